@@ -195,6 +195,9 @@ int Helium::Shutdown( int code )
         // Raise Shutdown Event
         g_ShuttingDown.Raise( ShutdownArgs () );
 
+        // Stop the async log writer (if it was started), this writes out everything still queued
+        Log::EnableAsync( false );
+
 
         // Setup debug CRT to dump memleaks to OutputDebugString and stderr
 #if HELIUM_OS_WIN && defined( _DEBUG )
@@ -0,0 +1,277 @@
+#include "Precompile.h"
+#include "Foundation/AsyncFileStream.h"
+
+#include "Foundation/Math.h"
+
+using namespace Helium;
+
+/// Constructor.
+AsyncFileStream::AsyncFileStream()
+: m_pQueue( NULL )
+, m_blockSize( 0 )
+, m_current( 0 )
+, m_position( 0 )
+, m_nextOffset( 0 )
+, m_size( 0 )
+{
+}
+
+/// Destructor.
+AsyncFileStream::~AsyncFileStream()
+{
+	Close();
+}
+
+/// Open a file for reading, and start reading ahead.
+///
+/// @param[in] pPath       FilePath name of the file to open.
+/// @param[in] pQueue      Queue to read through, or null for one of the stream's own.
+/// @param[in] blockSize   Size of each read.
+/// @param[in] blockCount  Number of blocks, at least two for any to be read ahead.
+///
+/// @return  True if the file was successfully opened, false if not.
+bool AsyncFileStream::Open( const char* pPath, AsyncFileQueue* pQueue, size_t blockSize, uint32_t blockCount )
+{
+	HELIUM_ASSERT( pPath );
+	HELIUM_ASSERT( blockSize > 0 && blockCount > 0 );
+
+	Close();
+
+	if( !m_file.Open( pPath, FileModes::Read, false ) )
+	{
+		return false;
+	}
+
+	if( pQueue )
+	{
+		m_pQueue = pQueue;
+	}
+	else
+	{
+		// just enough depth for the blocks, no point in more threads than that either
+		if( !m_ownQueue.IsInitialized() )
+		{
+			HELIUM_VERIFY( m_ownQueue.Initialize( blockCount, blockCount ) );
+		}
+
+		m_pQueue = &m_ownQueue;
+	}
+
+	m_blockSize = blockSize;
+	m_size = m_file.GetSize();
+	m_buffer.Resize( blockSize * blockCount );
+	m_blocks.Resize( blockCount );
+	for( uint32_t blockIndex = 0; blockIndex < blockCount; ++blockIndex )
+	{
+		m_blocks[ blockIndex ].m_used = false;
+	}
+
+	Restart( 0 );
+	return true;
+}
+
+/// @copydoc Stream::Close()
+void AsyncFileStream::Close()
+{
+	if( !m_file.IsOpen() )
+	{
+		return;
+	}
+
+	// the reads in flight land in our buffer
+	for( size_t blockIndex = 0; blockIndex < m_blocks.GetSize(); ++blockIndex )
+	{
+		WaitForBlock( m_blocks[ blockIndex ] );
+	}
+
+	m_file.Close();
+	m_ownQueue.Shutdown();
+	m_pQueue = NULL;
+	m_blocks.Clear();
+	m_buffer.Clear();
+}
+
+/// @copydoc Stream::IsOpen()
+bool AsyncFileStream::IsOpen() const
+{
+	return m_file.IsOpen();
+}
+
+/// @copydoc Stream::Read()
+size_t AsyncFileStream::Read( void* pBuffer, size_t size, size_t count )
+{
+	HELIUM_ASSERT_MSG( m_file.IsOpen(), "File not open" );
+	if( !m_file.IsOpen() || size == 0 )
+	{
+		return 0;
+	}
+
+	uint8_t* pDest = static_cast< uint8_t* >( pBuffer );
+	size_t byteCount = size * count;
+	size_t bytesRead = 0;
+	while( bytesRead < byteCount )
+	{
+		Block& rBlock = m_blocks[ m_current ];
+		if( !WaitForBlock( rBlock ) )
+		{
+			break;
+		}
+
+		size_t blockOffset = static_cast< size_t >( m_position - rBlock.m_offset );
+		size_t blockSize = rBlock.m_request.m_Transferred;
+		if( blockOffset >= blockSize )
+		{
+			break; // the end of the file (or it got shorter)
+		}
+
+		size_t copySize = Min( blockSize - blockOffset, byteCount - bytesRead );
+		MemoryCopy( pDest + bytesRead, static_cast< uint8_t* >( rBlock.m_request.m_Buffer ) + blockOffset, copySize );
+		bytesRead += copySize;
+		m_position += copySize;
+
+		if( blockOffset + copySize == blockSize )
+		{
+			// done with the block, read the next one into it
+			Refill( rBlock );
+			m_current = ( m_current + 1 ) % static_cast< uint32_t >( m_blocks.GetSize() );
+		}
+	}
+
+	return bytesRead / size;
+}
+
+/// @copydoc Stream::Write()
+size_t AsyncFileStream::Write( const void* /*pBuffer*/, size_t /*size*/, size_t /*count*/ )
+{
+	HELIUM_BREAK_MSG( "AsyncFileStream is read only" );
+	return 0;
+}
+
+/// @copydoc Stream::Flush()
+void AsyncFileStream::Flush()
+{
+}
+
+/// @copydoc Stream::Seek()
+int64_t AsyncFileStream::Seek( int64_t offset, SeekOrigin origin )
+{
+	if( !m_file.IsOpen() )
+	{
+		HELIUM_BREAK_MSG( "File not open" );
+		return -1;
+	}
+
+	int64_t position = offset;
+	if( origin == SeekOrigins::Current )
+	{
+		position += m_position;
+	}
+	else if( origin == SeekOrigins::End )
+	{
+		position += m_size;
+	}
+
+	if( position < 0 )
+	{
+		position = 0;
+	}
+
+	// skipping ahead within the blocks read so far keeps the ones after it, anywhere else starts over
+	Block& rCurrent = m_blocks[ m_current ];
+	if( rCurrent.m_used && position >= rCurrent.m_offset && position < m_nextOffset )
+	{
+		for( ;; )
+		{
+			Block& rBlock = m_blocks[ m_current ];
+			if( position < rBlock.m_offset + static_cast< int64_t >( m_blockSize ) )
+			{
+				break;
+			}
+
+			WaitForBlock( rBlock );
+			Refill( rBlock );
+			m_current = ( m_current + 1 ) % static_cast< uint32_t >( m_blocks.GetSize() );
+		}
+
+		m_position = position;
+	}
+	else
+	{
+		Restart( position );
+	}
+
+	return m_position;
+}
+
+/// @copydoc Stream::Tell()
+int64_t AsyncFileStream::Tell() const
+{
+	return m_position;
+}
+
+/// @copydoc Stream::GetSize()
+int64_t AsyncFileStream::GetSize() const
+{
+	return m_size;
+}
+
+/// Read the next block of the file into a block that is done with, if the file goes on that far.
+///
+/// @param[in] rBlock  Block to read into, which must not have a read in flight.
+void AsyncFileStream::Refill( Block& rBlock )
+{
+	HELIUM_ASSERT( !rBlock.m_used || rBlock.m_request.m_Complete );
+
+	rBlock.m_used = m_nextOffset < m_size;
+	if( !rBlock.m_used )
+	{
+		return;
+	}
+
+	size_t blockIndex = &rBlock - m_blocks.GetData();
+	size_t size = static_cast< size_t >( Min< int64_t >( static_cast< int64_t >( m_blockSize ), m_size - m_nextOffset ) );
+	rBlock.m_offset = m_nextOffset;
+	rBlock.m_request.SetRead( m_file, m_buffer.GetData() + blockIndex * m_blockSize, size, m_nextOffset );
+	m_pQueue->Submit( rBlock.m_request );
+	m_nextOffset += size;
+}
+
+/// Wait for the read of a block to complete.
+///
+/// @param[in] rBlock  Block to wait for.
+///
+/// @return  True if the block holds data, false if it's past the end of the file or the read failed.
+bool AsyncFileStream::WaitForBlock( Block& rBlock )
+{
+	if( !rBlock.m_used )
+	{
+		return false;
+	}
+
+	// the queue may complete other streams' reads first
+	while( !rBlock.m_request.m_Complete )
+	{
+		m_pQueue->Wait();
+	}
+
+	return rBlock.m_request.m_Succeeded;
+}
+
+/// Read the blocks from the one holding a new position.
+///
+/// @param[in] position  Position to read from.
+void AsyncFileStream::Restart( int64_t position )
+{
+	for( size_t blockIndex = 0; blockIndex < m_blocks.GetSize(); ++blockIndex )
+	{
+		WaitForBlock( m_blocks[ blockIndex ] );
+	}
+
+	m_position = position;
+	m_nextOffset = position - position % static_cast< int64_t >( m_blockSize );
+	m_current = 0;
+	for( size_t blockIndex = 0; blockIndex < m_blocks.GetSize(); ++blockIndex )
+	{
+		Refill( m_blocks[ blockIndex ] );
+	}
+}
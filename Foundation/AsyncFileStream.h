@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Platform/AsyncFile.h"
+
+#include "Foundation/DynamicArray.h"
+#include "Foundation/Stream.h"
+
+namespace Helium
+{
+	/// Read only file stream that keeps reads of the blocks after the one being read in flight.
+	///
+	/// Sequential readers find the next block already loaded, or on its way, instead of waiting on each read.  Streams
+	/// can share one AsyncFileQueue, so many files load at once (as long as they are all read on the queue's thread).
+	class HELIUM_FOUNDATION_API AsyncFileStream : public Stream
+	{
+	public:
+		/// Default size of each block read ahead.
+		static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+		/// Default number of blocks, the one being read and those read ahead of it.
+		static const uint32_t DEFAULT_BLOCK_COUNT = 4;
+
+		/// @name Construction/Destruction
+		//@{
+		AsyncFileStream();
+		virtual ~AsyncFileStream();
+		//@}
+
+		/// Open a file for reading, and start reading ahead.
+		///
+		/// @param[in] pPath       FilePath name of the file to open.
+		/// @param[in] pQueue      Queue to read through, or null for one of the stream's own.
+		/// @param[in] blockSize   Size of each read.
+		/// @param[in] blockCount  Number of blocks, at least two for any to be read ahead.
+		///
+		/// @return  True if the file was successfully opened, false if not.
+		bool Open(
+			const char* pPath,
+			AsyncFileQueue* pQueue = NULL,
+			size_t blockSize = DEFAULT_BLOCK_SIZE,
+			uint32_t blockCount = DEFAULT_BLOCK_COUNT );
+
+		/// @copydoc Stream::Close()
+		virtual void Close();
+
+		/// @copydoc Stream::IsOpen()
+		virtual bool IsOpen() const;
+
+		/// @copydoc Stream::Read()
+		virtual size_t Read( void* pBuffer, size_t size, size_t count );
+
+		/// @copydoc Stream::Write()
+		virtual size_t Write( const void* pBuffer, size_t size, size_t count );
+
+		/// @copydoc Stream::Flush()
+		virtual void Flush();
+
+		/// @copydoc Stream::Seek()
+		virtual int64_t Seek( int64_t offset, SeekOrigin origin );
+
+		/// @copydoc Stream::Tell()
+		virtual int64_t Tell() const;
+
+		/// @copydoc Stream::GetSize()
+		virtual int64_t GetSize() const;
+
+		/// @name Stream Capabilities
+		//@{
+
+		/// @copydoc Stream::CanRead()
+		virtual bool CanRead() const
+		{
+			return IsOpen();
+		}
+
+		/// @copydoc Stream::CanWrite()
+		virtual bool CanWrite() const
+		{
+			return false;
+		}
+
+		/// @copydoc Stream::CanSeek()
+		virtual bool CanSeek() const
+		{
+			return IsOpen();
+		}
+		//@}
+
+	private:
+		/// A block of the file, loaded or being read.
+		struct Block
+		{
+			AsyncFileRequest m_request;
+			int64_t          m_offset;
+			bool             m_used;     ///< False for blocks past the end of the file.
+		};
+
+		void Refill( Block& rBlock );
+		bool WaitForBlock( Block& rBlock );
+		void Restart( int64_t position );
+
+		/// File being read.
+		File m_file;
+		/// Queue reading it, m_ownQueue or one shared with other streams.
+		AsyncFileQueue* m_pQueue;
+		/// Queue used when none is given.
+		AsyncFileQueue m_ownQueue;
+
+		/// Blocks, in a ring starting at m_current.
+		DynamicArray< Block > m_blocks;
+		/// Memory of every block.
+		DynamicArray< uint8_t > m_buffer;
+		/// Size of each block.
+		size_t m_blockSize;
+		/// Block holding the current position.
+		uint32_t m_current;
+
+		/// Current position.
+		int64_t m_position;
+		/// Offset of the first byte not read (or being read) yet.
+		int64_t m_nextOffset;
+		/// Size of the file when it was opened.
+		int64_t m_size;
+	};
+}
@@ -0,0 +1,832 @@
+#include "Precompile.h"
+#include "BinaryLog.h"
+
+#include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Console.h"
+#include "Platform/Thread.h"
+#include "Platform/Timer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <map>
+
+using namespace Helium;
+using namespace Helium::Log;
+
+//
+// Format interning
+//  An open addressing table keyed on the format string's address, insertion is lock-free so any thread may intern.
+//
+
+#define FORMAT_TABLE_SIZE 4096
+#define FORMAT_MAX_COUNT ( FORMAT_TABLE_SIZE / 2 )
+
+static const char* volatile g_FormatKeys[ FORMAT_TABLE_SIZE ];
+static int32_t volatile     g_FormatIds[ FORMAT_TABLE_SIZE ];
+static const char*          g_Formats[ FORMAT_MAX_COUNT + 1 ];
+static int32_t volatile     g_FormatCount = 0;
+
+uint32_t Log::InternFormat( const char* format )
+{
+	uint32_t hash = static_cast< uint32_t >( reinterpret_cast< uintptr_t >( format ) >> 2 );
+	hash *= 0x9E3779B1;
+
+	for ( uint32_t probe = 0; probe < FORMAT_TABLE_SIZE; ++probe )
+	{
+		uint32_t slot = ( ( hash >> 20 ) + probe ) & ( FORMAT_TABLE_SIZE - 1 );
+
+		const char* key = g_FormatKeys[ slot ];
+		if ( key == NULL )
+		{
+			key = AtomicCompareExchange( g_FormatKeys[ slot ], format, static_cast< const char* >( NULL ) );
+			if ( key == NULL )
+			{
+				// we own the slot, hand out the next id
+				int32_t id = AtomicIncrement( g_FormatCount );
+				if ( id > FORMAT_MAX_COUNT )
+				{
+					AtomicExchange( g_FormatIds[ slot ], -1 );
+					return 0;
+				}
+
+				g_Formats[ id ] = format;
+				AtomicExchange( g_FormatIds[ slot ], id );
+				return id;
+			}
+		}
+
+		if ( key == format )
+		{
+			// the owner may still be publishing the id
+			int32_t id;
+			while ( ( id = g_FormatIds[ slot ] ) == 0 )
+			{
+				Thread::Yield();
+			}
+
+			return id > 0 ? id : 0;
+		}
+	}
+
+	return 0;
+}
+
+const char* Log::GetInternedFormat( uint32_t id )
+{
+	if ( id == 0 || id > static_cast< uint32_t >( g_FormatCount ) || id > FORMAT_MAX_COUNT )
+	{
+		return NULL;
+	}
+
+	return g_Formats[ id ];
+}
+
+//
+// Format parsing
+//
+
+namespace ArgumentTypes
+{
+	enum ArgumentType
+	{
+		None,        // no argument (%%)
+		Int,
+		Long,
+		LongLong,
+		Size,
+		IntMax,
+		PtrDiff,
+		Double,
+		LongDouble,
+		Pointer,
+		String,
+		Unsupported,
+	};
+}
+typedef ArgumentTypes::ArgumentType ArgumentType;
+
+struct FormatSpec
+{
+	const char*  m_Start;   // the '%' that starts the conversion
+	uint32_t     m_Length;  // length of the conversion including the '%'
+	uint32_t     m_Stars;   // number of '*' width or precision int arguments preceding the value
+	int32_t      m_Precision;  // digits after the '.', -1 if there are none, or if they come from the last star
+	bool         m_StarPrecision;
+	ArgumentType m_Type;
+};
+
+// parse the conversion starting at the '%' at p, returns the character after the conversion
+static const char* ParseFormatSpec( const char* p, FormatSpec& spec )
+{
+	spec.m_Start = p++;
+	spec.m_Stars = 0;
+	spec.m_Precision = -1;
+	spec.m_StarPrecision = false;
+	spec.m_Type = ArgumentTypes::Unsupported;
+
+	if ( *p == '%' )
+	{
+		spec.m_Type = ArgumentTypes::None;
+		spec.m_Length = 2;
+		return p + 1;
+	}
+
+	// flags
+	while ( *p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'' )
+	{
+		++p;
+	}
+
+	// width
+	if ( *p == '*' )
+	{
+		++spec.m_Stars;
+		++p;
+	}
+	else
+	{
+		while ( *p >= '0' && *p <= '9' )
+		{
+			++p;
+		}
+	}
+
+	// precision
+	if ( *p == '.' )
+	{
+		++p;
+		if ( *p == '*' )
+		{
+			++spec.m_Stars;
+			spec.m_StarPrecision = true;
+			++p;
+		}
+		else
+		{
+			// a lone '.' is a precision of zero
+			spec.m_Precision = 0;
+			while ( *p >= '0' && *p <= '9' )
+			{
+				spec.m_Precision = spec.m_Precision * 10 + ( *p - '0' );
+				++p;
+			}
+		}
+	}
+
+	// length
+	ArgumentType integer = ArgumentTypes::Int;
+	bool longDouble = false;
+	bool wide = false;
+	switch ( *p )
+	{
+	case 'h':
+		p += ( p[1] == 'h' ) ? 2 : 1;
+		break;
+
+	case 'l':
+		if ( p[1] == 'l' )
+		{
+			integer = ArgumentTypes::LongLong;
+			p += 2;
+		}
+		else
+		{
+			integer = ArgumentTypes::Long;
+			wide = true;
+			p += 1;
+		}
+		break;
+
+	case 'q':
+		integer = ArgumentTypes::LongLong;
+		p += 1;
+		break;
+
+	case 'z':
+		integer = ArgumentTypes::Size;
+		p += 1;
+		break;
+
+	case 'j':
+		integer = ArgumentTypes::IntMax;
+		p += 1;
+		break;
+
+	case 't':
+		integer = ArgumentTypes::PtrDiff;
+		p += 1;
+		break;
+
+	case 'L':
+		longDouble = true;
+		p += 1;
+		break;
+
+	case 'I':
+		if ( p[1] == '6' && p[2] == '4' )
+		{
+			integer = ArgumentTypes::LongLong;
+			p += 3;
+		}
+		else if ( p[1] == '3' && p[2] == '2' )
+		{
+			p += 3;
+		}
+		else
+		{
+			integer = ArgumentTypes::Size;
+			p += 1;
+		}
+		break;
+	}
+
+	// conversion
+	switch ( *p )
+	{
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		spec.m_Type = integer;
+		break;
+
+	case 'c':
+		spec.m_Type = wide ? ArgumentTypes::Unsupported : ArgumentTypes::Int;
+		break;
+
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		spec.m_Type = longDouble ? ArgumentTypes::LongDouble : ArgumentTypes::Double;
+		break;
+
+	case 'p':
+		spec.m_Type = ArgumentTypes::Pointer;
+		break;
+
+	case 's':
+		spec.m_Type = wide ? ArgumentTypes::Unsupported : ArgumentTypes::String;
+		break;
+	}
+
+	if ( *p )
+	{
+		++p;
+	}
+
+	spec.m_Length = static_cast< uint32_t >( p - spec.m_Start );
+	return p;
+}
+
+//
+// Encoding
+//
+
+static inline bool Put( uint8_t* buffer, uint32_t bufferSize, uint32_t& size, const void* data, uint32_t length )
+{
+	if ( size + length > bufferSize )
+	{
+		return false;
+	}
+
+	memcpy( buffer + size, data, length );
+	size += length;
+	return true;
+}
+
+// like strlen, but stops looking after maxLength characters, for strings that printf is told to cut short
+static inline uint32_t BoundedLength( const char* string, uint32_t maxLength )
+{
+	uint32_t length = 0;
+	while ( length < maxLength && string[ length ] )
+	{
+		++length;
+	}
+
+	return length;
+}
+
+template< class T >
+static inline bool PutValue( uint8_t* buffer, uint32_t bufferSize, uint32_t& size, T value )
+{
+	return Put( buffer, bufferSize, size, &value, sizeof( value ) );
+}
+
+bool Log::EncodeArguments( const char* format, va_list args, uint8_t* buffer, uint32_t bufferSize, uint32_t& size )
+{
+	size = 0;
+
+	for ( const char* p = format; *p; )
+	{
+		if ( *p != '%' )
+		{
+			++p;
+			continue;
+		}
+
+		FormatSpec spec;
+		p = ParseFormatSpec( p, spec );
+
+		int32_t precision = spec.m_Precision;
+		for ( uint32_t i = 0; i < spec.m_Stars; ++i )
+		{
+			int star = va_arg( args, int );
+			if ( !PutValue< int32_t >( buffer, bufferSize, size, star ) )
+			{
+				return false;
+			}
+
+			// a negative precision from a star is taken as if it was left out
+			if ( spec.m_StarPrecision && i + 1 == spec.m_Stars )
+			{
+				precision = star < 0 ? -1 : star;
+			}
+		}
+
+		bool result = true;
+		switch ( spec.m_Type )
+		{
+		case ArgumentTypes::None:
+			break;
+
+		case ArgumentTypes::Int:
+			result = PutValue< int32_t >( buffer, bufferSize, size, va_arg( args, int ) );
+			break;
+
+		case ArgumentTypes::Long:
+			result = PutValue< int64_t >( buffer, bufferSize, size, va_arg( args, long ) );
+			break;
+
+		case ArgumentTypes::LongLong:
+			result = PutValue< int64_t >( buffer, bufferSize, size, va_arg( args, long long ) );
+			break;
+
+		case ArgumentTypes::Size:
+			result = PutValue< uint64_t >( buffer, bufferSize, size, va_arg( args, size_t ) );
+			break;
+
+		case ArgumentTypes::IntMax:
+			result = PutValue< int64_t >( buffer, bufferSize, size, va_arg( args, intmax_t ) );
+			break;
+
+		case ArgumentTypes::PtrDiff:
+			result = PutValue< int64_t >( buffer, bufferSize, size, va_arg( args, ptrdiff_t ) );
+			break;
+
+		case ArgumentTypes::Double:
+			result = PutValue< float64_t >( buffer, bufferSize, size, va_arg( args, double ) );
+			break;
+
+		case ArgumentTypes::LongDouble:
+			result = PutValue< float64_t >( buffer, bufferSize, size, static_cast< float64_t >( va_arg( args, long double ) ) );
+			break;
+
+		case ArgumentTypes::Pointer:
+			result = PutValue< uint64_t >( buffer, bufferSize, size, reinterpret_cast< uintptr_t >( va_arg( args, void* ) ) );
+			break;
+
+		case ArgumentTypes::String:
+			{
+				const char* string = va_arg( args, const char* );
+				if ( !string )
+				{
+					string = "(null)";
+				}
+
+				// with a precision the string needn't be terminated, so don't look past it
+				uint32_t length = precision < 0 ? static_cast< uint32_t >( strlen( string ) ) : BoundedLength( string, static_cast< uint32_t >( precision ) );
+				result = PutValue< uint32_t >( buffer, bufferSize, size, length ) && Put( buffer, bufferSize, size, string, length );
+				break;
+			}
+
+		default:
+			return false;
+		}
+
+		if ( !result )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//
+// Rendering
+//
+
+template< class T >
+static inline bool GetValue( const uint8_t* arguments, uint32_t size, uint32_t& offset, T& value )
+{
+	if ( offset + sizeof( T ) > size )
+	{
+		return false;
+	}
+
+	memcpy( &value, arguments + offset, sizeof( T ) );
+	offset += sizeof( T );
+	return true;
+}
+
+template< class T >
+static int RenderValue( char* dest, size_t destSize, const char* spec, uint32_t stars, const int32_t* starValues, T value )
+{
+	switch ( stars )
+	{
+	case 0:
+		return StringPrint( dest, destSize, spec, value );
+
+	case 1:
+		return StringPrint( dest, destSize, spec, starValues[ 0 ], value );
+
+	default:
+		return StringPrint( dest, destSize, spec, starValues[ 0 ], starValues[ 1 ], value );
+	}
+}
+
+uint32_t Log::RenderArguments( const char* format, const uint8_t* arguments, uint32_t size, char* dest, uint32_t destSize )
+{
+	HELIUM_ASSERT( destSize > 0 );
+
+	uint32_t length = 0;
+	uint32_t offset = 0;
+	const char* p = format;
+
+	while ( *p && length + 1 < destSize )
+	{
+		if ( *p != '%' )
+		{
+			dest[ length++ ] = *p++;
+			continue;
+		}
+
+		FormatSpec spec;
+		p = ParseFormatSpec( p, spec );
+
+		if ( spec.m_Type == ArgumentTypes::None )
+		{
+			dest[ length++ ] = '%';
+			continue;
+		}
+
+		char conversion[ 32 ];
+		if ( spec.m_Type == ArgumentTypes::Unsupported || spec.m_Length >= sizeof( conversion ) )
+		{
+			// the encoder would have refused this format, leave the conversion in the text
+			break;
+		}
+		memcpy( conversion, spec.m_Start, spec.m_Length );
+		conversion[ spec.m_Length ] = '\0';
+
+		int32_t starValues[ 2 ] = { 0, 0 };
+		bool valid = true;
+		for ( uint32_t i = 0; i < spec.m_Stars && i < 2; ++i )
+		{
+			valid &= GetValue( arguments, size, offset, starValues[ i ] );
+		}
+
+		char* out = dest + length;
+		size_t outSize = destSize - length;
+		int written = 0;
+
+		switch ( spec.m_Type )
+		{
+		case ArgumentTypes::Int:
+			{
+				int32_t value = 0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, static_cast< int >( value ) );
+				break;
+			}
+
+		case ArgumentTypes::Long:
+			{
+				int64_t value = 0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, static_cast< long >( value ) );
+				break;
+			}
+
+		case ArgumentTypes::LongLong:
+			{
+				int64_t value = 0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, static_cast< long long >( value ) );
+				break;
+			}
+
+		case ArgumentTypes::Size:
+			{
+				uint64_t value = 0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, static_cast< size_t >( value ) );
+				break;
+			}
+
+		case ArgumentTypes::IntMax:
+			{
+				int64_t value = 0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, static_cast< intmax_t >( value ) );
+				break;
+			}
+
+		case ArgumentTypes::PtrDiff:
+			{
+				int64_t value = 0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, static_cast< ptrdiff_t >( value ) );
+				break;
+			}
+
+		case ArgumentTypes::Double:
+			{
+				float64_t value = 0.0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, value );
+				break;
+			}
+
+		case ArgumentTypes::LongDouble:
+			{
+				float64_t value = 0.0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, static_cast< long double >( value ) );
+				break;
+			}
+
+		case ArgumentTypes::Pointer:
+			{
+				uint64_t value = 0;
+				valid = valid && GetValue( arguments, size, offset, value );
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, reinterpret_cast< void* >( static_cast< uintptr_t >( value ) ) );
+				break;
+			}
+
+		case ArgumentTypes::String:
+			{
+				uint32_t stringLength = 0;
+				valid = valid && GetValue( arguments, size, offset, stringLength ) && offset + stringLength <= size;
+				std::string string;
+				if ( valid )
+				{
+					string.assign( reinterpret_cast< const char* >( arguments + offset ), stringLength );
+					offset += stringLength;
+				}
+				written = RenderValue( out, outSize, conversion, spec.m_Stars, starValues, string.c_str() );
+				break;
+			}
+
+		default:
+			break;
+		}
+
+		if ( !valid )
+		{
+			// truncated or corrupt arguments, stop rather than print garbage
+			break;
+		}
+
+		if ( written > 0 )
+		{
+			length += ( static_cast< uint32_t >( written ) < outSize ) ? static_cast< uint32_t >( written ) : static_cast< uint32_t >( outSize - 1 );
+		}
+	}
+
+	dest[ length ] = '\0';
+	return length;
+}
+
+//
+// Writer
+//
+
+BinaryLogWriter::BinaryLogWriter()
+{
+}
+
+BinaryLogWriter::~BinaryLogWriter()
+{
+	Close();
+}
+
+bool BinaryLogWriter::Open( const char* fileName )
+{
+	if ( !m_File.Open( fileName, FileModes::Write ) )
+	{
+		return false;
+	}
+
+	BinaryLogFileHeader header;
+	memcpy( header.m_Magic, "HLOG", sizeof( header.m_Magic ) );
+	header.m_Version = BINARY_LOG_VERSION;
+	header.m_TicksPerSecond = Timer::GetTicksPerSecond();
+	Append( &header, sizeof( header ) );
+	Flush();
+
+	return true;
+}
+
+void BinaryLogWriter::Close()
+{
+	if ( m_File.IsOpen() )
+	{
+		Flush();
+		m_File.Close();
+	}
+
+	m_Defined.clear();
+}
+
+void BinaryLogWriter::Write( const BinaryLogStatement& statement, const uint8_t* arguments )
+{
+	if ( statement.m_FormatId >= m_Defined.size() )
+	{
+		m_Defined.resize( statement.m_FormatId + 1, false );
+	}
+
+	if ( !m_Defined[ statement.m_FormatId ] )
+	{
+		const char* format = GetInternedFormat( statement.m_FormatId );
+		HELIUM_ASSERT( format );
+
+		uint8_t type = BinaryLogRecordTypes::Format;
+		uint32_t length = format ? static_cast< uint32_t >( strlen( format ) ) : 0;
+		Append( &type, sizeof( type ) );
+		Append( &statement.m_FormatId, sizeof( statement.m_FormatId ) );
+		Append( &length, sizeof( length ) );
+		Append( format, length );
+
+		m_Defined[ statement.m_FormatId ] = true;
+	}
+
+	uint8_t type = BinaryLogRecordTypes::Statement;
+	Append( &type, sizeof( type ) );
+	Append( &statement, sizeof( statement ) );
+	Append( arguments, statement.m_ArgumentSize );
+
+	// keep the buffer from growing without bound between flushes
+	if ( m_Buffer.size() >= 64 * 1024 )
+	{
+		m_File.Write( &m_Buffer[ 0 ], m_Buffer.size() );
+		m_Buffer.clear();
+	}
+}
+
+void BinaryLogWriter::Flush()
+{
+	if ( !m_Buffer.empty() )
+	{
+		m_File.Write( &m_Buffer[ 0 ], m_Buffer.size() );
+		m_Buffer.clear();
+	}
+
+	m_File.Flush();
+}
+
+void BinaryLogWriter::Append( const void* data, size_t size )
+{
+	const uint8_t* bytes = static_cast< const uint8_t* >( data );
+	m_Buffer.insert( m_Buffer.end(), bytes, bytes + size );
+}
+
+//
+// Decoder
+//
+
+bool Log::DecodeBinaryLog( const std::string& binaryFile, const std::string& textFile )
+{
+	File input;
+	if ( !input.Open( binaryFile.c_str(), FileModes::Read ) )
+	{
+		return false;
+	}
+
+	int64_t fileSize = input.GetSize();
+	if ( fileSize < static_cast< int64_t >( sizeof( BinaryLogFileHeader ) ) )
+	{
+		return false;
+	}
+
+	std::vector< uint8_t > data( static_cast< size_t >( fileSize ) );
+	size_t read = 0;
+	if ( !input.Read( &data[ 0 ], data.size(), &read ) || read != data.size() )
+	{
+		return false;
+	}
+	input.Close();
+
+	BinaryLogFileHeader header;
+	memcpy( &header, &data[ 0 ], sizeof( header ) );
+	if ( memcmp( header.m_Magic, "HLOG", sizeof( header.m_Magic ) ) != 0 || header.m_Version != BINARY_LOG_VERSION || header.m_TicksPerSecond == 0 )
+	{
+		return false;
+	}
+
+	File output;
+	if ( !output.Open( textFile.c_str(), FileModes::Write ) )
+	{
+		return false;
+	}
+
+	std::map< uint32_t, std::string > formats;
+	std::string text;
+	std::vector< char > rendered( 8192 );
+	bool stampNewLine = true;
+	bool result = true;
+
+	size_t offset = sizeof( header );
+	while ( offset < data.size() && result )
+	{
+		uint8_t type = data[ offset++ ];
+		switch ( type )
+		{
+		case BinaryLogRecordTypes::Format:
+			{
+				uint32_t id = 0;
+				uint32_t length = 0;
+				if ( offset + sizeof( id ) + sizeof( length ) > data.size() )
+				{
+					result = false;
+					break;
+				}
+				memcpy( &id, &data[ offset ], sizeof( id ) );
+				memcpy( &length, &data[ offset + sizeof( id ) ], sizeof( length ) );
+				offset += sizeof( id ) + sizeof( length );
+
+				if ( offset + length > data.size() )
+				{
+					result = false;
+					break;
+				}
+				formats[ id ].assign( reinterpret_cast< const char* >( &data[ offset ] ), length );
+				offset += length;
+				break;
+			}
+
+		case BinaryLogRecordTypes::Statement:
+			{
+				BinaryLogStatement statement;
+				if ( offset + sizeof( statement ) > data.size() )
+				{
+					result = false;
+					break;
+				}
+				memcpy( &statement, &data[ offset ], sizeof( statement ) );
+				offset += sizeof( statement );
+
+				if ( offset + statement.m_ArgumentSize > data.size() )
+				{
+					result = false;
+					break;
+				}
+
+				std::map< uint32_t, std::string >::const_iterator found = formats.find( statement.m_FormatId );
+				if ( found == formats.end() )
+				{
+					result = false;
+					break;
+				}
+
+				uint32_t length = RenderArguments( found->second.c_str(), statement.m_ArgumentSize ? &data[ offset ] : NULL, statement.m_ArgumentSize, &rendered[ 0 ], static_cast< uint32_t >( rendered.size() ) );
+				offset += statement.m_ArgumentSize;
+
+				// stamp the start of each line like the trace files do, but with the seconds on the Timer clock
+				//  the statement was recorded with (not the wall clock time of day the trace files use)
+				text.clear();
+				if ( stampNewLine )
+				{
+					char stamp[ 64 ];
+					StringPrint( stamp, "[%12.6f TID:%llu] ", static_cast< float64_t >( statement.m_Timestamp ) / static_cast< float64_t >( header.m_TicksPerSecond ), static_cast< unsigned long long >( statement.m_ThreadId ) );
+					text = stamp;
+				}
+				text.append( &rendered[ 0 ], length );
+
+				if ( length )
+				{
+					stampNewLine = rendered[ length - 1 ] == '\n';
+				}
+
+				output.Write( text.c_str(), text.length() );
+				break;
+			}
+
+		default:
+			result = false;
+			break;
+		}
+	}
+
+	output.Close();
+	return result;
+}
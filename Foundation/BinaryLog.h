@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdarg.h>
+#include <string>
+#include <vector>
+
+#include "Platform/Types.h"
+#include "Platform/File.h"
+
+#include "Foundation/API.h"
+
+namespace Helium
+{
+	namespace Log
+	{
+		//
+		// Binary log records keep the id of the format string and the raw printf arguments instead of the formatted
+		//  text.  Text is only rendered when something wants to read it: the async writer thread renders for
+		//  listeners, the console and text trace files, and DecodeBinaryLog renders binary log files offline.
+		//
+		// Binary log file layout (native byte order):
+		//  - BinaryLogFileHeader
+		//  - a sequence of records, each one starting with a uint8_t BinaryLogRecordType:
+		//    - Format:    uint32_t id, uint32_t length, then length chars (written before the first statement using it)
+		//    - Statement: BinaryLogStatement, then m_ArgumentSize bytes of encoded arguments
+		//
+		// Encoded arguments are packed in the order they are consumed by the format: 4 bytes for int sized values
+		//  (including '*' widths and precisions), 8 bytes for wider integers, doubles and pointers, and a uint32_t
+		//  length followed by the characters (no terminator) for strings.
+		//
+
+		namespace BinaryLogRecordTypes
+		{
+			enum BinaryLogRecordType
+			{
+				Format = 1,
+				Statement,
+			};
+		}
+		typedef BinaryLogRecordTypes::BinaryLogRecordType BinaryLogRecordType;
+
+		const static uint32_t BINARY_LOG_VERSION = 1;
+
+		struct BinaryLogFileHeader
+		{
+			char     m_Magic[4];         // "HLOG"
+			uint32_t m_Version;          // BINARY_LOG_VERSION
+			uint64_t m_TicksPerSecond;   // frequency of BinaryLogStatement::m_Timestamp
+		};
+
+		struct BinaryLogStatement
+		{
+			uint32_t m_FormatId;
+			uint32_t m_Stream;
+			uint32_t m_Level;
+			uint32_t m_ArgumentSize;
+			uint64_t m_ThreadId;
+			uint64_t m_Timestamp;        // Timer::GetTickCount() when the statement was printed
+		};
+
+		// format strings are identified by address, so they must stay valid for as long as the process logs (use literals)
+		HELIUM_FOUNDATION_API uint32_t InternFormat( const char* format );
+		HELIUM_FOUNDATION_API const char* GetInternedFormat( uint32_t id );
+
+		// pack the arguments consumed by format, fails if the format uses a conversion we can't defer (%n, wide strings)
+		HELIUM_FOUNDATION_API bool EncodeArguments( const char* format, va_list args, uint8_t* buffer, uint32_t bufferSize, uint32_t& size );
+
+		// render packed arguments with their format, returns the length of the text written to dest
+		HELIUM_FOUNDATION_API uint32_t RenderArguments( const char* format, const uint8_t* arguments, uint32_t size, char* dest, uint32_t destSize );
+
+		// writes binary statements to a file, emitting format definitions the first time each one is used
+		class HELIUM_FOUNDATION_API BinaryLogWriter
+		{
+		public:
+			BinaryLogWriter();
+			~BinaryLogWriter();
+
+			bool Open( const char* fileName );
+			void Close();
+
+			void Write( const BinaryLogStatement& statement, const uint8_t* arguments );
+			void Flush();
+
+		private:
+			void Append( const void* data, size_t size );
+
+			File                   m_File;
+			std::vector< bool >    m_Defined;
+			std::vector< uint8_t > m_Buffer;
+		};
+
+		// offline decoder, converts a binary log file to text, stamping each line with "[seconds TID:thread] ", where the
+		//  seconds are the statement's Timer ticks (a monotonic clock, not the time of day of the text trace files)
+		HELIUM_FOUNDATION_API bool DecodeBinaryLog( const std::string& binaryFile, const std::string& textFile );
+	}
+}
@@ -0,0 +1,297 @@
+#include "Precompile.h"
+#include "Foundation/Compression.h"
+
+#include "Platform/Assert.h"
+#include "Platform/Utility.h"
+
+using namespace Helium;
+
+/// Shortest match that is encoded.
+static const size_t MIN_MATCH = 4;
+/// A block always ends with this many literals, so matches never run up to the end of it.
+static const size_t LAST_LITERALS = 5;
+/// No match starts within this many bytes of the end of a block.
+static const size_t MATCH_LIMIT = 12;
+/// Farthest back a match can copy from.
+static const size_t MAX_OFFSET = 65535;
+/// Size of the table of recent positions of each 4 byte sequence, as a power of two.
+static const uint32_t HASH_BITS = 14;
+
+static inline uint32_t Read32( const uint8_t* pData )
+{
+    uint32_t value;
+    MemoryCopy( &value, pData, sizeof( value ) );
+    return value;
+}
+
+static inline uint32_t HashSequence( uint32_t sequence )
+{
+    return ( sequence * 2654435761U ) >> ( 32 - HASH_BITS );
+}
+
+static inline uint8_t* WriteLength( uint8_t* pDest, size_t length )
+{
+    for( ; length >= 255; length -= 255 )
+    {
+        *pDest++ = 255;
+    }
+
+    *pDest++ = static_cast< uint8_t >( length );
+    return pDest;
+}
+
+static inline bool ReadLength( const uint8_t*& pSource, const uint8_t* pSourceEnd, size_t& length )
+{
+    uint8_t value;
+    do
+    {
+        if( pSource == pSourceEnd )
+        {
+            return false;
+        }
+
+        value = *pSource++;
+        length += value;
+    }
+    while( value == 255 );
+
+    return true;
+}
+
+/// Write a run of literals followed by a match (none if matchLength is zero, for the last run of a block).
+///
+/// @return  End of the written sequence, or null if it doesn't fit.
+static uint8_t* WriteSequence(
+    uint8_t* pDest,
+    const uint8_t* pDestEnd,
+    const uint8_t* pLiterals,
+    size_t literalCount,
+    size_t offset,
+    size_t matchLength )
+{
+    size_t needed = 1 + literalCount / 255 + 1 + literalCount + ( matchLength ? 2 + matchLength / 255 + 1 : 0 );
+    if( needed > static_cast< size_t >( pDestEnd - pDest ) )
+    {
+        return NULL;
+    }
+
+    uint8_t* pToken = pDest++;
+    *pToken = static_cast< uint8_t >( ( literalCount >= 15 ? 15 : literalCount ) << 4 );
+    if( literalCount >= 15 )
+    {
+        pDest = WriteLength( pDest, literalCount - 15 );
+    }
+
+    MemoryCopy( pDest, pLiterals, literalCount );
+    pDest += literalCount;
+
+    if( matchLength )
+    {
+        HELIUM_ASSERT( offset > 0 && offset <= MAX_OFFSET );
+        *pDest++ = static_cast< uint8_t >( offset & 0xff );
+        *pDest++ = static_cast< uint8_t >( offset >> 8 );
+
+        size_t lengthCode = matchLength - MIN_MATCH;
+        *pToken |= static_cast< uint8_t >( lengthCode >= 15 ? 15 : lengthCode );
+        if( lengthCode >= 15 )
+        {
+            pDest = WriteLength( pDest, lengthCode - 15 );
+        }
+    }
+
+    return pDest;
+}
+
+/// Get the largest size Compress() can produce from a block of data.
+///
+/// @param[in] size  Size of the uncompressed block, in bytes.
+///
+/// @return  Capacity the compressed data needs, in the worst case (data that doesn't compress at all).
+///
+/// @see Compress()
+size_t Helium::CompressBound( size_t size )
+{
+    return size + size / 255 + 16;
+}
+
+/// Compress a block of data.
+///
+/// Blocks are compressed on their own, so they can be decompressed without any other data (and in any order).
+///
+/// @param[in]  pSource   Data to compress.
+/// @param[in]  size      Size of the data, in bytes (less than 4GB).
+/// @param[out] pDest     Buffer in which to store the compressed data.
+/// @param[in]  capacity  Size of the destination buffer, CompressBound( size ) bytes is always enough.
+///
+/// @return  Size of the compressed data, or zero if it didn't fit in the destination buffer.
+///
+/// @see Decompress(), CompressBound()
+size_t Helium::Compress( const void* pSource, size_t size, void* pDest, size_t capacity )
+{
+    HELIUM_ASSERT( pSource || size == 0 );
+    HELIUM_ASSERT( pDest );
+    HELIUM_ASSERT( size < 0xffffffff );
+
+    const uint8_t* pBegin = static_cast< const uint8_t* >( pSource );
+    const uint8_t* pEnd = pBegin + size;
+    const uint8_t* pCurrent = pBegin;
+    const uint8_t* pAnchor = pBegin;  // start of the literals not written yet
+
+    uint8_t* pDestBegin = static_cast< uint8_t* >( pDest );
+    uint8_t* pDestCurrent = pDestBegin;
+    const uint8_t* pDestEnd = pDestBegin + capacity;
+
+    if( size > MATCH_LIMIT )
+    {
+        // offset + 1 of the last position each hashed sequence was seen at, zero for none
+        uint32_t positions[ 1 << HASH_BITS ];
+        MemoryZero( positions, sizeof( positions ) );
+
+        const uint8_t* pMatchLimit = pEnd - MATCH_LIMIT;
+        const uint8_t* pExtendLimit = pEnd - LAST_LITERALS;
+
+        while( pCurrent < pMatchLimit )
+        {
+            uint32_t sequence = Read32( pCurrent );
+            uint32_t& position = positions[ HashSequence( sequence ) ];
+            const uint8_t* pMatch = position ? pBegin + position - 1 : NULL;
+            position = static_cast< uint32_t >( pCurrent - pBegin ) + 1;
+
+            if( !pMatch || static_cast< size_t >( pCurrent - pMatch ) > MAX_OFFSET || Read32( pMatch ) != sequence )
+            {
+                // step faster the longer nothing matches, data that doesn't compress goes by quickly
+                pCurrent += 1 + ( ( pCurrent - pAnchor ) >> 6 );
+                continue;
+            }
+
+            // grow the match back into the pending literals, and forward as far as it goes
+            while( pCurrent > pAnchor && pMatch > pBegin && pCurrent[ -1 ] == pMatch[ -1 ] )
+            {
+                --pCurrent;
+                --pMatch;
+            }
+
+            const uint8_t* pMatchEnd = pCurrent + MIN_MATCH;
+            for( const uint8_t* pReference = pMatch + MIN_MATCH; pMatchEnd < pExtendLimit && *pMatchEnd == *pReference; ++pReference )
+            {
+                ++pMatchEnd;
+            }
+
+            pDestCurrent = WriteSequence(
+                pDestCurrent,
+                pDestEnd,
+                pAnchor,
+                pCurrent - pAnchor,
+                pCurrent - pMatch,
+                pMatchEnd - pCurrent );
+            if( !pDestCurrent )
+            {
+                return 0;
+            }
+
+            pCurrent = pMatchEnd;
+            pAnchor = pCurrent;
+
+            // remember a position inside the match too, repeats are often a little apart
+            positions[ HashSequence( Read32( pCurrent - 2 ) ) ] = static_cast< uint32_t >( pCurrent - 2 - pBegin ) + 1;
+        }
+    }
+
+    pDestCurrent = WriteSequence( pDestCurrent, pDestEnd, pAnchor, pEnd - pAnchor, 0, 0 );
+    if( !pDestCurrent )
+    {
+        return 0;
+    }
+
+    return static_cast< size_t >( pDestCurrent - pDestBegin );
+}
+
+/// Decompress a block of data compressed by Compress().
+///
+/// @param[in]  pSource     Compressed data.
+/// @param[in]  sourceSize  Size of the compressed data, in bytes.
+/// @param[out] pDest       Buffer in which to store the decompressed data.
+/// @param[in]  size        Size of the data before it was compressed.
+///
+/// @return  True if the data decompressed to exactly size bytes, false if it is corrupt.
+///
+/// @see Compress()
+bool Helium::Decompress( const void* pSource, size_t sourceSize, void* pDest, size_t size )
+{
+    HELIUM_ASSERT( pSource || sourceSize == 0 );
+    HELIUM_ASSERT( pDest || size == 0 );
+
+    const uint8_t* pCurrent = static_cast< const uint8_t* >( pSource );
+    const uint8_t* pEnd = pCurrent + sourceSize;
+
+    uint8_t* pDestBegin = static_cast< uint8_t* >( pDest );
+    uint8_t* pDestCurrent = pDestBegin;
+    uint8_t* pDestEnd = pDestBegin + size;
+
+    while( pCurrent < pEnd )
+    {
+        uint8_t token = *pCurrent++;
+
+        size_t literalCount = token >> 4;
+        if( literalCount == 15 && !ReadLength( pCurrent, pEnd, literalCount ) )
+        {
+            return false;
+        }
+
+        if( literalCount > static_cast< size_t >( pEnd - pCurrent ) || literalCount > static_cast< size_t >( pDestEnd - pDestCurrent ) )
+        {
+            return false;
+        }
+
+        MemoryCopy( pDestCurrent, pCurrent, literalCount );
+        pCurrent += literalCount;
+        pDestCurrent += literalCount;
+
+        // the last sequence is only literals
+        if( pCurrent == pEnd )
+        {
+            break;
+        }
+
+        if( pEnd - pCurrent < 2 )
+        {
+            return false;
+        }
+
+        size_t offset = pCurrent[ 0 ] | ( static_cast< size_t >( pCurrent[ 1 ] ) << 8 );
+        pCurrent += 2;
+        if( offset == 0 || offset > static_cast< size_t >( pDestCurrent - pDestBegin ) )
+        {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if( matchLength == 15 && !ReadLength( pCurrent, pEnd, matchLength ) )
+        {
+            return false;
+        }
+
+        matchLength += MIN_MATCH;
+        if( matchLength > static_cast< size_t >( pDestEnd - pDestCurrent ) )
+        {
+            return false;
+        }
+
+        const uint8_t* pMatch = pDestCurrent - offset;
+        if( offset >= matchLength )
+        {
+            MemoryCopy( pDestCurrent, pMatch, matchLength );
+            pDestCurrent += matchLength;
+        }
+        else
+        {
+            // the match overlaps what it writes, repeating the last offset bytes
+            for( uint8_t* pMatchEnd = pDestCurrent + matchLength; pDestCurrent < pMatchEnd; )
+            {
+                *pDestCurrent++ = *pMatch++;
+            }
+        }
+    }
+
+    return pDestCurrent == pDestEnd;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Platform/Types.h"
+#include "Foundation/API.h"
+
+namespace Helium
+{
+    /// @defgroup compression Block Compression
+    ///
+    /// Fast LZ77 compression of independent blocks of memory, in the style of LZ4's block format: runs of literal
+    /// bytes alternate with matches that copy earlier output (up to 64KB back).  Compression favors speed over
+    /// ratio, decompression is a simple copy loop that checks every length and offset against both buffers.
+    //@{
+    HELIUM_FOUNDATION_API size_t CompressBound( size_t size );
+    HELIUM_FOUNDATION_API size_t Compress( const void* pSource, size_t size, void* pDest, size_t capacity );
+    HELIUM_FOUNDATION_API bool Decompress( const void* pSource, size_t sourceSize, void* pDest, size_t size );
+    //@}
+}
@@ -3,8 +3,11 @@
 
 #include "Platform/Assert.h"
 #include "Platform/Exception.h"
+#include "Platform/Runtime.h"
+#include "Platform/Thread.h"
 
 #include "Foundation/String.h"
+#include "Foundation/Wildcard.h"
 
 using namespace Helium;
 
@@ -115,7 +118,6 @@ bool DirectoryIterator::Find()
     while( !m_Done )
     {
         bool ok = true;
-        bool needStatPath = true;
 
         FilePath absolutePath;
 
@@ -126,11 +128,9 @@ bool DirectoryIterator::Find()
         }
         else
         {
+            // the directory filled in the status with the entry, no need to read it again
             absolutePath = m_Path.Get() + entry.m_Name;
 
-            HELIUM_VERIFY( entry.m_Stat.Read( absolutePath.Data() ) );
-            needStatPath = false;
-
             // directory...
             if ( entry.m_Stat.m_Mode & StatusModes::Directory )
             {
@@ -158,12 +158,6 @@ bool DirectoryIterator::Find()
         {
             // It's a keeper! store the data and format the file name
             // add the path path to the fileName
-            if ( needStatPath )
-            {
-                absolutePath = m_Path.Get() + entry.m_Name;
-				HELIUM_VERIFY( entry.m_Stat.Read( absolutePath.Data() ) );
-            }
-
             if ( m_Flags & DirectoryFlags::RelativePath )
             {
                 m_Item.m_Path.Set( entry.m_Name );
@@ -228,4 +222,249 @@ void Helium::RecurseDirectories( DirectoryItemSignature::Delegate delegate, cons
             RecurseDirectories( delegate, dir.GetItem().m_Path, flags );
         }
     }
-}
\ No newline at end of file
+}
+
+struct DirectoryScanner::Worker
+{
+    DirectoryScanner* m_Scanner;
+    DirectoryReader   m_Reader;
+    CallbackThread    m_Thread;
+
+    void Run()
+    {
+        m_Scanner->Run( m_Reader );
+    }
+};
+
+DirectoryScanner::DirectoryScanner()
+: m_Flags( 0 )
+, m_ThreadCount( 0 )
+, m_Busy( 0 )
+, m_FailedCount( 0 )
+, m_ItemCount( 0 )
+{
+
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+
+}
+
+void DirectoryScanner::AddFilePattern( const char* pattern )
+{
+    m_FilePatterns.push_back( pattern );
+}
+
+void DirectoryScanner::AddExcludePattern( const char* pattern )
+{
+    m_ExcludePatterns.push_back( pattern );
+}
+
+void DirectoryScanner::ClearPatterns()
+{
+    m_FilePatterns.clear();
+    m_ExcludePatterns.clear();
+}
+
+uint64_t DirectoryScanner::Scan( const FilePath& path, DirectoryItemSignature::Delegate delegate, uint32_t flags, uint32_t threadCount )
+{
+    HELIUM_ASSERT( delegate.Valid() );
+
+    m_Root = path.Get();
+    if ( !m_Root.empty() && *m_Root.rbegin() != '/' )
+    {
+        m_Root += '/';
+    }
+
+    if ( threadCount == 0 )
+    {
+        threadCount = Helium::Platform::GetProcessorCount();
+        threadCount = threadCount ? threadCount : 1;
+    }
+
+    m_Flags = flags;
+    m_ThreadCount = threadCount;
+    m_Delegate = delegate;
+    m_FailedCount = 0;
+    m_ItemCount = 0;
+
+    m_Pending.push_back( std::string() );
+    m_Busy = 1;
+    m_Work.Increment();
+
+    // the calling thread scans too
+    Worker* workers = NULL;
+    if ( threadCount > 1 )
+    {
+        workers = new Worker[ threadCount - 1 ];
+        for ( uint32_t i = 0; i < threadCount - 1; ++i )
+        {
+            workers[ i ].m_Scanner = this;
+            HELIUM_VERIFY( workers[ i ].m_Thread.Create( &CallbackThread::EntryHelper< Worker, &Worker::Run >, &workers[ i ], "Directory Scanner" ) );
+        }
+    }
+
+    DirectoryReader reader;
+    Run( reader );
+
+    for ( uint32_t i = 0; i + 1 < threadCount; ++i )
+    {
+        workers[ i ].m_Thread.Join();
+    }
+    delete [] workers;
+
+    m_Delegate.Clear();
+    return m_ItemCount;
+}
+
+void DirectoryScanner::Run( DirectoryReader& reader )
+{
+    std::vector< DirectoryIteratorItem > items;
+    std::vector< std::string > directories;
+    std::string relativePath;
+
+    for (;;)
+    {
+        m_Work.Decrement();
+
+        // nothing left means everything is done, a count for each directory comes with it
+        m_Lock.Lock();
+        if ( m_Pending.empty() )
+        {
+            m_Lock.Unlock();
+            break;
+        }
+        relativePath.swap( m_Pending.back() );
+        m_Pending.pop_back();
+        m_Lock.Unlock();
+
+        ScanDirectory( reader, relativePath, items, directories );
+
+        if ( !items.empty() )
+        {
+            m_DelegateLock.Lock();
+            for ( size_t i = 0; i < items.size(); ++i )
+            {
+                m_Delegate.Invoke( items[ i ] );
+            }
+            m_ItemCount += items.size();
+            m_DelegateLock.Unlock();
+
+            items.clear();
+        }
+
+        m_Lock.Lock();
+        m_Pending.insert( m_Pending.end(), directories.begin(), directories.end() );
+        m_Busy += static_cast< uint32_t >( directories.size() );
+        bool finished = --m_Busy == 0;
+        m_Lock.Unlock();
+
+        for ( size_t i = 0; i < directories.size(); ++i )
+        {
+            m_Work.Increment();
+        }
+        directories.clear();
+
+        if ( finished )
+        {
+            for ( uint32_t i = 0; i < m_ThreadCount; ++i )
+            {
+                m_Work.Increment();
+            }
+        }
+    }
+}
+
+void DirectoryScanner::ScanDirectory( DirectoryReader& reader, const std::string& relativePath, std::vector< DirectoryIteratorItem >& items, std::vector< std::string >& directories )
+{
+    std::string path ( m_Root + relativePath );
+    if ( !reader.Open( path.c_str() ) )
+    {
+        m_Lock.Lock();
+        ++m_FailedCount;
+        m_Lock.Unlock();
+        return;
+    }
+
+    const std::string& itemPrefix = ( m_Flags & DirectoryFlags::RelativePath ) ? relativePath : path;
+    while ( reader.Next() )
+    {
+        const char* name = reader.GetName();
+        if ( Matches( m_ExcludePatterns, name ) )
+        {
+            continue;
+        }
+
+        Status status;
+        bool haveStatus = false;
+
+        uint32_t mode = reader.GetMode();
+        bool directory = ( mode & StatusModes::Directory ) != 0;
+        bool link = ( mode & StatusModes::Link ) != 0;
+        if ( link )
+        {
+            haveStatus = reader.GetStatus( status );
+            directory = haveStatus && ( status.m_Mode & StatusModes::Directory );
+        }
+
+        if ( directory )
+        {
+            // skip hidden/system directories, like DirectoryIterator
+            if ( mode & StatusModes::Special )
+            {
+                continue;
+            }
+
+            if ( !link )
+            {
+                directories.push_back( relativePath + name + '/' );
+            }
+
+            if ( m_Flags & DirectoryFlags::SkipDirectories )
+            {
+                continue;
+            }
+        }
+        else if ( ( m_Flags & DirectoryFlags::SkipFiles ) || ( !m_FilePatterns.empty() && !Matches( m_FilePatterns, name ) ) )
+        {
+            continue;
+        }
+
+        items.push_back( DirectoryIteratorItem() );
+        DirectoryIteratorItem& item = items.back();
+
+        std::string itemPath ( itemPrefix );
+        itemPath += name;
+        if ( directory )
+        {
+            itemPath += '/';
+        }
+        item.m_Path.Set( itemPath );
+
+        if ( m_Flags & DirectoryFlags::ReadStatus )
+        {
+            if ( haveStatus || reader.GetStatus( status ) )
+            {
+                item.m_CreateTime = status.m_CreatedTime;
+                item.m_ModTime = status.m_ModifiedTime;
+                item.m_Size = status.m_Size;
+            }
+        }
+    }
+
+    reader.Close();
+}
+
+bool DirectoryScanner::Matches( const std::vector< std::string >& patterns, const char* name )
+{
+    for ( size_t i = 0; i < patterns.size(); ++i )
+    {
+        if ( WildcardMatch( patterns[ i ].c_str(), name ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -2,6 +2,8 @@
 
 #include "Platform/Types.h"
 #include "Platform/File.h"
+#include "Platform/Locks.h"
+#include "Platform/Semaphore.h"
 
 #include "Foundation/API.h"
 #include "Foundation/Event.h"
@@ -17,6 +19,7 @@ namespace Helium
 			SkipFiles       = 1 << 0,          // Skip files
 			SkipDirectories = 1 << 1,          // Skip directories
 			RelativePath    = 1 << 2,          // Don't preped each file with the root path
+			ReadStatus      = 1 << 3,          // DirectoryScanner: fill in sizes and times (a status read per item, except on windows)
 		};
 	}
 
@@ -75,4 +78,55 @@ namespace Helium
 	typedef Helium::Signature< const DirectoryIteratorItem& > DirectoryItemSignature;
 
 	HELIUM_FOUNDATION_API void RecurseDirectories( DirectoryItemSignature::Delegate delegate, const FilePath& path, uint32_t flags = DirectoryFlags::Default);
+
+	// Scans a whole tree on several threads, each reading directories many entries at a time and taking their types
+	//  from the listing (no status read per entry), while the items go to a delegate one at a time, in no set order.
+	//  Links are passed on as what they point to, but linked directories aren't scanned (so there are no cycles).
+	class HELIUM_FOUNDATION_API DirectoryScanner : NonCopyable
+	{
+	public:
+		DirectoryScanner();
+		~DirectoryScanner();
+
+		// WildcardMatch patterns of names, files to pass on (every file, with none) and files or directories to skip
+		void AddFilePattern( const char* pattern );
+		void AddExcludePattern( const char* pattern );
+		void ClearPatterns();
+
+		// returns the number of items passed on, threadCount 0 uses one thread per processor (the caller's included)
+		uint64_t Scan( const FilePath& path, DirectoryItemSignature::Delegate delegate, uint32_t flags = DirectoryFlags::Default, uint32_t threadCount = 0 );
+
+		// directories that couldn't be opened during the last scan
+		inline uint32_t GetFailedCount() const;
+
+	private:
+		struct Worker;
+
+		void Run( DirectoryReader& reader );
+		void ScanDirectory( DirectoryReader& reader, const std::string& relativePath, std::vector< DirectoryIteratorItem >& items, std::vector< std::string >& directories );
+		static bool Matches( const std::vector< std::string >& patterns, const char* name );
+
+		std::vector< std::string >        m_FilePatterns;
+		std::vector< std::string >        m_ExcludePatterns;
+
+		// the scan in progress
+		std::string                       m_Root;
+		uint32_t                          m_Flags;
+		uint32_t                          m_ThreadCount;
+		DirectoryItemSignature::Delegate  m_Delegate;
+
+		Mutex                             m_Lock;          // guards the directories left and the counts
+		Semaphore                         m_Work;          // one count per directory left, and per thread when done
+		std::vector< std::string >        m_Pending;       // directories left, relative to the root
+		uint32_t                          m_Busy;          // directories left and being scanned
+		uint32_t                          m_FailedCount;
+
+		Mutex                             m_DelegateLock;  // one item at a time
+		uint64_t                          m_ItemCount;
+	};
+
+	inline uint32_t DirectoryScanner::GetFailedCount() const
+	{
+		return m_FailedCount;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "Precompile.h"
+#include "Foundation/DirectoryIterator.h"
+
+#include "Platform/Console.h"
+#include "Platform/Runtime.h"
+#include "Platform/Tests.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+#include <set>
+
+using namespace Helium;
+
+struct DirectoryTestCollector
+{
+	std::set< std::string > m_Paths;
+	uint64_t                m_Size;
+
+	DirectoryTestCollector()
+		: m_Size( 0 )
+	{
+	}
+
+	void Add( const DirectoryIteratorItem& item )
+	{
+		EXPECT_TRUE( m_Paths.insert( item.m_Path.Get() ).second );
+		m_Size += item.m_Size;
+	}
+};
+
+// deletes what a scan found, files first, then the directories deepest first
+static void RemoveTestTree( const std::string& root )
+{
+	DirectoryTestCollector collector;
+	DirectoryScanner scanner;
+	scanner.Scan( FilePath( root ), DirectoryItemSignature::Delegate( &collector, &DirectoryTestCollector::Add ) );
+
+	for ( std::set< std::string >::const_iterator itr = collector.m_Paths.begin(), end = collector.m_Paths.end(); itr != end; ++itr )
+	{
+		if ( *itr->rbegin() != '/' )
+		{
+			Helium::Delete( itr->c_str() );
+		}
+	}
+
+	for ( std::set< std::string >::const_reverse_iterator itr = collector.m_Paths.rbegin(), end = collector.m_Paths.rend(); itr != end; ++itr )
+	{
+		if ( *itr->rbegin() == '/' )
+		{
+			RemoveTestDirectory( *itr );
+		}
+	}
+
+	RemoveTestDirectory( root );
+}
+
+TEST(Directory, ScannerMatchesIterator)
+{
+	const std::string root ( "FoundationDirectoryScan/" );
+	const char* directories[] = { "one/", "one/deeper/", "one/deeper/deepest/", "two/", "skip/" };
+	const char* files[] = { "a.txt", "b.dat", "one/c.txt", "one/d.TXT", "one/deeper/e.txt", "one/deeper/deepest/f.dat", "two/g.dat", "skip/h.txt" };
+
+	RemoveTestTree( root );
+	ASSERT_TRUE( MakePath( root.c_str() ) );
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( directories ); ++i )
+	{
+		ASSERT_TRUE( MakePath( ( root + directories[ i ] ).c_str() ) );
+	}
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( files ); ++i )
+	{
+		ASSERT_TRUE( MakeTestFile( root + files[ i ], i + 1 ) );
+	}
+
+	// everything, the same as recursing with DirectoryIterator
+	DirectoryTestCollector iterated;
+	RecurseDirectories( DirectoryItemSignature::Delegate( &iterated, &DirectoryTestCollector::Add ), FilePath( root ) );
+	EXPECT_EQ( HELIUM_ARRAY_COUNT( directories ) + HELIUM_ARRAY_COUNT( files ), iterated.m_Paths.size() );
+
+	for ( uint32_t threadCount = 1; threadCount <= 4; threadCount *= 2 )
+	{
+		DirectoryScanner scanner;
+		DirectoryTestCollector scanned;
+		EXPECT_EQ( iterated.m_Paths.size(), scanner.Scan( FilePath( root ), DirectoryItemSignature::Delegate( &scanned, &DirectoryTestCollector::Add ), DirectoryFlags::ReadStatus, threadCount ) );
+		EXPECT_TRUE( scanned.m_Paths == iterated.m_Paths );
+		EXPECT_EQ( 0u, scanner.GetFailedCount() );
+
+		// sizes of the files (the directories' vary by file system)
+		uint64_t fileSizes = 0;
+		DirectoryTestCollector scannedFiles;
+		scanner.Scan( FilePath( root ), DirectoryItemSignature::Delegate( &scannedFiles, &DirectoryTestCollector::Add ), DirectoryFlags::ReadStatus | DirectoryFlags::SkipDirectories, threadCount );
+		for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( files ); ++i )
+		{
+			fileSizes += i + 1;
+		}
+		EXPECT_EQ( HELIUM_ARRAY_COUNT( files ), scannedFiles.m_Paths.size() );
+		EXPECT_EQ( fileSizes, scannedFiles.m_Size );
+	}
+
+	// patterns, relative paths
+	DirectoryScanner scanner;
+	scanner.AddFilePattern( "*.txt" );
+	scanner.AddExcludePattern( "skip" );
+	scanner.AddExcludePattern( "deepest" );
+
+	DirectoryTestCollector filtered;
+	scanner.Scan( FilePath( root ), DirectoryItemSignature::Delegate( &filtered, &DirectoryTestCollector::Add ), DirectoryFlags::RelativePath | DirectoryFlags::SkipDirectories, 2 );
+
+	std::set< std::string > expected;
+	expected.insert( "a.txt" );
+	expected.insert( "one/c.txt" );
+	expected.insert( "one/d.TXT" );
+	expected.insert( "one/deeper/e.txt" );
+	EXPECT_TRUE( filtered.m_Paths == expected );
+
+	DirectoryTestCollector directoriesOnly;
+	scanner.ClearPatterns();
+	scanner.Scan( FilePath( root ), DirectoryItemSignature::Delegate( &directoriesOnly, &DirectoryTestCollector::Add ), DirectoryFlags::RelativePath | DirectoryFlags::SkipFiles, 2 );
+	EXPECT_EQ( HELIUM_ARRAY_COUNT( directories ), directoriesOnly.m_Paths.size() );
+	EXPECT_EQ( 1u, directoriesOnly.m_Paths.count( "one/deeper/deepest/" ) );
+
+	// missing
+	DirectoryTestCollector missing;
+	EXPECT_EQ( 0u, scanner.Scan( FilePath( root + "missing/" ), DirectoryItemSignature::Delegate( &missing, &DirectoryTestCollector::Add ) ) );
+	EXPECT_EQ( 1u, scanner.GetFailedCount() );
+
+	RemoveTestTree( root );
+}
+
+TEST(Directory, ScannerBenchmark)
+{
+	// 100 directories of 10 directories of 100 files
+	const std::string root ( "FoundationDirectoryScanBenchmark/" );
+	const uint32_t fanOut = 100;
+	const uint32_t subdirectoryCount = 10;
+	const uint32_t fileCount = 100;
+
+	RemoveTestTree( root );
+
+	char name[ 64 ];
+	for ( uint32_t i = 0; i < fanOut; ++i )
+	{
+		for ( uint32_t j = 0; j < subdirectoryCount; ++j )
+		{
+			StringPrint( name, sizeof( name ), "%u/%u/", i, j );
+			std::string directory ( root + name );
+			ASSERT_TRUE( MakePath( directory.c_str() ) );
+			for ( uint32_t k = 0; k < fileCount; ++k )
+			{
+				StringPrint( name, sizeof( name ), "file%u.dat", k );
+				File file;
+				ASSERT_TRUE( file.Open( ( directory + name ).c_str(), FileModes::Write ) );
+			}
+		}
+	}
+
+	const size_t itemCount = fanOut + fanOut * subdirectoryCount + fanOut * subdirectoryCount * fileCount;
+
+	SimpleTimer timer;
+	DirectoryTestCollector iterated;
+	RecurseDirectories( DirectoryItemSignature::Delegate( &iterated, &DirectoryTestCollector::Add ), FilePath( root ) );
+	float64_t iteratorMillis = timer.Elapsed();
+	EXPECT_EQ( itemCount, iterated.m_Paths.size() );
+
+	float64_t scannerMillis[ 3 ];
+	uint32_t threadCounts[ 3 ] = { 1, 0, 1 };
+	for ( uint32_t pass = 0; pass < 3; ++pass )
+	{
+		DirectoryScanner scanner;
+		DirectoryTestCollector scanned;
+		timer.Reset();
+		scanner.Scan( FilePath( root ), DirectoryItemSignature::Delegate( &scanned, &DirectoryTestCollector::Add ), pass == 2 ? DirectoryFlags::ReadStatus : DirectoryFlags::Default, threadCounts[ pass ] );
+		scannerMillis[ pass ] = timer.Elapsed();
+		EXPECT_EQ( itemCount, scanned.m_Paths.size() );
+	}
+
+	RemoveTestTree( root );
+
+	Helium::Print( "DirectoryScanner: %" PRIuSZ " items, %.0f ms recursing DirectoryIterator, %.0f ms on 1 thread, %.0f ms on %u, %.0f ms on 1 with status\n",
+		itemCount, iteratorMillis, scannerMillis[ 0 ], scannerMillis[ 1 ], Helium::Platform::GetProcessorCount(), scannerMillis[ 2 ] );
+}
@@ -2,6 +2,7 @@
 
 #include "Platform/Types.h"
 #include "Platform/Assert.h"
+#include "Platform/Utility.h"
 #include "Foundation/SmartPtr.h"
 
 #include <vector>
@@ -25,14 +26,17 @@ namespace Helium
 	//
 	// Comments:
 	//
-	//  The reliance on internally allocated worker (Impl) classes is there to
-	//   allow for experimentation with memory allocation without having to
-	//   refactor tons of code to test changes.  Since the allocation is masked
-	//   client code will never call new itself.  There is lots of overloading
-	//   and template member functions to support as much efficiency as possible.
-	//   Utilize template member functions over Delegate prototypes to prevent
-	//   needless heap thrashing (creation, comparison, and deletion of internal
-	//   DelegateImpl objects).
+	//  Delegate stores the function or member function pointer inline, along
+	//   with a thunk that knows how to call it, so binding, copying and
+	//   comparing delegates never touches the heap.  DelegateImpl and its
+	//   derived classes are still here for code that wants a heap allocated,
+	//   type erased invoker (see Reflect::Method).
+	//
+	//  Event keeps its delegates in one reference counted array.  Raise holds
+	//   a reference to the array it is walking, and any change made while the
+	//   array is referenced like that goes to a copy, so a raise never sees the
+	//   array grow under it.  Removing a delegate also clears it from the arrays
+	//   still being raised, so it won't be called after it was removed.
 	//
 	// Usage:
 	//
@@ -60,8 +64,6 @@ namespace Helium
 	// To Do:
 	//
 	//  * Add support for stl or 'Helium' allocators in place of C++ heap
-	//  * Elminate heap usage in Delegate with some horrific unions:
-	//     http://www.codeproject.com/cpp/fastdelegate2.asp
 	//
 	//////////////////////////////////////////////////////////////////////////
 
@@ -137,8 +139,8 @@ namespace Helium
 		void Invoke( ArgsType parameter ) const;
 
 		//
-		// DelegateImpl implements the guts of Delegate and is heap allocated and reference counted.
-		//  Its defines an interface (pure virtual) that must be implemented by derived classes
+		// DelegateImpl is a heap allocated and reference counted invoker, for code that needs to hold
+		//  one through the type erased Invokable interface.  Delegate itself doesn't use these.
 		//
 
 		class DelegateImpl : public RefCountBaseType< DelegateImpl >, public Invokable
@@ -203,7 +205,32 @@ namespace Helium
 			friend class Delegate;
 		};
 
-		Helium::SmartPtr< DelegateImpl > m_Impl;
+	private:
+		typedef void (*FunctionPointer)( ArgsType );
+		typedef void (*Thunk)( const Delegate& delegate, ArgsType parameter );
+
+		// large enough for any member function pointer, since a pointer to a member of an incomplete class has to
+		//  use the most general representation
+		class UnknownClass;
+		typedef void (UnknownClass::*UnknownMethod)();
+
+		void SetFunction( FunctionPointer function );
+		template < class ClassType, typename MethodType >
+		void SetMethod( ClassType* instance, MethodType method );
+
+		static void InvokeFunction( const Delegate& delegate, ArgsType parameter );
+		template < class ClassType, typename MethodType >
+		static void InvokeMethod( const Delegate& delegate, ArgsType parameter );
+
+		Thunk        m_Thunk;     // calls the target, NULL if this delegate is empty
+		DelegateType m_Type;      // for comparison, thunks can differ between modules for the same target
+		void*        m_Instance;  // the object methods are called on, NULL for functions
+		union
+		{
+			FunctionPointer m_Function;
+			UnknownMethod   m_MethodAlignment;
+			uint8_t         m_Method[ sizeof( UnknownMethod ) ]; // zero padded past the end of the stored pointer
+		};
 	};
 
 	//
@@ -249,32 +276,40 @@ namespace Helium
 			// Query for count
 			uint32_t Count() const;
 
-			// Compact dead pointers caused by Remove() inside Raise()
-			void Compact();
+			// Is any raise walking this array
+			bool IsRaising() const;
 
-			// Add the delegate function to the list
-			void Add( const Delegate& delegate );
+			// Find a delegate that matches, or NULL
+			const Delegate* Find( const Delegate& delegate ) const;
 			template < typename FunctionType >
-			void AddFunction( FunctionType function );
+			const Delegate* FindFunction( FunctionType function ) const;
 			template < class ClassType, typename MethodType >
-			void AddMethod( ClassType* instance, MethodType method );
+			const Delegate* FindMethod( const ClassType* instance, MethodType method ) const;
 
-			// Remove the delegate function from the list
-			void Remove( const Delegate& delegate );
-			template < typename FunctionType >
-			void RemoveFunction( FunctionType function );
-			template < class ClassType, typename MethodType >
-			void RemoveMethod( const ClassType* instance, MethodType method );
+			// Append a delegate (only while nothing else references this array)
+			void Add( const Delegate& delegate );
+
+			// Remove a delegate found with Find*, and clear it from the arrays this one replaced that are still being raised
+			void Remove( const Delegate* delegate );
 
 			// Invoke all of the delegates for this event occurrence. Pays no mind about the return value of the invocation
 			void Raise( ArgsType parameter, const Delegate& emitter );
 
 		private:
-			std::vector<Delegate>   m_Delegates;
-			uint32_t                     m_EntryCount;
-			uint32_t                     m_EmptySlots;
+			friend class Event;
+
+			std::vector<Delegate>          m_Delegates;
+			uint32_t                       m_RaiseCount;   // raises in progress over this array
+			Helium::SmartPtr< EventImpl >  m_Replaced;     // the array this one was copied from while it was being raised
 		};
 
+	private:
+		// Get an array we can change, copying the current one if anything else references it
+		EventImpl* Edit();
+
+		// Drop the array once it is empty
+		void Trim();
+
 		Helium::SmartPtr< EventImpl > m_Impl;
 	};
 
@@ -1,28 +1,33 @@
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 Helium::Delegate< ArgsType, RefCountBaseType >::Delegate()
+	: m_Thunk( NULL )
+	, m_Type( DelegateTypes::Function )
+	, m_Instance( NULL )
 {
-
+	MemoryZero( m_Method, sizeof( m_Method ) );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 Helium::Delegate< ArgsType, RefCountBaseType >::Delegate( const Delegate& rhs )
-	: m_Impl( rhs.m_Impl )
+	: m_Thunk( rhs.m_Thunk )
+	, m_Type( rhs.m_Type )
+	, m_Instance( rhs.m_Instance )
 {
-
+	MemoryCopy( m_Method, rhs.m_Method, sizeof( m_Method ) );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template < typename FunctionType >
 Helium::Delegate< ArgsType, RefCountBaseType >::Delegate( FunctionType function )
 {
-	m_Impl = new Function (function);
+	SetFunction( function );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template < class ClassType, typename MethodType >
 Helium::Delegate< ArgsType, RefCountBaseType >::Delegate( ClassType* instance, MethodType method )
 {
-	m_Impl = new Method<ClassType> (instance, method);
+	SetMethod( instance, method );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
@@ -42,92 +47,121 @@ Helium::Delegate< ArgsType, RefCountBaseType > Helium::Delegate< ArgsType, RefCo
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 void Helium::Delegate< ArgsType, RefCountBaseType >::Clear()
 {
-	m_Impl = NULL;
+	m_Thunk = NULL;
+	m_Type = DelegateTypes::Function;
+	m_Instance = NULL;
+	MemoryZero( m_Method, sizeof( m_Method ) );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 bool Helium::Delegate< ArgsType, RefCountBaseType >::Valid() const
 {
-	return m_Impl.ReferencesObject();
+	return m_Thunk != NULL;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 void Helium::Delegate< ArgsType, RefCountBaseType >::Set( const Delegate& delegate )
 {
-	m_Impl = delegate.m_Impl;
+	m_Thunk = delegate.m_Thunk;
+	m_Type = delegate.m_Type;
+	m_Instance = delegate.m_Instance;
+	MemoryCopy( m_Method, delegate.m_Method, sizeof( m_Method ) );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template < typename FunctionType >
 void Helium::Delegate< ArgsType, RefCountBaseType >::Set( FunctionType function )
 {
-	m_Impl = new Function (function);
+	SetFunction( function );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template < class ClassType, typename MethodType >
 void Helium::Delegate< ArgsType, RefCountBaseType >::Set( ClassType* instance, MethodType method )
 {
-	m_Impl = new Method<ClassType> (instance, method);
+	SetMethod( instance, method );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 bool Helium::Delegate< ArgsType, RefCountBaseType >::Equals( const Delegate& rhs ) const
 {
-	if (m_Impl.ReferencesObject() != rhs.m_Impl.ReferencesObject())
+	if ( !Valid() || !rhs.Valid() )
 	{
 		return false;
 	}
 
-	if (!m_Impl.ReferencesObject())
-	{
-		return false;
-	}
-
-	return m_Impl->Equals( rhs.m_Impl );
+	return m_Type == rhs.m_Type
+		&& m_Instance == rhs.m_Instance
+		&& MemoryCompare( m_Method, rhs.m_Method, sizeof( m_Method ) ) == 0;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template <typename FunctionType>
 bool Helium::Delegate< ArgsType, RefCountBaseType >::Equals( FunctionType function ) const
 {
-	if (m_Impl.ReferencesObject() && m_Impl->GetType() == DelegateTypes::Function)
-	{
-		Function* func = static_cast<Function*>(m_Impl.Ptr());
-
-		return func->m_Function == function;
-	}
-	else
-	{
-		return false;
-	}
+	return Valid() && m_Type == DelegateTypes::Function && m_Function == function;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template< class ClassType, typename MethodType >
 bool Helium::Delegate< ArgsType, RefCountBaseType >::Equals( const ClassType* instance, MethodType method ) const
 {
-	if (m_Impl.ReferencesObject() && m_Impl->GetType() == DelegateTypes::Method)
-	{
-		Method<ClassType>* meth = static_cast<Method<ClassType>*>(m_Impl.Ptr());
-
-		return meth->m_Instance == instance && meth->m_Method == method;
-	}
-	else
-	{
-		return false;
-	}
+	return Valid()
+		&& m_Type == DelegateTypes::Method
+		&& m_Instance == static_cast< const void* >( instance )
+		&& MemoryCompare( m_Method, &method, sizeof( method ) ) == 0;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 void Helium::Delegate< ArgsType, RefCountBaseType >::Invoke( ArgsType parameter ) const
 {
-	if (m_Impl.ReferencesObject())
+	if ( m_Thunk )
 	{
-		m_Impl->Invoke(parameter);
+		m_Thunk( *this, parameter );
 	}
 }
 
+template< typename ArgsType, template< typename T > class RefCountBaseType >
+void Helium::Delegate< ArgsType, RefCountBaseType >::SetFunction( FunctionPointer function )
+{
+	HELIUM_ASSERT( function );
+
+	MemoryZero( m_Method, sizeof( m_Method ) );
+	m_Function = function;
+	m_Instance = NULL;
+	m_Type = DelegateTypes::Function;
+	m_Thunk = &InvokeFunction;
+}
+
+template< typename ArgsType, template< typename T > class RefCountBaseType >
+template < class ClassType, typename MethodType >
+void Helium::Delegate< ArgsType, RefCountBaseType >::SetMethod( ClassType* instance, MethodType method )
+{
+	HELIUM_COMPILE_ASSERT( sizeof( MethodType ) <= sizeof( UnknownMethod ) );
+	HELIUM_ASSERT( method );
+
+	MemoryZero( m_Method, sizeof( m_Method ) );
+	MemoryCopy( m_Method, &method, sizeof( method ) );
+	m_Instance = static_cast< void* >( instance );
+	m_Type = DelegateTypes::Method;
+	m_Thunk = &InvokeMethod< ClassType, MethodType >;
+}
+
+template< typename ArgsType, template< typename T > class RefCountBaseType >
+void Helium::Delegate< ArgsType, RefCountBaseType >::InvokeFunction( const Delegate& delegate, ArgsType parameter )
+{
+	delegate.m_Function( parameter );
+}
+
+template< typename ArgsType, template< typename T > class RefCountBaseType >
+template < class ClassType, typename MethodType >
+void Helium::Delegate< ArgsType, RefCountBaseType >::InvokeMethod( const Delegate& delegate, ArgsType parameter )
+{
+	MethodType method;
+	MemoryCopy( &method, delegate.m_Method, sizeof( method ) );
+	( static_cast< ClassType* >( delegate.m_Instance )->*method )( parameter );
+}
+
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 Helium::Delegate< ArgsType, RefCountBaseType >::Function::Function( FunctionType function )
 	: m_Function( function )
@@ -256,49 +290,40 @@ bool Helium::Event< ArgsType, RefCountBaseType >::Valid() const
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 void Helium::Event< ArgsType, RefCountBaseType >::Add( const Delegate& delegate )
 {
-	if ( !m_Impl.ReferencesObject() )
+	if ( !m_Impl.ReferencesObject() || !m_Impl->Find( delegate ) )
 	{
-		m_Impl = new EventImpl;
+		Edit()->Add( delegate );
 	}
-
-	m_Impl->Add( delegate );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template< typename FunctionType >
 void Helium::Event< ArgsType, RefCountBaseType >::AddFunction( FunctionType function )
 {
-	if ( !m_Impl.ReferencesObject() )
+	if ( !m_Impl.ReferencesObject() || !m_Impl->FindFunction( function ) )
 	{
-		m_Impl = new EventImpl;
+		Edit()->Add( Delegate ( function ) );
 	}
-
-	m_Impl->AddFunction( function );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template< class ClassType, typename MethodType >
 void Helium::Event< ArgsType, RefCountBaseType >::AddMethod( ClassType* instance, MethodType method )
 {
-	if ( !m_Impl.ReferencesObject() )
+	if ( !m_Impl.ReferencesObject() || !m_Impl->FindMethod( instance, method ) )
 	{
-		m_Impl = new EventImpl;
+		Edit()->Add( Delegate ( instance, method ) );
 	}
-
-	m_Impl->AddMethod( instance, method );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 void Helium::Event< ArgsType, RefCountBaseType >::Remove( const Delegate& delegate )
 {
-	if ( m_Impl.ReferencesObject() )
+	if ( m_Impl.ReferencesObject() && m_Impl->Find( delegate ) )
 	{
-		m_Impl->Remove( delegate );
-
-		if (m_Impl->Count() == 0)
-		{
-			m_Impl = NULL;
-		}
+		EventImpl* impl = Edit();
+		impl->Remove( impl->Find( delegate ) );
+		Trim();
 	}
 }
 
@@ -306,14 +331,11 @@ template< typename ArgsType, template< typename T > class RefCountBaseType >
 template< typename FunctionType >
 void Helium::Event< ArgsType, RefCountBaseType >::RemoveFunction( FunctionType function )
 {
-	if ( m_Impl.ReferencesObject() )
+	if ( m_Impl.ReferencesObject() && m_Impl->FindFunction( function ) )
 	{
-		m_Impl->RemoveFunction( function );
-
-		if (m_Impl->Count() == 0)
-		{
-			m_Impl = NULL;
-		}
+		EventImpl* impl = Edit();
+		impl->Remove( impl->FindFunction( function ) );
+		Trim();
 	}
 }
 
@@ -321,14 +343,11 @@ template< typename ArgsType, template< typename T > class RefCountBaseType >
 template< class ClassType, typename MethodType >
 void Helium::Event< ArgsType, RefCountBaseType >::RemoveMethod( const ClassType* instance, MethodType method )
 {
-	if ( m_Impl.ReferencesObject() )
+	if ( m_Impl.ReferencesObject() && m_Impl->FindMethod( instance, method ) )
 	{
-		m_Impl->RemoveMethod( instance, method );
-
-		if (m_Impl->Count() == 0)
-		{
-			m_Impl = NULL;
-		}
+		EventImpl* impl = Edit();
+		impl->Remove( impl->FindMethod( instance, method ) );
+		Trim();
 	}
 }
 
@@ -362,10 +381,57 @@ void Helium::Event< ArgsType, RefCountBaseType >::RaiseWithEmitter( ArgsType par
 	return void ();
 }
 
+template< typename ArgsType, template< typename T > class RefCountBaseType >
+typename Helium::Event< ArgsType, RefCountBaseType >::EventImpl* Helium::Event< ArgsType, RefCountBaseType >::Edit()
+{
+	if ( !m_Impl.ReferencesObject() )
+	{
+		m_Impl = new EventImpl;
+	}
+	else if ( m_Impl->GetRefCount() > 1 )
+	{
+		// something is walking (or sharing) the array, so leave it be and change a copy
+		EventImpl* copy = new EventImpl;
+		copy->m_Delegates.reserve( m_Impl->m_Delegates.size() + 1 );
+		for ( size_t i=0; i<m_Impl->m_Delegates.size(); ++i )
+		{
+			if ( m_Impl->m_Delegates[i].Valid() )
+			{
+				copy->m_Delegates.push_back( m_Impl->m_Delegates[i] );
+			}
+		}
+
+		// keep hold of the arrays still being raised, so removals can reach them
+		copy->m_Replaced = m_Impl->IsRaising() ? m_Impl : m_Impl->m_Replaced;
+		m_Impl = copy;
+	}
+
+	// forget replaced arrays once nothing is raising them
+	bool raising = false;
+	for ( EventImpl* replaced = m_Impl->m_Replaced; replaced && !raising; replaced = replaced->m_Replaced )
+	{
+		raising = replaced->IsRaising();
+	}
+	if ( !raising )
+	{
+		m_Impl->m_Replaced = NULL;
+	}
+
+	return m_Impl;
+}
+
+template< typename ArgsType, template< typename T > class RefCountBaseType >
+void Helium::Event< ArgsType, RefCountBaseType >::Trim()
+{
+	if ( m_Impl->Count() == 0 )
+	{
+		m_Impl = NULL;
+	}
+}
+
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 Helium::Event< ArgsType, RefCountBaseType >::EventImpl::EventImpl()
-	: m_EntryCount (0)
-	, m_EmptySlots (0)
+	: m_RaiseCount (0)
 {
 
 }
@@ -377,166 +443,95 @@ uint32_t Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Count() const
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
-void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Compact()
+bool Helium::Event< ArgsType, RefCountBaseType >::EventImpl::IsRaising() const
 {
-	if (m_EmptySlots)
-	{
-		typename std::vector<Delegate>::iterator itr = m_Delegates.begin();
-		typename std::vector<Delegate>::iterator end = m_Delegates.end();
-		for ( uint32_t slotsLeft = m_EmptySlots; itr != end && slotsLeft; ++itr )
-		{
-			if ( !itr->Valid() )
-			{
-				typename std::vector<Delegate>::iterator next = itr + 1;
-				for ( ; next != end; ++next )
-				{
-					if (next->Valid())
-					{
-						*itr = *next;
-						next->Clear();
-						--slotsLeft;
-						break;
-					}
-				}
-			}
-		}
-
-		m_Delegates.resize( m_Delegates.size() - m_EmptySlots );
-		m_EmptySlots = 0;
-	}
+	return m_RaiseCount > 0;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
-void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Add( const Delegate& delegate )
+const typename Helium::Event< ArgsType, RefCountBaseType >::Delegate* Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Find( const Delegate& delegate ) const
 {
-	typename std::vector<Delegate>::const_iterator itr = m_Delegates.begin();
-	typename std::vector<Delegate>::const_iterator end = m_Delegates.end();
-	for ( ; itr != end; ++itr )
+	for ( size_t i=0; i<m_Delegates.size(); ++i )
 	{
-		if ( itr->Valid() && itr->Equals(delegate) )
+		if ( m_Delegates[i].Equals( delegate ) )
 		{
-			return;
+			return &m_Delegates[i];
 		}
 	}
 
-	m_Delegates.push_back( delegate );
+	return NULL;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template< typename FunctionType >
-void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::AddFunction( FunctionType function )
+const typename Helium::Event< ArgsType, RefCountBaseType >::Delegate* Helium::Event< ArgsType, RefCountBaseType >::EventImpl::FindFunction( FunctionType function ) const
 {
-	typename std::vector<Delegate>::const_iterator itr = m_Delegates.begin();
-	typename std::vector<Delegate>::const_iterator end = m_Delegates.end();
-	for ( ; itr != end; ++itr )
+	for ( size_t i=0; i<m_Delegates.size(); ++i )
 	{
-		if ( itr->Valid() && itr->Equals(function) )
+		if ( m_Delegates[i].Equals( function ) )
 		{
-			return;
+			return &m_Delegates[i];
 		}
 	}
 
-	m_Delegates.push_back( Delegate (function) );
+	return NULL;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 template< class ClassType, typename MethodType >
-void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::AddMethod( ClassType* instance, MethodType method )
+const typename Helium::Event< ArgsType, RefCountBaseType >::Delegate* Helium::Event< ArgsType, RefCountBaseType >::EventImpl::FindMethod( const ClassType* instance, MethodType method ) const
 {
-	typename std::vector<Delegate>::const_iterator itr = m_Delegates.begin();
-	typename std::vector<Delegate>::const_iterator end = m_Delegates.end();
-	for ( ; itr != end; ++itr )
+	for ( size_t i=0; i<m_Delegates.size(); ++i )
 	{
-		if ( itr->Valid() && itr->Equals(instance, method ))
+		if ( m_Delegates[i].Equals( instance, method ) )
 		{
-			return;
+			return &m_Delegates[i];
 		}
 	}
 
-	m_Delegates.push_back( Delegate (instance, method) );
+	return NULL;
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
-void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Remove( const Delegate& delegate )
+void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Add( const Delegate& delegate )
 {
-	typename std::vector<Delegate>::iterator itr = m_Delegates.begin();
-	typename std::vector<Delegate>::iterator end = m_Delegates.end();
-	for ( ; itr != end; ++itr )
-	{
-		if ( itr->Valid() && itr->Equals(delegate) )
-		{
-			/* see stackoverflow 5286922 */
-			/* the this is to fix template ambiguity */
-			if ( this->GetRefCount() == 1 )
-			{
-				m_Delegates.erase( itr );
-			}
-			else
-			{
-				m_EmptySlots++;
-				itr->Clear();
-			}
-			break;
-		}
-	}
-}
+	/* see stackoverflow 5286922 */
+	/* the this is to fix template ambiguity */
+	HELIUM_ASSERT( this->GetRefCount() == 1 );
 
-template< typename ArgsType, template< typename T > class RefCountBaseType >
-template< typename FunctionType >
-void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::RemoveFunction( FunctionType function )
-{
-	typename std::vector<Delegate>::iterator itr = m_Delegates.begin();
-	typename std::vector<Delegate>::iterator end = m_Delegates.end();
-	for ( ; itr != end; ++itr )
-	{
-		if ( itr->Valid() && itr->Equals(function) )
-		{
-			if ( this->GetRefCount() == 1 )
-			{
-				m_Delegates.erase( itr );
-			}
-			else
-			{
-				m_EmptySlots++;
-				itr->Clear();
-			}
-			break;
-		}
-	}
+	m_Delegates.push_back( delegate );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
-template< class ClassType, typename MethodType >
-void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::RemoveMethod( const ClassType* instance, MethodType method )
+void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Remove( const Delegate* delegate )
 {
-	typename std::vector<Delegate>::iterator itr = m_Delegates.begin();
-	typename std::vector<Delegate>::iterator end = m_Delegates.end();
-	for ( ; itr != end; ++itr )
+	HELIUM_ASSERT( this->GetRefCount() == 1 );
+	HELIUM_ASSERT( delegate >= &m_Delegates.front() && delegate <= &m_Delegates.back() );
+
+	// raises still walking older arrays must not call it either
+	for ( EventImpl* replaced = m_Replaced; replaced; replaced = replaced->m_Replaced )
 	{
-		if ( itr->Valid() && itr->Equals(instance, method) )
+		for ( size_t i=0; i<replaced->m_Delegates.size(); ++i )
 		{
-			if ( this->GetRefCount() == 1 )
-			{
-				m_Delegates.erase( itr );
-			}
-			else
+			if ( replaced->m_Delegates[i].Equals( *delegate ) )
 			{
-				m_EmptySlots++;
-				itr->Clear();
+				replaced->m_Delegates[i].Clear();
 			}
-			break;
 		}
 	}
+
+	m_Delegates.erase( m_Delegates.begin() + ( delegate - &m_Delegates.front() ) );
 }
 
 template< typename ArgsType, template< typename T > class RefCountBaseType >
 void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Raise( ArgsType parameter, const Delegate& emitter )
 {
-	++m_EntryCount;
+	++m_RaiseCount;
 
-	for ( size_t i=0; i<m_Delegates.size(); ++i )
+	// nothing is added to or removed from this array while we hold it, entries can only be cleared
+	for ( size_t i=0, count=m_Delegates.size(); i<count; ++i )
 	{
-		Delegate& d ( m_Delegates[i] );
+		const Delegate& d ( m_Delegates[i] );
 
 		if ( !d.Valid() || ( emitter.Valid() && emitter.Equals( d ) ) )
 		{
@@ -546,8 +541,5 @@ void Helium::Event< ArgsType, RefCountBaseType >::EventImpl::Raise( ArgsType par
 		d.Invoke(parameter); 
 	}
 
-	if ( --m_EntryCount == 0 )
-	{
-		Compact();
-	}
+	--m_RaiseCount;
 }
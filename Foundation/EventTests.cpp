@@ -0,0 +1,195 @@
+#include "Precompile.h"
+#include "Foundation/Event.h"
+
+#include "Platform/Console.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+using namespace Helium;
+
+struct EventTestArgs
+{
+	uint32_t m_Value;
+};
+
+typedef Signature< const EventTestArgs& > EventTestSignature;
+
+static uint32_t g_FunctionCalls = 0;
+
+static void CountFunctionCall( const EventTestArgs& args )
+{
+	g_FunctionCalls += args.m_Value;
+}
+
+// counts its calls, and can change the event it is listening to from inside a raise
+struct EventTestListener
+{
+	uint32_t                   m_Calls;
+	EventTestSignature::Event* m_Event;
+	EventTestListener*         m_Remove;
+	EventTestListener*         m_Add;
+	bool                       m_Reraise;
+
+	EventTestListener()
+		: m_Calls( 0 )
+		, m_Event( NULL )
+		, m_Remove( NULL )
+		, m_Add( NULL )
+		, m_Reraise( false )
+	{
+	}
+
+	void Changed( const EventTestArgs& args )
+	{
+		m_Calls += args.m_Value;
+
+		if ( m_Add )
+		{
+			m_Event->AddMethod( m_Add, &EventTestListener::Changed );
+			m_Add = NULL;
+		}
+
+		if ( m_Reraise )
+		{
+			m_Reraise = false;
+			EventTestArgs nested = { 100 };
+			m_Event->Raise( nested );
+		}
+
+		if ( m_Remove )
+		{
+			m_Event->RemoveMethod( m_Remove, &EventTestListener::Changed );
+			m_Remove = NULL;
+		}
+	}
+};
+
+TEST(Event, DelegatesBindAndCompareInline)
+{
+	EventTestSignature::Delegate empty;
+	EXPECT_FALSE( empty.Valid() );
+	EXPECT_FALSE( empty.Equals( empty ) );
+
+	EventTestListener a, b;
+	EventTestSignature::Delegate method ( &a, &EventTestListener::Changed );
+	EventTestSignature::Delegate function ( &CountFunctionCall );
+	EXPECT_TRUE( method.Equals( EventTestSignature::Delegate ( &a, &EventTestListener::Changed ) ) );
+	EXPECT_FALSE( method.Equals( EventTestSignature::Delegate ( &b, &EventTestListener::Changed ) ) );
+	EXPECT_TRUE( method.Equals( &a, &EventTestListener::Changed ) );
+	EXPECT_FALSE( method.Equals( function ) );
+	EXPECT_TRUE( function.Equals( &CountFunctionCall ) );
+
+	EventTestSignature::Delegate copy;
+	copy.Set( method );
+	EventTestArgs args = { 3 };
+	copy.Invoke( args );
+	EXPECT_EQ( 3u, a.m_Calls );
+
+	g_FunctionCalls = 0;
+	function.Invoke( args );
+	EXPECT_EQ( 3u, g_FunctionCalls );
+
+	copy.Clear();
+	EXPECT_FALSE( copy.Valid() );
+	copy.Invoke( args );
+	EXPECT_EQ( 3u, a.m_Calls );
+}
+
+TEST(Event, ChangesDuringRaise)
+{
+	EventTestSignature::Event event;
+	EventTestListener a, b, c, d;
+	a.m_Event = b.m_Event = c.m_Event = d.m_Event = &event;
+
+	event.AddMethod( &a, &EventTestListener::Changed );
+	event.AddMethod( &a, &EventTestListener::Changed );
+	event.AddMethod( &b, &EventTestListener::Changed );
+	event.AddMethod( &c, &EventTestListener::Changed );
+	event.AddFunction( &CountFunctionCall );
+	EXPECT_EQ( 4u, event.Count() );
+
+	// a listener added during a raise hears the next one, a listener removed during a raise hears nothing more
+	a.m_Add = &d;
+	b.m_Remove = &c;
+	g_FunctionCalls = 0;
+	EventTestArgs args = { 1 };
+	event.Raise( args );
+	EXPECT_EQ( 1u, a.m_Calls );
+	EXPECT_EQ( 1u, b.m_Calls );
+	EXPECT_EQ( 0u, c.m_Calls );
+	EXPECT_EQ( 0u, d.m_Calls );
+	EXPECT_EQ( 1u, g_FunctionCalls );
+	EXPECT_EQ( 4u, event.Count() );
+
+	event.Raise( args );
+	EXPECT_EQ( 2u, a.m_Calls );
+	EXPECT_EQ( 0u, c.m_Calls );
+	EXPECT_EQ( 1u, d.m_Calls );
+
+	// nested raises see the array as it is when they start, and removals reach the outer raise too
+	a.m_Reraise = true;
+	b.m_Remove = &d;
+	event.Raise( args );
+	EXPECT_EQ( 103u, a.m_Calls );
+	EXPECT_EQ( 103u, b.m_Calls );
+	EXPECT_EQ( 1u, d.m_Calls );
+	EXPECT_EQ( 3u, event.Count() );
+
+	// the emitter doesn't hear itself
+	event.RaiseWithEmitter( args, EventTestSignature::Delegate ( &a, &EventTestListener::Changed ) );
+	EXPECT_EQ( 103u, a.m_Calls );
+	EXPECT_EQ( 104u, b.m_Calls );
+
+	event.RemoveMethod( &a, &EventTestListener::Changed );
+	event.RemoveMethod( &b, &EventTestListener::Changed );
+	event.RemoveFunction( &CountFunctionCall );
+	EXPECT_FALSE( event.Valid() );
+}
+
+TEST(Event, DispatchBenchmark)
+{
+	const uint32_t listenerCounts[] = { 0, 1, 8, 64 };
+	const uint32_t raiseCalls = 4000000;
+
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( listenerCounts ); ++i )
+	{
+		uint32_t listenerCount = listenerCounts[ i ];
+		uint32_t raiseCount = raiseCalls / ( listenerCount ? listenerCount : 1 );
+
+		EventTestSignature::Event event;
+		EventTestListener listeners[ 64 ];
+		for ( uint32_t j = 0; j < listenerCount; ++j )
+		{
+			event.AddMethod( &listeners[ j ], &EventTestListener::Changed );
+		}
+
+		SimpleTimer timer;
+		EventTestArgs args = { 1 };
+		for ( uint32_t j = 0; j < raiseCount; ++j )
+		{
+			event.Raise( args );
+		}
+		float64_t millis = timer.Elapsed();
+
+		uint32_t calls = 0;
+		for ( uint32_t j = 0; j < listenerCount; ++j )
+		{
+			calls += listeners[ j ].m_Calls;
+		}
+		EXPECT_EQ( raiseCount * listenerCount, calls );
+
+		timer.Reset();
+		for ( uint32_t j = 0; j < raiseCount; ++j )
+		{
+			EventTestSignature::Delegate delegate ( &listeners[ 0 ], &EventTestListener::Changed );
+			event.Add( delegate );
+			event.Remove( delegate );
+		}
+		float64_t bindMillis = timer.Elapsed();
+
+		Helium::Print( "Event: %2u listener(s), %.1f ns/raise, %.1f ns/listener call, %.1f ns to bind, add and remove\n",
+			listenerCount, millis * 1000000.0 / raiseCount, listenerCount ? millis * 1000000.0 / ( raiseCount * listenerCount ) : 0.0,
+			bindMillis * 1000000.0 / raiseCount );
+	}
+}
@@ -81,6 +81,8 @@ void Helium::ProcessException(const Helium::Exception& exception, bool print, bo
 
     if ( fatal )
     {
+        // write out anything still queued for the async log writer before we go down
+        Log::Flush();
         g_Terminating.Raise( TerminateArgs () );
         EnableExceptionFilter( false );
     }
@@ -130,6 +132,8 @@ void Helium::ProcessException(const std::exception& exception, bool print, bool
 
     if ( fatal )
     {
+        // write out anything still queued for the async log writer before we go down
+        Log::Flush();
         g_Terminating.Raise( TerminateArgs () );
         EnableExceptionFilter( false );
     }
@@ -173,6 +177,8 @@ uint32_t Helium::ProcessException(LPEXCEPTION_POINTERS info, bool print, bool fa
 
         if ( fatal )
         {
+            // write out anything still queued for the async log writer before we go down
+            Log::Flush();
             g_Terminating.Raise( TerminateArgs () );
             EnableExceptionFilter( false );
         }
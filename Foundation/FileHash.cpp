@@ -0,0 +1,585 @@
+#include "Precompile.h"
+#include "Foundation/FileHash.h"
+
+#include "Platform/Atomic.h"
+#include "Platform/File.h"
+#include "Platform/Runtime.h"
+#include "Platform/Thread.h"
+
+#include "Foundation/Endian.h"
+#include "Foundation/MD5.h"
+#include "Foundation/Math.h"
+
+#include <time.h>
+
+using namespace Helium;
+
+static const uint64_t XXHashPrime1 = 11400714785074694791ULL;
+static const uint64_t XXHashPrime2 = 14029467366897019727ULL;
+static const uint64_t XXHashPrime3 = 1609587929392839161ULL;
+static const uint64_t XXHashPrime4 = 9650029242287828579ULL;
+static const uint64_t XXHashPrime5 = 2870177450012600261ULL;
+
+static inline uint64_t XXHashRotate( uint64_t value, uint32_t bits )
+{
+	return ( value << bits ) | ( value >> ( 64 - bits ) );
+}
+
+static inline uint64_t XXHashRead64( const uint8_t* pData )
+{
+	uint64_t value;
+	MemoryCopy( &value, pData, sizeof( value ) );
+#if HELIUM_ENDIAN_BIG
+	value = ConvertEndian( value );
+#endif
+	return value;
+}
+
+static inline uint32_t XXHashRead32( const uint8_t* pData )
+{
+	uint32_t value;
+	MemoryCopy( &value, pData, sizeof( value ) );
+#if HELIUM_ENDIAN_BIG
+	value = ConvertEndian( value );
+#endif
+	return value;
+}
+
+static inline uint64_t XXHashRound( uint64_t accumulator, uint64_t input )
+{
+	accumulator += input * XXHashPrime2;
+	accumulator = XXHashRotate( accumulator, 31 );
+	return accumulator * XXHashPrime1;
+}
+
+static inline uint64_t XXHashMergeRound( uint64_t accumulator, uint64_t value )
+{
+	accumulator ^= XXHashRound( 0, value );
+	return accumulator * XXHashPrime1 + XXHashPrime4;
+}
+
+// one 32 byte stripe into the four accumulators
+static inline void XXHashStripe( uint64_t* pAccumulators, const uint8_t* pData )
+{
+	pAccumulators[ 0 ] = XXHashRound( pAccumulators[ 0 ], XXHashRead64( pData ) );
+	pAccumulators[ 1 ] = XXHashRound( pAccumulators[ 1 ], XXHashRead64( pData + 8 ) );
+	pAccumulators[ 2 ] = XXHashRound( pAccumulators[ 2 ], XXHashRead64( pData + 16 ) );
+	pAccumulators[ 3 ] = XXHashRound( pAccumulators[ 3 ], XXHashRead64( pData + 24 ) );
+}
+
+/// Constructor.
+///
+/// @param[in] seed  Seed, hashes only match others with the same one.
+XXHash64::XXHash64( uint64_t seed )
+	: m_seed( seed )
+	, m_totalSize( 0 )
+	, m_bufferSize( 0 )
+{
+	m_accumulators[ 0 ] = seed + XXHashPrime1 + XXHashPrime2;
+	m_accumulators[ 1 ] = seed + XXHashPrime2;
+	m_accumulators[ 2 ] = seed;
+	m_accumulators[ 3 ] = seed - XXHashPrime1;
+}
+
+/// Add data to the hash.
+///
+/// @param[in] pData  Data to add.
+/// @param[in] size   Size of the data, in bytes.
+void XXHash64::Update( const void* pData, size_t size )
+{
+	HELIUM_ASSERT( pData || size == 0 );
+
+	const uint8_t* pBytes = static_cast< const uint8_t* >( pData );
+	m_totalSize += size;
+
+	// finish a stripe started by the last update
+	if( m_bufferSize )
+	{
+		size_t copySize = Min( size, sizeof( m_buffer ) - m_bufferSize );
+		MemoryCopy( m_buffer + m_bufferSize, pBytes, copySize );
+		m_bufferSize += static_cast< uint32_t >( copySize );
+		pBytes += copySize;
+		size -= copySize;
+
+		if( m_bufferSize < sizeof( m_buffer ) )
+		{
+			return;
+		}
+
+		XXHashStripe( m_accumulators, m_buffer );
+		m_bufferSize = 0;
+	}
+
+	for( ; size >= sizeof( m_buffer ); pBytes += sizeof( m_buffer ), size -= sizeof( m_buffer ) )
+	{
+		XXHashStripe( m_accumulators, pBytes );
+	}
+
+	MemoryCopy( m_buffer, pBytes, size );
+	m_bufferSize = static_cast< uint32_t >( size );
+}
+
+/// Get the hash of the data so far.
+///
+/// @return  Hash value.
+uint64_t XXHash64::Finish() const
+{
+	uint64_t hash;
+	if( m_totalSize >= sizeof( m_buffer ) )
+	{
+		hash = XXHashRotate( m_accumulators[ 0 ], 1 ) + XXHashRotate( m_accumulators[ 1 ], 7 ) +
+			XXHashRotate( m_accumulators[ 2 ], 12 ) + XXHashRotate( m_accumulators[ 3 ], 18 );
+		hash = XXHashMergeRound( hash, m_accumulators[ 0 ] );
+		hash = XXHashMergeRound( hash, m_accumulators[ 1 ] );
+		hash = XXHashMergeRound( hash, m_accumulators[ 2 ] );
+		hash = XXHashMergeRound( hash, m_accumulators[ 3 ] );
+	}
+	else
+	{
+		hash = m_seed + XXHashPrime5;
+	}
+
+	hash += m_totalSize;
+
+	const uint8_t* pBytes = m_buffer;
+	const uint8_t* pEnd = m_buffer + m_bufferSize;
+	for( ; pBytes + 8 <= pEnd; pBytes += 8 )
+	{
+		hash ^= XXHashRound( 0, XXHashRead64( pBytes ) );
+		hash = XXHashRotate( hash, 27 ) * XXHashPrime1 + XXHashPrime4;
+	}
+
+	if( pBytes + 4 <= pEnd )
+	{
+		hash ^= static_cast< uint64_t >( XXHashRead32( pBytes ) ) * XXHashPrime1;
+		hash = XXHashRotate( hash, 23 ) * XXHashPrime2 + XXHashPrime3;
+		pBytes += 4;
+	}
+
+	for( ; pBytes < pEnd; ++pBytes )
+	{
+		hash ^= *pBytes * XXHashPrime5;
+		hash = XXHashRotate( hash, 11 ) * XXHashPrime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXHashPrime2;
+	hash ^= hash >> 29;
+	hash *= XXHashPrime3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+// read with a buffer the caller keeps, so workers don't allocate one per file
+static bool HashFile( const char* pPath, FileHashAlgorithm algorithm, std::string& rHash, DynamicArray< uint8_t >& rBuffer )
+{
+	File file;
+	if( !file.Open( pPath, FileModes::Read, false ) )
+	{
+		return false;
+	}
+
+	if( rBuffer.IsEmpty() )
+	{
+		rBuffer.Resize( FileHashCache::READ_SIZE );
+	}
+
+	XXHash64 xxHash;
+	MD5Hasher md5;
+	size_t bytesRead = 0;
+	for( ;; )
+	{
+		if( !file.Read( rBuffer.GetData(), rBuffer.GetSize(), &bytesRead ) )
+		{
+			return false;
+		}
+
+		if( bytesRead == 0 )
+		{
+			break;
+		}
+
+		if( algorithm == FileHashAlgorithms::MD5 )
+		{
+			md5.Update( rBuffer.GetData(), bytesRead );
+		}
+		else
+		{
+			xxHash.Update( rBuffer.GetData(), bytesRead );
+		}
+	}
+
+	if( algorithm == FileHashAlgorithms::MD5 )
+	{
+		rHash = md5.Finish();
+	}
+	else
+	{
+		static const char digits[] = "0123456789ABCDEF";
+		uint64_t value = xxHash.Finish();
+		rHash.resize( 16 );
+		for( size_t digitIndex = 0; digitIndex < 16; ++digitIndex )
+		{
+			rHash[ 15 - digitIndex ] = digits[ ( value >> ( digitIndex * 4 ) ) & 0xf ];
+		}
+	}
+
+	return true;
+}
+
+/// Hash the contents of a file, as upper case hex.
+///
+/// @param[in]  pPath      File to hash.
+/// @param[in]  algorithm  Hash to use.
+/// @param[out] rHash      Hash of the file, if it could be read.
+///
+/// @return  True if the file was read, false if not.
+bool Helium::HashFile( const char* pPath, FileHashAlgorithm algorithm, std::string& rHash )
+{
+	DynamicArray< uint8_t > buffer;
+	return ::HashFile( pPath, algorithm, rHash, buffer );
+}
+
+// the cache file, machine local so in native byte order
+static const uint32_t FileHashCacheMagic = 0x43484648;  // "HFHC"
+static const uint32_t FileHashCacheVersion = 1;
+
+template< typename T >
+static void AppendValue( DynamicArray< uint8_t >& rData, const T& rValue )
+{
+	rData.AddArray( reinterpret_cast< const uint8_t* >( &rValue ), sizeof( rValue ) );
+}
+
+template< typename T >
+static bool ReadValue( const uint8_t*& rpData, const uint8_t* pEnd, T& rValue )
+{
+	if( static_cast< size_t >( pEnd - rpData ) < sizeof( rValue ) )
+	{
+		return false;
+	}
+
+	MemoryCopy( &rValue, rpData, sizeof( rValue ) );
+	rpData += sizeof( rValue );
+	return true;
+}
+
+static bool ReadString( const uint8_t*& rpData, const uint8_t* pEnd, size_t length, std::string& rString )
+{
+	if( static_cast< size_t >( pEnd - rpData ) < length )
+	{
+		return false;
+	}
+
+	rString.assign( reinterpret_cast< const char* >( rpData ), length );
+	rpData += length;
+	return true;
+}
+
+struct FileHashCache::Worker
+{
+	FileHashCache*          m_pCache;
+	CallbackThread          m_thread;
+	DynamicArray< uint8_t > m_buffer;
+
+	void Run()
+	{
+		m_pCache->Run( m_buffer );
+	}
+};
+
+/// Constructor.
+///
+/// @param[in] algorithm  Hash to use.
+FileHashCache::FileHashCache( FileHashAlgorithm algorithm )
+	: m_algorithm( algorithm )
+	, m_hitCount( 0 )
+	, m_missCount( 0 )
+	, m_pJobs( NULL )
+	, m_jobCount( 0 )
+	, m_nextJob( 0 )
+{
+}
+
+/// Load the entries saved by Save(), replacing any in the cache.
+///
+/// @param[in] pPath  File to load.
+///
+/// @return  True if the entries were loaded, false if the file is missing, damaged, or uses another hash (leaving
+///          the cache empty).
+bool FileHashCache::Load( const char* pPath )
+{
+	HELIUM_ASSERT( pPath );
+
+	Clear();
+
+	File file;
+	if( !file.Open( pPath, FileModes::Read, false ) )
+	{
+		return false;
+	}
+
+	DynamicArray< uint8_t > data;
+	data.Resize( static_cast< size_t >( file.GetSize() ) );
+	size_t bytesRead = 0;
+	if( data.IsEmpty() || !file.Read( data.GetData(), data.GetSize(), &bytesRead ) || bytesRead != data.GetSize() )
+	{
+		return false;
+	}
+
+	const uint8_t* pData = data.GetData();
+	const uint8_t* pEnd = pData + data.GetSize();
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t algorithm = 0;
+	uint32_t count = 0;
+	if( !ReadValue( pData, pEnd, magic ) || magic != FileHashCacheMagic ||
+		!ReadValue( pData, pEnd, version ) || version != FileHashCacheVersion ||
+		!ReadValue( pData, pEnd, algorithm ) || algorithm != static_cast< uint32_t >( m_algorithm ) ||
+		!ReadValue( pData, pEnd, count ) )
+	{
+		return false;
+	}
+
+	std::string path;
+	Entry entry;
+	for( uint32_t entryIndex = 0; entryIndex < count; ++entryIndex )
+	{
+		uint32_t pathLength = 0;
+		uint8_t hashLength = 0;
+		if( !ReadValue( pData, pEnd, entry.m_size ) ||
+			!ReadValue( pData, pEnd, entry.m_modifiedTime ) ||
+			!ReadValue( pData, pEnd, entry.m_fileId ) ||
+			!ReadValue( pData, pEnd, entry.m_hashedTime ) ||
+			!ReadValue( pData, pEnd, pathLength ) ||
+			!ReadString( pData, pEnd, pathLength, path ) ||
+			!ReadValue( pData, pEnd, hashLength ) ||
+			!ReadString( pData, pEnd, hashLength, entry.m_hash ) )
+		{
+			m_entries.clear();
+			return false;
+		}
+
+		m_entries.insert( m_entries.end(), std::make_pair( path, entry ) );
+	}
+
+	return true;
+}
+
+/// Save the entries, for Load() in a later run.
+///
+/// @param[in] pPath  File to save to.
+///
+/// @return  True if the file was written, false if not.
+bool FileHashCache::Save( const char* pPath ) const
+{
+	HELIUM_ASSERT( pPath );
+
+	DynamicArray< uint8_t > data;
+	AppendValue( data, FileHashCacheMagic );
+	AppendValue( data, FileHashCacheVersion );
+	AppendValue( data, static_cast< uint32_t >( m_algorithm ) );
+	AppendValue( data, static_cast< uint32_t >( m_entries.size() ) );
+
+	for( std::map< std::string, Entry >::const_iterator itr = m_entries.begin(), end = m_entries.end(); itr != end; ++itr )
+	{
+		const Entry& rEntry = itr->second;
+		AppendValue( data, rEntry.m_size );
+		AppendValue( data, rEntry.m_modifiedTime );
+		AppendValue( data, rEntry.m_fileId );
+		AppendValue( data, rEntry.m_hashedTime );
+		AppendValue( data, static_cast< uint32_t >( itr->first.size() ) );
+		data.AddArray( reinterpret_cast< const uint8_t* >( itr->first.data() ), itr->first.size() );
+		AppendValue( data, static_cast< uint8_t >( rEntry.m_hash.size() ) );
+		data.AddArray( reinterpret_cast< const uint8_t* >( rEntry.m_hash.data() ), rEntry.m_hash.size() );
+	}
+
+	File file;
+	return file.Open( pPath, FileModes::Write ) && file.Write( data.GetData(), data.GetSize() );
+}
+
+/// Forget every entry, and reset the hit and miss counts.
+void FileHashCache::Clear()
+{
+	m_entries.clear();
+	m_hitCount = 0;
+	m_missCount = 0;
+}
+
+/// Get the hash of a file's contents, from the cache if the file hasn't changed since it was last hashed.
+///
+/// @param[in]  path   File to hash.
+/// @param[out] rHash  Hash of the file, as upper case hex.
+///
+/// @return  True if the hash was found, false if the file couldn't be read.
+bool FileHashCache::GetHash( const FilePath& path, std::string& rHash )
+{
+	Job job;
+	job.m_pPath = &path;
+	job.m_pHash = &rHash;
+	Process( job, m_buffer );
+	Finish( job );
+
+	return job.m_succeeded;
+}
+
+/// Get the hashes of many files, reading those not in the cache on worker threads.
+///
+/// @param[in]  paths        Files to hash.
+/// @param[out] rHashes      Hash of each file, or an empty string for those that couldn't be read.
+/// @param[in]  threadCount  Threads to hash on (the caller's included), or zero for one per processor.
+///
+/// @return  Number of files hashed.
+size_t FileHashCache::GetHashes( const std::vector< FilePath >& paths, std::vector< std::string >& rHashes, uint32_t threadCount )
+{
+	rHashes.resize( paths.size() );
+	if( paths.empty() )
+	{
+		return 0;
+	}
+
+	std::vector< Job > jobs ( paths.size() );
+	for( size_t pathIndex = 0; pathIndex < paths.size(); ++pathIndex )
+	{
+		jobs[ pathIndex ].m_pPath = &paths[ pathIndex ];
+		jobs[ pathIndex ].m_pHash = &rHashes[ pathIndex ];
+	}
+
+	if( threadCount == 0 )
+	{
+		threadCount = Helium::Platform::GetProcessorCount();
+	}
+	threadCount = static_cast< uint32_t >( Clamp< size_t >( threadCount, 1, paths.size() ) );
+
+	// the entries only change once every worker is done, until then they are only read
+	m_pJobs = &jobs[ 0 ];
+	m_jobCount = static_cast< int32_t >( jobs.size() );
+	m_nextJob = 0;
+
+	Worker* pWorkers = NULL;
+	if( threadCount > 1 )
+	{
+		pWorkers = new Worker[ threadCount - 1 ];
+		for( uint32_t workerIndex = 0; workerIndex < threadCount - 1; ++workerIndex )
+		{
+			pWorkers[ workerIndex ].m_pCache = this;
+			HELIUM_VERIFY( pWorkers[ workerIndex ].m_thread.Create(
+				&CallbackThread::EntryHelper< Worker, &Worker::Run >, &pWorkers[ workerIndex ], "File Hash" ) );
+		}
+	}
+
+	Run( m_buffer );
+
+	for( uint32_t workerIndex = 0; workerIndex + 1 < threadCount; ++workerIndex )
+	{
+		pWorkers[ workerIndex ].m_thread.Join();
+	}
+	delete [] pWorkers;
+
+	m_pJobs = NULL;
+	m_jobCount = 0;
+
+	size_t hashedCount = 0;
+	for( size_t jobIndex = 0; jobIndex < jobs.size(); ++jobIndex )
+	{
+		Finish( jobs[ jobIndex ] );
+		hashedCount += jobs[ jobIndex ].m_succeeded ? 1 : 0;
+	}
+
+	return hashedCount;
+}
+
+/// Hash files of GetHashes() until there are none left.
+///
+/// @param[in] rBuffer  Buffer to read into.
+void FileHashCache::Run( DynamicArray< uint8_t >& rBuffer )
+{
+	for( ;; )
+	{
+		int32_t jobIndex = AtomicIncrement( m_nextJob ) - 1;
+		if( jobIndex >= m_jobCount )
+		{
+			break;
+		}
+
+		Process( m_pJobs[ jobIndex ], rBuffer );
+	}
+}
+
+/// Find the hash of a file in the cache, or read the file for it.  Only reads the entries, so workers can run
+/// this at the same time.
+///
+/// @param[in] rJob     File to hash.
+/// @param[in] rBuffer  Buffer to read into.
+void FileHashCache::Process( Job& rJob, DynamicArray< uint8_t >& rBuffer ) const
+{
+	rJob.m_succeeded = false;
+	rJob.m_hit = false;
+	rJob.m_pHash->clear();
+
+	const char* pPath = rJob.m_pPath->Data();
+	Status status;
+	if( !status.Read( pPath ) || ( status.m_Mode & StatusModes::Directory ) )
+	{
+		return;
+	}
+
+	Entry& rEntry = rJob.m_entry;
+	rEntry.m_size = status.m_Size;
+	rEntry.m_modifiedTime = status.m_ModifiedTime;
+	rEntry.m_fileId = status.m_FileId;
+
+	std::map< std::string, Entry >::const_iterator found = m_entries.find( rJob.m_pPath->Get() );
+	if( found != m_entries.end() )
+	{
+		const Entry& rCached = found->second;
+		if( rCached.m_size == rEntry.m_size && rCached.m_modifiedTime == rEntry.m_modifiedTime &&
+			rCached.m_fileId == rEntry.m_fileId && rCached.m_modifiedTime < rCached.m_hashedTime )
+		{
+			*rJob.m_pHash = rCached.m_hash;
+			rJob.m_succeeded = true;
+			rJob.m_hit = true;
+			return;
+		}
+	}
+
+	rEntry.m_hashedTime = static_cast< uint64_t >( time( NULL ) );
+	if( !::HashFile( pPath, m_algorithm, *rJob.m_pHash, rBuffer ) )
+	{
+		rJob.m_pHash->clear();
+		return;
+	}
+
+	// changed while being read, the hash is right for neither version so never trust it
+	Status after;
+	if( !after.Read( pPath ) || after.m_Size != status.m_Size || after.m_ModifiedTime != status.m_ModifiedTime )
+	{
+		rEntry.m_hashedTime = 0;
+	}
+
+	rEntry.m_hash = *rJob.m_pHash;
+	rJob.m_succeeded = true;
+}
+
+/// Update the entries and counts with a file Process() handled.
+///
+/// @param[in] rJob  File hashed.
+void FileHashCache::Finish( Job& rJob )
+{
+	if( rJob.m_hit )
+	{
+		++m_hitCount;
+		return;
+	}
+
+	if( rJob.m_succeeded )
+	{
+		++m_missCount;
+		m_entries[ rJob.m_pPath->Get() ] = rJob.m_entry;
+	}
+	else
+	{
+		m_entries.erase( rJob.m_pPath->Get() );
+	}
+}
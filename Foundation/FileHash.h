@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Platform/Types.h"
+
+#include "Foundation/API.h"
+#include "Foundation/DynamicArray.h"
+#include "Foundation/FilePath.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Helium
+{
+	namespace FileHashAlgorithms
+	{
+		/// Hash of file contents.
+		enum Type
+		{
+			XXHash64,  ///< 64-bit xxHash, fast and not cryptographic (16 hex digits).
+			MD5,       ///< MD5, as FileMD5() gives (32 hex digits).
+		};
+	}
+	typedef FileHashAlgorithms::Type FileHashAlgorithm;
+
+	/// 64-bit xxHash (XXH64) of data that comes in pieces, many times faster than MD5 and meant for telling contents
+	/// apart, not for security.
+	class HELIUM_FOUNDATION_API XXHash64
+	{
+	public:
+		explicit XXHash64( uint64_t seed = 0 );
+
+		void Update( const void* pData, size_t size );
+		uint64_t Finish() const;
+
+	private:
+		uint64_t m_accumulators[ 4 ];
+		uint64_t m_seed;
+		uint64_t m_totalSize;
+		uint8_t  m_buffer[ 32 ];
+		uint32_t m_bufferSize;
+	};
+
+	/// Hash the contents of a file, as upper case hex.
+	///
+	/// @param[in]  pPath      File to hash.
+	/// @param[in]  algorithm  Hash to use.
+	/// @param[out] rHash      Hash of the file, if it could be read.
+	///
+	/// @return  True if the file was read, false if not.
+	HELIUM_FOUNDATION_API bool HashFile( const char* pPath, FileHashAlgorithm algorithm, std::string& rHash );
+
+	/// Hashes of file contents, remembered by path along with the size, modification time and identity (inode) each
+	/// file had when it was hashed.  Files that still match are not read again, and the cache can be saved and
+	/// loaded between runs.
+	///
+	/// Times only have whole seconds, so a file changed in the same second it was hashed could go unnoticed; hashes
+	/// of files modified no earlier than the second they were hashed in are not trusted later, and get redone.
+	class HELIUM_FOUNDATION_API FileHashCache : NonCopyable
+	{
+	public:
+		/// Size of the reads when hashing.
+		static const size_t READ_SIZE = 1024 * 1024;
+
+		explicit FileHashCache( FileHashAlgorithm algorithm = FileHashAlgorithms::XXHash64 );
+
+		/// @name Persistence
+		//@{
+		bool Load( const char* pPath );
+		bool Save( const char* pPath ) const;
+		void Clear();
+		//@}
+
+		/// @name Hashing
+		//@{
+		bool GetHash( const FilePath& path, std::string& rHash );
+		size_t GetHashes( const std::vector< FilePath >& paths, std::vector< std::string >& rHashes, uint32_t threadCount = 0 );
+		//@}
+
+		/// @name Data Access
+		//@{
+		inline FileHashAlgorithm GetAlgorithm() const;
+		inline size_t GetSize() const;
+		inline uint64_t GetHitCount() const;
+		inline uint64_t GetMissCount() const;
+		//@}
+
+	private:
+		/// Cached hash of one file.
+		struct Entry
+		{
+			uint64_t    m_size;
+			uint64_t    m_modifiedTime;
+			uint64_t    m_fileId;
+			uint64_t    m_hashedTime;  ///< Wall clock second the file was read in.
+			std::string m_hash;
+		};
+
+		/// A file being hashed by GetHashes().
+		struct Job
+		{
+			const FilePath* m_pPath;
+			std::string*    m_pHash;
+			Entry           m_entry;
+			bool            m_succeeded;
+			bool            m_hit;
+		};
+
+		struct Worker;
+
+		void Run( DynamicArray< uint8_t >& rBuffer );
+		void Process( Job& rJob, DynamicArray< uint8_t >& rBuffer ) const;
+		void Finish( Job& rJob );
+
+		/// Hash used for new entries.
+		FileHashAlgorithm m_algorithm;
+		/// Entries by path.
+		std::map< std::string, Entry > m_entries;
+
+		/// Files found in the cache.
+		uint64_t m_hitCount;
+		/// Files read.
+		uint64_t m_missCount;
+
+		/// Buffer to read into on the calling thread.
+		DynamicArray< uint8_t > m_buffer;
+
+		/// Files for the workers of GetHashes().
+		Job* m_pJobs;
+		/// Number of files for the workers.
+		int32_t m_jobCount;
+		/// Index after the last file taken by a worker.
+		volatile int32_t m_nextJob;
+	};
+}
+
+#include "Foundation/FileHash.inl"
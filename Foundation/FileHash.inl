@@ -0,0 +1,31 @@
+/// Get the hash used for new entries.
+///
+/// @return  Hash algorithm.
+Helium::FileHashAlgorithm Helium::FileHashCache::GetAlgorithm() const
+{
+	return m_algorithm;
+}
+
+/// Get the number of files in the cache.
+///
+/// @return  Number of entries.
+size_t Helium::FileHashCache::GetSize() const
+{
+	return m_entries.size();
+}
+
+/// Get the number of files whose hash came from the cache, since it was created or cleared.
+///
+/// @return  Number of cache hits.
+uint64_t Helium::FileHashCache::GetHitCount() const
+{
+	return m_hitCount;
+}
+
+/// Get the number of files that had to be read, since the cache was created or cleared.
+///
+/// @return  Number of cache misses.
+uint64_t Helium::FileHashCache::GetMissCount() const
+{
+	return m_missCount;
+}
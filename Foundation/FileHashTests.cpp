@@ -0,0 +1,224 @@
+#include "Precompile.h"
+#include "Foundation/FileHash.h"
+#include "Foundation/MD5.h"
+
+#include "Platform/Console.h"
+#include "Platform/File.h"
+#include "Platform/Runtime.h"
+#include "Platform/Tests.h"
+#include "Platform/Thread.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+using namespace Helium;
+
+// a hash is only trusted once the file is older than the second it was hashed in
+static void WaitForNextSecond()
+{
+	Thread::Sleep( 1100 );
+}
+
+TEST(FileHash, KnownHashes)
+{
+	const char* spam = "Nobody inspects the spammish repetition";
+
+	XXHash64 empty;
+	EXPECT_EQ( 0xEF46DB3751D8E999ULL, empty.Finish() );
+
+	XXHash64 abc;
+	abc.Update( "abc", 3 );
+	EXPECT_EQ( 0x44BC2CF5AD770999ULL, abc.Finish() );
+
+	XXHash64 whole;
+	whole.Update( spam, StringLength( spam ) );
+	EXPECT_EQ( 0xFBCEA83C8A378BF1ULL, whole.Finish() );
+
+	// the same in every size of piece
+	for ( size_t pieceSize = 1; pieceSize < 40; ++pieceSize )
+	{
+		XXHash64 pieces;
+		for ( size_t offset = 0; offset < StringLength( spam ); offset += pieceSize )
+		{
+			pieces.Update( spam + offset, Min( pieceSize, StringLength( spam ) - offset ) );
+		}
+		EXPECT_EQ( whole.Finish(), pieces.Finish() );
+	}
+
+	EXPECT_EQ( std::string( "900150983CD24FB0D6963F7D28E17F72" ), MD5( std::string( "abc" ) ) );
+
+	MD5Hasher md5;
+	md5.Update( "a", 1 );
+	md5.Update( "bc", 2 );
+	EXPECT_EQ( std::string( "900150983CD24FB0D6963F7D28E17F72" ), md5.Finish() );
+
+	// files
+	const char* path = "FoundationFileHashKnown.bin";
+	{
+		File file;
+		ASSERT_TRUE( file.Open( path, FileModes::Write ) );
+		ASSERT_TRUE( file.Write( spam, StringLength( spam ) ) );
+	}
+
+	std::string hash;
+	EXPECT_TRUE( HashFile( path, FileHashAlgorithms::XXHash64, hash ) );
+	EXPECT_EQ( std::string( "FBCEA83C8A378BF1" ), hash );
+	EXPECT_TRUE( HashFile( path, FileHashAlgorithms::MD5, hash ) );
+	EXPECT_EQ( MD5( std::string( spam ) ), hash );
+	EXPECT_EQ( hash, FileMD5( path ) );
+	EXPECT_EQ( hash, FileMD5( path, 7 ) );
+
+	Helium::Delete( path );
+	EXPECT_FALSE( HashFile( path, FileHashAlgorithms::XXHash64, hash ) );
+}
+
+TEST(FileHash, CacheHitsAndMisses)
+{
+	const std::string root ( "FoundationFileHashCache/" );
+	const char* cachePath = "FoundationFileHashCache.bin";
+	ASSERT_TRUE( MakePath( root.c_str() ) );
+
+	std::vector< FilePath > paths;
+	for ( uint32_t i = 0; i < 8; ++i )
+	{
+		char name[ 32 ];
+		StringPrint( name, sizeof( name ), "%u.bin", i );
+		ASSERT_TRUE( MakeTestFile( root + name, 1000 * i + 17, i ) );
+		paths.push_back( FilePath( root + name ) );
+	}
+	paths.push_back( FilePath( root + "missing.bin" ) );
+	WaitForNextSecond();
+
+	// cold, then warm
+	FileHashCache cache;
+	std::vector< std::string > hashes;
+	EXPECT_EQ( 8u, cache.GetHashes( paths, hashes, 3 ) );
+	EXPECT_EQ( 0u, cache.GetHitCount() );
+	EXPECT_EQ( 8u, cache.GetMissCount() );
+	EXPECT_EQ( 8u, cache.GetSize() );
+	EXPECT_TRUE( hashes[ 8 ].empty() );
+	for ( uint32_t i = 0; i < 8; ++i )
+	{
+		std::string hash;
+		EXPECT_TRUE( HashFile( paths[ i ].Data(), FileHashAlgorithms::XXHash64, hash ) );
+		EXPECT_EQ( hash, hashes[ i ] );
+	}
+
+	std::vector< std::string > warmHashes;
+	EXPECT_EQ( 8u, cache.GetHashes( paths, warmHashes, 3 ) );
+	EXPECT_EQ( 8u, cache.GetHitCount() );
+	EXPECT_TRUE( warmHashes == hashes );
+
+	// a changed file is read again, even in the same second
+	ASSERT_TRUE( MakeTestFile( paths[ 3 ].Get(), 50, 99 ) );
+	std::string hash;
+	EXPECT_TRUE( cache.GetHash( paths[ 3 ], hash ) );
+	EXPECT_NE( hashes[ 3 ], hash );
+	EXPECT_EQ( 9u, cache.GetMissCount() );
+	EXPECT_TRUE( cache.GetHash( paths[ 3 ], hash ) );
+	EXPECT_EQ( 10u, cache.GetMissCount() );  // changed in the second it was hashed in, so not trusted yet
+	hashes[ 3 ] = hash;
+
+	// saved and loaded
+	ASSERT_TRUE( cache.Save( cachePath ) );
+	FileHashCache loaded;
+	ASSERT_TRUE( loaded.Load( cachePath ) );
+	EXPECT_EQ( cache.GetSize(), loaded.GetSize() );
+	EXPECT_EQ( 8u, loaded.GetHashes( paths, warmHashes, 1 ) );
+	EXPECT_EQ( 7u, loaded.GetHitCount() );
+	EXPECT_EQ( 1u, loaded.GetMissCount() );
+	EXPECT_TRUE( warmHashes == hashes );
+
+	// another hash doesn't take the file
+	FileHashCache md5Cache ( FileHashAlgorithms::MD5 );
+	EXPECT_FALSE( md5Cache.Load( cachePath ) );
+	EXPECT_EQ( 0u, md5Cache.GetSize() );
+	EXPECT_TRUE( md5Cache.GetHash( paths[ 1 ], hash ) );
+	EXPECT_EQ( FileMD5( paths[ 1 ].Get() ), hash );
+
+	// deleted files are forgotten
+	Helium::Delete( paths[ 0 ].Data() );
+	EXPECT_FALSE( cache.GetHash( paths[ 0 ], hash ) );
+	EXPECT_EQ( 7u, cache.GetSize() );
+
+	for ( size_t i = 1; i < 8; ++i )
+	{
+		Helium::Delete( paths[ i ].Data() );
+	}
+	Helium::Delete( cachePath );
+	RemoveTestDirectory( root );
+}
+
+TEST(FileHash, RescanBenchmark)
+{
+	// 64 directories of 64 files of 32KB
+	const std::string root ( "FoundationFileHashBenchmark/" );
+	const char* cachePath = "FoundationFileHashBenchmark.bin";
+	const uint32_t directoryCount = 64;
+	const uint32_t fileCount = 64;
+	const size_t fileSize = 32 * 1024;
+
+	std::vector< FilePath > paths;
+	char name[ 64 ];
+	for ( uint32_t i = 0; i < directoryCount; ++i )
+	{
+		StringPrint( name, sizeof( name ), "%u/", i );
+		ASSERT_TRUE( MakePath( ( root + name ).c_str() ) );
+		for ( uint32_t j = 0; j < fileCount; ++j )
+		{
+			StringPrint( name, sizeof( name ), "%u/%u.bin", i, j );
+			ASSERT_TRUE( MakeTestFile( root + name, fileSize, i * fileCount + j ) );
+			paths.push_back( FilePath( root + name ) );
+		}
+	}
+	WaitForNextSecond();
+
+	// FileMD5 a file at a time, as before
+	SimpleTimer timer;
+	for ( size_t i = 0; i < paths.size(); ++i )
+	{
+		FileMD5( paths[ i ].Get() );
+	}
+	float64_t fileMD5Millis = timer.Elapsed();
+
+	float64_t coldMillis[ 2 ];
+	float64_t warmMillis = 0.0;
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		FileHashCache cache ( pass == 0 ? FileHashAlgorithms::MD5 : FileHashAlgorithms::XXHash64 );
+		std::vector< std::string > hashes;
+
+		timer.Reset();
+		EXPECT_EQ( paths.size(), cache.GetHashes( paths, hashes ) );
+		coldMillis[ pass ] = timer.Elapsed();
+
+		if ( pass == 1 )
+		{
+			// warm, from a cache saved by an earlier run
+			ASSERT_TRUE( cache.Save( cachePath ) );
+
+			timer.Reset();
+			FileHashCache warmCache;
+			ASSERT_TRUE( warmCache.Load( cachePath ) );
+			EXPECT_EQ( paths.size(), warmCache.GetHashes( paths, hashes ) );
+			warmMillis = timer.Elapsed();
+			EXPECT_EQ( paths.size(), warmCache.GetHitCount() );
+		}
+	}
+
+	for ( size_t i = 0; i < paths.size(); ++i )
+	{
+		Helium::Delete( paths[ i ].Data() );
+	}
+	for ( uint32_t i = 0; i < directoryCount; ++i )
+	{
+		StringPrint( name, sizeof( name ), "%u/", i );
+		RemoveTestDirectory( root + name );
+	}
+	RemoveTestDirectory( root );
+	Helium::Delete( cachePath );
+
+	const float64_t megabytes = paths.size() * fileSize / ( 1024.0 * 1024.0 );
+	Helium::Print( "FileHashCache: %" PRIuSZ " files, %.0f ms FileMD5, %.0f ms cold MD5, %.0f ms cold xxHash (%.0f MB/s), %.0f ms warm on %u threads\n",
+		paths.size(), fileMD5Millis, coldMillis[ 0 ], coldMillis[ 1 ], megabytes / ( coldMillis[ 1 ] / 1000.0 ), warmMillis, Helium::Platform::GetProcessorCount() );
+}
@@ -3,6 +3,7 @@
 
 #include "Platform/Assert.h"
 #include "Platform/Console.h"
+#include "Platform/Futex.h"
 
 #include "Foundation/String.h"
 
@@ -33,11 +34,16 @@ Message::~Message()
 }
 
 MessageQueue::MessageQueue()
-	: m_Head (0)
-	, m_Tail (0)
+	: m_Head (&m_Stub)
+	, m_Tail (&m_Stub)
+	, m_Stub (0, 0, 0)
 	, m_Count (0)
 	, m_Total (0)
 	, m_MaxLength (0)
+	, m_Pending (0)
+	, m_Waiters (0)
+	, m_Wake (0)
+	, m_Clears (0)
 {
 
 }
@@ -47,121 +53,191 @@ MessageQueue::~MessageQueue()
 	Clear();
 }
 
-void MessageQueue::Add(Message* msg)
+void MessageQueue::Push(Message* msg)
 {
-	HELIUM_IPC_SCOPE_TIMER("");
-	bool shouldIncrement = true;
+	msg->m_Next = 0;
 
-	if ( msg )
+	// swing the head to the new message, after this it is visible to the consumer once its predecessor links to it
+	Message* prev = AtomicExchange( m_Head, msg );
+
+	// old end message points to us
+	AtomicExchangeRelease( prev->m_Next, msg );
+}
+
+Message* MessageQueue::Pop()
+{
+	// caller must hold m_Consumer
+	for (;;)
 	{
-		Helium::MutexScopeLock mutex (m_Mutex);
+		Message* tail = m_Tail;
+		Message* next = tail->m_Next;
 
-		if (m_Tail == 0)
+		if (tail == &m_Stub)
 		{
-			// header must also be zero and count must be zero
-			if (m_Count != 0)
-			{
-				HELIUM_BREAK();
-			}
-			if (m_Head != 0)
+			if (next == 0)
 			{
-				HELIUM_BREAK();
+				// truly empty unless a producer is between its exchange and its link
+				if (m_Head == &m_Stub)
+				{
+					return 0;
+				}
+
+				Helium::Thread::Yield();
+				continue;
 			}
 
-			msg->m_Next = 0;
-			m_Head = msg;
-			m_Tail = msg;
+			// skip over the stub
+			m_Tail = next;
+			tail = next;
+			next = next->m_Next;
 		}
-		else
-		{
-			Message* end = m_Tail;
-
-			// tail points to new message
-			m_Tail = msg;
 
-			// old end message points to us
-			end->m_Next = msg;
+		if (next)
+		{
+			m_Tail = next;
+			return tail;
+		}
 
-			// we point to null
-			msg->m_Next = 0;
+		if (tail != m_Head)
+		{
+			// a producer has swapped the head but not linked it in yet, it will be done momentarily
+			Helium::Thread::Yield();
+			continue;
 		}
 
-		m_Count++;
-		m_Total++;
-		msg->SetNumber( m_Total );
+		// tail is the last message, put the stub behind it so we can unlink it
+		Push(&m_Stub);
 
-		// if we're over our limit now, then remove the oldest message.
-		if (m_MaxLength > 0 && m_Count > m_MaxLength)
+		next = tail->m_Next;
+		if (next)
 		{
-			m_Count--;
-			shouldIncrement = false;
+			m_Tail = next;
+			return tail;
+		}
 
-			// take the head of the queue
-			Message* trash = m_Head;
+		Helium::Thread::Yield();
+	}
+}
 
-			// move the the head dow
-			m_Head = m_Head->m_Next;
+bool MessageQueue::TakePending()
+{
+	for (;;)
+	{
+		int32_t pending = m_Pending;
+		if (pending <= 0)
+		{
+			return false;
+		}
 
-			delete trash;
+		if (AtomicCompareExchangeAcquire( m_Pending, pending - 1, pending ) == pending)
+		{
+			return true;
 		}
 	}
+}
 
-	if (shouldIncrement)
+void MessageQueue::Park(int32_t clears)
+{
+	int32_t wake = m_Wake;
+
+	// advertise that we are about to sleep, then re-check so we can't miss a Signal() that raced with us
+	AtomicIncrement( m_Waiters );
+	if (m_Pending <= 0 && m_Clears == clears)
 	{
-		m_Append.Increment();
+		FutexWait( m_Wake, wake );
 	}
+	AtomicDecrement( m_Waiters );
 }
 
-Message* MessageQueue::Remove()
+void MessageQueue::Signal()
 {
-	HELIUM_IPC_SCOPE_TIMER("");
+	AtomicIncrement( m_Pending );
 
-	m_Append.Decrement();
+	// only pay for the system call if someone is actually asleep
+	if (m_Waiters)
+	{
+		AtomicIncrement( m_Wake );
+		FutexWakeAll( m_Wake );
+	}
+}
 
-	Helium::MutexScopeLock mutex (m_Mutex);
+void MessageQueue::Add(Message* msg)
+{
+	HELIUM_IPC_SCOPE_TIMER("");
 
-	Message* result = 0;
-	if (m_Head != 0)
+	if ( msg )
 	{
-		m_Count--;
+		msg->SetNumber( AtomicIncrement( m_Total ) );
 
-		// take the head of the queue
-		result = m_Head;
+		Push( msg );
 
-		// move the the head dow
-		m_Head = m_Head->m_Next;
+		uint32_t count = AtomicIncrement( m_Count );
 
-		// if the head points to null, set the tail to null because we have popped the last entry
-		if (m_Head == 0)
+		// if we're over our limit now, then remove the oldest message.  if the consumer is busy it will drain the
+		//  queue for us, so the length may briefly exceed the limit by the number of concurrent producers
+		if (m_MaxLength > 0 && count > m_MaxLength && m_Consumer.TryLock())
 		{
-			m_Tail = 0;
+			Message* trash = Pop();
+			if (trash)
+			{
+				AtomicDecrement( m_Count );
+			}
+
+			m_Consumer.Unlock();
+
+			if (trash)
+			{
+				// the pending wakeup for the discarded message now accounts for this one
+				delete trash;
+				return;
+			}
 		}
 	}
 
-	return result;
+	Signal();
 }
 
-void MessageQueue::Clear()
+Message* MessageQueue::Remove()
 {
 	HELIUM_IPC_SCOPE_TIMER("");
 
-	Helium::MutexScopeLock mutex (m_Mutex);
+	while (!TakePending())
+	{
+		Park( m_Clears );
+	}
 
-	Message* msg = m_Head;
-	while (msg)
+	Helium::ScopeSpinLock lock (m_Consumer);
+
+	Message* result = Pop();
+	if (result)
 	{
-		Message* next = msg->m_Next;
-		delete msg;
-		msg = next;
+		AtomicDecrement( m_Count );
 	}
 
-	m_Head = 0;
-	m_Tail = 0;
-	m_Count = 0;
-	m_Total = 0;
+	return result;
+}
+
+void MessageQueue::Clear()
+{
+	HELIUM_IPC_SCOPE_TIMER("");
+
+	{
+		Helium::ScopeSpinLock lock (m_Consumer);
+
+		while (Message* msg = Pop())
+		{
+			delete msg;
+		}
+
+		AtomicExchange( m_Count, 0 );
+		AtomicExchange( m_Total, 0 );
+		AtomicExchange( m_Pending, 0 );
+	}
 
-	m_Append.Increment();
-	m_Append.Reset();
+	// release anyone in Wait()
+	AtomicIncrement( m_Clears );
+	AtomicIncrement( m_Wake );
+	FutexWakeAll( m_Wake );
 }
 
 uint32_t MessageQueue::Count()
@@ -176,14 +252,11 @@ uint32_t MessageQueue::Total()
 
 void MessageQueue::Wait()
 {
-	// this will send the calling thread to sleep, and when it returns the semaphore value will be decremented for *this* thread
-	m_Append.Decrement();
-
-	// this will be zero if the queue was reset by another thread
-	if ( m_Total )
+	// this will send the calling thread to sleep until there is something to remove, or the queue was cleared by another thread
+	int32_t clears = m_Clears;
+	while (m_Pending <= 0 && m_Clears == clears)
 	{
-		// do an increment to preserve the semaphore's value over the call to this function
-		m_Append.Increment();
+		Park( clears );
 	}
 }
 
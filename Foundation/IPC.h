@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Platform/Atomic.h"
 #include "Platform/Condition.h"
 #include "Platform/Locks.h"
 #include "Platform/Runtime.h"
@@ -61,7 +62,7 @@ namespace Helium
 			friend class MessageQueue;
 
 		private:
-			Message*	m_Next;
+			Message* volatile m_Next;
 			uint32_t	m_Number;
 			uint8_t*	m_Data;
 
@@ -114,17 +115,35 @@ namespace Helium
 			}
 		};
 
+		//
+		// Multi-producer, single-consumer message queue
+		//  Producers link messages in with a single atomic exchange and never block; the consumer only parks
+		//  (via a futex) when there is nothing to remove.  Consumers are serialized by a spin lock that is only
+		//  contended when a producer is trimming the queue to its maximum length.
+		//
+
 		class HELIUM_FOUNDATION_API MessageQueue
 		{
 		private:
-			Message* m_Head;            // pointer to head message 
-			Message* m_Tail;            // pointer to tail message 
-			uint32_t m_Count;           // number of messages in queue
-			uint32_t m_Total;           // number of messages that have passed through the queue since clear
+			Message* volatile m_Head;   // most recently added message, swapped in by producers
+			Message* m_Tail;            // oldest message, only touched while holding m_Consumer
+			Message m_Stub;             // sentinel node so the queue is never truly unlinked
+			int32_t volatile m_Count;   // number of messages in queue
+			int32_t volatile m_Total;   // number of messages that have passed through the queue since clear
 			uint32_t m_MaxLength;       // max allowable number of messages in queue.  A value of zero means unlimited
 
-			Helium::Mutex m_Mutex;      // mutex to control access to the queue
-			Helium::Semaphore m_Append; // semaphore that increments on add, decrements on remove
+			int32_t volatile m_Pending; // number of outstanding Remove() wakeups (messages and NULL adds)
+			int32_t volatile m_Waiters; // number of threads parked in Remove() or Wait()
+			int32_t volatile m_Wake;    // futex word, bumped whenever parked threads need to re-check the queue
+			int32_t volatile m_Clears;  // number of times the queue has been cleared, used to release Wait()
+
+			Helium::SpinLock m_Consumer; // serializes unlinking from the tail end of the queue
+
+			void Push(Message* msg);
+			Message* Pop();
+			bool TakePending();
+			void Park(int32_t wake);
+			void Signal();
 
 		public:
 			MessageQueue();
@@ -0,0 +1,148 @@
+#include "Precompile.h"
+#include "Foundation/IPC.h"
+
+#include "Platform/Console.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+using namespace Helium;
+using namespace Helium::IPC;
+
+// Connection is the only thing allowed to create messages, so wrap a queue in an inert one
+class QueueTestConnection : public Connection
+{
+public:
+	QueueTestConnection()
+	{
+		m_NextTransaction = 1;
+	}
+
+	MessageQueue& GetQueue()
+	{
+		return m_ReadQueue;
+	}
+
+	virtual void Close() override {}
+	virtual bool ReadMessage(Message**) override { return false; }
+	virtual bool WriteMessage(Message*) override { return false; }
+	virtual bool Read(void*, uint32_t) override { return false; }
+	virtual bool Write(void*, uint32_t) override { return false; }
+};
+
+struct QueueProducer
+{
+	QueueTestConnection* m_Connection;
+	uint32_t             m_ID;
+	uint32_t             m_Count;
+
+	void Run()
+	{
+		for ( uint32_t i = 0; i < m_Count; ++i )
+		{
+			Message* msg = m_Connection->CreateMessage( m_ID, 0, static_cast< int32_t >( i + 1 ) );
+			m_Connection->GetQueue().Add( msg );
+		}
+	}
+};
+
+static void RunProducers( QueueTestConnection& connection, uint32_t producerCount, uint32_t messagesPerProducer, uint32_t* received )
+{
+	QueueProducer producers[ 32 ];
+	CallbackThread threads[ 32 ];
+	HELIUM_ASSERT( producerCount <= 32 );
+
+	for ( uint32_t i = 0; i < producerCount; ++i )
+	{
+		producers[ i ].m_Connection = &connection;
+		producers[ i ].m_ID = i;
+		producers[ i ].m_Count = messagesPerProducer;
+		threads[ i ].Create( &CallbackThread::EntryHelper< QueueProducer, &QueueProducer::Run >, &producers[ i ], "Queue Producer" );
+	}
+
+	int32_t last[ 32 ] = { 0 };
+	uint32_t total = producerCount * messagesPerProducer;
+	for ( uint32_t i = 0; i < total; ++i )
+	{
+		Message* msg = connection.GetQueue().Remove();
+		ASSERT_TRUE( msg != NULL );
+
+		// each producer's messages must come out in the order they went in
+		EXPECT_EQ( last[ msg->GetID() ] + 1, msg->GetTransaction() );
+		last[ msg->GetID() ] = msg->GetTransaction();
+		++received[ msg->GetID() ];
+		delete msg;
+	}
+
+	for ( uint32_t i = 0; i < producerCount; ++i )
+	{
+		threads[ i ].Join();
+	}
+}
+
+TEST(IPCMessageQueue, ProducerOrdering)
+{
+	QueueTestConnection connection;
+	uint32_t received[ 32 ] = { 0 };
+
+	RunProducers( connection, 4, 10000, received );
+
+	for ( uint32_t i = 0; i < 4; ++i )
+	{
+		EXPECT_EQ( 10000u, received[ i ] );
+	}
+	EXPECT_EQ( 0u, connection.GetQueue().Count() );
+	EXPECT_EQ( 40000u, connection.GetQueue().Total() );
+}
+
+TEST(IPCMessageQueue, MaxLengthDropsOldest)
+{
+	QueueTestConnection connection;
+	MessageQueue& queue = connection.GetQueue();
+	queue.SetMaxLength( 4 );
+
+	for ( uint32_t i = 0; i < 10; ++i )
+	{
+		queue.Add( connection.CreateMessage( 0, 0, static_cast< int32_t >( i + 1 ) ) );
+	}
+
+	EXPECT_EQ( 4u, queue.Count() );
+	EXPECT_EQ( 10u, queue.Total() );
+
+	for ( int32_t i = 7; i <= 10; ++i )
+	{
+		Message* msg = queue.Remove();
+		ASSERT_TRUE( msg != NULL );
+		EXPECT_EQ( i, msg->GetTransaction() );
+		delete msg;
+	}
+}
+
+TEST(IPCMessageQueue, NullWakesConsumer)
+{
+	QueueTestConnection connection;
+	MessageQueue& queue = connection.GetQueue();
+
+	queue.Add( NULL );
+	queue.Wait();
+	EXPECT_TRUE( queue.Remove() == NULL );
+	EXPECT_EQ( 0u, queue.Count() );
+}
+
+TEST(IPCMessageQueue, ThroughputBenchmark)
+{
+	const uint32_t messageCount = 400000;
+
+	for ( uint32_t producerCount = 1; producerCount <= 8; producerCount *= 2 )
+	{
+		QueueTestConnection connection;
+		uint32_t received[ 32 ] = { 0 };
+
+		SimpleTimer timer;
+		RunProducers( connection, producerCount, messageCount / producerCount, received );
+		float64_t millis = timer.Elapsed();
+
+		Helium::Print( "MessageQueue: %u producer(s), %u messages in %.1f ms (%.0f messages/s)\n",
+			producerCount, messageCount, millis, millis > 0.0 ? messageCount / ( millis / 1000.0 ) : 0.0 );
+	}
+}
@@ -2,12 +2,16 @@
 #include "Log.h"
 
 #include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Futex.h"
 #include "Platform/Locks.h"
 #include "Platform/Thread.h"
 #include "Platform/File.h"
 #include "Platform/Console.h"
 #include "Platform/Encoding.h"
+#include "Platform/Timer.h"
 
+#include "Foundation/BinaryLog.h"
 #include "Foundation/String.h"
 
 #include <stdio.h>
@@ -109,6 +113,19 @@ struct OutputFile
 typedef std::map< std::string, OutputFile > M_OutputFile;
 static M_OutputFile g_TraceFiles;
 
+static uint32_t g_TraceStreams = 0; // union of the streams of all trace files
+
+struct BinaryLogFile
+{
+	BinaryLogWriter* m_Writer;
+	Stream           m_StreamType;
+	int              m_RefCount;
+};
+
+typedef std::map< std::string, BinaryLogFile > M_BinaryLogFile;
+static M_BinaryLogFile g_BinaryLogs;
+
+static uint32_t g_BinaryStreams = 0; // union of the streams of all binary log files
 static uint32_t g_Streams = Streams::Normal | Streams::Warning | Streams::Error;
 static Level g_Level = Levels::Default;
 static int g_Indent = 0;
@@ -171,7 +188,7 @@ void Log::RemoveListener(const ListenerSignature::Delegate& listener)
 	g_LogEvent.Remove(listener);
 }
 
-void Redirect(const std::string& fileName, const char* str, bool stampNewLine = true )
+void Redirect(const std::string& fileName, const char* str, bool stampNewLine = true, ThreadId threadId = Thread::GetCurrentId(), bool flush = true )
 {
 	File* f = g_FileManager.Find(fileName);
 	if (f)
@@ -196,7 +213,7 @@ void Redirect(const std::string& fileName, const char* str, bool stampNewLine =
 			time += currentTime.dstflag ? 1 : 0;
 			uint32_t hour = time % 24;
 
-			length = StringPrint( temp, count, "[%02d:%02d:%02d.%03d TID:%d] %s", hour, min, sec, milli, Thread::GetCurrentId(), str );
+			length = StringPrint( temp, count, "[%02d:%02d:%02d.%03d TID:%d] %s", hour, min, sec, milli, threadId, str );
 		}
 		else
 		{
@@ -204,10 +221,28 @@ void Redirect(const std::string& fileName, const char* str, bool stampNewLine =
 		}
 
 		f->Write( temp, length );
-		f->Flush();
+
+		if ( flush )
+		{
+			f->Flush();
+		}
 	}
 }
 
+static void UpdateTraceStreams( const M_OutputFile& files )
+{
+	uint32_t streams = 0;
+
+	M_OutputFile::const_iterator itr = files.begin();
+	M_OutputFile::const_iterator end = files.end();
+	for( ; itr != end; ++itr )
+	{
+		streams |= (*itr).second.m_StreamType;
+	}
+
+	g_TraceStreams = streams;
+}
+
 bool AddFile( M_OutputFile& files, const std::string& fileName, Stream stream, ThreadId threadId, bool append )
 {
 	Helium::MutexScopeLock mutex (g_Mutex);
@@ -245,6 +280,7 @@ bool AddFile( M_OutputFile& files, const std::string& fileName, Stream stream, T
 				info.m_RefCount = 1;
 				info.m_ThreadId = threadId;
 				files[ fileName ] = info;
+				UpdateTraceStreams( files );
 				return true;
 			}
 			else
@@ -271,6 +307,7 @@ void RemoveFile( M_OutputFile& files, const std::string& fileName )
 		{
 			g_FileManager.Close( fileName );
 			files.erase( found );
+			UpdateTraceStreams( files );
 		}
 	}
 }
@@ -285,6 +322,76 @@ void Log::RemoveTraceFile( const std::string& fileName )
 	RemoveFile( g_TraceFiles, fileName );
 }
 
+static void UpdateBinaryStreams()
+{
+	uint32_t streams = 0;
+
+	M_BinaryLogFile::const_iterator itr = g_BinaryLogs.begin();
+	M_BinaryLogFile::const_iterator end = g_BinaryLogs.end();
+	for( ; itr != end; ++itr )
+	{
+		streams |= (*itr).second.m_StreamType;
+	}
+
+	g_BinaryStreams = streams;
+}
+
+bool Log::AddBinaryLogFile( const std::string& fileName, Stream stream )
+{
+	Helium::MutexScopeLock mutex (g_Mutex);
+
+	M_BinaryLogFile::iterator found = g_BinaryLogs.find( fileName );
+	if ( found != g_BinaryLogs.end() )
+	{
+		if ( found->second.m_StreamType != stream )
+		{
+			HELIUM_BREAK(); // trying to add the same file, but with a different stream type
+		}
+
+		found->second.m_RefCount++; // another reference
+		return true;
+	}
+
+	if ( fileName.empty() )
+	{
+		return false;
+	}
+
+	BinaryLogWriter* writer = new BinaryLogWriter;
+	if ( !writer->Open( fileName.c_str() ) )
+	{
+		delete writer;
+		return false;
+	}
+
+	BinaryLogFile info;
+	info.m_Writer = writer;
+	info.m_StreamType = stream;
+	info.m_RefCount = 1;
+	g_BinaryLogs[ fileName ] = info;
+	UpdateBinaryStreams();
+	return true;
+}
+
+void Log::RemoveBinaryLogFile( const std::string& fileName )
+{
+	Helium::MutexScopeLock mutex (g_Mutex);
+
+	M_BinaryLogFile::iterator found = g_BinaryLogs.find( fileName );
+	if ( found != g_BinaryLogs.end() )
+	{
+		found->second.m_RefCount--;
+
+		if ( found->second.m_RefCount == 0 )
+		{
+			// statements still queued for this file are lost, Flush() first to keep them
+			delete found->second.m_Writer;
+			g_BinaryLogs.erase( found );
+			UpdateBinaryStreams();
+		}
+	}
+}
+
 void Log::Indent(int col)
 {
 	if ( Thread::IsMain() )
@@ -332,6 +439,11 @@ void Log::EnableStream( Stream stream, bool enable )
 	}
 }
 
+bool Log::WouldPrint( Stream stream, Level level )
+{
+	return ( ( g_Streams & stream ) == stream && level <= g_Level ) || ( g_TraceStreams & stream ) == stream;
+}
+
 ConsoleColor Log::GetStreamColor( Log::Stream stream )
 {
 	switch (stream)
@@ -369,10 +481,12 @@ void Log::UnlockMutex()
 	g_Mutex.Unlock();
 }
 
-void Log::PrintString(const char* string, Stream stream, Level level, ConsoleColor color, int indent, char* output, uint32_t outputSize)
-{
-	Helium::MutexScopeLock mutex (g_Mutex);
+// whether the next trace file output starts a new line (and should be time stamped)
+static bool g_StampNewLine = true;
 
+// deliver a statement to listeners, the console and trace files, g_Mutex must be held
+static void WriteStatement(const char* string, Stream stream, Level level, ConsoleColor color, int indent, ThreadId threadId, char* output, uint32_t outputSize, bool flush)
+{
 	// check trace files
 	bool trace = false;
 	M_OutputFile::iterator itr = g_TraceFiles.begin();
@@ -380,7 +494,7 @@ void Log::PrintString(const char* string, Stream stream, Level level, ConsoleCol
 	for( ; itr != end; ++itr )
 	{
 		if ( ( (*itr).second.m_StreamType & stream ) == stream
-			&& ( (*itr).second.m_ThreadId == ThreadId () || (*itr).second.m_ThreadId == Thread::GetCurrentId() ) )
+			&& ( (*itr).second.m_ThreadId == ThreadId () || (*itr).second.m_ThreadId == threadId ) )
 		{
 			trace = true;
 		}
@@ -398,7 +512,7 @@ void Log::PrintString(const char* string, Stream stream, Level level, ConsoleCol
 		}
 
 		// the statement
-		Statement statement ( string, stream, level, indent );
+		Statement statement ( string, stream, level, indent, threadId );
 
 		// construct the print statement
 		ListenerArgs args ( statement );
@@ -436,23 +550,21 @@ void Log::PrintString(const char* string, Stream stream, Level level, ConsoleCol
 			OutputDebugStringW( convertedStatement );
 #endif
 			// output to trace file(s)
-			static bool stampNewLine = true;
-
 			itr = g_TraceFiles.begin();
 			end = g_TraceFiles.end();
 			for( ; itr != end; ++itr )
 			{
 				if ( ( (*itr).second.m_StreamType & stream ) == stream
-					&& ( (*itr).second.m_ThreadId == ThreadId () || (*itr).second.m_ThreadId == Thread::GetCurrentId() ) )
+					&& ( (*itr).second.m_ThreadId == ThreadId () || (*itr).second.m_ThreadId == threadId ) )
 				{
-					Redirect( (*itr).first, statement.m_String.c_str(), stampNewLine );
+					Redirect( (*itr).first, statement.m_String.c_str(), g_StampNewLine, threadId, flush );
 				}
 			}
 
 			// update stampNewLine
 			if ( !statement.m_String.empty() )
 			{
-				stampNewLine = ( *statement.m_String.rbegin() == '\n' ) ? true : false ;
+				g_StampNewLine = ( *statement.m_String.rbegin() == '\n' ) ? true : false ;
 			}
 
 			// output to buffer
@@ -464,6 +576,491 @@ void Log::PrintString(const char* string, Stream stream, Level level, ConsoleCol
 	}
 }
 
+// deliver a deferred statement to binary logs, and render it for anything that wants text, g_Mutex must be held
+static void WriteBinaryStatement(const BinaryLogStatement& statement, const uint8_t* arguments, int indent, ThreadId threadId, bool flush)
+{
+	Stream stream = statement.m_Stream;
+
+	M_BinaryLogFile::iterator itr = g_BinaryLogs.begin();
+	M_BinaryLogFile::iterator end = g_BinaryLogs.end();
+	for( ; itr != end; ++itr )
+	{
+		if ( ( (*itr).second.m_StreamType & stream ) == stream )
+		{
+			(*itr).second.m_Writer->Write( statement, arguments );
+		}
+	}
+
+	// listeners, the console and text trace files get the rendered string
+	Level level = static_cast< Level >( statement.m_Level );
+	if ( ( ( g_Streams & stream ) == stream && level <= g_Level ) || ( g_TraceStreams & stream ) == stream )
+	{
+		const char* format = GetInternedFormat( statement.m_FormatId );
+		if ( format )
+		{
+			char string[ MAX_PRINT_SIZE ];
+			RenderArguments( format, arguments, statement.m_ArgumentSize, string, MAX_PRINT_SIZE );
+			WriteStatement( string, stream, level, ConsoleColors::None, indent, threadId, NULL, 0, flush );
+		}
+	}
+}
+
+static void FlushBinaryLogs()
+{
+	M_BinaryLogFile::iterator itr = g_BinaryLogs.begin();
+	M_BinaryLogFile::iterator end = g_BinaryLogs.end();
+	for( ; itr != end; ++itr )
+	{
+		(*itr).second.m_Writer->Flush();
+	}
+}
+
+//
+// Asynchronous backend
+//  Each printing thread owns a single-producer ring of variable length records. The writer thread (or any
+//  thread calling Flush) drains the rings while holding g_Mutex, so records are consumed by one thread at a time.
+//  When a thread exits its ring is retired, and freed by the next drain that empties it.
+//
+
+namespace AsyncRecordKinds
+{
+	enum AsyncRecordKind
+	{
+		Padding,    // unused space at the end of the ring, skip to the start
+		Text,       // a formatted statement follows the header
+		Binary,     // an AsyncBinaryPayload and its encoded arguments follow the header
+	};
+}
+typedef AsyncRecordKinds::AsyncRecordKind AsyncRecordKind;
+
+struct AsyncRecord
+{
+	uint32_t     m_Size;       // size of the record including this header, always a multiple of 8
+	uint32_t     m_Kind;       // AsyncRecordKind, padding records only have valid m_Size and m_Kind
+	Stream       m_Stream;
+	Level        m_Level;
+	ConsoleColor m_Color;
+	int32_t      m_Indent;
+	ThreadId     m_ThreadId;
+};
+
+struct AsyncRing
+{
+	AsyncRing*       m_Next;             // next ring in g_AsyncRings, only changed while holding g_Mutex (except by pushes)
+	uint8_t*         m_Buffer;
+	uint32_t         m_Mask;             // capacity - 1
+	int32_t volatile m_Write;            // only advanced by the owning thread
+	int32_t volatile m_Read;             // only advanced while holding g_Mutex
+	int32_t volatile m_Dropped;          // number of records discarded because the ring was full
+	int32_t          m_DroppedReported;  // value of m_Dropped last time we printed a notice about it
+	int32_t volatile m_Retired;          // set when the owning thread exits, after its last record
+};
+
+struct AsyncBinaryPayload
+{
+	uint64_t m_Timestamp;
+	uint32_t m_FormatId;
+	uint32_t m_ArgumentSize;
+};
+
+static void HELIUM_THREAD_LOCAL_DESTRUCTOR RetireAsyncRing( void* ring );
+
+static AsyncRing* volatile     g_AsyncRings = NULL;
+static ThreadLocal< AsyncRing > g_AsyncRing ( &RetireAsyncRing );
+static int32_t volatile        g_AsyncRingCount = 0;
+static uint32_t                g_AsyncRetiredDropped = 0;  // m_Dropped of the freed rings, only changed while holding g_Mutex
+static uint32_t                g_AsyncRingSize = 64 * 1024;
+static int32_t volatile        g_AsyncEnabled = 0;
+static int32_t volatile        g_AsyncRunning = 0;
+static int32_t volatile        g_AsyncSleeping = 0;
+static int32_t volatile        g_AsyncWake = 0;
+static Helium::CallbackThread  g_AsyncThread;
+
+static AsyncRing* GetAsyncRing()
+{
+	AsyncRing* ring = g_AsyncRing.GetPointer();
+	if ( !ring )
+	{
+		uint32_t capacity = 1024;
+		while ( capacity < g_AsyncRingSize )
+		{
+			capacity <<= 1;
+		}
+
+		ring = new AsyncRing;
+		ring->m_Buffer = new uint8_t[ capacity ];
+		ring->m_Mask = capacity - 1;
+		ring->m_Write = 0;
+		ring->m_Read = 0;
+		ring->m_Dropped = 0;
+		ring->m_DroppedReported = 0;
+		ring->m_Retired = 0;
+		AtomicIncrement( g_AsyncRingCount );
+
+		// publish to the writer
+		AsyncRing* head;
+		do
+		{
+			head = g_AsyncRings;
+			ring->m_Next = head;
+		}
+		while ( AtomicCompareExchange( g_AsyncRings, ring, head ) != head );
+
+		g_AsyncRing.SetPointer( ring );
+	}
+
+	return ring;
+}
+
+// called on the exit of a thread that printed, its ring stays until everything in it is written
+static void HELIUM_THREAD_LOCAL_DESTRUCTOR RetireAsyncRing( void* ring )
+{
+	AtomicExchange( static_cast< AsyncRing* >( ring )->m_Retired, 1 );
+}
+
+// unlink and free a retired ring that has been drained, g_Mutex must be held
+static void FreeAsyncRing( AsyncRing* ring )
+{
+	// pushes only ever change the head, so a ring further down can't move under us
+	if ( AtomicCompareExchange( g_AsyncRings, ring->m_Next, ring ) != ring )
+	{
+		AsyncRing* previous = g_AsyncRings;
+		while ( previous->m_Next != ring )
+		{
+			previous = previous->m_Next;
+		}
+		previous->m_Next = ring->m_Next;
+	}
+
+	g_AsyncRetiredDropped += ring->m_Dropped;
+	AtomicDecrement( g_AsyncRingCount );
+
+	delete [] ring->m_Buffer;
+	delete ring;
+}
+
+static void WakeAsyncWriter()
+{
+	// only pay for the system call if the writer is actually asleep
+	if ( g_AsyncSleeping )
+	{
+		AtomicIncrement( g_AsyncWake );
+		FutexWake( g_AsyncWake );
+	}
+}
+
+// reserve a record with payloadSize bytes following the header, returns NULL (counting a drop) if the ring is full
+static AsyncRecord* ReserveAsyncRecord(AsyncRing* ring, uint32_t payloadSize, uint32_t& next)
+{
+	uint32_t capacity = ring->m_Mask + 1;
+	uint32_t size = static_cast< uint32_t >( ( sizeof( AsyncRecord ) + payloadSize + 7 ) & ~7 );
+	uint32_t write = static_cast< uint32_t >( ring->m_Write );
+	uint32_t read = static_cast< uint32_t >( ring->m_Read );
+	uint32_t offset = write & ring->m_Mask;
+	uint32_t padding = ( capacity - offset < size ) ? capacity - offset : 0;
+
+	// records may not take more than half the ring
+	if ( size > capacity / 2 || ( write - read ) + padding + size > capacity )
+	{
+		AtomicIncrement( ring->m_Dropped );
+		return NULL;
+	}
+
+	if ( padding )
+	{
+		AsyncRecord* pad = reinterpret_cast< AsyncRecord* >( ring->m_Buffer + offset );
+		pad->m_Size = padding;
+		pad->m_Kind = AsyncRecordKinds::Padding;
+		offset = 0;
+	}
+
+	AsyncRecord* record = reinterpret_cast< AsyncRecord* >( ring->m_Buffer + offset );
+	record->m_Size = size;
+	next = write + padding + size;
+	return record;
+}
+
+// publish a record filled in after ReserveAsyncRecord
+static void CommitAsyncRecord(AsyncRing* ring, uint32_t next)
+{
+	AtomicExchange( ring->m_Write, static_cast< int32_t >( next ) );
+
+	WakeAsyncWriter();
+}
+
+static void EnqueueStatement(const char* string, Stream stream, Level level, ConsoleColor color, int indent)
+{
+	AsyncRing* ring = GetAsyncRing();
+	uint32_t capacity = ring->m_Mask + 1;
+
+	// very long statements get truncated to fit
+	size_t length = StringLength( string );
+	size_t maxLength = capacity / 2 - sizeof( AsyncRecord ) - 8;
+	if ( length > maxLength )
+	{
+		length = maxLength;
+	}
+
+	uint32_t next;
+	AsyncRecord* record = ReserveAsyncRecord( ring, static_cast< uint32_t >( length + 1 ), next );
+	if ( !record )
+	{
+		return;
+	}
+
+	record->m_Kind = AsyncRecordKinds::Text;
+	record->m_Stream = stream;
+	record->m_Level = level;
+	record->m_Color = color;
+	record->m_Indent = indent;
+	record->m_ThreadId = Thread::GetCurrentId();
+
+	char* text = reinterpret_cast< char* >( record + 1 );
+	MemoryCopy( text, string, length );
+	text[ length ] = '\0';
+
+	CommitAsyncRecord( ring, next );
+}
+
+static void EnqueueBinaryStatement(const BinaryLogStatement& statement, const uint8_t* arguments, int indent)
+{
+	AsyncRing* ring = GetAsyncRing();
+
+	uint32_t next;
+	AsyncRecord* record = ReserveAsyncRecord( ring, sizeof( AsyncBinaryPayload ) + statement.m_ArgumentSize, next );
+	if ( !record )
+	{
+		return;
+	}
+
+	record->m_Kind = AsyncRecordKinds::Binary;
+	record->m_Stream = statement.m_Stream;
+	record->m_Level = static_cast< Level >( statement.m_Level );
+	record->m_Color = ConsoleColors::None;
+	record->m_Indent = indent;
+	record->m_ThreadId = Thread::GetCurrentId();
+
+	AsyncBinaryPayload* payload = reinterpret_cast< AsyncBinaryPayload* >( record + 1 );
+	payload->m_Timestamp = statement.m_Timestamp;
+	payload->m_FormatId = statement.m_FormatId;
+	payload->m_ArgumentSize = statement.m_ArgumentSize;
+	MemoryCopy( payload + 1, arguments, statement.m_ArgumentSize );
+
+	CommitAsyncRecord( ring, next );
+}
+
+// deliver all queued records, g_Mutex must be held, returns the number of records written
+static uint32_t DrainAsyncRings()
+{
+	uint32_t count = 0;
+
+	AsyncRing* next;
+	for ( AsyncRing* ring = g_AsyncRings; ring; ring = next )
+	{
+		next = ring->m_Next;
+
+		// a retired ring won't get any more records, so once we've caught up with this write it's done
+		bool retired = ring->m_Retired != 0;
+		uint32_t read = static_cast< uint32_t >( ring->m_Read );
+		uint32_t write = static_cast< uint32_t >( ring->m_Write );
+
+		int32_t dropped = ring->m_Dropped;
+		if ( dropped != ring->m_DroppedReported )
+		{
+			char notice[ 128 ];
+			StringPrint( notice, "WARNING: %d log statement(s) dropped, the log buffer was full\n", dropped - ring->m_DroppedReported );
+			WriteStatement( notice, Streams::Warning, Levels::Default, ConsoleColors::None, 0, Thread::GetCurrentId(), NULL, 0, false );
+			ring->m_DroppedReported = dropped;
+		}
+
+		while ( read != write )
+		{
+			const AsyncRecord* record = reinterpret_cast< const AsyncRecord* >( ring->m_Buffer + ( read & ring->m_Mask ) );
+			if ( record->m_Kind == AsyncRecordKinds::Text )
+			{
+				WriteStatement( reinterpret_cast< const char* >( record + 1 ), record->m_Stream, record->m_Level, record->m_Color, record->m_Indent, record->m_ThreadId, NULL, 0, false );
+				++count;
+			}
+			else if ( record->m_Kind == AsyncRecordKinds::Binary )
+			{
+				const AsyncBinaryPayload* payload = reinterpret_cast< const AsyncBinaryPayload* >( record + 1 );
+
+				BinaryLogStatement statement;
+				statement.m_FormatId = payload->m_FormatId;
+				statement.m_Stream = record->m_Stream;
+				statement.m_Level = record->m_Level;
+				statement.m_ArgumentSize = payload->m_ArgumentSize;
+				statement.m_ThreadId = (uint64_t)record->m_ThreadId;
+				statement.m_Timestamp = payload->m_Timestamp;
+
+				WriteBinaryStatement( statement, reinterpret_cast< const uint8_t* >( payload + 1 ), record->m_Indent, record->m_ThreadId, false );
+				++count;
+			}
+
+			read += record->m_Size;
+		}
+
+		AtomicExchange( ring->m_Read, static_cast< int32_t >( read ) );
+
+		if ( retired )
+		{
+			FreeAsyncRing( ring );
+		}
+	}
+
+	// the per-statement writes above skip flushing, so do it once for the whole batch
+	if ( count )
+	{
+		M_OutputFile::iterator itr = g_TraceFiles.begin();
+		M_OutputFile::iterator end = g_TraceFiles.end();
+		for( ; itr != end; ++itr )
+		{
+			File* f = g_FileManager.Find( (*itr).first );
+			if ( f )
+			{
+				f->Flush();
+			}
+		}
+
+		FlushBinaryLogs();
+	}
+
+	return count;
+}
+
+static bool AsyncRingsPending()
+{
+	Helium::MutexScopeLock mutex (g_Mutex);
+
+	for ( AsyncRing* ring = g_AsyncRings; ring; ring = ring->m_Next )
+	{
+		if ( ring->m_Read != ring->m_Write )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void AsyncWriterThread( void* )
+{
+	while ( g_AsyncRunning )
+	{
+		int32_t wake = g_AsyncWake;
+
+		uint32_t count = 0;
+		{
+			Helium::MutexScopeLock mutex (g_Mutex);
+			count = DrainAsyncRings();
+		}
+
+		if ( !count )
+		{
+			// advertise that we are about to sleep, then re-check so we can't miss a statement that raced with us
+			AtomicIncrement( g_AsyncSleeping );
+			if ( g_AsyncRunning && !AsyncRingsPending() )
+			{
+				FutexWait( g_AsyncWake, wake );
+			}
+			AtomicDecrement( g_AsyncSleeping );
+		}
+	}
+
+	Helium::MutexScopeLock mutex (g_Mutex);
+	DrainAsyncRings();
+}
+
+void Log::EnableAsync( bool enable, uint32_t ringSize )
+{
+	if ( enable == IsAsyncEnabled() )
+	{
+		return;
+	}
+
+	if ( enable )
+	{
+		g_AsyncRingSize = ringSize;
+		g_AsyncRunning = 1;
+		if ( !g_AsyncThread.Create( &AsyncWriterThread, NULL, "Log Writer" ) )
+		{
+			g_AsyncRunning = 0;
+			HELIUM_BREAK();
+			return;
+		}
+
+		AtomicExchange( g_AsyncEnabled, 1 );
+	}
+	else
+	{
+		// new statements are written synchronously from here, the writer drains what is left on its way out
+		AtomicExchange( g_AsyncEnabled, 0 );
+		AtomicExchange( g_AsyncRunning, 0 );
+		AtomicIncrement( g_AsyncWake );
+		FutexWakeAll( g_AsyncWake );
+		g_AsyncThread.Join();
+	}
+}
+
+bool Log::IsAsyncEnabled()
+{
+	return g_AsyncEnabled != 0;
+}
+
+void Log::Flush()
+{
+	Helium::MutexScopeLock mutex (g_Mutex);
+
+	if ( g_AsyncRings )
+	{
+		DrainAsyncRings();
+	}
+
+	FlushBinaryLogs();
+}
+
+uint32_t Log::GetDroppedCount()
+{
+	Helium::MutexScopeLock mutex (g_Mutex);
+
+	uint32_t dropped = g_AsyncRetiredDropped;
+	for ( AsyncRing* ring = g_AsyncRings; ring; ring = ring->m_Next )
+	{
+		dropped += ring->m_Dropped;
+	}
+
+	return dropped;
+}
+
+uint32_t Log::GetAsyncRingCount()
+{
+	return static_cast< uint32_t >( g_AsyncRingCount );
+}
+
+void Log::PrintString(const char* string, Stream stream, Level level, ConsoleColor color, int indent, char* output, uint32_t outputSize)
+{
+	if ( g_AsyncEnabled && !output )
+	{
+		// skip the copy entirely if nobody would see this
+		if ( ( ( g_Streams & stream ) == stream && level <= g_Level ) || ( g_TraceStreams & stream ) == stream )
+		{
+			EnqueueStatement( string, stream, level, color, indent < 0 ? g_Indent : indent );
+		}
+
+		return;
+	}
+
+	Helium::MutexScopeLock mutex (g_Mutex);
+
+	// anything still queued was printed before us
+	if ( g_AsyncRings )
+	{
+		DrainAsyncRings();
+	}
+
+	WriteStatement( string, stream, level, color, indent, Thread::GetCurrentId(), output, outputSize, true );
+}
+
 void Log::PrintStatement(const Statement& statement)
 {
 	Helium::MutexScopeLock mutex (g_Mutex);
@@ -486,199 +1083,192 @@ void Log::PrintStatements(const std::vector< Statement >& statements, uint32_t s
 	}
 }
 
-void Log::PrintColor(ConsoleColor color, const char* fmt, ...)
+// format a statement on the caller's stack (so no lock is needed) and print it
+static void PrintFormatted(Stream stream, Level level, ConsoleColor color, int indent, const char* prefix, const char* fmt, va_list args)
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
+	// check for nothing to do before paying for the formatting
+	if ( !WouldPrint( stream, level ) )
+	{
+		return;
+	}
 
-	va_list args;
-	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, fmt, args);
+	char string[MAX_PRINT_SIZE];
+	size_t length = 0;
+	if ( prefix )
+	{
+		CopyString( string, prefix );
+		length = StringLength( string );
+	}
+
+	int size = StringPrintArgs(string + length, MAX_PRINT_SIZE - length, fmt, args);
 	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
 	HELIUM_ASSERT(size >= 0);
-	PrintString(string, Streams::Normal, Levels::Default, color); 
-	va_end(args); 
+
+	PrintString(string, stream, level, color, indent);
 }
 
-void Log::Print(const char *fmt,...) 
+// encode arguments from a parameter pack rather than a va_list
+static bool EncodeArgumentList(uint8_t* buffer, uint32_t bufferSize, uint32_t& size, const char* fmt, ...)
 {
+	va_list args;
+	va_start(args, fmt);
+	bool result = EncodeArguments(fmt, args, buffer, bufferSize, size);
+	va_end(args);
+	return result;
+}
+
+void Log::PrintDeferred(Stream stream, Level level, const char* fmt, ...)
+{
+	// check for nothing to do before paying for the encoding
+	if ( ( ( g_Streams & stream ) != stream || level > g_Level ) && ( g_TraceStreams & stream ) != stream && ( g_BinaryStreams & stream ) != stream )
+	{
+		return;
+	}
+
+	uint8_t arguments[ MAX_PRINT_SIZE ];
+	uint32_t size = 0;
+	bool encoded = false;
+
+	uint32_t formatId = InternFormat( fmt );
+	if ( formatId )
+	{
+		va_list args;
+		va_start(args, fmt);
+		encoded = EncodeArguments( fmt, args, arguments, sizeof( arguments ), size );
+		va_end(args);
+	}
+
+	if ( !encoded )
+	{
+		// out of format ids, too much data, or a conversion we can't defer: format now and defer the string
+		static const char s_StringFormat[] = "%s";
+
+		char string[ MAX_PRINT_SIZE / 2 ];
+		va_list args;
+		va_start(args, fmt);
+		StringPrintArgs( string, fmt, args );
+		va_end(args);
+		string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
+
+		formatId = InternFormat( s_StringFormat );
+		if ( !formatId || !EncodeArgumentList( arguments, sizeof( arguments ), size, s_StringFormat, string ) )
+		{
+			// no format id left for even that, print the text the ordinary way (binary log files won't see it)
+			PrintString( string, stream, level, GetStreamColor( stream ) );
+			return;
+		}
+	}
+
+	BinaryLogStatement statement;
+	statement.m_FormatId = formatId;
+	statement.m_Stream = stream;
+	statement.m_Level = level;
+	statement.m_ArgumentSize = size;
+	statement.m_ThreadId = (uint64_t)Thread::GetCurrentId();
+	statement.m_Timestamp = Timer::GetTickCount();
+
+	if ( g_AsyncEnabled )
+	{
+		EnqueueBinaryStatement( statement, arguments, g_Indent );
+		return;
+	}
+
 	Helium::MutexScopeLock mutex (g_Mutex);
 
+	// anything still queued was printed before us
+	if ( g_AsyncRings )
+	{
+		DrainAsyncRings();
+	}
+
+	WriteBinaryStatement( statement, arguments, g_Indent, Thread::GetCurrentId(), true );
+}
+
+void Log::PrintColor(ConsoleColor color, const char* fmt, ...)
+{
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, fmt, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
+	PrintFormatted(Streams::Normal, Levels::Default, color, -1, NULL, fmt, args);
+	va_end(args);
+}
 
-	PrintString(string, Streams::Normal, Levels::Default, Log::GetStreamColor( Streams::Normal ));
-	va_end(args);      
+void Log::Print(const char *fmt,...) 
+{
+	va_list args;
+	va_start(args, fmt); 
+	PrintFormatted(Streams::Normal, Levels::Default, Log::GetStreamColor( Streams::Normal ), -1, NULL, fmt, args);
+	va_end(args);
 }
 
 void Log::Print(Level level, const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, fmt, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Normal, level, Log::GetStreamColor( Streams::Normal ));
-	va_end(args);       
+	PrintFormatted(Streams::Normal, level, Log::GetStreamColor( Streams::Normal ), -1, NULL, fmt, args);
+	va_end(args);
 }
 
 void Log::Debug(const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "DEBUG: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Debug, Levels::Default, Log::GetStreamColor( Streams::Debug ), 0);
+	PrintFormatted(Streams::Debug, Levels::Default, Log::GetStreamColor( Streams::Debug ), 0, "DEBUG: ", fmt, args);
 	va_end(args);
 }
 
 void Log::Debug(Level level, const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "DEBUG: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Debug, level, Log::GetStreamColor( Streams::Debug ), 0);
+	PrintFormatted(Streams::Debug, level, Log::GetStreamColor( Streams::Debug ), 0, "DEBUG: ", fmt, args);
 	va_end(args);
 }
 
 void Log::Profile(const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "PROFILE: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Profile, Levels::Default, Log::GetStreamColor( Streams::Profile ), 0);
+	PrintFormatted(Streams::Profile, Levels::Default, Log::GetStreamColor( Streams::Profile ), 0, "PROFILE: ", fmt, args);
 	va_end(args);
 }
 
 void Log::Profile(Level level, const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "PROFILE: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Profile, level, Log::GetStreamColor( Streams::Profile ), 0);
+	PrintFormatted(Streams::Profile, level, Log::GetStreamColor( Streams::Profile ), 0, "PROFILE: ", fmt, args);
 	va_end(args);
 }
 
 void Log::Warning(const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "WARNING: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Warning, Levels::Default, Log::GetStreamColor( Streams::Warning ), 0);
-	va_end(args);      
+	PrintFormatted(Streams::Warning, Levels::Default, Log::GetStreamColor( Streams::Warning ), 0, "WARNING: ", fmt, args);
+	va_end(args);
 }
 
 void Log::Warning(Level level, const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "WARNING: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Warning, level, Log::GetStreamColor( Streams::Warning ), 0);
-	va_end(args);      
+	PrintFormatted(Streams::Warning, level, Log::GetStreamColor( Streams::Warning ), 0, "WARNING: ", fmt, args);
+	va_end(args);
 }
 
 void Log::Error(const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "ERROR: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Error, Levels::Default, Log::GetStreamColor( Streams::Error ), 0);
+	PrintFormatted(Streams::Error, Levels::Default, Log::GetStreamColor( Streams::Error ), 0, "ERROR: ", fmt, args);
 	va_end(args);
 }
 
 void Log::Error(Level level, const char *fmt,...) 
 {
-	Helium::MutexScopeLock mutex (g_Mutex);
-
-	static char format[MAX_PRINT_SIZE];
-	StringPrint(format, "ERROR: ");
-	AppendString(format, fmt);
-
 	va_list args;
 	va_start(args, fmt); 
-	static char string[MAX_PRINT_SIZE];
-	int size = StringPrintArgs(string, format, args);
-	string[ sizeof(string)/sizeof(string[0]) - 1] = 0; 
-	HELIUM_ASSERT(size >= 0);
-
-	PrintString(string, Streams::Error, level, Log::GetStreamColor( Streams::Error ), 0);
+	PrintFormatted(Streams::Error, level, Log::GetStreamColor( Streams::Error ), 0, "ERROR: ", fmt, args);
 	va_end(args);
 }
 
@@ -903,7 +1493,8 @@ uint32_t Listener::GetErrorCount()
 
 void Listener::Print( ListenerArgs& args )
 {
-	if ( m_Thread == Thread::GetCurrentId() )
+	// statements may be delivered from the async writer thread, so match on the thread that printed them
+	if ( m_Thread == args.m_Statement.m_ThreadId )
 	{
 		if ( args.m_Statement.m_Stream == Log::Streams::Warning && m_WarningCount )
 		{
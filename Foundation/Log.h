@@ -68,8 +68,9 @@ namespace Helium
 			Stream      m_Stream;
 			Level       m_Level;
 			int         m_Indent;
+			ThreadId    m_ThreadId; // the thread that printed the statement (not necessarily the one delivering it)
 
-			inline Statement( const std::string& string, Stream stream = Streams::Normal, Level level = Levels::Default, int indent = 0 );
+			inline Statement( const std::string& string, Stream stream = Streams::Normal, Level level = Levels::Default, int indent = 0, ThreadId threadId = Thread::GetCurrentId() );
 
 			inline void ApplyIndent();
 
@@ -116,6 +117,16 @@ namespace Helium
 
 		typedef FileHandle<&AddTraceFile, &RemoveTraceFile> TraceFileHandle;
 
+		//
+		// Binary logging API records deferred statements (see PrintDeferred) without formatting them:
+		//  - files hold the format string id, the raw arguments, the printing thread and a timestamp (see BinaryLog.h)
+		//  - output is buffered, call Flush() to be sure everything printed so far is on disk
+		//  - use DecodeBinaryLog() to turn a binary log file into text
+		//
+
+		HELIUM_FOUNDATION_API bool AddBinaryLogFile( const std::string& fileName, Stream stream );
+		HELIUM_FOUNDATION_API void RemoveBinaryLogFile( const std::string& fileName );
+
 		//
 		// Indenting API causes all output to be offset by whitespace
 		//
@@ -138,6 +149,9 @@ namespace Helium
 		HELIUM_FOUNDATION_API bool IsStreamEnabled( Stream stream );
 		HELIUM_FOUNDATION_API void EnableStream( Stream stream, bool enable );
 
+		// true if a statement would be printed to the console or a trace file, to check before paying for its text
+		HELIUM_FOUNDATION_API bool WouldPrint( Stream stream, Level level = Levels::Default );
+
 		// get the print color for the given stream
 		HELIUM_FOUNDATION_API ConsoleColor GetStreamColor(Stream stream);
 
@@ -145,6 +159,26 @@ namespace Helium
 		HELIUM_FOUNDATION_API void LockMutex();
 		HELIUM_FOUNDATION_API void UnlockMutex();
 
+		//
+		// Asynchronous API moves listener dispatch and trace file output onto a background writer thread:
+		//  - each printing thread formats into its own lock-free ring buffer of ringSize bytes (a power of two)
+		//  - when a ring is full the statement is discarded and counted, so memory use stays bounded
+		//  - prints that capture their output (Bullet) are still done synchronously, after queued statements
+		//
+
+		// start or stop the background writer (stopping flushes everything queued so far)
+		HELIUM_FOUNDATION_API void EnableAsync( bool enable, uint32_t ringSize = 64 * 1024 );
+		HELIUM_FOUNDATION_API bool IsAsyncEnabled();
+
+		// write out all queued statements on the calling thread, for use on shutdown and crash paths
+		HELIUM_FOUNDATION_API void Flush();
+
+		// number of statements discarded because the printing thread's ring buffer was full
+		HELIUM_FOUNDATION_API uint32_t GetDroppedCount();
+
+		// number of ring buffers allocated, the rings of exited threads are freed once everything in them is written
+		HELIUM_FOUNDATION_API uint32_t GetAsyncRingCount();
+
 		//
 		// Printing APIs are the heart of Console
 		//
@@ -187,6 +221,10 @@ namespace Helium
 		HELIUM_FOUNDATION_API void Error(const char *fmt,...);
 		HELIUM_FOUNDATION_API void Error(Level level, const char *fmt,...);
 
+		// make a statement whose formatting is deferred until something reads it as text, fmt must be a string
+		//  literal since it is identified by address (binary log files never format it at all)
+		HELIUM_FOUNDATION_API void PrintDeferred(Stream stream, Level level, const char* fmt, ...);
+
 		// stack-based indention helper object indents all output while on the stack
 		class HELIUM_FOUNDATION_API Indentation
 		{
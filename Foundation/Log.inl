@@ -1,8 +1,9 @@
-Helium::Log::Statement::Statement( const std::string& string, Stream stream, Level level, int indent )
+Helium::Log::Statement::Statement( const std::string& string, Stream stream, Level level, int indent, ThreadId threadId )
     : m_String( string )
     , m_Stream( stream )
     , m_Level( level )
     , m_Indent( indent )
+    , m_ThreadId( threadId )
 {
 
 }
@@ -0,0 +1,357 @@
+#include "Precompile.h"
+#include "Foundation/Log.h"
+#include "Foundation/BinaryLog.h"
+
+#include "Platform/Atomic.h"
+#include "Platform/Console.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+
+using namespace Helium;
+
+static int32_t volatile g_TestStatements = 0;
+static ThreadId g_TestStatementThread;
+static bool g_TestStatementThreadMatched = true;
+
+static void CountTestStatement( Log::ListenerArgs& args )
+{
+	if ( args.m_Statement.m_Stream == Log::Streams::Normal )
+	{
+		AtomicIncrement( g_TestStatements );
+		if ( args.m_Statement.m_ThreadId != g_TestStatementThread )
+		{
+			g_TestStatementThreadMatched = false;
+		}
+	}
+
+	// keep the console quiet
+	args.m_Skip = true;
+}
+
+struct LogProducer
+{
+	uint32_t m_Count;
+
+	void Run()
+	{
+		for ( uint32_t i = 0; i < m_Count; ++i )
+		{
+			Log::Print( "Log benchmark statement %u of %u, with a little bit of padding to make it realistic\n", i, m_Count );
+		}
+	}
+};
+
+struct DeferredLogProducer
+{
+	uint32_t m_Count;
+
+	void Run()
+	{
+		for ( uint32_t i = 0; i < m_Count; ++i )
+		{
+			Log::PrintDeferred( Log::Streams::Normal, Log::Levels::Default, "Log benchmark statement %u of %u, with a little bit of padding to make it realistic\n", i, m_Count );
+		}
+	}
+};
+
+static bool CheckRender( char* expected, size_t expectedSize, char* rendered, size_t renderedSize, const char* fmt, ... )
+{
+	va_list args;
+	va_start( args, fmt );
+	vsnprintf( expected, expectedSize, fmt, args );
+	va_end( args );
+
+	uint8_t arguments[ 1024 ];
+	uint32_t size = 0;
+	va_start( args, fmt );
+	bool encoded = Log::EncodeArguments( fmt, args, arguments, sizeof( arguments ), size );
+	va_end( args );
+
+	Log::RenderArguments( fmt, arguments, size, rendered, static_cast< uint32_t >( renderedSize ) );
+	return encoded;
+}
+
+static bool EncodeTestArguments( uint8_t* arguments, uint32_t argumentsSize, uint32_t& size, const char* fmt, ... )
+{
+	va_list args;
+	va_start( args, fmt );
+	bool encoded = Log::EncodeArguments( fmt, args, arguments, argumentsSize, size );
+	va_end( args );
+	return encoded;
+}
+
+#define EXPECT_RENDERS( ... ) \
+	{ \
+		char expected[ 256 ], rendered[ 256 ]; \
+		EXPECT_TRUE( CheckRender( expected, sizeof( expected ), rendered, sizeof( rendered ), __VA_ARGS__ ) ); \
+		EXPECT_STREQ( expected, rendered ); \
+	}
+
+TEST(LogBinary, RenderMatchesPrintf)
+{
+	int value = 42;
+	EXPECT_RENDERS( "plain text, 100%% literal" );
+	EXPECT_RENDERS( "%d %i %u %x %X %o %c", -7, 12, 3000000000u, 0xbeef, 0xbeef, 8, 'z' );
+	EXPECT_RENDERS( "%hhd %hd %ld %lld %zu %jd %td", 300, 70000, -123456789L, -1234567890123LL, static_cast< size_t >( 99 ), static_cast< intmax_t >( -5 ), static_cast< ptrdiff_t >( 17 ) );
+	EXPECT_RENDERS( "%f %.3e %g %10.2f %-8.1f|", 3.25, 1234.5678, 0.0001, 2.5, -1.25 );
+	EXPECT_RENDERS( "%*d|%-*.*f|%.*s", 6, 9, 10, 2, 3.14159, 3, "abcdef" );
+	EXPECT_RENDERS( "[%s] [%10s] [%-4s] [%s]", "hello", "right", "l", static_cast< const char* >( "" ) );
+	EXPECT_RENDERS( "%p", static_cast< void* >( &value ) );
+
+	// a precision can cut a string short, which needn't be terminated then
+	const char unterminated[ 4 ] = { 'a', 'b', 'c', 'd' };
+	EXPECT_RENDERS( "[%.*s] [%.4s] [%.2s] [%-6.3s] [%.*s]", 4, unterminated, unterminated, unterminated, unterminated, -1, "all" );
+
+	uint8_t arguments[ 64 ];
+	uint32_t size = 0;
+	EXPECT_TRUE( EncodeTestArguments( arguments, sizeof( arguments ), size, "%.2s", "abcdef" ) );
+	EXPECT_EQ( sizeof( uint32_t ) + 2, size );
+
+	// wide strings can't be deferred
+	char expected[ 64 ], rendered[ 64 ];
+	EXPECT_FALSE( CheckRender( expected, sizeof( expected ), rendered, sizeof( rendered ), "%ls", L"wide" ) );
+}
+
+TEST(LogBinary, DecodeRoundTrip)
+{
+	const char* binaryFile = "LogBinaryRoundTrip.hlog";
+	const char* textFile = "LogBinaryRoundTrip.log";
+
+	bool normalEnabled = Log::IsStreamEnabled( Log::Streams::Normal );
+	Log::EnableStream( Log::Streams::Normal, false );
+	ASSERT_TRUE( Log::AddBinaryLogFile( binaryFile, Log::Streams::Normal ) );
+
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		Log::PrintDeferred( Log::Streams::Normal, Log::Levels::Default, "Deferred %u: %s %.2f\n", i, "text", i * 0.5 );
+	}
+	Log::PrintDeferred( Log::Streams::Normal, Log::Levels::Default, "partial " );
+	Log::PrintDeferred( Log::Streams::Normal, Log::Levels::Default, "line\n" );
+
+	Log::Flush();
+	Log::RemoveBinaryLogFile( binaryFile );
+	Log::EnableStream( Log::Streams::Normal, normalEnabled );
+
+	ASSERT_TRUE( Log::DecodeBinaryLog( binaryFile, textFile ) );
+
+	std::ifstream input ( textFile );
+	std::string line;
+	const char* expected[] = { "Deferred 0: text 0.00", "Deferred 1: text 0.50", "Deferred 2: text 1.00", "partial line" };
+	for ( uint32_t i = 0; i < sizeof( expected ) / sizeof( expected[ 0 ] ); ++i )
+	{
+		ASSERT_TRUE( std::getline( input, line ).good() );
+
+		// each line is stamped with the timer seconds and thread, then the text
+		size_t stamp = line.find( "] " );
+		ASSERT_NE( std::string::npos, stamp );
+		double seconds = -1.0;
+		unsigned long long threadId = 0;
+		EXPECT_EQ( 2, sscanf( line.c_str(), "[%lf TID:%llu] ", &seconds, &threadId ) );
+		EXPECT_LE( 0.0, seconds );
+		EXPECT_EQ( (unsigned long long)(uint64_t)Thread::GetCurrentId(), threadId );
+		EXPECT_EQ( expected[ i ], line.substr( stamp + 2 ) );
+	}
+	EXPECT_FALSE( std::getline( input, line ).good() );
+	input.close();
+
+	remove( binaryFile );
+	remove( textFile );
+}
+
+TEST(LogBinary, CallBenchmark)
+{
+	const char* traceFile = "LogBinaryBenchmark.log";
+	const char* binaryFile = "LogBinaryBenchmark.hlog";
+	const uint32_t statementCount = 16 * 1024;
+
+	bool normalEnabled = Log::IsStreamEnabled( Log::Streams::Normal );
+	Log::EnableStream( Log::Streams::Normal, false );
+
+	for ( int binary = 0; binary < 2; ++binary )
+	{
+		if ( binary )
+		{
+			Log::AddBinaryLogFile( binaryFile, Log::Streams::Normal );
+		}
+		else
+		{
+			Log::AddTraceFile( traceFile, Log::Streams::Normal );
+		}
+
+		LogProducer textProducer;
+		textProducer.m_Count = statementCount;
+		DeferredLogProducer binaryProducer;
+		binaryProducer.m_Count = statementCount;
+
+		SimpleTimer timer;
+		if ( binary )
+		{
+			binaryProducer.Run();
+		}
+		else
+		{
+			textProducer.Run();
+		}
+		float64_t callMillis = timer.Elapsed();
+		Log::Flush();
+		float64_t totalMillis = timer.Elapsed();
+
+		Helium::Print( "Log (%s): %u statements, %.0f ns/call, %.1f ms until written\n",
+			binary ? "binary" : "text", statementCount, callMillis * 1000000.0 / statementCount, totalMillis );
+
+		if ( binary )
+		{
+			Log::RemoveBinaryLogFile( binaryFile );
+		}
+		else
+		{
+			Log::RemoveTraceFile( traceFile );
+		}
+	}
+
+	Log::EnableStream( Log::Streams::Normal, normalEnabled );
+	remove( traceFile );
+	remove( binaryFile );
+}
+
+TEST(LogAsync, ListenersSeePrintingThread)
+{
+	g_TestStatements = 0;
+	g_TestStatementThread = Thread::GetCurrentId();
+	g_TestStatementThreadMatched = true;
+
+	Log::AddListener( Log::ListenerSignature::Delegate( &CountTestStatement ) );
+	Log::EnableAsync( true );
+
+	for ( uint32_t i = 0; i < 100; ++i )
+	{
+		Log::Print( "Async statement %u\n", i );
+	}
+
+	Log::Flush();
+	EXPECT_EQ( 100, g_TestStatements );
+	EXPECT_TRUE( g_TestStatementThreadMatched );
+
+	Log::EnableAsync( false );
+	Log::RemoveListener( Log::ListenerSignature::Delegate( &CountTestStatement ) );
+}
+
+TEST(LogAsync, DroppedStatementsAreCounted)
+{
+	g_TestStatements = 0;
+	g_TestStatementThread = Thread::GetCurrentId();
+
+	Log::AddListener( Log::ListenerSignature::Delegate( &CountTestStatement ) );
+	Log::EnableAsync( true, 1024 );
+
+	// this thread's ring already exists (and is bigger), so log from a fresh one
+	LogProducer producer;
+	producer.m_Count = 10000;
+	CallbackThread thread;
+	g_TestStatementThread = ThreadId ();
+	uint32_t droppedBefore = Log::GetDroppedCount();
+	thread.Create( &CallbackThread::EntryHelper< LogProducer, &LogProducer::Run >, &producer, "Log Producer" );
+	thread.Join();
+
+	Log::EnableAsync( false );
+	Log::RemoveListener( Log::ListenerSignature::Delegate( &CountTestStatement ) );
+
+	// every statement was either delivered or counted as dropped
+	EXPECT_EQ( producer.m_Count, static_cast< uint32_t >( g_TestStatements ) + ( Log::GetDroppedCount() - droppedBefore ) );
+}
+
+TEST(LogAsync, RingsOfExitedThreadsAreFreed)
+{
+	g_TestStatements = 0;
+	g_TestStatementThread = ThreadId ();
+
+	Log::AddListener( Log::ListenerSignature::Delegate( &CountTestStatement ) );
+	Log::EnableAsync( true );
+
+	const uint32_t roundCount = 32;
+	const uint32_t threadCount = 8;
+	uint32_t ringsBefore = Log::GetAsyncRingCount();
+	uint32_t mostRings = 0;
+	for ( uint32_t round = 0; round < roundCount; ++round )
+	{
+		LogProducer producers[ threadCount ];
+		CallbackThread threads[ threadCount ];
+		for ( uint32_t i = 0; i < threadCount; ++i )
+		{
+			producers[ i ].m_Count = 10;
+			threads[ i ].Create( &CallbackThread::EntryHelper< LogProducer, &LogProducer::Run >, &producers[ i ], "Log Producer" );
+		}
+		for ( uint32_t i = 0; i < threadCount; ++i )
+		{
+			threads[ i ].Join();
+		}
+		if ( mostRings < Log::GetAsyncRingCount() )
+		{
+			mostRings = Log::GetAsyncRingCount();
+		}
+
+		// the exited threads' rings go once they're written out
+		Log::Flush();
+		EXPECT_EQ( ringsBefore, Log::GetAsyncRingCount() );
+	}
+
+	Log::EnableAsync( false );
+	Log::RemoveListener( Log::ListenerSignature::Delegate( &CountTestStatement ) );
+
+	EXPECT_LE( mostRings, ringsBefore + threadCount );
+	EXPECT_EQ( roundCount * threadCount * 10, static_cast< uint32_t >( g_TestStatements ) );
+}
+
+TEST(LogAsync, ThroughputBenchmark)
+{
+	const char* traceFile = "LogAsyncBenchmark.log";
+	const uint32_t statementCount = 16 * 1024;
+
+	// trace file only, nothing on the console (including dropped statement notices)
+	bool normalEnabled = Log::IsStreamEnabled( Log::Streams::Normal );
+	bool warningEnabled = Log::IsStreamEnabled( Log::Streams::Warning );
+	Log::EnableStream( Log::Streams::Normal, false );
+	Log::EnableStream( Log::Streams::Warning, false );
+	Log::AddTraceFile( traceFile, Log::Streams::Normal );
+
+	for ( int async = 0; async < 2; ++async )
+	{
+		Log::EnableAsync( async != 0, 1024 * 1024 );
+
+		for ( uint32_t threadCount = 1; threadCount <= 32; threadCount *= 2 )
+		{
+			LogProducer producers[ 32 ];
+			CallbackThread threads[ 32 ];
+			uint32_t droppedBefore = Log::GetDroppedCount();
+
+			SimpleTimer timer;
+			for ( uint32_t i = 0; i < threadCount; ++i )
+			{
+				producers[ i ].m_Count = statementCount / threadCount;
+				threads[ i ].Create( &CallbackThread::EntryHelper< LogProducer, &LogProducer::Run >, &producers[ i ], "Log Producer" );
+			}
+			for ( uint32_t i = 0; i < threadCount; ++i )
+			{
+				threads[ i ].Join();
+			}
+			float64_t callMillis = timer.Elapsed();
+			Log::Flush();
+			float64_t totalMillis = timer.Elapsed();
+
+			Helium::Print( "Log (%s): %2u thread(s), %u statements, %.1f ms in callers, %.1f ms until written, %u dropped\n",
+				async ? "async" : "sync", threadCount, statementCount, callMillis, totalMillis, Log::GetDroppedCount() - droppedBefore );
+		}
+	}
+
+	Log::EnableAsync( false );
+	Log::RemoveTraceFile( traceFile );
+	Log::EnableStream( Log::Streams::Normal, normalEnabled );
+	Log::EnableStream( Log::Streams::Warning, warningEnabled );
+	remove( traceFile );
+}
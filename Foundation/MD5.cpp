@@ -1,11 +1,14 @@
 #include "Precompile.h"
 #include "MD5.h"
 
+#include "Platform/Assert.h"
+#include "Platform/Console.h"
 #include "Platform/Exception.h"
 #include "Platform/File.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 /*
 Copyright (C) 1999, 2002 Aladdin Enterprises.  All rights reserved.
@@ -486,6 +489,19 @@ inline void md5_finish(md5_state_t *pms, md5_byte_t digest[16])
 
 /* End Copyright (C) 1999, 2002 Aladdin Enterprises, begin Helium open source */
 
+// each byte as two hex digits, upper case
+static std::string ToHex( const md5_byte_t digest[16] )
+{
+    char hex_output[16*2 + 1];
+    for (int di = 0; di < 16; ++di)
+    {
+        char* where = hex_output + di * 2;
+        Helium::StringPrint(where, sizeof( hex_output ) - di * 2, "%02X", digest[di]);
+    }
+
+    return hex_output;
+}
+
 std::string Helium::MD5(const void* data, uint32_t count)
 {
     md5_state_t state;
@@ -496,14 +512,7 @@ std::string Helium::MD5(const void* data, uint32_t count)
     md5_byte_t digest[16];
     md5_finish(&state, digest);
 
-    char hex_output[16*2 + 1];
-    for (int di = 0; di < 16; ++di)
-    {
-		char* where = hex_output + di * 2;
-        StringPrint(where, where - hex_output, "%02X", digest[di]);
-    }
-
-    return hex_output;
+    return ToHex( digest );
 }
 
 std::string Helium::MD5(const std::string& data)
@@ -519,31 +528,42 @@ std::string Helium::FileMD5(const std::string& filePath, uint32_t packetSize)
         throw Helium::Exception( "Unable to open %s for read", filePath.c_str());
     }
 
-	f.Seek( 0, SeekOrigins::End );
-	int64_t size = f.Tell();
-	f.Seek( 0, SeekOrigins::Begin );
-
-    md5_state_t state;
-    md5_init(&state);
-
-    uint8_t* data = (uint8_t*)alloca( packetSize );
-    while ( size )
+    // on the heap, so large packets are fine
+    std::vector< uint8_t > data ( packetSize );
+    MD5Hasher hasher;
+    size_t read = 0;
+    while ( f.Read( &data[ 0 ], packetSize, &read ) && read )
     {
-		size_t read = f.Read(data, packetSize);
-        md5_append(&state, data, (int)read);
-        size -= read;
+        hasher.Update( &data[ 0 ], read );
     }
-	f.Close();
+    f.Close();
 
-    md5_byte_t digest[16];
-    md5_finish(&state, digest);
+    return hasher.Finish();
+}
 
-    char hex_output[16*2 + 1];
-    for (int di = 0; di < 16; ++di)
+HELIUM_COMPILE_ASSERT( sizeof( md5_state_t ) == sizeof( uint32_t ) * 22 );
+
+Helium::MD5Hasher::MD5Hasher()
+{
+    md5_init( reinterpret_cast< md5_state_t* >( m_State ) );
+}
+
+void Helium::MD5Hasher::Update( const void* data, size_t count )
+{
+    // md5_append takes an int
+    const md5_byte_t* bytes = static_cast< const md5_byte_t* >( data );
+    while ( count )
     {
-		char* where = hex_output + di * 2;
-        StringPrint(where, where - hex_output, "%02X", digest[di]);
+        int chunk = count < 0x40000000 ? static_cast< int >( count ) : 0x40000000;
+        md5_append( reinterpret_cast< md5_state_t* >( m_State ), bytes, chunk );
+        bytes += chunk;
+        count -= chunk;
     }
+}
 
-    return hex_output;
-}
\ No newline at end of file
+std::string Helium::MD5Hasher::Finish()
+{
+    md5_byte_t digest[16];
+    md5_finish( reinterpret_cast< md5_state_t* >( m_State ), digest );
+    return ToHex( digest );
+}
@@ -2,9 +2,24 @@
 
 #include "Platform/Types.h"
 
+#include "Foundation/API.h"
+
 namespace Helium
 {
     std::string MD5(const void* data, uint32_t count);
     std::string MD5(const std::string& data);
     std::string FileMD5(const std::string& filePath, uint32_t packetSize = 4096);
+
+    // MD5 of data that comes in pieces
+    class HELIUM_FOUNDATION_API MD5Hasher
+    {
+    public:
+        MD5Hasher();
+
+        void Update(const void* data, size_t count);
+        std::string Finish();
+
+    private:
+        uint32_t m_State[ 22 ]; // md5_state_t, which only MD5.cpp knows
+    };
 }
@@ -9,7 +9,7 @@ using namespace Helium;
 
 void MessagePackWriter::WriteNil()
 {
-	stream->Write< uint8_t >( MessagePackTypes::Nil );
+	buffer.Write< uint8_t >( MessagePackTypes::Nil );
 
 	if ( !containerState.IsEmpty() )
 	{
@@ -19,7 +19,7 @@ void MessagePackWriter::WriteNil()
 
 void MessagePackWriter::Write( bool value )
 {
-	stream->Write< uint8_t >( value ? MessagePackTypes::True : MessagePackTypes::False );
+	buffer.Write< uint8_t >( value ? MessagePackTypes::True : MessagePackTypes::False );
 
 	if ( !containerState.IsEmpty() )
 	{
@@ -29,12 +29,12 @@ void MessagePackWriter::Write( bool value )
 
 void MessagePackWriter::Write( float32_t value )
 {
-	stream->Write< uint8_t >( MessagePackTypes::Float32 );
+	buffer.Write< uint8_t >( MessagePackTypes::Float32 );
 
 #if HELIUM_ENDIAN_LITTLE
-	stream->Write< uint32_t >( ConvertEndianFloatToU32( value ) );
+	buffer.Write< uint32_t >( ConvertEndianFloatToU32( value ) );
 #else
-	stream->Write< float32_t >( value );
+	buffer.Write< float32_t >( value );
 #endif
 
 	if ( !containerState.IsEmpty() )
@@ -45,12 +45,12 @@ void MessagePackWriter::Write( float32_t value )
 
 void MessagePackWriter::Write( float64_t value )
 {
-	stream->Write< uint8_t >( MessagePackTypes::Float64 );
+	buffer.Write< uint8_t >( MessagePackTypes::Float64 );
 
 #if HELIUM_ENDIAN_LITTLE
-	stream->Write< uint64_t >( ConvertEndianDoubleToU64( value ) );
+	buffer.Write< uint64_t >( ConvertEndianDoubleToU64( value ) );
 #else
-	stream->Write< float64_t >( value );
+	buffer.Write< float64_t >( value );
 #endif
 
 	if ( !containerState.IsEmpty() )
@@ -63,12 +63,12 @@ void MessagePackWriter::Write( uint8_t value )
 {
 	if ( value <= MessagePackMasks::FixNumPositiveValue )
 	{
-		stream->Write< uint8_t >( value );
+		buffer.Write< uint8_t >( value );
 	}
 	else
 	{
-		stream->Write< uint8_t >( MessagePackTypes::UInt8 );
-		stream->Write< uint8_t >( value );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt8 );
+		buffer.Write< uint8_t >( value );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -81,20 +81,20 @@ void MessagePackWriter::Write( uint16_t value )
 {
 	if ( value <= MessagePackMasks::FixNumPositiveValue )
 	{
-		stream->Write< uint8_t >( static_cast< uint8_t >( value ) );
+		buffer.Write< uint8_t >( static_cast< uint8_t >( value ) );
 	}
 	else if ( value <= NumericLimits< uint8_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::UInt8 );
-		stream->Write< uint8_t >( static_cast< uint8_t >( value ) );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt8 );
+		buffer.Write< uint8_t >( static_cast< uint8_t >( value ) );
 	}
 	else
 	{
 #if HELIUM_ENDIAN_LITTLE
 		value = ConvertEndian( value );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::UInt16 );
-		stream->Write< uint16_t >( value );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt16 );
+		buffer.Write< uint16_t >( value );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -107,12 +107,12 @@ void MessagePackWriter::Write( uint32_t value )
 {
 	if ( value <= MessagePackMasks::FixNumPositiveValue )
 	{
-		stream->Write< uint8_t >( static_cast< uint8_t >( value ) );
+		buffer.Write< uint8_t >( static_cast< uint8_t >( value ) );
 	}
 	else if ( value <= NumericLimits< uint8_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::UInt8 );
-		stream->Write< uint8_t >( static_cast< uint8_t >( value ) );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt8 );
+		buffer.Write< uint8_t >( static_cast< uint8_t >( value ) );
 	}
 	else if ( value <= NumericLimits< uint16_t >::Maximum )
 	{
@@ -120,16 +120,16 @@ void MessagePackWriter::Write( uint32_t value )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::UInt16 );
-		stream->Write< uint16_t >( temp );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt16 );
+		buffer.Write< uint16_t >( temp );
 	}
 	else
 	{
 #if HELIUM_ENDIAN_LITTLE
 		value = ConvertEndian( value );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::UInt32 );
-		stream->Write< uint32_t >( value );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt32 );
+		buffer.Write< uint32_t >( value );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -142,12 +142,12 @@ void MessagePackWriter::Write( uint64_t value )
 {
 	if ( value <= MessagePackMasks::FixNumPositiveValue )
 	{
-		stream->Write< uint8_t >( static_cast< uint8_t >( value ) );
+		buffer.Write< uint8_t >( static_cast< uint8_t >( value ) );
 	}
 	else if ( value <= NumericLimits< uint8_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::UInt8 );
-		stream->Write< uint8_t >( static_cast< uint8_t >( value ) );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt8 );
+		buffer.Write< uint8_t >( static_cast< uint8_t >( value ) );
 	}
 	else if ( value <= NumericLimits< uint16_t >::Maximum )
 	{
@@ -155,8 +155,8 @@ void MessagePackWriter::Write( uint64_t value )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::UInt16 );
-		stream->Write< uint16_t >( temp );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt16 );
+		buffer.Write< uint16_t >( temp );
 	}
 	else if ( value <= NumericLimits< uint32_t >::Maximum )
 	{
@@ -164,16 +164,16 @@ void MessagePackWriter::Write( uint64_t value )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::UInt32 );
-		stream->Write< uint32_t >( temp );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt32 );
+		buffer.Write< uint32_t >( temp );
 	}
 	else
 	{
 #if HELIUM_ENDIAN_LITTLE
 		value = ConvertEndian( value );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::UInt64 );
-		stream->Write< uint64_t >( value );
+		buffer.Write< uint8_t >( MessagePackTypes::UInt64 );
+		buffer.Write< uint64_t >( value );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -186,16 +186,16 @@ void MessagePackWriter::Write( int8_t value )
 {
 	if ( value >= 0 )
 	{
-		stream->Write< int8_t >( value );
+		buffer.Write< int8_t >( value );
 	}
 	else if ( value < 0 && value >= -32 )
 	{
-		stream->Write< int8_t >( value );
+		buffer.Write< int8_t >( value );
 	}
 	else
 	{
-		stream->Write< uint8_t >( MessagePackTypes::Int8 );
-		stream->Write< int8_t >( value );
+		buffer.Write< uint8_t >( MessagePackTypes::Int8 );
+		buffer.Write< int8_t >( value );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -208,24 +208,24 @@ void MessagePackWriter::Write( int16_t value )
 {
 	if ( value >= 0 && value <= MessagePackMasks::FixNumPositiveValue )
 	{
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value < 0 && value >= -32 )
 	{
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value >= NumericLimits< int8_t >::Minimum && value <= NumericLimits< int8_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::Int8 );
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< uint8_t >( MessagePackTypes::Int8 );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else
 	{
 #if HELIUM_ENDIAN_LITTLE
 		value = ConvertEndian( value );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Int16 );
-		stream->Write< int16_t >( value );
+		buffer.Write< uint8_t >( MessagePackTypes::Int16 );
+		buffer.Write< int16_t >( value );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -238,16 +238,16 @@ void MessagePackWriter::Write( int32_t value )
 {
 	if ( value >= 0 && value <= MessagePackMasks::FixNumPositiveValue )
 	{
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value < 0 && value >= -32 )
 	{
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value >= NumericLimits< int8_t >::Minimum && value <= NumericLimits< int8_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::Int8 );
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< uint8_t >( MessagePackTypes::Int8 );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value >= NumericLimits< int16_t >::Minimum && value <= NumericLimits< int16_t >::Maximum )
 	{
@@ -255,16 +255,16 @@ void MessagePackWriter::Write( int32_t value )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Int16 );
-		stream->Write< int16_t >( temp );
+		buffer.Write< uint8_t >( MessagePackTypes::Int16 );
+		buffer.Write< int16_t >( temp );
 	}
 	else
 	{
 #if HELIUM_ENDIAN_LITTLE
 		value = ConvertEndian( value );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Int32 );
-		stream->Write< int32_t >( value );
+		buffer.Write< uint8_t >( MessagePackTypes::Int32 );
+		buffer.Write< int32_t >( value );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -277,16 +277,16 @@ void MessagePackWriter::Write( int64_t value )
 {
 	if ( value >= 0 && value <= MessagePackMasks::FixNumPositiveValue )
 	{
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value < 0 && value >= -32 )
 	{
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value >= NumericLimits< int8_t >::Minimum && value <= NumericLimits< int8_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::Int8 );
-		stream->Write< int8_t >( static_cast< int8_t >( value ) );
+		buffer.Write< uint8_t >( MessagePackTypes::Int8 );
+		buffer.Write< int8_t >( static_cast< int8_t >( value ) );
 	}
 	else if ( value >= NumericLimits< int16_t >::Minimum && value <= NumericLimits< int16_t >::Maximum )
 	{
@@ -294,8 +294,8 @@ void MessagePackWriter::Write( int64_t value )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Int16 );
-		stream->Write< int16_t >( temp );
+		buffer.Write< uint8_t >( MessagePackTypes::Int16 );
+		buffer.Write< int16_t >( temp );
 	}
 	else if ( value >= NumericLimits< int32_t >::Minimum && value <= NumericLimits< int32_t >::Maximum )
 	{
@@ -303,8 +303,8 @@ void MessagePackWriter::Write( int64_t value )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Int32 );
-		stream->Write< int32_t >( temp );
+		buffer.Write< uint8_t >( MessagePackTypes::Int32 );
+		buffer.Write< int32_t >( temp );
 	}
 	else
 	{
@@ -312,8 +312,8 @@ void MessagePackWriter::Write( int64_t value )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Int64 );
-		stream->Write< int64_t >( temp );
+		buffer.Write< uint8_t >( MessagePackTypes::Int64 );
+		buffer.Write< int64_t >( temp );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -332,8 +332,8 @@ void MessagePackWriter::WriteRaw( const void* bytes, uint32_t length )
 {
 	if ( length <= 31 )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::FixRaw | static_cast< uint8_t >( length ) );
-		stream->Write( bytes, length, 1 );
+		buffer.Write< uint8_t >( MessagePackTypes::FixRaw | static_cast< uint8_t >( length ) );
+		buffer.Write( bytes, 1, length );
 	}
 	else if ( length <= 65535 )
 	{
@@ -341,9 +341,9 @@ void MessagePackWriter::WriteRaw( const void* bytes, uint32_t length )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( temp );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Raw16 );
-		stream->Write< uint16_t >( temp );
-		stream->Write( bytes, length, 1 );
+		buffer.Write< uint8_t >( MessagePackTypes::Raw16 );
+		buffer.Write< uint16_t >( temp );
+		buffer.Write( bytes, 1, length );
 	}
 	else
 	{
@@ -351,9 +351,9 @@ void MessagePackWriter::WriteRaw( const void* bytes, uint32_t length )
 #if HELIUM_ENDIAN_LITTLE
 		temp = ConvertEndian( length );
 #endif
-		stream->Write< uint8_t >( MessagePackTypes::Raw32 );
-		stream->Write< uint32_t >( temp );
-		stream->Write( bytes, length, 1 );
+		buffer.Write< uint8_t >( MessagePackTypes::Raw32 );
+		buffer.Write< uint32_t >( temp );
+		buffer.Write( bytes, 1, length );
 	}
 
 	if ( !containerState.IsEmpty() )
@@ -362,6 +362,76 @@ void MessagePackWriter::WriteRaw( const void* bytes, uint32_t length )
 	}
 }
 
+void MessagePackWriter::WriteExt( int8_t extType, const void* bytes, uint32_t length )
+{
+	switch ( length )
+	{
+	case 1:
+		buffer.Write< uint8_t >( MessagePackTypes::FixExt1 );
+		break;
+
+	case 2:
+		buffer.Write< uint8_t >( MessagePackTypes::FixExt2 );
+		break;
+
+	case 4:
+		buffer.Write< uint8_t >( MessagePackTypes::FixExt4 );
+		break;
+
+	case 8:
+		buffer.Write< uint8_t >( MessagePackTypes::FixExt8 );
+		break;
+
+	case 16:
+		buffer.Write< uint8_t >( MessagePackTypes::FixExt16 );
+		break;
+
+	default:
+		if ( length <= 255 )
+		{
+			buffer.Write< uint8_t >( MessagePackTypes::Ext8 );
+			buffer.Write< uint8_t >( static_cast< uint8_t >( length ) );
+		}
+		else if ( length <= 65535 )
+		{
+			uint16_t temp = length;
+#if HELIUM_ENDIAN_LITTLE
+			temp = ConvertEndian( temp );
+#endif
+			buffer.Write< uint8_t >( MessagePackTypes::Ext16 );
+			buffer.Write< uint16_t >( temp );
+		}
+		else
+		{
+			uint32_t temp = length;
+#if HELIUM_ENDIAN_LITTLE
+			temp = ConvertEndian( length );
+#endif
+			buffer.Write< uint8_t >( MessagePackTypes::Ext32 );
+			buffer.Write< uint32_t >( temp );
+		}
+		break;
+	}
+
+	buffer.Write< int8_t >( extType );
+	buffer.Write( bytes, 1, length );
+
+	if ( !containerState.IsEmpty() )
+	{
+		containerState.GetLast().length--;
+	}
+}
+
+void MessagePackWriter::WriteEncoded( const void* bytes, size_t size, uint32_t count )
+{
+	buffer.Write( bytes, 1, size );
+
+	if ( !containerState.IsEmpty() )
+	{
+		containerState.GetLast().length -= count;
+	}
+}
+
 void MessagePackWriter::BeginArray( uint32_t length )
 {
 	ContainerState state;
@@ -370,9 +440,9 @@ void MessagePackWriter::BeginArray( uint32_t length )
 
 	if ( length == NumericLimits< uint32_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::Array32 );
-		state.lengthOffset = stream->Tell();
-		stream->Write< uint32_t >( length );
+		buffer.Write< uint8_t >( MessagePackTypes::Array32 );
+		state.lengthOffset = buffer.Tell();
+		buffer.Write< uint32_t >( length );
 	}
 	else
 	{
@@ -380,7 +450,7 @@ void MessagePackWriter::BeginArray( uint32_t length )
 
 		if ( length <= 15 )
 		{
-			stream->Write< uint8_t >( MessagePackTypes::FixArray | static_cast< uint8_t >( length ) );
+			buffer.Write< uint8_t >( MessagePackTypes::FixArray | static_cast< uint8_t >( length ) );
 		}
 		else if ( length <= 65535 )
 		{
@@ -388,8 +458,8 @@ void MessagePackWriter::BeginArray( uint32_t length )
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
-			stream->Write< uint8_t >( MessagePackTypes::Array16 );
-			stream->Write< uint16_t >( temp );
+			buffer.Write< uint8_t >( MessagePackTypes::Array16 );
+			buffer.Write< uint16_t >( temp );
 		}
 		else
 		{
@@ -397,8 +467,8 @@ void MessagePackWriter::BeginArray( uint32_t length )
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
-			stream->Write< uint8_t >( MessagePackTypes::Array32 );
-			stream->Write< uint32_t >( temp );
+			buffer.Write< uint8_t >( MessagePackTypes::Array32 );
+			buffer.Write< uint32_t >( temp );
 		}
 	}
 
@@ -413,15 +483,11 @@ void MessagePackWriter::EndArray()
 	{
 		if ( state.lengthOffset != Invalid< int64_t >() )
 		{
-			stream->Seek( state.lengthOffset, SeekOrigins::Begin );
-
 			uint32_t temp = NumericLimits< uint32_t >::Maximum - state.length;
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
-			stream->Write< uint32_t >( temp );
-
-			stream->Seek( 0, SeekOrigins::End );
+			buffer.WriteAt< uint32_t >( state.lengthOffset, temp );
 		}
 		else
 		{
@@ -450,9 +516,9 @@ void MessagePackWriter::BeginMap( uint32_t length )
 
 	if ( length == NumericLimits< uint32_t >::Maximum )
 	{
-		stream->Write< uint8_t >( MessagePackTypes::Map32 );
-		state.lengthOffset = stream->Tell();
-		stream->Write< uint32_t >( length );
+		buffer.Write< uint8_t >( MessagePackTypes::Map32 );
+		state.lengthOffset = buffer.Tell();
+		buffer.Write< uint32_t >( length );
 	}
 	else
 	{
@@ -460,7 +526,7 @@ void MessagePackWriter::BeginMap( uint32_t length )
 
 		if ( length <= 15 )
 		{
-			stream->Write< uint8_t >( MessagePackTypes::FixMap | static_cast< uint8_t >( length ) );
+			buffer.Write< uint8_t >( MessagePackTypes::FixMap | static_cast< uint8_t >( length ) );
 		}
 		else if ( length <= 65535 )
 		{
@@ -468,8 +534,8 @@ void MessagePackWriter::BeginMap( uint32_t length )
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
-			stream->Write< uint8_t >( MessagePackTypes::Array16 );
-			stream->Write< uint16_t >( temp );
+			buffer.Write< uint8_t >( MessagePackTypes::Array16 );
+			buffer.Write< uint16_t >( temp );
 		}
 		else
 		{
@@ -477,8 +543,8 @@ void MessagePackWriter::BeginMap( uint32_t length )
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
-			stream->Write< uint8_t >( MessagePackTypes::Array32 );
-			stream->Write< uint32_t >( temp );
+			buffer.Write< uint8_t >( MessagePackTypes::Array32 );
+			buffer.Write< uint32_t >( temp );
 		}
 
 		// our state is going to bookkeep the number written, but we need to write TWICE as many due to key+value
@@ -496,15 +562,11 @@ void MessagePackWriter::EndMap()
 	{
 		if ( state.lengthOffset != Invalid< int64_t >() )
 		{
-			stream->Seek( state.lengthOffset, SeekOrigins::Begin );
-
 			uint32_t temp = NumericLimits< uint32_t >::Maximum - state.length;
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
-			stream->Write< uint32_t >( temp );
-
-			stream->Seek( 0, SeekOrigins::End );
+			buffer.WriteAt< uint32_t >( state.lengthOffset, temp );
 		}
 		else
 		{
@@ -531,108 +593,14 @@ void MessagePackWriter::EndMap()
 
 void MessagePackReader::Skip()
 {
-	uint32_t length = 0x0;
+	SkipValue();
 
-	if ( ( type & MessagePackMasks::FixNumPositiveType ) != MessagePackTypes::FixNumPositive
-		&& ( type & MessagePackMasks::FixNumNegativeType ) != MessagePackTypes::FixNumNegative
-		&& type != MessagePackTypes::Nil
-		&& type != MessagePackTypes::False
-		&& type != MessagePackTypes::True )
-	{
-		if ( ( type & MessagePackMasks::FixRawType ) == MessagePackTypes::FixRaw )
-		{
-			length = type & MessagePackMasks::FixRawCount;
-		}
-		else
-		{
-			if ( ( type & MessagePackMasks::FixArrayType ) == MessagePackTypes::FixArray )
-			{
-				uint32_t count = type & MessagePackMasks::FixArrayCount;
-				for ( uint32_t i=0; i<count; ++i )
-				{
-					Advance();
-					Skip();
-				}
-			}
-			else
-			{
-				if ( ( type & MessagePackMasks::FixMapType ) == MessagePackTypes::FixMap )
-				{
-					uint32_t count = type & MessagePackMasks::FixMapCount;
-					for ( uint32_t i=0; i<count; ++i )
-					{
-						Advance();
-						Skip();
-						Advance();
-						Skip();
-					}
-				}
-				else
-				{
-					switch ( type )
-					{
-					case MessagePackTypes::UInt8:
-					case MessagePackTypes::Int8:
-						length = 1;
-						break;
-
-					case MessagePackTypes::UInt16:
-					case MessagePackTypes::Int16:
-						length = 2;
-						break;
-
-					case MessagePackTypes::Float32:
-					case MessagePackTypes::UInt32:
-					case MessagePackTypes::Int32:
-						length = 4;
-						break;
-
-					case MessagePackTypes::Float64:
-					case MessagePackTypes::UInt64:
-					case MessagePackTypes::Int64:
-						length = 8;
-						break;
-
-					case MessagePackTypes::Raw16:
-					case MessagePackTypes::Raw32:
-						length = ReadRawLength();
-						break;
-
-					case MessagePackTypes::Array16:
-					case MessagePackTypes::Array32:
-						{
-							uint32_t arrayLength = ReadArrayLength();
-							for ( uint32_t i=0; i<arrayLength; ++i )
-							{
-								Advance();
-								Skip();
-							}
-						}
-
-					case MessagePackTypes::Map16:
-					case MessagePackTypes::Map32:
-						{
-							uint32_t mapLength = ReadMapLength();
-							for ( uint32_t i=0; i<mapLength; ++i )
-							{
-								Advance();
-								Skip();
-								Advance();
-								Skip();
-							}
-						}
-					}
-				}
-			}
-		}
-	}
+	Advance();
 
-	if ( length )
+	if ( !containerState.IsEmpty() )
 	{
-		stream->Seek( length, SeekOrigins::Current );
+		containerState.GetLast().length--;
 	}
-
-	Advance();
 }
 
 void MessagePackReader::Read( bool& value, bool* succeeded )
@@ -684,10 +652,10 @@ void MessagePackReader::Read( float32_t& value, bool* succeeded )
 	{
 #if HELIUM_ENDIAN_LITTLE
 		uint32_t temp = 0x0;
-		stream->Read< uint32_t >( temp );
+		ReadValue< uint32_t >( temp );
 		value = ConvertEndianU32ToFloat( temp );
 #else
-		stream->Read< float32_t >( value );
+		ReadValue< float32_t >( value );
 #endif
 
 		result = true;
@@ -723,10 +691,10 @@ void MessagePackReader::Read( float64_t& value, bool* succeeded )
 		{
 #if HELIUM_ENDIAN_LITTLE
 			uint32_t temp = 0x0;
-			stream->Read< uint32_t >( temp );
+			ReadValue< uint32_t >( temp );
 			value = ConvertEndianU32ToFloat( temp );
 #else
-			stream->Read< float32_t >( value );
+			ReadValue< float32_t >( value );
 #endif
 			result = true;
 			break;
@@ -736,10 +704,10 @@ void MessagePackReader::Read( float64_t& value, bool* succeeded )
 		{
 #if HELIUM_ENDIAN_LITTLE
 			uint64_t temp = 0x0;
-			stream->Read< uint64_t >( temp );
+			ReadValue< uint64_t >( temp );
 			value = ConvertEndianU64ToDouble( temp );
 #else
-			stream->Read< float64_t >( value );
+			ReadValue< float64_t >( value );
 #endif
 			result = true;
 			break;
@@ -779,7 +747,7 @@ void MessagePackReader::Read( uint8_t& value, bool* succeeded )
 	{
 		if ( type == MessagePackTypes::UInt8 )
 		{
-			stream->Read< uint8_t >( value );
+			ReadValue< uint8_t >( value );
 			result = true;
 		}
 	}
@@ -820,7 +788,7 @@ void MessagePackReader::Read( uint16_t& value, bool* succeeded )
 		case MessagePackTypes::UInt8:
 			{
 				uint8_t temp;
-				stream->Read< uint8_t >( temp );
+				ReadValue< uint8_t >( temp );
 				value = temp;
 				result = true;
 				break;
@@ -828,7 +796,7 @@ void MessagePackReader::Read( uint16_t& value, bool* succeeded )
 
 		case MessagePackTypes::UInt16:
 			{
-				stream->Read< uint16_t >( value );
+				ReadValue< uint16_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 				value = ConvertEndian( value );
 #endif
@@ -874,7 +842,7 @@ void MessagePackReader::Read( uint32_t& value, bool* succeeded )
 		case MessagePackTypes::UInt8:
 			{
 				uint8_t temp;
-				stream->Read< uint8_t >( temp );
+				ReadValue< uint8_t >( temp );
 				value = temp;
 				result = true;
 				break;
@@ -883,7 +851,7 @@ void MessagePackReader::Read( uint32_t& value, bool* succeeded )
 		case MessagePackTypes::UInt16:
 			{
 				uint16_t temp;
-				stream->Read< uint16_t >( temp );
+				ReadValue< uint16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 				temp = ConvertEndian( temp );
 #endif
@@ -894,7 +862,7 @@ void MessagePackReader::Read( uint32_t& value, bool* succeeded )
 
 		case MessagePackTypes::UInt32:
 			{
-				stream->Read< uint32_t >( value );
+				ReadValue< uint32_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 				value = ConvertEndian( value );
 #endif
@@ -940,7 +908,7 @@ void MessagePackReader::Read( uint64_t& value, bool* succeeded )
 		case MessagePackTypes::UInt8:
 			{
 				uint8_t temp;
-				stream->Read< uint8_t >( temp );
+				ReadValue< uint8_t >( temp );
 				value = temp;
 				result = true;
 				break;
@@ -949,7 +917,7 @@ void MessagePackReader::Read( uint64_t& value, bool* succeeded )
 		case MessagePackTypes::UInt16:
 			{
 				uint16_t temp;
-				stream->Read< uint16_t >( temp );
+				ReadValue< uint16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 				temp = ConvertEndian( temp );
 #endif
@@ -961,7 +929,7 @@ void MessagePackReader::Read( uint64_t& value, bool* succeeded )
 		case MessagePackTypes::UInt32:
 			{
 				uint32_t temp;
-				stream->Read< uint32_t >( temp );
+				ReadValue< uint32_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 				temp = ConvertEndian( temp );
 #endif
@@ -972,7 +940,7 @@ void MessagePackReader::Read( uint64_t& value, bool* succeeded )
 
 		case MessagePackTypes::UInt64:
 			{
-				stream->Read< uint64_t >( value );
+				ReadValue< uint64_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 				value = ConvertEndian( value );
 #endif
@@ -1015,14 +983,14 @@ void MessagePackReader::Read( int8_t& value, bool* succeeded )
 	{
 		if ( ( type & MessagePackMasks::FixNumNegativeType ) == MessagePackTypes::FixNumNegative )
 		{
-			value = type;
+			value = static_cast< int8_t >( type );
 			result = true;
 		}
 		else
 		{
 			if ( type == MessagePackTypes::Int8 )
 			{
-				stream->Read< int8_t >( value );
+				ReadValue< int8_t >( value );
 				result = true;
 			}
 		}
@@ -1061,7 +1029,7 @@ void MessagePackReader::Read( int16_t& value, bool* succeeded )
 	{
 		if ( ( type & MessagePackMasks::FixNumNegativeType ) == MessagePackTypes::FixNumNegative )
 		{
-			value = type;
+			value = static_cast< int8_t >( type );
 			result = true;
 		}
 		else
@@ -1071,7 +1039,7 @@ void MessagePackReader::Read( int16_t& value, bool* succeeded )
 			case MessagePackTypes::Int8:
 				{
 					int8_t temp;
-					stream->Read< int8_t >( temp );
+					ReadValue< int8_t >( temp );
 					value = temp;
 					result = true;
 					break;
@@ -1079,7 +1047,7 @@ void MessagePackReader::Read( int16_t& value, bool* succeeded )
 
 			case MessagePackTypes::Int16:
 				{
-					stream->Read< int16_t >( value );
+					ReadValue< int16_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 					value = ConvertEndian( value );
 #endif
@@ -1123,7 +1091,7 @@ void MessagePackReader::Read( int32_t& value, bool* succeeded )
 	{
 		if ( ( type & MessagePackMasks::FixNumNegativeType ) == MessagePackTypes::FixNumNegative )
 		{
-			value = type;
+			value = static_cast< int8_t >( type );
 			result = true;
 		}
 		else
@@ -1133,7 +1101,7 @@ void MessagePackReader::Read( int32_t& value, bool* succeeded )
 			case MessagePackTypes::Int8:
 				{
 					int8_t temp;
-					stream->Read< int8_t >( temp );
+					ReadValue< int8_t >( temp );
 					value = temp;
 					result = true;
 					break;
@@ -1142,7 +1110,7 @@ void MessagePackReader::Read( int32_t& value, bool* succeeded )
 			case MessagePackTypes::Int16:
 				{
 					int16_t temp;
-					stream->Read< int16_t >( temp );
+					ReadValue< int16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 					temp = ConvertEndian( temp );
 #endif
@@ -1153,7 +1121,7 @@ void MessagePackReader::Read( int32_t& value, bool* succeeded )
 
 			case MessagePackTypes::Int32:
 				{
-					stream->Read< int32_t >( value );
+					ReadValue< int32_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 					value = ConvertEndian( value );
 #endif
@@ -1197,7 +1165,7 @@ void MessagePackReader::Read( int64_t& value, bool* succeeded )
 	{
 		if ( ( type & MessagePackMasks::FixNumNegativeType ) == MessagePackTypes::FixNumNegative )
 		{
-			value = type;
+			value = static_cast< int8_t >( type );
 			result = true;
 		}
 		else
@@ -1207,7 +1175,7 @@ void MessagePackReader::Read( int64_t& value, bool* succeeded )
 			case MessagePackTypes::Int8:
 				{
 					int8_t temp;
-					stream->Read< int8_t >( temp );
+					ReadValue< int8_t >( temp );
 					value = temp;
 					result = true;
 					break;
@@ -1216,7 +1184,7 @@ void MessagePackReader::Read( int64_t& value, bool* succeeded )
 			case MessagePackTypes::Int16:
 				{
 					int16_t temp;
-					stream->Read< int16_t >( temp );
+					ReadValue< int16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 					temp = ConvertEndian( temp );
 #endif
@@ -1228,7 +1196,7 @@ void MessagePackReader::Read( int64_t& value, bool* succeeded )
 			case MessagePackTypes::Int32:
 				{
 					int32_t temp;
-					stream->Read< int32_t >( temp );
+					ReadValue< int32_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 					temp = ConvertEndian( temp );
 #endif
@@ -1239,7 +1207,7 @@ void MessagePackReader::Read( int64_t& value, bool* succeeded )
 
 			case MessagePackTypes::Int64:
 				{
-					stream->Read< int64_t >( value );
+					ReadValue< int64_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 					value = ConvertEndian( value );
 #endif
@@ -1273,6 +1241,14 @@ void MessagePackReader::Read( int64_t& value, bool* succeeded )
 void MessagePackReader::Read( String& value )
 {
 	uint32_t length = ReadRawLength();
+	if ( length == 0 )
+	{
+		// there are no characters to read into, but ReadRaw still moves us past the raw
+		value.Clear();
+		ReadRaw( NULL, 0 );
+		return;
+	}
+
 	value.Resize( length + 1 );
 	ReadRaw( &value.GetFirst(), length );
 	value += '\0';
@@ -1293,7 +1269,7 @@ uint32_t MessagePackReader::ReadRawLength()
 		case MessagePackTypes::Raw16:
 			{
 				uint16_t temp;
-				stream->Read< uint16_t >( temp );
+				ReadValue< uint16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 				temp = ConvertEndian( temp );
 #endif
@@ -1303,7 +1279,7 @@ uint32_t MessagePackReader::ReadRawLength()
 
 		case MessagePackTypes::Raw32:
 			{
-				stream->Read< uint32_t >( length );
+				ReadValue< uint32_t >( length );
 #if HELIUM_ENDIAN_LITTLE
 				length = ConvertEndian( length );
 #endif
@@ -1324,7 +1300,39 @@ uint32_t MessagePackReader::ReadRawLength()
 
 void MessagePackReader::ReadRaw( void* bytes, uint32_t length )
 {
-	stream->Read( bytes, length, 1 );
+	if ( length )
+	{
+		ReadBytes( bytes, length );
+	}
+
+	Advance();
+
+	if ( !containerState.IsEmpty() )
+	{
+		containerState.GetLast().length--;
+	}
+}
+
+const void* MessagePackReader::ReadRawView( uint32_t length )
+{
+	const void* bytes = NULL;
+
+	if ( begin )
+	{
+		if ( static_cast< size_t >( end - current ) < length )
+		{
+			throw Helium::Exception( "Unexpected end of MessagePack data" );
+		}
+
+		bytes = current;
+		current += length;
+	}
+	else
+	{
+		scratch.Resize( length );
+		stream->Read( scratch.GetData(), 1, length );
+		bytes = scratch.GetData();
+	}
 
 	Advance();
 
@@ -1332,6 +1340,82 @@ void MessagePackReader::ReadRaw( void* bytes, uint32_t length )
 	{
 		containerState.GetLast().length--;
 	}
+
+	return bytes;
+}
+
+uint32_t MessagePackReader::ReadString( const char*& chars )
+{
+	uint32_t length = ReadRawLength();
+	chars = static_cast< const char* >( ReadRawView( length ) );
+	return length;
+}
+
+uint32_t MessagePackReader::ReadExtLength( int8_t& extType )
+{
+	uint32_t length = 0;
+
+	switch ( type )
+	{
+	case MessagePackTypes::FixExt1:
+		length = 1;
+		break;
+
+	case MessagePackTypes::FixExt2:
+		length = 2;
+		break;
+
+	case MessagePackTypes::FixExt4:
+		length = 4;
+		break;
+
+	case MessagePackTypes::FixExt8:
+		length = 8;
+		break;
+
+	case MessagePackTypes::FixExt16:
+		length = 16;
+		break;
+
+	case MessagePackTypes::Ext8:
+		{
+			uint8_t temp;
+			ReadValue< uint8_t >( temp );
+			length = temp;
+			break;
+		}
+
+	case MessagePackTypes::Ext16:
+		{
+			uint16_t temp;
+			ReadValue< uint16_t >( temp );
+#if HELIUM_ENDIAN_LITTLE
+			temp = ConvertEndian( temp );
+#endif
+			length = temp;
+			break;
+		}
+
+	case MessagePackTypes::Ext32:
+		{
+			ReadValue< uint32_t >( length );
+#if HELIUM_ENDIAN_LITTLE
+			length = ConvertEndian( length );
+#endif
+			break;
+		}
+
+	default:
+		{
+			throw Helium::Exception( "Object type is not an ext" );
+		}
+	}
+
+	ReadValue< int8_t >( extType );
+
+	// do not Advance() since the next byte is not a type byte
+
+	return length;
 }
 
 uint32_t MessagePackReader::ReadArrayLength()
@@ -1349,7 +1433,7 @@ uint32_t MessagePackReader::ReadArrayLength()
 		case MessagePackTypes::Array16:
 			{
 				uint16_t temp;
-				stream->Read< uint16_t >( temp );
+				ReadValue< uint16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 				temp = ConvertEndian( temp );
 #endif
@@ -1359,7 +1443,7 @@ uint32_t MessagePackReader::ReadArrayLength()
 
 		case MessagePackTypes::Array32:
 			{
-				stream->Read< uint32_t >( length );
+				ReadValue< uint32_t >( length );
 #if HELIUM_ENDIAN_LITTLE
 				length = ConvertEndian( length );
 #endif
@@ -1423,7 +1507,7 @@ uint32_t MessagePackReader::ReadMapLength()
 		case MessagePackTypes::Map16:
 			{
 				uint16_t temp;
-				stream->Read< uint16_t >( temp );
+				ReadValue< uint16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 				temp = ConvertEndian( temp );
 #endif
@@ -1433,7 +1517,7 @@ uint32_t MessagePackReader::ReadMapLength()
 
 		case MessagePackTypes::Map32:
 			{
-				stream->Read< uint32_t >( length );
+				ReadValue< uint32_t >( length );
 #if HELIUM_ENDIAN_LITTLE
 				length = ConvertEndian( length );
 #endif
@@ -1490,10 +1574,10 @@ void MessagePackReader::ReadFloat( float64_t& value )
 		{
 #if HELIUM_ENDIAN_LITTLE
 			uint32_t temp = 0x0;
-			stream->Read< uint32_t >( temp );
+			ReadValue< uint32_t >( temp );
 			value = ConvertEndianU32ToFloat( temp );
 #else
-			stream->Read< float32_t >( value );
+			ReadValue< float32_t >( value );
 #endif
 			break;
 		}
@@ -1502,10 +1586,10 @@ void MessagePackReader::ReadFloat( float64_t& value )
 		{
 #if HELIUM_ENDIAN_LITTLE
 			uint64_t temp = 0x0;
-			stream->Read< uint64_t >( temp );
+			ReadValue< uint64_t >( temp );
 			value = ConvertEndianU64ToDouble( temp );
 #else
-			stream->Read< float64_t >( value );
+			ReadValue< float64_t >( value );
 #endif
 			break;
 		}
@@ -1531,7 +1615,7 @@ void MessagePackReader::ReadUnsigned( uint64_t& value )
 	case MessagePackTypes::UInt8:
 		{
 			uint8_t temp = 0x0;
-			stream->Read< uint8_t >( temp );
+			ReadValue< uint8_t >( temp );
 			value = temp;
 			break;
 		}
@@ -1539,7 +1623,7 @@ void MessagePackReader::ReadUnsigned( uint64_t& value )
 	case MessagePackTypes::UInt16:
 		{
 			uint16_t temp = 0x0;
-			stream->Read< uint16_t >( temp );
+			ReadValue< uint16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
@@ -1550,7 +1634,7 @@ void MessagePackReader::ReadUnsigned( uint64_t& value )
 	case MessagePackTypes::UInt32:
 		{
 			uint32_t temp = 0x0;
-			stream->Read< uint32_t >( temp );
+			ReadValue< uint32_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
@@ -1560,7 +1644,7 @@ void MessagePackReader::ReadUnsigned( uint64_t& value )
 
 	case MessagePackTypes::UInt64:
 		{
-			stream->Read< uint64_t >( value );
+			ReadValue< uint64_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 			value = ConvertEndian( value );
 #endif
@@ -1588,7 +1672,7 @@ void MessagePackReader::ReadSigned( int64_t& value )
 	case MessagePackTypes::Int8:
 		{
 			int8_t temp = 0x0;
-			stream->Read< int8_t >( temp );
+			ReadValue< int8_t >( temp );
 			value = temp;
 			break;
 		}
@@ -1596,7 +1680,7 @@ void MessagePackReader::ReadSigned( int64_t& value )
 	case MessagePackTypes::Int16:
 		{
 			int16_t temp = 0x0;
-			stream->Read< int16_t >( temp );
+			ReadValue< int16_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
@@ -1607,7 +1691,7 @@ void MessagePackReader::ReadSigned( int64_t& value )
 	case MessagePackTypes::Int32:
 		{
 			int32_t temp = 0x0;
-			stream->Read< int32_t >( temp );
+			ReadValue< int32_t >( temp );
 #if HELIUM_ENDIAN_LITTLE
 			temp = ConvertEndian( temp );
 #endif
@@ -1617,7 +1701,7 @@ void MessagePackReader::ReadSigned( int64_t& value )
 
 	case MessagePackTypes::Int64:
 		{
-			stream->Read< int64_t >( value );
+			ReadValue< int64_t >( value );
 #if HELIUM_ENDIAN_LITTLE
 			value = ConvertEndian( value );
 #endif
@@ -1637,3 +1721,128 @@ void MessagePackReader::ReadSigned( int64_t& value )
 		containerState.GetLast().length--;
 	}
 }
+
+void MessagePackReader::SkipBytes( size_t size )
+{
+	if ( begin )
+	{
+		if ( static_cast< size_t >( end - current ) < size )
+		{
+			throw Helium::Exception( "Unexpected end of MessagePack data" );
+		}
+
+		current += size;
+	}
+	else
+	{
+		stream->Seek( size, SeekOrigins::Current );
+	}
+}
+
+// skip over the rest of the current value, leaving the stream where the next one starts
+void MessagePackReader::SkipValue()
+{
+	uint32_t length = 0x0;
+	uint32_t count = 0x0;
+
+	if ( ( type & MessagePackMasks::FixNumPositiveType ) == MessagePackTypes::FixNumPositive
+		|| ( type & MessagePackMasks::FixNumNegativeType ) == MessagePackTypes::FixNumNegative )
+	{
+		return;
+	}
+	else if ( ( type & MessagePackMasks::FixRawType ) == MessagePackTypes::FixRaw )
+	{
+		length = type & MessagePackMasks::FixRawCount;
+	}
+	else if ( ( type & MessagePackMasks::FixArrayType ) == MessagePackTypes::FixArray )
+	{
+		count = type & MessagePackMasks::FixArrayCount;
+	}
+	else if ( ( type & MessagePackMasks::FixMapType ) == MessagePackTypes::FixMap )
+	{
+		count = ( type & MessagePackMasks::FixMapCount ) * 2;
+	}
+	else
+	{
+		switch ( type )
+		{
+		case MessagePackTypes::UInt8:
+		case MessagePackTypes::Int8:
+			length = 1;
+			break;
+
+		case MessagePackTypes::UInt16:
+		case MessagePackTypes::Int16:
+			length = 2;
+			break;
+
+		case MessagePackTypes::Float32:
+		case MessagePackTypes::UInt32:
+		case MessagePackTypes::Int32:
+			length = 4;
+			break;
+
+		case MessagePackTypes::Float64:
+		case MessagePackTypes::UInt64:
+		case MessagePackTypes::Int64:
+			length = 8;
+			break;
+
+		case MessagePackTypes::Raw16:
+		case MessagePackTypes::Raw32:
+			length = ReadRawLength();
+			break;
+
+		case MessagePackTypes::FixExt1:
+		case MessagePackTypes::FixExt2:
+		case MessagePackTypes::FixExt4:
+		case MessagePackTypes::FixExt8:
+		case MessagePackTypes::FixExt16:
+		case MessagePackTypes::Ext8:
+		case MessagePackTypes::Ext16:
+		case MessagePackTypes::Ext32:
+			{
+				int8_t extType;
+				length = ReadExtLength( extType );
+				break;
+			}
+
+		case MessagePackTypes::Array16:
+		case MessagePackTypes::Map16:
+			{
+				uint16_t temp;
+				ReadValue< uint16_t >( temp );
+#if HELIUM_ENDIAN_LITTLE
+				temp = ConvertEndian( temp );
+#endif
+				count = type == MessagePackTypes::Map16 ? temp * 2 : temp;
+				break;
+			}
+
+		case MessagePackTypes::Array32:
+		case MessagePackTypes::Map32:
+			{
+				ReadValue< uint32_t >( count );
+#if HELIUM_ENDIAN_LITTLE
+				count = ConvertEndian( count );
+#endif
+				count = type == MessagePackTypes::Map32 ? count * 2 : count;
+				break;
+			}
+
+		default:
+			break;
+		}
+	}
+
+	if ( length )
+	{
+		SkipBytes( length );
+	}
+
+	for ( uint32_t i=0; i<count; ++i )
+	{
+		Advance();
+		SkipValue();
+	}
+}
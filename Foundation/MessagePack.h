@@ -49,6 +49,16 @@ namespace Helium
 			Array32                 = 0xdd, // 11011101
 			Map16                   = 0xde, // 11011110
 			Map32                   = 0xdf, // 11011111
+
+			// Extension objects, a signed type code and that many bytes of data (from the later revision of the spec)
+			FixExt1                 = 0xd4, // 11010100
+			FixExt2                 = 0xd5, // 11010101
+			FixExt4                 = 0xd6, // 11010110
+			FixExt8                 = 0xd7, // 11010111
+			FixExt16                = 0xd8, // 11011000
+			Ext8                    = 0xc7, // 11000111
+			Ext16                   = 0xc8, // 11001000
+			Ext32                   = 0xc9, // 11001001
 		};
 	};
 	typedef MessagePackTypes::Type MessagePackType;
@@ -87,6 +97,9 @@ namespace Helium
 		inline MessagePackWriter( Stream* stream = NULL );
 		inline void SetStream( Stream* stream );
 
+		// hand buffered output to the stream (this doesn't flush the stream itself)
+		inline void Flush();
+
 		void WriteNil();
 		void Write( bool value );
 		void Write( float32_t value );
@@ -102,6 +115,10 @@ namespace Helium
 
 		void Write( const char* str );
 		void WriteRaw( const void* bytes, uint32_t length );
+		void WriteExt( int8_t extType, const void* bytes, uint32_t length );
+
+		// values encoded by another writer (into memory, say, on some other thread)
+		void WriteEncoded( const void* bytes, size_t size, uint32_t count = 1 );
 
 		void BeginArray( uint32_t length = NumericLimits< uint32_t >::Maximum );
 		void EndArray();
@@ -110,7 +127,7 @@ namespace Helium
 		void EndMap();
 
 	private:
-		Stream*                        stream;
+		BufferedStreamWriter           buffer;
 		struct ContainerState
 		{
 			MessagePackContainer container;
@@ -124,8 +141,16 @@ namespace Helium
 	{
 	public:
 		inline MessagePackReader( Stream* stream = NULL );
+		inline MessagePackReader( const void* data, size_t size );
 		inline void SetStream( Stream* stream );
 
+		// decode straight from memory (that outlives the reader), without a virtual call per token
+		inline void SetBuffer( const void* data, size_t size );
+		inline bool IsBuffered() const;
+
+		// offset of the byte after the current type byte, in the stream or buffer
+		inline int64_t Tell() const;
+
 		inline void Advance();
 		inline bool IsNil();
 		inline bool IsBoolean();
@@ -133,6 +158,7 @@ namespace Helium
 		inline bool IsRaw();
 		inline bool IsArray();
 		inline bool IsMap();
+		inline bool IsExt();
 		void Skip();
 
 		// NULL succeeded pointer will throw on failure
@@ -155,6 +181,13 @@ namespace Helium
 		uint32_t ReadRawLength();
 		void ReadRaw( void* bytes, uint32_t length );
 
+		// the next raw without copying it out, valid while the buffer is (or, reading a stream, until the next view)
+		const void* ReadRawView( uint32_t length );
+		uint32_t ReadString( const char*& chars ); // not null terminated, returns the length
+
+		// the data of an ext is read like a raw, with ReadRaw or ReadRawView
+		uint32_t ReadExtLength( int8_t& extType );
+
 		uint32_t ReadArrayLength();
 		void BeginArray( uint32_t length );
 		void EndArray();
@@ -167,8 +200,17 @@ namespace Helium
 		void ReadFloat( float64_t& value );
 		void ReadUnsigned( uint64_t& value );
 		void ReadSigned( int64_t& value );
+		void SkipValue();
+
+		inline void ReadBytes( void* bytes, size_t size );
+		template< class T >
+		inline void ReadValue( T& value );
+		void SkipBytes( size_t size );
 
 		Stream*                        stream;
+		const uint8_t*                 begin;          // of the buffer, NULL when reading a stream
+		const uint8_t*                 current;
+		const uint8_t*                 end;
 		uint8_t                        type;
 		struct ContainerState
 		{
@@ -176,6 +218,7 @@ namespace Helium
 			uint32_t             length;
 		};
 		DynamicArray< ContainerState > containerState;
+		DynamicArray< uint8_t >        scratch;        // raw views of a stream
 	};
 }
 
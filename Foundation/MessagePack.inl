@@ -1,38 +1,116 @@
 Helium::MessagePackWriter::MessagePackWriter( Stream* stream )
-: stream( stream )
+: buffer( stream )
 {
 
 }
 
 void Helium::MessagePackWriter::SetStream( Stream* stream )
 {
-	if ( this->stream != stream )
+	if ( this->buffer.GetStream() != stream )
 	{
-		this->stream = stream;
+		this->buffer.Open( stream );
 		this->containerState.Clear();
 	}
 }
 
+void Helium::MessagePackWriter::Flush()
+{
+	this->buffer.Flush();
+}
+
 Helium::MessagePackReader::MessagePackReader( Stream* stream )
 : stream( stream )
+, begin( NULL )
+, current( NULL )
+, end( NULL )
 , type( MessagePackTypes::Nil )
 {
 
 }
 
+Helium::MessagePackReader::MessagePackReader( const void* data, size_t size )
+: stream( NULL )
+, begin( NULL )
+, current( NULL )
+, end( NULL )
+, type( MessagePackTypes::Nil )
+{
+	SetBuffer( data, size );
+}
+
 void Helium::MessagePackReader::SetStream( Stream* stream )
 {
-	if ( this->stream != stream )
+	if ( this->stream != stream || this->begin )
 	{
 		this->stream = stream;
+		this->begin = NULL;
+		this->current = NULL;
+		this->end = NULL;
 		this->type = MessagePackTypes::Nil;
 		this->containerState.Clear();
 	}
 }
 
+void Helium::MessagePackReader::SetBuffer( const void* data, size_t size )
+{
+	HELIUM_ASSERT( data );
+
+	this->stream = NULL;
+	this->begin = static_cast< const uint8_t* >( data );
+	this->current = this->begin;
+	this->end = this->begin + size;
+	this->type = MessagePackTypes::Nil;
+	this->containerState.Clear();
+}
+
+bool Helium::MessagePackReader::IsBuffered() const
+{
+	return begin != NULL;
+}
+
+int64_t Helium::MessagePackReader::Tell() const
+{
+	return begin ? current - begin : stream->Tell();
+}
+
 void Helium::MessagePackReader::Advance()
 {
-	stream->Read( &type, sizeof( type ), 1 );
+	// like a stream, the type is left alone at the end of the data
+	if ( begin )
+	{
+		if ( current < end )
+		{
+			type = *current++;
+		}
+	}
+	else
+	{
+		stream->Read( &type, sizeof( type ), 1 );
+	}
+}
+
+void Helium::MessagePackReader::ReadBytes( void* bytes, size_t size )
+{
+	if ( begin )
+	{
+		if ( static_cast< size_t >( end - current ) < size )
+		{
+			throw Helium::Exception( "Unexpected end of MessagePack data" );
+		}
+
+		MemoryCopy( bytes, current, size );
+		current += size;
+	}
+	else
+	{
+		stream->Read( bytes, 1, size );
+	}
+}
+
+template< class T >
+void Helium::MessagePackReader::ReadValue( T& value )
+{
+	ReadBytes( &value, sizeof( T ) );
 }
 
 bool Helium::MessagePackReader::IsNil()
@@ -135,6 +213,26 @@ bool Helium::MessagePackReader::IsMap()
 	return false;
 }
 
+bool Helium::MessagePackReader::IsExt()
+{
+	switch ( type )
+	{
+	case MessagePackTypes::FixExt1:
+	case MessagePackTypes::FixExt2:
+	case MessagePackTypes::FixExt4:
+	case MessagePackTypes::FixExt8:
+	case MessagePackTypes::FixExt16:
+	case MessagePackTypes::Ext8:
+	case MessagePackTypes::Ext16:
+	case MessagePackTypes::Ext32:
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 template< class T >
 void Helium::MessagePackReader::ReadNumber( T& value, bool clamp, bool* succeeded )
 {
@@ -144,6 +242,7 @@ void Helium::MessagePackReader::ReadNumber( T& value, bool clamp, bool* succeede
 	{
 		value = type;
 		result = true;
+		Advance();
 
 		if ( !containerState.IsEmpty() )
 		{
@@ -156,6 +255,7 @@ void Helium::MessagePackReader::ReadNumber( T& value, bool clamp, bool* succeede
 		{
 			value = static_cast< int8_t >( type );
 			result = true;
+			Advance();
 
 			if ( !containerState.IsEmpty() )
 			{
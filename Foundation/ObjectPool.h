@@ -29,6 +29,9 @@ namespace Helium
         //@{
         T* Allocate();
         void Release( T* pObject );
+
+        size_t Allocate( T** ppObjects, size_t count );
+        void Release( T* const* ppObjects, size_t count );
         //@}
 
         /// @name Indexing
@@ -143,6 +143,91 @@ void Helium::ObjectPool< T, Allocator >::Release( T* pObject )
     m_freeObjectCount = freeObjectCount;
 }
 
+/// Allocate a batch of objects from this pool, taking the pool locks once for the whole batch.
+///
+/// @param[out] ppObjects  Array in which to store the allocated objects.
+/// @param[in]  count      Number of objects to allocate.
+///
+/// @return  Number of objects allocated, which may be less than the number requested if the free list ran short, and
+///          will only be zero if the pool is empty and no more blocks can be allocated.
+///
+/// @see Release()
+template< typename T, typename Allocator >
+size_t Helium::ObjectPool< T, Allocator >::Allocate( T** ppObjects, size_t count )
+{
+    HELIUM_ASSERT( ppObjects || count == 0 );
+
+    {
+        // Acquire a reader lock on the pool to synchronize block allocations.
+        ScopeReadLock readLock( m_poolBlockAllocationLock );
+
+        // Synchronize access to the free object list.
+        ScopeLock< SpinLock > scopeLock( m_freeObjectSpinLock );
+
+        size_t freeObjectCount = m_freeObjectCount;
+        size_t takeCount = Min( freeObjectCount, count );
+        if( takeCount != 0 )
+        {
+            freeObjectCount -= takeCount;
+            for( size_t objectIndex = 0; objectIndex < takeCount; ++objectIndex )
+            {
+                ppObjects[ objectIndex ] = m_ppFreeObjects[ freeObjectCount + objectIndex ];
+                HELIUM_ASSERT( ppObjects[ objectIndex ] );
+            }
+
+            m_freeObjectCount = freeObjectCount;
+
+            return takeCount;
+        }
+    }
+
+    if( count == 0 )
+    {
+        return 0;
+    }
+
+    // The free list is empty, so fall back on the single object path to allocate a new block.
+    T* pObject = Allocate();
+    if( !pObject )
+    {
+        return 0;
+    }
+
+    ppObjects[ 0 ] = pObject;
+
+    return 1 + Allocate( ppObjects + 1, count - 1 );
+}
+
+/// Release a batch of objects previously retrieved using Allocate() back into this pool.
+///
+/// @param[in] ppObjects  Objects to release.
+/// @param[in] count      Number of objects to release.
+///
+/// @see Allocate()
+template< typename T, typename Allocator >
+void Helium::ObjectPool< T, Allocator >::Release( T* const* ppObjects, size_t count )
+{
+    HELIUM_ASSERT( ppObjects || count == 0 );
+
+    // Acquire a reader lock on the pool to synchronize block allocations.
+    ScopeReadLock readLock( m_poolBlockAllocationLock );
+
+    // Synchronize access to the free object list.
+    ScopeLock< SpinLock > scopeLock( m_freeObjectSpinLock );
+
+    size_t freeObjectCount = m_freeObjectCount;
+    HELIUM_ASSERT( m_ppFreeObjects );
+    HELIUM_ASSERT( freeObjectCount + count <= m_blockSize * m_allocatedBlockCount );
+
+    for( size_t objectIndex = 0; objectIndex < count; ++objectIndex )
+    {
+        HELIUM_ASSERT( ppObjects[ objectIndex ] );
+        m_ppFreeObjects[ freeObjectCount + objectIndex ] = ppObjects[ objectIndex ];
+    }
+
+    m_freeObjectCount = freeObjectCount + count;
+}
+
 /// Get a unique index associated with the given object
 ///
 /// @param[in] pObject  Object from this pool for which to retrieve an index.
@@ -2,10 +2,12 @@
 #include "Profile.h"
 
 #include "Platform/Assert.h"
+#include "Platform/Locks.h"
 #include "Platform/Thread.h"
 #include "Platform/System.h"
 #include "Platform/Types.h"
 
+#include "Foundation/BinaryLog.h"
 #include "Foundation/Log.h"
 #include "Foundation/String.h"
 
@@ -14,6 +16,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <map>
+
 #ifndef MIN
 #define MIN(A,B)        ((A) < (B) ? (A) : (B))
 #endif
@@ -30,8 +34,326 @@ static uint32_t  g_ContextCount = 0;
 static Context*  g_Contexts[HELIUM_PROFILE_CONTEXTS_MAX];
 static bool      g_Enabled = false;
 
-void Profile::Startup()
+static TraceFormat   g_TraceFormat = TraceFormats::Packets;
+static File          g_TraceEventFile;  // shared by all contexts when writing the chrome format
+static Helium::Mutex g_TraceEventMutex;
+
+// all events go in one process, chrome and perfetto only use the pid to group threads
+#define HELIUM_PROFILE_TRACE_PID (1)
+
+//
+// Trace event writer
+//  Converts one thread's packet stream to Chrome trace event JSON. Scopes become begin/end event pairs so
+//  nesting is preserved across packet blocks, and any scopes still open at the end are closed at the last
+//  time stamp seen. Every event is followed by a comma, CloseTraceEventFile() writes a final event without one.
+//
+
+namespace Helium
+{
+	namespace Profile
+	{
+		class TraceEventWriter
+		{
+		public:
+			TraceEventWriter( uint64_t threadId, float64_t microsPerTick )
+				: m_ThreadId( threadId )
+				, m_MicrosPerTick( microsPerTick )
+				, m_LastTicks( 0 )
+			{
+			}
+
+			// convert the packets in one block, returns false if the block is malformed
+			bool WriteBlock( const uint8_t* block, uint32_t size, File& file );
+
+			// end any open scopes
+			void Finish( File& file );
+
+		private:
+			void Event( const char* name, const char* phase, uint64_t ticks, const char* args = NULL );
+			void Escape( const char* string, size_t maxLength );
+
+			struct SinkInfo
+			{
+				std::string m_Name;
+				std::string m_File;
+				uint32_t    m_Line;
+			};
+
+			uint64_t                          m_ThreadId;
+			float64_t                         m_MicrosPerTick;
+			uint64_t                          m_LastTicks;
+			std::vector< uint64_t >           m_ScopeStarts;
+			std::map< uint32_t, SinkInfo >    m_Sinks;
+			std::map< uint32_t, std::string > m_Descriptions;
+			std::string                       m_Output;
+		};
+	}
+}
+
+void TraceEventWriter::Escape( const char* string, size_t maxLength )
+{
+	for ( size_t i = 0; i < maxLength && string[ i ]; ++i )
+	{
+		char c = string[ i ];
+		if ( c == '"' || c == '\\' )
+		{
+			m_Output += '\\';
+			m_Output += c;
+		}
+		else if ( static_cast< unsigned char >( c ) < 0x20 )
+		{
+			char code[ 8 ];
+			StringPrint( code, "\\u%04x", c );
+			m_Output += code;
+		}
+		else
+		{
+			m_Output += c;
+		}
+	}
+}
+
+void TraceEventWriter::Event( const char* name, const char* phase, uint64_t ticks, const char* args )
+{
+	char buffer[ 128 ];
+
+	m_Output += "{";
+	if ( name )
+	{
+		m_Output += "\"name\":\"";
+		Escape( name, HELIUM_PROFILE_STRING_MAX );
+		m_Output += "\",";
+	}
+
+	StringPrint( buffer, "\"ph\":\"%s\",\"pid\":%d,\"tid\":%" PRIu64 ",\"ts\":%.3f", phase, HELIUM_PROFILE_TRACE_PID, m_ThreadId, ticks * m_MicrosPerTick );
+	m_Output += buffer;
+
+	if ( args )
+	{
+		m_Output += ",\"args\":";
+		m_Output += args;
+	}
+
+	m_Output += "},\n";
+}
+
+bool TraceEventWriter::WriteBlock( const uint8_t* block, uint32_t size, File& file )
+{
+	bool result = true;
+
+	uint32_t offset = 0;
+	while ( offset + sizeof( Header ) <= size )
+	{
+		const UberPacket* packet = reinterpret_cast< const UberPacket* >( block + offset );
+		if ( packet->m_Header.m_Size < sizeof( Header ) || offset + packet->m_Header.m_Size > size )
+		{
+			result = false;
+			break;
+		}
+
+		if ( packet->m_Header.m_Command == HELIUM_PROFILE_CMD_BLOCK_END )
+		{
+			break;
+		}
+
+		switch ( packet->m_Header.m_Command )
+		{
+		case HELIUM_PROFILE_CMD_INIT:
+			{
+				if ( packet->m_Init.m_TicksPerSecond )
+				{
+					m_MicrosPerTick = 1000000.0 / packet->m_Init.m_TicksPerSecond;
+				}
+				else
+				{
+					// the conversion is for HELIUM_PROFILE_CYCLES_FOR_CONVERSION ticks into millis
+					m_MicrosPerTick = packet->m_Init.m_Conversion * 1000.0 / HELIUM_PROFILE_CYCLES_FOR_CONVERSION;
+				}
+				break;
+			}
+
+		case HELIUM_PROFILE_CMD_THREAD_NAME:
+			{
+				m_ThreadId = packet->m_ThreadName.m_ThreadId;
+
+				std::string args = "{\"name\":\"";
+				std::swap( args, m_Output );
+				Escape( packet->m_ThreadName.m_Name, sizeof( packet->m_ThreadName.m_Name ) );
+				std::swap( args, m_Output );
+				args += "\"}";
+
+				Event( "thread_name", "M", 0, args.c_str() );
+				break;
+			}
+
+		case HELIUM_PROFILE_CMD_SINK:
+			{
+				const SinkPacket& sink = packet->m_Sink;
+				SinkInfo& info = m_Sinks[ sink.m_SinkId ];
+				info.m_Name.assign( sink.m_Name, strnlen( sink.m_Name, sizeof( sink.m_Name ) ) );
+				info.m_File.assign( sink.m_File, strnlen( sink.m_File, sizeof( sink.m_File ) ) );
+				info.m_Line = sink.m_Line;
+				break;
+			}
+
+		case HELIUM_PROFILE_CMD_DESCRIPTION:
+			{
+				const DescriptionPacket& description = packet->m_Description;
+				m_Descriptions[ description.m_DescriptionId ].assign( description.m_Description, strnlen( description.m_Description, sizeof( description.m_Description ) ) );
+				break;
+			}
+
+		case HELIUM_PROFILE_CMD_SCOPE_ENTER:
+			{
+				const ScopeEnterPacket& enter = packet->m_ScopeEnter;
+				m_ScopeStarts.push_back( enter.m_StartTicks );
+				m_LastTicks = MAX( m_LastTicks, enter.m_StartTicks );
+
+				const char* name = "Unknown";
+				char description[ HELIUM_PROFILE_STRING_MAX ];
+				std::string args;
+
+				if ( enter.m_SinkId == HELIUM_PROFILE_SINK_FLUSH )
+				{
+					name = "Context::FlushFile";
+				}
+				else
+				{
+					std::map< uint32_t, SinkInfo >::const_iterator sink = m_Sinks.find( enter.m_SinkId );
+					if ( sink != m_Sinks.end() )
+					{
+						name = sink->second.m_Name.c_str();
+
+						// keep the sink's location in the args, since a description replaces its name
+						std::swap( args, m_Output );
+						m_Output = "{\"sink\":\"";
+						Escape( sink->second.m_Name.c_str(), sink->second.m_Name.length() );
+						m_Output += "\",\"file\":\"";
+						Escape( sink->second.m_File.c_str(), sink->second.m_File.length() );
+						std::swap( args, m_Output );
+
+						char line[ 32 ];
+						StringPrint( line, "\",\"line\":%u}", sink->second.m_Line );
+						args += line;
+					}
+				}
+
+				if ( enter.m_DescriptionId && sizeof( ScopeEnterPacket ) + enter.m_ArgumentSize <= packet->m_Header.m_Size )
+				{
+					std::map< uint32_t, std::string >::const_iterator format = m_Descriptions.find( enter.m_DescriptionId );
+					if ( format != m_Descriptions.end() )
+					{
+						// the arguments follow the packet
+						Log::RenderArguments( format->second.c_str(), reinterpret_cast< const uint8_t* >( &enter + 1 ), enter.m_ArgumentSize, description, sizeof( description ) );
+						name = description;
+					}
+				}
+
+				Event( name, "B", enter.m_StartTicks, args.empty() ? NULL : args.c_str() );
+				break;
+			}
+
+		case HELIUM_PROFILE_CMD_SCOPE_EXIT:
+			{
+				if ( m_ScopeStarts.empty() )
+				{
+					// an exit for a scope entered before the trace started
+					break;
+				}
+
+				uint64_t ticks = m_ScopeStarts.back() + packet->m_ScopeExitPacket.m_Duration;
+				m_ScopeStarts.pop_back();
+				m_LastTicks = MAX( m_LastTicks, ticks );
+
+				Event( NULL, "E", ticks );
+				break;
+			}
+
+		case HELIUM_PROFILE_CMD_COUNTER:
+			{
+				const CounterPacket& counter = packet->m_Counter;
+				m_LastTicks = MAX( m_LastTicks, counter.m_Ticks );
+
+				char args[ 64 ];
+				StringPrint( args, "{\"value\":%.17g}", counter.m_Value );
+
+				Event( counter.m_Name, "C", counter.m_Ticks, args );
+				break;
+			}
+
+		default:
+			{
+				result = false;
+				break;
+			}
+		}
+
+		if ( !result )
+		{
+			break;
+		}
+
+		offset += packet->m_Header.m_Size;
+	}
+
+	if ( !m_Output.empty() )
+	{
+		file.Write( m_Output.c_str(), m_Output.length() );
+		m_Output.clear();
+	}
+
+	return result;
+}
+
+void TraceEventWriter::Finish( File& file )
+{
+	while ( !m_ScopeStarts.empty() )
+	{
+		m_ScopeStarts.pop_back();
+		Event( NULL, "E", m_LastTicks );
+	}
+
+	if ( !m_Output.empty() )
+	{
+		file.Write( m_Output.c_str(), m_Output.length() );
+		m_Output.clear();
+	}
+}
+
+static bool OpenTraceEventFile( File& file, const char* fileName )
 {
+	if ( !file.Open( fileName, FileModes::Write ) )
+	{
+		return false;
+	}
+
+	const char* start = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	file.Write( start, strlen( start ) );
+	return true;
+}
+
+static void CloseTraceEventFile( File& file )
+{
+	char end[ 128 ];
+	StringPrint( end, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Helium\"}}\n]}\n", HELIUM_PROFILE_TRACE_PID );
+	file.Write( end, strlen( end ) );
+	file.Close();
+}
+
+void Profile::Startup( TraceFormat format )
+{
+	// get the time stamp calibration out of the way before anything is timed
+	GetTimestampFrequency();
+
+	g_TraceFormat = format;
+	if ( g_TraceFormat == TraceFormats::Chrome )
+	{
+		if ( !OpenTraceEventFile( g_TraceEventFile, "profile.json" ) )
+		{
+			g_TraceFormat = TraceFormats::Packets;
+		}
+	}
+
 	g_Enabled = true;
 }
 
@@ -43,9 +365,56 @@ void Profile::Shutdown()
 		delete( g_Contexts[i] );
 	}
 	g_ContextCount = 0;
+
+	if ( g_TraceEventFile.IsOpen() )
+	{
+		CloseTraceEventFile( g_TraceEventFile );
+	}
+
 	g_Enabled = false;
 }
 
+bool Profile::ExportChromeTrace( const std::vector< std::string >& packetFiles, const std::string& jsonFile )
+{
+	File output;
+	if ( !OpenTraceEventFile( output, jsonFile.c_str() ) )
+	{
+		return false;
+	}
+
+	bool result = true;
+	std::vector< uint8_t > block( HELIUM_PROFILE_PACKET_BLOCK_SIZE );
+
+	for ( size_t i = 0; i < packetFiles.size(); ++i )
+	{
+		File input;
+		if ( !input.Open( packetFiles[ i ].c_str(), FileModes::Read ) )
+		{
+			result = false;
+			continue;
+		}
+
+		// until we see a thread name packet (protocol version 0 doesn't have them) just number the threads
+		TraceEventWriter writer ( i + 1, 1000000.0 / GetTimestampFrequency() );
+
+		size_t read = 0;
+		while ( input.Read( &block[ 0 ], block.size(), &read ) && read == block.size() )
+		{
+			if ( !writer.WriteBlock( &block[ 0 ], static_cast< uint32_t >( block.size() ), output ) )
+			{
+				result = false;
+				break;
+			}
+		}
+
+		writer.Finish( output );
+		input.Close();
+	}
+
+	CloseTraceEventFile( output );
+	return result;
+}
+
 Sink::Sink(const char* name)
 	: m_Function(NULL)
 	, m_File(NULL)
@@ -155,25 +524,10 @@ void Sink::ReportAll()
 
 Helium::ThreadLocalPointer g_ProfileContext;
 
-Profile::Timer::Timer(Sink& sink, const char* fmt, ...)
-	: m_Sink(sink)
-{
-	if ( fmt )
-	{
-		va_list args;
-		va_start(args, fmt);
-		StringPrintArgs(m_Name, fmt, args);
-		va_end(args);
-	}
-	else
-	{
-		m_Name[0] = '\0';
-	}
-
-	m_StartTicks = Helium::Timer::GetTickCount();
-
 #if HELIUM_PROFILE_INSTRUMENTATION
 
+static Context* GetContext()
+{
 	Context* context = (Context*)g_ProfileContext.GetPointer();
 
 	if ( context == NULL )
@@ -184,67 +538,161 @@ Profile::Timer::Timer(Sink& sink, const char* fmt, ...)
 		// save it off. this should probably be locked
 		g_Contexts[g_ContextCount] = context;
 		g_ContextCount++;
+	}
+
+	return context;
+}
+
+#endif
+
+void Profile::SetThreadName( const char* name )
+{
+#if HELIUM_PROFILE_INSTRUMENTATION
+	GetContext()->SetThreadName( name );
+#else
+	(void)name;
+#endif
+}
 
-		InitPacket* init = context->AllocPacket<InitPacket>(HELIUM_PROFILE_CMD_INIT);
+void Profile::RecordCounter( const char* name, float64_t value )
+{
+#if HELIUM_PROFILE_INSTRUMENTATION
+	GetContext()->RecordCounter( name, value );
+#else
+	(void)name;
+	(void)value;
+#endif
+}
 
-		init->m_Version = HELIUM_PROFILE_PROTOCOL_VERSION;
-		init->m_Signature = HELIUM_PROFILE_SIGNATURE;
-		init->m_Conversion = static_cast<float32_t>( Helium::Timer::TicksToMilliseconds(HELIUM_PROFILE_CYCLES_FOR_CONVERSION) );
+static uint64_t  g_TimestampFrequency = 0;
+static float64_t g_MillisPerTimestamp = 0.0;
+
+static void CalibrateTimestamp()
+{
+#if HELIUM_CPU_X86
+	// time the counter against the system timer for a couple of milliseconds
+	uint64_t timerFrequency = Helium::Timer::GetTicksPerSecond();
+	uint64_t startTicks = Helium::Timer::GetTickCount();
+	uint64_t startTimestamp = GetTimestamp();
+
+	uint64_t endTicks;
+	do
+	{
+		endTicks = Helium::Timer::GetTickCount();
 	}
+	while ( endTicks - startTicks < timerFrequency / 500 );
+
+	uint64_t endTimestamp = GetTimestamp();
 
-	ScopeEnterPacket* enter = context->AllocPacket<ScopeEnterPacket>(HELIUM_PROFILE_CMD_SCOPE_ENTER);
+	float64_t frequency = static_cast<float64_t>( endTimestamp - startTimestamp ) * timerFrequency / static_cast<float64_t>( endTicks - startTicks );
+	g_MillisPerTimestamp = 1000.0 / frequency;
+	g_TimestampFrequency = static_cast<uint64_t>( frequency );
+#else
+	g_MillisPerTimestamp = Helium::Timer::GetSecondsPerTick() * 1000.0;
+	g_TimestampFrequency = Helium::Timer::GetTicksPerSecond();
+#endif
+}
 
-	enter->m_UniqueID = context->m_UniqueID++;
-	enter->m_StackDepth = context->m_StackDepth;
-	enter->m_Line = m_Sink.m_Line;
-	enter->m_StartTicks = m_StartTicks;
+uint64_t Profile::GetTimestampFrequency()
+{
+	if ( g_TimestampFrequency == 0 )
+	{
+		CalibrateTimestamp();
+	}
 
-	CopyString(enter->m_Description, m_Name);
+	return g_TimestampFrequency;
+}
 
-	if ( m_Sink.m_Function )
+float64_t Profile::TimestampToMilliseconds( uint64_t timestamp )
+{
+	if ( g_MillisPerTimestamp == 0.0 )
 	{
-		CopyString(enter->m_Function, m_Sink.m_Function);
+		CalibrateTimestamp();
 	}
-	else
+
+	return timestamp * g_MillisPerTimestamp;
+}
+
+// descriptions that can't be deferred are formatted up front, and kept as the argument of this
+static const char s_TextFormat[] = "%s";
+
+// encode arguments from a parameter pack rather than a va_list
+static bool EncodeArgumentList(uint8_t* buffer, uint32_t bufferSize, uint32_t& size, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result = Log::EncodeArguments(fmt, args, buffer, bufferSize, size);
+	va_end(args);
+	return result;
+}
+
+Profile::Timer::Timer(Sink& sink, const char* fmt, ...)
+	: m_Format(NULL)
+	, m_ArgumentSize(0)
+	, m_Sink(sink)
+	, m_Context(NULL)
+{
+	if ( fmt && fmt[0] != '\0' )
 	{
-		enter->m_Function[0] = '\0';
+		// just pack the arguments, they are only formatted if the description is printed or exported
+		m_Format = fmt;
+
+		va_list args;
+		va_start(args, fmt);
+		bool encoded = Log::EncodeArguments(fmt, args, m_Arguments, sizeof(m_Arguments), m_ArgumentSize);
+		va_end(args);
+
+		if ( !encoded )
+		{
+			// too much data or a conversion we can't defer
+			char text[HELIUM_PROFILE_ARGUMENTS_MAX - sizeof(uint32_t)];
+			va_start(args, fmt);
+			StringPrintArgs(text, fmt, args);
+			va_end(args);
+
+			m_Format = s_TextFormat;
+			EncodeArgumentList(m_Arguments, sizeof(m_Arguments), m_ArgumentSize, s_TextFormat, text);
+		}
 	}
 
-	context->m_StackDepth++;
+#if HELIUM_PROFILE_INSTRUMENTATION
+
+	m_Context = GetContext();
+
+	m_StartTicks = GetTimestamp();
+	m_Context->EnterScope(m_Sink, m_Format, m_Arguments, m_ArgumentSize, m_StartTicks);
+
 	if ( m_Sink.m_Index != -1 )
 	{
-		context->m_SinkStack[m_Sink.m_Index]++;
+		m_Context->m_SinkStack[m_Sink.m_Index]++;
 	}
 
+#else
+
+	m_StartTicks = GetTimestamp();
+
 #endif
 }
 
 Profile::Timer::~Timer()
 {
-	uint64_t stopTicks = Helium::Timer::GetTickCount();
-
-	uint64_t   taken = stopTicks - m_StartTicks;
-	float millis = static_cast<float32_t>( Helium::Timer::TicksToMilliseconds(taken) );
+	uint64_t taken = GetTimestamp() - m_StartTicks;
+	float millis = static_cast<float32_t>( TimestampToMilliseconds(taken) );
 
-	if ( m_Name[0] != '\0' )
+	if ( m_Format && Log::WouldPrint(Log::Streams::Profile) )
 	{
-		Log::Profile("[%12.3f] %s\n", millis, m_Name);
+		char description[HELIUM_PROFILE_STRING_MAX];
+		Log::RenderArguments(m_Format, m_Arguments, m_ArgumentSize, description, sizeof(description));
+		Log::Profile("[%12.3f] %s\n", millis, description);
 	}
 
 #if HELIUM_PROFILE_INSTRUMENTATION
 
-	Context* context = (Context*)g_ProfileContext.GetPointer();
-	HELIUM_ASSERT(context);
-
-	ScopeExitPacket* packet = context->AllocPacket<ScopeExitPacket>(HELIUM_PROFILE_CMD_SCOPE_EXIT);
-
-	packet->m_UniqueID = context->m_UniqueID++;
-	packet->m_StackDepth = --context->m_StackDepth;
-	packet->m_Duration = taken;
+	m_Context->ExitScope(taken);
 
 	if ( m_Sink.m_Index != -1 )
 	{
-		int stack = --context->m_SinkStack[m_Sink.m_Index];
+		int stack = --m_Context->m_SinkStack[m_Sink.m_Index];
 
 		if ( stack == 0 )
 		{
@@ -266,22 +714,131 @@ Profile::Timer::~Timer()
 }
 
 Context::Context()
-	: m_UniqueID(0)
+	: m_EventWriter(NULL)
+	, m_ThreadId((uint32_t)Thread::GetCurrentId()) // trace viewers store tids as doubles, so keep them small
 	, m_StackDepth(0)
 	, m_PacketBufferOffset(0)
 {
-	m_TraceFile.Open("profile.bin", FileModes::Write);
 	memset(m_SinkStack, 0, sizeof(m_SinkStack));
+	memset(m_DefinedSinks, 0, sizeof(m_DefinedSinks));
+	memset(m_DefinedDescriptions, 0, sizeof(m_DefinedDescriptions));
+
+	if ( g_TraceFormat == TraceFormats::Chrome )
+	{
+		CopyString(m_TraceFileName, "profile.json");
+		m_EventWriter = new TraceEventWriter( m_ThreadId, 1000000.0 / GetTimestampFrequency() );
+	}
+	else
+	{
+		// each thread gets its own stream, they are merged by ExportChromeTrace
+		StringPrint(m_TraceFileName, "profile.%" PRIu64 ".bin", m_ThreadId);
+		m_TraceFile.Open(m_TraceFileName, FileModes::Write);
+	}
+
+	InitPacket* init = AllocPacket<InitPacket>(HELIUM_PROFILE_CMD_INIT);
+
+	init->m_Version = HELIUM_PROFILE_PROTOCOL_VERSION;
+	init->m_Signature = HELIUM_PROFILE_SIGNATURE;
+	init->m_Conversion = static_cast<float32_t>( TimestampToMilliseconds(HELIUM_PROFILE_CYCLES_FOR_CONVERSION) );
+	init->m_TicksPerSecond = GetTimestampFrequency();
+
+	if ( Thread::IsMain() )
+	{
+		SetThreadName("Main Thread");
+	}
+	else
+	{
+		char name[HELIUM_PROFILE_PACKET_STRING_BUFSIZE];
+		StringPrint(name, "Thread %" PRIu64, m_ThreadId);
+		SetThreadName(name);
+	}
 }
 
 Context::~Context()
 {
+	if ( m_EventWriter )
+	{
+		Helium::MutexScopeLock mutex (g_TraceEventMutex);
+		m_EventWriter->Finish( g_TraceEventFile );
+		delete m_EventWriter;
+	}
+
 	m_TraceFile.Close();
 }
 
+void Context::SetThreadName(const char* name)
+{
+	ThreadNamePacket* packet = AllocPacket<ThreadNamePacket>(HELIUM_PROFILE_CMD_THREAD_NAME);
+
+	packet->m_ThreadId = m_ThreadId;
+	CopyString(packet->m_Name, name);
+}
+
+void Context::RecordCounter(const char* name, float64_t value)
+{
+	CounterPacket* counter = AllocPacket<CounterPacket>(HELIUM_PROFILE_CMD_COUNTER);
+
+	counter->m_Ticks = GetTimestamp();
+	counter->m_Value = value;
+	CopyString(counter->m_Name, name);
+}
+
+void Context::DefineSink(const Sink& sink)
+{
+	HELIUM_ASSERT( sink.m_Index >= 0 );
+
+	SinkPacket* packet = AllocPacket<SinkPacket>(HELIUM_PROFILE_CMD_SINK);
+
+	packet->m_SinkId = sink.m_Index + 1;
+	packet->m_Line = sink.m_Line;
+	CopyString(packet->m_Name, sink.m_Function ? sink.m_Function : sink.m_Name);
+
+	// keep the end of long paths, it's the interesting part
+	const char* file = sink.m_File ? sink.m_File : "";
+	size_t length = StringLength(file);
+	if ( length >= sizeof(packet->m_File) )
+	{
+		file += length - ( sizeof(packet->m_File) - 1 );
+	}
+	CopyString(packet->m_File, file);
+
+	m_DefinedSinks[sink.m_Index >> 5] |= 1u << ( sink.m_Index & 31 );
+}
+
+uint32_t Context::DefineDescription(const char* format)
+{
+	// interned by address in the binary log's table, which any thread can do without a lock
+	uint32_t id = Log::InternFormat(format);
+	if ( id == 0 || id >= HELIUM_PROFILE_DESCRIPTIONS_MAX )
+	{
+		return 0;
+	}
+
+	if ( !( m_DefinedDescriptions[id >> 5] & ( 1u << ( id & 31 ) ) ) )
+	{
+		DescriptionPacket* packet = AllocPacket<DescriptionPacket>(HELIUM_PROFILE_CMD_DESCRIPTION);
+
+		packet->m_DescriptionId = id;
+		CopyString(packet->m_Description, format);
+
+		m_DefinedDescriptions[id >> 5] |= 1u << ( id & 31 );
+	}
+
+	return id;
+}
+
+void Context::EnterUnregisteredScope(const Sink& sink, uint64_t startTicks)
+{
+	uint8_t arguments[sizeof(uint32_t) + HELIUM_PROFILE_STRING_MAX];
+	uint32_t size = 0;
+	EncodeArgumentList(arguments, sizeof(arguments), size, s_TextFormat, sink.m_Name);
+
+	EnterScope(sink, s_TextFormat, arguments, size, startTicks);
+}
+
 void Context::FlushFile()
 {
-	uint64_t startTicks = Helium::Timer::GetTickCount();
+	uint64_t startTicks = GetTimestamp();
 
 	// make a scope enter packet for flushing the file
 	ScopeEnterPacket* enter = (ScopeEnterPacket*)( m_PacketBuffer + m_PacketBufferOffset );
@@ -289,12 +846,11 @@ void Context::FlushFile()
 
 	enter->m_Header.m_Command = HELIUM_PROFILE_CMD_SCOPE_ENTER;
 	enter->m_Header.m_Size = sizeof(ScopeEnterPacket);
-	enter->m_UniqueID = 0;
-	enter->m_StackDepth = 0;
-	enter->m_Line = __LINE__;
+	enter->m_SinkId = HELIUM_PROFILE_SINK_FLUSH;
+	enter->m_DescriptionId = 0;
+	enter->m_StackDepth = m_StackDepth;
+	enter->m_ArgumentSize = 0;
 	enter->m_StartTicks = startTicks;
-	strcpy(enter->m_Function, "Context::FlushFile");
-	enter->m_Description[0] = 0;
 
 	// make a block end packet for end of packet
 	BlockEndPacket* blockEnd = (BlockEndPacket*)( m_PacketBuffer + m_PacketBufferOffset );
@@ -303,8 +859,17 @@ void Context::FlushFile()
 	blockEnd->m_Header.m_Command = HELIUM_PROFILE_CMD_BLOCK_END;
 	blockEnd->m_Header.m_Size = sizeof(BlockEndPacket);
 
-	// we write the whole buffer, in large blocks
-	m_TraceFile.Write((const char*)m_PacketBuffer, HELIUM_PROFILE_PACKET_BLOCK_SIZE);
+	if ( m_EventWriter )
+	{
+		// convert straight to trace events
+		Helium::MutexScopeLock mutex (g_TraceEventMutex);
+		m_EventWriter->WriteBlock( m_PacketBuffer, m_PacketBufferOffset, g_TraceEventFile );
+	}
+	else
+	{
+		// we write the whole buffer, in large blocks
+		m_TraceFile.Write((const char*)m_PacketBuffer, HELIUM_PROFILE_PACKET_BLOCK_SIZE);
+	}
 
 	// reset the packet buffer
 	m_PacketBufferOffset = 0;
@@ -316,9 +881,8 @@ void Context::FlushFile()
 	exit->m_Header.m_Command = HELIUM_PROFILE_CMD_SCOPE_EXIT;
 	exit->m_Header.m_Size = sizeof(ScopeExitPacket);
 
-	exit->m_UniqueID = 0;
-	exit->m_StackDepth = 0;
-	exit->m_Duration = Helium::Timer::GetTickCount() - startTicks;
+	exit->m_StackDepth = m_StackDepth;
+	exit->m_Duration = GetTimestamp() - startTicks;
 
 	// return to filling out the packet buffer
 }
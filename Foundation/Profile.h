@@ -1,8 +1,12 @@
 #pragma once 
 
+#include <string>
+#include <vector>
+
 #include "Platform/Types.h"
 #include "Platform/File.h"
 #include "Platform/Timer.h"
+#include "Platform/Utility.h"
 
 #include "Foundation/API.h"
 
@@ -13,13 +17,22 @@
 #define HELIUM_PROFILE_SINK_MAX                (2048)
 #define HELIUM_PROFILE_CONTEXTS_MAX            (128)
 
-#define HELIUM_PROFILE_PROTOCOL_VERSION        (0x00)
+#define HELIUM_PROFILE_PROTOCOL_VERSION        (0x02)
 #define HELIUM_PROFILE_SIGNATURE               (0x12345678)
 
 #define HELIUM_PROFILE_CMD_INIT                (0x00)
 #define HELIUM_PROFILE_CMD_SCOPE_ENTER         (0x01)
 #define HELIUM_PROFILE_CMD_SCOPE_EXIT          (0x02)
 #define HELIUM_PROFILE_CMD_BLOCK_END           (0x03)
+#define HELIUM_PROFILE_CMD_THREAD_NAME         (0x04)
+#define HELIUM_PROFILE_CMD_COUNTER             (0x05)
+#define HELIUM_PROFILE_CMD_SINK                (0x06)
+#define HELIUM_PROFILE_CMD_DESCRIPTION         (0x07)
+
+#define HELIUM_PROFILE_SINK_FLUSH              (0)           // pseudo sink for time spent in Context::FlushFile
+#define HELIUM_PROFILE_SINK_UNREGISTERED       (0xffffffff)  // sinks past HELIUM_PROFILE_SINK_MAX, named by description
+#define HELIUM_PROFILE_DESCRIPTIONS_MAX        (4096)        // description formats, further ones are dropped
+#define HELIUM_PROFILE_ARGUMENTS_MAX           (256)         // packed arguments of a description, as Log::EncodeArguments makes them
 
 #define HELIUM_PROFILE_PACKET_STRING_BUFSIZE   (64)
 #define HELIUM_PROFILE_CYCLES_FOR_CONVERSION   (100000)
@@ -34,9 +47,40 @@ namespace Helium
 {
 	namespace Profile
 	{
-		HELIUM_FOUNDATION_API void Startup();
+		//
+		// Trace formats for instrumentation output:
+		//  - packets writes each thread's packet stream to profile.<thread id>.bin (see ExportChromeTrace)
+		//  - chrome writes every thread to a single profile.json in Chrome trace event format, which loads
+		//    directly into chrome://tracing and the Perfetto UI
+		//
+
+		namespace TraceFormats
+		{
+			enum TraceFormat
+			{
+				Packets,
+				Chrome,
+			};
+		}
+		typedef TraceFormats::TraceFormat TraceFormat;
+
+		HELIUM_FOUNDATION_API void Startup( TraceFormat format = TraceFormats::Packets );
 		HELIUM_FOUNDATION_API void Shutdown();
 
+		// name the calling thread in the trace (threads are otherwise named by id)
+		HELIUM_FOUNDATION_API void SetThreadName( const char* name );
+
+		// record a sample for the named counter track
+		HELIUM_FOUNDATION_API void RecordCounter( const char* name, float64_t value );
+
+		// convert packet streams written by Context::FlushFile to a Chrome trace event JSON file
+		HELIUM_FOUNDATION_API bool ExportChromeTrace( const std::vector< std::string >& packetFiles, const std::string& jsonFile );
+
+		// instrumentation time stamps, these read the cpu's time stamp counter directly where we can
+		inline uint64_t GetTimestamp();
+		HELIUM_FOUNDATION_API uint64_t GetTimestampFrequency();
+		HELIUM_FOUNDATION_API float64_t TimestampToMilliseconds( uint64_t timestamp );
+
 		class HELIUM_FOUNDATION_API Sink
 		{
 		public:
@@ -57,21 +101,32 @@ namespace Helium
 			int32_t     m_Index;
 		};
 
+		class Context;
+
 		class HELIUM_FOUNDATION_API Timer
 		{
 		public:
+			// fmt is kept by address and its arguments are only formatted for output, so it must stay valid (use literals)
 			Timer(Sink& sink, const char* fmt = NULL, ...);
 			~Timer();
 
-			char     m_Name[HELIUM_PROFILE_STRING_MAX];
+			const char* m_Format;  // description, NULL for none
+			uint8_t  m_Arguments[HELIUM_PROFILE_ARGUMENTS_MAX];
+			uint32_t m_ArgumentSize;
 			Sink&    m_Sink;
+			Context* m_Context; // the calling thread's context, when instrumenting
 			uint64_t m_StartTicks;
-			uint32_t m_UniqueID;
 
 		private:
 			Timer(const Timer& rhs); // no implementation
 		};
 
+		//
+		// Packet stream, static strings are only sent the first time they are used in each stream so the
+		//  packets written per scope just carry ids, the stack depth and a time stamp. Descriptions are sent as
+		//  their format string, and each scope carries its packed arguments (formatted by ExportChromeTrace).
+		//
+
 		struct Header
 		{
 			uint16_t m_Command;
@@ -84,23 +139,38 @@ namespace Helium
 			uint32_t  m_Version;
 			uint32_t  m_Signature;
 			float32_t m_Conversion; // PROFILE_CYCLES_FOR_CONVERSION cycles -> how many millis?
+			uint64_t  m_TicksPerSecond;
+		};
+
+		struct SinkPacket
+		{
+			Header   m_Header;
+			uint32_t m_SinkId;
+			uint32_t m_Line;
+			char     m_Name[HELIUM_PROFILE_PACKET_STRING_BUFSIZE];
+			char     m_File[HELIUM_PROFILE_PACKET_STRING_BUFSIZE];
+		};
+
+		struct DescriptionPacket
+		{
+			Header   m_Header;
+			uint32_t m_DescriptionId;
+			char     m_Description[HELIUM_PROFILE_STRING_MAX]; // format string
 		};
 
 		struct ScopeEnterPacket
 		{
 			Header   m_Header;
-			uint32_t m_UniqueID;
+			uint32_t m_SinkId;
+			uint32_t m_DescriptionId; // zero for none
 			uint32_t m_StackDepth;
-			uint32_t m_Line;
+			uint32_t m_ArgumentSize;  // bytes of packed arguments for the description following the packet
 			uint64_t m_StartTicks;
-			char     m_Description[HELIUM_PROFILE_PACKET_STRING_BUFSIZE];
-			char     m_Function[HELIUM_PROFILE_PACKET_STRING_BUFSIZE];
 		};
 
 		struct ScopeExitPacket
 		{
 			Header   m_Header;
-			uint32_t m_UniqueID;
 			uint32_t m_StackDepth;
 			uint64_t m_Duration;
 		};
@@ -110,33 +180,66 @@ namespace Helium
 			Header m_Header;
 		};
 
+		struct ThreadNamePacket
+		{
+			Header   m_Header;
+			uint64_t m_ThreadId;
+			char     m_Name[HELIUM_PROFILE_PACKET_STRING_BUFSIZE];
+		};
+
+		struct CounterPacket
+		{
+			Header    m_Header;
+			uint64_t  m_Ticks;
+			float64_t m_Value;
+			char      m_Name[HELIUM_PROFILE_PACKET_STRING_BUFSIZE];
+		};
+
 		union UberPacket
 		{
-			Header           m_Header;
-			InitPacket       m_Init;
-			ScopeEnterPacket m_ScopeEnter;
-			ScopeExitPacket  m_ScopeExitPacket;
+			Header            m_Header;
+			InitPacket        m_Init;
+			SinkPacket        m_Sink;
+			DescriptionPacket m_Description;
+			ScopeEnterPacket  m_ScopeEnter;
+			ScopeExitPacket   m_ScopeExitPacket;
+			ThreadNamePacket  m_ThreadName;
+			CounterPacket     m_Counter;
 		};
 
+		class TraceEventWriter;
+
 		class HELIUM_FOUNDATION_API Context
 		{
 		public:
-			File     m_TraceFile;
-			uint32_t m_UniqueID;
-			uint32_t m_StackDepth;
-			uint32_t m_PacketBufferOffset;
-			uint8_t  m_PacketBuffer[HELIUM_PROFILE_PACKET_BLOCK_SIZE];
-			uint32_t m_SinkStack[HELIUM_PROFILE_SINK_MAX];
+			File              m_TraceFile;
+			char              m_TraceFileName[HELIUM_PROFILE_STRING_MAX];
+			TraceEventWriter* m_EventWriter; // converts packets to trace events when writing the chrome format
+			uint64_t          m_ThreadId;
+			uint32_t          m_StackDepth;
+			uint32_t          m_PacketBufferOffset;
+			uint8_t           m_PacketBuffer[HELIUM_PROFILE_PACKET_BLOCK_SIZE];
+			uint32_t          m_SinkStack[HELIUM_PROFILE_SINK_MAX];
+			uint32_t          m_DefinedSinks[HELIUM_PROFILE_SINK_MAX / 32];
+			uint32_t          m_DefinedDescriptions[HELIUM_PROFILE_DESCRIPTIONS_MAX / 32];
 
 			Context();
 			~Context();
 
+			void SetThreadName(const char* name);
+			void RecordCounter(const char* name, float64_t value);
 			void FlushFile();
 
+			// write the packets for a scope, format may be NULL (it's kept by address, like Timer's) and the arguments
+			//  are packed by Log::EncodeArguments
+			inline void EnterScope(const Sink& sink, const char* format, uint64_t startTicks);
+			inline void EnterScope(const Sink& sink, const char* format, const uint8_t* arguments, uint32_t argumentSize, uint64_t startTicks);
+			inline void ExitScope(uint64_t duration);
+
 			template <class T>
-			T* AllocPacket(uint32_t cmd)
+			T* AllocPacket(uint32_t cmd, uint32_t extraSize = 0)
 			{
-				uint32_t spaceNeeded = sizeof(T) + sizeof(BlockEndPacket) + sizeof(ScopeEnterPacket);
+				uint32_t spaceNeeded = sizeof(T) + extraSize + sizeof(BlockEndPacket) + sizeof(ScopeEnterPacket);
 
 				if ( m_PacketBufferOffset + spaceNeeded >= HELIUM_PROFILE_PACKET_BLOCK_SIZE )
 				{
@@ -144,19 +247,26 @@ namespace Helium
 				}
 
 				T* packet = (T*)( m_PacketBuffer + m_PacketBufferOffset );
-				m_PacketBufferOffset += sizeof(T);
+				m_PacketBufferOffset += sizeof(T) + extraSize;
 
 				//Log::Print("CMD %d OFFSET %d\n", cmd, m_PacketBufferOffset);
 
 				packet->m_Header.m_Command = cmd;
-				packet->m_Header.m_Size = sizeof(T);
+				packet->m_Header.m_Size = sizeof(T) + extraSize;
 
 				return packet;
 			}
+
+		private:
+			void DefineSink(const Sink& sink);
+			uint32_t DefineDescription(const char* format);
+			void EnterUnregisteredScope(const Sink& sink, uint64_t startTicks);
 		};
 	}
 }
 
+#include "Foundation/Profile.inl"
+
 // master profile enable
 #if HELIUM_PROFILE
 # define HELIUM_PROFILE_ENABLE 1
@@ -193,9 +303,13 @@ namespace Helium
 	static Helium::Profile::Sink scopeSink ( HELIUM_FUNCTION_NAME, __FILE__, __LINE__ ); \
 	Helium::Profile::Timer scopeTimer ( scopeSink, __VA_ARGS__ );
 
+# define HELIUM_PROFILE_COUNTER( name, value ) \
+	Helium::Profile::RecordCounter( name, value );
+
 #else
 
 # define HELIUM_PROFILE_FUNCTION_TIMER()
 # define HELIUM_PROFILE_SCOPE_TIMER( ... )
+# define HELIUM_PROFILE_COUNTER( name, value )
 
 #endif
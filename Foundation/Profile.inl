@@ -0,0 +1,69 @@
+#if HELIUM_CPU_X86
+# if HELIUM_CC_CL
+#  include <intrin.h>
+# else
+#  include <x86intrin.h>
+# endif
+#endif
+
+uint64_t Helium::Profile::GetTimestamp()
+{
+#if HELIUM_CPU_X86
+    return __rdtsc();
+#else
+    return Helium::Timer::GetTickCount();
+#endif
+}
+
+void Helium::Profile::Context::EnterScope( const Sink& sink, const char* format, uint64_t startTicks )
+{
+    EnterScope( sink, format, NULL, 0, startTicks );
+}
+
+void Helium::Profile::Context::EnterScope( const Sink& sink, const char* format, const uint8_t* arguments, uint32_t argumentSize, uint64_t startTicks )
+{
+    uint32_t sinkId = HELIUM_PROFILE_SINK_UNREGISTERED;
+    if ( sink.m_Index >= 0 )
+    {
+        sinkId = sink.m_Index + 1;
+        if ( !( m_DefinedSinks[ sink.m_Index >> 5 ] & ( 1u << ( sink.m_Index & 31 ) ) ) )
+        {
+            DefineSink( sink );
+        }
+    }
+    else if ( !format )
+    {
+        // unregistered sinks are described by their name instead
+        EnterUnregisteredScope( sink, startTicks );
+        return;
+    }
+
+    uint32_t descriptionId = 0;
+    if ( format && format[ 0 ] != '\0' )
+    {
+        descriptionId = DefineDescription( format );
+    }
+
+    if ( !descriptionId )
+    {
+        argumentSize = 0;
+    }
+
+    ScopeEnterPacket* enter = AllocPacket< ScopeEnterPacket >( HELIUM_PROFILE_CMD_SCOPE_ENTER, argumentSize );
+    enter->m_SinkId = sinkId;
+    enter->m_DescriptionId = descriptionId;
+    enter->m_StackDepth = m_StackDepth++;
+    enter->m_ArgumentSize = argumentSize;
+    enter->m_StartTicks = startTicks;
+    if ( argumentSize )
+    {
+        MemoryCopy( enter + 1, arguments, argumentSize );
+    }
+}
+
+void Helium::Profile::Context::ExitScope( uint64_t duration )
+{
+    ScopeExitPacket* exit = AllocPacket< ScopeExitPacket >( HELIUM_PROFILE_CMD_SCOPE_EXIT );
+    exit->m_StackDepth = --m_StackDepth;
+    exit->m_Duration = duration;
+}
@@ -0,0 +1,208 @@
+#include "Precompile.h"
+#include "Foundation/Profile.h"
+#include "Foundation/BinaryLog.h"
+
+#include "Platform/Console.h"
+
+#include "gtest/gtest.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+using namespace Helium;
+using namespace Helium::Profile;
+
+static Sink g_OuterSink ( "RecordScopes", __FILE__, __LINE__ );
+static Sink g_InnerSink ( "Inner" );
+
+// descriptions are kept by address, so use one copy of the format
+static const char g_LoadFormat[] = "Load %s #%d (100%%)";
+
+static uint32_t EncodeDescription( uint8_t* arguments, uint32_t argumentsSize, const char* format, ... )
+{
+	uint32_t size = 0;
+	va_list args;
+	va_start( args, format );
+	EXPECT_TRUE( Log::EncodeArguments( format, args, arguments, argumentsSize, size ) );
+	va_end( args );
+	return size;
+}
+
+// record an outer scope containing an inner scope, a counter sample and a described scope, then flush
+static void RecordScopes( Context& context )
+{
+	uint64_t start = GetTimestamp();
+
+	context.EnterScope( g_OuterSink, "Outer \"quoted\"", start );
+	context.EnterScope( g_InnerSink, NULL, start + 10 );
+	context.RecordCounter( "Objects", 42.0 );
+	context.ExitScope( 20 );
+
+	uint8_t arguments[ HELIUM_PROFILE_ARGUMENTS_MAX ];
+	for ( int i = 0; i < 2; ++i )
+	{
+		uint32_t size = EncodeDescription( arguments, sizeof( arguments ), g_LoadFormat, "level", i );
+		context.EnterScope( g_InnerSink, g_LoadFormat, arguments, size, start + 30 + i * 10 );
+		context.ExitScope( 5 );
+	}
+
+	context.ExitScope( 100 );
+
+	context.FlushFile();
+}
+
+static std::string ReadFile( const char* fileName )
+{
+	std::ifstream input ( fileName );
+	std::stringstream contents;
+	contents << input.rdbuf();
+	return contents.str();
+}
+
+static uint32_t CountOccurrences( const std::string& string, const char* pattern )
+{
+	uint32_t count = 0;
+	for ( size_t found = string.find( pattern ); found != std::string::npos; found = string.find( pattern, found + 1 ) )
+	{
+		++count;
+	}
+
+	return count;
+}
+
+static void ExpectTraceEvents( const std::string& json )
+{
+	EXPECT_EQ( 0u, json.find( "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" ) );
+	EXPECT_NE( std::string::npos, json.find( "]}\n", json.length() - 3 ) );
+
+	EXPECT_NE( std::string::npos, json.find( "\"name\":\"thread_name\",\"ph\":\"M\"" ) );
+	EXPECT_NE( std::string::npos, json.find( "\"name\":\"Profile Test\"" ) );
+	EXPECT_NE( std::string::npos, json.find( "\"name\":\"Outer \\\"quoted\\\"\",\"ph\":\"B\"" ) );
+	EXPECT_NE( std::string::npos, json.find( "\"args\":{\"sink\":\"RecordScopes\",\"file\":\"" ) );
+	EXPECT_NE( std::string::npos, json.find( "\"name\":\"Inner\",\"ph\":\"B\"" ) );
+	EXPECT_NE( std::string::npos, json.find( "\"args\":{\"sink\":\"Inner\",\"file\":\"\",\"line\":0}" ) );
+	EXPECT_NE( std::string::npos, json.find( "\"name\":\"Objects\",\"ph\":\"C\"" ) );
+	EXPECT_NE( std::string::npos, json.find( "\"args\":{\"value\":42}" ) );
+
+	// descriptions are formatted from their arguments on the way out
+	EXPECT_EQ( 1u, CountOccurrences( json, "\"name\":\"Load level #0 (100%)\",\"ph\":\"B\"" ) );
+	EXPECT_EQ( 1u, CountOccurrences( json, "\"name\":\"Load level #1 (100%)\",\"ph\":\"B\"" ) );
+
+	// every scope is closed, even the one FlushFile leaves open
+	EXPECT_LE( 4u, CountOccurrences( json, "\"ph\":\"B\"" ) );
+	EXPECT_EQ( CountOccurrences( json, "\"ph\":\"B\"" ), CountOccurrences( json, "\"ph\":\"E\"" ) );
+}
+
+TEST(ProfileTrace, ExportPacketsToChrome)
+{
+	Profile::Startup();
+
+	Context* context = new Context;
+	std::string packetFile = context->m_TraceFileName;
+	context->SetThreadName( "Profile Test" );
+	RecordScopes( *context );
+	delete context;
+
+	Profile::Shutdown();
+
+	std::vector< std::string > packetFiles;
+	packetFiles.push_back( packetFile );
+	ASSERT_TRUE( ExportChromeTrace( packetFiles, "ProfileTraceExport.json" ) );
+
+	ExpectTraceEvents( ReadFile( "ProfileTraceExport.json" ) );
+
+	remove( packetFile.c_str() );
+	remove( "ProfileTraceExport.json" );
+}
+
+TEST(ProfileTrace, WriteChromeDirectly)
+{
+	Profile::Startup( TraceFormats::Chrome );
+
+	Context* context = new Context;
+	EXPECT_STREQ( "profile.json", context->m_TraceFileName );
+	context->SetThreadName( "Profile Test" );
+	RecordScopes( *context );
+	delete context;
+
+	Profile::Shutdown();
+
+	ExpectTraceEvents( ReadFile( "profile.json" ) );
+
+	remove( "profile.json" );
+}
+
+TEST(ProfileTrace, ScopeOverheadBenchmark)
+{
+	const uint32_t scopeCount = 1000000;
+
+	Profile::Startup();
+
+	// reading the clock is a floor on the cost of a scope (it's much slower under virtualization)
+	Helium::SimpleTimer timer;
+	for ( uint32_t i = 0; i < scopeCount; ++i )
+	{
+		GetTimestamp();
+	}
+	float64_t millis = timer.Elapsed();
+
+	Helium::Print( "Profile: %.1f ns/timestamp (%" PRIu64 " Hz)\n", millis * 1000000.0 / scopeCount, GetTimestampFrequency() );
+
+	// the packets written for each scope, whether or not instrumentation is compiled in
+	Context* context = new Context;
+	std::string packetFile = context->m_TraceFileName;
+
+	timer.Reset();
+	for ( uint32_t i = 0; i < scopeCount; ++i )
+	{
+		uint64_t start = GetTimestamp();
+		context->EnterScope( g_InnerSink, NULL, start );
+		context->ExitScope( GetTimestamp() - start );
+	}
+	millis = timer.Elapsed();
+	delete context;
+
+	Helium::Print( "Profile: %u context scopes, %.1f ns/scope\n", scopeCount, millis * 1000000.0 / scopeCount );
+
+	// described scopes pack their arguments, formatting waits for the export
+	context = new Context;
+	packetFile = context->m_TraceFileName;
+
+	timer.Reset();
+	for ( uint32_t i = 0; i < scopeCount; ++i )
+	{
+		uint64_t start = GetTimestamp();
+		uint8_t arguments[ HELIUM_PROFILE_ARGUMENTS_MAX ];
+		uint32_t size = EncodeDescription( arguments, sizeof( arguments ), g_LoadFormat, "level", i );
+		context->EnterScope( g_InnerSink, g_LoadFormat, arguments, size, start );
+		context->ExitScope( GetTimestamp() - start );
+	}
+	millis = timer.Elapsed();
+	delete context;
+
+	Helium::Print( "Profile: %u described context scopes, %.1f ns/scope\n", scopeCount, millis * 1000000.0 / scopeCount );
+
+	// the whole timer, including sink accumulation
+	timer.Reset();
+	for ( uint32_t i = 0; i < scopeCount; ++i )
+	{
+		Profile::Timer scopeTimer ( g_InnerSink );
+	}
+	millis = timer.Elapsed();
+
+	Helium::Print( "Profile: %u timer scopes (instrumentation %s), %.1f ns/scope\n", scopeCount, HELIUM_PROFILE_INSTRUMENTATION ? "on" : "off", millis * 1000000.0 / scopeCount );
+
+	timer.Reset();
+	for ( uint32_t i = 0; i < scopeCount; ++i )
+	{
+		Profile::Timer scopeTimer ( g_InnerSink, g_LoadFormat, "level", i );
+	}
+	millis = timer.Elapsed();
+
+	Helium::Print( "Profile: %u described timer scopes (instrumentation %s), %.1f ns/scope\n", scopeCount, HELIUM_PROFILE_INSTRUMENTATION ? "on" : "off", millis * 1000000.0 / scopeCount );
+
+	Profile::Shutdown();
+	remove( packetFile.c_str() );
+}
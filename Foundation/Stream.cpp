@@ -1,7 +1,11 @@
 #include "Precompile.h"
 #include "Stream.h"
 
+#include "Platform/Exception.h"
 #include "Platform/MemoryHeap.h"
+#include "Platform/Runtime.h"
+#include "Platform/Thread.h"
+#include "Foundation/Compression.h"
 #include "Foundation/Math.h"
 
 using namespace Helium;
@@ -347,6 +351,130 @@ bool BufferedStream::CanSeek() const
     return( m_pStream && m_pStream->CanSeek() );
 }
 
+/// Constructor.
+///
+/// @param[in] pStream     Stream to which buffered data should be written (can be null to leave uninitialized).
+/// @param[in] bufferSize  Size of the buffer, in bytes.  Writes larger than this go straight to the stream.
+BufferedStreamWriter::BufferedStreamWriter( Stream* pStream, size_t bufferSize )
+    : m_pStream( pStream )
+    , m_pBuffer( NULL )
+    , m_bufferSize( bufferSize )
+    , m_bufferedByteCount( 0 )
+{
+    if( bufferSize != 0 )
+    {
+        m_pBuffer = static_cast< uint8_t* >( DefaultAllocator().Allocate( bufferSize ) );
+        HELIUM_ASSERT( m_pBuffer );
+    }
+}
+
+/// Destructor.
+BufferedStreamWriter::~BufferedStreamWriter()
+{
+    Flush();
+
+    DefaultAllocator().Free( m_pBuffer );
+}
+
+/// Assign the stream to write to, any data buffered for the current stream is flushed to it first.
+///
+/// @param[in] pStream  Stream to which buffered data should be written (can be null).
+void BufferedStreamWriter::Open( Stream* pStream )
+{
+    if( pStream != m_pStream )
+    {
+        Flush();
+        m_pStream = pStream;
+    }
+}
+
+/// Overwrite data written earlier (such as a length prefix), without moving the write position.  Data still in the
+/// buffer is patched in place, otherwise the stream is seeked to the offset and back to its end.  Throws if the stream
+/// won't seek there (or back).
+///
+/// @param[in] offset   Stream offset of the data to overwrite.
+/// @param[in] pBuffer  Buffer from which data should be written.
+/// @param[in] size     Number of bytes to write.
+void BufferedStreamWriter::WriteAt( int64_t offset, const void* pBuffer, size_t size )
+{
+    HELIUM_ASSERT( m_pStream );
+
+    int64_t bufferStart = m_pStream->Tell();
+    if( offset >= bufferStart )
+    {
+        size_t bufferOffset = static_cast< size_t >( offset - bufferStart );
+        HELIUM_ASSERT( bufferOffset + size <= m_bufferedByteCount );
+        MemoryCopy( m_pBuffer + bufferOffset, pBuffer, size );
+        return;
+    }
+
+    // written out already, the data can straddle what was flushed and what is still buffered (and a stream that
+    //  can't go back that far, like a compressed one past its first block, would leave the data wrong, so fail)
+    size_t flushedSize = static_cast< size_t >( Min< int64_t >( bufferStart - offset, static_cast< int64_t >( size ) ) );
+    if( m_pStream->Seek( offset, SeekOrigins::Begin ) != offset )
+    {
+        m_pStream->Seek( bufferStart, SeekOrigins::Begin );
+        throw Helium::Exception( "Unable to seek back to offset %" PRId64 " to overwrite data already written", offset );
+    }
+
+    size_t written = m_pStream->Write( pBuffer, 1, flushedSize );
+    if( m_pStream->Seek( bufferStart, SeekOrigins::Begin ) != bufferStart )
+    {
+        throw Helium::Exception( "Unable to seek forward to offset %" PRId64 " after overwriting data", bufferStart );
+    }
+
+    if( written != flushedSize )
+    {
+        throw Helium::Exception( "Unable to overwrite data at offset %" PRId64, offset );
+    }
+
+    if( flushedSize < size )
+    {
+        MemoryCopy( m_pBuffer, static_cast< const uint8_t* >( pBuffer ) + flushedSize, size - flushedSize );
+    }
+}
+
+/// Hand any buffered data to the stream.  This does not flush the stream itself.
+void BufferedStreamWriter::Flush()
+{
+    if( m_bufferedByteCount != 0 )
+    {
+        HELIUM_ASSERT( m_pStream );
+        m_pStream->Write( m_pBuffer, 1, m_bufferedByteCount );
+        m_bufferedByteCount = 0;
+    }
+}
+
+/// Get the stream offset of the next byte to be written, including data still in the buffer.
+///
+/// @return  Current write offset, or -1 if the stream does not support seeking.
+int64_t BufferedStreamWriter::Tell() const
+{
+    HELIUM_ASSERT( m_pStream );
+
+    int64_t offset = m_pStream->Tell();
+    return( offset < 0 ? offset : offset + static_cast< int64_t >( m_bufferedByteCount ) );
+}
+
+/// Slow path of Write(), for data that doesn't fit in what is left of the buffer.
+///
+/// @param[in] pBuffer  Buffer from which data should be written.
+/// @param[in] size     Number of bytes to write.
+void BufferedStreamWriter::WriteBlock( const void* pBuffer, size_t size )
+{
+    Flush();
+
+    if( size < m_bufferSize )
+    {
+        MemoryCopy( m_pBuffer, pBuffer, size );
+        m_bufferedByteCount = size;
+    }
+    else
+    {
+        m_pStream->Write( pBuffer, 1, size );
+    }
+}
+
 /// Constructor.
 ///
 /// @param[in] pStream  Stream around which this stream should be wrapped (can be null to leave uninitialized).
@@ -512,4 +640,701 @@ bool ByteSwappingStream::CanWrite() const
 bool ByteSwappingStream::CanSeek() const
 {
     return ( m_pStream && m_pStream->CanSeek() );
+}
+
+/// Magic number at the start and end of compressed streams ("HLZB").
+static const uint32_t COMPRESSED_STREAM_MAGIC = 'H' | ( 'L' << 8 ) | ( 'Z' << 16 ) | ( 'B' << 24 );
+/// Version of the compressed stream format.
+static const uint32_t COMPRESSED_STREAM_VERSION = 1;
+/// Size of the header (magic, version, block size, reserved), and of the footer (index offset, block count, magic).
+static const size_t COMPRESSED_STREAM_HEADER_SIZE = 16;
+/// Size of each block index entry (offset, compressed size, uncompressed size).
+static const size_t COMPRESSED_STREAM_ENTRY_SIZE = 16;
+/// Largest supported block size, so sizes fit the index and corrupt headers can't ask for huge buffers.
+static const size_t COMPRESSED_STREAM_MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+
+// the compressed stream header, footer, and index are little endian
+static inline void StoreLittleEndian( uint8_t* pDest, uint64_t value, size_t size )
+{
+    for( size_t byteIndex = 0; byteIndex < size; ++byteIndex )
+    {
+        pDest[ byteIndex ] = static_cast< uint8_t >( value >> ( byteIndex * 8 ) );
+    }
+}
+
+static inline uint64_t LoadLittleEndian( const uint8_t* pSource, size_t size )
+{
+    uint64_t value = 0;
+    for( size_t byteIndex = 0; byteIndex < size; ++byteIndex )
+    {
+        value |= static_cast< uint64_t >( pSource[ byteIndex ] ) << ( byteIndex * 8 );
+    }
+
+    return value;
+}
+
+/// Worker thread compressing or decompressing every stride-th task of the current group.
+struct CompressedStream::Worker
+{
+    CompressedStream* m_pStream;
+    size_t            m_first;
+    size_t            m_stride;
+    CallbackThread    m_thread;
+
+    void Run()
+    {
+        m_pStream->ProcessTasks( m_first, m_stride );
+    }
+};
+
+/// Constructor.
+///
+/// @param[in] pStream    Stream around which this stream should be wrapped (can be null to leave uninitialized).
+/// @param[in] mode       Whether to read (decompress) or write (compress) data.
+/// @param[in] blockSize  Uncompressed size of each block when writing.  Reading uses the block size of the data.
+///
+/// @see Open()
+CompressedStream::CompressedStream( Stream* pStream, EMode mode, size_t blockSize )
+    : m_pStream( NULL )
+    , m_mode( mode )
+    , m_blockSize( blockSize )
+    , m_threadCount( 0 )
+    , m_base( 0 )
+    , m_bufferStart( 0 )
+    , m_groupSize( 0 )
+    , m_offset( 0 )
+    , m_position( 0 )
+    , m_size( 0 )
+{
+    if( pStream )
+    {
+        Open( pStream, mode, blockSize );
+    }
+}
+
+/// Destructor.
+CompressedStream::~CompressedStream()
+{
+    Close();
+}
+
+/// Set the stream to compress data to or decompress data from.
+///
+/// Any stream currently assigned will be finished and flushed, but not closed, when changing the stream.  When
+/// writing, the header is written right away.  When reading, the header and block index are read right away (from
+/// the current location of the stream), and an exception is thrown if they are not valid.
+///
+/// @param[in] pStream    Stream around which this stream should be wrapped (can be null to leave uninitialized).
+/// @param[in] mode       Whether to read (decompress) or write (compress) data.
+/// @param[in] blockSize  Uncompressed size of each block when writing.  Reading uses the block size of the data.
+void CompressedStream::Open( Stream* pStream, EMode mode, size_t blockSize )
+{
+    HELIUM_ASSERT( blockSize != 0 && blockSize <= COMPRESSED_STREAM_MAX_BLOCK_SIZE );
+
+    if( m_pStream )
+    {
+        Finish();
+        m_pStream->Flush();
+    }
+
+    m_pStream = pStream;
+    m_mode = mode;
+    m_blockSize = blockSize;
+    m_base = 0;
+    m_blocks.Resize( 0 );
+    m_firstBlock.Resize( 0 );
+    m_buffer.Resize( 0 );
+    m_bufferStart = 0;
+    m_groupSize = 0;
+    m_offset = 0;
+    m_position = 0;
+    m_size = 0;
+
+    if( !IsOpen() )
+    {
+        return;
+    }
+
+    if( mode == MODE_WRITE )
+    {
+        uint8_t header[ COMPRESSED_STREAM_HEADER_SIZE ];
+        StoreLittleEndian( header, COMPRESSED_STREAM_MAGIC, 4 );
+        StoreLittleEndian( header + 4, COMPRESSED_STREAM_VERSION, 4 );
+        StoreLittleEndian( header + 8, blockSize, 4 );
+        StoreLittleEndian( header + 12, 0, 4 );
+        m_pStream->Write( header, 1, sizeof( header ) );
+
+        // the first block is written last, its entry is filled in then
+        Block block;
+        MemoryZero( &block, sizeof( block ) );
+        m_blocks.Push( block );
+
+        m_bufferStart = blockSize;
+        m_offset = sizeof( header );
+    }
+    else
+    {
+        const char* pError = ReadIndex();
+        if( pError )
+        {
+            m_pStream = NULL;
+            m_blocks.Resize( 0 );
+            m_size = 0;
+            throw Helium::Exception( "Unable to open compressed stream: %s", pError );
+        }
+    }
+}
+
+/// Set the number of threads used to compress or decompress a group of blocks at a time.
+///
+/// When writing, this takes effect until the first block past the first one is written.
+///
+/// @param[in] threadCount  Number of threads (including the calling thread), or zero for one per processor.
+void CompressedStream::SetThreadCount( uint32_t threadCount )
+{
+    m_threadCount = threadCount;
+}
+
+/// Get the number of blocks of data in this stream.
+///
+/// @return  Number of blocks written so far, or in the data being read.
+size_t CompressedStream::GetBlockCount() const
+{
+    return static_cast< size_t >( ( m_size + m_blockSize - 1 ) / m_blockSize );
+}
+
+/// Get the uncompressed size of each block (except the last).
+///
+/// @return  Block size, in bytes.
+size_t CompressedStream::GetBlockSize() const
+{
+    return m_blockSize;
+}
+
+/// @copydoc Stream::Close()
+void CompressedStream::Close()
+{
+    if( m_pStream )
+    {
+        Finish();
+        m_pStream->Close();
+        m_pStream = NULL;
+    }
+}
+
+/// @copydoc Stream::IsOpen()
+bool CompressedStream::IsOpen() const
+{
+    return ( m_pStream && m_pStream->IsOpen() );
+}
+
+/// @copydoc Stream::Read()
+size_t CompressedStream::Read( void* pBuffer, size_t size, size_t count )
+{
+    HELIUM_ASSERT( CanRead() );
+    if( !CanRead() || size == 0 || count == 0 )
+    {
+        return 0;
+    }
+
+    uint8_t* pDest = static_cast< uint8_t* >( pBuffer );
+    size_t byteCount = size * count;
+    size_t bytesRead = 0;
+    while( bytesRead < byteCount && m_position < m_size )
+    {
+        if( m_position < m_bufferStart || m_position >= m_bufferStart + m_buffer.GetSize() )
+        {
+            if( !LoadGroup( static_cast< size_t >( m_position / m_blockSize ) ) )
+            {
+                break;
+            }
+        }
+
+        size_t bufferOffset = static_cast< size_t >( m_position - m_bufferStart );
+        size_t copySize = Min( byteCount - bytesRead, m_buffer.GetSize() - bufferOffset );
+        MemoryCopy( pDest + bytesRead, m_buffer.GetData() + bufferOffset, copySize );
+        bytesRead += copySize;
+        m_position += copySize;
+    }
+
+    return bytesRead / size;
+}
+
+/// @copydoc Stream::Write()
+size_t CompressedStream::Write( const void* pBuffer, size_t size, size_t count )
+{
+    HELIUM_ASSERT( CanWrite() );
+    if( !CanWrite() || size == 0 || count == 0 )
+    {
+        return 0;
+    }
+
+    if( m_groupSize == 0 )
+    {
+        m_groupSize = GetThreadCount() * m_blockSize;
+    }
+
+    const uint8_t* pSource = static_cast< const uint8_t* >( pBuffer );
+    size_t byteCount = size * count;
+    size_t bytesWritten = 0;
+    while( bytesWritten < byteCount )
+    {
+        size_t copySize = byteCount - bytesWritten;
+        if( m_position < m_blockSize )
+        {
+            size_t blockOffset = static_cast< size_t >( m_position );
+            copySize = Min( copySize, m_blockSize - blockOffset );
+            if( blockOffset + copySize > m_firstBlock.GetSize() )
+            {
+                m_firstBlock.Resize( blockOffset + copySize );
+            }
+
+            MemoryCopy( m_firstBlock.GetData() + blockOffset, pSource + bytesWritten, copySize );
+        }
+        else
+        {
+            HELIUM_ASSERT( m_position >= m_bufferStart && m_position <= m_bufferStart + m_buffer.GetSize() );
+            size_t bufferOffset = static_cast< size_t >( m_position - m_bufferStart );
+            if( bufferOffset == m_groupSize )
+            {
+                CompressGroup();
+                continue;
+            }
+
+            copySize = Min( copySize, m_groupSize - bufferOffset );
+            if( bufferOffset + copySize > m_buffer.GetSize() )
+            {
+                m_buffer.Resize( bufferOffset + copySize );
+            }
+
+            MemoryCopy( m_buffer.GetData() + bufferOffset, pSource + bytesWritten, copySize );
+        }
+
+        bytesWritten += copySize;
+        m_position += copySize;
+        m_size = Max( m_size, m_position );
+    }
+
+    return count;
+}
+
+/// @copydoc Stream::Flush()
+///
+/// Blocks are only written once a group of them is full, so this only flushes the underlying stream.
+void CompressedStream::Flush()
+{
+    if( m_pStream )
+    {
+        m_pStream->Flush();
+    }
+}
+
+/// @copydoc Stream::Seek()
+///
+/// While writing, seeking fails for locations in blocks that were already compressed (other than the first block).
+int64_t CompressedStream::Seek( int64_t offset, SeekOrigin origin )
+{
+    HELIUM_ASSERT( CanSeek() );
+    if( !CanSeek() )
+    {
+        return -1;
+    }
+
+    int64_t position = offset;
+    if( origin == SeekOrigins::Current )
+    {
+        position += static_cast< int64_t >( m_position );
+    }
+    else if( origin == SeekOrigins::End )
+    {
+        position += static_cast< int64_t >( m_size );
+    }
+
+    if( position < 0 || static_cast< uint64_t >( position ) > m_size )
+    {
+        return -1;
+    }
+
+    if( m_mode == MODE_WRITE && static_cast< uint64_t >( position ) >= m_blockSize && static_cast< uint64_t >( position ) < m_bufferStart )
+    {
+        return -1;
+    }
+
+    m_position = static_cast< uint64_t >( position );
+
+    return position;
+}
+
+/// @copydoc Stream::Tell()
+int64_t CompressedStream::Tell() const
+{
+    return ( IsOpen() ? static_cast< int64_t >( m_position ) : -1 );
+}
+
+/// @copydoc Stream::GetSize()
+///
+/// This is the size of the uncompressed data.
+int64_t CompressedStream::GetSize() const
+{
+    return ( IsOpen() ? static_cast< int64_t >( m_size ) : -1 );
+}
+
+/// @copydoc Stream::CanRead()
+bool CompressedStream::CanRead() const
+{
+    return ( m_mode == MODE_READ && IsOpen() && m_pStream->CanRead() );
+}
+
+/// @copydoc Stream::CanWrite()
+bool CompressedStream::CanWrite() const
+{
+    return ( m_mode == MODE_WRITE && IsOpen() && m_pStream->CanWrite() );
+}
+
+/// @copydoc Stream::CanSeek()
+bool CompressedStream::CanSeek() const
+{
+    return ( IsOpen() && ( m_mode == MODE_WRITE || m_pStream->CanSeek() ) );
+}
+
+/// Read and check the header, footer, and block index of the stream being read.
+///
+/// @return  Null if the stream is valid, or a description of the problem.
+const char* CompressedStream::ReadIndex()
+{
+    if( !m_pStream->CanSeek() )
+    {
+        return "the stream does not support seeking";
+    }
+
+    m_base = m_pStream->Tell();
+
+    uint8_t header[ COMPRESSED_STREAM_HEADER_SIZE ];
+    if( m_pStream->Read( header, 1, sizeof( header ) ) != sizeof( header ) ||
+        LoadLittleEndian( header, 4 ) != COMPRESSED_STREAM_MAGIC )
+    {
+        return "the data is not compressed";
+    }
+
+    if( LoadLittleEndian( header + 4, 4 ) != COMPRESSED_STREAM_VERSION )
+    {
+        return "unsupported version";
+    }
+
+    uint64_t blockSize = LoadLittleEndian( header + 8, 4 );
+    if( blockSize == 0 || blockSize > COMPRESSED_STREAM_MAX_BLOCK_SIZE )
+    {
+        return "invalid block size";
+    }
+
+    m_blockSize = static_cast< size_t >( blockSize );
+
+    uint8_t footer[ COMPRESSED_STREAM_HEADER_SIZE ];
+    int64_t footerOffset = m_pStream->Seek( -static_cast< int64_t >( sizeof( footer ) ), SeekOrigins::End ) - m_base;
+    if( footerOffset < static_cast< int64_t >( sizeof( header ) ) ||
+        m_pStream->Read( footer, 1, sizeof( footer ) ) != sizeof( footer ) ||
+        LoadLittleEndian( footer + 12, 4 ) != COMPRESSED_STREAM_MAGIC )
+    {
+        return "the data is truncated";
+    }
+
+    uint64_t indexOffset = LoadLittleEndian( footer, 8 );
+    uint64_t blockCount = LoadLittleEndian( footer + 8, 4 );
+    if( indexOffset < sizeof( header ) || indexOffset + blockCount * COMPRESSED_STREAM_ENTRY_SIZE != static_cast< uint64_t >( footerOffset ) )
+    {
+        return "invalid block index";
+    }
+
+    DynamicArray< uint8_t > index;
+    index.Resize( static_cast< size_t >( blockCount * COMPRESSED_STREAM_ENTRY_SIZE ) );
+    if( m_pStream->Seek( m_base + indexOffset, SeekOrigins::Begin ) < 0 ||
+        m_pStream->Read( index.GetData(), 1, index.GetSize() ) != index.GetSize() )
+    {
+        return "the data is truncated";
+    }
+
+    size_t compressBound = CompressBound( m_blockSize );
+    m_blocks.Reserve( static_cast< size_t >( blockCount ) );
+    for( size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex )
+    {
+        const uint8_t* pEntry = index.GetData() + blockIndex * COMPRESSED_STREAM_ENTRY_SIZE;
+
+        Block block;
+        block.m_offset = LoadLittleEndian( pEntry, 8 );
+        block.m_compressedSize = static_cast< uint32_t >( LoadLittleEndian( pEntry + 8, 4 ) );
+        block.m_size = static_cast< uint32_t >( LoadLittleEndian( pEntry + 12, 4 ) );
+
+        // every block is full except the last, and its data lies between the header and the index
+        bool bLast = ( blockIndex + 1 == blockCount );
+        if( block.m_size == 0 || block.m_size > m_blockSize || ( !bLast && block.m_size != m_blockSize ) ||
+            block.m_compressedSize > compressBound ||
+            block.m_offset < sizeof( header ) || block.m_offset + block.m_compressedSize > indexOffset )
+        {
+            return "invalid block index";
+        }
+
+        m_blocks.Push( block );
+        m_size += block.m_size;
+    }
+
+    return NULL;
+}
+
+/// Compress the blocks in the write buffer and write them to the underlying stream.
+void CompressedStream::CompressGroup()
+{
+    size_t bufferSize = m_buffer.GetSize();
+    size_t blockCount = ( bufferSize + m_blockSize - 1 ) / m_blockSize;
+    size_t compressBound = CompressBound( m_blockSize );
+    m_compressed.Resize( blockCount * compressBound );
+
+    m_tasks.Resize( 0 );
+    for( size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex )
+    {
+        Task task;
+        task.m_pSource = m_buffer.GetData() + blockIndex * m_blockSize;
+        task.m_sourceSize = Min( m_blockSize, bufferSize - blockIndex * m_blockSize );
+        task.m_pDest = m_compressed.GetData() + blockIndex * compressBound;
+        task.m_destSize = compressBound;
+        task.m_result = 0;
+        m_tasks.Push( task );
+    }
+
+    RunTasks();
+
+    for( size_t taskIndex = 0; taskIndex < m_tasks.GetSize(); ++taskIndex )
+    {
+        WriteBlock( m_blocks.GetSize(), m_tasks[ taskIndex ] );
+    }
+
+    m_bufferStart += bufferSize;
+    m_buffer.Resize( 0 );
+}
+
+/// Write a compressed block (or the uncompressed data, if it didn't compress) and add it to the block index.
+///
+/// @param[in] blockIndex  Index of the block.
+/// @param[in] task        Result of compressing the block.
+void CompressedStream::WriteBlock( size_t blockIndex, const Task& task )
+{
+    Block block;
+    block.m_offset = m_offset;
+    block.m_size = static_cast< uint32_t >( task.m_sourceSize );
+
+    if( task.m_result != 0 && task.m_result < task.m_sourceSize )
+    {
+        block.m_compressedSize = static_cast< uint32_t >( task.m_result );
+        m_pStream->Write( task.m_pDest, 1, task.m_result );
+    }
+    else
+    {
+        block.m_compressedSize = block.m_size;
+        m_pStream->Write( task.m_pSource, 1, task.m_sourceSize );
+    }
+
+    m_offset += block.m_compressedSize;
+
+    if( blockIndex < m_blocks.GetSize() )
+    {
+        m_blocks[ blockIndex ] = block;
+    }
+    else
+    {
+        HELIUM_ASSERT( blockIndex == m_blocks.GetSize() );
+        m_blocks.Push( block );
+    }
+}
+
+/// Write the remaining blocks, the first block, the block index, and the footer, if writing.
+void CompressedStream::Finish()
+{
+    if( m_mode != MODE_WRITE || !IsOpen() )
+    {
+        return;
+    }
+
+    if( !m_buffer.IsEmpty() )
+    {
+        CompressGroup();
+    }
+
+    if( m_firstBlock.IsEmpty() )
+    {
+        m_blocks.Resize( 0 );
+    }
+    else
+    {
+        size_t compressBound = CompressBound( m_firstBlock.GetSize() );
+        m_compressed.Resize( compressBound );
+
+        Task task;
+        task.m_pSource = m_firstBlock.GetData();
+        task.m_sourceSize = m_firstBlock.GetSize();
+        task.m_pDest = m_compressed.GetData();
+        task.m_destSize = compressBound;
+        task.m_result = 0;
+        m_tasks.Resize( 0 );
+        m_tasks.Push( task );
+
+        ProcessTasks( 0, 1 );
+        WriteBlock( 0, m_tasks[ 0 ] );
+    }
+
+    DynamicArray< uint8_t > index;
+    index.Resize( m_blocks.GetSize() * COMPRESSED_STREAM_ENTRY_SIZE + COMPRESSED_STREAM_HEADER_SIZE );
+
+    uint8_t* pEntry = index.GetData();
+    for( size_t blockIndex = 0; blockIndex < m_blocks.GetSize(); ++blockIndex )
+    {
+        const Block& block = m_blocks[ blockIndex ];
+        StoreLittleEndian( pEntry, block.m_offset, 8 );
+        StoreLittleEndian( pEntry + 8, block.m_compressedSize, 4 );
+        StoreLittleEndian( pEntry + 12, block.m_size, 4 );
+        pEntry += COMPRESSED_STREAM_ENTRY_SIZE;
+    }
+
+    StoreLittleEndian( pEntry, m_offset, 8 );
+    StoreLittleEndian( pEntry + 8, m_blocks.GetSize(), 4 );
+    StoreLittleEndian( pEntry + 12, COMPRESSED_STREAM_MAGIC, 4 );
+    m_pStream->Write( index.GetData(), 1, index.GetSize() );
+
+    m_blocks.Resize( 0 );
+    m_firstBlock.Resize( 0 );
+    m_buffer.Resize( 0 );
+    m_compressed.Resize( 0 );
+    m_tasks.Resize( 0 );
+}
+
+/// Read and decompress a group of blocks into the read buffer.
+///
+/// @param[in] blockIndex  Index of the first block of the group.
+///
+/// @return  True if the blocks were loaded, false if they couldn't be read or are corrupt.
+bool CompressedStream::LoadGroup( size_t blockIndex )
+{
+    HELIUM_ASSERT( blockIndex < m_blocks.GetSize() );
+
+    size_t blockCount = Min< size_t >( GetThreadCount(), m_blocks.GetSize() - blockIndex );
+    size_t bufferSize = 0;
+    size_t compressedSize = 0;
+    for( size_t groupIndex = 0; groupIndex < blockCount; ++groupIndex )
+    {
+        const Block& block = m_blocks[ blockIndex + groupIndex ];
+        bufferSize += block.m_size;
+        if( block.m_compressedSize != block.m_size )
+        {
+            compressedSize += block.m_compressedSize;
+        }
+    }
+
+    m_bufferStart = static_cast< uint64_t >( blockIndex ) * m_blockSize;
+    m_buffer.Resize( bufferSize );
+    m_compressed.Resize( compressedSize );
+    m_tasks.Resize( 0 );
+
+    uint8_t* pDest = m_buffer.GetData();
+    uint8_t* pSource = m_compressed.GetData();
+    bool bSuccess = true;
+    for( size_t groupIndex = 0; groupIndex < blockCount && bSuccess; ++groupIndex )
+    {
+        const Block& block = m_blocks[ blockIndex + groupIndex ];
+        bool bCompressed = ( block.m_compressedSize != block.m_size );
+        uint8_t* pRead = ( bCompressed ? pSource : pDest );
+
+        bSuccess = m_pStream->Seek( m_base + static_cast< int64_t >( block.m_offset ), SeekOrigins::Begin ) >= 0 &&
+            m_pStream->Read( pRead, 1, block.m_compressedSize ) == block.m_compressedSize;
+
+        if( bCompressed )
+        {
+            Task task;
+            task.m_pSource = pSource;
+            task.m_sourceSize = block.m_compressedSize;
+            task.m_pDest = pDest;
+            task.m_destSize = block.m_size;
+            task.m_result = 0;
+            m_tasks.Push( task );
+
+            pSource += block.m_compressedSize;
+        }
+
+        pDest += block.m_size;
+    }
+
+    if( bSuccess )
+    {
+        RunTasks();
+
+        for( size_t taskIndex = 0; taskIndex < m_tasks.GetSize(); ++taskIndex )
+        {
+            bSuccess = bSuccess && m_tasks[ taskIndex ].m_result != 0;
+        }
+    }
+
+    if( !bSuccess )
+    {
+        m_buffer.Resize( 0 );
+    }
+
+    return bSuccess;
+}
+
+/// Compress or decompress every task of the current group, using up to the thread count's worth of threads.
+void CompressedStream::RunTasks()
+{
+    size_t threadCount = Min< size_t >( GetThreadCount(), m_tasks.GetSize() );
+    if( threadCount <= 1 )
+    {
+        ProcessTasks( 0, 1 );
+        return;
+    }
+
+    // the calling thread takes the first share
+    Worker* workers = new Worker[ threadCount - 1 ];
+    for( size_t threadIndex = 1; threadIndex < threadCount; ++threadIndex )
+    {
+        Worker& worker = workers[ threadIndex - 1 ];
+        worker.m_pStream = this;
+        worker.m_first = threadIndex;
+        worker.m_stride = threadCount;
+        worker.m_thread.Create( &CallbackThread::EntryHelper< Worker, &Worker::Run >, &worker, "Compressed Stream" );
+    }
+
+    ProcessTasks( 0, threadCount );
+
+    for( size_t threadIndex = 1; threadIndex < threadCount; ++threadIndex )
+    {
+        workers[ threadIndex - 1 ].m_thread.Join();
+    }
+
+    delete [] workers;
+}
+
+/// Compress or decompress every stride-th task of the current group.
+///
+/// @param[in] first   Index of the first task to process.
+/// @param[in] stride  Distance between the tasks to process.
+void CompressedStream::ProcessTasks( size_t first, size_t stride )
+{
+    for( size_t taskIndex = first; taskIndex < m_tasks.GetSize(); taskIndex += stride )
+    {
+        Task& task = m_tasks[ taskIndex ];
+        if( m_mode == MODE_WRITE )
+        {
+            task.m_result = Compress( task.m_pSource, task.m_sourceSize, task.m_pDest, task.m_destSize );
+        }
+        else
+        {
+            task.m_result = Decompress( task.m_pSource, task.m_sourceSize, task.m_pDest, task.m_destSize ) ? 1 : 0;
+        }
+    }
+}
+
+/// Get the number of threads to compress or decompress with.
+///
+/// @return  Thread count, at least one.
+uint32_t CompressedStream::GetThreadCount() const
+{
+    uint32_t threadCount = ( m_threadCount ? m_threadCount : Platform::GetProcessorCount() );
+
+    return Max< uint32_t >( threadCount, 1 );
 }
\ No newline at end of file
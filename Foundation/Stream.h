@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Foundation/API.h"
+#include "Foundation/DynamicArray.h"
 
 #include "Platform/File.h"
 #include "Platform/Utility.h"
@@ -222,6 +223,56 @@ namespace Helium
 		bool m_bReadData;
 	};
 
+	/// Write-only front end that gathers data in a contiguous buffer and hands it to a stream in large blocks.
+	///
+	/// Unlike BufferedStream this is not a Stream itself, so its writes are inlined, and small writes (such as the
+	/// single bytes and tokens written by text and MessagePack serializers) only make a virtual call once the buffer
+	/// fills.  Nothing reaches the stream until Flush(), which is also done when the stream is changed or on
+	/// destruction.
+	class HELIUM_FOUNDATION_API BufferedStreamWriter : NonCopyable
+	{
+	public:
+		/// Default buffer size, in bytes.
+		static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+		/// @name Construction/Destruction
+		//@{
+		explicit BufferedStreamWriter( Stream* pStream = NULL, size_t bufferSize = DEFAULT_BUFFER_SIZE );
+		~BufferedStreamWriter();
+		//@}
+
+		/// @name Stream Assignment
+		//@{
+		void Open( Stream* pStream );
+		inline Stream* GetStream() const;
+		//@}
+
+		/// @name Writing
+		//@{
+		inline void Write( const void* pBuffer, size_t size, size_t count );
+		template< class T > void Write( const T& data );
+
+		void WriteAt( int64_t offset, const void* pBuffer, size_t size );
+		template< class T > void WriteAt( int64_t offset, const T& data );
+
+		void Flush();
+		int64_t Tell() const;
+		//@}
+
+	private:
+		void WriteBlock( const void* pBuffer, size_t size );
+
+		/// Underlying stream.
+		Stream* m_pStream;
+
+		/// Stream buffer.
+		uint8_t* m_pBuffer;
+		/// Stream buffer size.
+		size_t m_bufferSize;
+		/// Number of bytes currently in the buffer.
+		size_t m_bufferedByteCount;
+	};
+
 	/// Stream wrapper that swaps the byte order of chunks of data read from or written to the stream.
 	class HELIUM_FOUNDATION_API ByteSwappingStream : public Stream
 	{
@@ -263,6 +314,141 @@ namespace Helium
 		/// Underlying stream on which to perform byte swapping.
 		Stream* m_pStream;
 	};
+
+	/// Stream wrapper that compresses data in independent blocks, so blocks can be compressed and decompressed in
+	/// parallel and reading can seek straight to the block holding any offset.
+	///
+	/// A compressed stream is either read or written, never both.  Data is compressed a group of blocks at a time
+	/// (one block per thread) as it is written, and the block index is written on Close(), which also closes the
+	/// underlying stream.  While writing, seeking back is only supported within the first block (held back until
+	/// Close() so headers at the start of the data can be filled in) and within the group of blocks not compressed
+	/// yet.  Reading needs a seekable underlying stream.
+	///
+	/// @see Compress(), Decompress()
+	class HELIUM_FOUNDATION_API CompressedStream : public Stream
+	{
+	public:
+		/// Default block size, in bytes.
+		static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+		/// Stream access modes.
+		enum EMode
+		{
+			MODE_READ,   ///< Decompress data read from the underlying stream.
+			MODE_WRITE,  ///< Compress data written to the underlying stream.
+		};
+
+		/// @name Construction/Destruction
+		//@{
+		explicit CompressedStream( Stream* pStream = NULL, EMode mode = MODE_READ, size_t blockSize = DEFAULT_BLOCK_SIZE );
+		virtual ~CompressedStream();
+		//@}
+
+		/// @name Stream Assignment
+		//@{
+		virtual void Open( Stream* pStream, EMode mode = MODE_READ, size_t blockSize = DEFAULT_BLOCK_SIZE );
+		//@}
+
+		/// @name Compression
+		//@{
+		void SetThreadCount( uint32_t threadCount );
+		size_t GetBlockCount() const;
+		size_t GetBlockSize() const;
+		//@}
+
+		/// @name Stream Interface
+		//@{
+		virtual void Close();
+		virtual bool IsOpen() const;
+
+		virtual size_t Read( void* pBuffer, size_t size, size_t count );
+		virtual size_t Write( const void* pBuffer, size_t size, size_t count );
+
+		virtual void Flush();
+
+		virtual int64_t Seek( int64_t offset, SeekOrigin origin );
+		virtual int64_t Tell() const;
+		virtual int64_t GetSize() const;
+		//@}
+
+		/// @name Stream Capabilities
+		//@{
+		virtual bool CanRead() const;
+		virtual bool CanWrite() const;
+		virtual bool CanSeek() const;
+		//@}
+
+	private:
+		/// Location of a block in the underlying stream.
+		struct Block
+		{
+			/// Offset of the compressed data from the start of the compressed stream.
+			uint64_t m_offset;
+			/// Size of the compressed data (the same as the uncompressed size if the block is stored uncompressed).
+			uint32_t m_compressedSize;
+			/// Size of the uncompressed data.
+			uint32_t m_size;
+		};
+
+		/// Block being compressed or decompressed on a worker thread.
+		struct Task
+		{
+			/// Data to (de)compress.
+			const uint8_t* m_pSource;
+			/// Size of the source data.
+			size_t m_sourceSize;
+			/// Buffer for the result.
+			uint8_t* m_pDest;
+			/// Size of the result buffer (the exact uncompressed size when decompressing).
+			size_t m_destSize;
+			/// Compressed size (zero if the block doesn't compress), or nonzero if decompression succeeded.
+			size_t m_result;
+		};
+
+		struct Worker;
+
+		const char* ReadIndex();
+		void CompressGroup();
+		void WriteBlock( size_t blockIndex, const Task& task );
+		void Finish();
+		bool LoadGroup( size_t blockIndex );
+		void RunTasks();
+		void ProcessTasks( size_t first, size_t stride );
+		uint32_t GetThreadCount() const;
+
+		/// Underlying stream.
+		Stream* m_pStream;
+		/// Access mode.
+		EMode m_mode;
+		/// Uncompressed size of each block (except the last).
+		size_t m_blockSize;
+		/// Number of threads to use, or zero for one per processor.
+		uint32_t m_threadCount;
+
+		/// Underlying stream offset of the start of the compressed stream.
+		int64_t m_base;
+		/// Compressed blocks, in order of their uncompressed data.
+		DynamicArray< Block > m_blocks;
+		/// Data of the first block, while writing.
+		DynamicArray< uint8_t > m_firstBlock;
+		/// Uncompressed data of the current group of blocks.
+		DynamicArray< uint8_t > m_buffer;
+		/// Compressed data of the current group of blocks.
+		DynamicArray< uint8_t > m_compressed;
+		/// Blocks of the current group being (de)compressed.
+		DynamicArray< Task > m_tasks;
+		/// Uncompressed offset of the start of m_buffer.
+		uint64_t m_bufferStart;
+		/// Uncompressed size of a group of blocks while writing (fixed once writing starts).
+		size_t m_groupSize;
+		/// Offset of the end of the compressed data written so far, from the start of the compressed stream.
+		uint64_t m_offset;
+
+		/// Current uncompressed offset.
+		uint64_t m_position;
+		/// Total uncompressed size.
+		uint64_t m_size;
+	};
 }
 
 #include "Foundation/Stream.inl"
\ No newline at end of file
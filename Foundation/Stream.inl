@@ -20,4 +20,58 @@ template< class T, size_t N >
 size_t Helium::Stream::Write( const T (&data)[N] )
 {
 	return this->Write( &data, sizeof( T ), N );
+}
+
+/// Get the stream to which buffered data is written.
+///
+/// @return  Current stream.
+Helium::Stream* Helium::BufferedStreamWriter::GetStream() const
+{
+	return m_pStream;
+}
+
+/// Write data to the buffer, flushing it to the stream if it fills up.
+///
+/// @param[in] pBuffer  Buffer from which data should be written.
+/// @param[in] size     Size of each block of data to write.
+/// @param[in] count    Number of blocks to write.
+void Helium::BufferedStreamWriter::Write( const void* pBuffer, size_t size, size_t count )
+{
+	size_t byteCount = size * count;
+	if( m_bufferedByteCount + byteCount <= m_bufferSize )
+	{
+		MemoryCopy( m_pBuffer + m_bufferedByteCount, pBuffer, byteCount );
+		m_bufferedByteCount += byteCount;
+	}
+	else
+	{
+		WriteBlock( pBuffer, byteCount );
+	}
+}
+
+/// Write data to the buffer, flushing it to the stream if it fills up.
+///
+/// @param[in] data  A reference to the data to be written.
+template< class T >
+void Helium::BufferedStreamWriter::Write( const T& data )
+{
+	if( m_bufferedByteCount + sizeof( T ) <= m_bufferSize )
+	{
+		MemoryCopy( m_pBuffer + m_bufferedByteCount, &data, sizeof( T ) );
+		m_bufferedByteCount += sizeof( T );
+	}
+	else
+	{
+		WriteBlock( &data, sizeof( T ) );
+	}
+}
+
+/// Overwrite data written earlier, without moving the write position.
+///
+/// @param[in] offset  Stream offset of the data to overwrite.
+/// @param[in] data    A reference to the data to be written.
+template< class T >
+void Helium::BufferedStreamWriter::WriteAt( int64_t offset, const T& data )
+{
+	WriteAt( offset, &data, sizeof( T ) );
 }
\ No newline at end of file
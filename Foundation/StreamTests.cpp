@@ -0,0 +1,957 @@
+#include "Precompile.h"
+#include "Foundation/AsyncFileStream.h"
+#include "Foundation/Compression.h"
+#include "Foundation/MemoryStream.h"
+#include "Foundation/MessagePack.h"
+
+#include "Platform/Console.h"
+#include "Platform/Exception.h"
+#include "Platform/File.h"
+#include "Platform/Tests.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+using namespace Helium;
+
+// serialized-looking data: runs of names and small numbers, with some noise
+static void MakeTestData( DynamicArray< uint8_t >& data, size_t size, uint32_t seed )
+{
+	static const char* names[] = { "m_Position", "m_Rotation", "m_Scale", "m_Name", "m_Children", "m_Flags" };
+
+	data.Resize( 0 );
+	data.Reserve( size );
+	while ( data.GetSize() < size )
+	{
+		seed = seed * 1664525 + 1013904223;
+		const char* name = names[ ( seed >> 16 ) % HELIUM_ARRAY_COUNT( names ) ];
+		data.AddArray( reinterpret_cast< const uint8_t* >( name ), StringLength( name ) );
+		data.Add( static_cast< uint8_t >( seed >> 24 ), 1 + ( seed >> 8 ) % 3 );
+	}
+
+	data.Resize( size );
+}
+
+static void MakeRandomData( DynamicArray< uint8_t >& data, size_t size, uint32_t seed )
+{
+	data.Resize( size );
+	MakeTestBytes( data.GetData(), size, seed );
+}
+
+static bool RoundTrip( const DynamicArray< uint8_t >& data )
+{
+	DynamicArray< uint8_t > compressed;
+	compressed.Resize( CompressBound( data.GetSize() ) );
+	size_t compressedSize = Compress( data.GetData(), data.GetSize(), compressed.GetData(), compressed.GetSize() );
+	if ( compressedSize == 0 )
+	{
+		return false;
+	}
+
+	DynamicArray< uint8_t > decompressed;
+	decompressed.Resize( data.GetSize() );
+	return Decompress( compressed.GetData(), compressedSize, decompressed.GetData(), decompressed.GetSize() ) &&
+		MemoryCompare( data.GetData(), decompressed.GetData(), data.GetSize() ) == 0;
+}
+
+TEST(Stream, BufferedWriterMatchesStream)
+{
+	DynamicArray< uint8_t > expected;
+	DynamicArray< uint8_t > actual;
+	DynamicMemoryStream expectedStream ( &expected );
+	DynamicMemoryStream actualStream ( &actual );
+
+	// a tiny buffer, so writes land inside it, straddle it, and skip it
+	BufferedStreamWriter writer ( &actualStream, 16 );
+
+	uint8_t block[ 40 ];
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( block ); ++i )
+	{
+		block[ i ] = static_cast< uint8_t >( i );
+	}
+
+	for ( uint32_t i = 0; i < 100; ++i )
+	{
+		uint32_t value = i * 7;
+		size_t size = i % HELIUM_ARRAY_COUNT( block );
+
+		static_cast< Stream& >( expectedStream ).Write( value );
+		expectedStream.Write( block, 1, size );
+		writer.Write( value );
+		writer.Write( block, 1, size );
+
+		EXPECT_EQ( expectedStream.Tell(), writer.Tell() );
+	}
+
+	writer.Flush();
+	ASSERT_EQ( expected.GetSize(), actual.GetSize() );
+	EXPECT_EQ( 0, MemoryCompare( expected.GetData(), actual.GetData(), expected.GetSize() ) );
+}
+
+TEST(Stream, BufferedWriterWriteAt)
+{
+	DynamicArray< uint8_t > data;
+	DynamicMemoryStream stream ( &data );
+	BufferedStreamWriter writer ( &stream, 16 );
+
+	// still buffered
+	writer.Write< uint32_t >( 0 );
+	writer.Write< uint32_t >( 0 );
+	writer.WriteAt< uint32_t >( 4, 0x11111111 );
+	EXPECT_EQ( 0u, data.GetSize() );
+
+	// already flushed, and straddling what was flushed and what is still buffered
+	writer.Write< uint32_t >( 0 );
+	writer.Write< uint32_t >( 0 );
+	writer.Write< uint32_t >( 0 );
+	writer.Write< uint32_t >( 0 );
+	EXPECT_EQ( 16u, data.GetSize() );
+	writer.WriteAt< uint32_t >( 0, 0x22222222 );
+	writer.WriteAt< uint32_t >( 14, 0x33333333 );
+	EXPECT_EQ( 24, writer.Tell() );
+
+	writer.Write< uint32_t >( 0x44444444 );
+	writer.Flush();
+
+	const uint32_t expected[] = { 0x22222222, 0x11111111, 0, 0x33330000, 0x00003333, 0, 0x44444444 };
+	ASSERT_EQ( sizeof( expected ), data.GetSize() );
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( expected ); ++i )
+	{
+		uint32_t value;
+		MemoryCopy( &value, data.GetData() + i * sizeof( value ), sizeof( value ) );
+#if !HELIUM_ENDIAN_LITTLE
+		value = ( value >> 16 ) | ( value << 16 );
+#endif
+		EXPECT_EQ( expected[ i ], value );
+	}
+}
+
+TEST(Stream, BufferedWriterWriteAtRefused)
+{
+	DynamicArray< uint8_t > compressed;
+	DynamicMemoryStream stream ( &compressed );
+	CompressedStream compressor;
+	compressor.Open( &stream, CompressedStream::MODE_WRITE, 1024 );
+	BufferedStreamWriter writer ( &compressor, 16 );
+
+	DynamicArray< uint8_t > data;
+	MakeTestData( data, 4096, 3 );
+	writer.Write( data.GetData(), 1, data.GetSize() );
+	writer.Flush();
+
+	// the first block is kept to patch, the ones after it were compressed already and can't be
+	writer.WriteAt< uint32_t >( 0, 0x11111111 );
+	EXPECT_THROW( writer.WriteAt< uint32_t >( 1500, 0x22222222 ), Helium::Exception );
+	EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), compressor.Tell() );
+
+	writer.Write< uint32_t >( 0x33333333 );
+	writer.Flush();
+	EXPECT_EQ( static_cast< int64_t >( data.GetSize() + 4 ), compressor.GetSize() );
+	compressor.Close();
+}
+
+TEST(Stream, BufferedWriterBenchmark)
+{
+	const size_t byteCount = 64 * 1024 * 1024;
+	DynamicArray< uint8_t > data;
+	data.Reserve( byteCount );
+	DynamicMemoryStream stream ( &data );
+
+	// a byte at a time, like rapidjson's output stream
+	Stream* pStream = &stream;
+	SimpleTimer timer;
+	for ( size_t i = 0; i < byteCount; ++i )
+	{
+		pStream->Write< char >( static_cast< char >( i ) );
+	}
+	float64_t streamMillis = timer.Elapsed();
+	EXPECT_EQ( byteCount, data.GetSize() );
+
+	data.Resize( 0 );
+	stream.Seek( 0, SeekOrigins::Begin );
+
+	timer.Reset();
+	{
+		BufferedStreamWriter writer ( &stream );
+		for ( size_t i = 0; i < byteCount; ++i )
+		{
+			writer.Write< char >( static_cast< char >( i ) );
+		}
+	}
+	float64_t bufferedMillis = timer.Elapsed();
+	EXPECT_EQ( byteCount, data.GetSize() );
+
+	// MessagePack, a map of small values
+	data.Resize( 0 );
+	stream.Seek( 0, SeekOrigins::Begin );
+
+	timer.Reset();
+	{
+		MessagePackWriter writer ( &stream );
+		writer.BeginArray();
+		while ( data.GetSize() + BufferedStreamWriter::DEFAULT_BUFFER_SIZE < byteCount )
+		{
+			for ( uint32_t i = 0; i < 1024; ++i )
+			{
+				writer.BeginMap();
+				writer.Write( "value" );
+				writer.Write( i );
+				writer.Write( "scale" );
+				writer.Write( 0.5f * i );
+				writer.EndMap();
+			}
+		}
+		writer.EndArray();
+	}
+	float64_t messagePackMillis = timer.Elapsed();
+
+	const float64_t megabytes = byteCount / ( 1024.0 * 1024.0 );
+	Helium::Print( "Stream: %.0f MB/s writing a byte at a time, %.0f MB/s buffered, %.0f MB/s MessagePack\n",
+		megabytes / ( streamMillis / 1000.0 ), megabytes / ( bufferedMillis / 1000.0 ), ( data.GetSize() / ( 1024.0 * 1024.0 ) ) / ( messagePackMillis / 1000.0 ) );
+}
+
+TEST(Stream, CompressRoundTrip)
+{
+	DynamicArray< uint8_t > data;
+	EXPECT_TRUE( RoundTrip( data ) );
+
+	// around the minimum sizes for matches
+	for ( size_t size = 1; size < 64; ++size )
+	{
+		MakeTestData( data, size, static_cast< uint32_t >( size ) );
+		EXPECT_TRUE( RoundTrip( data ) ) << size;
+
+		data.Resize( 0 );
+		data.Add( 'a', size );
+		EXPECT_TRUE( RoundTrip( data ) ) << size;
+	}
+
+	MakeTestData( data, 1024 * 1024, 1 );
+	EXPECT_TRUE( RoundTrip( data ) );
+
+	// long runs, and offsets past the 64KB window
+	data.Resize( 0 );
+	data.Add( 0, 300000 );
+	EXPECT_TRUE( RoundTrip( data ) );
+
+	MakeRandomData( data, 100000, 2 );
+	data.AddArray( data.GetData(), data.GetSize() );
+	EXPECT_TRUE( RoundTrip( data ) );
+
+	MakeRandomData( data, 1024 * 1024, 3 );
+	EXPECT_TRUE( RoundTrip( data ) );
+}
+
+TEST(Stream, CompressRejectsBadInput)
+{
+	DynamicArray< uint8_t > data;
+	MakeTestData( data, 4096, 4 );
+
+	DynamicArray< uint8_t > compressed;
+	compressed.Resize( CompressBound( data.GetSize() ) );
+	size_t compressedSize = Compress( data.GetData(), data.GetSize(), compressed.GetData(), compressed.GetSize() );
+	ASSERT_NE( 0u, compressedSize );
+	EXPECT_LT( compressedSize, data.GetSize() );
+
+	// too small a destination
+	EXPECT_EQ( 0u, Compress( data.GetData(), data.GetSize(), compressed.GetData(), compressedSize - 1 ) );
+	compressedSize = Compress( data.GetData(), data.GetSize(), compressed.GetData(), compressed.GetSize() );
+
+	DynamicArray< uint8_t > decompressed;
+	decompressed.Resize( data.GetSize() );
+	EXPECT_FALSE( Decompress( compressed.GetData(), compressedSize, decompressed.GetData(), data.GetSize() - 1 ) );
+	EXPECT_FALSE( Decompress( compressed.GetData(), compressedSize, decompressed.GetData(), data.GetSize() + 1 ) );
+
+	// truncated anywhere, or with any byte changed, it fails or stays in bounds
+	for ( size_t size = 0; size < compressedSize; ++size )
+	{
+		EXPECT_FALSE( Decompress( compressed.GetData(), size, decompressed.GetData(), data.GetSize() ) );
+	}
+
+	for ( size_t i = 0; i < compressedSize; ++i )
+	{
+		uint8_t value = compressed[ i ];
+		compressed[ i ] = ~value;
+		Decompress( compressed.GetData(), compressedSize, decompressed.GetData(), data.GetSize() );
+		compressed[ i ] = value;
+	}
+
+	// a match before the start of the data
+	const uint8_t badOffset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+	EXPECT_FALSE( Decompress( badOffset, sizeof( badOffset ), decompressed.GetData(), 5 ) );
+}
+
+TEST(Stream, CompressedStreamRoundTrip)
+{
+	DynamicArray< uint8_t > data;
+	MakeTestData( data, 100000, 5 );
+
+	DynamicArray< uint8_t > compressed;
+	{
+		DynamicMemoryStream stream ( &compressed );
+		CompressedStream writer;
+		writer.SetThreadCount( 3 );
+		writer.Open( &stream, CompressedStream::MODE_WRITE, 1024 );
+
+		// a placeholder to fill in at the end, like an archive header
+		uint32_t placeholder = 0;
+		writer.Write( &placeholder, sizeof( placeholder ), 1 );
+		for ( size_t offset = 4; offset < data.GetSize(); )
+		{
+			size_t size = Min< size_t >( data.GetSize() - offset, 1 + offset % 3000 );
+			EXPECT_EQ( 1u, writer.Write( data.GetData() + offset, size, 1 ) );
+			offset += size;
+		}
+
+		EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), writer.GetSize() );
+		EXPECT_EQ( ( data.GetSize() + 1023 ) / 1024, writer.GetBlockCount() );
+
+		// the first block can still be changed, blocks already compressed can't
+		EXPECT_EQ( 0, writer.Seek( 0, SeekOrigins::Begin ) );
+		writer.Write( data.GetData(), 1, 4 );
+		EXPECT_EQ( -1, writer.Seek( 2048, SeekOrigins::Begin ) );
+		EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), writer.Seek( 0, SeekOrigins::End ) );
+		writer.Close();
+	}
+
+	EXPECT_LT( compressed.GetSize(), data.GetSize() );
+
+	StaticMemoryStream stream ( compressed.GetData(), compressed.GetSize() );
+	CompressedStream reader;
+	reader.SetThreadCount( 2 );
+	reader.Open( &stream );
+	ASSERT_TRUE( reader.IsOpen() );
+	EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), reader.GetSize() );
+	EXPECT_EQ( 1024u, reader.GetBlockSize() );
+
+	DynamicArray< uint8_t > decompressed;
+	decompressed.Resize( data.GetSize() );
+	EXPECT_EQ( 1u, reader.Read( decompressed.GetData(), decompressed.GetSize(), 1 ) );
+	EXPECT_EQ( 0, MemoryCompare( data.GetData(), decompressed.GetData(), data.GetSize() ) );
+	EXPECT_EQ( 0u, reader.Read( decompressed.GetData(), 1, 1 ) );
+
+	// random access
+	for ( uint32_t i = 0; i < 100; ++i )
+	{
+		size_t offset = ( i * 7919 ) % data.GetSize();
+		size_t size = Min< size_t >( data.GetSize() - offset, 1 + i * 37 );
+		EXPECT_EQ( static_cast< int64_t >( offset ), reader.Seek( offset, SeekOrigins::Begin ) );
+		EXPECT_EQ( size, reader.Read( decompressed.GetData(), 1, size ) );
+		EXPECT_EQ( 0, MemoryCompare( data.GetData() + offset, decompressed.GetData(), size ) );
+	}
+
+	// a damaged block can't be read
+	compressed[ 40 ] = ~compressed[ 40 ];
+	reader.Seek( 0, SeekOrigins::Begin );
+	EXPECT_EQ( 0u, reader.Read( decompressed.GetData(), decompressed.GetSize(), 1 ) );
+	compressed[ 40 ] = ~compressed[ 40 ];
+
+	// nor data that was never compressed
+	StaticMemoryStream plain ( data.GetData(), data.GetSize() );
+	EXPECT_THROW( reader.Open( &plain ), Helium::Exception );
+	EXPECT_FALSE( reader.IsOpen() );
+}
+
+TEST(Stream, CompressedStreamBenchmark)
+{
+	const size_t byteCount = 64 * 1024 * 1024;
+	DynamicArray< uint8_t > data;
+	DynamicArray< uint8_t > compressed;
+	DynamicArray< uint8_t > decompressed;
+	decompressed.Resize( byteCount );
+
+	// MessagePack, a map of small values (as in the writer benchmark), then data that doesn't compress
+	{
+		DynamicMemoryStream stream ( &data );
+		MessagePackWriter writer ( &stream );
+		writer.BeginArray();
+		for ( uint32_t i = 0; data.GetSize() + BufferedStreamWriter::DEFAULT_BUFFER_SIZE < byteCount; ++i )
+		{
+			writer.BeginMap();
+			writer.Write( "value" );
+			writer.Write( i );
+			writer.Write( "scale" );
+			writer.Write( 0.5f * i );
+			writer.EndMap();
+		}
+		writer.EndArray();
+	}
+
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		if ( pass == 1 )
+		{
+			MakeRandomData( data, byteCount, 6 );
+		}
+
+		compressed.Resize( 0 );
+		SimpleTimer timer;
+		{
+			DynamicMemoryStream stream ( &compressed );
+			CompressedStream writer ( &stream, CompressedStream::MODE_WRITE );
+			writer.Write( data.GetData(), 1, data.GetSize() );
+		}
+		float64_t compressMillis = timer.Elapsed();
+
+		timer.Reset();
+		{
+			StaticMemoryStream stream ( compressed.GetData(), compressed.GetSize() );
+			CompressedStream reader ( &stream );
+			EXPECT_EQ( data.GetSize(), reader.Read( decompressed.GetData(), 1, data.GetSize() ) );
+		}
+		float64_t decompressMillis = timer.Elapsed();
+		EXPECT_EQ( 0, MemoryCompare( data.GetData(), decompressed.GetData(), data.GetSize() ) );
+
+		const float64_t megabytes = data.GetSize() / ( 1024.0 * 1024.0 );
+		Helium::Print( "CompressedStream: %s data, ratio %.2f, %.0f MB/s compressing, %.0f MB/s decompressing\n",
+			pass == 0 ? "MessagePack" : "random", static_cast< float64_t >( data.GetSize() ) / compressed.GetSize(),
+			megabytes / ( compressMillis / 1000.0 ), megabytes / ( decompressMillis / 1000.0 ) );
+	}
+}
+
+// a document exercising fixed and sized types of each kind, and containers to skip
+static void WriteTestDocument( DynamicArray< uint8_t >& data, const uint8_t* rawBytes, uint32_t rawSize )
+{
+	data.Resize( 0 );
+	DynamicMemoryStream stream ( &data );
+	MessagePackWriter writer ( &stream );
+	writer.BeginArray( 100 );
+	for ( uint32_t i = 0; i < 100; ++i )
+	{
+		writer.BeginMap( 5 );
+		writer.Write( "value" );
+		writer.Write( static_cast< uint64_t >( i ) * i * i * i * i );
+		writer.Write( "scale" );
+		writer.Write( -0.5f * i );
+		writer.Write( "raw" );
+		writer.WriteRaw( rawBytes, rawSize );
+		writer.Write( "a long name that doesn't fit in a fixed size raw" );
+		writer.BeginArray( 2 );
+		writer.Write( 1.0 );
+		writer.BeginMap( 1 );
+		writer.Write( "nested" );
+		writer.Write( i );
+		writer.EndMap();
+		writer.EndArray();
+		writer.Write( "offset" );
+		writer.Write( -static_cast< int32_t >( i ) * 1000 );
+		writer.EndMap();
+	}
+	writer.EndArray();
+}
+
+static void ReadTestDocument( MessagePackReader& reader, const uint8_t* rawBytes, uint32_t rawSize )
+{
+	reader.Advance();
+	ASSERT_TRUE( reader.IsArray() );
+	uint32_t length = reader.ReadArrayLength();
+	EXPECT_EQ( 100u, length );
+	reader.BeginArray( length );
+
+	for ( uint32_t i = 0; i < length; ++i )
+	{
+		ASSERT_TRUE( reader.IsMap() );
+		uint32_t fieldCount = reader.ReadMapLength();
+		EXPECT_EQ( 5u, fieldCount );
+		reader.BeginMap( fieldCount );
+
+		const char* chars = NULL;
+		EXPECT_EQ( 5u, reader.ReadString( chars ) );
+		EXPECT_EQ( 0, MemoryCompare( chars, "value", 5 ) );
+		uint64_t value = 0;
+		reader.ReadNumber( value, false, NULL );
+		EXPECT_EQ( static_cast< uint64_t >( i ) * i * i * i * i, value );
+
+		String name;
+		reader.Read( name );
+		EXPECT_STREQ( "scale", name.GetData() );
+		float32_t scale = 0.f;
+		reader.Read( scale, NULL );
+		EXPECT_EQ( -0.5f * i, scale );
+
+		reader.Read( name );
+		EXPECT_STREQ( "raw", name.GetData() );
+		uint32_t size = reader.ReadRawLength();
+		EXPECT_EQ( rawSize, size );
+		EXPECT_EQ( 0, MemoryCompare( rawBytes, reader.ReadRawView( size ), size ) );
+
+		reader.Skip();
+		reader.Skip();
+
+		reader.Read( name );
+		int32_t offset = 0;
+		reader.Read( offset, NULL );
+		EXPECT_EQ( -static_cast< int32_t >( i ) * 1000, offset );
+
+		reader.EndMap();
+	}
+
+	reader.EndArray();
+}
+
+TEST(Stream, MessagePackReaderBuffer)
+{
+	uint8_t raw[ 300 ];
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( raw ); ++i )
+	{
+		raw[ i ] = static_cast< uint8_t >( i * 3 );
+	}
+
+	// a fixed size raw and a Raw16
+	const uint32_t rawSizes[] = { 20, sizeof( raw ) };
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( rawSizes ); ++i )
+	{
+		DynamicArray< uint8_t > data;
+		WriteTestDocument( data, raw, rawSizes[ i ] );
+
+		StaticMemoryStream stream ( data.GetData(), data.GetSize() );
+		MessagePackReader streamReader ( &stream );
+		EXPECT_FALSE( streamReader.IsBuffered() );
+		ReadTestDocument( streamReader, raw, rawSizes[ i ] );
+		EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), streamReader.Tell() );
+
+		MessagePackReader bufferReader ( data.GetData(), data.GetSize() );
+		EXPECT_TRUE( bufferReader.IsBuffered() );
+		ReadTestDocument( bufferReader, raw, rawSizes[ i ] );
+		EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), bufferReader.Tell() );
+
+		// values running off the end of the buffer throw instead of reading past it
+		bufferReader.SetBuffer( data.GetData(), data.GetSize() - 2 );
+		EXPECT_THROW( ReadTestDocument( bufferReader, raw, rawSizes[ i ] ), Helium::Exception );
+	}
+}
+
+TEST(Stream, MessagePackReaderBenchmark)
+{
+	const size_t byteCount = 32 * 1024 * 1024;
+	DynamicArray< uint8_t > data;
+	data.Reserve( byteCount );
+
+	// objects like archives write, a map of named fields
+	uint32_t objectCount = 0;
+	{
+		DynamicMemoryStream stream ( &data );
+		MessagePackWriter writer ( &stream );
+		writer.BeginArray();
+		for ( ; data.GetSize() + BufferedStreamWriter::DEFAULT_BUFFER_SIZE < byteCount; ++objectCount )
+		{
+			writer.BeginMap( 3 );
+			writer.Write( "m_Value" );
+			writer.Write( objectCount );
+			writer.Write( "m_Scale" );
+			writer.Write( 0.5f * objectCount );
+			writer.Write( "m_Name" );
+			writer.Write( "object" );
+			writer.EndMap();
+		}
+		writer.EndArray();
+	}
+
+	float64_t millis[ 2 ];
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		StaticMemoryStream stream ( data.GetData(), data.GetSize() );
+		MessagePackReader reader ( &stream );
+		if ( pass == 1 )
+		{
+			reader.SetBuffer( data.GetData(), data.GetSize() );
+		}
+
+		SimpleTimer timer;
+		uint32_t sum = 0;
+		String str;
+		reader.Advance();
+		uint32_t length = reader.ReadArrayLength();
+		reader.BeginArray( length );
+		for ( uint32_t i = 0; i < length; ++i )
+		{
+			uint32_t fieldCount = reader.ReadMapLength();
+			reader.BeginMap( fieldCount );
+			for ( uint32_t j = 0; j < fieldCount; ++j )
+			{
+				// field names as the archive reader reads them
+				const char* chars = NULL;
+				sum += reader.ReadString( chars );
+				if ( reader.IsNumber() )
+				{
+					float64_t value = 0.0;
+					reader.ReadNumber( value, true, NULL );
+					sum += static_cast< uint32_t >( value );
+				}
+				else
+				{
+					reader.Read( str );
+					sum += static_cast< uint32_t >( str.GetSize() );
+				}
+			}
+			reader.EndMap();
+		}
+		reader.EndArray();
+		millis[ pass ] = timer.Elapsed();
+
+		EXPECT_EQ( objectCount, length );
+		EXPECT_NE( 0u, sum );
+	}
+
+	const float64_t megabytes = data.GetSize() / ( 1024.0 * 1024.0 );
+	Helium::Print( "MessagePackReader: %.0f MB/s from a stream, %.0f MB/s from a buffer\n",
+		megabytes / ( millis[ 0 ] / 1000.0 ), megabytes / ( millis[ 1 ] / 1000.0 ) );
+}
+
+TEST(Stream, MessagePackExt)
+{
+	uint8_t bytes[ 70000 ];
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( bytes ); ++i )
+	{
+		bytes[ i ] = static_cast< uint8_t >( i * 7 );
+	}
+
+	// each fixed size, then Ext8, Ext16, and Ext32, with a number after each to check the lengths
+	const uint32_t sizes[] = { 1, 2, 4, 8, 16, 0, 3, 300, sizeof( bytes ) };
+	const uint32_t count = HELIUM_ARRAY_COUNT( sizes );
+
+	DynamicArray< uint8_t > data;
+	{
+		DynamicMemoryStream stream ( &data );
+		MessagePackWriter writer ( &stream );
+		writer.BeginArray( count * 2 );
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			writer.WriteExt( static_cast< int8_t >( i - 4 ), bytes, sizes[ i ] );
+			writer.Write( i );
+		}
+		writer.EndArray();
+	}
+
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		StaticMemoryStream stream ( data.GetData(), data.GetSize() );
+		MessagePackReader reader ( &stream );
+		if ( pass == 1 )
+		{
+			reader.SetBuffer( data.GetData(), data.GetSize() );
+		}
+
+		reader.Advance();
+		uint32_t length = reader.ReadArrayLength();
+		EXPECT_EQ( count * 2, length );
+		reader.BeginArray( length );
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			ASSERT_TRUE( reader.IsExt() );
+			EXPECT_FALSE( reader.IsRaw() );
+
+			// skip every other one
+			if ( i % 2 )
+			{
+				reader.Skip();
+			}
+			else
+			{
+				int8_t extType = 0;
+				uint32_t size = reader.ReadExtLength( extType );
+				EXPECT_EQ( static_cast< int8_t >( i - 4 ), extType );
+				ASSERT_EQ( sizes[ i ], size );
+				EXPECT_EQ( 0, MemoryCompare( bytes, reader.ReadRawView( size ), size ) );
+			}
+
+			uint32_t value = 0;
+			reader.Read( value, NULL );
+			EXPECT_EQ( i, value );
+		}
+		reader.EndArray();
+		EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), reader.Tell() );
+	}
+}
+
+TEST(Stream, MessagePackFixnums)
+{
+	// the fixnum edges and the smallest sized numbers past them, each followed by a marker to check the position
+	const int32_t values[] = { 0, 1, 127, -1, -32, 128, -33, 255, -128 };
+	const uint32_t count = HELIUM_ARRAY_COUNT( values );
+
+	DynamicArray< uint8_t > data;
+	{
+		DynamicMemoryStream stream ( &data );
+		MessagePackWriter writer ( &stream );
+		writer.BeginArray( count * 2 );
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			writer.Write( values[ i ] );
+			writer.Write( "marker" );
+		}
+		writer.EndArray();
+	}
+
+	// from a stream and from a buffer, with ReadNumber and with Read
+	for ( uint32_t pass = 0; pass < 4; ++pass )
+	{
+		StaticMemoryStream stream ( data.GetData(), data.GetSize() );
+		MessagePackReader reader ( &stream );
+		if ( pass & 1 )
+		{
+			reader.SetBuffer( data.GetData(), data.GetSize() );
+		}
+
+		reader.Advance();
+		uint32_t length = reader.ReadArrayLength();
+		EXPECT_EQ( count * 2, length );
+		reader.BeginArray( length );
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			ASSERT_TRUE( reader.IsNumber() );
+			int32_t value = 0;
+			if ( pass & 2 )
+			{
+				reader.Read( value, NULL );
+			}
+			else
+			{
+				reader.ReadNumber( value, false, NULL );
+			}
+			EXPECT_EQ( values[ i ], value );
+
+			ASSERT_TRUE( reader.IsRaw() );
+			String marker;
+			reader.Read( marker );
+			EXPECT_STREQ( "marker", marker.GetData() );
+		}
+		reader.EndArray();
+		EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), reader.Tell() );
+	}
+}
+
+TEST(Stream, MessagePackRaws)
+{
+	uint8_t bytes[ 70000 ];
+	MakeTestBytes( bytes, sizeof( bytes ), 7 );
+
+	// empty, each edge of the fixed size, Raw16, and Raw32 lengths, as raws then as strings
+	const uint32_t sizes[] = { 0, 1, 31, 32, 65535, 65536, sizeof( bytes ) };
+	const uint32_t count = HELIUM_ARRAY_COUNT( sizes );
+
+	std::string strings[ count ];
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		strings[ i ].assign( sizes[ i ], 'a' + static_cast< char >( i ) );
+	}
+
+	DynamicArray< uint8_t > data;
+	{
+		DynamicMemoryStream stream ( &data );
+		MessagePackWriter writer ( &stream );
+		writer.BeginArray( count * 2 );
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			writer.WriteRaw( bytes, sizes[ i ] );
+			writer.Write( strings[ i ].c_str() );
+		}
+		writer.EndArray();
+	}
+
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		StaticMemoryStream stream ( data.GetData(), data.GetSize() );
+		MessagePackReader reader ( &stream );
+		if ( pass == 1 )
+		{
+			reader.SetBuffer( data.GetData(), data.GetSize() );
+		}
+
+		reader.Advance();
+		uint32_t length = reader.ReadArrayLength();
+		EXPECT_EQ( count * 2, length );
+		reader.BeginArray( length );
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			DynamicArray< uint8_t > raw;
+			raw.Resize( reader.ReadRawLength() );
+			ASSERT_EQ( sizes[ i ], raw.GetSize() );
+			reader.ReadRaw( raw.GetData(), sizes[ i ] );
+			EXPECT_EQ( 0, MemoryCompare( bytes, raw.GetData(), sizes[ i ] ) );
+
+			String string;
+			reader.Read( string );
+			EXPECT_EQ( sizes[ i ] == 0, string.IsEmpty() );
+			if ( sizes[ i ] )
+			{
+				EXPECT_STREQ( strings[ i ].c_str(), string.GetData() );
+			}
+		}
+		reader.EndArray();
+		EXPECT_EQ( static_cast< int64_t >( data.GetSize() ), reader.Tell() );
+	}
+}
+
+TEST(Stream, MessagePackExtBenchmark)
+{
+	const uint32_t valueCount = 4 * 1024 * 1024;
+	DynamicArray< float32_t > values;
+	values.Resize( valueCount );
+	for ( uint32_t i = 0; i < valueCount; ++i )
+	{
+		values[ i ] = 0.25f * i;
+	}
+
+	// a large float array as an array of values, then as one ext of little endian bytes
+	float64_t writeMillis[ 2 ], readMillis[ 2 ];
+	size_t sizes[ 2 ];
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		DynamicArray< uint8_t > data;
+		data.Reserve( valueCount * 5 + 16 );
+
+		SimpleTimer writeTimer;
+		{
+			DynamicMemoryStream stream ( &data );
+			MessagePackWriter writer ( &stream );
+			if ( pass == 0 )
+			{
+				writer.BeginArray( valueCount );
+				for ( uint32_t i = 0; i < valueCount; ++i )
+				{
+					writer.Write( values[ i ] );
+				}
+				writer.EndArray();
+			}
+			else
+			{
+				writer.WriteExt( 1, values.GetData(), valueCount * sizeof( float32_t ) );
+			}
+		}
+		writeMillis[ pass ] = writeTimer.Elapsed();
+		sizes[ pass ] = data.GetSize();
+
+		DynamicArray< float32_t > result;
+		SimpleTimer readTimer;
+		{
+			MessagePackReader reader ( data.GetData(), data.GetSize() );
+			reader.Advance();
+			if ( pass == 0 )
+			{
+				uint32_t length = reader.ReadArrayLength();
+				result.Resize( length );
+				reader.BeginArray( length );
+				for ( uint32_t i = 0; i < length; ++i )
+				{
+					reader.ReadNumber( result[ i ], true, NULL );
+				}
+				reader.EndArray();
+			}
+			else
+			{
+				int8_t extType = 0;
+				uint32_t size = reader.ReadExtLength( extType );
+				result.Resize( size / sizeof( float32_t ) );
+				MemoryCopy( result.GetData(), reader.ReadRawView( size ), size );
+			}
+		}
+		readMillis[ pass ] = readTimer.Elapsed();
+
+		ASSERT_EQ( valueCount, result.GetSize() );
+		EXPECT_EQ( 0, MemoryCompare( values.GetData(), result.GetData(), valueCount * sizeof( float32_t ) ) );
+	}
+
+	const float64_t megabytes = valueCount * sizeof( float32_t ) / ( 1024.0 * 1024.0 );
+	Helium::Print( "MessagePack float array: %.0f MB/s write, %.0f MB/s read, %" PRIuSZ " bytes as values\n",
+		megabytes / ( writeMillis[ 0 ] / 1000.0 ), megabytes / ( readMillis[ 0 ] / 1000.0 ), sizes[ 0 ] );
+	Helium::Print( "MessagePack float array: %.0f MB/s write, %.0f MB/s read, %" PRIuSZ " bytes as an ext\n",
+		megabytes / ( writeMillis[ 1 ] / 1000.0 ), megabytes / ( readMillis[ 1 ] / 1000.0 ), sizes[ 1 ] );
+}
+
+TEST(Stream, AsyncFileStreamRoundTrip)
+{
+	const char* paths[] = { "FoundationAsyncFileStream0.bin", "FoundationAsyncFileStream1.bin", "FoundationAsyncFileStream2.bin" };
+	const size_t blockSize = 4096;
+
+	// sizes that end mid block, on a block, and inside the first block
+	const size_t sizes[] = { blockSize * 10 + 123, blockSize * 8, 1000 };
+	DynamicArray< uint8_t > data[ HELIUM_ARRAY_COUNT( paths ) ];
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( paths ); ++i )
+	{
+		MakeRandomData( data[ i ], sizes[ i ], static_cast< uint32_t >( i + 1 ) );
+		File file;
+		ASSERT_TRUE( file.Open( paths[ i ], FileModes::Write ) );
+		ASSERT_TRUE( file.Write( data[ i ].GetData(), data[ i ].GetSize() ) );
+	}
+
+	// every stream on one queue, read a bit at a time in turn
+	AsyncFileQueue queue;
+	ASSERT_TRUE( queue.Initialize( 8 ) );
+
+	AsyncFileStream streams[ HELIUM_ARRAY_COUNT( paths ) ];
+	DynamicArray< uint8_t > readBack[ HELIUM_ARRAY_COUNT( paths ) ];
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( paths ); ++i )
+	{
+		ASSERT_TRUE( streams[ i ].Open( paths[ i ], &queue, blockSize, 3 ) );
+		EXPECT_EQ( static_cast< int64_t >( sizes[ i ] ), streams[ i ].GetSize() );
+		readBack[ i ].Resize( sizes[ i ] );
+	}
+
+	const size_t chunkSize = 1500;
+	bool reading = true;
+	for ( size_t offset = 0; reading; offset += chunkSize )
+	{
+		reading = false;
+		for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( paths ); ++i )
+		{
+			if ( offset < sizes[ i ] )
+			{
+				size_t size = Min( chunkSize, sizes[ i ] - offset );
+				EXPECT_EQ( size, streams[ i ].Read( readBack[ i ].GetData() + offset, 1, size ) );
+				reading = true;
+			}
+		}
+	}
+
+	uint8_t byte = 0;
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( paths ); ++i )
+	{
+		EXPECT_TRUE( readBack[ i ] == data[ i ] );
+		EXPECT_EQ( 0u, streams[ i ].Read( &byte, 1, 1 ) );
+	}
+
+	// reading past the end gives what's there
+	AsyncFileStream& stream = streams[ 0 ];
+	uint8_t buffer[ blockSize * 2 ];
+	EXPECT_EQ( static_cast< int64_t >( sizes[ 0 ] - 100 ), stream.Seek( -100, SeekOrigins::End ) );
+	EXPECT_EQ( 100u, stream.Read( buffer, 1, sizeof( buffer ) ) );
+	EXPECT_TRUE( MemoryCompare( buffer, data[ 0 ].GetData() + sizes[ 0 ] - 100, 100 ) == 0 );
+
+	// back to the start, then ahead within the blocks read ahead, then past them
+	const int64_t positions[] = { 0, 10, blockSize + 7, blockSize * 2 + 1, blockSize * 7 + 5, blockSize * 3, blockSize * 3 };
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( positions ); ++i )
+	{
+		EXPECT_EQ( positions[ i ], stream.Seek( positions[ i ], SeekOrigins::Begin ) );
+		EXPECT_EQ( positions[ i ], stream.Tell() );
+		EXPECT_EQ( 300u, stream.Read( buffer, 1, 300 ) );
+		EXPECT_TRUE( MemoryCompare( buffer, data[ 0 ].GetData() + positions[ i ], 300 ) == 0 );
+	}
+
+	EXPECT_EQ( static_cast< int64_t >( blockSize * 4 ), stream.Seek( blockSize - 300, SeekOrigins::Current ) );
+	EXPECT_EQ( sizeof( buffer ), stream.Read( buffer, 1, sizeof( buffer ) ) );
+	EXPECT_TRUE( MemoryCompare( buffer, data[ 0 ].GetData() + blockSize * 4, sizeof( buffer ) ) == 0 );
+
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( paths ); ++i )
+	{
+		streams[ i ].Close();
+		EXPECT_FALSE( streams[ i ].IsOpen() );
+		Helium::Delete( paths[ i ] );
+	}
+
+	// a stream with its own queue
+	AsyncFileStream ownStream;
+	EXPECT_FALSE( ownStream.Open( paths[ 1 ], NULL, blockSize, 2 ) );
+	{
+		File file;
+		ASSERT_TRUE( file.Open( paths[ 1 ], FileModes::Write ) );
+		ASSERT_TRUE( file.Write( data[ 0 ].GetData(), data[ 0 ].GetSize() ) );
+	}
+	ASSERT_TRUE( ownStream.Open( paths[ 1 ], NULL, blockSize, 2 ) );
+	DynamicArray< uint8_t > ownReadBack;
+	ownReadBack.Resize( sizes[ 0 ] );
+	EXPECT_EQ( sizes[ 0 ], ownStream.Read( ownReadBack.GetData(), 1, sizes[ 0 ] ) );
+	EXPECT_TRUE( ownReadBack == data[ 0 ] );
+	ownStream.Close();
+	Helium::Delete( paths[ 1 ] );
+}
@@ -1,13 +1,19 @@
 #include "Precompile.h"
 #include "Persist/Archive.h"
 
+#include "Platform/Atomic.h"
 #include "Platform/Locks.h"
 #include "Platform/Process.h"
 #include "Platform/Exception.h"
+#include "Platform/Runtime.h"
+#include "Platform/Thread.h"
 
+#include "Foundation/FileStream.h"
 #include "Foundation/Log.h"
+#include "Foundation/MemoryStream.h"
 #include "Foundation/Profile.h"
 
+#include "Reflect/MetaStruct.h"
 #include "Reflect/Object.h"
 #include "Reflect/TranslatorDeduction.h"
 #include "Reflect/Registry.h"
@@ -15,6 +21,7 @@
 #include "Persist/ArchiveBson.h"
 #include "Persist/ArchiveJson.h"
 #include "Persist/ArchiveMessagePack.h"
+#include "Persist/ArchiveBinary.h"
 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -28,13 +35,21 @@ const char* Persist::ArchiveExtensions[] =
 {
 	"bson",
 	"json",
-	"msgpack"
+	"msgpack",
+	"bin"
 };
 
+// objects claimed at a time by the workers of a parallel read or write
+static const int32_t ParallelBatch = 32;
+
+// the worker (ArchiveReader::ReadWorker) the calling thread is reading objects for, if any
+static ThreadLocalPointer g_ReadWorker;
+
 Archive::Archive( uint32_t flags )
 	: m_Progress( 0 )
 	, m_Abort( false )
 	, m_Flags( flags )
+	, m_ThreadCount( 0 )
 {
 }
 
@@ -43,6 +58,7 @@ Archive::Archive( const FilePath& path, uint32_t flags )
 	, m_Progress( 0 )
 	, m_Abort( false )
 	, m_Flags( flags )
+	, m_ThreadCount( 0 )
 {
 	HELIUM_ASSERT( !m_Path.Empty() );
 }
@@ -51,50 +67,509 @@ Archive::~Archive()
 {
 }
 
-SmartPtr< ArchiveWriter > ArchiveWriter::GetWriter( const FilePath& path, ObjectIdentifier* identifier, ArchiveType archiveType )
+void Archive::SetThreadCount( uint32_t count )
+{
+	m_ThreadCount = count;
+}
+
+uint32_t Archive::GetThreadCount() const
+{
+	return m_ThreadCount ? m_ThreadCount : Platform::GetProcessorCount();
+}
+
+Stream* Archive::OpenStream()
+{
+	bool write = GetMode() == ArchiveModes::Write;
+
+	FileStream* file = new FileStream();
+	file->Open( m_Path.Data(), write ? FileStream::MODE_WRITE : FileStream::MODE_READ );
+	if ( !( m_Flags & ArchiveFlags::Compress ) )
+	{
+		return file;
+	}
+
+	// closing the compressed stream closes the file, this just owns it
+	m_File.Reset( file );
+
+	AutoPtr< CompressedStream > stream( new CompressedStream() );
+	stream->SetThreadCount( m_ThreadCount );
+	stream->Open( file, write ? CompressedStream::MODE_WRITE : CompressedStream::MODE_READ );
+	return stream.Release();
+}
+
+// packed sequences start with [ scalar type : 8 ][ values per item : 8 ][ item count : 32, little endian ], then
+//  the CRC of the name of the field each value of an item belongs to [ name : 32, little endian ] * values per item,
+//  0 for items that are just a number
+static const size_t PackedSequenceHeaderSize = 6;
+
+// shorter sequences are written item by item, where small integers take less than the header
+static const size_t PackedSequenceMinimum = 16;
+
+static size_t GetPackedValueSize( ScalarType type )
+{
+	switch ( type )
+	{
+	case ScalarTypes::Unsigned8:
+	case ScalarTypes::Signed8:
+		return 1;
+
+	case ScalarTypes::Unsigned16:
+	case ScalarTypes::Signed16:
+		return 2;
+
+	case ScalarTypes::Unsigned32:
+	case ScalarTypes::Signed32:
+	case ScalarTypes::Float32:
+		return 4;
+
+	case ScalarTypes::Unsigned64:
+	case ScalarTypes::Signed64:
+	case ScalarTypes::Float64:
+		return 8;
+
+	default:
+		return 0; // booleans and strings aren't packed
+	}
+}
+
+static bool GetPackedScalarType( const Translator* translator, ScalarType& type )
+{
+	if ( translator->GetMetaId() != MetaIds::SimpleTranslator )
+	{
+		return false;
+	}
+
+	type = static_cast< const ScalarTranslator* >( translator )->m_Type;
+	return GetPackedValueSize( type ) == translator->m_Size;
+}
+
+// items are packable if they are a number, or a structure of numbers of one type with no padding between them,
+//  names (if given) gets the name CRC of each value's field, in the order they are in memory
+static bool GetPackedLayout( const Translator* translator, ScalarType& type, uint32_t& valuesPerItem, uint32_t* names = NULL )
+{
+	if ( GetPackedScalarType( translator, type ) )
+	{
+		valuesPerItem = 1;
+		if ( names )
+		{
+			names[ 0 ] = 0;
+		}
+		return true;
+	}
+
+	if ( translator->GetMetaId() != MetaIds::StructureTranslator )
+	{
+		return false;
+	}
+
+	const MetaStruct* structure = static_cast< const StructureTranslator* >( translator )->GetMetaStruct();
+	uint32_t fieldSize = 0;
+	bool first = true;
+	for ( const MetaStruct* current = structure; current; current = current->m_Base )
+	{
+		for ( DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin(), end = current->m_Fields.End(); itr != end; ++itr )
+		{
+			ScalarType fieldType;
+			if ( ( itr->m_Flags & FieldFlags::Discard ) || !GetPackedScalarType( itr->m_Translator, fieldType ) || ( !first && fieldType != type ) )
+			{
+				return false;
+			}
+
+			type = fieldType;
+			fieldSize += itr->m_Size;
+			first = false;
+		}
+	}
+
+	// fields don't overlap, so if they add up to the size of the structure they fill all of it
+	if ( first || fieldSize != structure->m_Size || fieldSize / GetPackedValueSize( type ) > 255 )
+	{
+		return false;
+	}
+
+	uint32_t valueSize = static_cast< uint32_t >( GetPackedValueSize( type ) );
+	valuesPerItem = fieldSize / valueSize;
+	if ( names )
+	{
+		for ( const MetaStruct* current = structure; current; current = current->m_Base )
+		{
+			for ( DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin(), end = current->m_Fields.End(); itr != end; ++itr )
+			{
+				for ( uint32_t offset = itr->m_Offset; offset < itr->m_Offset + itr->m_Size; offset += valueSize )
+				{
+					names[ offset / valueSize ] = itr->m_NameCrc;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+#if !HELIUM_ENDIAN_LITTLE
+static void SwapPackedValues( uint8_t* values, size_t valueSize, size_t count )
+{
+	for ( size_t i=0; i<count; ++i, values += valueSize )
+	{
+		for ( size_t j=0; j<valueSize/2; ++j )
+		{
+			uint8_t temp = values[ j ];
+			values[ j ] = values[ valueSize - 1 - j ];
+			values[ valueSize - 1 - j ] = temp;
+		}
+	}
+}
+#endif
+
+template< class T >
+static T LoadPackedValue( const uint8_t* bytes )
+{
+	T value;
+	MemoryCopy( &value, bytes, sizeof( T ) );
+#if !HELIUM_ENDIAN_LITTLE
+	SwapPackedValues( reinterpret_cast< uint8_t* >( &value ), sizeof( T ), 1 );
+#endif
+	return value;
+}
+
+// convert packed values of another type (say the field changed from float32_t to float64_t), clamping like the item by item form
+template< class T >
+static void UnpackValues( const uint8_t* values, ScalarType type, T* items, uint32_t count )
 {
+	size_t valueSize = GetPackedValueSize( type );
+	for ( uint32_t i=0; i<count; ++i, values += valueSize )
+	{
+		switch ( type )
+		{
+		case ScalarTypes::Unsigned8:
+			RangeCast( LoadPackedValue< uint8_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Unsigned16:
+			RangeCast( LoadPackedValue< uint16_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Unsigned32:
+			RangeCast( LoadPackedValue< uint32_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Unsigned64:
+			RangeCast( LoadPackedValue< uint64_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Signed8:
+			RangeCast( LoadPackedValue< int8_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Signed16:
+			RangeCast( LoadPackedValue< int16_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Signed32:
+			RangeCast( LoadPackedValue< int32_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Signed64:
+			RangeCast( LoadPackedValue< int64_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Float32:
+			RangeCast( LoadPackedValue< float32_t >( values ), items[ i ], true );
+			break;
+
+		case ScalarTypes::Float64:
+			RangeCast( LoadPackedValue< float64_t >( values ), items[ i ], true );
+			break;
+
+		default:
+			HELIUM_ASSERT( false );
+			break;
+		}
+	}
+}
+
+static void UnpackValues( const uint8_t* values, ScalarType type, void* items, ScalarType itemType, uint32_t count )
+{
+	switch ( itemType )
+	{
+	case ScalarTypes::Unsigned8:
+		UnpackValues( values, type, static_cast< uint8_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Unsigned16:
+		UnpackValues( values, type, static_cast< uint16_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Unsigned32:
+		UnpackValues( values, type, static_cast< uint32_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Unsigned64:
+		UnpackValues( values, type, static_cast< uint64_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Signed8:
+		UnpackValues( values, type, static_cast< int8_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Signed16:
+		UnpackValues( values, type, static_cast< int16_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Signed32:
+		UnpackValues( values, type, static_cast< int32_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Signed64:
+		UnpackValues( values, type, static_cast< int64_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Float32:
+		UnpackValues( values, type, static_cast< float32_t* >( items ), count );
+		break;
+
+	case ScalarTypes::Float64:
+		UnpackValues( values, type, static_cast< float64_t* >( items ), count );
+		break;
+
+	default:
+		HELIUM_ASSERT( false );
+		break;
+	}
+}
+
+// structures whose fields have moved, changed, or gone get what is left of them field by field
+static void UnpackFields( const uint8_t* bytes, size_t headerSize, uint32_t length, Pointer pointer, SequenceTranslator* sequence )
+{
+	ScalarType type = static_cast< ScalarType >( bytes[ 0 ] );
+	uint32_t valuesPerItem = bytes[ 1 ];
+	size_t valueSize = GetPackedValueSize( type );
+	const MetaStruct* structure = static_cast< StructureTranslator* >( sequence->GetItemTranslator() )->GetMetaStruct();
+
+	// where in an item each value goes, found by the name of its field (and its place in it, for arrays)
+	struct Target
+	{
+		uint32_t   m_Offset;
+		ScalarType m_Type;
+		bool       m_Found;
+	};
+
+	Target targets[ 255 ];
+	for ( uint32_t i=0; i<valuesPerItem; ++i )
+	{
+		uint32_t name = LoadPackedValue< uint32_t >( bytes + PackedSequenceHeaderSize + i * sizeof( uint32_t ) );
+		uint32_t element = 0;
+		for ( uint32_t j=0; j<i; ++j )
+		{
+			element += LoadPackedValue< uint32_t >( bytes + PackedSequenceHeaderSize + j * sizeof( uint32_t ) ) == name;
+		}
+
+		const Field* field = structure->FindFieldByName( name );
+		Target& target = targets[ i ];
+		target.m_Found = field && !( field->m_Flags & FieldFlags::Discard ) && GetPackedScalarType( field->m_Translator, target.m_Type )
+			&& ( element + 1 ) * GetPackedValueSize( target.m_Type ) <= field->m_Size;
+		if ( target.m_Found )
+		{
+			target.m_Offset = field->m_Offset + element * static_cast< uint32_t >( GetPackedValueSize( target.m_Type ) );
+		}
+	}
+
+	sequence->SetLength( pointer, length );
+
+	const uint8_t* values = bytes + headerSize;
+	for ( uint32_t i=0; i<length; ++i )
+	{
+		uint8_t* item = static_cast< uint8_t* >( sequence->GetItem( pointer, i ).m_Address );
+		for ( uint32_t j=0; j<valuesPerItem; ++j, values += valueSize )
+		{
+			if ( targets[ j ].m_Found )
+			{
+				UnpackValues( values, type, item + targets[ j ].m_Offset, targets[ j ].m_Type, 1 );
+			}
+		}
+	}
+}
+
+bool Archive::PackSequence( Pointer pointer, SequenceTranslator* sequence, DynamicArray< uint8_t >& packed )
+{
+	size_t length = sequence->GetLength( pointer );
+	if ( length < PackedSequenceMinimum )
+	{
+		return false;
+	}
+
+	ScalarType type;
+	uint32_t valuesPerItem;
+	uint32_t names[ 255 ];
+	if ( !GetPackedLayout( sequence->GetItemTranslator(), type, valuesPerItem, names ) )
+	{
+		return false;
+	}
+
+	// the whole thing has to fit the 32 bit lengths of the formats
+	size_t valueSize = GetPackedValueSize( type );
+	size_t headerSize = PackedSequenceHeaderSize + valuesPerItem * sizeof( uint32_t );
+	uint64_t size = static_cast< uint64_t >( length ) * valuesPerItem * valueSize;
+	if ( size > NumericLimits< uint32_t >::Maximum - headerSize )
+	{
+		return false;
+	}
+
+	const void* data = sequence->GetItemData( pointer );
+	if ( !data )
+	{
+		return false;
+	}
+
+	packed.Resize( headerSize + static_cast< size_t >( size ) );
+	uint8_t* bytes = packed.GetData();
+	bytes[ 0 ] = static_cast< uint8_t >( type );
+	bytes[ 1 ] = static_cast< uint8_t >( valuesPerItem );
+	bytes[ 2 ] = static_cast< uint8_t >( length );
+	bytes[ 3 ] = static_cast< uint8_t >( length >> 8 );
+	bytes[ 4 ] = static_cast< uint8_t >( length >> 16 );
+	bytes[ 5 ] = static_cast< uint8_t >( length >> 24 );
+
+	MemoryCopy( bytes + PackedSequenceHeaderSize, names, valuesPerItem * sizeof( uint32_t ) );
+	MemoryCopy( bytes + headerSize, data, static_cast< size_t >( size ) );
+#if !HELIUM_ENDIAN_LITTLE
+	SwapPackedValues( bytes + PackedSequenceHeaderSize, sizeof( uint32_t ), valuesPerItem );
+	SwapPackedValues( bytes + headerSize, valueSize, length * valuesPerItem );
+#endif
+
+	return true;
+}
+
+bool Archive::UnpackSequence( const void* packed, size_t size, Pointer pointer, SequenceTranslator* sequence )
+{
+	const uint8_t* bytes = static_cast< const uint8_t* >( packed );
+	if ( size < PackedSequenceHeaderSize )
+	{
+		return false;
+	}
+
+	ScalarType type = static_cast< ScalarType >( bytes[ 0 ] );
+	uint32_t valuesPerItem = bytes[ 1 ];
+	uint32_t length = bytes[ 2 ] | ( bytes[ 3 ] << 8 ) | ( bytes[ 4 ] << 16 ) | ( static_cast< uint32_t >( bytes[ 5 ] ) << 24 );
+	size_t headerSize = PackedSequenceHeaderSize + valuesPerItem * sizeof( uint32_t );
+	size_t valueSize = GetPackedValueSize( type );
+	if ( !valueSize || size < headerSize || static_cast< uint64_t >( length ) * valuesPerItem * valueSize != size - headerSize )
+	{
+		return false;
+	}
+
+	Translator* itemTranslator = sequence->GetItemTranslator();
+	ScalarType itemType;
+	uint32_t itemValues;
+	uint32_t itemNames[ 255 ];
+	bool sameLayout = GetPackedLayout( itemTranslator, itemType, itemValues, itemNames ) && itemValues == valuesPerItem;
+	for ( uint32_t i=0; sameLayout && i<valuesPerItem; ++i )
+	{
+		sameLayout = LoadPackedValue< uint32_t >( bytes + PackedSequenceHeaderSize + i * sizeof( uint32_t ) ) == itemNames[ i ];
+	}
+
+	if ( !sameLayout )
+	{
+		if ( itemTranslator->GetMetaId() != MetaIds::StructureTranslator )
+		{
+			return false;
+		}
+
+		UnpackFields( bytes, headerSize, length, pointer, sequence );
+		return true;
+	}
+
+	sequence->SetLength( pointer, length );
+
+	const uint8_t* values = bytes + headerSize;
+	uint8_t* data = static_cast< uint8_t* >( sequence->GetItemData( pointer ) );
+	if ( data && type == itemType )
+	{
+		MemoryCopy( data, values, size - headerSize );
+#if !HELIUM_ENDIAN_LITTLE
+		SwapPackedValues( data, valueSize, length * valuesPerItem );
+#endif
+	}
+	else
+	{
+		size_t itemSize = valuesPerItem * GetPackedValueSize( itemType );
+		for ( uint32_t i=0; i<length; ++i, values += valuesPerItem * valueSize )
+		{
+			void* item = data ? data + i * itemSize : sequence->GetItem( pointer, i ).m_Address;
+			UnpackValues( values, type, item, itemType, valuesPerItem );
+		}
+	}
+
+	return true;
+}
+
+SmartPtr< ArchiveWriter > ArchiveWriter::GetWriter( const FilePath& path, ObjectIdentifier* identifier, ArchiveType archiveType, uint32_t flags )
+{
+	SmartPtr< ArchiveWriter > writer;
+
 	switch ( archiveType )
 	{
 	case ArchiveTypes::Auto:
 		{
 			if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::Bson ] ) == 0 )
 			{
-				return new ArchiveWriterBson( path, identifier );
+				writer = new ArchiveWriterBson( path, identifier, flags );
 			}
 			else if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::Json ] ) == 0 )
 			{
-				return new ArchiveWriterJson( path, identifier );
+				writer = new ArchiveWriterJson( path, identifier, flags );
 			}
 			else if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::MessagePack ] ) == 0 )
 			{
-				return new ArchiveWriterMessagePack( path, identifier );
+				writer = new ArchiveWriterMessagePack( path, identifier, flags );
+			}
+			else if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::Binary ] ) == 0 )
+			{
+				writer = new ArchiveWriterBinary( path, identifier, flags );
 			}
 			break;
 		}
 
 	case ArchiveTypes::Bson:
-		return new ArchiveWriterBson( path, identifier );
+		writer = new ArchiveWriterBson( path, identifier, flags );
+		break;
 
 	case ArchiveTypes::Json:
-		return new ArchiveWriterJson( path, identifier );
+		writer = new ArchiveWriterJson( path, identifier, flags );
+		break;
 
 	case ArchiveTypes::MessagePack:
-		return new ArchiveWriterMessagePack( path, identifier );
+		writer = new ArchiveWriterMessagePack( path, identifier, flags );
+		break;
+
+	case ArchiveTypes::Binary:
+		writer = new ArchiveWriterBinary( path, identifier, flags );
+		break;
 
 	default:
 		HELIUM_ASSERT( false );
 		break;
 	}
 
-	throw Persist::StreamException( "Unknown archive type" );
+	if ( !writer )
+	{
+		throw Persist::StreamException( "Unknown archive type" );
+	}
+
+	if ( ( flags & ArchiveFlags::Delta ) && writer->GetType() != ArchiveTypes::MessagePack )
+	{
+		throw Persist::StreamException( "Delta archives can only be written as MessagePack" );
+	}
+
+	return writer;
 }
 
-bool ArchiveWriter::WriteToFile( const FilePath& path, const ObjectPtr& object, ObjectIdentifier* identifier, ArchiveType archiveType, std::string* error )
+bool ArchiveWriter::WriteToFile( const FilePath& path, const ObjectPtr& object, ObjectIdentifier* identifier, ArchiveType archiveType, std::string* error, uint32_t flags )
 {
-	return WriteToFile( path, &object, 1, identifier, archiveType, error );
+	return WriteToFile( path, &object, 1, identifier, archiveType, error, flags );
 }
 
-bool ArchiveWriter::WriteToFile( const FilePath& path, const ObjectPtr* objects, size_t count, ObjectIdentifier* identifier, ArchiveType archiveType, std::string* error )
+bool ArchiveWriter::WriteToFile( const FilePath& path, const ObjectPtr* objects, size_t count, ObjectIdentifier* identifier, ArchiveType archiveType, std::string* error, uint32_t flags )
 {
 	HELIUM_ASSERT( !path.Empty() );
 	HELIUM_PERSIST_SCOPE_TIMER( "%s", path.Data() );
@@ -106,7 +581,7 @@ bool ArchiveWriter::WriteToFile( const FilePath& path, const ObjectPtr* objects,
 	FilePath safetyPath( path.Directory() + Helium::GetProcessString() );
 	safetyPath.ReplaceExtension( path.Extension() );
 
-	SmartPtr< ArchiveWriter > archive = GetWriter( safetyPath, identifier, archiveType );
+	SmartPtr< ArchiveWriter > archive = GetWriter( safetyPath, identifier, archiveType, flags );
 
 	// generate the file to the safety location
 	if ( Helium::IsDebuggerPresent() )
@@ -119,128 +594,553 @@ bool ArchiveWriter::WriteToFile( const FilePath& path, const ObjectPtr* objects,
 	{
 		bool open = false;
 
-		try
+		try
+		{
+			archive->Open();
+			open = true;
+			archive->Write( objects, count );
+			archive->Close(); 
+		}
+		catch ( Helium::Exception& ex )
+		{
+			std::stringstream str;
+			str << "While writing '" << path.Data() << "': " << ex.Get();
+
+			if ( error )
+			{
+				*error = str.str();
+			}
+
+			if ( open )
+			{
+				archive->Close();
+			}
+
+			safetyPath.Delete();
+			return false;
+		}
+		catch( ... )
+		{
+			if ( open )
+			{
+				archive->Close();
+			}
+
+			safetyPath.Delete();
+			throw;
+		}
+	}
+
+	try
+	{
+		// delete the destination file
+		path.Delete();
+
+		// move the written file to the destination location
+		safetyPath.Move( path );
+	}
+	catch ( Helium::Exception& ex )
+	{
+		std::stringstream str;
+		str << "While moving '" << safetyPath.Data() << "' to '" << path.Data() << "': " << ex.Get();
+
+		if ( error )
+		{
+			*error = str.str();
+		}
+
+		safetyPath.Delete();
+		return false;
+	}
+
+	// the file now matches the objects, so the next delta starts from here
+	for ( DynamicArray< ObjectPtr >::ConstIterator itr = archive->m_Objects.Begin(), end = archive->m_Objects.End(); itr != end; ++itr )
+	{
+		(*itr)->ClearDirtyFields();
+	}
+
+	return true;
+}
+
+bool ArchiveWriter::CompactToFile( const FilePath& path, const FilePath* deltaPaths, size_t deltaCount, ArchiveType archiveType, std::string* error )
+{
+	DynamicArray< ObjectPtr > objects;
+	if ( !ArchiveReader::ReadFromFile( path, objects, NULL, archiveType, error ) )
+	{
+		return false;
+	}
+
+	// each delta applies to the objects as the ones before it left them
+	for ( size_t i = 0; i < deltaCount; ++i )
+	{
+		if ( !ArchiveReader::ReadFromFile( deltaPaths[ i ], objects, NULL, ArchiveTypes::Auto, error ) )
+		{
+			return false;
+		}
+	}
+
+	return WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, archiveType, error );
+}
+
+ArchiveWriter::ArchiveWriter( ObjectIdentifier* identifier, uint32_t flags )
+	: Archive( flags )
+	, m_Identifier( identifier )
+	, m_IndexedCount( 0 )
+	, m_Identified( false )
+{
+
+}
+
+ArchiveWriter::ArchiveWriter( const FilePath& filePath, ObjectIdentifier* identifier, uint32_t flags )
+	: Archive( filePath, flags )
+	, m_Identifier( identifier )
+	, m_IndexedCount( 0 )
+	, m_Identified( false )
+{
+}
+
+ArchiveMode ArchiveWriter::GetMode() const
+{
+	return ArchiveModes::Write;
+}
+
+bool ArchiveWriter::Identify( const ObjectPtr& object, Name* identity )
+{
+	if ( m_Identifier )
+	{
+		return m_Identifier->Identify( object, identity );
+	}
+
+	uint32_t index = 0;
+	if ( !IndexObject( object, identity ? &index : NULL ) )
+	{
+		return false;
+	}
+
+	if ( identity )
+	{
+		String str;
+		str.Format( "%d", index );
+		identity->Set( str );
+	}
+
+	return true;
+}
+
+bool ArchiveWriter::Identify( const ObjectPtr& object, uint32_t& index )
+{
+	if ( m_Identifier )
+	{
+		return m_Identifier->Identify( object, index );
+	}
+
+	return IndexObject( object, &index );
+}
+
+bool ArchiveWriter::IndexObject( const ObjectPtr& object, uint32_t* index )
+{
+	// null pointers have no identity, they read back as null
+	if ( !object )
+	{
+		return false;
+	}
+
+	// IdentifyObjects indexed everything being written up front, strictly owned objects aren't in there
+	if ( m_Identified )
+	{
+		uint32_t found = m_ObjectIndices.Find( object );
+		if ( found == ObjectIndex::Invalid )
+		{
+			return false;
+		}
+
+		if ( index )
+		{
+			*index = found;
+		}
+
+		return true;
+	}
+
+	bool strictOwnership = reinterpret_cast< RefCountProxy< Reflect::Object >* >( object.GetProxy() )->GetStrongRefCount() == 1;
+	if ( strictOwnership )
+	{
+		return false;
+	}
+
+	if ( index )
+	{
+		// catch up with the objects added by Write, the first of any duplicates keeps its index
+		for ( ; m_IndexedCount < m_Objects.GetSize(); ++m_IndexedCount )
+		{
+			m_ObjectIndices.Insert( m_Objects[ m_IndexedCount ], static_cast< uint32_t >( m_IndexedCount ) );
+		}
+
+		*index = m_ObjectIndices.Find( object );
+		if ( *index == ObjectIndex::Invalid )
+		{
+			*index = static_cast< uint32_t >( m_Objects.GetSize() );
+
+			// this will cause it to be written after the current object-in-progress (see Write)
+			m_Objects.Push( object );
+		}
+	}
+
+	return true;
+}
+
+struct ArchiveWriter::ParallelWrite
+{
+	int32_t volatile                          m_Next;         // first object of the next batch to claim
+	int32_t                                   m_First;
+	int32_t                                   m_Count;
+	int32_t volatile                          m_Stop;         // a worker failed
+	int32_t volatile                          m_Failed;
+	std::string                               m_Error;        // from the first worker to fail
+	bool                                      m_InlineOwned;
+	DynamicArray< DynamicArray< Object* > >*  m_References;   // one per batch, while identifying
+	DynamicArray< ParallelChunk >*            m_Chunks;       // one per batch, while writing
+};
+
+struct ArchiveWriter::WriteWorker
+{
+	ArchiveWriter*  m_Archive;
+	ParallelWrite*  m_Write;
+	CallbackThread  m_Thread;
+
+	void Run()
+	{
+		m_Archive->WriteBatches( *m_Write, false );
+	}
+};
+
+// whether values of a type can point at objects, the rest don't need walking for IdentifyObjects
+static bool HoldsPointers( Translator* translator )
+{
+	switch ( translator->GetMetaId() )
+	{
+	case MetaIds::PointerTranslator:
+		return true;
+
+	case MetaIds::StructureTranslator:
+		{
+			for ( const MetaStruct* current = static_cast< StructureTranslator* >( translator )->GetMetaStruct(); current != NULL; current = current->m_Base )
+			{
+				for ( DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin(), end = current->m_Fields.End(); itr != end; ++itr )
+				{
+					if ( HoldsPointers( itr->m_Translator ) )
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+	case MetaIds::SetTranslator:
+		return HoldsPointers( static_cast< SetTranslator* >( translator )->GetItemTranslator() );
+
+	case MetaIds::SequenceTranslator:
+		return HoldsPointers( static_cast< SequenceTranslator* >( translator )->GetItemTranslator() );
+
+	case MetaIds::AssociationTranslator:
+		{
+			AssociationTranslator* association = static_cast< AssociationTranslator* >( translator );
+			return HoldsPointers( association->GetKeyTranslator() ) || HoldsPointers( association->GetValueTranslator() );
+		}
+
+	default:
+		return false;
+	}
+}
+
+static void FindReferences( Pointer pointer, Translator* translator, Object* object, bool inlineOwned, DynamicArray< Object* >& references );
+
+// the objects an instance points to, in the order SerializeInstance writes them (base structures first)
+static void FindReferences( void* instance, const MetaStruct* structure, Object* object, bool inlineOwned, DynamicArray< Object* >& references )
+{
+	DynamicArray< const MetaStruct* > bases;
+	for ( const MetaStruct* current = structure; current != NULL; current = current->m_Base )
+	{
+		bases.Push( current );
+	}
+
+	while ( !bases.IsEmpty() )
+	{
+		const MetaStruct* current = bases.Pop();
+		DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin();
+		DynamicArray< Field >::ConstIterator end = current->m_Fields.End();
+		for ( ; itr != end; ++itr )
+		{
+			const Field* field = &*itr;
+			if ( !HoldsPointers( field->m_Translator ) || !field->ShouldSerialize( instance, object ) )
+			{
+				continue;
+			}
+
+			for ( uint32_t i=0; i<field->m_Count; ++i )
+			{
+				FindReferences( Pointer ( field, instance, object, i ), field->m_Translator, object, inlineOwned, references );
+			}
+		}
+	}
+}
+
+static void FindReferences( Pointer pointer, Translator* translator, Object* object, bool inlineOwned, DynamicArray< Object* >& references )
+{
+	switch ( translator->GetMetaId() )
+	{
+	case MetaIds::PointerTranslator:
+		{
+			const ObjectPtr& pointed ( pointer.As< ObjectPtr >() );
+			if ( !pointed )
+			{
+				break;
+			}
+
+			// strictly owned objects have no identity (see ArchiveWriter::IndexObject), some backends write them in place
+			bool strictOwnership = reinterpret_cast< RefCountProxy< Reflect::Object >* >( pointed.GetProxy() )->GetStrongRefCount() == 1;
+			if ( !strictOwnership )
+			{
+				references.Push( pointed );
+			}
+			else if ( inlineOwned )
+			{
+				FindReferences( pointed, pointed->GetMetaClass(), pointed, inlineOwned, references );
+			}
+			break;
+		}
+
+	case MetaIds::StructureTranslator:
 		{
-			archive->Open();
-			open = true;
-			archive->Write( objects, count );
-			archive->Close(); 
+			StructureTranslator* structure = static_cast< StructureTranslator* >( translator );
+			FindReferences( pointer.m_Address, structure->GetMetaStruct(), object, inlineOwned, references );
+			break;
 		}
-		catch ( Helium::Exception& ex )
+
+	case MetaIds::SetTranslator:
 		{
-			std::stringstream str;
-			str << "While writing '" << path.Data() << "': " << ex.Get();
+			SetTranslator* set = static_cast< SetTranslator* >( translator );
+			DynamicArray< Pointer > items;
+			set->GetItems( pointer, items );
 
-			if ( error )
+			for ( DynamicArray< Pointer >::Iterator itr = items.Begin(), end = items.End(); itr != end; ++itr )
 			{
-				*error = str.str();
+				FindReferences( *itr, set->GetItemTranslator(), object, inlineOwned, references );
 			}
+			break;
+		}
 
-			if ( open )
+	case MetaIds::SequenceTranslator:
+		{
+			SequenceTranslator* sequence = static_cast< SequenceTranslator* >( translator );
+			DynamicArray< Pointer > items;
+			sequence->GetItems( pointer, items );
+
+			for ( DynamicArray< Pointer >::Iterator itr = items.Begin(), end = items.End(); itr != end; ++itr )
 			{
-				archive->Close();
+				FindReferences( *itr, sequence->GetItemTranslator(), object, inlineOwned, references );
 			}
-
-			safetyPath.Delete();
-			return false;
+			break;
 		}
-		catch( ... )
+
+	case MetaIds::AssociationTranslator:
 		{
-			if ( open )
+			AssociationTranslator* association = static_cast< AssociationTranslator* >( translator );
+			DynamicArray< Pointer > keys, values;
+			association->GetItems( pointer, keys, values );
+
+			for ( DynamicArray< Pointer >::Iterator keyItr = keys.Begin(), valueItr = values.Begin(), keyEnd = keys.End(), valueEnd = values.End();
+				keyItr != keyEnd && valueItr != valueEnd;
+				++keyItr, ++valueItr )
 			{
-				archive->Close();
+				FindReferences( *keyItr, association->GetKeyTranslator(), object, inlineOwned, references );
+				FindReferences( *valueItr, association->GetValueTranslator(), object, inlineOwned, references );
 			}
-
-			safetyPath.Delete();
-			throw;
+			break;
 		}
+
+	default:
+		// scalars don't point at anything
+		break;
 	}
+}
 
-	try
-	{
-		// delete the destination file
-		path.Delete();
+bool ArchiveWriter::IsParallel() const
+{
+	// deltas are small, and address objects by the position they had when the document was read, and with one
+	//  thread the batches are just overhead
+	return ( m_Flags & ArchiveFlags::Parallel ) && !( m_Flags & ArchiveFlags::Delta ) && GetThreadCount() > 1;
+}
 
-		// move the written file to the destination location
-		safetyPath.Move( path );
-	}
-	catch ( Helium::Exception& ex )
-	{
-		std::stringstream str;
-		str << "While moving '" << safetyPath.Data() << "' to '" << path.Data() << "': " << ex.Get();
+void ArchiveWriter::IdentifyObjects( bool inlineOwned )
+{
+	HELIUM_ASSERT( !m_Identified );
 
-		if ( error )
+	// a custom identifier names objects itself, so nothing else gets written
+	if ( !m_Identifier )
+	{
+		for ( ; m_IndexedCount < m_Objects.GetSize(); ++m_IndexedCount )
 		{
-			*error = str.str();
+			m_ObjectIndices.Insert( m_Objects[ m_IndexedCount ], static_cast< uint32_t >( m_IndexedCount ) );
 		}
 
-		safetyPath.Delete();
-		return false;
-	}
+		// workers find what each object points to, then the objects that are new get appended in that
+		//  order, which is the order a serial write finds them in.  Those get their own round, and so on.
+		for ( size_t first = 0; first < m_Objects.GetSize(); )
+		{
+			size_t count = m_Objects.GetSize() - first;
+			DynamicArray< DynamicArray< Object* > > references;
+			references.Resize( ( count + ParallelBatch - 1 ) / ParallelBatch );
 
-	return true;
-}
+			ParallelWrite write;
+			write.m_First = static_cast< int32_t >( first );
+			write.m_Count = static_cast< int32_t >( count );
+			write.m_InlineOwned = inlineOwned;
+			write.m_References = &references;
+			write.m_Chunks = NULL;
+			RunParallel( write );
 
-ArchiveWriter::ArchiveWriter( ObjectIdentifier* identifier, uint32_t flags )
-	: Archive( flags )
-	, m_Identifier( identifier )
-{
+			first = m_Objects.GetSize();
+
+			for ( size_t i = 0; i < references.GetSize(); ++i )
+			{
+				const DynamicArray< Object* >& batch = references[ i ];
+				for ( size_t j = 0; j < batch.GetSize(); ++j )
+				{
+					// the first of any duplicates keeps its index
+					if ( m_ObjectIndices.Insert( batch[ j ], static_cast< uint32_t >( m_Objects.GetSize() ) ) )
+					{
+						m_Objects.Push( batch[ j ] );
+					}
+				}
+			}
 
+			m_IndexedCount = m_Objects.GetSize();
+		}
+	}
+
+	m_Identified = true;
 }
 
-ArchiveWriter::ArchiveWriter( const FilePath& filePath, ObjectIdentifier* identifier, uint32_t flags )
-	: Archive( filePath, flags )
-	, m_Identifier( identifier )
+void ArchiveWriter::WriteParallel( DynamicArray< ParallelChunk >& chunks )
 {
+	HELIUM_ASSERT( m_Identified );
+
+	size_t count = m_Objects.GetSize();
+	chunks.Resize( ( count + ParallelBatch - 1 ) / ParallelBatch );
+
+	ParallelWrite write;
+	write.m_First = 0;
+	write.m_Count = static_cast< int32_t >( count );
+	write.m_InlineOwned = false;
+	write.m_References = NULL;
+	write.m_Chunks = &chunks;
+	RunParallel( write );
 }
 
-ArchiveMode ArchiveWriter::GetMode() const
+void ArchiveWriter::WriteParallelObjects( size_t first, size_t last, Stream& stream )
 {
-	return ArchiveModes::Write;
+	HELIUM_ASSERT_MSG( false, "Archive type does not support parallel writing" );
 }
 
-bool ArchiveWriter::Identify( const ObjectPtr& object, Name* identity )
+void ArchiveWriter::RunParallel( ParallelWrite& write )
 {
-	if ( m_Identifier )
+	HELIUM_ASSERT( m_Objects.GetSize() <= static_cast< size_t >( NumericLimits< int32_t >::Maximum - ParallelBatch ) );
+
+	write.m_Next = 0;
+	write.m_Stop = 0;
+	write.m_Failed = 0;
+
+	// the calling thread works too, and raises the status events
+	uint32_t threadCount = GetThreadCount();
+	threadCount = static_cast< uint32_t >( Min< size_t >( threadCount, ( write.m_Count + ParallelBatch - 1 ) / ParallelBatch ) );
+	threadCount = Max< uint32_t >( threadCount, 1 );
+
+	WriteWorker* workers = new WriteWorker[ threadCount ];
+	for ( uint32_t i=0; i<threadCount; ++i )
 	{
-		return m_Identifier->Identify( object, identity );
+		workers[ i ].m_Archive = this;
+		workers[ i ].m_Write = &write;
 	}
 
-	bool strictOwnership = reinterpret_cast< RefCountProxy< Reflect::Object >* >( object.GetProxy() )->GetStrongRefCount() == 1;
-	if ( !strictOwnership )
+	for ( uint32_t i=1; i<threadCount; ++i )
+	{
+		workers[ i ].m_Thread.Create( &CallbackThread::EntryHelper< WriteWorker, &WriteWorker::Run >, &workers[ i ], "Archive Write" );
+	}
+
+	WriteBatches( write, true );
+
+	for ( uint32_t i=1; i<threadCount; ++i )
+	{
+		workers[ i ].m_Thread.Join();
+	}
+
+	delete[] workers;
+
+	if ( write.m_Failed )
+	{
+		throw Persist::StreamException( "%s", write.m_Error.c_str() );
+	}
+}
+
+void ArchiveWriter::WriteBatches( ParallelWrite& write, bool notify )
+{
+	while ( !write.m_Stop )
 	{
-		if ( identity )
+		int32_t batch = AtomicAdd( write.m_Next, ParallelBatch );
+		if ( batch >= write.m_Count )
 		{
-			size_t index = Invalid< size_t >();
-			for ( DynamicArray< ObjectPtr >::ConstIterator itr = m_Objects.Begin(), end = m_Objects.End(); itr != end; ++itr )
+			break;
+		}
+
+		int32_t first = write.m_First + batch;
+		int32_t last = write.m_First + Min( batch + ParallelBatch, write.m_Count );
+
+		try
+		{
+			if ( write.m_References )
 			{
-				if ( itr->Ptr() == object )
+				DynamicArray< Object* >& references = write.m_References->GetElement( batch / ParallelBatch );
+				for ( int32_t i=first; i<last; ++i )
 				{
-					index = m_Objects.GetIndex( itr );
-					break;
+					Object* object = m_Objects.GetElement( i );
+					if ( object )
+					{
+						FindReferences( object, object->GetMetaClass(), object, write.m_InlineOwned, references );
+					}
 				}
 			}
-
-			if ( index == Invalid< size_t >() )
+			else
 			{
-				index = m_Objects.GetSize();
+				ParallelChunk& chunk = write.m_Chunks->GetElement( batch / ParallelBatch );
+				chunk.m_Count = last - first;
 
-				// this will cause it to be written after the current object-in-progress (see Write)
-				m_Objects.Push( object );
+				DynamicMemoryStream stream ( &chunk.m_Data );
+				WriteParallelObjects( first, last, stream );
+			}
+		}
+		catch ( Helium::Exception& ex )
+		{
+			if ( AtomicCompareExchange( write.m_Failed, 1, 0 ) == 0 )
+			{
+				write.m_Error = ex.Get();
 			}
 
-			String str;
-			str.Format( "%d", index );
-			identity->Set( str );
+			AtomicExchange( write.m_Stop, 1 );
+			break;
 		}
 
-		return true;
+		if ( notify && write.m_Chunks )
+		{
+			ArchiveStatus info( *this, ArchiveStates::ObjectProcessed );
+			info.m_Progress = (int)(((float)(last) / (float)write.m_Count) * 100.0f);
+			e_Status.Raise( info );
+		}
 	}
-
-	return false;
 }
 
-SmartPtr< ArchiveReader > ArchiveReader::GetReader( const FilePath& path, ObjectResolver* resolver, ArchiveType archiveType )
+SmartPtr< ArchiveReader > ArchiveReader::GetReader( const FilePath& path, ObjectResolver* resolver, ArchiveType archiveType, uint32_t flags )
 {
 	switch ( archiveType )
 	{
@@ -248,27 +1148,34 @@ SmartPtr< ArchiveReader > ArchiveReader::GetReader( const FilePath& path, Object
 		{
 			if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::Bson ] ) == 0 )
 			{
-				return new ArchiveReaderBson( path, resolver );
+				return new ArchiveReaderBson( path, resolver, flags );
 			}
 			else if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::Json ] ) == 0 )
 			{
-				return new ArchiveReaderJson( path, resolver );
+				return new ArchiveReaderJson( path, resolver, flags );
 			}
 			else if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::MessagePack ] ) == 0 )
 			{
-				return new ArchiveReaderMessagePack( path, resolver );
+				return new ArchiveReaderMessagePack( path, resolver, flags );
+			}
+			else if ( CaseInsensitiveCompareString( path.Extension().c_str(), ArchiveExtensions[ ArchiveTypes::Binary ] ) == 0 )
+			{
+				return new ArchiveReaderBinary( path, resolver, flags );
 			}
 			break;
 		}
 
 	case ArchiveTypes::Bson:
-		return new ArchiveReaderBson( path, resolver );
+		return new ArchiveReaderBson( path, resolver, flags );
 
 	case ArchiveTypes::Json:
-		return new ArchiveReaderJson( path, resolver );
+		return new ArchiveReaderJson( path, resolver, flags );
 
 	case ArchiveTypes::MessagePack:
-		return new ArchiveReaderMessagePack( path, resolver );
+		return new ArchiveReaderMessagePack( path, resolver, flags );
+
+	case ArchiveTypes::Binary:
+		return new ArchiveReaderBinary( path, resolver, flags );
 
 	default:
 		HELIUM_ASSERT( false );
@@ -278,10 +1185,10 @@ SmartPtr< ArchiveReader > ArchiveReader::GetReader( const FilePath& path, Object
 	throw Persist::StreamException( "Unknown archive type" );
 }
 
-bool ArchiveReader::ReadFromFile( const FilePath& path, ObjectPtr& object, ObjectResolver* resolver, ArchiveType archiveType, std::string* error )
+bool ArchiveReader::ReadFromFile( const FilePath& path, ObjectPtr& object, ObjectResolver* resolver, ArchiveType archiveType, std::string* error, uint32_t flags )
 {
 	DynamicArray< ObjectPtr > objects;
-	if ( ReadFromFile( path, objects, resolver, archiveType, error ) )
+	if ( ReadFromFile( path, objects, resolver, archiveType, error, flags ) )
 	{
 		HELIUM_ASSERT( !objects.IsEmpty() );
 		object = objects.GetFirst();
@@ -291,13 +1198,13 @@ bool ArchiveReader::ReadFromFile( const FilePath& path, ObjectPtr& object, Objec
 	return false;
 }
 
-bool ArchiveReader::ReadFromFile( const FilePath& path, DynamicArray< ObjectPtr >& objects, ObjectResolver* resolver, ArchiveType archiveType, std::string* error )
+bool ArchiveReader::ReadFromFile( const FilePath& path, DynamicArray< ObjectPtr >& objects, ObjectResolver* resolver, ArchiveType archiveType, std::string* error, uint32_t flags )
 {
 	HELIUM_ASSERT( !path.Empty() );
 	HELIUM_PERSIST_SCOPE_TIMER( "%s", path.Data() );
 	Log::Debug( "Parsing '%s'\n", path.Data() );
 
-	SmartPtr< ArchiveReader > archive = GetReader( path, resolver, archiveType );
+	SmartPtr< ArchiveReader > archive = GetReader( path, resolver, archiveType, flags );
 
 	if ( Helium::IsDebuggerPresent() )
 	{
@@ -347,10 +1254,10 @@ bool ArchiveReader::ReadFromFile( const FilePath& path, DynamicArray< ObjectPtr
 	return true;
 }
 
-ObjectPtr ArchiveReader::ReadFromFile( const FilePath& path, ObjectResolver* resolver, ArchiveType archiveType, std::string* error )
+ObjectPtr ArchiveReader::ReadFromFile( const FilePath& path, ObjectResolver* resolver, ArchiveType archiveType, std::string* error, uint32_t flags )
 {
 	ObjectPtr object;
-	ReadFromFile( path, object, resolver, archiveType, error );
+	ReadFromFile( path, object, resolver, archiveType, error, flags );
 	return object;
 }
 
@@ -372,12 +1279,164 @@ ArchiveMode ArchiveReader::GetMode() const
 	return ArchiveModes::Read;
 }
 
+struct ArchiveReader::ParallelRead
+{
+	int32_t volatile m_Next;    // first object of the next batch to claim
+	int32_t          m_Count;
+	int32_t volatile m_Stop;    // aborted, or a worker failed
+	int32_t volatile m_Failed;
+	std::string      m_Error;   // from the first worker to fail
+};
+
+struct ArchiveReader::ReadWorker
+{
+	ArchiveReader*        m_Archive;
+	ParallelRead*         m_Read;
+	DynamicArray< Fixup > m_Fixups;   // made by this worker, gathered up once they are all done
+	CallbackThread        m_Thread;
+
+	void Run()
+	{
+		m_Archive->ReadObjects( *m_Read, *this, false );
+	}
+};
+
+bool ArchiveReader::IsParallel() const
+{
+	// reading over existing objects needs to resolve pointers to them as it goes, so that stays serial
+	return ( m_Flags & ArchiveFlags::Parallel ) && m_Objects.IsEmpty();
+}
+
+void ArchiveReader::ReadParallel( size_t count )
+{
+	HELIUM_ASSERT( m_Objects.GetSize() == count );
+	HELIUM_ASSERT( count <= static_cast< size_t >( NumericLimits< int32_t >::Maximum - ParallelBatch ) );
+
+	// every object gets its proxy first, so workers can point at objects that haven't been read yet
+	m_Proxies.resize( count );
+	for ( size_t i=0; i<count; ++i )
+	{
+		if ( !m_Proxies[ i ] )
+		{
+			RefCountProxy< Reflect::Object >* proxy = Object::RefCountSupportType::Allocate();
+			MemorySet( proxy, 0 , sizeof( *proxy ) );
+			m_Proxies[ i ] = proxy;
+		}
+	}
+
+	ParallelRead read;
+	read.m_Next = 0;
+	read.m_Count = static_cast< int32_t >( count );
+	read.m_Stop = 0;
+	read.m_Failed = 0;
+
+	// the calling thread reads too, and raises the status events
+	uint32_t threadCount = GetThreadCount();
+	threadCount = static_cast< uint32_t >( Min< size_t >( threadCount, ( count + ParallelBatch - 1 ) / ParallelBatch ) );
+	threadCount = Max< uint32_t >( threadCount, 1 );
+
+	ReadWorker* workers = new ReadWorker[ threadCount ];
+	for ( uint32_t i=0; i<threadCount; ++i )
+	{
+		workers[ i ].m_Archive = this;
+		workers[ i ].m_Read = &read;
+	}
+
+	for ( uint32_t i=1; i<threadCount; ++i )
+	{
+		workers[ i ].m_Thread.Create( &CallbackThread::EntryHelper< ReadWorker, &ReadWorker::Run >, &workers[ i ], "Archive Read" );
+	}
+
+	ReadObjects( read, workers[ 0 ], true );
+
+	for ( uint32_t i=0; i<threadCount; ++i )
+	{
+		if ( i )
+		{
+			workers[ i ].m_Thread.Join();
+		}
+
+		m_Fixups.AddArray( workers[ i ].m_Fixups.GetData(), workers[ i ].m_Fixups.GetSize() );
+	}
+
+	delete[] workers;
+
+	// proxies of objects that weren't read, and aren't pointed at, can go back
+	for ( size_t i=0; i<count; ++i )
+	{
+		RefCountProxy< Reflect::Object >* proxy = m_Proxies[ i ];
+		if ( !m_Objects[ i ] && proxy && proxy->GetStrongRefCount() == 0 && proxy->GetWeakRefCount() == 0 )
+		{
+			Object::RefCountSupportType::Release( proxy );
+			m_Proxies[ i ] = NULL;
+		}
+	}
+
+	if ( read.m_Failed )
+	{
+		throw Persist::StreamException( "%s", read.m_Error.c_str() );
+	}
+}
+
+void ArchiveReader::ReadParallelObject( size_t index, Reflect::ObjectPtr& object )
+{
+	HELIUM_ASSERT_MSG( false, "Archive type does not support parallel reading" );
+}
+
+void ArchiveReader::ReadObjects( ParallelRead& read, ReadWorker& worker, bool notify )
+{
+	g_ReadWorker.SetPointer( &worker );
+
+	while ( !read.m_Stop )
+	{
+		int32_t first = AtomicAdd( read.m_Next, ParallelBatch );
+		if ( first >= read.m_Count )
+		{
+			break;
+		}
+
+		int32_t last = Min( first + ParallelBatch, read.m_Count );
+
+		try
+		{
+			for ( int32_t i=first; i<last; ++i )
+			{
+				ReadParallelObject( i, m_Objects[ i ] );
+			}
+		}
+		catch ( Helium::Exception& ex )
+		{
+			if ( AtomicCompareExchange( read.m_Failed, 1, 0 ) == 0 )
+			{
+				read.m_Error = ex.Get();
+			}
+
+			AtomicExchange( read.m_Stop, 1 );
+			break;
+		}
+
+		if ( notify )
+		{
+			ArchiveStatus info( *this, ArchiveStates::ObjectProcessed );
+			info.m_Progress = (int)(((float)(last) / (float)read.m_Count) * 100.0f);
+			e_Status.Raise( info );
+			m_Abort |= info.m_Abort;
+			if ( m_Abort )
+			{
+				AtomicExchange( read.m_Stop, 1 );
+			}
+		}
+	}
+
+	g_ReadWorker.SetPointer( NULL );
+}
+
 Reflect::ObjectPtr ArchiveReader::AllocateObject( const Reflect::MetaClass* type, size_t index )
 {
 	Object* object = type->m_Creator();
 
 	// if we pre-allocated a proxy, hook it up to the object
-	if ( index < m_Proxies.size() )
+	if ( index < m_Proxies.size() && m_Proxies[ index ] )
 	{
 		// find the appropriate pre-allocated proxy
 		RefCountProxy< Object >* proxy = m_Proxies[ index ];
@@ -394,65 +1453,111 @@ Reflect::ObjectPtr ArchiveReader::AllocateObject( const Reflect::MetaClass* type
 
 bool ArchiveReader::Resolve( const Name& identity, ObjectPtr& pointer, const MetaClass* pointerClass )
 {
-	if ( !m_Resolver || !m_Resolver->Resolve( identity, pointer, pointerClass ) )
+	if ( m_Resolver && m_Resolver->Resolve( identity, pointer, pointerClass ) )
+	{
+		return true;
+	}
+
+	if ( identity.IsEmpty() )
+	{
+		pointer.Release();
+		return true;
+	}
+
+	uint32_t index = Invalid< uint32_t >();
+	String str ( identity.Get() );
+
+	int parseSuccessful = str.Parse( "%d", &index );
+	if ( !parseSuccessful )
+	{
+		HELIUM_TRACE(
+			TraceLevels::Warning,
+			"ArchiveReader::Resolve - Could not parse identity '%s' as a number!\n", 
+			*str);
+		return false;
+	}
+
+	return ResolveIndex( index, pointer, pointerClass );
+}
+
+bool ArchiveReader::Resolve( uint32_t index, ObjectPtr& pointer, const MetaClass* pointerClass )
+{
+	if ( m_Resolver && m_Resolver->Resolve( index, pointer, pointerClass ) )
+	{
+		return true;
+	}
+
+	if ( index == Invalid< uint32_t >() )
 	{
-		uint32_t index = Invalid< uint32_t >();
-		String str ( identity.Get() );
+		pointer.Release();
+		return true;
+	}
 
-		Object* found = NULL;
-		int parseSuccessful = str.Parse( "%d", &index );
+	return ResolveIndex( index, pointer, pointerClass );
+}
+
+bool ArchiveReader::ResolveIndex( uint32_t index, ObjectPtr& pointer, const MetaClass* pointerClass )
+{
+	// reading in parallel, the objects are still being filled in but they all have their proxies already
+	ReadWorker* worker = static_cast< ReadWorker* >( g_ReadWorker.GetPointer() );
+	if ( worker && worker->m_Archive == this )
+	{
+		pointer.Release();
 
-		if ( !parseSuccessful )
+		if ( index < m_Proxies.size() )
 		{
-			HELIUM_TRACE(
-				TraceLevels::Warning,
-				"ArchiveReader::Resolve - Could not parse identity '%s' as a number!\n", 
-				*str);
-			return false;
+			RefCountProxy< Reflect::Object >* proxy = m_Proxies[ index ];
+			pointer.SetProxy( reinterpret_cast< RefCountProxyBase< Reflect::Object >* >( proxy ) );
+			proxy->AddStrongRef();
+			worker->m_Fixups.Push( Fixup ( index, pointerClass ) );
 		}
-		else if ( index < m_Objects.GetSize() )
+
+		return true;
+	}
+
+	Object* found = NULL;
+	if ( index < m_Objects.GetSize() )
+	{
+		found = m_Objects.GetElement( index );
+	}
+
+	if ( found )
+	{
+		if ( !found->IsA( pointerClass ) )
 		{
-			found = m_Objects.GetElement( index );
+			Log::Warning( "Object of type '%s' is not valid for pointer type '%s'", found->GetMetaClass()->m_Name, pointerClass->m_Name );
 		}
-
-		if ( found )
+		else
 		{
-			if ( !found->IsA( pointerClass ) )
-			{
-				Log::Warning( "Object of type '%s' is not valid for pointer type '%s'", pointer->GetMetaClass()->m_Name, pointerClass->m_Name );
-			}
-			else
-			{
-				pointer = found;
-			}
+			pointer = found;
 		}
-		else // not found yet, must be later in the file, add a fixup to try again once the objects are done loading
+	}
+	else // not found yet, must be later in the file, add a fixup to try again once the objects are done loading
+	{
+		// ensure our list of proxies is sufficient size for this index
+		if ( m_Proxies.size() < index+1 )
 		{
-			// ensure our list of proxies is sufficient size for this index
-			if ( m_Proxies.size() < index+1 )
-			{
-				m_Proxies.resize( index+1 );
-			}
+			m_Proxies.resize( index+1 );
+		}
 
-			// ensure that we have allocated a proxy for this object
-			RefCountProxy< Reflect::Object >* proxy = m_Proxies[ index ];
-			if ( !proxy )
-			{
-				proxy = Object::RefCountSupportType::Allocate();
-				MemorySet( proxy, 0 , sizeof( *proxy ) );
-				m_Proxies[ index ] = proxy;
-			}
+		// ensure that we have allocated a proxy for this object
+		RefCountProxy< Reflect::Object >* proxy = m_Proxies[ index ];
+		if ( !proxy )
+		{
+			proxy = Object::RefCountSupportType::Allocate();
+			MemorySet( proxy, 0 , sizeof( *proxy ) );
+			m_Proxies[ index ] = proxy;
+		}
 
-			// release whatever we might already be pointing at and set the pointer to look at our pre-allocated proxy
-			pointer.Release();
-			pointer.SetProxy( reinterpret_cast< RefCountProxyBase< Reflect::Object >* >( proxy ) );
+		// release whatever we might already be pointing at and set the pointer to look at our pre-allocated proxy
+		pointer.Release();
+		pointer.SetProxy( reinterpret_cast< RefCountProxyBase< Reflect::Object >* >( proxy ) );
 
-			// Make sure the proxy accounts for our reference
-			proxy->AddStrongRef();
+		// Make sure the proxy accounts for our reference
+		proxy->AddStrongRef();
 
-			// kick down the road the association of the proxy with the object (we will find it again by index)
-			m_Fixups.Push( Fixup ( index, pointerClass ) );
-		}
+		// kick down the road the association of the proxy with the object (we will find it again by index)
+		m_Fixups.Push( Fixup ( index, pointerClass ) );
 	}
 
 	return true;
@@ -464,6 +1569,18 @@ void ArchiveReader::Resolve()
 	info.m_Progress = 100;
 	e_Status.Raise( info );
 
+	// pointers made before their object was read couldn't check its type, so check them now
+	for ( size_t i=0; i<m_Fixups.GetSize(); ++i )
+	{
+		const Fixup& fixup = m_Fixups[ i ];
+		Object* found = fixup.m_Index < m_Objects.GetSize() ? m_Objects[ fixup.m_Index ].Ptr() : NULL;
+		if ( found && !found->IsA( fixup.m_PointerClass ) )
+		{
+			Log::Warning( "Object of type '%s' is not valid for pointer type '%s'", found->GetMetaClass()->m_Name, fixup.m_PointerClass->m_Name );
+		}
+	}
+	m_Fixups.Clear();
+
 	// do any necessary object finalization here
 
 	info.m_State = ArchiveStates::Complete;
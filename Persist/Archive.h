@@ -6,10 +6,12 @@
 #include "Foundation/FilePath.h"
 #include "Foundation/Log.h" 
 #include "Foundation/SmartPtr.h"
+#include "Foundation/Stream.h"
 
 #include "Reflect/MetaClass.h"
 #include "Reflect/Exceptions.h"
 #include "Reflect/Object.h"
+#include "Reflect/ObjectGraph.h"
 #include "Reflect/Translator.h"
 
 #include "Persist/API.h"
@@ -30,6 +32,9 @@ namespace Helium
 			{
 				Notify      = 1 << 0, // Notify objects of changes
 				StringCrc   = 1 << 1, // Using string CRC-32 values for meta-data instead of full strings (for brevity)
+				Delta       = 1 << 2, // Write only the dirty objects and fields (see Object::SetDirtyTracking), MessagePack only
+				Parallel    = 1 << 3, // Read or write the top level objects on worker threads (the resolver or identifier must be thread safe), MessagePack only, other types ignore it
+				Compress    = 1 << 4, // Compress the file in independent blocks (see CompressedStream), for archives opened from a path
 			};
 		}
 
@@ -41,6 +46,7 @@ namespace Helium
 				Bson,
 				Json,
 				MessagePack,
+				Binary,
 				Count,
 			};
 		}
@@ -113,13 +119,31 @@ namespace Helium
 			virtual void        Open() = 0;
 			virtual void        Close() = 0;
 
+			// worker threads used by ArchiveFlags::Parallel and ArchiveFlags::Compress, 0 (the default) is one per processor
+			void SetThreadCount( uint32_t count );
+			uint32_t GetThreadCount() const;
+
 			ArchiveStatusSignature::Event e_Status;
 
 		protected:
+			// open m_Path for the archive's mode, wrapped in a CompressedStream for ArchiveFlags::Compress
+			Stream* OpenStream();
+
+			// sequences of numbers (or of structures of one type of number, like vectors) as one block of little endian
+			//  values after the names of the fields they come from, false if the sequence is short or its items aren't
+			//  stored that way
+			static bool PackSequence( Reflect::Pointer pointer, Reflect::SequenceTranslator* sequence, DynamicArray< uint8_t >& packed );
+
+			// structures whose fields don't match the names are read field by field, otherwise this returns false
+			//  (leaving the sequence alone) if the packed items don't have the layout of the sequence's items
+			static bool UnpackSequence( const void* packed, size_t size, Reflect::Pointer pointer, Reflect::SequenceTranslator* sequence );
+
 			uint32_t           m_Progress; // in bytes
 			bool               m_Abort;
 			const uint8_t      m_Flags;
 			FilePath           m_Path;
+			uint32_t           m_ThreadCount;
+			AutoPtr< Stream >  m_File;     // under the CompressedStream returned by OpenStream
 		};
 
 		//
@@ -129,9 +153,17 @@ namespace Helium
 		class HELIUM_PERSIST_API ArchiveWriter : public Archive, public Reflect::ObjectIdentifier
 		{
 		public:
-			static SmartPtr< ArchiveWriter > GetWriter( const FilePath& path, Reflect::ObjectIdentifier* identifier = NULL, ArchiveType archiveType = ArchiveTypes::Auto );
-			static bool                      WriteToFile( const FilePath& path, const Reflect::ObjectPtr& object, Reflect::ObjectIdentifier* identifier = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL );
-			static bool                      WriteToFile( const FilePath& path, const Reflect::ObjectPtr* objects, size_t count, Reflect::ObjectIdentifier* identifier = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL );
+			static SmartPtr< ArchiveWriter > GetWriter( const FilePath& path, Reflect::ObjectIdentifier* identifier = NULL, ArchiveType archiveType = ArchiveTypes::Auto, uint32_t flags = 0 );
+			static bool                      WriteToFile( const FilePath& path, const Reflect::ObjectPtr& object, Reflect::ObjectIdentifier* identifier = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL, uint32_t flags = 0 );
+			static bool                      WriteToFile( const FilePath& path, const Reflect::ObjectPtr* objects, size_t count, Reflect::ObjectIdentifier* identifier = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL, uint32_t flags = 0 );
+
+			// A delta archive (ArchiveFlags::Delta) holds the dirty fields of the dirty objects, addressed by their
+			//  position in the object list (so pass every object of the document, in the same order each time).
+			//  Reading a delta into the objects read from the archive it follows applies the changes to them.
+			//  Writing either kind of archive to a file clears the dirty fields of the objects it wrote.
+
+			// Apply a chain of deltas to the full archive at path, and rewrite it as a full archive
+			static bool                      CompactToFile( const FilePath& path, const FilePath* deltaPaths, size_t deltaCount, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL );
 
 			ArchiveWriter( Reflect::ObjectIdentifier* identifier, uint32_t flags );
 			ArchiveWriter( const FilePath& path, Reflect::ObjectIdentifier* identifier, uint32_t flags );
@@ -141,9 +173,40 @@ namespace Helium
 		protected:
 			virtual void Write( const Reflect::ObjectPtr* objects, size_t count ) = 0;
 			virtual bool Identify( const Reflect::ObjectPtr& object, Name* identity ) override;
+			virtual bool Identify( const Reflect::ObjectPtr& object, uint32_t& index ) override;
+
+			// Parallel writes: IdentifyObjects finds every object that will be written, and its index, by walking
+			//  the fields of m_Objects (on worker threads) in the order the backend serializes them, inlineOwned
+			//  for backends that write strictly owned objects in place.  WriteParallel then has worker threads call
+			//  WriteParallelObjects for batches of them, into a buffer per batch that the backend concatenates.
+			//  Identify only looks objects up while the workers run, so the output matches a serial write,
+			//  as long as PreSerialize doesn't change what an object points to.  Deltas are written serially, and
+			//  so is everything when there's only the one thread (the batches would only add overhead).
+			struct ParallelChunk
+			{
+				DynamicArray< uint8_t > m_Data;
+				uint32_t                m_Count;  // of objects in m_Data
+			};
+
+			bool         IsParallel() const;
+			void         IdentifyObjects( bool inlineOwned );
+			void         WriteParallel( DynamicArray< ParallelChunk >& chunks );
+			virtual void WriteParallelObjects( size_t first, size_t last, Stream& stream );
 
 			DynamicArray< Reflect::ObjectPtr > m_Objects;
 			Reflect::ObjectIdentifier*         m_Identifier;
+
+		private:
+			struct ParallelWrite;
+			struct WriteWorker;
+
+			bool IndexObject( const Reflect::ObjectPtr& object, uint32_t* index );
+			void RunParallel( ParallelWrite& write );
+			void WriteBatches( ParallelWrite& write, bool notify );
+
+			Reflect::ObjectIndex               m_ObjectIndices;  // of m_Objects, which only grows
+			size_t                             m_IndexedCount;   // m_Objects are added to m_ObjectIndices lazily
+			bool                               m_Identified;     // by IdentifyObjects, so Identify only looks objects up
 		};
 
 		//
@@ -153,10 +216,10 @@ namespace Helium
 		class HELIUM_PERSIST_API ArchiveReader : public Archive, public Reflect::ObjectResolver
 		{
 		public:
-			static SmartPtr< ArchiveReader > GetReader( const FilePath& path, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto );
-			static bool                      ReadFromFile( const FilePath& path, Reflect::ObjectPtr& object, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL );
-			static Reflect::ObjectPtr        ReadFromFile( const FilePath& path, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL );
-			static bool                      ReadFromFile( const FilePath& path, DynamicArray< Reflect::ObjectPtr >& objects, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL );
+			static SmartPtr< ArchiveReader > GetReader( const FilePath& path, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto, uint32_t flags = 0 );
+			static bool                      ReadFromFile( const FilePath& path, Reflect::ObjectPtr& object, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL, uint32_t flags = 0 );
+			static Reflect::ObjectPtr        ReadFromFile( const FilePath& path, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL, uint32_t flags = 0 );
+			static bool                      ReadFromFile( const FilePath& path, DynamicArray< Reflect::ObjectPtr >& objects, Reflect::ObjectResolver* resolver = NULL, ArchiveType archiveType = ArchiveTypes::Auto, std::string* error = NULL, uint32_t flags = 0 );
 
 			ArchiveReader( Reflect::ObjectResolver* resolver, uint32_t flags );
 			ArchiveReader( const FilePath& path, Reflect::ObjectResolver* resolver, uint32_t flags );
@@ -167,8 +230,20 @@ namespace Helium
 			virtual void       Read( DynamicArray< Reflect::ObjectPtr >& objects ) = 0;
 			Reflect::ObjectPtr AllocateObject( const Reflect::MetaClass* type, size_t index );
 			bool               Resolve( const Name& identity, Reflect::ObjectPtr& pointer, const Reflect::MetaClass* pointerClass ) override;
+			bool               Resolve( uint32_t index, Reflect::ObjectPtr& pointer, const Reflect::MetaClass* pointerClass ) override;
 			void               Resolve();
 
+			// resolve an index into m_Objects, or set up a fixup for an object not read yet
+			virtual bool       ResolveIndex( uint32_t index, Reflect::ObjectPtr& pointer, const Reflect::MetaClass* pointerClass );
+
+			// Parallel reads: once the backend has found where each top level object starts, ReadParallel calls
+			//  ReadParallelObject for every one of them from worker threads.  All the objects get their proxies up
+			//  front, so pointers between them are fixups that need no shared state, and Resolve() checks them
+			//  once the workers are done.  Only a fresh object list is read this way (not deltas, or existing objects).
+			bool               IsParallel() const;
+			void               ReadParallel( size_t count );
+			virtual void       ReadParallelObject( size_t index, Reflect::ObjectPtr& object );
+
 			struct Fixup
 			{
 				Fixup( const Fixup& rhs )
@@ -189,6 +264,12 @@ namespace Helium
 			DynamicArray< Fixup >                             m_Fixups;
 			DynamicArray< Reflect::ObjectPtr >                m_Objects;
 			Reflect::ObjectResolver*                          m_Resolver;
+
+		private:
+			struct ParallelRead;
+			struct ReadWorker;
+
+			void ReadObjects( ParallelRead& read, ReadWorker& worker, bool notify );
 		};
 	}
 }
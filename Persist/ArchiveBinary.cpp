@@ -0,0 +1,1254 @@
+#include "Precompile.h"
+#include "Persist/ArchiveBinary.h"
+
+#include "Reflect/Object.h"
+#include "Reflect/MetaStruct.h"
+#include "Reflect/Registry.h"
+#include "Reflect/TranslatorDeduction.h"
+
+using namespace Helium;
+using namespace Helium::Reflect;
+using namespace Helium::Persist;
+
+static const uint32_t BinaryMagic = 0x48504241; // 'HPBA'
+static const uint32_t BinaryVersion = 1;
+static const uint32_t BinaryByteOrder = 0x01020304;
+
+// object data is handed to the stream in chunks of about this size
+static const size_t BinaryBufferSize = 64 * 1024;
+
+struct BinaryHeader
+{
+	uint32_t m_Magic;
+	uint32_t m_Version;
+	uint32_t m_ByteOrder;       // BinaryByteOrder, as the writer stored it
+	uint32_t m_StructureCount;
+	uint32_t m_ObjectCount;
+	uint32_t m_SchemaSize;
+	uint64_t m_SchemaOffset;    // the object data runs from the header to here, the index follows the schema
+};
+
+struct BinaryIndexEntry
+{
+	uint64_t m_Offset;
+	uint32_t m_Size;
+	uint32_t m_Structure;
+};
+
+//
+// The schema describes each field's type as a string of codes: scalars are their ScalarTypes value, and the
+//  rest are followed by what they hold.  Values are written in that shape: scalars as themselves (booleans as
+//  a byte), strings and containers led by a 32-bit length, and structures as their fields in schema order.
+//
+
+namespace BinaryTypes
+{
+	enum BinaryType
+	{
+		Structure = ScalarTypes::String + 1, // then the structure's 32-bit index in the schema
+		Set,                                 // then the item type
+		Sequence,                            // then the item type
+		Association,                         // then the key type, and the value type
+		Pointer,                             // a 32-bit object index, all bits set for null
+	};
+}
+
+// size of the scalar types, strings are variable
+static const uint8_t ScalarSizes[] = { 1, 1, 2, 4, 8, 1, 2, 4, 8, 4, 8, 0 };
+
+// archives written with an identifier store pointers as its names, otherwise they are indices
+static bool IsIndexedPointer( Translator* translator, ObjectIdentifier* identifier )
+{
+	return !identifier && translator->GetMetaId() == MetaIds::PointerTranslator;
+}
+
+template< class T >
+static void AppendBinary( DynamicArray< uint8_t >& buffer, const T& value )
+{
+	buffer.AddArray( reinterpret_cast< const uint8_t* >( &value ), sizeof( T ) );
+}
+
+static void AppendBinaryString( DynamicArray< uint8_t >& buffer, const char* value, size_t length )
+{
+	AppendBinary( buffer, static_cast< uint32_t >( length ) );
+	buffer.AddArray( reinterpret_cast< const uint8_t* >( value ), length );
+}
+
+static uint32_t GetStructureIndex( const uint8_t* type )
+{
+	uint32_t index = 0;
+	MemoryCopy( &index, type + 1, sizeof( index ) );
+	return index;
+}
+
+// returns the end of a type from the schema, which has already been checked
+static const uint8_t* SkipType( const uint8_t* type )
+{
+	switch ( *type )
+	{
+	case BinaryTypes::Structure:
+		return type + 1 + sizeof( uint32_t );
+
+	case BinaryTypes::Set:
+	case BinaryTypes::Sequence:
+		return SkipType( type + 1 );
+
+	case BinaryTypes::Association:
+		return SkipType( SkipType( type + 1 ) );
+
+	default:
+		return type + 1;
+	}
+}
+
+// returns the end of a type read from a file, or NULL if it runs off the end or isn't valid
+static const uint8_t* ValidateType( const uint8_t* type, const uint8_t* end, uint32_t structureCount )
+{
+	if ( !type || type >= end )
+	{
+		return NULL;
+	}
+
+	switch ( *type )
+	{
+	case BinaryTypes::Structure:
+		return end - type > static_cast< ptrdiff_t >( sizeof( uint32_t ) ) && GetStructureIndex( type ) < structureCount ? type + 1 + sizeof( uint32_t ) : NULL;
+
+	case BinaryTypes::Set:
+	case BinaryTypes::Sequence:
+		return ValidateType( type + 1, end, structureCount );
+
+	case BinaryTypes::Association:
+		return ValidateType( ValidateType( type + 1, end, structureCount ), end, structureCount );
+
+	case BinaryTypes::Pointer:
+		return type + 1;
+
+	default:
+		return *type <= ScalarTypes::String ? type + 1 : NULL;
+	}
+}
+
+void ArchiveWriterBinary::WriteToStream( const ObjectPtr& object, Stream& stream, ObjectIdentifier* identifier, uint32_t flags )
+{
+	ArchiveWriterBinary archive ( &stream, identifier, flags );
+	archive.Write( &object, 1 );
+	archive.Close();
+}
+
+void ArchiveWriterBinary::WriteToStream( const ObjectPtr* objects, size_t count, Stream& stream, ObjectIdentifier* identifier, uint32_t flags )
+{
+	ArchiveWriterBinary archive ( &stream, identifier, flags );
+	archive.Write( objects, count );
+	archive.Close();
+}
+
+ArchiveWriterBinary::ArchiveWriterBinary( const FilePath& path, ObjectIdentifier* identifier, uint32_t flags )
+	: ArchiveWriter( path, identifier, flags )
+	, m_Offset( 0 )
+{
+}
+
+ArchiveWriterBinary::ArchiveWriterBinary( Stream *stream, ObjectIdentifier* identifier, uint32_t flags )
+	: ArchiveWriter( identifier, flags )
+	, m_Offset( 0 )
+{
+	m_Stream.Reset( stream );
+	m_Stream.Orphan( true );
+}
+
+ArchiveType ArchiveWriterBinary::GetType() const
+{
+	return ArchiveTypes::Binary;
+}
+
+void ArchiveWriterBinary::Open()
+{
+#if PERSIST_ARCHIVE_VERBOSE
+	Log::Print("Opening file '%s'\n", m_Path.c_str());
+#endif
+
+	Stream* stream = OpenStream();
+	m_Stream.Reset( stream );
+}
+
+void ArchiveWriterBinary::Close()
+{
+	HELIUM_ASSERT( m_Stream );
+	m_Stream->Close();
+}
+
+void ArchiveWriterBinary::Write( const Reflect::ObjectPtr* objects, size_t count )
+{
+	HELIUM_PERSIST_SCOPE_TIMER( "Reflect - Binary Write" );
+
+	// notify starting
+	ArchiveStatus info( *this, ArchiveStates::Starting );
+	e_Status.Raise( info );
+
+	// the master object
+	m_Objects.AddArray( objects, count );
+
+	// the header is written again once we know where everything went
+	BinaryHeader header;
+	MemoryZero( &header, sizeof( header ) );
+	int64_t start = m_Stream->Tell();
+	m_Stream->Write( header );
+	m_Offset = start + sizeof( header );
+
+	// objects can get added during this iteration (in Identify), so use indices
+	DynamicArray< BinaryIndexEntry > index;
+	for ( size_t i = 0; i < m_Objects.GetSize(); ++i )
+	{
+		Object* object = m_Objects.GetElement( i );
+
+		BinaryIndexEntry entry;
+		entry.m_Offset = m_Offset + m_Buffer.GetSize();
+		entry.m_Structure = AddStructure( object->GetMetaClass() );
+		SerializeInstance( object, entry.m_Structure, object );
+		entry.m_Size = static_cast< uint32_t >( m_Offset + m_Buffer.GetSize() - entry.m_Offset );
+		index.Add( entry );
+
+		if ( m_Buffer.GetSize() >= BinaryBufferSize )
+		{
+			FlushBuffer();
+		}
+
+		info.m_State = ArchiveStates::ObjectProcessed;
+		info.m_Progress = (int)(((float)(i) / (float)m_Objects.GetSize()) * 100.0f);
+		e_Status.Raise( info );
+	}
+
+	FlushBuffer();
+
+	DynamicArray< uint8_t > schema;
+	WriteSchema( schema );
+
+	header.m_Magic = BinaryMagic;
+	header.m_Version = BinaryVersion;
+	header.m_ByteOrder = BinaryByteOrder;
+	header.m_StructureCount = static_cast< uint32_t >( m_Structures.GetSize() );
+	header.m_ObjectCount = static_cast< uint32_t >( index.GetSize() );
+	header.m_SchemaSize = static_cast< uint32_t >( schema.GetSize() );
+	header.m_SchemaOffset = m_Offset;
+
+	m_Stream->Write( schema.GetData(), 1, schema.GetSize() );
+	if ( !index.IsEmpty() )
+	{
+		m_Stream->Write( index.GetData(), sizeof( BinaryIndexEntry ), index.GetSize() );
+	}
+
+	int64_t end = m_Stream->Tell();
+	m_Stream->Seek( start, SeekOrigins::Begin );
+	m_Stream->Write( header );
+	m_Stream->Seek( end, SeekOrigins::Begin );
+
+	// notify completion of last object processed
+	info.m_State = ArchiveStates::ObjectProcessed;
+	info.m_Progress = 100;
+	e_Status.Raise( info );
+
+	// do cleanup
+	m_Stream->Flush();
+
+	// notify completion
+	info.m_State = ArchiveStates::Complete;
+	e_Status.Raise( info );
+}
+
+uint32_t ArchiveWriterBinary::AddStructure( const MetaStruct* structure )
+{
+	HashMap< const MetaStruct*, uint32_t >::ConstIterator found = m_StructureIndices.Find( structure );
+	if ( found != m_StructureIndices.End() )
+	{
+		return found->Second();
+	}
+
+	uint32_t index = static_cast< uint32_t >( m_Structures.GetSize() );
+	m_StructureIndices.Insert( HashMap< const MetaStruct*, uint32_t >::ValueType( structure, index ) );
+
+	// fields are laid out base first, like the other archives write them
+	DynamicArray< const MetaStruct* > bases;
+	for ( const MetaStruct* current = structure; current != NULL; current = current->m_Base )
+	{
+		bases.Push( current );
+	}
+
+	Structure entry;
+	entry.m_Structure = structure;
+	entry.m_FirstField = static_cast< uint32_t >( m_Fields.GetSize() );
+	while ( !bases.IsEmpty() )
+	{
+		const MetaStruct* current = bases.Pop();
+		for ( DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin(), end = current->m_Fields.End(); itr != end; ++itr )
+		{
+			if ( !( itr->m_Flags & FieldFlags::Discard ) )
+			{
+				m_Fields.Push( &*itr );
+			}
+		}
+	}
+	entry.m_FieldCount = static_cast< uint32_t >( m_Fields.GetSize() ) - entry.m_FirstField;
+	m_Structures.Add( entry );
+
+	// the structures our fields hold get entries of their own
+	for ( uint32_t i = entry.m_FirstField; i < entry.m_FirstField + entry.m_FieldCount; ++i )
+	{
+		AddTypes( m_Fields[ i ]->m_Translator );
+	}
+
+	return index;
+}
+
+void ArchiveWriterBinary::AddTypes( Translator* translator )
+{
+	switch ( translator->GetMetaId() )
+	{
+	case MetaIds::StructureTranslator:
+		AddStructure( static_cast< StructureTranslator* >( translator )->GetMetaStruct() );
+		break;
+
+	case MetaIds::SetTranslator:
+		AddTypes( static_cast< SetTranslator* >( translator )->GetItemTranslator() );
+		break;
+
+	case MetaIds::SequenceTranslator:
+		AddTypes( static_cast< SequenceTranslator* >( translator )->GetItemTranslator() );
+		break;
+
+	case MetaIds::AssociationTranslator:
+		AddTypes( static_cast< AssociationTranslator* >( translator )->GetKeyTranslator() );
+		AddTypes( static_cast< AssociationTranslator* >( translator )->GetValueTranslator() );
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ArchiveWriterBinary::DescribeType( Translator* translator, DynamicArray< uint8_t >& schema )
+{
+	if ( IsIndexedPointer( translator, m_Identifier ) )
+	{
+		schema.Add( BinaryTypes::Pointer );
+		return;
+	}
+
+	if ( translator->IsA( MetaIds::ScalarTranslator ) )
+	{
+		schema.Add( static_cast< uint8_t >( static_cast< ScalarTranslator* >( translator )->m_Type ) );
+		return;
+	}
+
+	switch ( translator->GetMetaId() )
+	{
+	case MetaIds::StructureTranslator:
+		{
+			HashMap< const MetaStruct*, uint32_t >::ConstIterator found = m_StructureIndices.Find( static_cast< StructureTranslator* >( translator )->GetMetaStruct() );
+			HELIUM_ASSERT( found != m_StructureIndices.End() );
+			schema.Add( BinaryTypes::Structure );
+			AppendBinary( schema, found->Second() );
+			break;
+		}
+
+	case MetaIds::SetTranslator:
+		schema.Add( BinaryTypes::Set );
+		DescribeType( static_cast< SetTranslator* >( translator )->GetItemTranslator(), schema );
+		break;
+
+	case MetaIds::SequenceTranslator:
+		schema.Add( BinaryTypes::Sequence );
+		DescribeType( static_cast< SequenceTranslator* >( translator )->GetItemTranslator(), schema );
+		break;
+
+	case MetaIds::AssociationTranslator:
+		schema.Add( BinaryTypes::Association );
+		DescribeType( static_cast< AssociationTranslator* >( translator )->GetKeyTranslator(), schema );
+		DescribeType( static_cast< AssociationTranslator* >( translator )->GetValueTranslator(), schema );
+		break;
+
+	default:
+		// Unhandled reflection type in ArchiveWriterBinary::DescribeType
+		HELIUM_BREAK();
+	}
+}
+
+void ArchiveWriterBinary::WriteSchema( DynamicArray< uint8_t >& schema )
+{
+	for ( DynamicArray< Structure >::ConstIterator itr = m_Structures.Begin(), end = m_Structures.End(); itr != end; ++itr )
+	{
+		AppendBinaryString( schema, itr->m_Structure->m_Name, StringLength( itr->m_Structure->m_Name ) );
+		AppendBinary( schema, itr->m_FieldCount );
+
+		for ( uint32_t i = itr->m_FirstField; i < itr->m_FirstField + itr->m_FieldCount; ++i )
+		{
+			const Field* field = m_Fields[ i ];
+			AppendBinaryString( schema, field->m_Name, StringLength( field->m_Name ) );
+			AppendBinary( schema, field->m_Count );
+			DescribeType( field->m_Translator, schema );
+		}
+	}
+}
+
+void ArchiveWriterBinary::SerializeInstance( void* instance, uint32_t structure, Object* object )
+{
+#if PERSIST_ARCHIVE_VERBOSE
+	Log::Print("Serializing %s\n", m_Structures[ structure ].m_Structure->m_Name );
+#endif
+
+	uint32_t firstField = m_Structures[ structure ].m_FirstField;
+	uint32_t fieldCount = m_Structures[ structure ].m_FieldCount;
+
+	object->PreSerialize( NULL );
+
+	for ( uint32_t i = firstField; i < firstField + fieldCount; ++i )
+	{
+		const Field* field = m_Fields[ i ];
+		object->PreSerialize( field );
+
+		for ( uint32_t j = 0; j < field->m_Count; ++j )
+		{
+			SerializeTranslator( Pointer ( field, instance, object, j ), field->m_Translator, field, object );
+		}
+
+		object->PostSerialize( field );
+	}
+
+	object->PostSerialize( NULL );
+}
+
+void ArchiveWriterBinary::SerializeTranslator( Pointer pointer, Translator* translator, const Field* field, Object* object )
+{
+	if ( IsIndexedPointer( translator, m_Identifier ) )
+	{
+		uint32_t index = 0;
+		if ( !Reflect::Identify( this, pointer, index ) )
+		{
+			index = Invalid< uint32_t >();
+		}
+
+		AppendBinary( m_Buffer, index );
+		return;
+	}
+
+	if ( translator->IsA( MetaIds::ScalarTranslator ) )
+	{
+		ScalarTranslator* scalar = static_cast< ScalarTranslator* >( translator );
+		switch ( scalar->m_Type )
+		{
+		case ScalarTypes::Boolean:
+			AppendBinary( m_Buffer, static_cast< uint8_t >( pointer.As<bool>() ? 1 : 0 ) );
+			break;
+
+		case ScalarTypes::Unsigned8:
+			AppendBinary( m_Buffer, pointer.As<uint8_t>() );
+			break;
+
+		case ScalarTypes::Unsigned16:
+			AppendBinary( m_Buffer, pointer.As<uint16_t>() );
+			break;
+
+		case ScalarTypes::Unsigned32:
+			AppendBinary( m_Buffer, pointer.As<uint32_t>() );
+			break;
+
+		case ScalarTypes::Unsigned64:
+			AppendBinary( m_Buffer, pointer.As<uint64_t>() );
+			break;
+
+		case ScalarTypes::Signed8:
+			AppendBinary( m_Buffer, pointer.As<int8_t>() );
+			break;
+
+		case ScalarTypes::Signed16:
+			AppendBinary( m_Buffer, pointer.As<int16_t>() );
+			break;
+
+		case ScalarTypes::Signed32:
+			AppendBinary( m_Buffer, pointer.As<int32_t>() );
+			break;
+
+		case ScalarTypes::Signed64:
+			AppendBinary( m_Buffer, pointer.As<int64_t>() );
+			break;
+
+		case ScalarTypes::Float32:
+			AppendBinary( m_Buffer, pointer.As<float32_t>() );
+			break;
+
+		case ScalarTypes::Float64:
+			AppendBinary( m_Buffer, pointer.As<float64_t>() );
+			break;
+
+		case ScalarTypes::String:
+			String str;
+			scalar->Print( pointer, str, this );
+			AppendBinaryString( m_Buffer, str.GetData(), str.GetSize() );
+			break;
+		}
+
+		return;
+	}
+
+	switch ( translator->GetMetaId() )
+	{
+	case MetaIds::StructureTranslator:
+		{
+			StructureTranslator* structure = static_cast< StructureTranslator* >( translator );
+			HashMap< const MetaStruct*, uint32_t >::ConstIterator found = m_StructureIndices.Find( structure->GetMetaStruct() );
+			HELIUM_ASSERT( found != m_StructureIndices.End() );
+			SerializeInstance( pointer.m_Address, found->Second(), object );
+			break;
+		}
+
+	case MetaIds::SetTranslator:
+		{
+			SetTranslator* set = static_cast< SetTranslator* >( translator );
+
+			Translator* itemTranslator = set->GetItemTranslator();
+			DynamicArray< Pointer > items;
+			set->GetItems( pointer, items );
+
+			AppendBinary( m_Buffer, static_cast< uint32_t >( items.GetSize() ) );
+			for ( DynamicArray< Pointer >::Iterator itr = items.Begin(), end = items.End(); itr != end; ++itr )
+			{
+				SerializeTranslator( *itr, itemTranslator, field, object );
+			}
+
+			break;
+		}
+
+	case MetaIds::SequenceTranslator:
+		{
+			SequenceTranslator* sequence = static_cast< SequenceTranslator* >( translator );
+
+			Translator* itemTranslator = sequence->GetItemTranslator();
+			DynamicArray< Pointer > items;
+			sequence->GetItems( pointer, items );
+
+			AppendBinary( m_Buffer, static_cast< uint32_t >( items.GetSize() ) );
+			for ( DynamicArray< Pointer >::Iterator itr = items.Begin(), end = items.End(); itr != end; ++itr )
+			{
+				SerializeTranslator( *itr, itemTranslator, field, object );
+			}
+
+			break;
+		}
+
+	case MetaIds::AssociationTranslator:
+		{
+			AssociationTranslator* association = static_cast< AssociationTranslator* >( translator );
+
+			Translator* keyTranslator = association->GetKeyTranslator();
+			Translator* valueTranslator = association->GetValueTranslator();
+			DynamicArray< Pointer > keys, values;
+			association->GetItems( pointer, keys, values );
+
+			AppendBinary( m_Buffer, static_cast< uint32_t >( keys.GetSize() ) );
+			for ( DynamicArray< Pointer >::Iterator keyItr = keys.Begin(), valueItr = values.Begin(), keyEnd = keys.End(), valueEnd = values.End();
+				keyItr != keyEnd && valueItr != valueEnd;
+				++keyItr, ++valueItr )
+			{
+				SerializeTranslator( *keyItr, keyTranslator, field, object );
+				SerializeTranslator( *valueItr, valueTranslator, field, object );
+			}
+
+			break;
+		}
+
+	default:
+		// Unhandled reflection type in ArchiveWriterBinary::SerializeTranslator
+		HELIUM_BREAK();
+	}
+}
+
+void ArchiveWriterBinary::FlushBuffer()
+{
+	if ( !m_Buffer.IsEmpty() )
+	{
+		m_Stream->Write( m_Buffer.GetData(), 1, m_Buffer.GetSize() );
+		m_Offset += m_Buffer.GetSize();
+		m_Buffer.Resize( 0 );
+	}
+}
+
+//
+// Bounds checked reading from a block of the file
+//
+
+class ArchiveReaderBinary::Cursor
+{
+public:
+	Cursor( const uint8_t* data, size_t size )
+		: m_Data( data )
+		, m_End( data + size )
+	{
+	}
+
+	const uint8_t* GetData() const
+	{
+		return m_Data;
+	}
+
+	const uint8_t* GetEnd() const
+	{
+		return m_End;
+	}
+
+	void Advance( size_t size )
+	{
+		Check( size );
+		m_Data += size;
+	}
+
+	template< class T >
+	void Read( T& value )
+	{
+		Check( sizeof( T ) );
+		MemoryCopy( &value, m_Data, sizeof( T ) );
+		m_Data += sizeof( T );
+	}
+
+	void ReadString( String& value )
+	{
+		uint32_t length = 0;
+		Read( length );
+		Check( length );
+		value = String( reinterpret_cast< const char* >( m_Data ), length );
+		m_Data += length;
+	}
+
+private:
+	void Check( size_t size ) const
+	{
+		if ( static_cast< size_t >( m_End - m_Data ) < size )
+		{
+			throw Persist::StreamException( "Binary archive data is truncated" );
+		}
+	}
+
+	const uint8_t* m_Data;
+	const uint8_t* m_End;
+};
+
+void ArchiveReaderBinary::ReadFromStream( Stream& stream, ObjectPtr& object, ObjectResolver* resolver, uint32_t flags )
+{
+	DynamicArray< ObjectPtr > objects;
+	ReadFromStream( stream, objects, resolver, flags );
+	if ( !objects.IsEmpty() )
+	{
+		object = objects.GetFirst();
+	}
+}
+
+void ArchiveReaderBinary::ReadFromStream( Stream& stream, DynamicArray< ObjectPtr >& objects, ObjectResolver* resolver, uint32_t flags )
+{
+	ArchiveReaderBinary archive( &stream, resolver, flags );
+	archive.Read( objects );
+	archive.Close();
+}
+
+ArchiveReaderBinary::ArchiveReaderBinary( const FilePath& path, ObjectResolver* resolver, uint32_t flags )
+	: ArchiveReader( path, resolver, flags )
+	, m_Stream( NULL )
+	, m_Started( false )
+	, m_DataOffset( 0 )
+	, m_DataSize( 0 )
+{
+}
+
+ArchiveReaderBinary::ArchiveReaderBinary( Stream *stream, ObjectResolver* resolver, uint32_t flags )
+	: ArchiveReader( resolver, flags )
+	, m_Stream( NULL )
+	, m_Started( false )
+	, m_DataOffset( 0 )
+	, m_DataSize( 0 )
+{
+	m_Stream.Reset( stream );
+	m_Stream.Orphan( true );
+}
+
+ArchiveType ArchiveReaderBinary::GetType() const
+{
+	return ArchiveTypes::Binary;
+}
+
+void ArchiveReaderBinary::Open()
+{
+#if PERSIST_ARCHIVE_VERBOSE
+	Log::Print("Opening file '%s'\n", m_Path.c_str());
+#endif
+
+	Stream* stream = OpenStream();
+	m_Stream.Reset( stream );
+}
+
+void ArchiveReaderBinary::Close()
+{
+	HELIUM_ASSERT( m_Stream );
+	m_Stream->Close();
+}
+
+size_t ArchiveReaderBinary::GetObjectCount()
+{
+	Start();
+
+	return m_Entries.GetSize();
+}
+
+ObjectPtr ArchiveReaderBinary::ReadObject( size_t index )
+{
+	Start();
+
+	if ( index >= m_Entries.GetSize() )
+	{
+		return NULL;
+	}
+
+	// the objects this one points to are queued as they are found, rather than loaded then and there,
+	//  so a long chain of them doesn't take a long chain of calls
+	m_Pending.Clear();
+	QueueObject( index );
+	while ( !m_Pending.IsEmpty() )
+	{
+		LoadObject( m_Pending.Pop() );
+	}
+
+	return m_Objects[ index ];
+}
+
+void ArchiveReaderBinary::Read( DynamicArray< ObjectPtr >& objects )
+{
+	HELIUM_PERSIST_SCOPE_TIMER( "Reflect - Binary Read" );
+
+	Start();
+
+	// everything is read again, over the objects we were given
+	m_Objects = objects;
+	m_Objects.Resize( m_Entries.GetSize() );
+	m_Pending.Clear();
+	for ( size_t i = 0; i < m_Entries.GetSize(); ++i )
+	{
+		// every object is loaded in order below, so pointers to later ones are left as fixups
+		Entry& entry = m_Entries[ i ];
+		entry.m_Queued = true;
+
+		// an object read over one of another type replaces it, so nothing may point at the old one
+		const MetaClass* objectClass = ReflectionCast< const MetaClass >( m_Structures[ entry.m_Structure ].m_Structure );
+		if ( m_Objects[ i ] && m_Objects[ i ]->GetMetaClass() != objectClass )
+		{
+			m_Objects[ i ] = NULL;
+		}
+	}
+
+	// take all the object data in one read, rather than one per object
+	m_Data.Resize( static_cast< size_t >( m_DataSize ) );
+	m_Stream->Seek( m_DataOffset, SeekOrigins::Begin );
+	if ( m_DataSize && m_Stream->Read( m_Data.GetData(), 1, m_Data.GetSize() ) != m_Data.GetSize() )
+	{
+		throw Persist::StreamException( "Failed to read object data (%s)", m_Path.Data() );
+	}
+
+	for ( size_t i = 0; i < m_Entries.GetSize(); ++i )
+	{
+		LoadObject( i );
+
+		ArchiveStatus info( *this, ArchiveStates::ObjectProcessed );
+		info.m_Progress = (int)(((float)(i) / (float)m_Entries.GetSize()) * 100.0f);
+		e_Status.Raise( info );
+		m_Abort |= info.m_Abort;
+		if ( m_Abort )
+		{
+			break;
+		}
+	}
+
+	m_Data.Clear();
+
+	Resolve();
+
+	objects = m_Objects;
+}
+
+bool ArchiveReaderBinary::ResolveIndex( uint32_t index, ObjectPtr& pointer, const MetaClass* pointerClass )
+{
+	if ( index < m_Entries.GetSize() )
+	{
+		// an object of a type that's gone won't be made, so nothing can point at it
+		if ( !m_Structures[ m_Entries[ index ].m_Structure ].m_Structure )
+		{
+			pointer.Release();
+			return true;
+		}
+
+		// reading objects on demand, make the one this refers to now and fill it in once the current one is done
+		QueueObject( index );
+	}
+
+	return ArchiveReader::ResolveIndex( index, pointer, pointerClass );
+}
+
+void ArchiveReaderBinary::Start()
+{
+	if ( m_Started )
+	{
+		return;
+	}
+
+	m_Started = true;
+
+	ArchiveStatus info( *this, ArchiveStates::Starting );
+	e_Status.Raise( info );
+	m_Abort = false;
+
+	// determine the size of the input stream
+	m_Stream->Seek( 0, SeekOrigins::End );
+	int64_t size = m_Stream->Tell();
+	m_Stream->Seek( 0, SeekOrigins::Begin );
+
+	BinaryHeader header;
+	if ( size < static_cast< int64_t >( sizeof( header ) ) || m_Stream->Read( &header, sizeof( header ), 1 ) != 1 || header.m_Magic != BinaryMagic )
+	{
+		throw Persist::StreamException( "Input stream is not a binary archive (%s)", m_Path.Data() );
+	}
+
+	if ( header.m_ByteOrder != BinaryByteOrder )
+	{
+		throw Persist::StreamException( "Binary archive was written with the other byte order (%s)", m_Path.Data() );
+	}
+
+	if ( header.m_Version != BinaryVersion )
+	{
+		throw Persist::StreamException( "Binary archive version %u is not supported (%s)", header.m_Version, m_Path.Data() );
+	}
+
+	uint64_t indexOffset = header.m_SchemaOffset + header.m_SchemaSize;
+	if ( header.m_SchemaOffset < sizeof( header ) || indexOffset + header.m_ObjectCount * sizeof( BinaryIndexEntry ) != static_cast< uint64_t >( size ) )
+	{
+		throw Persist::StreamException( "Binary archive is truncated or corrupt (%s)", m_Path.Data() );
+	}
+
+	m_DataOffset = sizeof( header );
+	m_DataSize = header.m_SchemaOffset - sizeof( header );
+
+	m_Schema.Resize( header.m_SchemaSize );
+	DynamicArray< BinaryIndexEntry > index;
+	index.Resize( header.m_ObjectCount );
+
+	m_Stream->Seek( header.m_SchemaOffset, SeekOrigins::Begin );
+	if ( ( header.m_SchemaSize && m_Stream->Read( m_Schema.GetData(), 1, m_Schema.GetSize() ) != m_Schema.GetSize() )
+		|| ( header.m_ObjectCount && m_Stream->Read( index.GetData(), sizeof( BinaryIndexEntry ), index.GetSize() ) != index.GetSize() ) )
+	{
+		throw Persist::StreamException( "Failed to read binary archive schema (%s)", m_Path.Data() );
+	}
+
+	ReadSchema( header.m_StructureCount );
+
+	m_Entries.Reserve( index.GetSize() );
+	for ( DynamicArray< BinaryIndexEntry >::ConstIterator itr = index.Begin(), end = index.End(); itr != end; ++itr )
+	{
+		if ( itr->m_Offset < m_DataOffset || itr->m_Offset + itr->m_Size > header.m_SchemaOffset || itr->m_Structure >= m_Structures.GetSize() )
+		{
+			throw Persist::StreamException( "Binary archive index is corrupt (%s)", m_Path.Data() );
+		}
+
+		Entry entry = { itr->m_Offset, itr->m_Size, itr->m_Structure, false };
+		m_Entries.Add( entry );
+	}
+
+	m_Objects.Resize( m_Entries.GetSize() );
+}
+
+void ArchiveReaderBinary::ReadSchema( uint32_t structureCount )
+{
+	Cursor cursor( m_Schema.GetData(), m_Schema.GetSize() );
+
+	m_Structures.Reserve( structureCount );
+	for ( uint32_t i = 0; i < structureCount; ++i )
+	{
+		String name;
+		cursor.ReadString( name );
+
+		Structure structure;
+		structure.m_Structure = name.IsEmpty() ? NULL : Registry::GetInstance()->GetMetaStruct( Crc32( name.GetData() ) );
+		structure.m_FirstField = static_cast< uint32_t >( m_Fields.GetSize() );
+		cursor.Read( structure.m_FieldCount );
+
+		for ( uint32_t j = 0; j < structure.m_FieldCount; ++j )
+		{
+			String fieldName;
+			cursor.ReadString( fieldName );
+
+			SchemaField field;
+			field.m_Field = NULL;
+			field.m_NameCrc = fieldName.IsEmpty() ? 0 : Crc32( fieldName.GetData() );
+			cursor.Read( field.m_Count );
+			field.m_Type = cursor.GetData();
+
+			const uint8_t* typeEnd = ValidateType( field.m_Type, cursor.GetEnd(), structureCount );
+			if ( !typeEnd )
+			{
+				throw Persist::StreamException( "Binary archive schema is corrupt (%s)", m_Path.Data() );
+			}
+
+			cursor.Advance( typeEnd - field.m_Type );
+			m_Fields.Add( field );
+		}
+
+		if ( !structure.m_Structure )
+		{
+			HELIUM_TRACE( TraceLevels::Warning, "Binary archive type '%s' is not registered, its data will be skipped\n", *name );
+		}
+
+		m_Structures.Add( structure );
+	}
+
+	// match up the fields once every structure is known, since fields refer to them by index
+	for ( DynamicArray< Structure >::ConstIterator itr = m_Structures.Begin(), end = m_Structures.End(); itr != end; ++itr )
+	{
+		if ( itr->m_Structure )
+		{
+			for ( uint32_t i = itr->m_FirstField; i < itr->m_FirstField + itr->m_FieldCount; ++i )
+			{
+				SchemaField& schemaField = m_Fields[ i ];
+				const Field* field = itr->m_Structure->FindFieldByName( schemaField.m_NameCrc );
+				if ( field && !( field->m_Flags & FieldFlags::Discard ) && MatchType( schemaField.m_Type, field->m_Translator ) )
+				{
+					schemaField.m_Field = field;
+				}
+			}
+		}
+	}
+}
+
+bool ArchiveReaderBinary::MatchType( const uint8_t* type, Translator* translator ) const
+{
+	switch ( *type )
+	{
+	case BinaryTypes::Structure:
+		return translator->GetMetaId() == MetaIds::StructureTranslator
+			&& m_Structures[ GetStructureIndex( type ) ].m_Structure == static_cast< StructureTranslator* >( translator )->GetMetaStruct();
+
+	case BinaryTypes::Set:
+		return translator->GetMetaId() == MetaIds::SetTranslator
+			&& MatchType( type + 1, static_cast< SetTranslator* >( translator )->GetItemTranslator() );
+
+	case BinaryTypes::Sequence:
+		return translator->GetMetaId() == MetaIds::SequenceTranslator
+			&& MatchType( type + 1, static_cast< SequenceTranslator* >( translator )->GetItemTranslator() );
+
+	case BinaryTypes::Association:
+		return translator->GetMetaId() == MetaIds::AssociationTranslator
+			&& MatchType( type + 1, static_cast< AssociationTranslator* >( translator )->GetKeyTranslator() )
+			&& MatchType( SkipType( type + 1 ), static_cast< AssociationTranslator* >( translator )->GetValueTranslator() );
+
+	case BinaryTypes::Pointer:
+		return translator->GetMetaId() == MetaIds::PointerTranslator;
+
+	default:
+		return translator->IsA( MetaIds::ScalarTranslator )
+			&& static_cast< ScalarTranslator* >( translator )->m_Type == *type;
+	}
+}
+
+void ArchiveReaderBinary::QueueObject( size_t index )
+{
+	Entry& entry = m_Entries[ index ];
+	if ( entry.m_Queued )
+	{
+		return;
+	}
+
+	entry.m_Queued = true;
+
+	const MetaClass* objectClass = ReflectionCast< const MetaClass >( m_Structures[ entry.m_Structure ].m_Structure );
+	if ( objectClass && !m_Objects[ index ] )
+	{
+		m_Objects[ index ] = AllocateObject( objectClass, index );
+	}
+
+	m_Pending.Push( index );
+}
+
+void ArchiveReaderBinary::LoadObject( size_t index )
+{
+	Entry& entry = m_Entries[ index ];
+	HELIUM_ASSERT( entry.m_Queued );
+
+	// the object data is either all in memory already, or we fetch just this object's
+	DynamicArray< uint8_t > buffer;
+	const uint8_t* data = NULL;
+	if ( !m_Data.IsEmpty() )
+	{
+		data = m_Data.GetData() + ( entry.m_Offset - m_DataOffset );
+	}
+	else
+	{
+		buffer.Resize( entry.m_Size );
+		m_Stream->Seek( entry.m_Offset, SeekOrigins::Begin );
+		if ( entry.m_Size && m_Stream->Read( buffer.GetData(), 1, entry.m_Size ) != entry.m_Size )
+		{
+			throw Persist::StreamException( "Failed to read object %u (%s)", static_cast< uint32_t >( index ), m_Path.Data() );
+		}
+
+		data = buffer.GetData();
+	}
+
+	const MetaClass* objectClass = ReflectionCast< const MetaClass >( m_Structures[ entry.m_Structure ].m_Structure );
+
+	// an object read over one of another type replaces it
+	ObjectPtr object = m_Objects[ index ];
+	if ( object && object->GetMetaClass() != objectClass )
+	{
+		object = NULL;
+	}
+
+	if ( !object )
+	{
+		if ( !objectClass )
+		{
+			return;
+		}
+
+		object = AllocateObject( objectClass, index );
+	}
+
+	// in the list before its fields are read, so objects that point back at it find it
+	m_Objects[ index ] = object;
+
+	Cursor cursor( data, entry.m_Size );
+	DeserializeInstance( cursor, object, entry.m_Structure, object );
+}
+
+void ArchiveReaderBinary::DeserializeInstance( Cursor& cursor, void* instance, uint32_t structure, Object* object )
+{
+#if PERSIST_ARCHIVE_VERBOSE
+	Log::Print("Deserializing %s\n", m_Structures[ structure ].m_Structure->m_Name);
+#endif
+
+	uint32_t firstField = m_Structures[ structure ].m_FirstField;
+	uint32_t fieldCount = m_Structures[ structure ].m_FieldCount;
+
+	object->PreDeserialize( NULL );
+
+	for ( uint32_t i = firstField; i < firstField + fieldCount; ++i )
+	{
+		const SchemaField& schemaField = m_Fields[ i ];
+		const Field* field = schemaField.m_Field;
+		if ( field )
+		{
+			object->PreDeserialize( field );
+
+			for ( uint32_t j = 0; j < schemaField.m_Count; ++j )
+			{
+				if ( j < field->m_Count )
+				{
+					DeserializeTranslator( cursor, schemaField.m_Type, Pointer ( field, instance, object, j ), field->m_Translator, field, object );
+				}
+				else
+				{
+					Skip( cursor, schemaField.m_Type );
+				}
+			}
+
+			object->PostDeserialize( field );
+		}
+		else
+		{
+			for ( uint32_t j = 0; j < schemaField.m_Count; ++j )
+			{
+				Skip( cursor, schemaField.m_Type );
+			}
+		}
+	}
+
+	object->PostDeserialize( NULL );
+}
+
+void ArchiveReaderBinary::DeserializeTranslator( Cursor& cursor, const uint8_t* type, Pointer pointer, Translator* translator, const Field* field, Object* object )
+{
+	// the field's translator was matched against the type when the schema was read
+	switch ( *type )
+	{
+	case ScalarTypes::Boolean:
+		{
+			uint8_t value = 0;
+			cursor.Read( value );
+			pointer.As<bool>() = value != 0;
+			break;
+		}
+
+	case ScalarTypes::Unsigned8:
+		cursor.Read( pointer.As<uint8_t>() );
+		break;
+
+	case ScalarTypes::Unsigned16:
+		cursor.Read( pointer.As<uint16_t>() );
+		break;
+
+	case ScalarTypes::Unsigned32:
+		cursor.Read( pointer.As<uint32_t>() );
+		break;
+
+	case ScalarTypes::Unsigned64:
+		cursor.Read( pointer.As<uint64_t>() );
+		break;
+
+	case ScalarTypes::Signed8:
+		cursor.Read( pointer.As<int8_t>() );
+		break;
+
+	case ScalarTypes::Signed16:
+		cursor.Read( pointer.As<int16_t>() );
+		break;
+
+	case ScalarTypes::Signed32:
+		cursor.Read( pointer.As<int32_t>() );
+		break;
+
+	case ScalarTypes::Signed64:
+		cursor.Read( pointer.As<int64_t>() );
+		break;
+
+	case ScalarTypes::Float32:
+		cursor.Read( pointer.As<float32_t>() );
+		break;
+
+	case ScalarTypes::Float64:
+		cursor.Read( pointer.As<float64_t>() );
+		break;
+
+	case ScalarTypes::String:
+		{
+			String str;
+			cursor.ReadString( str );
+			static_cast< ScalarTranslator* >( translator )->Parse( str, pointer, this, ( m_Flags & ArchiveFlags::Notify ) != 0 );
+			break;
+		}
+
+	case BinaryTypes::Structure:
+		DeserializeInstance( cursor, pointer.m_Address, GetStructureIndex( type ), object );
+		break;
+
+	case BinaryTypes::Pointer:
+		{
+			uint32_t index = 0;
+			cursor.Read( index );
+			Reflect::Resolve( this, index, pointer );
+			pointer.RaiseChanged( ( m_Flags & ArchiveFlags::Notify ) != 0 );
+			break;
+		}
+
+	case BinaryTypes::Set:
+		{
+			SetTranslator* set = static_cast< SetTranslator* >( translator );
+			Translator* itemTranslator = set->GetItemTranslator();
+			uint32_t length = 0;
+			cursor.Read( length );
+			set->Clear( pointer ); // the archive holds the whole set, even when reading over existing data
+			for ( uint32_t i=0; i<length; ++i )
+			{
+				Variable item ( itemTranslator );
+				DeserializeTranslator( cursor, type + 1, item, itemTranslator, field, object );
+				set->InsertItem( pointer, item );
+			}
+			break;
+		}
+
+	case BinaryTypes::Sequence:
+		{
+			SequenceTranslator* sequence = static_cast< SequenceTranslator* >( translator );
+			Translator* itemTranslator = sequence->GetItemTranslator();
+			uint32_t length = 0;
+			cursor.Read( length );
+			sequence->SetLength( pointer, length );
+			for ( uint32_t i=0; i<length; ++i )
+			{
+				Pointer item = sequence->GetItem( pointer, i );
+				DeserializeTranslator( cursor, type + 1, item, itemTranslator, field, object );
+			}
+			break;
+		}
+
+	case BinaryTypes::Association:
+		{
+			AssociationTranslator* association = static_cast< AssociationTranslator* >( translator );
+			Translator* keyTranslator = association->GetKeyTranslator();
+			Translator* valueTranslator = association->GetValueTranslator();
+			const uint8_t* keyType = type + 1;
+			const uint8_t* valueType = SkipType( keyType );
+			uint32_t length = 0;
+			cursor.Read( length );
+			association->Clear( pointer ); // the archive holds the whole association, even when reading over existing data
+			for ( uint32_t i=0; i<length; ++i )
+			{
+				Variable key ( keyTranslator );
+				Variable value ( valueTranslator );
+				DeserializeTranslator( cursor, keyType, key, keyTranslator, field, object );
+				DeserializeTranslator( cursor, valueType, value, valueTranslator, field, object );
+				association->SetItem( pointer, key, value );
+			}
+			break;
+		}
+	}
+}
+
+void ArchiveReaderBinary::Skip( Cursor& cursor, const uint8_t* type ) const
+{
+	switch ( *type )
+	{
+	case ScalarTypes::String:
+		{
+			uint32_t length = 0;
+			cursor.Read( length );
+			cursor.Advance( length );
+			break;
+		}
+
+	case BinaryTypes::Structure:
+		{
+			const Structure& structure = m_Structures[ GetStructureIndex( type ) ];
+			for ( uint32_t i = structure.m_FirstField; i < structure.m_FirstField + structure.m_FieldCount; ++i )
+			{
+				for ( uint32_t j = 0; j < m_Fields[ i ].m_Count; ++j )
+				{
+					Skip( cursor, m_Fields[ i ].m_Type );
+				}
+			}
+			break;
+		}
+
+	case BinaryTypes::Set:
+	case BinaryTypes::Sequence:
+		{
+			uint32_t length = 0;
+			cursor.Read( length );
+			for ( uint32_t i=0; i<length; ++i )
+			{
+				Skip( cursor, type + 1 );
+			}
+			break;
+		}
+
+	case BinaryTypes::Association:
+		{
+			const uint8_t* valueType = SkipType( type + 1 );
+			uint32_t length = 0;
+			cursor.Read( length );
+			for ( uint32_t i=0; i<length; ++i )
+			{
+				Skip( cursor, type + 1 );
+				Skip( cursor, valueType );
+			}
+			break;
+		}
+
+	case BinaryTypes::Pointer:
+		cursor.Advance( sizeof( uint32_t ) );
+		break;
+
+	default:
+		cursor.Advance( ScalarSizes[ *type ] );
+		break;
+	}
+}
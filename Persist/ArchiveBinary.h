@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Foundation/DynamicArray.h"
+#include "Foundation/FilePath.h"
+#include "Foundation/HashMap.h"
+#include "Foundation/Stream.h"
+
+#include "Persist/Archive.h"
+
+namespace Helium
+{
+	namespace Persist
+	{
+		//
+		// Native binary archives store the field layout of each structure once, in a schema table, so objects are
+		//  just their field values packed back to back in schema order.  An index of where each object starts lets
+		//  ArchiveReaderBinary load single objects without parsing the rest of the file.  Values are written in
+		//  the byte order of the machine writing them, and the reader refuses files of the other byte order.
+		//
+		//  [ header ][ object data ... ][ schema table ][ object index ]
+		//
+
+		class HELIUM_PERSIST_API ArchiveWriterBinary : public ArchiveWriter
+		{
+		public:
+			static void WriteToStream( const Reflect::ObjectPtr& object, Stream& stream, Reflect::ObjectIdentifier* identifier = NULL, uint32_t flags = 0 );
+			static void WriteToStream( const Reflect::ObjectPtr* objects, size_t count, Stream& stream, Reflect::ObjectIdentifier* identifier = NULL, uint32_t flags = 0 );
+
+			ArchiveWriterBinary( const FilePath& path, Reflect::ObjectIdentifier* identifier = NULL, uint32_t flags = 0x0 );
+			ArchiveWriterBinary( Stream *stream, Reflect::ObjectIdentifier* identifier = NULL, uint32_t flags = 0x0 );
+
+			virtual ArchiveType GetType() const override;
+			virtual void Open() override;
+			virtual void Close() override;
+
+		protected:
+			virtual void Write( const Reflect::ObjectPtr* objects, size_t count ) override;
+
+		private:
+			struct Structure
+			{
+				const Reflect::MetaStruct* m_Structure;
+				uint32_t                   m_FirstField;  // in m_Fields
+				uint32_t                   m_FieldCount;
+			};
+
+			uint32_t AddStructure( const Reflect::MetaStruct* structure );
+			void AddTypes( Reflect::Translator* translator );
+			void DescribeType( Reflect::Translator* translator, DynamicArray< uint8_t >& schema );
+			void WriteSchema( DynamicArray< uint8_t >& schema );
+
+			void SerializeInstance( void* instance, uint32_t structure, Reflect::Object* object );
+			void SerializeTranslator( Reflect::Pointer pointer, Reflect::Translator* translator, const Reflect::Field* field, Reflect::Object* object );
+			void FlushBuffer();
+
+			AutoPtr< Stream >                               m_Stream;
+			DynamicArray< uint8_t >                         m_Buffer;    // pending object data
+			uint64_t                                        m_Offset;    // where m_Buffer starts in the stream
+			DynamicArray< Structure >                       m_Structures;
+			DynamicArray< const Reflect::Field* >           m_Fields;
+			HashMap< const Reflect::MetaStruct*, uint32_t > m_StructureIndices;
+		};
+
+		class HELIUM_PERSIST_API ArchiveReaderBinary : public ArchiveReader
+		{
+		public:
+			static void ReadFromStream( Stream& stream, Reflect::ObjectPtr& object, Reflect::ObjectResolver* resolver = NULL, uint32_t flags = 0 );
+			static void ReadFromStream( Stream& stream, DynamicArray< Reflect::ObjectPtr >& objects, Reflect::ObjectResolver* resolver = NULL, uint32_t flags = 0 );
+
+			ArchiveReaderBinary( const FilePath& path, Reflect::ObjectResolver* resolver = NULL, uint32_t flags = 0x0 );
+			ArchiveReaderBinary( Stream *stream, Reflect::ObjectResolver* resolver = NULL, uint32_t flags = 0x0 );
+
+			virtual ArchiveType GetType() const override;
+			virtual void Open() override;
+			virtual void Close() override;
+
+			// random access, objects are loaded on demand (along with the objects they point to) and kept
+			size_t             GetObjectCount();
+			Reflect::ObjectPtr ReadObject( size_t index );
+
+		protected:
+			virtual void Read( DynamicArray< Reflect::ObjectPtr >& objects ) override;
+			virtual bool ResolveIndex( uint32_t index, Reflect::ObjectPtr& pointer, const Reflect::MetaClass* pointerClass ) override;
+
+		private:
+			struct Structure
+			{
+				const Reflect::MetaStruct* m_Structure;   // NULL if the type is gone
+				uint32_t                   m_FirstField;  // in m_Fields
+				uint32_t                   m_FieldCount;
+			};
+
+			struct SchemaField
+			{
+				const Reflect::Field* m_Field;   // NULL if the field is gone or changed type, so it's skipped
+				const uint8_t*        m_Type;    // in m_Schema
+				uint32_t              m_NameCrc;
+				uint32_t              m_Count;
+			};
+
+			struct Entry
+			{
+				uint64_t m_Offset;
+				uint32_t m_Size;
+				uint32_t m_Structure;
+				bool     m_Queued;  // loaded, or waiting in m_Pending to be
+			};
+
+			class Cursor;
+
+			void Start();
+			void ReadSchema( uint32_t structureCount );
+			bool MatchType( const uint8_t* type, Reflect::Translator* translator ) const;
+			void QueueObject( size_t index );
+			void LoadObject( size_t index );
+
+			void DeserializeInstance( Cursor& cursor, void* instance, uint32_t structure, Reflect::Object* object );
+			void DeserializeTranslator( Cursor& cursor, const uint8_t* type, Reflect::Pointer pointer, Reflect::Translator* translator, const Reflect::Field* field, Reflect::Object* object );
+			void Skip( Cursor& cursor, const uint8_t* type ) const;
+
+			AutoPtr< Stream >           m_Stream;
+			bool                        m_Started;
+			DynamicArray< uint8_t >     m_Schema;
+			DynamicArray< Structure >   m_Structures;
+			DynamicArray< SchemaField > m_Fields;
+			DynamicArray< Entry >       m_Entries;
+			DynamicArray< size_t >      m_Pending;     // objects made by ReadObject, still to be filled in
+			DynamicArray< uint8_t >     m_Data;        // all the object data, while reading everything
+			uint64_t                    m_DataOffset;  // where the object data starts in the stream
+			uint64_t                    m_DataSize;
+		};
+	}
+}
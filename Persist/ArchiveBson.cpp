@@ -2,7 +2,6 @@
 #include "Persist/ArchiveBson.h"
 
 #include "Foundation/Endian.h"
-#include "Foundation/FileStream.h"
 #include "Foundation/Numeric.h"
 
 #include "Reflect/Object.h"
@@ -22,6 +21,21 @@ using namespace Helium;
 using namespace Helium::Reflect;
 using namespace Helium::Persist;
 
+// binary subtype of sequences written by Archive::PackSequence
+static const char PackedSequenceSubtype = static_cast< char >( BSON_BIN_USER );
+
+// dates and object ids have BSON types of their own, so sequences of them are written item by item
+static bool IsBsonStructure( const Translator* translator )
+{
+	if ( translator->GetMetaId() != MetaIds::StructureTranslator )
+	{
+		return false;
+	}
+
+	const MetaStruct* metaStruct = static_cast< const StructureTranslator* >( translator )->GetMetaStruct();
+	return metaStruct == Reflect::GetMetaStruct< BsonDate >() || metaStruct == Reflect::GetMetaStruct< BsonObjectId >();
+}
+
 const char* Persist::GetBsonErrorString( int status )
 {
 	// if this is non-power-of-two then we have multiple errors
@@ -136,8 +150,7 @@ void ArchiveWriterBson::Open()
 	Log::Print("Opening file '%s'\n", m_Path.c_str());
 #endif
 
-	FileStream* stream = new FileStream();
-	stream->Open( m_Path.Data(), FileStream::MODE_WRITE );
+	Stream* stream = OpenStream();
 	m_Stream.Reset( stream );
 }
 
@@ -405,6 +418,13 @@ void ArchiveWriterBson::SerializeTranslator( bson* b, const char* name, Pointer
 			SequenceTranslator* sequence = static_cast< SequenceTranslator* >( translator );
 
 			Translator* itemTranslator = sequence->GetItemTranslator();
+			DynamicArray< uint8_t > packed;
+			if ( !IsBsonStructure( itemTranslator ) && PackSequence( pointer, sequence, packed ) )
+			{
+				HELIUM_VERIFY( BSON_OK == bson_append_binary( b, name, PackedSequenceSubtype, reinterpret_cast< const char* >( packed.GetData() ), static_cast< int >( packed.GetSize() ) ) );
+				break;
+			}
+
 			DynamicArray< Pointer > items;
 			sequence->GetItems( pointer, items );
 
@@ -503,8 +523,7 @@ void ArchiveReaderBson::Open()
 	Log::Print("Opening file '%s'\n", m_Path.c_str());
 #endif
 
-	FileStream* stream = new FileStream();
-	stream->Open( m_Path.Data(), FileStream::MODE_READ );
+	Stream* stream = OpenStream();
 	m_Stream.Reset( stream );
 }
 
@@ -977,6 +996,16 @@ void ArchiveReaderBson::DeserializeTranslator( bson_iterator* i, Pointer pointer
 			break;
 		}
 
+	case BSON_BINDATA:
+		{
+			char subtype = bson_iterator_bin_type( i );
+			if ( subtype == PackedSequenceSubtype && translator->GetMetaId() == MetaIds::SequenceTranslator )
+			{
+				UnpackSequence( bson_iterator_bin_data( i ), bson_iterator_bin_len( i ), pointer, static_cast< SequenceTranslator* >( translator ) );
+			}
+			break;
+		}
+
 	case BSON_DATE:
 		{
 			if ( translator->GetMetaId() == MetaIds::StructureTranslator )
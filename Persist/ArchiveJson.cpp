@@ -2,7 +2,6 @@
 #include "Persist/ArchiveJson.h"
 
 #include "Foundation/Endian.h"
-#include "Foundation/FileStream.h"
 #include "Foundation/Numeric.h"
 
 #include "Reflect/Object.h"
@@ -58,8 +57,7 @@ void ArchiveWriterJson::Open()
 	Log::Print("Opening file '%s'\n", m_Path.c_str());
 #endif
 
-	FileStream* stream = new FileStream();
-	stream->Open( m_Path.Data(), FileStream::MODE_WRITE );
+	Stream* stream = OpenStream();
 	m_Stream.Reset( stream );
 	m_Output.SetStream( stream );
 }
@@ -67,8 +65,8 @@ void ArchiveWriterJson::Open()
 void ArchiveWriterJson::Close()
 {
 	HELIUM_ASSERT( m_Stream );
-	m_Stream->Close();
 	m_Output.SetStream( NULL );
+	m_Stream->Close();
 }
 
 void ArchiveWriterJson::Write( const ObjectPtr* objects, size_t count )
@@ -122,7 +120,7 @@ void ArchiveWriterJson::Write( const ObjectPtr* objects, size_t count )
 	e_Status.Raise( info );
 
 	// do cleanup
-	m_Stream->Flush();
+	m_Output.Flush();
 
 	// notify completion
 	info.m_State = ArchiveStates::Complete;
@@ -419,8 +417,7 @@ void ArchiveReaderJson::Open()
 	Log::Print("Opening file '%s'\n", m_Path.c_str());
 #endif
 
-	FileStream* stream = new FileStream();
-	stream->Open( m_Path.Data(), FileStream::MODE_READ );
+	Stream* stream = OpenStream();
 	m_Stream.Reset( stream );
 }
 
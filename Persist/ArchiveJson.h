@@ -47,7 +47,7 @@ namespace Helium
 			inline void Flush();
 
 		private:
-			Stream* m_Stream;
+			BufferedStreamWriter m_Writer;  // rapidjson writes a character at a time
 		};
 		typedef rapidjson::PrettyWriter< RapidJsonOutputStream > RapidJsonWriter;
 
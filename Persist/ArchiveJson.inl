@@ -1,19 +1,20 @@
 Helium::Persist::RapidJsonOutputStream::RapidJsonOutputStream()
-	: m_Stream( NULL )
+	: m_Writer( NULL )
 {
 }
 
 void Helium::Persist::RapidJsonOutputStream::SetStream( Stream* stream )
 {
-	m_Stream = stream;
+	m_Writer.Open( stream );
 }
 
 void Helium::Persist::RapidJsonOutputStream::Put( Ch c )
 {
-	m_Stream->Write< Ch >( c );
+	m_Writer.Write< Ch >( c );
 }
 
 void Helium::Persist::RapidJsonOutputStream::Flush()
 {
-	m_Stream->Flush();
+	m_Writer.Flush();
+	m_Writer.GetStream()->Flush();
 }
@@ -2,7 +2,6 @@
 #include "Persist/ArchiveMessagePack.h"
 
 #include "Foundation/Endian.h"
-#include "Foundation/FileStream.h"
 
 #include "Reflect/Object.h"
 #include "Reflect/MetaStruct.h"
@@ -13,6 +12,9 @@ using namespace Helium;
 using namespace Helium::Reflect;
 using namespace Helium::Persist;
 
+// ext type of sequences written by Archive::PackSequence
+static const int8_t PackedSequenceExtType = 1;
+
 void ArchiveWriterMessagePack::WriteToStream( const ObjectPtr& object, Stream& stream, ObjectIdentifier* identifier, uint32_t flags )
 {
 	ArchiveWriterMessagePack archive ( &stream, identifier, flags );
@@ -51,8 +53,7 @@ void ArchiveWriterMessagePack::Open()
 	Log::Print("Opening file '%s'\n", m_Path.c_str());
 #endif
 
-	FileStream* stream = new FileStream();
-	stream->Open( m_Path.Data(), FileStream::MODE_WRITE );
+	Stream* stream = OpenStream();
 	m_Stream.Reset( stream );
 	m_Writer.SetStream( stream );
 }
@@ -60,6 +61,7 @@ void ArchiveWriterMessagePack::Open()
 void ArchiveWriterMessagePack::Close()
 {
 	HELIUM_ASSERT( m_Stream );
+	m_Writer.SetStream( NULL );
 	m_Stream->Close(); 
 }
 
@@ -77,31 +79,58 @@ void ArchiveWriterMessagePack::Write( const Reflect::ObjectPtr* objects, size_t
 	// begin top level array of objects
 	m_Writer.BeginArray();
 
-	// objects can get changed during this iteration (in Identify), so use indices
-	for ( size_t index = 0; index < m_Objects.GetSize(); ++index )
+	// a delta is an array of entries followed by the length of the object list, each entry is
+	//  [ index, reset, object ], reset objects weren't tracked so all their fields are written
+	bool delta = ( m_Flags & ArchiveFlags::Delta ) != 0;
+	if ( delta )
 	{
-		Object* object = m_Objects.GetElement( index );
-		const MetaClass* objectClass = object->GetMetaClass();
+		m_Writer.BeginArray();
+	}
 
-		m_Writer.BeginMap( 1 );
+	if ( IsParallel() )
+	{
+		// batches of objects get written to memory on their own, then they go out in order
+		IdentifyObjects( false );
 
-		if ( m_Flags & ArchiveFlags::StringCrc )
+		DynamicArray< ParallelChunk > chunks;
+		WriteParallel( chunks );
+
+		for ( size_t index = 0; index < chunks.GetSize(); ++index )
 		{
-			uint32_t typeCrc = Crc32( objectClass->m_Name );
-			m_Writer.Write( typeCrc );
+			const ParallelChunk& chunk = chunks[ index ];
+			m_Writer.WriteEncoded( chunk.m_Data.GetData(), chunk.m_Data.GetSize(), chunk.m_Count );
 		}
-		else
+	}
+	else
+	{
+		// objects can get changed during this iteration (in Identify), so use indices
+		for ( size_t index = 0; index < m_Objects.GetSize(); ++index )
 		{
-			m_Writer.Write( objectClass->m_Name );
-		}
+			Object* object = m_Objects.GetElement( index );
 
-		SerializeInstance( object, objectClass, object );
+			if ( !delta )
+			{
+				SerializeObject( m_Writer, object );
+			}
+			else if ( object->IsDirty() )
+			{
+				m_Writer.BeginArray( 3 );
+				m_Writer.Write( static_cast< uint32_t >( index ) );
+				m_Writer.Write( !object->IsDirtyTracking() );
+				SerializeObject( m_Writer, object );
+				m_Writer.EndArray();
+			}
 
-		m_Writer.EndMap();
+			info.m_State = ArchiveStates::ObjectProcessed;
+			info.m_Progress = (int)(((float)(index) / (float)m_Objects.GetSize()) * 100.0f);
+			e_Status.Raise( info );
+		}
+	}
 
-		info.m_State = ArchiveStates::ObjectProcessed;
-		info.m_Progress = (int)(((float)(index) / (float)m_Objects.GetSize()) * 100.0f);
-		e_Status.Raise( info );
+	if ( delta )
+	{
+		m_Writer.EndArray();
+		m_Writer.Write( static_cast< uint32_t >( m_Objects.GetSize() ) );
 	}
 
 	// end top level array
@@ -113,6 +142,7 @@ void ArchiveWriterMessagePack::Write( const Reflect::ObjectPtr* objects, size_t
 	e_Status.Raise( info );
 
 	// do cleanup
+	m_Writer.Flush();
 	m_Stream->Flush();
 
 	// notify completion
@@ -120,7 +150,38 @@ void ArchiveWriterMessagePack::Write( const Reflect::ObjectPtr* objects, size_t
 	e_Status.Raise( info );
 }
 
-void ArchiveWriterMessagePack::SerializeInstance( void* instance, const MetaStruct* structure, Object* object )
+void ArchiveWriterMessagePack::WriteParallelObjects( size_t first, size_t last, Stream& stream )
+{
+	MessagePackWriter writer ( &stream );
+	for ( size_t index = first; index < last; ++index )
+	{
+		SerializeObject( writer, m_Objects.GetElement( index ) );
+	}
+	writer.Flush();
+}
+
+void ArchiveWriterMessagePack::SerializeObject( MessagePackWriter& writer, Object* object )
+{
+	const MetaClass* objectClass = object->GetMetaClass();
+
+	writer.BeginMap( 1 );
+
+	if ( m_Flags & ArchiveFlags::StringCrc )
+	{
+		uint32_t typeCrc = Crc32( objectClass->m_Name );
+		writer.Write( typeCrc );
+	}
+	else
+	{
+		writer.Write( objectClass->m_Name );
+	}
+
+	SerializeInstance( writer, object, objectClass, object );
+
+	writer.EndMap();
+}
+
+void ArchiveWriterMessagePack::SerializeInstance( MessagePackWriter& writer, void* instance, const MetaStruct* structure, Object* object )
 {
 #if PERSIST_ARCHIVE_VERBOSE
 	Log::Print("Serializing %s\n", structure->m_Name );
@@ -143,14 +204,22 @@ void ArchiveWriterMessagePack::SerializeInstance( void* instance, const MetaStru
 		for ( ; itr != end; ++itr )
 		{
 			const Field* field = &*itr;
-			if ( field->ShouldSerialize( instance, object ) )
+			if ( m_Flags & ArchiveFlags::Delta )
+			{
+				// deltas are read over existing data, so default values are written too, but only dirty fields of the object itself
+				if ( !( field->m_Flags & FieldFlags::Discard ) && ( instance != object || object->IsFieldDirty( field ) ) )
+				{
+					fields.Push( field );
+				}
+			}
+			else if ( field->ShouldSerialize( instance, object ) )
 			{
 				fields.Push( field );
 			}
 		}
 	}
 
-	m_Writer.BeginMap( static_cast< uint32_t >( fields.GetSize() ) );
+	writer.BeginMap( static_cast< uint32_t >( fields.GetSize() ) );
 	object->PreSerialize( NULL );
 
 	DynamicArray< const Field* >::ConstIterator itr = fields.Begin();
@@ -159,15 +228,15 @@ void ArchiveWriterMessagePack::SerializeInstance( void* instance, const MetaStru
 	{
 		const Field* field = *itr;
 		object->PreSerialize( field );
-		SerializeField( instance, field, object );
+		SerializeField( writer, instance, field, object );
 		object->PostSerialize( field );
 	}
 
 	object->PostSerialize( NULL );
-	m_Writer.EndMap();
+	writer.EndMap();
 }
 
-void ArchiveWriterMessagePack::SerializeField( void* instance, const Field* field, Object* object )
+void ArchiveWriterMessagePack::SerializeField( MessagePackWriter& writer, void* instance, const Field* field, Object* object )
 {
 #if PERSIST_ARCHIVE_VERBOSE
 	Log::Print("Serializing field %s\n", field->m_Name);
@@ -177,32 +246,32 @@ void ArchiveWriterMessagePack::SerializeField( void* instance, const Field* fiel
 	{
 		// write the crc of the field name (used to associate a field when reading)
 		uint32_t fieldNameCrc = Crc32( field->m_Name );
-		m_Writer.Write( fieldNameCrc );
+		writer.Write( fieldNameCrc );
 	}
 	else
 	{
 		// write the actual string
-		m_Writer.Write( field->m_Name );
+		writer.Write( field->m_Name );
 	}
 
 	if ( field->m_Count > 1 )
 	{
-		m_Writer.BeginArray( field->m_Count );
+		writer.BeginArray( field->m_Count );
 
 		for ( uint32_t i=0; i<field->m_Count; ++i )
 		{
-			SerializeTranslator( Pointer ( field, instance, object, i ), field->m_Translator, field, object );
+			SerializeTranslator( writer, Pointer ( field, instance, object, i ), field->m_Translator, field, object );
 		}
 
-		m_Writer.EndArray();
+		writer.EndArray();
 	}
 	else
 	{
-		SerializeTranslator( Pointer ( field, instance, object ), field->m_Translator, field, object );
+		SerializeTranslator( writer, Pointer ( field, instance, object ), field->m_Translator, field, object );
 	}
 }
 
-void ArchiveWriterMessagePack::SerializeTranslator( Pointer pointer, Translator* translator, const Field* field, Object* object )
+void ArchiveWriterMessagePack::SerializeTranslator( MessagePackWriter& writer, Pointer pointer, Translator* translator, const Field* field, Object* object )
 {
 	switch ( translator->GetMetaId() )
 	{
@@ -212,57 +281,65 @@ void ArchiveWriterMessagePack::SerializeTranslator( Pointer pointer, Translator*
 	case MetaIds::PointerTranslator:
 	case MetaIds::TypeTranslator:
 		{
+			// shared objects are written as their index, rather than a name for it
+			uint32_t index = 0;
+			if ( translator->GetMetaId() == MetaIds::PointerTranslator && Reflect::Identify( this, pointer, index ) )
+			{
+				writer.Write( index );
+				break;
+			}
+
 			ScalarTranslator* scalar = static_cast< ScalarTranslator* >( translator );
 			switch ( scalar->m_Type )
 			{
 			case ScalarTypes::Boolean:
-				m_Writer.Write( pointer.As<bool>() );
+				writer.Write( pointer.As<bool>() );
 				break;
 
 			case ScalarTypes::Unsigned8:
-				m_Writer.Write( pointer.As<uint8_t>() );
+				writer.Write( pointer.As<uint8_t>() );
 				break;
 
 			case ScalarTypes::Unsigned16:
-				m_Writer.Write( pointer.As<uint16_t>() );
+				writer.Write( pointer.As<uint16_t>() );
 				break;
 
 			case ScalarTypes::Unsigned32:
-				m_Writer.Write( pointer.As<uint32_t>() );
+				writer.Write( pointer.As<uint32_t>() );
 				break;
 
 			case ScalarTypes::Unsigned64:
-				m_Writer.Write( pointer.As<uint64_t>() );
+				writer.Write( pointer.As<uint64_t>() );
 				break;
 
 			case ScalarTypes::Signed8:
-				m_Writer.Write( pointer.As<int8_t>() );
+				writer.Write( pointer.As<int8_t>() );
 				break;
 
 			case ScalarTypes::Signed16:
-				m_Writer.Write( pointer.As<int16_t>() );
+				writer.Write( pointer.As<int16_t>() );
 				break;
 
 			case ScalarTypes::Signed32:
-				m_Writer.Write( pointer.As<int32_t>() );
+				writer.Write( pointer.As<int32_t>() );
 				break;
 
 			case ScalarTypes::Signed64:
-				m_Writer.Write( pointer.As<int64_t>() );
+				writer.Write( pointer.As<int64_t>() );
 				break;
 
 			case ScalarTypes::Float32:
-				m_Writer.Write( pointer.As<float32_t>() );
+				writer.Write( pointer.As<float32_t>() );
 				break;
 
 			case ScalarTypes::Float64:
-				m_Writer.Write( pointer.As<float64_t>() );
+				writer.Write( pointer.As<float64_t>() );
 				break;
 
 			case ScalarTypes::String:
 				String str;
 				scalar->Print( pointer, str, this );
-				m_Writer.Write( str.GetData() );
+				writer.Write( *str ); // deltas write default values too, so this can be empty
 				break;
 			}
 			break;
@@ -271,7 +348,7 @@ void ArchiveWriterMessagePack::SerializeTranslator( Pointer pointer, Translator*
 	case MetaIds::StructureTranslator:
 		{
 			StructureTranslator* structure = static_cast< StructureTranslator* >( translator );
-			SerializeInstance( pointer.m_Address, structure->GetMetaStruct(), object );
+			SerializeInstance( writer, pointer.m_Address, structure->GetMetaStruct(), object );
 			break;
 		}
 
@@ -284,14 +361,14 @@ void ArchiveWriterMessagePack::SerializeTranslator( Pointer pointer, Translator*
 			set->GetItems( pointer, items );
 
 			uint32_t length = static_cast< uint32_t >( items.GetSize() );
-			m_Writer.BeginArray( length );
+			writer.BeginArray( length );
 
 			for ( DynamicArray< Pointer >::Iterator itr = items.Begin(), end = items.End(); itr != end; ++itr )
 			{
-				SerializeTranslator( *itr, itemTranslator, field, object );
+				SerializeTranslator( writer, *itr, itemTranslator, field, object );
 			}
 
-			m_Writer.EndArray();
+			writer.EndArray();
 
 			break;
 		}
@@ -300,19 +377,26 @@ void ArchiveWriterMessagePack::SerializeTranslator( Pointer pointer, Translator*
 		{
 			SequenceTranslator* sequence = static_cast< SequenceTranslator* >( translator );
 
+			DynamicArray< uint8_t > packed;
+			if ( PackSequence( pointer, sequence, packed ) )
+			{
+				writer.WriteExt( PackedSequenceExtType, packed.GetData(), static_cast< uint32_t >( packed.GetSize() ) );
+				break;
+			}
+
 			Translator* itemTranslator = sequence->GetItemTranslator();
 			DynamicArray< Pointer > items;
 			sequence->GetItems( pointer, items );
 
 			uint32_t length = static_cast< uint32_t >( items.GetSize() );
-			m_Writer.BeginArray( length );
+			writer.BeginArray( length );
 
 			for ( DynamicArray< Pointer >::Iterator itr = items.Begin(), end = items.End(); itr != end; ++itr )
 			{
-				SerializeTranslator( *itr, itemTranslator, field, object );
+				SerializeTranslator( writer, *itr, itemTranslator, field, object );
 			}
 
-			m_Writer.EndArray();
+			writer.EndArray();
 
 			break;
 		}
@@ -327,17 +411,17 @@ void ArchiveWriterMessagePack::SerializeTranslator( Pointer pointer, Translator*
 			association->GetItems( pointer, keys, values );
 
 			uint32_t length = static_cast< uint32_t >( keys.GetSize() );
-			m_Writer.BeginMap( length );
+			writer.BeginMap( length );
 
 			for ( DynamicArray< Pointer >::Iterator keyItr = keys.Begin(), valueItr = values.Begin(), keyEnd = keys.End(), valueEnd = values.End();
 				keyItr != keyEnd && valueItr != valueEnd;
 				++keyItr, ++valueItr )
 			{
-				SerializeTranslator( *keyItr, keyTranslator, field, object );
-				SerializeTranslator( *valueItr, valueTranslator, field, object );
+				SerializeTranslator( writer, *keyItr, keyTranslator, field, object );
+				SerializeTranslator( writer, *valueItr, valueTranslator, field, object );
 			}
 
-			m_Writer.EndMap();
+			writer.EndMap();
 
 			break;
 		}
@@ -393,8 +477,7 @@ void ArchiveReaderMessagePack::Open()
 	Log::Print("Opening file '%s'\n", m_Path.c_str());
 #endif
 
-	FileStream* stream = new FileStream();
-	stream->Open( m_Path.Data(), FileStream::MODE_READ );
+	Stream* stream = OpenStream();
 	m_Stream.Reset( stream );
 	m_Reader.SetStream( stream );
 }
@@ -417,31 +500,48 @@ void ArchiveReaderMessagePack::Read( DynamicArray< ObjectPtr >& objects )
 	{
 		uint32_t length = m_Reader.ReadArrayLength();
 
-		m_Objects.Resize( length );
-
-		m_Reader.BeginArray( length );
-
-		for ( uint32_t i=0; i<length; i++ )
+		// a delta leads with its array of entries, a full archive with its first object
+		if ( length == 2 && m_Reader.IsArray() )
+		{
+			m_Reader.BeginArray( length );
+			ReadDelta();
+			m_Reader.EndArray();
+		}
+		else if ( IsParallel() )
+		{
+			ReadObjectsParallel( length );
+		}
+		else
 		{
-			ObjectPtr& object( m_Objects[ i ] );
-			ReadNext( object, i );
+			m_Objects.Resize( length );
 
-			ArchiveStatus info( *this, ArchiveStates::ObjectProcessed );
-			info.m_Progress = (int)(((float)(m_Stream->Tell()) / (float)m_Size) * 100.0f);
-			e_Status.Raise( info );
-			m_Abort |= info.m_Abort;
-			if ( m_Abort )
+			m_Reader.BeginArray( length );
+
+			for ( uint32_t i=0; i<length; i++ )
 			{
-				break;
+				ObjectPtr& object( m_Objects[ i ] );
+				ReadNext( object, i );
+
+				ArchiveStatus info( *this, ArchiveStates::ObjectProcessed );
+				info.m_Progress = (int)(((float)(m_Reader.Tell()) / (float)m_Size) * 100.0f);
+				e_Status.Raise( info );
+				m_Abort |= info.m_Abort;
+				if ( m_Abort )
+				{
+					break;
+				}
 			}
-		}
 
-		m_Reader.EndArray();
+			m_Reader.EndArray();
+		}
 	}
 
 	Resolve();
 
 	objects = m_Objects;
+
+	m_Reader.SetStream( m_Stream.Ptr() );
+	m_Buffer.Clear();
 }
 
 void ArchiveReaderMessagePack::Start()
@@ -461,33 +561,118 @@ void ArchiveReaderMessagePack::Start()
 		throw Persist::StreamException( "Input stream is empty (%s)", m_Path.Data() );
 	}
 
+	// decode it all from memory, the nil on the end is so there is always a type to advance to
+	size_t size = static_cast< size_t >( m_Size );
+	m_Buffer.Resize( size + 1 );
+	if ( m_Stream->Read( m_Buffer.GetData(), 1, size ) != size )
+	{
+		throw Persist::StreamException( "Unable to read input stream (%s)", m_Path.Data() );
+	}
+	m_Buffer[ size ] = MessagePackTypes::Nil;
+	m_Reader.SetBuffer( m_Buffer.GetData(), m_Buffer.GetSize() );
+
 	// parse the first byte of the stream
 	m_Reader.Advance();
 }
 
-bool ArchiveReaderMessagePack::ReadNext( ObjectPtr& object, size_t index )
+void ArchiveReaderMessagePack::ReadObjectsParallel( uint32_t length )
+{
+	// skip through the objects to find where each one starts (the type of the first was already read)
+	m_Offsets.Resize( length + 1 );
+	for ( uint32_t i=0; i<length; i++ )
+	{
+		m_Offsets[ i ] = static_cast< uint32_t >( m_Reader.Tell() - 1 );
+		m_Reader.Skip();
+	}
+	m_Offsets[ length ] = static_cast< uint32_t >( m_Reader.Tell() - 1 );
+
+	m_Objects.Resize( length );
+	ReadParallel( length );
+
+	m_Offsets.Clear();
+}
+
+void ArchiveReaderMessagePack::ReadParallelObject( size_t index, ObjectPtr& object )
+{
+	MessagePackReader reader ( m_Buffer.GetData() + m_Offsets[ index ], m_Offsets[ index + 1 ] - m_Offsets[ index ] );
+	reader.Advance();
+
+	ReadObject( reader, object, index, false );
+}
+
+void ArchiveReaderMessagePack::ReadDelta()
+{
+	uint32_t entryCount = m_Reader.ReadArrayLength();
+	m_Reader.BeginArray( entryCount );
+
+	for ( uint32_t i=0; i<entryCount; i++ )
+	{
+		uint32_t length = m_Reader.ReadArrayLength();
+		m_Reader.BeginArray( length );
+
+		uint32_t index = 0;
+		bool reset = false;
+		m_Reader.Read( index, NULL );
+		m_Reader.Read( reset, NULL );
+
+		// entries can add objects past the end of the list we started with
+		if ( index >= m_Objects.GetSize() )
+		{
+			m_Objects.Resize( index + 1 );
+		}
+
+		ReadNext( m_Objects[ index ], index, reset );
+
+		m_Reader.EndArray();
+
+		ArchiveStatus info( *this, ArchiveStates::ObjectProcessed );
+		info.m_Progress = (int)(((float)(m_Reader.Tell()) / (float)m_Size) * 100.0f);
+		e_Status.Raise( info );
+		m_Abort |= info.m_Abort;
+		if ( m_Abort )
+		{
+			return;
+		}
+	}
+
+	m_Reader.EndArray();
+
+	// objects dropped from the end of the list since the last write go away
+	uint32_t objectCount = 0;
+	m_Reader.Read( objectCount, NULL );
+	m_Objects.Resize( objectCount );
+}
+
+bool ArchiveReaderMessagePack::ReadNext( ObjectPtr& object, size_t index, bool reset )
 {
-	if ( m_Stream->Tell() == this->m_Size )
+	// past the last object is the nil on the end of the buffer
+	if ( m_Reader.Tell() > this->m_Size )
 	{
 		return false;
 	}
 
-	if ( HELIUM_VERIFY( m_Reader.IsMap() ) )
+	ReadObject( m_Reader, object, index, reset );
+	return true;
+}
+
+void ArchiveReaderMessagePack::ReadObject( MessagePackReader& reader, ObjectPtr& object, size_t index, bool reset )
+{
+	if ( HELIUM_VERIFY( reader.IsMap() ) )
 	{
-		uint32_t length = m_Reader.ReadMapLength();
+		uint32_t length = reader.ReadMapLength();
 		HELIUM_ASSERT( length == 1 );
-		m_Reader.BeginMap( length );
+		reader.BeginMap( length );
 
 		uint32_t objectClassCrc = 0;
-		if ( m_Reader.IsNumber() )
+		if ( reader.IsNumber() )
 		{
-			m_Reader.Read( objectClassCrc, NULL );
+			reader.Read( objectClassCrc, NULL );
 		}
 		else
 		{
-			String typeStr;
-			m_Reader.Read( typeStr );
-			objectClassCrc = Helium::Crc32( typeStr.GetData() );
+			const char* typeStr = NULL;
+			uint32_t typeLength = reader.ReadString( typeStr );
+			objectClassCrc = Helium::Crc32( typeStr, typeLength );
 		}
 
 		const MetaClass* objectClass = NULL;
@@ -496,6 +681,16 @@ bool ArchiveReaderMessagePack::ReadNext( ObjectPtr& object, size_t index )
 			objectClass = Registry::GetInstance()->GetMetaClass( objectClassCrc );
 		}
 
+		// an object read over one of another type replaces it, a reset one starts again from its defaults
+		if ( object && objectClass && object->GetMetaClass() != objectClass )
+		{
+			object = NULL;
+		}
+		else if ( object && reset && object->GetTemplate() )
+		{
+			object->GetTemplate()->CopyTo( object );
+		}
+
 		if ( !object && HELIUM_VERIFY( objectClass ) )
 		{
 			object = AllocateObject( objectClass, index );
@@ -503,20 +698,18 @@ bool ArchiveReaderMessagePack::ReadNext( ObjectPtr& object, size_t index )
 
 		if ( object.ReferencesObject() )
 		{
-			DeserializeInstance( object, object->GetMetaClass(), object );
+			DeserializeInstance( reader, object, object->GetMetaClass(), object );
 		}
 		else // object.ReferencesObject()
 		{
-			m_Reader.Skip();
+			reader.Skip();
 		}
 
-		m_Reader.EndMap();
+		reader.EndMap();
 	}
-
-	return true;
 }
 
-void ArchiveReaderMessagePack::DeserializeInstance( void* instance, const MetaStruct* structure, Object* object )
+void ArchiveReaderMessagePack::DeserializeInstance( MessagePackReader& reader, void* instance, const MetaStruct* structure, Object* object )
 {
 #if PERSIST_ARCHIVE_VERBOSE
 	Log::Print("Deserializing %s\n", structure->m_Name);
@@ -524,23 +717,23 @@ void ArchiveReaderMessagePack::DeserializeInstance( void* instance, const MetaSt
 
 	object->PreDeserialize( NULL );
 
-	if ( HELIUM_VERIFY( m_Reader.IsMap() ) )
+	if ( HELIUM_VERIFY( reader.IsMap() ) )
 	{
-		uint32_t length = m_Reader.ReadMapLength();
-		m_Reader.BeginMap( length );
+		uint32_t length = reader.ReadMapLength();
+		reader.BeginMap( length );
 
 		for (uint32_t i=0; i<length; i++)
 		{
 			uint32_t fieldCrc = 0;
-			if ( m_Reader.IsNumber() )
+			if ( reader.IsNumber() )
 			{
-				m_Reader.Read( fieldCrc, NULL );
+				reader.Read( fieldCrc, NULL );
 			}
 			else
 			{
-				String fieldStr;
-				m_Reader.Read( fieldStr );
-				fieldCrc = Helium::Crc32( fieldStr.GetData() );
+				const char* fieldStr = NULL;
+				uint32_t fieldLength = reader.ReadString( fieldStr );
+				fieldCrc = Helium::Crc32( fieldStr, fieldLength );
 			}
 
 			const Field* field = structure->FindFieldByName( fieldCrc );
@@ -548,27 +741,27 @@ void ArchiveReaderMessagePack::DeserializeInstance( void* instance, const MetaSt
 			{
 				object->PreDeserialize( field );
 
-				DeserializeField( instance, field, object );
+				DeserializeField( reader, instance, field, object );
 
 				object->PostDeserialize( field );
 			}
 			else
 			{
-				m_Reader.Skip();
+				reader.Skip();
 			}
 		}
 
-		m_Reader.EndMap();
+		reader.EndMap();
 	}
 	else // IsMap()
 	{
-		m_Reader.Skip();
+		reader.Skip();
 	}
 
 	object->PostDeserialize( NULL );
 }
 
-void ArchiveReaderMessagePack::DeserializeField( void* instance, const Field* field, Object* object )
+void ArchiveReaderMessagePack::DeserializeField( MessagePackReader& reader, void* instance, const Field* field, Object* object )
 {
 #if PERSIST_ARCHIVE_VERBOSE
 	Log::Print("Deserializing field %s\n", field->m_Name);
@@ -576,114 +769,123 @@ void ArchiveReaderMessagePack::DeserializeField( void* instance, const Field* fi
 	
 	if ( field->m_Count > 1 )
 	{
-		if ( m_Reader.IsArray() )
+		if ( reader.IsArray() )
 		{
-			uint32_t length = m_Reader.ReadArrayLength();
-			m_Reader.BeginArray( length );
+			uint32_t length = reader.ReadArrayLength();
+			reader.BeginArray( length );
 			for ( uint32_t i=0; i<length; ++i )
 			{
 				if ( i < field->m_Count )
 				{
-					DeserializeTranslator( Pointer ( field, instance, object, i ), field->m_Translator, field, object );
+					DeserializeTranslator( reader, Pointer ( field, instance, object, i ), field->m_Translator, field, object );
 				}
 				else
 				{
-					m_Reader.Skip();
+					reader.Skip();
 				}
 			}
-			m_Reader.EndArray();
+			reader.EndArray();
 		}
 		else
 		{
-			DeserializeTranslator( Pointer ( field, instance, object, 0 ), field->m_Translator, field, object );
+			DeserializeTranslator( reader, Pointer ( field, instance, object, 0 ), field->m_Translator, field, object );
 		}
 	}
 	else
 	{
-		DeserializeTranslator( Pointer ( field, instance, object ), field->m_Translator, field, object );
+		DeserializeTranslator( reader, Pointer ( field, instance, object ), field->m_Translator, field, object );
 	}
 }
 
-void ArchiveReaderMessagePack::DeserializeTranslator( Pointer pointer, Translator* translator, const Field* field, Object* object )
+void ArchiveReaderMessagePack::DeserializeTranslator( MessagePackReader& reader, Pointer pointer, Translator* translator, const Field* field, Object* object )
 {
-	if ( m_Reader.IsBoolean() )
+	if ( reader.IsBoolean() )
 	{
 		if ( translator->IsA(MetaIds::ScalarTranslator) )
 		{
 			ScalarTranslator* scalar = static_cast< ScalarTranslator* >( translator );
 			if ( scalar->m_Type == ScalarTypes::Boolean )
 			{
-				m_Reader.Read( pointer.As<bool>(), NULL );
+				reader.Read( pointer.As<bool>(), NULL );
 			}
 			else
 			{
-				m_Reader.Skip(); // no implicit conversion, discard data
+				reader.Skip(); // no implicit conversion, discard data
 			}
 		}
 		else
 		{
-			m_Reader.Skip(); // no implicit conversion, discard data
+			reader.Skip(); // no implicit conversion, discard data
 		}
 	}
-	else if ( m_Reader.IsNumber() )
+	else if ( reader.IsNumber() )
 	{
 		if ( translator->IsA(MetaIds::ScalarTranslator) )
 		{
 			ScalarTranslator* scalar = static_cast< ScalarTranslator* >( translator );
 			bool clamp = true;
+			if ( scalar->GetMetaId() == MetaIds::PointerTranslator )
+			{
+				uint32_t index = Invalid< uint32_t >();
+				reader.ReadNumber( index, clamp, NULL );
+				Reflect::Resolve( this, index, pointer );
+				pointer.RaiseChanged( ( m_Flags & ArchiveFlags::Notify ) != 0 );
+				return;
+			}
+
 			switch ( scalar->m_Type )
 			{
 			case ScalarTypes::Unsigned8:
-				m_Reader.ReadNumber( pointer.As<uint8_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<uint8_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Unsigned16:
-				m_Reader.ReadNumber( pointer.As<uint16_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<uint16_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Unsigned32:
-				m_Reader.ReadNumber( pointer.As<uint32_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<uint32_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Unsigned64:
-				m_Reader.ReadNumber( pointer.As<uint64_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<uint64_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Signed8:
-				m_Reader.ReadNumber( pointer.As<int8_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<int8_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Signed16:
-				m_Reader.ReadNumber( pointer.As<int16_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<int16_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Signed32:
-				m_Reader.ReadNumber( pointer.As<int32_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<int32_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Signed64:
-				m_Reader.ReadNumber( pointer.As<int64_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<int64_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Float32:
-				m_Reader.ReadNumber( pointer.As<float32_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<float32_t>(), clamp, NULL );
 				break;
 
 			case ScalarTypes::Float64:
-				m_Reader.ReadNumber( pointer.As<float64_t>(), clamp, NULL );
+				reader.ReadNumber( pointer.As<float64_t>(), clamp, NULL );
 				break;
 
 			default:
-				m_Reader.Skip(); // no implicit conversion, discard data
+				reader.Skip(); // no implicit conversion, discard data
 				break;
 			}
 		}
 		else
 		{
-			m_Reader.Skip(); // no implicit conversion, discard data
+			reader.Skip(); // no implicit conversion, discard data
 		}
 	}
-	else if ( m_Reader.IsRaw() )
+	else if ( reader.IsRaw() )
 	{
 		if ( translator->IsA( MetaIds::ScalarTranslator ) )
 		{
@@ -691,81 +893,93 @@ void ArchiveReaderMessagePack::DeserializeTranslator( Pointer pointer, Translato
 			if ( scalar->m_Type == ScalarTypes::String )
 			{
 				String str;
-				m_Reader.Read( str );
+				reader.Read( str );
 				scalar->Parse( str, pointer, this, m_Flags | ArchiveFlags::Notify ? true : false );
 			}
 		}
 		else
 		{
-			m_Reader.Skip(); // no implicit conversion, discard data
+			reader.Skip(); // no implicit conversion, discard data
 		}
 	}
-	else if ( m_Reader.IsArray() )
+	else if ( reader.IsArray() )
 	{
 		if ( translator->GetMetaId() == MetaIds::SetTranslator )
 		{
 			SetTranslator* set = static_cast< SetTranslator* >( translator );
 			Translator* itemTranslator = set->GetItemTranslator();
-			uint32_t length = m_Reader.ReadArrayLength();
-			m_Reader.BeginArray( length );
+			uint32_t length = reader.ReadArrayLength();
+			set->Clear( pointer ); // the archive holds the whole set, even when reading over existing data
+			reader.BeginArray( length );
 			for ( uint32_t i=0; i<length; ++i )
 			{
 				Variable item ( itemTranslator );
-				DeserializeTranslator( item, itemTranslator, field, object );
+				DeserializeTranslator( reader, item, itemTranslator, field, object );
 				set->InsertItem( pointer, item );
 			}
-			m_Reader.EndArray();
+			reader.EndArray();
 		}
 		else if ( translator->GetMetaId() == MetaIds::SequenceTranslator )
 		{
 			SequenceTranslator* sequence = static_cast< SequenceTranslator* >( translator );
 			Translator* itemTranslator = sequence->GetItemTranslator();
-			uint32_t length = m_Reader.ReadArrayLength();
+			uint32_t length = reader.ReadArrayLength();
 			sequence->SetLength(pointer, length);
-			m_Reader.BeginArray( length );
+			reader.BeginArray( length );
 			for ( uint32_t i=0; i<length; ++i )
 			{
 				Pointer item = sequence->GetItem( pointer, i );
-				DeserializeTranslator( item, itemTranslator, field, object );
+				DeserializeTranslator( reader, item, itemTranslator, field, object );
 			}
-			m_Reader.EndArray();
+			reader.EndArray();
 		}
 		else
 		{
-			m_Reader.Skip(); // no implicit conversion, discard data
+			reader.Skip(); // no implicit conversion, discard data
 		}
 	}
-	else if ( m_Reader.IsMap() )
+	else if ( reader.IsMap() )
 	{
 		if ( translator->GetMetaId() == MetaIds::StructureTranslator )
 		{
 			StructureTranslator* structure = static_cast< StructureTranslator* >( translator );
-			DeserializeInstance( pointer.m_Address,  structure->GetMetaStruct(), object );
+			DeserializeInstance( reader, pointer.m_Address,  structure->GetMetaStruct(), object );
 		}
 		else if ( translator->GetMetaId() == MetaIds::AssociationTranslator )
 		{
 			AssociationTranslator* assocation = static_cast< AssociationTranslator* >( translator );
 			Translator* keyTranslator = assocation->GetKeyTranslator();
 			Translator* valueTranslator = assocation->GetValueTranslator();
-			uint32_t length = m_Reader.ReadMapLength();
-			m_Reader.BeginMap( length );
+			uint32_t length = reader.ReadMapLength();
+			assocation->Clear( pointer ); // the archive holds the whole association, even when reading over existing data
+			reader.BeginMap( length );
 			for ( uint32_t i=0; i<length; ++i )
 			{
 				Variable key ( keyTranslator );
 				Variable value ( valueTranslator );
-				DeserializeTranslator( key, keyTranslator, field, object );
-				DeserializeTranslator( value, valueTranslator, field, object );
+				DeserializeTranslator( reader, key, keyTranslator, field, object );
+				DeserializeTranslator( reader, value, valueTranslator, field, object );
 				assocation->SetItem( pointer, key, value );
 			}
-			m_Reader.EndMap();
+			reader.EndMap();
 		}
 		else
 		{
-			m_Reader.Skip(); // no implicit conversion, discard data
+			reader.Skip(); // no implicit conversion, discard data
+		}
+	}
+	else if ( reader.IsExt() )
+	{
+		int8_t extType = 0;
+		uint32_t length = reader.ReadExtLength( extType );
+		const void* bytes = reader.ReadRawView( length );
+		if ( extType == PackedSequenceExtType && translator->GetMetaId() == MetaIds::SequenceTranslator )
+		{
+			UnpackSequence( bytes, length, pointer, static_cast< SequenceTranslator* >( translator ) );
 		}
 	}
 	else
 	{
-		m_Reader.Skip(); // no implicit conversion, discard data
+		reader.Skip(); // no implicit conversion, discard data
 	}
 }
@@ -26,11 +26,13 @@ namespace Helium
 
 		protected:
 			virtual void Write( const Reflect::ObjectPtr* objects, size_t count ) override;
+			virtual void WriteParallelObjects( size_t first, size_t last, Stream& stream ) override;
 
 		private:
-			void SerializeInstance( void* instance, const Reflect::MetaStruct* structure, Reflect::Object* object );
-			void SerializeField( void* instance, const Reflect::Field* field, Reflect::Object* object );
-			void SerializeTranslator( Reflect::Pointer pointer, Reflect::Translator* translator, const Reflect::Field* field, Reflect::Object* object );
+			void SerializeObject( MessagePackWriter& writer, Reflect::Object* object );
+			void SerializeInstance( MessagePackWriter& writer, void* instance, const Reflect::MetaStruct* structure, Reflect::Object* object );
+			void SerializeField( MessagePackWriter& writer, void* instance, const Reflect::Field* field, Reflect::Object* object );
+			void SerializeTranslator( MessagePackWriter& writer, Reflect::Pointer pointer, Reflect::Translator* translator, const Reflect::Field* field, Reflect::Object* object );
 
 			AutoPtr< Stream > m_Stream;
 			MessagePackWriter m_Writer;
@@ -51,18 +53,24 @@ namespace Helium
 
 		protected:
 			virtual void Read( DynamicArray< Reflect::ObjectPtr >& objects ) override;
+			virtual void ReadParallelObject( size_t index, Reflect::ObjectPtr& object ) override;
 
 		private:
 			void Start();
-			bool ReadNext( Reflect::ObjectPtr &object, size_t index );
-			void DeserializeInstance( void* instance, const Reflect::MetaStruct* composite, Reflect::Object* object );
-			void DeserializeField( void* instance, const Reflect::Field* field, Reflect::Object* object );
-			void DeserializeTranslator( Reflect::Pointer pointer, Reflect::Translator* translator, const Reflect::Field* field, Reflect::Object* object );
+			void ReadDelta();
+			void ReadObjectsParallel( uint32_t length );
+			bool ReadNext( Reflect::ObjectPtr &object, size_t index, bool reset = false );
+			void ReadObject( MessagePackReader& reader, Reflect::ObjectPtr &object, size_t index, bool reset );
+			void DeserializeInstance( MessagePackReader& reader, void* instance, const Reflect::MetaStruct* composite, Reflect::Object* object );
+			void DeserializeField( MessagePackReader& reader, void* instance, const Reflect::Field* field, Reflect::Object* object );
+			void DeserializeTranslator( MessagePackReader& reader, Reflect::Pointer pointer, Reflect::Translator* translator, const Reflect::Field* field, Reflect::Object* object );
 
 		private:
-			AutoPtr< Stream > m_Stream;
-			MessagePackReader m_Reader;
-			int64_t           m_Size;
+			AutoPtr< Stream >        m_Stream;
+			MessagePackReader        m_Reader;
+			int64_t                  m_Size;
+			DynamicArray< uint8_t >  m_Buffer;    // the whole stream, while reading
+			DynamicArray< uint32_t > m_Offsets;   // where each one starts in m_Buffer (and where the last ends)
 		};
 	}
 }
\ No newline at end of file
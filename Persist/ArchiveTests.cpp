@@ -0,0 +1,1511 @@
+#include "Precompile.h"
+#include "Persist/Archive.h"
+#include "Persist/ArchiveBinary.h"
+#include "Persist/ArchiveMessagePack.h"
+#include "Persist/Exceptions.h"
+
+#include "Foundation/FileStream.h"
+#include "Foundation/MemoryStream.h"
+
+#include "Platform/Console.h"
+#include "Platform/File.h"
+#include "Platform/Timer.h"
+
+#include "Reflect/Registry.h"
+#include "Reflect/TranslatorDeduction.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace Helium;
+using namespace Helium::Reflect;
+using namespace Helium::Persist;
+
+struct ArchiveTestVector : Struct
+{
+	float32_t m_X;
+	float32_t m_Y;
+	float32_t m_Z;
+
+	ArchiveTestVector()
+		: m_X( 0.f )
+		, m_Y( 0.f )
+		, m_Z( 0.f )
+	{
+	}
+
+	HELIUM_DECLARE_BASE_STRUCT( ArchiveTestVector );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+class ArchiveTestNode;
+typedef StrongPtr< ArchiveTestNode > ArchiveTestNodePtr;
+
+// a node of a document: plain data, containers, a structure, and a link to another node
+class ArchiveTestNode : public Object
+{
+public:
+	uint32_t                          m_Value;
+	std::string                       m_Name;
+	std::vector< uint32_t >           m_List;
+	std::set< uint32_t >              m_Set;
+	std::map< std::string, uint32_t > m_Map;
+	ArchiveTestVector                 m_Position;
+	ArchiveTestNodePtr                m_Link;
+
+	ArchiveTestNode()
+		: m_Value( 0 )
+	{
+	}
+
+	HELIUM_DECLARE_CLASS( ArchiveTestNode, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+// an object as written by an older build, and as that build's successor has it: Removed is gone, Changed holds a
+//  string now, and Link points at a type the successor doesn't have at all.  The file's type names are patched
+//  from the A to the B (and Z) spellings to read it back as the successor would.
+class ArchiveTestEvolvedA : public Object
+{
+public:
+	uint32_t  m_Kept;
+	uint32_t  m_Removed;
+	uint32_t  m_Changed;
+	ObjectPtr m_Link;
+
+	ArchiveTestEvolvedA()
+		: m_Kept( 0 )
+		, m_Removed( 0 )
+		, m_Changed( 0 )
+	{
+	}
+
+	HELIUM_DECLARE_CLASS( ArchiveTestEvolvedA, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+class ArchiveTestEvolvedB : public Object
+{
+public:
+	uint32_t    m_Kept;
+	std::string m_Changed;
+	ObjectPtr   m_Link;
+
+	ArchiveTestEvolvedB()
+		: m_Kept( 0 )
+	{
+	}
+
+	HELIUM_DECLARE_CLASS( ArchiveTestEvolvedB, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+class ArchiveTestVanishedA : public Object
+{
+public:
+	uint32_t m_Value;
+
+	ArchiveTestVanishedA()
+		: m_Value( 0 )
+	{
+	}
+
+	HELIUM_DECLARE_CLASS( ArchiveTestVanishedA, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+struct ArchiveTestLinks : Struct
+{
+	ObjectPtr m_Link;
+
+	HELIUM_DECLARE_BASE_STRUCT( ArchiveTestLinks );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+// holds pointers to other objects in every way a field can: directly, in a structure, a vector, and a map
+class ArchiveTestHolder : public Object
+{
+public:
+	uint32_t                           m_Value;
+	ObjectPtr                          m_Owned;
+	ArchiveTestLinks                   m_Held;
+	std::vector< ObjectPtr >           m_Vector;
+	std::map< std::string, ObjectPtr > m_Map;
+
+	ArchiveTestHolder()
+		: m_Value( 0 )
+	{
+	}
+
+	HELIUM_DECLARE_CLASS( ArchiveTestHolder, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+// points as written by an older build, then with Y gone, Z moved in front of X, and W new
+struct ArchiveTestPointA : Struct
+{
+	float32_t m_X;
+	float32_t m_Y;
+	float32_t m_Z;
+
+	ArchiveTestPointA()
+		: m_X( 0.f )
+		, m_Y( 0.f )
+		, m_Z( 0.f )
+	{
+	}
+
+	bool operator==( const ArchiveTestPointA& rhs ) const
+	{
+		return m_X == rhs.m_X && m_Y == rhs.m_Y && m_Z == rhs.m_Z;
+	}
+
+	HELIUM_DECLARE_BASE_STRUCT( ArchiveTestPointA );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+struct ArchiveTestPointB : Struct
+{
+	float32_t m_Z;
+	float32_t m_X;
+	float32_t m_W;
+
+	ArchiveTestPointB()
+		: m_Z( 0.f )
+		, m_X( 0.f )
+		, m_W( -1.f )
+	{
+	}
+
+	bool operator==( const ArchiveTestPointB& rhs ) const
+	{
+		return m_Z == rhs.m_Z && m_X == rhs.m_X && m_W == rhs.m_W;
+	}
+
+	HELIUM_DECLARE_BASE_STRUCT( ArchiveTestPointB );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+class ArchiveTestPackedA : public Object
+{
+public:
+	std::vector< ArchiveTestPointA > m_Points;
+	std::vector< uint32_t >          m_Numbers;
+
+	HELIUM_DECLARE_CLASS( ArchiveTestPackedA, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+class ArchiveTestPackedB : public Object
+{
+public:
+	std::vector< ArchiveTestPointB > m_Points;
+	std::vector< uint32_t >          m_Numbers;
+
+	HELIUM_DECLARE_CLASS( ArchiveTestPackedB, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+// fails to read if it was written with m_Fail set
+class ArchiveTestFailing : public Object
+{
+public:
+	uint32_t  m_Value;
+	bool      m_Fail;
+	ObjectPtr m_Link;
+
+	ArchiveTestFailing()
+		: m_Value( 0 )
+		, m_Fail( false )
+	{
+	}
+
+	virtual void PostDeserialize( const Field* field ) override
+	{
+		if ( m_Fail )
+		{
+			throw Persist::Exception( "Object %u failed to read", m_Value );
+		}
+	}
+
+	HELIUM_DECLARE_CLASS( ArchiveTestFailing, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+HELIUM_DEFINE_BASE_STRUCT( ArchiveTestVector );
+HELIUM_DEFINE_CLASS( ArchiveTestNode );
+HELIUM_DEFINE_CLASS( ArchiveTestEvolvedA );
+HELIUM_DEFINE_CLASS( ArchiveTestEvolvedB );
+HELIUM_DEFINE_CLASS( ArchiveTestVanishedA );
+HELIUM_DEFINE_CLASS( ArchiveTestFailing );
+HELIUM_DEFINE_BASE_STRUCT( ArchiveTestLinks );
+HELIUM_DEFINE_CLASS( ArchiveTestHolder );
+HELIUM_DEFINE_BASE_STRUCT( ArchiveTestPointA );
+HELIUM_DEFINE_BASE_STRUCT( ArchiveTestPointB );
+HELIUM_DEFINE_CLASS( ArchiveTestPackedA );
+HELIUM_DEFINE_CLASS( ArchiveTestPackedB );
+
+void ArchiveTestVector::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &ArchiveTestVector::m_X, "X" );
+	comp.AddField( &ArchiveTestVector::m_Y, "Y" );
+	comp.AddField( &ArchiveTestVector::m_Z, "Z" );
+}
+
+void ArchiveTestNode::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestNode::m_Value, "Value" );
+	comp.AddField( &ArchiveTestNode::m_Name, "Name" );
+	comp.AddField( &ArchiveTestNode::m_List, "List" );
+	comp.AddField( &ArchiveTestNode::m_Set, "Set" );
+	comp.AddField( &ArchiveTestNode::m_Map, "Map" );
+	comp.AddField( &ArchiveTestNode::m_Position, "Position" );
+	comp.AddField( &ArchiveTestNode::m_Link, "Link" );
+}
+
+void ArchiveTestEvolvedA::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestEvolvedA::m_Kept, "Kept" );
+	comp.AddField( &ArchiveTestEvolvedA::m_Removed, "Removed" );
+	comp.AddField( &ArchiveTestEvolvedA::m_Changed, "Changed" );
+	comp.AddField( &ArchiveTestEvolvedA::m_Link, "Link" );
+}
+
+void ArchiveTestEvolvedB::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestEvolvedB::m_Kept, "Kept" );
+	comp.AddField( &ArchiveTestEvolvedB::m_Changed, "Changed" );
+	comp.AddField( &ArchiveTestEvolvedB::m_Link, "Link" );
+}
+
+void ArchiveTestVanishedA::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestVanishedA::m_Value, "Value" );
+}
+
+void ArchiveTestFailing::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestFailing::m_Value, "Value" );
+	comp.AddField( &ArchiveTestFailing::m_Fail, "Fail" );
+	comp.AddField( &ArchiveTestFailing::m_Link, "Link" );
+}
+
+void ArchiveTestLinks::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &ArchiveTestLinks::m_Link, "Link" );
+}
+
+void ArchiveTestHolder::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestHolder::m_Value, "Value" );
+	comp.AddField( &ArchiveTestHolder::m_Owned, "Owned" );
+	comp.AddField( &ArchiveTestHolder::m_Held, "Held" );
+	comp.AddField( &ArchiveTestHolder::m_Vector, "Vector" );
+	comp.AddField( &ArchiveTestHolder::m_Map, "Map" );
+}
+
+void ArchiveTestPointA::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &ArchiveTestPointA::m_X, "X" );
+	comp.AddField( &ArchiveTestPointA::m_Y, "Y" );
+	comp.AddField( &ArchiveTestPointA::m_Z, "Z" );
+}
+
+void ArchiveTestPointB::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &ArchiveTestPointB::m_Z, "Z" );
+	comp.AddField( &ArchiveTestPointB::m_X, "X" );
+	comp.AddField( &ArchiveTestPointB::m_W, "W" );
+}
+
+void ArchiveTestPackedA::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestPackedA::m_Points, "Points" );
+	comp.AddField( &ArchiveTestPackedA::m_Numbers, "Numbers" );
+}
+
+void ArchiveTestPackedB::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &ArchiveTestPackedB::m_Points, "Points" );
+	comp.AddField( &ArchiveTestPackedB::m_Numbers, "Numbers" );
+}
+
+// count holders, sharing each other through every kind of field, with cycles (and links to themselves), and each
+//  owning one more that only it points to; only the first quarter of them go in the list, the rest are found
+static void MakeTestHolders( DynamicArray< StrongPtr< ArchiveTestHolder > >& holders, DynamicArray< ObjectPtr >& objects, uint32_t count )
+{
+	holders.Clear();
+	objects.Clear();
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		StrongPtr< ArchiveTestHolder > holder = new ArchiveTestHolder;
+		holder->m_Value = i;
+		StrongPtr< ArchiveTestHolder > owned = new ArchiveTestHolder;
+		owned->m_Value = count + i;
+		holder->m_Owned = owned.Ptr();
+		holders.Add( holder );
+	}
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		ArchiveTestHolder* holder = holders[ i ];
+		holder->m_Held.m_Link = holders[ ( i * 7 + 1 ) % count ].Ptr();
+		holder->m_Vector.push_back( holders[ ( i * 3 + 2 ) % count ].Ptr() );
+		holder->m_Vector.push_back( holder );
+		holder->m_Map[ "next" ] = holders[ ( i + 1 ) % count ].Ptr();
+		holder->m_Map[ "far" ] = holders[ ( i * 5 + count / 2 ) % count ].Ptr();
+	}
+
+	for ( uint32_t i = 0; i < count / 4; ++i )
+	{
+		objects.Add( holders[ i ].Ptr() );
+	}
+
+	// and one twice
+	if ( count )
+	{
+		objects.Add( holders[ 0 ].Ptr() );
+	}
+}
+
+static void BreakHolderLinks( const DynamicArray< ObjectPtr >& objects )
+{
+	for ( size_t i = 0; i < objects.GetSize(); ++i )
+	{
+		ArchiveTestHolder* holder = SafeCast< ArchiveTestHolder >( objects[ i ].Ptr() );
+		if ( holder )
+		{
+			holder->m_Held.m_Link = NULL;
+			holder->m_Vector.clear();
+			holder->m_Map.clear();
+		}
+	}
+}
+
+// count nodes, each linked to another a few places along
+static void MakeTestNodes( DynamicArray< ArchiveTestNodePtr >& nodes, DynamicArray< ObjectPtr >& objects, uint32_t count )
+{
+	nodes.Clear();
+	objects.Clear();
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		ArchiveTestNodePtr node = new ArchiveTestNode;
+		node->m_Value = i + 1;
+		node->m_Name = i % 3 ? "node" : "";
+		node->m_List.push_back( i );
+		node->m_List.push_back( i * 2 );
+		node->m_Set.insert( i );
+		node->m_Set.insert( i + 1 );
+		node->m_Map[ "first" ] = i;
+		node->m_Map[ "second" ] = i * 3;
+		node->m_Position.m_X = static_cast< float32_t >( i );
+		node->m_Position.m_Y = -0.5f * i;
+		nodes.Add( node );
+		objects.Add( node );
+	}
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		nodes[ i ]->m_Link = nodes[ ( i * 7 + 1 ) % count ];
+	}
+}
+
+// the read objects match the nodes, with links to the same positions
+static void ExpectSameNodes( const DynamicArray< ArchiveTestNodePtr >& nodes, const DynamicArray< ObjectPtr >& objects )
+{
+	ASSERT_EQ( nodes.GetSize(), objects.GetSize() );
+
+	std::map< const Object*, size_t > positions;
+	for ( size_t i = 0; i < nodes.GetSize(); ++i )
+	{
+		positions[ nodes[ i ].Ptr() ] = i;
+	}
+
+	for ( size_t i = 0; i < nodes.GetSize(); ++i )
+	{
+		const ArchiveTestNode* expected = nodes[ i ];
+		const ArchiveTestNode* node = SafeCast< ArchiveTestNode >( objects[ i ].Ptr() );
+		ASSERT_TRUE( node != NULL ) << i;
+		EXPECT_EQ( expected->m_Value, node->m_Value ) << i;
+		EXPECT_EQ( expected->m_Name, node->m_Name ) << i;
+		EXPECT_TRUE( expected->m_List == node->m_List ) << i;
+		EXPECT_TRUE( expected->m_Set == node->m_Set ) << i;
+		EXPECT_TRUE( expected->m_Map == node->m_Map ) << i;
+		EXPECT_EQ( expected->m_Position.m_X, node->m_Position.m_X ) << i;
+		EXPECT_EQ( expected->m_Position.m_Y, node->m_Position.m_Y ) << i;
+		EXPECT_EQ( expected->m_Position.m_Z, node->m_Position.m_Z ) << i;
+
+		if ( expected->m_Link )
+		{
+			std::map< const Object*, size_t >::const_iterator found = positions.find( expected->m_Link.Ptr() );
+			ASSERT_TRUE( found != positions.end() ) << i;
+			EXPECT_EQ( objects[ found->second ].Ptr(), node->m_Link.Ptr() ) << i;
+		}
+		else
+		{
+			EXPECT_FALSE( node->m_Link.ReferencesObject() ) << i;
+		}
+	}
+}
+
+// links make cycles, which would keep the nodes alive past the test
+static void BreakLinks( const DynamicArray< ObjectPtr >& objects )
+{
+	for ( size_t i = 0; i < objects.GetSize(); ++i )
+	{
+		ArchiveTestNode* node = SafeCast< ArchiveTestNode >( objects[ i ].Ptr() );
+		if ( node )
+		{
+			node->m_Link = NULL;
+		}
+	}
+}
+
+// names objects by their position in a list, as identifiers did before archives wrote indices
+class ArchiveTestNameIdentifier : public ObjectIdentifier
+{
+public:
+	ArchiveTestNameIdentifier( const DynamicArray< ObjectPtr >& objects )
+		: m_Count( 0 )
+	{
+		for ( size_t i = 0; i < objects.GetSize(); ++i )
+		{
+			m_Indices[ objects[ i ].Ptr() ] = static_cast< uint32_t >( i );
+		}
+	}
+
+	virtual bool Identify( const ObjectPtr& object, Name* identity ) override
+	{
+		std::map< const Object*, uint32_t >::const_iterator found = m_Indices.find( object.Ptr() );
+		if ( found == m_Indices.end() )
+		{
+			return false;
+		}
+
+		if ( identity )
+		{
+			String str;
+			str.Format( "%u", found->second );
+			identity->Set( str );
+			++m_Count;
+		}
+
+		return true;
+	}
+
+	std::map< const Object*, uint32_t > m_Indices;
+	uint32_t                            m_Count;
+};
+
+// reads a MessagePack archive with a given number of worker threads
+class ArchiveTestReader : public ArchiveReaderMessagePack
+{
+public:
+	ArchiveTestReader( const FilePath& path, uint32_t threadCount )
+		: ArchiveReaderMessagePack( path, NULL, ArchiveFlags::Parallel )
+	{
+		SetThreadCount( threadCount );
+	}
+
+	void ReadAll( DynamicArray< ObjectPtr >& objects )
+	{
+		Open();
+		Read( objects );
+		Close();
+	}
+};
+
+// writes a MessagePack archive to memory with a given number of worker threads, 0 to write serially
+class ArchiveTestWriter : public ArchiveWriterMessagePack
+{
+public:
+	ArchiveTestWriter( Stream* stream, uint32_t threadCount )
+		: ArchiveWriterMessagePack( stream, NULL, threadCount ? ArchiveFlags::Parallel : 0 )
+	{
+		SetThreadCount( threadCount );
+	}
+
+	void WriteAll( const DynamicArray< ObjectPtr >& objects )
+	{
+		Write( objects.GetData(), objects.GetSize() );
+		Close();
+	}
+
+	bool WritesInParallel() const
+	{
+		return IsParallel();
+	}
+};
+
+static void WriteTestArchive( const DynamicArray< ObjectPtr >& objects, uint32_t threadCount, DynamicArray< uint8_t >& data )
+{
+	data.Clear();
+	DynamicMemoryStream stream ( &data );
+	ArchiveTestWriter archive ( &stream, threadCount );
+	archive.WriteAll( objects );
+}
+
+static bool ReadTestFile( const FilePath& path, std::string& contents )
+{
+	File file;
+	if ( !file.Open( path.Data(), FileModes::Read ) )
+	{
+		return false;
+	}
+
+	contents.resize( static_cast< size_t >( file.GetSize() ) );
+	return contents.empty() || file.Read( &contents[ 0 ], contents.size() );
+}
+
+static bool WriteTestFile( const FilePath& path, const std::string& contents )
+{
+	File file;
+	return file.Open( path.Data(), FileModes::Write ) && file.Write( contents.data(), contents.size() );
+}
+
+static bool ReplaceInTestFile( const FilePath& path, const std::string& from, const std::string& to )
+{
+	std::string contents;
+	if ( !ReadTestFile( path, contents ) )
+	{
+		return false;
+	}
+
+	std::string::size_type position = contents.find( from );
+	if ( position == std::string::npos )
+	{
+		return false;
+	}
+
+	contents.replace( position, from.size(), to );
+	return WriteTestFile( path, contents );
+}
+
+TEST(PersistArchive, ReadingOverObjectsReplacesContainers)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveContainers.msgpack" );
+	const FilePath deltaPath ( "PersistArchiveContainers.delta.msgpack" );
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, 10 );
+	for ( size_t i = 0; i < nodes.GetSize(); ++i )
+	{
+		nodes[ i ]->SetDirtyTracking( true );
+	}
+
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	DynamicArray< ObjectPtr > read;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	ExpectSameNodes( nodes, read );
+
+	// items taken out of a set or map are gone once the delta is read over the objects that had them
+	nodes[ 2 ]->m_Set.erase( 2 );
+	nodes[ 2 ]->FieldChanged( &nodes[ 2 ]->m_Set );
+	nodes[ 4 ]->m_Map.erase( "first" );
+	nodes[ 4 ]->m_Map[ "third" ] = 9;
+	nodes[ 4 ]->FieldChanged( &nodes[ 4 ]->m_Map );
+
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( deltaPath, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error, ArchiveFlags::Delta ) ) << error;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( deltaPath, read, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	ExpectSameNodes( nodes, read );
+	EXPECT_EQ( 1u, SafeCast< ArchiveTestNode >( read[ 2 ].Ptr() )->m_Set.size() );
+	EXPECT_EQ( 2u, SafeCast< ArchiveTestNode >( read[ 4 ].Ptr() )->m_Map.size() );
+
+	BreakLinks( objects );
+	BreakLinks( read );
+	Helium::Delete( path.Data() );
+	Helium::Delete( deltaPath.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, DeltaRoundTrip)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveDelta.msgpack" );
+	const FilePath deltaPaths[] = { FilePath( "PersistArchiveDelta.1.msgpack" ), FilePath( "PersistArchiveDelta.2.msgpack" ) };
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, 1000 );
+	for ( size_t i = 0; i < nodes.GetSize(); ++i )
+	{
+		nodes[ i ]->SetDirtyTracking( true );
+	}
+
+	// writing to a file leaves the objects clean
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	EXPECT_FALSE( nodes[ 5 ]->IsDirty() );
+
+	// a field back to its default, a container, a field of a structure, and a link to an object added at the end
+	nodes[ 3 ]->ChangeField( &ArchiveTestNode::m_Value, 0u );
+	nodes[ 4 ]->m_List.clear();
+	nodes[ 4 ]->FieldChanged( &nodes[ 4 ]->m_List );
+	nodes[ 5 ]->m_Position.m_Z = 7.f;
+	nodes[ 5 ]->FieldChanged( &nodes[ 5 ]->m_Position );
+
+	ArchiveTestNodePtr added = new ArchiveTestNode;
+	added->m_Value = 1234;
+	added->m_Link = nodes[ 0 ];
+	nodes.Add( added );
+	objects.Add( added );
+	nodes[ 6 ]->m_Link = added;
+	nodes[ 6 ]->FieldChanged( &nodes[ 6 ]->m_Link );
+
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( deltaPaths[ 0 ], objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error, ArchiveFlags::Delta ) ) << error;
+	EXPECT_FALSE( nodes[ 3 ]->IsDirty() );
+
+	Status base, delta;
+	ASSERT_TRUE( base.Read( path.Data() ) && delta.Read( deltaPaths[ 0 ].Data() ) );
+	EXPECT_LT( delta.m_Size * 20, base.m_Size );
+
+	// then a renamed object, and the added one dropped from the end again
+	nodes[ 10 ]->m_Name = "renamed";
+	nodes[ 10 ]->RaiseChanged();
+	nodes[ 6 ]->m_Link = nodes[ 1 ];
+	nodes[ 6 ]->FieldChanged( &nodes[ 6 ]->m_Link );
+	added->m_Link = NULL;
+	added = NULL;
+	nodes.Pop();
+	objects.Pop();
+
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( deltaPaths[ 1 ], objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error, ArchiveFlags::Delta ) ) << error;
+
+	// each delta applies to the objects the ones before it left
+	DynamicArray< ObjectPtr > read;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( deltaPaths[ 0 ], read, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	ASSERT_EQ( nodes.GetSize() + 1, read.GetSize() );
+	const ArchiveTestNode* readAdded = SafeCast< ArchiveTestNode >( read.GetLast().Ptr() );
+	ASSERT_TRUE( readAdded != NULL );
+	EXPECT_EQ( 1234u, readAdded->m_Value );
+	EXPECT_EQ( read[ 0 ].Ptr(), readAdded->m_Link.Ptr() );
+	EXPECT_EQ( readAdded, SafeCast< ArchiveTestNode >( read[ 6 ].Ptr() )->m_Link.Ptr() );
+	EXPECT_EQ( 0u, SafeCast< ArchiveTestNode >( read[ 3 ].Ptr() )->m_Value );
+	EXPECT_TRUE( SafeCast< ArchiveTestNode >( read[ 4 ].Ptr() )->m_List.empty() );
+	EXPECT_EQ( 7.f, SafeCast< ArchiveTestNode >( read[ 5 ].Ptr() )->m_Position.m_Z );
+
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( deltaPaths[ 1 ], read, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	ExpectSameNodes( nodes, read );
+
+	// compacting folds the deltas into the full archive
+	ASSERT_TRUE( ArchiveWriter::CompactToFile( path, deltaPaths, HELIUM_ARRAY_COUNT( deltaPaths ), ArchiveTypes::MessagePack, &error ) ) << error;
+	DynamicArray< ObjectPtr > compacted;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, compacted, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	ExpectSameNodes( nodes, compacted );
+
+	BreakLinks( objects );
+	BreakLinks( read );
+	BreakLinks( compacted );
+	Helium::Delete( path.Data() );
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( deltaPaths ); ++i )
+	{
+		Helium::Delete( deltaPaths[ i ].Data() );
+	}
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, IndexAndNameIdentitiesResolve)
+{
+	Reflect::Startup();
+
+	const FilePath paths[] = { FilePath( "PersistArchiveIdentities.msgpack" ), FilePath( "PersistArchiveIdentities.bin" ) };
+	const ArchiveType types[] = { ArchiveTypes::MessagePack, ArchiveTypes::Binary };
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, 100 );
+	nodes[ 9 ]->m_Link = NULL;
+
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( paths ); ++i )
+	{
+		// written as indices
+		ASSERT_TRUE( ArchiveWriter::WriteToFile( paths[ i ], objects.GetData(), objects.GetSize(), NULL, types[ i ], &error ) ) << error;
+		Status indexed;
+		ASSERT_TRUE( indexed.Read( paths[ i ].Data() ) );
+
+		DynamicArray< ObjectPtr > read;
+		ASSERT_TRUE( ArchiveReader::ReadFromFile( paths[ i ], read, NULL, types[ i ], &error ) ) << error;
+		ExpectSameNodes( nodes, read );
+		BreakLinks( read );
+
+		// written as names, by an identifier that only knows about them
+		ArchiveTestNameIdentifier identifier ( objects );
+		ASSERT_TRUE( ArchiveWriter::WriteToFile( paths[ i ], objects.GetData(), objects.GetSize(), &identifier, types[ i ], &error ) ) << error;
+		EXPECT_LE( 99u, identifier.m_Count );
+		Status named;
+		ASSERT_TRUE( named.Read( paths[ i ].Data() ) );
+		EXPECT_LT( indexed.m_Size, named.m_Size );
+
+		read.Clear();
+		ASSERT_TRUE( ArchiveReader::ReadFromFile( paths[ i ], read, NULL, types[ i ], &error ) ) << error;
+		ExpectSameNodes( nodes, read );
+		BreakLinks( read );
+
+		Helium::Delete( paths[ i ].Data() );
+	}
+
+	BreakLinks( objects );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, SharedReferenceBenchmark)
+{
+	Reflect::Startup();
+
+	const FilePath paths[] = { FilePath( "PersistArchiveShared.msgpack" ), FilePath( "PersistArchiveShared.bin" ) };
+	const ArchiveType types[] = { ArchiveTypes::MessagePack, ArchiveTypes::Binary };
+	const uint32_t counts[] = { 10000, 100000, 1000000 };
+	std::string error;
+
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( counts ); ++i )
+	{
+		// every object is pointed at by one other, as well as being in the list
+		DynamicArray< ArchiveTestNodePtr > nodes;
+		DynamicArray< ObjectPtr > objects;
+		nodes.Reserve( counts[ i ] );
+		objects.Reserve( counts[ i ] );
+		for ( uint32_t j = 0; j < counts[ i ]; ++j )
+		{
+			ArchiveTestNodePtr node = new ArchiveTestNode;
+			node->m_Value = j;
+			nodes.Add( node );
+			objects.Add( node );
+		}
+		for ( uint32_t j = 0; j < counts[ i ]; ++j )
+		{
+			nodes[ j ]->m_Link = nodes[ ( j * 7 + 1 ) % counts[ i ] ];
+		}
+
+		float64_t writeMillis[ 2 ];
+		float64_t readMillis[ 2 ];
+		for ( size_t j = 0; j < HELIUM_ARRAY_COUNT( paths ); ++j )
+		{
+			SimpleTimer timer;
+			ASSERT_TRUE( ArchiveWriter::WriteToFile( paths[ j ], objects.GetData(), objects.GetSize(), NULL, types[ j ], &error ) ) << error;
+			writeMillis[ j ] = timer.Elapsed();
+
+			DynamicArray< ObjectPtr > read;
+			timer.Reset();
+			ASSERT_TRUE( ArchiveReader::ReadFromFile( paths[ j ], read, NULL, types[ j ], &error ) ) << error;
+			readMillis[ j ] = timer.Elapsed();
+
+			ASSERT_EQ( objects.GetSize(), read.GetSize() );
+			const ArchiveTestNode* node = SafeCast< ArchiveTestNode >( read[ 5 ].Ptr() );
+			ASSERT_TRUE( node != NULL );
+			EXPECT_EQ( read[ 36 % counts[ i ] ].Ptr(), node->m_Link.Ptr() );
+			BreakLinks( read );
+			Helium::Delete( paths[ j ].Data() );
+		}
+
+		BreakLinks( objects );
+
+		Helium::Print( "Shared references: %u objects, MessagePack %.0f ms write %.0f ms read, binary %.0f ms write %.0f ms read\n",
+			counts[ i ], writeMillis[ 0 ], readMillis[ 0 ], writeMillis[ 1 ], readMillis[ 1 ] );
+	}
+
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, BinaryRoundTrip)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveRoundTrip.bin" );
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, 100 );
+	nodes[ 7 ]->m_Link = NULL;
+
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::Binary, &error ) ) << error;
+	DynamicArray< ObjectPtr > read;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::Binary, &error ) ) << error;
+	ExpectSameNodes( nodes, read );
+
+	// read over the objects that are there already, after a change to one of them
+	ArchiveTestNodePtr changed = SafeCast< ArchiveTestNode >( read[ 3 ].Ptr() );
+	changed->m_Value = 999;
+	changed->m_List.clear();
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::Binary, &error ) ) << error;
+	EXPECT_EQ( changed.Ptr(), read[ 3 ].Ptr() );
+	ExpectSameNodes( nodes, read );
+
+	BreakLinks( objects );
+	BreakLinks( read );
+	changed = NULL;
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, CompressedRoundTrip)
+{
+	Reflect::Startup();
+
+	const ArchiveType types[] = { ArchiveTypes::MessagePack, ArchiveTypes::Binary };
+	const FilePath paths[] = { FilePath( "PersistArchiveCompressed.msgpack" ), FilePath( "PersistArchiveCompressed.bin" ) };
+	std::string error;
+
+	// a file that fits in the first block, and one that runs over many
+	const uint32_t counts[] = { 100, 20000 };
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( counts ); ++i )
+	{
+		DynamicArray< ArchiveTestNodePtr > nodes;
+		DynamicArray< ObjectPtr > objects;
+		MakeTestNodes( nodes, objects, counts[ i ] );
+		nodes[ 7 ]->m_Link = NULL;
+
+		for ( uint32_t j = 0; j < HELIUM_ARRAY_COUNT( types ); ++j )
+		{
+			ASSERT_TRUE( ArchiveWriter::WriteToFile( paths[ j ], objects.GetData(), objects.GetSize(), NULL, types[ j ], &error, ArchiveFlags::Compress ) ) << error;
+
+			// the file is really in blocks, and its data is as big as intended
+			FileStream file;
+			ASSERT_TRUE( file.Open( paths[ j ].Data(), FileStream::MODE_READ ) );
+			CompressedStream compressed;
+			compressed.Open( &file );
+			ASSERT_TRUE( compressed.IsOpen() );
+			EXPECT_EQ( i != 0, compressed.GetSize() > static_cast< int64_t >( CompressedStream::DEFAULT_BLOCK_SIZE ) ) << compressed.GetSize();
+			compressed.Close();
+
+			DynamicArray< ObjectPtr > read;
+			ASSERT_TRUE( ArchiveReader::ReadFromFile( paths[ j ], read, NULL, types[ j ], &error, ArchiveFlags::Compress ) ) << error;
+			ExpectSameNodes( nodes, read );
+			BreakLinks( read );
+
+			Helium::Delete( paths[ j ].Data() );
+		}
+
+		BreakLinks( objects );
+	}
+
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, BinaryReadsSingleObjects)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveSingle.bin" );
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, 100 );
+
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::Binary, &error ) ) << error;
+
+	{
+		ArchiveReaderBinary archive ( path );
+		archive.Open();
+		EXPECT_EQ( objects.GetSize(), archive.GetObjectCount() );
+		EXPECT_FALSE( archive.ReadObject( objects.GetSize() ).ReferencesObject() );
+
+		// the object comes with the ones it points to, and is the same object when asked for again
+		ObjectPtr object = archive.ReadObject( 42 );
+		ArchiveTestNode* node = SafeCast< ArchiveTestNode >( object.Ptr() );
+		ASSERT_TRUE( node != NULL );
+		EXPECT_EQ( 43u, node->m_Value );
+		EXPECT_TRUE( nodes[ 42 ]->m_Map == node->m_Map );
+		EXPECT_EQ( object.Ptr(), archive.ReadObject( 42 ).Ptr() );
+
+		ArchiveTestNode* link = node->m_Link;
+		ASSERT_TRUE( link != NULL );
+		EXPECT_EQ( nodes[ 42 ]->m_Link->m_Value, link->m_Value );
+		EXPECT_EQ( link, archive.ReadObject( ( 42 * 7 + 1 ) % 100 ).Ptr() );
+
+		// then everything, the objects read already included
+		DynamicArray< ObjectPtr > read;
+		for ( size_t i = 0; i < archive.GetObjectCount(); ++i )
+		{
+			read.Add( archive.ReadObject( i ) );
+		}
+		ExpectSameNodes( nodes, read );
+		EXPECT_EQ( object.Ptr(), read[ 42 ].Ptr() );
+
+		BreakLinks( read );
+		archive.Close();
+	}
+
+	BreakLinks( objects );
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, BinaryReadsLongChains)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveChain.bin" );
+	const uint32_t count = 200000;
+	std::string error;
+
+	// each node points at the next, so every pointer is to an object later in the file
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		ArchiveTestNodePtr node = new ArchiveTestNode;
+		node->m_Value = i;
+		nodes.Add( node );
+		objects.Add( node );
+	}
+	for ( uint32_t i = 0; i + 1 < count; ++i )
+	{
+		nodes[ i ]->m_Link = nodes[ i + 1 ];
+	}
+
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::Binary, &error ) ) << error;
+
+	DynamicArray< ObjectPtr > read;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::Binary, &error ) ) << error;
+	ASSERT_EQ( count, read.GetSize() );
+	for ( uint32_t i = 0; i + 1 < count; ++i )
+	{
+		ASSERT_EQ( read[ i + 1 ].Ptr(), SafeCast< ArchiveTestNode >( read[ i ].Ptr() )->m_Link.Ptr() ) << i;
+	}
+	BreakLinks( read );
+
+	// the first object on demand brings in the whole chain
+	{
+		ArchiveReaderBinary archive ( path );
+		archive.Open();
+
+		ArchiveTestNode* node = SafeCast< ArchiveTestNode >( archive.ReadObject( 0 ).Ptr() );
+		uint32_t length = 0;
+		while ( node )
+		{
+			EXPECT_EQ( length, node->m_Value );
+			node = node->m_Link;
+			++length;
+		}
+		EXPECT_EQ( count, length );
+
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			SafeCast< ArchiveTestNode >( archive.ReadObject( i ).Ptr() )->m_Link = NULL;
+		}
+		archive.Close();
+	}
+
+	BreakLinks( objects );
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, BinarySchemaEvolution)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveEvolution.bin" );
+	std::string error;
+
+	StrongPtr< ArchiveTestEvolvedA > evolved = new ArchiveTestEvolvedA;
+	evolved->m_Kept = 5;
+	evolved->m_Removed = 6;
+	evolved->m_Changed = 7;
+	StrongPtr< ArchiveTestVanishedA > vanished = new ArchiveTestVanishedA;
+	vanished->m_Value = 8;
+	evolved->m_Link = vanished.Ptr();
+
+	DynamicArray< ObjectPtr > objects;
+	objects.Add( evolved );
+	objects.Add( vanished );
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::Binary, &error ) ) << error;
+	ASSERT_TRUE( ReplaceInTestFile( path, "ArchiveTestEvolvedA", "ArchiveTestEvolvedB" ) );
+	ASSERT_TRUE( ReplaceInTestFile( path, "ArchiveTestVanishedA", "ArchiveTestVanishedZ" ) );
+
+	// the removed field and the field of another type are skipped, and the unregistered object isn't made
+	DynamicArray< ObjectPtr > read;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::Binary, &error ) ) << error;
+	ASSERT_EQ( 2u, read.GetSize() );
+	const ArchiveTestEvolvedB* successor = SafeCast< ArchiveTestEvolvedB >( read[ 0 ].Ptr() );
+	ASSERT_TRUE( successor != NULL );
+	EXPECT_EQ( 5u, successor->m_Kept );
+	EXPECT_TRUE( successor->m_Changed.empty() );
+	EXPECT_FALSE( successor->m_Link.ReferencesObject() );
+	EXPECT_FALSE( read[ 1 ].ReferencesObject() );
+
+	// and on demand
+	{
+		ArchiveReaderBinary archive ( path );
+		archive.Open();
+		EXPECT_FALSE( archive.ReadObject( 1 ).ReferencesObject() );
+		successor = SafeCast< ArchiveTestEvolvedB >( archive.ReadObject( 0 ).Ptr() );
+		ASSERT_TRUE( successor != NULL );
+		EXPECT_EQ( 5u, successor->m_Kept );
+		EXPECT_FALSE( successor->m_Link.ReferencesObject() );
+		archive.Close();
+	}
+
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, BinaryRejectsDamagedFiles)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveDamaged.bin" );
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, 10 );
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::Binary, &error ) ) << error;
+
+	std::string contents;
+	ASSERT_TRUE( ReadTestFile( path, contents ) );
+	DynamicArray< ObjectPtr > read;
+
+	// cut short anywhere, at the end, in the index, in the object data, and in the header
+	const size_t lengths[] = { contents.size() - 1, contents.size() - 10, contents.size() / 2, 10, 0 };
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( lengths ); ++i )
+	{
+		ASSERT_TRUE( WriteTestFile( path, contents.substr( 0, lengths[ i ] ) ) );
+		error.clear();
+		EXPECT_FALSE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::Binary, &error ) ) << lengths[ i ];
+		EXPECT_FALSE( error.empty() );
+	}
+
+	// written by a machine of the other byte order
+	std::string swapped = contents;
+	std::swap( swapped[ 8 ], swapped[ 11 ] );
+	std::swap( swapped[ 9 ], swapped[ 10 ] );
+	ASSERT_TRUE( WriteTestFile( path, swapped ) );
+	error.clear();
+	EXPECT_FALSE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::Binary, &error ) );
+	EXPECT_NE( std::string::npos, error.find( "byte order" ) ) << error;
+
+	// and the file as it was still reads
+	ASSERT_TRUE( WriteTestFile( path, contents ) );
+	read.Clear();
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::Binary, &error ) ) << error;
+	ExpectSameNodes( nodes, read );
+
+	BreakLinks( objects );
+	BreakLinks( read );
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, BinaryBenchmark)
+{
+	Reflect::Startup();
+
+	const FilePath paths[] = { FilePath( "PersistArchiveBenchmark.msgpack" ), FilePath( "PersistArchiveBenchmark.bin" ) };
+	const ArchiveType types[] = { ArchiveTypes::MessagePack, ArchiveTypes::Binary };
+	const uint32_t count = 100000;
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, count );
+
+	int64_t sizes[ 2 ];
+	float64_t readMillis[ 2 ];
+	SimpleTimer timer;
+	for ( size_t i = 0; i < 2; ++i )
+	{
+		ASSERT_TRUE( ArchiveWriter::WriteToFile( paths[ i ], objects.GetData(), objects.GetSize(), NULL, types[ i ], &error ) ) << error;
+		Status status;
+		ASSERT_TRUE( status.Read( paths[ i ].Data() ) );
+		sizes[ i ] = status.m_Size;
+
+		DynamicArray< ObjectPtr > read;
+		timer.Reset();
+		ASSERT_TRUE( ArchiveReader::ReadFromFile( paths[ i ], read, NULL, types[ i ], &error ) ) << error;
+		readMillis[ i ] = timer.Elapsed();
+		ExpectSameNodes( nodes, read );
+		BreakLinks( read );
+	}
+
+	// one object from the middle, with the objects it points to
+	float64_t singleMillis = 0.0;
+	{
+		timer.Reset();
+		ArchiveReaderBinary archive ( paths[ 1 ] );
+		archive.Open();
+		ObjectPtr object = archive.ReadObject( count / 2 );
+		singleMillis = timer.Elapsed();
+		EXPECT_TRUE( object.ReferencesObject() );
+		archive.Close();
+
+		// the links it brought in end in a cycle
+		DynamicArray< ObjectPtr > loaded;
+		std::set< Object* > seen;
+		for ( ArchiveTestNode* node = SafeCast< ArchiveTestNode >( object.Ptr() ); node && seen.insert( node ).second; node = node->m_Link )
+		{
+			loaded.Add( node );
+		}
+		BreakLinks( loaded );
+	}
+
+	BreakLinks( objects );
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( paths ); ++i )
+	{
+		Helium::Delete( paths[ i ].Data() );
+	}
+	Reflect::Shutdown();
+
+	Helium::Print( "Binary archive: %u objects, %" PRId64 " bytes (MessagePack %" PRId64 "), read in %.0f ms (MessagePack %.0f ms), one object in %.2f ms\n",
+		count, sizes[ 1 ], sizes[ 0 ], readMillis[ 1 ], readMillis[ 0 ], singleMillis );
+}
+
+TEST(PersistArchive, ParallelReadMatchesSerial)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveParallelRead.msgpack" );
+	std::string error;
+
+	// enough objects for every thread to take a few batches, with links back and forth between them
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, 1000 );
+	nodes[ 10 ]->m_Link = NULL;
+	nodes[ 11 ]->m_Link = nodes[ 11 ];
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+
+	DynamicArray< ObjectPtr > serial;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, serial, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	ExpectSameNodes( nodes, serial );
+
+	for ( uint32_t threadCount = 1; threadCount <= 8; ++threadCount )
+	{
+		DynamicArray< ObjectPtr > parallel;
+		ArchiveTestReader archive ( path, threadCount );
+		archive.ReadAll( parallel );
+		ExpectSameNodes( nodes, parallel );
+		BreakLinks( parallel );
+	}
+
+	// and with the flag, through the file interface
+	DynamicArray< ObjectPtr > parallel;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, parallel, NULL, ArchiveTypes::MessagePack, &error, ArchiveFlags::Parallel ) ) << error;
+	ExpectSameNodes( nodes, parallel );
+
+	BreakLinks( objects );
+	BreakLinks( serial );
+	BreakLinks( parallel );
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, ParallelReadFailures)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveParallelFailure.msgpack" );
+	const uint32_t count = 1000;
+	std::string error;
+
+	DynamicArray< StrongPtr< ArchiveTestFailing > > failing;
+	DynamicArray< ObjectPtr > objects;
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		StrongPtr< ArchiveTestFailing > object = new ArchiveTestFailing;
+		object->m_Value = i;
+		failing.Add( object );
+		objects.Add( object );
+	}
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		failing[ i ]->m_Link = failing[ ( i * 7 + 1 ) % count ].Ptr();
+	}
+
+	// serialized with m_Fail set, then left clear so the objects here can be released
+	failing[ 700 ]->m_Fail = true;
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	failing[ 700 ]->m_Fail = false;
+
+	// whichever worker hits it, the failure comes back to the caller as a stream exception
+	for ( uint32_t threadCount = 1; threadCount <= 4; ++threadCount )
+	{
+		DynamicArray< ObjectPtr > read;
+		ArchiveTestReader archive ( path, threadCount );
+		bool thrown = false;
+		try
+		{
+			archive.ReadAll( read );
+		}
+		catch ( Persist::StreamException& ex )
+		{
+			thrown = true;
+			EXPECT_NE( std::string::npos, std::string( ex.What() ).find( "Object 700 failed to read" ) ) << ex.What();
+		}
+		EXPECT_TRUE( thrown ) << threadCount;
+	}
+
+	DynamicArray< ObjectPtr > read;
+	EXPECT_FALSE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::MessagePack, &error, ArchiveFlags::Parallel ) );
+	EXPECT_NE( std::string::npos, error.find( "Object 700 failed to read" ) ) << error;
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		failing[ i ]->m_Link = NULL;
+	}
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, ParallelReadBenchmark)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchiveParallelBenchmark.msgpack" );
+	const uint32_t count = 100000;
+	std::string error;
+
+	DynamicArray< ArchiveTestNodePtr > nodes;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestNodes( nodes, objects, count );
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, objects.GetData(), objects.GetSize(), NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+
+	SimpleTimer timer;
+	DynamicArray< ObjectPtr > read;
+	ASSERT_TRUE( ArchiveReader::ReadFromFile( path, read, NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	float64_t serialMillis = timer.Elapsed();
+	ExpectSameNodes( nodes, read );
+	BreakLinks( read );
+
+	String times;
+	for ( uint32_t threadCount = 1; threadCount <= 32; threadCount *= 2 )
+	{
+		read.Clear();
+		timer.Reset();
+		ArchiveTestReader archive ( path, threadCount );
+		archive.ReadAll( read );
+		float64_t millis = timer.Elapsed();
+		ExpectSameNodes( nodes, read );
+		BreakLinks( read );
+
+		String time;
+		time.Format( ", %u threads %.0f ms", threadCount, millis );
+		times += time;
+	}
+
+	BreakLinks( objects );
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+
+	Helium::Print( "Parallel read: %u objects, serial %.0f ms%s\n", count, serialMillis, *times );
+}
+
+TEST(PersistArchive, ParallelWriteMatchesSerial)
+{
+	Reflect::Startup();
+
+	DynamicArray< StrongPtr< ArchiveTestHolder > > holders;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestHolders( holders, objects, 1000 );
+
+	DynamicArray< uint8_t > serial;
+	WriteTestArchive( objects, 0, serial );
+
+	for ( uint32_t threadCount = 1; threadCount <= 8; ++threadCount )
+	{
+		DynamicArray< uint8_t > parallel;
+		WriteTestArchive( objects, threadCount, parallel );
+		ASSERT_EQ( serial.GetSize(), parallel.GetSize() ) << threadCount;
+		EXPECT_EQ( 0, MemoryCompare( serial.GetData(), parallel.GetData(), serial.GetSize() ) ) << threadCount;
+	}
+
+	// one thread writes serially, batching only pays with more of them
+	{
+		DynamicArray< uint8_t > data;
+		DynamicMemoryStream stream ( &data );
+		EXPECT_FALSE( ArchiveTestWriter( &stream, 1 ).WritesInParallel() );
+		EXPECT_TRUE( ArchiveTestWriter( &stream, 2 ).WritesInParallel() );
+	}
+
+	// down to no objects at all
+	const uint32_t counts[] = { 0, 1, 2 };
+	for ( size_t i = 0; i < HELIUM_ARRAY_COUNT( counts ); ++i )
+	{
+		DynamicArray< ObjectPtr > few;
+		few.AddArray( objects.GetData(), counts[ i ] );
+
+		DynamicArray< uint8_t > parallel;
+		WriteTestArchive( few, 0, serial );
+		WriteTestArchive( few, 4, parallel );
+		ASSERT_EQ( serial.GetSize(), parallel.GetSize() ) << counts[ i ];
+		EXPECT_EQ( 0, MemoryCompare( serial.GetData(), parallel.GetData(), serial.GetSize() ) ) << counts[ i ];
+	}
+
+	// and the parallel output reads back, with every shared holder found (strictly owned ones aren't written)
+	DynamicArray< uint8_t > parallel;
+	WriteTestArchive( objects, 4, parallel );
+	StaticMemoryStream stream ( parallel.GetData(), parallel.GetSize() );
+	DynamicArray< ObjectPtr > read;
+	ArchiveReaderMessagePack::ReadFromStream( stream, read );
+	ASSERT_EQ( holders.GetSize() + 1, read.GetSize() );
+	for ( size_t i = 0; i < read.GetSize(); ++i )
+	{
+		const ArchiveTestHolder* holder = SafeCast< ArchiveTestHolder >( read[ i ].Ptr() );
+		ASSERT_TRUE( holder != NULL ) << i;
+		const ArchiveTestHolder* expected = holders[ holder->m_Value ];
+		EXPECT_EQ( SafeCast< ArchiveTestHolder >( expected->m_Held.m_Link.Ptr() )->m_Value, SafeCast< ArchiveTestHolder >( holder->m_Held.m_Link.Ptr() )->m_Value ) << i;
+		ASSERT_EQ( 2u, holder->m_Vector.size() ) << i;
+		EXPECT_EQ( read[ i == objects.GetSize() - 1 ? 0 : i ].Ptr(), holder->m_Vector[ 1 ].Ptr() ) << i;
+		EXPECT_EQ( SafeCast< ArchiveTestHolder >( expected->m_Map.find( "far" )->second.Ptr() )->m_Value, SafeCast< ArchiveTestHolder >( holder->m_Map.find( "far" )->second.Ptr() )->m_Value ) << i;
+	}
+
+	// the object in the list twice is written twice, and pointers go to the first
+	EXPECT_NE( read[ 0 ].Ptr(), read[ objects.GetSize() - 1 ].Ptr() );
+
+	BreakHolderLinks( read );
+	for ( size_t i = 0; i < holders.GetSize(); ++i )
+	{
+		objects.Add( holders[ i ].Ptr() );
+	}
+	BreakHolderLinks( objects );
+	Reflect::Shutdown();
+}
+
+TEST(PersistArchive, ParallelWriteBenchmark)
+{
+	Reflect::Startup();
+
+	const uint32_t count = 100000;
+
+	DynamicArray< StrongPtr< ArchiveTestHolder > > holders;
+	DynamicArray< ObjectPtr > objects;
+	MakeTestHolders( holders, objects, count );
+
+	SimpleTimer timer;
+	DynamicArray< uint8_t > serial;
+	WriteTestArchive( objects, 0, serial );
+	float64_t serialMillis = timer.Elapsed();
+
+	String times;
+	for ( uint32_t threadCount = 1; threadCount <= 32; threadCount *= 2 )
+	{
+		DynamicArray< uint8_t > parallel;
+		timer.Reset();
+		WriteTestArchive( objects, threadCount, parallel );
+		float64_t millis = timer.Elapsed();
+		EXPECT_EQ( serial.GetSize(), parallel.GetSize() ) << threadCount;
+
+		String time;
+		time.Format( ", %u threads %.0f ms", threadCount, millis );
+		times += time;
+	}
+
+	for ( size_t i = 0; i < holders.GetSize(); ++i )
+	{
+		objects.Add( holders[ i ].Ptr() );
+	}
+	BreakHolderLinks( objects );
+	Reflect::Shutdown();
+
+	Helium::Print( "Parallel write: %u objects, %" PRIuSZ " bytes, serial %.0f ms%s\n", count, serial.GetSize(), serialMillis, *times );
+}
+
+// the first point of a packed sequence is ( 1, 2, 3 ), then each one is that plus its index
+static void ExpectPackedPoints( const ArchiveTestPackedB* packed, size_t count, float32_t w )
+{
+	ASSERT_EQ( count, packed->m_Points.size() );
+	for ( size_t i = 0; i < count; ++i )
+	{
+		const ArchiveTestPointB& point = packed->m_Points[ i ];
+		EXPECT_EQ( 1.f + i, point.m_X ) << i;
+		EXPECT_EQ( 3.f + i, point.m_Z ) << i;
+		EXPECT_EQ( w, point.m_W ) << i;
+	}
+}
+
+TEST(PersistArchive, PackedSequences)
+{
+	Reflect::Startup();
+
+	const FilePath path ( "PersistArchivePacked.msgpack" );
+	const uint32_t count = 100;
+	std::string error;
+
+	StrongPtr< ArchiveTestPackedA > packed = new ArchiveTestPackedA;
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		ArchiveTestPointA point;
+		point.m_X = 1.f + i;
+		point.m_Y = 2.f + i;
+		point.m_Z = 3.f + i;
+		packed->m_Points.push_back( point );
+		packed->m_Numbers.push_back( i * 1000 );
+	}
+
+	// round trip, and packed smaller than the values would be one by one
+	ASSERT_TRUE( ArchiveWriter::WriteToFile( path, packed.Ptr(), NULL, ArchiveTypes::MessagePack, &error ) ) << error;
+	Status status;
+	ASSERT_TRUE( status.Read( path.Data() ) );
+	EXPECT_LT( status.m_Size, static_cast< int64_t >( count * ( 3 * 5 + 5 ) ) );
+
+	ObjectPtr read = ArchiveReader::ReadFromFile( path, NULL, ArchiveTypes::MessagePack, &error );
+	const ArchiveTestPackedA* readPacked = SafeCast< ArchiveTestPackedA >( read.Ptr() );
+	ASSERT_TRUE( readPacked != NULL ) << error;
+	ASSERT_EQ( count, readPacked->m_Points.size() );
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		EXPECT_EQ( packed->m_Points[ i ].m_X, readPacked->m_Points[ i ].m_X ) << i;
+		EXPECT_EQ( packed->m_Points[ i ].m_Y, readPacked->m_Points[ i ].m_Y ) << i;
+		EXPECT_EQ( packed->m_Points[ i ].m_Z, readPacked->m_Points[ i ].m_Z ) << i;
+	}
+	EXPECT_TRUE( packed->m_Numbers == readPacked->m_Numbers );
+
+	// read by a build whose points have the same size, but other fields: values go to the fields they came from
+	ASSERT_TRUE( ReplaceInTestFile( path, "ArchiveTestPackedA", "ArchiveTestPackedB" ) );
+	read = ArchiveReader::ReadFromFile( path, NULL, ArchiveTypes::MessagePack, &error );
+	const ArchiveTestPackedB* evolved = SafeCast< ArchiveTestPackedB >( read.Ptr() );
+	ASSERT_TRUE( evolved != NULL ) << error;
+	ExpectPackedPoints( evolved, count, -1.f );
+	EXPECT_TRUE( packed->m_Numbers == evolved->m_Numbers );
+
+	// the form from before sequences were packed, each point as a map of its fields
+	DynamicArray< uint8_t > data;
+	{
+		DynamicMemoryStream stream ( &data );
+		MessagePackWriter writer ( &stream );
+		writer.BeginArray( 1 );
+		writer.BeginMap( 1 );
+		writer.Write( "ArchiveTestPackedB" );
+		writer.BeginMap( 1 );
+		writer.Write( "Points" );
+		writer.BeginArray( count );
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			writer.BeginMap( 3 );
+			writer.Write( "X" );
+			writer.Write( 1.f + i );
+			writer.Write( "Z" );
+			writer.Write( 3.f + i );
+			writer.Write( "W" );
+			writer.Write( 4.f );
+			writer.EndMap();
+		}
+		writer.EndArray();
+		writer.EndMap();
+		writer.EndMap();
+		writer.EndArray();
+		writer.Flush();
+	}
+
+	StaticMemoryStream stream ( data.GetData(), data.GetSize() );
+	ArchiveReaderMessagePack::ReadFromStream( stream, read );
+	evolved = SafeCast< ArchiveTestPackedB >( read.Ptr() );
+	ASSERT_TRUE( evolved != NULL );
+	ExpectPackedPoints( evolved, count, 4.f );
+
+	Helium::Delete( path.Data() );
+	Reflect::Shutdown();
+}
@@ -0,0 +1,362 @@
+#include "Precompile.h"
+#include "Platform/AsyncFile.h"
+
+#include "Platform/Assert.h"
+#include "Platform/Runtime.h"
+#include "Platform/Thread.h"
+
+using namespace Helium;
+
+AsyncFileRequest::AsyncFileRequest()
+	: m_File( NULL )
+	, m_Operation( AsyncFileOperations::Read )
+	, m_Buffer( NULL )
+	, m_Size( 0 )
+	, m_Offset( 0 )
+	, m_Callback( NULL )
+	, m_UserData( NULL )
+	, m_Complete( false )
+	, m_Succeeded( false )
+	, m_Transferred( 0 )
+	, m_Next( NULL )
+	, m_Result( 0 )
+{
+}
+
+void AsyncFileRequest::SetRead( File& file, void* buffer, size_t size, int64_t offset, AsyncFileCallback callback, void* userData )
+{
+	HELIUM_ASSERT( size <= 0x7fffffff );
+
+	m_File = &file;
+	m_Operation = AsyncFileOperations::Read;
+	m_Buffer = buffer;
+	m_Size = static_cast< uint32_t >( size );
+	m_Offset = offset;
+	m_Callback = callback;
+	m_UserData = userData;
+}
+
+void AsyncFileRequest::SetWrite( File& file, const void* buffer, size_t size, int64_t offset, AsyncFileCallback callback, void* userData )
+{
+	SetRead( file, const_cast< void* >( buffer ), size, offset, callback, userData );
+	m_Operation = AsyncFileOperations::Write;
+}
+
+struct AsyncFileQueue::Worker
+{
+	AsyncFileQueue* m_Queue;
+	CallbackThread  m_Thread;
+
+	void Run()
+	{
+		m_Queue->WorkerRun();
+	}
+};
+
+AsyncFileQueue::AsyncFileQueue()
+	: m_Initialized( false )
+	, m_Depth( 0 )
+	, m_Outstanding( 0 )
+	, m_InFlight( 0 )
+	, m_PendingHead( NULL )
+	, m_PendingTail( NULL )
+	, m_Ring( NULL )
+	, m_Workers( NULL )
+	, m_WorkerCount( 0 )
+	, m_Done( false, false )
+	, m_QueuedHead( NULL )
+	, m_QueuedTail( NULL )
+	, m_DoneHead( NULL )
+	, m_DoneTail( NULL )
+	, m_Stopping( false )
+{
+}
+
+AsyncFileQueue::~AsyncFileQueue()
+{
+	Shutdown();
+}
+
+bool AsyncFileQueue::Initialize( uint32_t depth, uint32_t threadCount, bool native )
+{
+	HELIUM_ASSERT( !m_Initialized );
+	HELIUM_ASSERT( depth > 0 );
+
+	m_Depth = depth;
+	if ( !native || !InitializeRing( depth ) )
+	{
+		if ( threadCount == 0 )
+		{
+			threadCount = Helium::Platform::GetProcessorCount();
+			threadCount = threadCount < 2 ? 2 : threadCount;
+		}
+
+		StartWorkers( threadCount );
+	}
+
+	m_Initialized = true;
+	return true;
+}
+
+void AsyncFileQueue::Shutdown()
+{
+	if ( !m_Initialized )
+	{
+		return;
+	}
+
+	WaitAll();
+
+	if ( m_Ring )
+	{
+		ShutdownRing();
+	}
+	else
+	{
+		StopWorkers();
+	}
+
+	m_Initialized = false;
+}
+
+void AsyncFileQueue::Submit( AsyncFileRequest& request )
+{
+	Submit( &request, 1 );
+}
+
+void AsyncFileQueue::Submit( AsyncFileRequest* requests, size_t count )
+{
+	HELIUM_ASSERT( m_Initialized );
+
+	for ( size_t i = 0; i < count; ++i )
+	{
+		AsyncFileRequest* request = &requests[ i ];
+		HELIUM_ASSERT( request->m_File && request->m_File->IsOpen() );
+		HELIUM_ASSERT( request->m_Buffer || request->m_Size == 0 );
+
+		request->m_Complete = false;
+		request->m_Succeeded = false;
+		request->m_Transferred = 0;
+		request->m_Result = 0;
+		request->m_Next = NULL;
+
+		if ( m_PendingTail )
+		{
+			m_PendingTail->m_Next = request;
+		}
+		else
+		{
+			m_PendingHead = request;
+		}
+		m_PendingTail = request;
+	}
+
+	m_Outstanding += static_cast< uint32_t >( count );
+
+	if ( m_Ring )
+	{
+		SubmitRing();
+	}
+	else
+	{
+		SubmitWorkers();
+	}
+}
+
+uint32_t AsyncFileQueue::Poll()
+{
+	return m_Ring ? ReapRing( 0 ) : ReapWorkers( 0 );
+}
+
+uint32_t AsyncFileQueue::Wait( uint32_t minimum )
+{
+	minimum = minimum < m_Outstanding ? minimum : m_Outstanding;
+	return m_Ring ? ReapRing( minimum ) : ReapWorkers( minimum );
+}
+
+void AsyncFileQueue::WaitAll()
+{
+	while ( m_Outstanding )
+	{
+		Wait( m_Outstanding );
+	}
+}
+
+void AsyncFileQueue::Complete( AsyncFileRequest* request )
+{
+	HELIUM_ASSERT( m_InFlight > 0 && m_Outstanding > 0 );
+	--m_InFlight;
+	--m_Outstanding;
+
+	request->m_Next = NULL;
+	request->m_Succeeded = request->m_Result >= 0;
+	request->m_Transferred = request->m_Succeeded ? static_cast< uint32_t >( request->m_Result ) : 0;
+	request->m_Complete = true;
+
+	// last, since the callback may reuse (or free) the request
+	if ( request->m_Callback )
+	{
+		request->m_Callback( *request );
+	}
+}
+
+void AsyncFileQueue::StartWorkers( uint32_t threadCount )
+{
+	m_Stopping = false;
+	m_WorkerCount = threadCount;
+	m_Workers = new Worker[ threadCount ];
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		m_Workers[ i ].m_Queue = this;
+		HELIUM_VERIFY( m_Workers[ i ].m_Thread.Create( &CallbackThread::EntryHelper< Worker, &Worker::Run >, &m_Workers[ i ], "Async File" ) );
+	}
+}
+
+void AsyncFileQueue::StopWorkers()
+{
+	m_Lock.Lock();
+	m_Stopping = true;
+	m_Lock.Unlock();
+
+	for ( uint32_t i = 0; i < m_WorkerCount; ++i )
+	{
+		m_Work.Increment();
+	}
+
+	for ( uint32_t i = 0; i < m_WorkerCount; ++i )
+	{
+		m_Workers[ i ].m_Thread.Join();
+	}
+
+	delete [] m_Workers;
+	m_Workers = NULL;
+	m_WorkerCount = 0;
+}
+
+void AsyncFileQueue::SubmitWorkers()
+{
+	// take what fits in flight, and hand it over with one lock
+	AsyncFileRequest* head = m_PendingHead;
+	AsyncFileRequest* tail = NULL;
+	uint32_t count = 0;
+	for ( AsyncFileRequest* request = m_PendingHead; request && m_InFlight < m_Depth; request = request->m_Next )
+	{
+		tail = request;
+		++m_InFlight;
+		++count;
+	}
+
+	if ( !count )
+	{
+		return;
+	}
+
+	m_PendingHead = tail->m_Next;
+	if ( !m_PendingHead )
+	{
+		m_PendingTail = NULL;
+	}
+	tail->m_Next = NULL;
+
+	m_Lock.Lock();
+	if ( m_QueuedTail )
+	{
+		m_QueuedTail->m_Next = head;
+	}
+	else
+	{
+		m_QueuedHead = head;
+	}
+	m_QueuedTail = tail;
+	m_Lock.Unlock();
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		m_Work.Increment();
+	}
+}
+
+uint32_t AsyncFileQueue::ReapWorkers( uint32_t minimum )
+{
+	uint32_t completed = 0;
+	for (;;)
+	{
+		m_Lock.Lock();
+		AsyncFileRequest* request = m_DoneHead;
+		m_DoneHead = NULL;
+		m_DoneTail = NULL;
+		m_Lock.Unlock();
+
+		while ( request )
+		{
+			AsyncFileRequest* next = request->m_Next;
+			Complete( request );
+			request = next;
+			++completed;
+		}
+
+		// completing made room in flight
+		SubmitWorkers();
+
+		if ( completed >= minimum )
+		{
+			break;
+		}
+
+		m_Done.Wait();
+	}
+
+	return completed;
+}
+
+void AsyncFileQueue::WorkerRun()
+{
+	for (;;)
+	{
+		m_Work.Decrement();
+
+		m_Lock.Lock();
+		AsyncFileRequest* request = m_QueuedHead;
+		if ( request )
+		{
+			m_QueuedHead = request->m_Next;
+			if ( !m_QueuedHead )
+			{
+				m_QueuedTail = NULL;
+			}
+		}
+		bool stopping = m_Stopping;
+		m_Lock.Unlock();
+
+		if ( !request )
+		{
+			if ( stopping )
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		size_t transferred = 0;
+		bool succeeded = request->m_Operation == AsyncFileOperations::Read
+			? request->m_File->ReadAt( request->m_Buffer, request->m_Size, request->m_Offset, &transferred )
+			: request->m_File->WriteAt( request->m_Buffer, request->m_Size, request->m_Offset, &transferred );
+		request->m_Result = succeeded ? static_cast< int32_t >( transferred ) : -1;
+		request->m_Next = NULL;
+
+		m_Lock.Lock();
+		if ( m_DoneTail )
+		{
+			m_DoneTail->m_Next = request;
+		}
+		else
+		{
+			m_DoneHead = request;
+		}
+		m_DoneTail = request;
+		m_Lock.Unlock();
+
+		m_Done.Signal();
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Platform/API.h"
+#include "Platform/Types.h"
+#include "Platform/Utility.h"
+#include "Platform/File.h"
+#include "Platform/Locks.h"
+#include "Platform/Condition.h"
+#include "Platform/Semaphore.h"
+
+namespace Helium
+{
+	namespace AsyncFileOperations
+	{
+		enum Type
+		{
+			Read,
+			Write,
+		};
+	}
+	typedef AsyncFileOperations::Type AsyncFileOperation;
+
+	struct AsyncFileRequest;
+	typedef void ( *AsyncFileCallback )( AsyncFileRequest& request );
+
+	//
+	// A positional read or write, which the caller keeps (with its buffer) until it completes
+	//
+
+	struct HELIUM_PLATFORM_API AsyncFileRequest
+	{
+		AsyncFileRequest();
+
+		void SetRead( File& file, void* buffer, size_t size, int64_t offset, AsyncFileCallback callback = NULL, void* userData = NULL );
+		void SetWrite( File& file, const void* buffer, size_t size, int64_t offset, AsyncFileCallback callback = NULL, void* userData = NULL );
+
+		// set by the caller
+		File*              m_File;
+		AsyncFileOperation m_Operation;
+		void*              m_Buffer;
+		uint32_t           m_Size;        // less than 2GB, like a single read() or write()
+		int64_t            m_Offset;
+		AsyncFileCallback  m_Callback;    // called from Poll() or Wait(), on the thread calling them
+		void*              m_UserData;
+
+		// set when it completes
+		bool               m_Complete;
+		bool               m_Succeeded;
+		uint32_t           m_Transferred; // like pread(), short reading past the end of the file
+
+		// used by the queue
+		AsyncFileRequest*  m_Next;
+		int32_t            m_Result;      // bytes transferred, or a negative error
+	};
+
+	//
+	// Batches of requests in flight at once, on io_uring where the kernel has it, or else a pool of threads doing
+	//  blocking positional reads and writes.  The queue belongs to one thread, which submits requests and completes
+	//  them with Poll() or Wait().
+	//
+
+	class HELIUM_PLATFORM_API AsyncFileQueue : NonCopyable
+	{
+	public:
+		AsyncFileQueue();
+		~AsyncFileQueue();
+
+		// depth is the most requests in flight (more wait their turn), threads are only started without io_uring (0 is
+		//  one per processor, but at least two), and native false always uses threads
+		bool Initialize( uint32_t depth = 64, uint32_t threadCount = 0, bool native = true );
+		void Shutdown(); // completes any outstanding requests first
+
+		inline bool IsInitialized() const;
+		inline bool IsNative() const;
+		inline uint32_t GetOutstanding() const;
+
+		void Submit( AsyncFileRequest& request );
+		void Submit( AsyncFileRequest* requests, size_t count );
+
+		// complete the requests that are done, returning how many that was
+		uint32_t Poll();
+
+		// block until at least minimum requests complete (or none are left), returning how many did
+		uint32_t Wait( uint32_t minimum = 1 );
+		void WaitAll();
+
+	private:
+		struct Ring;
+		struct Worker;
+
+		void Complete( AsyncFileRequest* request );
+
+		// io_uring (in AsyncFilePosix.cpp), InitializeRing() is false where it isn't available
+		bool InitializeRing( uint32_t depth );
+		void ShutdownRing();
+		void SubmitRing();
+		uint32_t ReapRing( uint32_t minimum );
+
+		// the thread pool
+		void StartWorkers( uint32_t threadCount );
+		void StopWorkers();
+		void SubmitWorkers();
+		uint32_t ReapWorkers( uint32_t minimum );
+		void WorkerRun();
+
+		bool              m_Initialized;
+		uint32_t          m_Depth;
+		uint32_t          m_Outstanding;   // submitted but not completed
+		uint32_t          m_InFlight;      // handed to the ring or the workers
+		AsyncFileRequest* m_PendingHead;   // waiting for room in flight
+		AsyncFileRequest* m_PendingTail;
+		Ring*             m_Ring;
+
+		Worker*           m_Workers;
+		uint32_t          m_WorkerCount;
+		Mutex             m_Lock;          // the lists shared with the workers
+		Semaphore         m_Work;
+		Condition         m_Done;
+		AsyncFileRequest* m_QueuedHead;    // for the workers
+		AsyncFileRequest* m_QueuedTail;
+		AsyncFileRequest* m_DoneHead;      // by the workers
+		AsyncFileRequest* m_DoneTail;
+		bool              m_Stopping;
+	};
+}
+
+#include "Platform/AsyncFile.inl"
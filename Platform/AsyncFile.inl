@@ -0,0 +1,14 @@
+bool Helium::AsyncFileQueue::IsInitialized() const
+{
+	return m_Initialized;
+}
+
+bool Helium::AsyncFileQueue::IsNative() const
+{
+	return m_Ring != NULL;
+}
+
+uint32_t Helium::AsyncFileQueue::GetOutstanding() const
+{
+	return m_Outstanding;
+}
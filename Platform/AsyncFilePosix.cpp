@@ -0,0 +1,334 @@
+#include "Precompile.h"
+#include "Platform/AsyncFile.h"
+
+#include "Platform/Assert.h"
+#include "Platform/Thread.h"
+
+#if HELIUM_OS_LINUX
+# include <linux/io_uring.h>
+#endif
+
+// IORING_FEAT_FAST_POLL came with the kernel after the one that added IORING_OP_READ and IORING_OP_WRITE
+#if HELIUM_OS_LINUX && defined( IORING_FEAT_FAST_POLL )
+# define HELIUM_ASYNC_FILE_URING 1
+#else
+# define HELIUM_ASYNC_FILE_URING 0
+#endif
+
+#if HELIUM_ASYNC_FILE_URING
+# include <errno.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+using namespace Helium;
+
+#if HELIUM_ASYNC_FILE_URING
+
+// the ring is mapped from the kernel, the application and the kernel each own one end of each queue
+struct AsyncFileQueue::Ring
+{
+	int            m_Fd;
+	void*          m_Map;
+	size_t         m_MapSize;
+	io_uring_sqe*  m_Sqes;
+	size_t         m_SqesSize;
+
+	unsigned*      m_SqHead;
+	unsigned*      m_SqTail;
+	unsigned*      m_SqArray;
+	unsigned       m_SqMask;
+
+	unsigned*      m_CqHead;
+	unsigned*      m_CqTail;
+	io_uring_cqe*  m_Cqes;
+	unsigned       m_CqMask;
+
+	bool           m_Submitting;
+	uint32_t       m_Completed;   // by SubmitRing(), for ReapRing() to count
+
+	AsyncFileRequest* TakeCompletions();
+};
+
+static int RingSetup( unsigned entries, io_uring_params* params )
+{
+	return static_cast< int >( syscall( __NR_io_uring_setup, entries, params ) );
+}
+
+static int RingEnter( int fd, unsigned toSubmit, unsigned minComplete, unsigned flags )
+{
+	int result;
+	do
+	{
+		result = static_cast< int >( syscall( __NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0 ) );
+	}
+	while ( result < 0 && errno == EINTR );
+
+	return result;
+}
+
+// take every completion off the queue, in order, with the results filled in
+AsyncFileRequest* AsyncFileQueue::Ring::TakeCompletions()
+{
+	AsyncFileRequest* head = NULL;
+	AsyncFileRequest* tail = NULL;
+	unsigned cqHead = *m_CqHead;
+	unsigned cqTail = __atomic_load_n( m_CqTail, __ATOMIC_ACQUIRE );
+	for ( ; cqHead != cqTail; ++cqHead )
+	{
+		io_uring_cqe* cqe = &m_Cqes[ cqHead & m_CqMask ];
+		AsyncFileRequest* request = reinterpret_cast< AsyncFileRequest* >( static_cast< uintptr_t >( cqe->user_data ) );
+		request->m_Result = cqe->res;
+		request->m_Next = NULL;
+
+		if ( tail )
+		{
+			tail->m_Next = request;
+		}
+		else
+		{
+			head = request;
+		}
+		tail = request;
+	}
+	__atomic_store_n( m_CqHead, cqHead, __ATOMIC_RELEASE );
+
+	return head;
+}
+
+bool AsyncFileQueue::InitializeRing( uint32_t depth )
+{
+	io_uring_params params;
+	MemoryZero( &params, sizeof( params ) );
+
+	// the completion queue is twice the size, so it can't overflow with no more than this in flight
+	int fd = RingSetup( depth < 4096 ? depth : 4096, &params );
+	if ( fd < 0 )
+	{
+		return false; // not built into the kernel, or blocked by seccomp
+	}
+
+	if ( !( params.features & IORING_FEAT_SINGLE_MMAP ) || !( params.features & IORING_FEAT_FAST_POLL ) )
+	{
+		close( fd );
+		return false; // too old for IORING_OP_READ and IORING_OP_WRITE
+	}
+
+	size_t sqSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+	size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+	size_t mapSize = sqSize > cqSize ? sqSize : cqSize;
+	void* map = mmap( NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+	if ( map == MAP_FAILED )
+	{
+		close( fd );
+		return false;
+	}
+
+	size_t sqesSize = params.sq_entries * sizeof( io_uring_sqe );
+	void* sqes = mmap( NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+	if ( sqes == MAP_FAILED )
+	{
+		munmap( map, mapSize );
+		close( fd );
+		return false;
+	}
+
+	uint8_t* bytes = static_cast< uint8_t* >( map );
+	m_Ring = new Ring;
+	m_Ring->m_Fd = fd;
+	m_Ring->m_Map = map;
+	m_Ring->m_MapSize = mapSize;
+	m_Ring->m_Sqes = static_cast< io_uring_sqe* >( sqes );
+	m_Ring->m_SqesSize = sqesSize;
+	m_Ring->m_SqHead = reinterpret_cast< unsigned* >( bytes + params.sq_off.head );
+	m_Ring->m_SqTail = reinterpret_cast< unsigned* >( bytes + params.sq_off.tail );
+	m_Ring->m_SqArray = reinterpret_cast< unsigned* >( bytes + params.sq_off.array );
+	m_Ring->m_SqMask = *reinterpret_cast< unsigned* >( bytes + params.sq_off.ring_mask );
+	m_Ring->m_CqHead = reinterpret_cast< unsigned* >( bytes + params.cq_off.head );
+	m_Ring->m_CqTail = reinterpret_cast< unsigned* >( bytes + params.cq_off.tail );
+	m_Ring->m_Cqes = reinterpret_cast< io_uring_cqe* >( bytes + params.cq_off.cqes );
+	m_Ring->m_CqMask = *reinterpret_cast< unsigned* >( bytes + params.cq_off.ring_mask );
+	m_Ring->m_Submitting = false;
+	m_Ring->m_Completed = 0;
+
+	m_Depth = depth < params.sq_entries ? depth : params.sq_entries;
+	return true;
+}
+
+void AsyncFileQueue::ShutdownRing()
+{
+	HELIUM_ASSERT( m_InFlight == 0 );
+
+	munmap( m_Ring->m_Sqes, m_Ring->m_SqesSize );
+	munmap( m_Ring->m_Map, m_Ring->m_MapSize );
+	close( m_Ring->m_Fd );
+
+	delete m_Ring;
+	m_Ring = NULL;
+}
+
+void AsyncFileQueue::SubmitRing()
+{
+	// completing requests below runs callbacks, anything they submit is picked up by the loop instead
+	if ( m_Ring->m_Submitting )
+	{
+		return;
+	}
+	m_Ring->m_Submitting = true;
+
+	for (;;)
+	{
+		// only this thread adds to the submission queue, and never more than it has room for
+		unsigned tail = *m_Ring->m_SqTail;
+		while ( m_PendingHead && m_InFlight < m_Depth )
+		{
+			AsyncFileRequest* request = m_PendingHead;
+			m_PendingHead = request->m_Next;
+			if ( !m_PendingHead )
+			{
+				m_PendingTail = NULL;
+			}
+			request->m_Next = NULL;
+
+			unsigned index = tail & m_Ring->m_SqMask;
+			io_uring_sqe* sqe = &m_Ring->m_Sqes[ index ];
+			MemoryZero( sqe, sizeof( *sqe ) );
+			sqe->opcode = request->m_Operation == AsyncFileOperations::Read ? IORING_OP_READ : IORING_OP_WRITE;
+			sqe->fd = request->m_File->m_Handle;
+			sqe->addr = reinterpret_cast< uintptr_t >( request->m_Buffer );
+			sqe->len = request->m_Size;
+			sqe->off = static_cast< uint64_t >( request->m_Offset );
+			sqe->user_data = reinterpret_cast< uintptr_t >( request );
+			m_Ring->m_SqArray[ index ] = index;
+
+			++tail;
+			++m_InFlight;
+		}
+		__atomic_store_n( m_Ring->m_SqTail, tail, __ATOMIC_RELEASE );
+
+		// whatever the kernel hasn't taken yet, from this call or one that couldn't finish
+		unsigned head = __atomic_load_n( m_Ring->m_SqHead, __ATOMIC_ACQUIRE );
+		unsigned unsubmitted = tail - head;
+		if ( !unsubmitted )
+		{
+			break;
+		}
+
+		if ( RingEnter( m_Ring->m_Fd, unsubmitted, 0, 0 ) >= 0 )
+		{
+			continue;
+		}
+
+		AsyncFileRequest* completed = NULL;
+		if ( errno == EAGAIN || errno == EBUSY )
+		{
+			// short of memory, or completions are backed up: make room by taking some, waiting for one if need be
+			completed = m_Ring->TakeCompletions();
+			if ( !completed )
+			{
+				if ( m_InFlight > unsubmitted )
+				{
+					RingEnter( m_Ring->m_Fd, 0, 1, IORING_ENTER_GETEVENTS );
+					completed = m_Ring->TakeCompletions();
+				}
+				else
+				{
+					Thread::Yield(); // nothing of ours is in the kernel, so it's short of memory, give it a moment
+				}
+			}
+		}
+		else
+		{
+			// nothing else gets better by trying again, take back what the kernel didn't (it only reads the queue in
+			//  RingEnter(), there's no polling thread) and fail it
+			int32_t error = -errno;
+			__atomic_store_n( m_Ring->m_SqTail, head, __ATOMIC_RELEASE );
+
+			AsyncFileRequest* last = NULL;
+			for ( ; head != tail; ++head )
+			{
+				io_uring_sqe* sqe = &m_Ring->m_Sqes[ m_Ring->m_SqArray[ head & m_Ring->m_SqMask ] ];
+				AsyncFileRequest* request = reinterpret_cast< AsyncFileRequest* >( static_cast< uintptr_t >( sqe->user_data ) );
+				request->m_Result = error;
+				request->m_Next = NULL;
+
+				if ( last )
+				{
+					last->m_Next = request;
+				}
+				else
+				{
+					completed = request;
+				}
+				last = request;
+			}
+		}
+
+		while ( completed )
+		{
+			AsyncFileRequest* next = completed->m_Next;
+			Complete( completed );
+			completed = next;
+			++m_Ring->m_Completed;
+		}
+	}
+
+	m_Ring->m_Submitting = false;
+}
+
+uint32_t AsyncFileQueue::ReapRing( uint32_t minimum )
+{
+	uint32_t completed = 0;
+	for (;;)
+	{
+		// take every completion before calling callbacks, which may submit more
+		AsyncFileRequest* request = m_Ring->TakeCompletions();
+		while ( request )
+		{
+			AsyncFileRequest* next = request->m_Next;
+			Complete( request );
+			request = next;
+			++completed;
+		}
+
+		// completing made room in flight (and submitting can complete some itself)
+		uint32_t submitCompleted = m_Ring->m_Completed;
+		SubmitRing();
+		completed += m_Ring->m_Completed - submitCompleted;
+
+		if ( completed >= minimum || !m_InFlight )
+		{
+			break;
+		}
+
+		RingEnter( m_Ring->m_Fd, 0, 1, IORING_ENTER_GETEVENTS );
+	}
+
+	return completed;
+}
+
+#else
+
+bool AsyncFileQueue::InitializeRing( uint32_t depth )
+{
+	return false;
+}
+
+void AsyncFileQueue::ShutdownRing()
+{
+	HELIUM_ASSERT( false );
+}
+
+void AsyncFileQueue::SubmitRing()
+{
+	HELIUM_ASSERT( false );
+}
+
+uint32_t AsyncFileQueue::ReapRing( uint32_t minimum )
+{
+	HELIUM_ASSERT( false );
+	return 0;
+}
+
+#endif
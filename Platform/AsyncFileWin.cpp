@@ -0,0 +1,29 @@
+#include "Precompile.h"
+#include "Platform/AsyncFile.h"
+
+#include "Platform/Assert.h"
+
+using namespace Helium;
+
+// there is no native queue on windows yet (that would be an I/O completion port), the thread pool does the work
+
+bool AsyncFileQueue::InitializeRing( uint32_t depth )
+{
+	return false;
+}
+
+void AsyncFileQueue::ShutdownRing()
+{
+	HELIUM_ASSERT( false );
+}
+
+void AsyncFileQueue::SubmitRing()
+{
+	HELIUM_ASSERT( false );
+}
+
+uint32_t AsyncFileQueue::ReapRing( uint32_t minimum )
+{
+	HELIUM_ASSERT( false );
+	return 0;
+}
@@ -56,11 +56,17 @@ namespace Helium
 		bool Write( const void* buffer, size_t numberOfBytesToWrite, size_t* numberOfBytesWritten = NULL );
 		bool Flush();
 
+		// at an offset, without using (or, on posix, moving) the file position, so threads can share the file
+		bool ReadAt( void* buffer, size_t numberOfBytesToRead, int64_t offset, size_t* numberOfBytesRead = NULL );
+		bool WriteAt( const void* buffer, size_t numberOfBytesToWrite, int64_t offset, size_t* numberOfBytesWritten = NULL );
+
 		int64_t Seek( int64_t offset, SeekOrigin origin );
 		int64_t Tell() const;
 		int64_t GetSize() const;
 
 	private:
+		friend class AsyncFileQueue;
+
 #ifdef HELIUM_OS_WIN
 		typedef HANDLE Handle;
 #else
@@ -102,6 +108,7 @@ namespace Helium
 		uint64_t     m_CreatedTime;
 		uint64_t     m_ModifiedTime;
 		uint64_t     m_AccessTime;
+		uint64_t     m_FileId;        // inode, where the file system has one (0 on windows)
 	};
 
 	//
@@ -142,6 +149,50 @@ namespace Helium
 		Handle m_Handle;
 	};
 
+	// reads a directory's entries many at a time, skipping "." and "..", with the type of each
+	//  from the listing itself where the file system has it (so scanning doesn't need a status read per entry)
+	class HELIUM_PLATFORM_API DirectoryReader : NonCopyable
+	{
+	public:
+		DirectoryReader();
+		~DirectoryReader();
+
+		bool IsOpen() const;
+		bool Open( const char* path );
+		bool Next();
+		void Close();
+
+		// name of the current entry, until the next one
+		inline const char* GetName() const;
+
+		// StatusModes type bits (Directory, Link, Pipe, Special, or none for a file) of the current entry
+		uint32_t GetMode();
+
+		// full status of the current entry, following links (free on windows, one status read elsewhere)
+		bool GetStatus( Status& status );
+
+	private:
+		const char* m_Name;
+
+#if HELIUM_OS_WIN
+		std::string m_NameBuffer;
+		void*       m_Handle;
+		void*       m_FindData;
+		bool        m_Found;
+#else
+		int         m_Handle;
+		uint32_t    m_Mode;
+		bool        m_ModeKnown;
+# if HELIUM_OS_LINUX
+		char*       m_Buffer;
+		size_t      m_BufferSize;
+		size_t      m_BufferOffset;
+# else
+		DIR*        m_Dir;
+# endif
+#endif
+	};
+
 	//
 	// File system operations
 	//
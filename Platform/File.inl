@@ -8,3 +8,8 @@ void Helium::Directory::SetPath( const std::string& path )
 	Close();
 	m_Path = path;
 }
+
+const char* Helium::DirectoryReader::GetName() const
+{
+	return m_Name;
+}
@@ -14,6 +14,7 @@
 
 #if HELIUM_OS_LINUX
 # include <sys/sendfile.h>
+# include <sys/syscall.h>
 #endif
 
 #if HELIUM_OS_MAC
@@ -22,6 +23,52 @@
 
 using namespace Helium;
 
+// the S_IF values share bits, so test the type as a whole
+static uint32_t FromStatType( mode_t mode )
+{
+	if ( S_ISDIR( mode ) )
+	{
+		return StatusModes::Directory;
+	}
+	if ( S_ISLNK( mode ) )
+	{
+		return StatusModes::Link;
+	}
+	if ( S_ISFIFO( mode ) )
+	{
+		return StatusModes::Pipe;
+	}
+	if ( !S_ISREG( mode ) )
+	{
+		return StatusModes::Special;
+	}
+
+	return StatusModes::None;
+}
+
+static void FromStat( const struct stat& status, Status& ourStatus )
+{
+	ourStatus.m_Mode = FromStatType( status.st_mode );
+	if ( status.st_mode & S_IRUSR )
+	{
+		ourStatus.m_Mode |= StatusModes::Read;
+	}
+	if ( status.st_mode & S_IWUSR )
+	{
+		ourStatus.m_Mode |= StatusModes::Write;
+	}
+	if ( status.st_mode & S_IXUSR )
+	{
+		ourStatus.m_Mode |= StatusModes::Execute;
+	}
+
+	ourStatus.m_Size = status.st_size;
+	ourStatus.m_CreatedTime = status.st_ctime;
+	ourStatus.m_ModifiedTime = status.st_mtime;
+	ourStatus.m_AccessTime = status.st_atime;
+	ourStatus.m_FileId = status.st_ino;
+}
+
 //
 // File contents
 //
@@ -69,7 +116,8 @@ bool File::Open( const char* filename, FileMode mode, bool truncate )
 		}
 	}
 
-	m_Handle = open( filename, flags );
+	// created files get the usual permissions (less the umask)
+	m_Handle = open( filename, flags, 0666 );
 	return m_Handle >= 0;
 }
 
@@ -95,7 +143,7 @@ bool File::Read( void* buffer, size_t numberOfBytesToRead, size_t* numberOfBytes
 
 	if (numberOfBytesRead)
 	{
-		*numberOfBytesRead = numberOfBytesToRead;
+		*numberOfBytesRead = static_cast< size_t >( result );
 	}
 	return true;
 }
@@ -111,7 +159,7 @@ bool File::Write( const void* buffer, size_t numberOfBytesToWrite, size_t* numbe
 
 	if (numberOfBytesWritten)
 	{
-		*numberOfBytesWritten = numberOfBytesToWrite;
+		*numberOfBytesWritten = static_cast< size_t >( result );
 	}
 	return true;
 }
@@ -121,6 +169,50 @@ bool File::Flush()
 	return 0 == fsync( m_Handle );
 }
 
+bool File::ReadAt( void* buffer, size_t numberOfBytesToRead, int64_t offset, size_t* numberOfBytesRead )
+{
+	HELIUM_ASSERT( buffer || numberOfBytesToRead == 0 );
+	ssize_t result;
+	do
+	{
+		result = pread( m_Handle, buffer, numberOfBytesToRead, offset );
+	}
+	while ( result < 0 && errno == EINTR );
+
+	if ( result < 0 )
+	{
+		return false;
+	}
+
+	if (numberOfBytesRead)
+	{
+		*numberOfBytesRead = static_cast< size_t >( result );
+	}
+	return true;
+}
+
+bool File::WriteAt( const void* buffer, size_t numberOfBytesToWrite, int64_t offset, size_t* numberOfBytesWritten )
+{
+	HELIUM_ASSERT( buffer || numberOfBytesToWrite == 0 );
+	ssize_t result;
+	do
+	{
+		result = pwrite( m_Handle, buffer, numberOfBytesToWrite, offset );
+	}
+	while ( result < 0 && errno == EINTR );
+
+	if ( result < 0 )
+	{
+		return false;
+	}
+
+	if (numberOfBytesWritten)
+	{
+		*numberOfBytesWritten = static_cast< size_t >( result );
+	}
+	return true;
+}
+
 int64_t File::Seek( int64_t offset, SeekOrigin origin )
 {
 	int whence =
@@ -153,6 +245,7 @@ Status::Status()
 , m_CreatedTime( 0 )
 , m_ModifiedTime( 0 )
 , m_AccessTime( 0 )
+, m_FileId( 0 )
 {
 
 }
@@ -162,40 +255,7 @@ bool Status::Read( const char* path )
 	struct stat status;
 	if ( 0 == stat( path, &status ) )
 	{
-		m_Mode = 0;
-		if ( status.st_mode & S_IFDIR )
-		{
-			m_Mode |= StatusModes::Directory;
-		}
-		if ( status.st_mode & S_IFLNK )
-		{
-			m_Mode |= StatusModes::Link;
-		}
-		if ( status.st_mode & S_IFIFO )
-		{
-			m_Mode |= StatusModes::Pipe;
-		}
-		if ( m_Mode == 0x0 )
-		{
-			m_Mode |= StatusModes::Special;
-		}
-		if ( status.st_mode & S_IRUSR )
-		{
-			m_Mode |= StatusModes::Read;
-		}
-		if ( status.st_mode & S_IWUSR )
-		{
-			m_Mode |= StatusModes::Write;
-		}
-		if ( status.st_mode & S_IXUSR )
-		{
-			m_Mode |= StatusModes::Execute;
-		}
-
-		m_Size = status.st_size;
-		m_CreatedTime = status.st_ctime;
-		m_ModifiedTime = status.st_mtime;
-		m_AccessTime = status.st_atime;
+		FromStat( status, *this );
 		return true;
 	}
 
@@ -246,7 +306,17 @@ bool Directory::FindNext( DirectoryEntry& entry )
 	if ( dirEntry )
 	{
 		entry.m_Name = dirEntry->d_name;
-		entry.m_Stat.Read( entry.m_Name.c_str() );
+
+		// the name is relative to the directory, not the working directory
+		struct stat status;
+		if ( 0 == fstatat( dirfd( m_Handle ), dirEntry->d_name, &status, 0 ) )
+		{
+			FromStat( status, entry.m_Stat );
+		}
+		else
+		{
+			entry.m_Stat = Status();
+		}
 		return true;
 	}
 	return false;
@@ -263,6 +333,207 @@ bool Directory::Close()
 	return true;
 }
 
+#if HELIUM_OS_LINUX
+// what getdents64 fills the buffer with, declared here since older c libraries don't wrap it
+struct LinuxDirent64
+{
+	uint64_t       d_ino;
+	int64_t        d_off;
+	unsigned short d_reclen;
+	unsigned char  d_type;
+	char           d_name[ 1 ];
+};
+
+// enough for a few hundred entries a call, readdir asks for 32KB at a time
+static const size_t DirectoryReaderBufferSize = 64 * 1024;
+#endif
+
+// some file systems don't fill in the type, those entries need a status read
+static bool FromDirentType( unsigned char type, uint32_t& mode )
+{
+	switch ( type )
+	{
+	case DT_UNKNOWN:
+		return false;
+	case DT_REG:
+		mode = StatusModes::None;
+		break;
+	case DT_DIR:
+		mode = StatusModes::Directory;
+		break;
+	case DT_LNK:
+		mode = StatusModes::Link;
+		break;
+	case DT_FIFO:
+		mode = StatusModes::Pipe;
+		break;
+	default:
+		mode = StatusModes::Special;
+		break;
+	}
+
+	return true;
+}
+
+static bool IsDotOrDotDot( const char* name )
+{
+	return name[ 0 ] == '.' && ( name[ 1 ] == '\0' || ( name[ 1 ] == '.' && name[ 2 ] == '\0' ) );
+}
+
+DirectoryReader::DirectoryReader()
+	: m_Name( NULL )
+	, m_Handle( -1 )
+	, m_Mode( 0 )
+	, m_ModeKnown( false )
+#if HELIUM_OS_LINUX
+	, m_Buffer( NULL )
+	, m_BufferSize( 0 )
+	, m_BufferOffset( 0 )
+#else
+	, m_Dir( NULL )
+#endif
+{
+}
+
+DirectoryReader::~DirectoryReader()
+{
+	Close();
+
+#if HELIUM_OS_LINUX
+	delete [] m_Buffer;
+#endif
+}
+
+bool DirectoryReader::IsOpen() const
+{
+	return m_Handle >= 0;
+}
+
+bool DirectoryReader::Open( const char* path )
+{
+	Close();
+
+	m_Handle = open( path, O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+	if ( m_Handle < 0 )
+	{
+		return false;
+	}
+
+#if HELIUM_OS_LINUX
+	// kept from one directory to the next
+	if ( !m_Buffer )
+	{
+		m_Buffer = new char[ DirectoryReaderBufferSize ];
+	}
+#else
+	m_Dir = fdopendir( m_Handle );
+	if ( !m_Dir )
+	{
+		close( m_Handle );
+		m_Handle = -1;
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+bool DirectoryReader::Next()
+{
+	HELIUM_ASSERT( IsOpen() );
+
+	for (;;)
+	{
+#if HELIUM_OS_LINUX
+		if ( m_BufferOffset >= m_BufferSize )
+		{
+			long size;
+			do
+			{
+				size = syscall( SYS_getdents64, m_Handle, m_Buffer, DirectoryReaderBufferSize );
+			}
+			while ( size < 0 && errno == EINTR );
+
+			if ( size <= 0 )
+			{
+				m_Name = NULL;
+				return false;
+			}
+
+			m_BufferSize = static_cast< size_t >( size );
+			m_BufferOffset = 0;
+		}
+
+		const LinuxDirent64* entry = reinterpret_cast< const LinuxDirent64* >( m_Buffer + m_BufferOffset );
+		m_BufferOffset += entry->d_reclen;
+#else
+		const struct dirent* entry = readdir( m_Dir );
+		if ( !entry )
+		{
+			m_Name = NULL;
+			return false;
+		}
+#endif
+
+		if ( !IsDotOrDotDot( entry->d_name ) )
+		{
+			m_Name = entry->d_name;
+			m_ModeKnown = FromDirentType( entry->d_type, m_Mode );
+			return true;
+		}
+	}
+}
+
+void DirectoryReader::Close()
+{
+#if HELIUM_OS_LINUX
+	if ( m_Handle >= 0 )
+	{
+		close( m_Handle );
+	}
+
+	m_BufferSize = 0;
+	m_BufferOffset = 0;
+#else
+	if ( m_Dir )
+	{
+		closedir( m_Dir ); // closes the handle too
+		m_Dir = NULL;
+	}
+#endif
+
+	m_Handle = -1;
+	m_Name = NULL;
+}
+
+uint32_t DirectoryReader::GetMode()
+{
+	HELIUM_ASSERT( m_Name );
+
+	if ( !m_ModeKnown )
+	{
+		struct stat status;
+		m_Mode = 0 == fstatat( m_Handle, m_Name, &status, AT_SYMLINK_NOFOLLOW ) ? FromStatType( status.st_mode ) : static_cast< uint32_t >( StatusModes::Special );
+		m_ModeKnown = true;
+	}
+
+	return m_Mode;
+}
+
+bool DirectoryReader::GetStatus( Status& status )
+{
+	HELIUM_ASSERT( m_Name );
+
+	struct stat fileStatus;
+	if ( 0 == fstatat( m_Handle, m_Name, &fileStatus, 0 ) )
+	{
+		FromStat( fileStatus, status );
+		return true;
+	}
+
+	return false;
+}
+
 //
 // File system ops
 //
@@ -361,12 +632,9 @@ bool Helium::MakePath( const char* path )
 	{
 		if ( stat( currentDirectory.c_str(), &status ) != 0 )
 		{
-			if ( !mkdir( currentDirectory.c_str(), 0777 ) )
+			if ( mkdir( currentDirectory.c_str(), 0777 ) != 0 && errno != EEXIST )
 			{
-				if ( errno != EEXIST )
-				{
-					return false;
-				}
+				return false;
 			}
 		}
 
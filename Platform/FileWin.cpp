@@ -146,6 +146,61 @@ bool File::Flush()
 	return 1 == ::FlushFileBuffers( m_Handle );
 }
 
+bool File::ReadAt( void* buffer, size_t numberOfBytesToRead, int64_t offset, size_t* numberOfBytesRead )
+{
+	HELIUM_ASSERT_MSG( numberOfBytesToRead <= MAXDWORD, "File read operations are limited to DWORD sizes" );
+	if( numberOfBytesToRead > MAXDWORD )
+	{
+		return false;
+	}
+
+	HELIUM_ASSERT( buffer || numberOfBytesToRead == 0 );
+
+	// the offset goes in an OVERLAPPED, which on a synchronous handle leaves the file position after the read
+	OVERLAPPED overlapped;
+	MemoryZero( &overlapped, sizeof( overlapped ) );
+	overlapped.Offset = static_cast< DWORD >( offset );
+	overlapped.OffsetHigh = static_cast< DWORD >( offset >> 32 );
+
+	DWORD tempBytesRead = 0;
+	bool result = 1 == ::ReadFile( m_Handle, buffer, static_cast< DWORD >( numberOfBytesToRead ), &tempBytesRead, &overlapped );
+	if ( !result && ::GetLastError() == ERROR_HANDLE_EOF )
+	{
+		result = true;
+		tempBytesRead = 0;
+	}
+
+	if ( result && numberOfBytesRead )
+	{
+		*numberOfBytesRead = tempBytesRead;
+	}
+	return result;
+}
+
+bool File::WriteAt( const void* buffer, size_t numberOfBytesToWrite, int64_t offset, size_t* numberOfBytesWritten )
+{
+	HELIUM_ASSERT_MSG( numberOfBytesToWrite <= MAXDWORD, "File write operations are limited to DWORD sizes" );
+	if( numberOfBytesToWrite > MAXDWORD )
+	{
+		return false;
+	}
+
+	HELIUM_ASSERT( buffer || numberOfBytesToWrite == 0 );
+
+	OVERLAPPED overlapped;
+	MemoryZero( &overlapped, sizeof( overlapped ) );
+	overlapped.Offset = static_cast< DWORD >( offset );
+	overlapped.OffsetHigh = static_cast< DWORD >( offset >> 32 );
+
+	DWORD tempBytesWritten = 0;
+	bool result = 1 == ::WriteFile( m_Handle, buffer, static_cast< DWORD >( numberOfBytesToWrite ), &tempBytesWritten, &overlapped );
+	if ( result && numberOfBytesWritten )
+	{
+		*numberOfBytesWritten = tempBytesWritten;
+	}
+	return result;
+}
+
 int64_t File::Seek( int64_t offset, SeekOrigin origin )
 {
 	LARGE_INTEGER moveDistance;
@@ -200,6 +255,7 @@ Status::Status()
 , m_CreatedTime( 0 )
 , m_ModifiedTime( 0 )
 , m_AccessTime( 0 )
+, m_FileId( 0 )
 {
 
 }
@@ -290,6 +346,97 @@ bool Directory::Close()
 	return true;
 }
 
+DirectoryReader::DirectoryReader()
+	: m_Name( NULL )
+	, m_Handle( INVALID_HANDLE_VALUE )
+	, m_FindData( new WIN32_FIND_DATA )
+	, m_Found( false )
+{
+}
+
+DirectoryReader::~DirectoryReader()
+{
+	Close();
+	delete static_cast< WIN32_FIND_DATA* >( m_FindData );
+}
+
+bool DirectoryReader::IsOpen() const
+{
+	return m_Handle != INVALID_HANDLE_VALUE;
+}
+
+bool DirectoryReader::Open( const char* path )
+{
+	Close();
+
+	std::string pattern ( path );
+	pattern += "/*";
+	HELIUM_TCHAR_TO_WIDE( pattern.c_str(), convertedPattern );
+
+	// the basic info skips the short names, and the large fetch asks for more entries a call
+	m_Handle = ::FindFirstFileEx( convertedPattern, FindExInfoBasic, m_FindData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH );
+	m_Found = m_Handle != INVALID_HANDLE_VALUE;
+	return m_Found;
+}
+
+bool DirectoryReader::Next()
+{
+	HELIUM_ASSERT( IsOpen() );
+
+	WIN32_FIND_DATA* findData = static_cast< WIN32_FIND_DATA* >( m_FindData );
+	for (;;)
+	{
+		// the first entry came with the handle
+		if ( !m_Found && !::FindNextFile( m_Handle, findData ) )
+		{
+			m_Name = NULL;
+			return false;
+		}
+		m_Found = false;
+
+		ConvertString( findData->cFileName, m_NameBuffer );
+		if ( m_NameBuffer != "." && m_NameBuffer != ".." )
+		{
+			m_Name = m_NameBuffer.c_str();
+			return true;
+		}
+	}
+}
+
+void DirectoryReader::Close()
+{
+	if ( IsOpen() )
+	{
+		::FindClose( m_Handle );
+	}
+
+	m_Handle = INVALID_HANDLE_VALUE;
+	m_Name = NULL;
+	m_Found = false;
+}
+
+uint32_t DirectoryReader::GetMode()
+{
+	HELIUM_ASSERT( m_Name );
+
+	uint32_t mode;
+	FromWindowsAttributes( static_cast< WIN32_FIND_DATA* >( m_FindData )->dwFileAttributes, mode );
+	return mode;
+}
+
+bool DirectoryReader::GetStatus( Status& status )
+{
+	HELIUM_ASSERT( m_Name );
+
+	const WIN32_FIND_DATA* findData = static_cast< WIN32_FIND_DATA* >( m_FindData );
+	status.m_Size = ( (uint64_t)findData->nFileSizeHigh << 32 ) | findData->nFileSizeLow;
+	status.m_CreatedTime = FromWindowsTime( findData->ftCreationTime );
+	status.m_ModifiedTime = FromWindowsTime( findData->ftLastWriteTime );
+	status.m_AccessTime = FromWindowsTime( findData->ftLastAccessTime );
+	FromWindowsAttributes( findData->dwFileAttributes, status.m_Mode );
+	return true;
+}
+
 //
 // File system ops
 //
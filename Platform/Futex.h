@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Platform/API.h"
+#include "Platform/Types.h"
+
+namespace Helium
+{
+	/// @defgroup futex Address-Based Thread Parking
+	///
+	/// These functions allow a thread to sleep until the value stored at a given address changes, without requiring a
+	/// kernel object per waitable address.  They are intended as a building block for lock-free structures that only
+	/// want to pay for a system call when a thread actually has to block (i.e. a consumer finding its queue empty).
+	///
+	/// Waits may return spuriously, so callers must always re-check the condition they are waiting on.  Waking only
+	/// releases threads that are already blocked in FutexWait(), so the waking thread must update the watched value
+	/// before calling FutexWake() or FutexWakeAll().
+	//@{
+
+	/// Block the calling thread as long as the value at the given address is equal to an expected value.
+	///
+	/// @param[in] rAddress  32-bit integer to watch.
+	/// @param[in] expected  Value that the integer must hold for the thread to go to sleep.
+	HELIUM_PLATFORM_API void FutexWait( int32_t volatile & rAddress, int32_t expected );
+
+	/// Wake a single thread blocked in FutexWait() on the given address.
+	///
+	/// @param[in] rAddress  Watched 32-bit integer.
+	HELIUM_PLATFORM_API void FutexWake( int32_t volatile & rAddress );
+
+	/// Wake all threads blocked in FutexWait() on the given address.
+	///
+	/// @param[in] rAddress  Watched 32-bit integer.
+	HELIUM_PLATFORM_API void FutexWakeAll( int32_t volatile & rAddress );
+
+	//@}
+}
@@ -0,0 +1,100 @@
+#include "Precompile.h"
+#include "Futex.h"
+
+#include "Platform/Assert.h"
+
+#include <errno.h>
+#include <limits.h>
+
+#if HELIUM_OS_LINUX
+# include <unistd.h>
+# include <sys/syscall.h>
+# include <linux/futex.h>
+#else
+# include <pthread.h>
+#endif
+
+using namespace Helium;
+
+#if HELIUM_OS_LINUX
+
+static long futex( int32_t volatile* address, int op, int32_t value )
+{
+    return syscall( SYS_futex, const_cast< int32_t* >( address ), op, value, NULL, NULL, 0 );
+}
+
+void Helium::FutexWait( int32_t volatile & rAddress, int32_t expected )
+{
+    long result = futex( &rAddress, FUTEX_WAIT_PRIVATE, expected );
+    HELIUM_ASSERT( result == 0 || errno == EAGAIN || errno == EINTR );
+    HELIUM_UNUSED( result );
+}
+
+void Helium::FutexWake( int32_t volatile & rAddress )
+{
+    futex( &rAddress, FUTEX_WAKE_PRIVATE, 1 );
+}
+
+void Helium::FutexWakeAll( int32_t volatile & rAddress )
+{
+    futex( &rAddress, FUTEX_WAKE_PRIVATE, INT_MAX );
+}
+
+#else
+
+// No public futex on this platform, so waiters park on a condition variable picked from a small table hashed on the
+//  watched address.  Unrelated addresses may share a bucket, which only costs a spurious wakeup.
+
+#define FUTEX_BUCKET_COUNT 64
+
+struct FutexBucket
+{
+    pthread_mutex_t m_Mutex;
+    pthread_cond_t  m_Condition;
+};
+
+static FutexBucket g_FutexBuckets[ FUTEX_BUCKET_COUNT ];
+static pthread_once_t g_FutexOnce = PTHREAD_ONCE_INIT;
+
+static void InitializeFutexBuckets()
+{
+    for ( size_t i = 0; i < FUTEX_BUCKET_COUNT; ++i )
+    {
+        pthread_mutex_init( &g_FutexBuckets[ i ].m_Mutex, NULL );
+        pthread_cond_init( &g_FutexBuckets[ i ].m_Condition, NULL );
+    }
+}
+
+static FutexBucket& GetFutexBucket( int32_t volatile* address )
+{
+    pthread_once( &g_FutexOnce, &InitializeFutexBuckets );
+    uintptr_t hash = reinterpret_cast< uintptr_t >( address ) >> 2;
+    return g_FutexBuckets[ ( hash ^ ( hash >> 6 ) ) % FUTEX_BUCKET_COUNT ];
+}
+
+void Helium::FutexWait( int32_t volatile & rAddress, int32_t expected )
+{
+    FutexBucket& bucket = GetFutexBucket( &rAddress );
+    pthread_mutex_lock( &bucket.m_Mutex );
+    if ( rAddress == expected )
+    {
+        pthread_cond_wait( &bucket.m_Condition, &bucket.m_Mutex );
+    }
+    pthread_mutex_unlock( &bucket.m_Mutex );
+}
+
+void Helium::FutexWake( int32_t volatile & rAddress )
+{
+    // the bucket may be shared, so a single signal could land on the wrong waiter
+    FutexWakeAll( rAddress );
+}
+
+void Helium::FutexWakeAll( int32_t volatile & rAddress )
+{
+    FutexBucket& bucket = GetFutexBucket( &rAddress );
+    pthread_mutex_lock( &bucket.m_Mutex );
+    pthread_cond_broadcast( &bucket.m_Condition );
+    pthread_mutex_unlock( &bucket.m_Mutex );
+}
+
+#endif
@@ -0,0 +1,23 @@
+#include "Precompile.h"
+#include "Futex.h"
+
+#include "Platform/Assert.h"
+
+#pragma comment ( lib, "Synchronization.lib" )
+
+using namespace Helium;
+
+void Helium::FutexWait( int32_t volatile & rAddress, int32_t expected )
+{
+    ::WaitOnAddress( &rAddress, &expected, sizeof( expected ), INFINITE );
+}
+
+void Helium::FutexWake( int32_t volatile & rAddress )
+{
+    ::WakeByAddressSingle( const_cast< int32_t* >( &rAddress ) );
+}
+
+void Helium::FutexWakeAll( int32_t volatile & rAddress )
+{
+    ::WakeByAddressAll( const_cast< int32_t* >( &rAddress ) );
+}
@@ -1,4 +1,254 @@
-#include "gtest/gtest.h"
-
-TEST(PlatformGeneral, GoogleTestTest) {
-}
\ No newline at end of file
+#include "Precompile.h"
+#include "Platform/AsyncFile.h"
+#include "Platform/Atomic.h"
+#include "Platform/Console.h"
+#include "Platform/Tests.h"
+#include "Platform/Thread.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace Helium;
+
+TEST(PlatformGeneral, GoogleTestTest) {
+}
+
+static int32_t volatile g_ThreadLocalDestroyed = 0;
+
+static void HELIUM_THREAD_LOCAL_DESTRUCTOR DestroyThreadLocal( void* value )
+{
+	AtomicAdd( g_ThreadLocalDestroyed, *static_cast< int32_t* >( value ) );
+}
+
+struct ThreadLocalJob
+{
+	ThreadLocalPointer* m_Pointer;
+	int32_t             m_Value;
+	bool                m_Set;
+
+	void Run()
+	{
+		if ( m_Set )
+		{
+			m_Pointer->SetPointer( &m_Value );
+		}
+	}
+};
+
+TEST(PlatformThread, ThreadLocalDestructor)
+{
+	ThreadLocalPointer pointer ( &DestroyThreadLocal );
+	int32_t mainValue = 100;
+	pointer.SetPointer( &mainValue );
+
+	// each exiting thread that set a value has it destroyed, the others (and this one) don't
+	ThreadLocalJob jobs[ 3 ];
+	CallbackThread threads[ 3 ];
+	for ( int32_t i = 0; i < 3; ++i )
+	{
+		jobs[ i ].m_Pointer = &pointer;
+		jobs[ i ].m_Value = 1 << i;
+		jobs[ i ].m_Set = i != 1;
+		ASSERT_TRUE( threads[ i ].Create( &CallbackThread::EntryHelper< ThreadLocalJob, &ThreadLocalJob::Run >, &jobs[ i ], "Thread Local" ) );
+	}
+	for ( int32_t i = 0; i < 3; ++i )
+	{
+		threads[ i ].Join();
+	}
+
+	EXPECT_EQ( 1 + 4, g_ThreadLocalDestroyed );
+	EXPECT_EQ( &mainValue, pointer.GetPointer() );
+	pointer.SetPointer( NULL );
+}
+
+static void MakeFileData( std::vector< uint8_t >& data, size_t size, uint32_t seed )
+{
+	data.resize( size );
+	MakeTestBytes( &data[ 0 ], size, seed );
+}
+
+static void CountCompletion( AsyncFileRequest& request )
+{
+	++*static_cast< uint32_t* >( request.m_UserData );
+}
+
+static void AsyncFileRoundTrip( bool native )
+{
+	const char* path = native ? "PlatformAsyncFileNative.bin" : "PlatformAsyncFileThreads.bin";
+	const size_t chunkSize = 4096;
+	const size_t chunkCount = 64;
+
+	AsyncFileQueue queue;
+	ASSERT_TRUE( queue.Initialize( 16, 4, native ) );
+	if ( native && !queue.IsNative() )
+	{
+		Helium::Print( "AsyncFileQueue: no native queue here, testing the thread pool\n" );
+	}
+
+	std::vector< uint8_t > data;
+	MakeFileData( data, chunkSize * chunkCount, 1 );
+
+	// more than the depth, in reverse, so some wait their turn and none land in order
+	File file;
+	ASSERT_TRUE( file.Open( path, FileModes::Both ) );
+
+	uint32_t callbacks = 0;
+	std::vector< AsyncFileRequest > requests ( chunkCount );
+	for ( size_t i = 0; i < chunkCount; ++i )
+	{
+		size_t chunk = chunkCount - 1 - i;
+		requests[ i ].SetWrite( file, &data[ chunk * chunkSize ], chunkSize, chunk * chunkSize, &CountCompletion, &callbacks );
+	}
+	queue.Submit( &requests[ 0 ], chunkCount );
+	queue.WaitAll();
+
+	EXPECT_EQ( chunkCount, callbacks );
+	EXPECT_EQ( 0u, queue.GetOutstanding() );
+	for ( size_t i = 0; i < chunkCount; ++i )
+	{
+		EXPECT_TRUE( requests[ i ].m_Complete );
+		EXPECT_TRUE( requests[ i ].m_Succeeded );
+		EXPECT_EQ( chunkSize, requests[ i ].m_Transferred );
+	}
+	EXPECT_EQ( static_cast< int64_t >( data.size() ), file.GetSize() );
+
+	// read it back, the last request running off the end of the file
+	std::vector< uint8_t > readBack ( data.size() + chunkSize, 0 );
+	for ( size_t i = 0; i < chunkCount; ++i )
+	{
+		requests[ i ].SetRead( file, &readBack[ i * chunkSize ], chunkSize, i * chunkSize );
+	}
+	requests[ chunkCount - 1 ].SetRead( file, &readBack[ ( chunkCount - 1 ) * chunkSize ], chunkSize * 2, ( chunkCount - 1 ) * chunkSize );
+
+	AsyncFileRequest pastEnd;
+	pastEnd.SetRead( file, &readBack[ 0 ], chunkSize, data.size() + chunkSize );
+
+	queue.Submit( &requests[ 0 ], chunkCount );
+	queue.Submit( pastEnd );
+
+	uint32_t completed = queue.Poll();
+	while ( queue.GetOutstanding() )
+	{
+		completed += queue.Wait();
+	}
+	EXPECT_EQ( chunkCount + 1, completed );
+
+	for ( size_t i = 0; i + 1 < chunkCount; ++i )
+	{
+		EXPECT_EQ( chunkSize, requests[ i ].m_Transferred );
+	}
+	EXPECT_TRUE( requests[ chunkCount - 1 ].m_Succeeded );
+	EXPECT_EQ( chunkSize, requests[ chunkCount - 1 ].m_Transferred );
+	EXPECT_TRUE( pastEnd.m_Succeeded );
+	EXPECT_EQ( 0u, pastEnd.m_Transferred );
+	EXPECT_TRUE( memcmp( &data[ 0 ], &readBack[ 0 ], data.size() ) == 0 );
+
+	// nothing outstanding
+	EXPECT_EQ( 0u, queue.Poll() );
+	EXPECT_EQ( 0u, queue.Wait() );
+
+	queue.Shutdown();
+	file.Close();
+	Helium::Delete( path );
+}
+
+TEST(PlatformAsyncFile, NativeRoundTrip)
+{
+	AsyncFileRoundTrip( true );
+}
+
+TEST(PlatformAsyncFile, ThreadPoolRoundTrip)
+{
+	AsyncFileRoundTrip( false );
+}
+
+TEST(PlatformAsyncFile, ManyFilesBenchmark)
+{
+	const size_t fileCount = 256;
+	const size_t fileSize = 256 * 1024;
+	const size_t requestSize = 64 * 1024;
+	const size_t requestsPerFile = fileSize / requestSize;
+
+	std::vector< uint8_t > data;
+	MakeFileData( data, fileSize, 2 );
+
+	char path[ 64 ];
+	for ( size_t i = 0; i < fileCount; ++i )
+	{
+		StringPrint( path, sizeof( path ), "PlatformAsyncFileBenchmark%u.bin", static_cast< uint32_t >( i ) );
+		File file;
+		ASSERT_TRUE( file.Open( path, FileModes::Write ) );
+		ASSERT_TRUE( file.Write( &data[ 0 ], data.size() ) );
+	}
+
+	std::vector< File > files ( fileCount );
+	std::vector< uint8_t > buffer ( fileCount * fileSize );
+	std::vector< AsyncFileRequest > requests ( fileCount * requestsPerFile );
+
+	// one file after another, a read at a time
+	SimpleTimer timer;
+	for ( size_t i = 0; i < fileCount; ++i )
+	{
+		StringPrint( path, sizeof( path ), "PlatformAsyncFileBenchmark%u.bin", static_cast< uint32_t >( i ) );
+		ASSERT_TRUE( files[ i ].Open( path, FileModes::Read, false ) );
+		for ( size_t j = 0; j < requestsPerFile; ++j )
+		{
+			ASSERT_TRUE( files[ i ].Read( &buffer[ i * fileSize + j * requestSize ], requestSize ) );
+		}
+		files[ i ].Close();
+	}
+	float64_t blockingMillis = timer.Elapsed();
+
+	// every file at once, through the native queue and the thread pool
+	float64_t queueMillis[ 2 ];
+	bool native = false;
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		MemorySet( &buffer[ 0 ], 0, buffer.size() );
+
+		AsyncFileQueue queue;
+		ASSERT_TRUE( queue.Initialize( 64, 0, pass == 0 ) );
+		if ( pass == 0 )
+		{
+			native = queue.IsNative();
+		}
+
+		timer.Reset();
+		for ( size_t i = 0; i < fileCount; ++i )
+		{
+			StringPrint( path, sizeof( path ), "PlatformAsyncFileBenchmark%u.bin", static_cast< uint32_t >( i ) );
+			ASSERT_TRUE( files[ i ].Open( path, FileModes::Read, false ) );
+			for ( size_t j = 0; j < requestsPerFile; ++j )
+			{
+				size_t index = i * requestsPerFile + j;
+				requests[ index ].SetRead( files[ i ], &buffer[ index * requestSize ], requestSize, j * requestSize );
+			}
+		}
+		queue.Submit( &requests[ 0 ], requests.size() );
+		queue.WaitAll();
+		for ( size_t i = 0; i < fileCount; ++i )
+		{
+			files[ i ].Close();
+		}
+		queueMillis[ pass ] = timer.Elapsed();
+
+		for ( size_t i = 0; i < requests.size(); ++i )
+		{
+			EXPECT_EQ( requestSize, requests[ i ].m_Transferred );
+		}
+		EXPECT_TRUE( memcmp( &buffer[ ( fileCount - 1 ) * fileSize ], &data[ 0 ], fileSize ) == 0 );
+	}
+
+	for ( size_t i = 0; i < fileCount; ++i )
+	{
+		StringPrint( path, sizeof( path ), "PlatformAsyncFileBenchmark%u.bin", static_cast< uint32_t >( i ) );
+		Helium::Delete( path );
+	}
+
+	const float64_t megabytes = fileCount * fileSize / ( 1024.0 * 1024.0 );
+	Helium::Print( "AsyncFileQueue: %" PRIuSZ " files, %.0f MB/s blocking, %.0f MB/s %s, %.0f MB/s thread pool\n",
+		fileCount, megabytes / ( blockingMillis / 1000.0 ), megabytes / ( queueMillis[ 0 ] / 1000.0 ),
+		native ? "io_uring" : "thread pool (no native queue)", megabytes / ( queueMillis[ 1 ] / 1000.0 ) );
+}
@@ -42,6 +42,9 @@ namespace Helium
 		HELIUM_PLATFORM_API Endianness GetEndianness();
 
 		inline const char* GetEndiannessString(Endianness e);
+
+		// the number of logical processors available to run threads
+		HELIUM_PLATFORM_API uint32_t GetProcessorCount();
 	}
 
 	HELIUM_PLATFORM_API void EnableCPPErrorHandling( bool enable );
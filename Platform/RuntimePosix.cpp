@@ -1,6 +1,8 @@
 #include "Precompile.h"
 #include "Runtime.h"
 
+#include <unistd.h>
+
 using namespace Helium;
 using namespace Helium::Platform;
 
@@ -9,6 +11,12 @@ Platform::Type Platform::GetType()
     return Types::Posix;
 }
 
+uint32_t Platform::GetProcessorCount()
+{
+    long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return count > 0 ? static_cast< uint32_t >( count ) : 1;
+}
+
 void Helium::EnableCPPErrorHandling( bool enable )
 {
 }
@@ -14,6 +14,13 @@ Platform::Type Platform::GetType()
     return Types::Windows;
 }
 
+uint32_t Platform::GetProcessorCount()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return info.dwNumberOfProcessors > 0 ? static_cast< uint32_t >( info.dwNumberOfProcessors ) : 1;
+}
+
 static int NewHandler( size_t size )
 {
     std::ostringstream str;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Platform/File.h"
+
+#if HELIUM_OS_WIN
+# include <direct.h>
+#else
+# include <unistd.h>
+#endif
+
+#include <string>
+
+//
+// Helpers shared by the tests of Platform and the libraries built on it
+//
+
+namespace Helium
+{
+	// bytes from a seeded generator, the same for every run and platform
+	inline void MakeTestBytes( void* data, size_t size, uint32_t seed )
+	{
+		uint8_t* bytes = static_cast< uint8_t* >( data );
+		for ( size_t i = 0; i < size; ++i )
+		{
+			seed = seed * 1664525 + 1013904223;
+			bytes[ i ] = static_cast< uint8_t >( seed >> 24 );
+		}
+	}
+
+	// a file of size bytes from MakeTestBytes
+	inline bool MakeTestFile( const std::string& path, size_t size, uint32_t seed = 0 )
+	{
+		std::string contents ( size, '\0' );
+		MakeTestBytes( &contents[ 0 ], size, seed );
+
+		File file;
+		return file.Open( path.c_str(), FileModes::Write ) && file.Write( contents.data(), contents.size() );
+	}
+
+	// removes an empty directory
+	inline void RemoveTestDirectory( const std::string& path )
+	{
+#if HELIUM_OS_WIN
+		_rmdir( path.c_str() );
+#else
+		rmdir( path.c_str() );
+#endif
+	}
+}
@@ -239,10 +239,19 @@ namespace Helium
 		//@}
 	};
 
+	// called with a thread's value when the thread exits, if the value isn't null (on windows, also for the threads
+	//  still holding a value when the ThreadLocalPointer is destroyed)
+#if HELIUM_OS_WIN
+# define HELIUM_THREAD_LOCAL_DESTRUCTOR __stdcall
+#else
+# define HELIUM_THREAD_LOCAL_DESTRUCTOR
+#endif
+	typedef void ( HELIUM_THREAD_LOCAL_DESTRUCTOR *ThreadLocalDestructor )( void* value );
+
 	class HELIUM_PLATFORM_API ThreadLocalPointer
 	{
 	public:
-		ThreadLocalPointer();
+		ThreadLocalPointer( ThreadLocalDestructor destructor = NULL );
 		~ThreadLocalPointer();
 
 		void* GetPointer() const;
@@ -251,6 +260,7 @@ namespace Helium
 	protected:
 #if HELIUM_OS_WIN
 		unsigned long m_Key;
+		bool m_Fiber; // fiber local storage, which has the destructor
 #else
 		pthread_key_t m_Key;
 #endif
@@ -260,6 +270,8 @@ namespace Helium
 	class ThreadLocal : public ThreadLocalPointer
 	{
 	public:
+		inline ThreadLocal( ThreadLocalDestructor destructor = NULL );
+
 		T* GetPointer() const;
 		void SetPointer(T* value);
 	};
@@ -37,6 +37,12 @@ void Helium::CallbackThread::EntryHelperWithArgs( void* param )
     delete args;
 }
 
+template< class T >
+Helium::ThreadLocal< T >::ThreadLocal( ThreadLocalDestructor destructor )
+	: ThreadLocalPointer( destructor )
+{
+}
+
 template< class T >
 T* Helium::ThreadLocal< T >::GetPointer() const
 {
@@ -237,9 +237,9 @@ void* Thread::ThreadCallback( void* pData )
     return 0;
 }
 
-ThreadLocalPointer::ThreadLocalPointer()
+ThreadLocalPointer::ThreadLocalPointer( ThreadLocalDestructor destructor )
 {
-    int status = pthread_key_create(&m_Key, NULL);
+    int status = pthread_key_create(&m_Key, destructor);
     HELIUM_ASSERT( status == 0 && "Could not create pthread_key");
     SetPointer(NULL);
 }
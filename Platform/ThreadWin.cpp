@@ -254,25 +254,41 @@ unsigned int __stdcall Thread::ThreadCallback( void* pData )
 	return 0;
 }
 
-ThreadLocalPointer::ThreadLocalPointer()
+ThreadLocalPointer::ThreadLocalPointer( ThreadLocalDestructor destructor )
 {
-	m_Key = TlsAlloc(); 
-	HELIUM_ASSERT(m_Key != TLS_OUT_OF_INDEXES);
+	// only fiber local storage calls back when threads exit
+	m_Fiber = destructor != NULL;
+	m_Key = m_Fiber ? FlsAlloc( destructor ) : TlsAlloc(); 
+	HELIUM_ASSERT(m_Key != ( m_Fiber ? FLS_OUT_OF_INDEXES : TLS_OUT_OF_INDEXES ));
 	SetPointer(NULL); 
 }
 
 ThreadLocalPointer::~ThreadLocalPointer()
 {
-	TlsFree(m_Key); 
+	if ( m_Fiber )
+	{
+		FlsFree(m_Key);
+	}
+	else
+	{
+		TlsFree(m_Key); 
+	}
 }
 
 void* ThreadLocalPointer::GetPointer() const
 {
-	void* value = TlsGetValue(m_Key);
+	void* value = m_Fiber ? FlsGetValue(m_Key) : TlsGetValue(m_Key);
 	return value;
 }
 
 void ThreadLocalPointer::SetPointer(void* pointer)
 {
-	TlsSetValue(m_Key, pointer); 
+	if ( m_Fiber )
+	{
+		FlsSetValue(m_Key, pointer);
+	}
+	else
+	{
+		TlsSetValue(m_Key, pointer); 
+	}
 }
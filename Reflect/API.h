@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Platform/System.h"
+#include "Platform/MemoryHeap.h"
 
 #include "Foundation/Profile.h"
 #include "Foundation/ReferenceCounting.h"
@@ -17,6 +18,16 @@
 
 #define HELIUM_REFLECT_PROFILE 0
 
+// track live reference count proxies in per-thread lists so leaks can be reported at shutdown, on along with memory
+//  tracking (define it to 1 to have the report in other builds too, it's cheap enough for production)
+#ifndef HELIUM_REFLECT_TRACK_PROXIES
+# if HELIUM_ENABLE_MEMORY_TRACKING
+#  define HELIUM_REFLECT_TRACK_PROXIES 1
+# else
+#  define HELIUM_REFLECT_TRACK_PROXIES 0
+# endif
+#endif
+
 #if HELIUM_PROFILE_INSTRUMENT_ALL || HELIUM_REFLECT_PROFILE
 #define HELIUM_REFLECT_SCOPE_TIMER( ... ) HELIUM_PROFILE_SCOPE_TIMER( __VA_ARGS__ )
 #else
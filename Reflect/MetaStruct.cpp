@@ -9,6 +9,9 @@
 #include "Reflect/MetaEnum.h"
 #include "Reflect/TranslatorDeduction.h"
 
+#include <algorithm>
+#include <vector>
+
 using namespace Helium;
 using namespace Helium::Reflect;
 
@@ -25,6 +28,7 @@ Field::Field()
 , m_KeyType( NULL )
 , m_ValueType( NULL )
 , m_Translator( NULL )
+, m_Bitwise( BitwiseKinds::None )
 {
 
 }
@@ -63,13 +67,16 @@ bool Field::ShouldSerialize( void* address, Object* object, uint32_t index ) con
 
 MetaStruct::MetaStruct()
 	: m_Base( NULL )
+	, m_Depth( 0 )
+	, m_Ancestors( new const MetaStruct*[ 1 ] )
 	, m_FirstDerived( NULL )
 	, m_NextSibling( NULL )
 	, m_Populate( NULL )
 	, m_Default( NULL )
 	, m_DefaultDelete( NULL )
+	, m_HasFieldRuns( false )
 {
-
+	m_Ancestors[ 0 ] = this;
 }
 
 MetaStruct::~MetaStruct()
@@ -78,6 +85,8 @@ MetaStruct::~MetaStruct()
 	{
 		m_DefaultDelete( m_Default );
 	}
+
+	delete[] m_Ancestors;
 }
 
 MetaStruct* MetaStruct::Create()
@@ -87,6 +96,12 @@ MetaStruct* MetaStruct::Create()
 
 void MetaStruct::Register() const
 {
+	// the registry took the layout from its schema, it was logged when the schema was saved
+	if ( m_HasFieldRuns )
+	{
+		return;
+	}
+
 	MetaType::Register();
 
 	uint32_t computedSize = 0;
@@ -102,24 +117,33 @@ void MetaStruct::Register() const
 	{
 		Log::Debug( " %d bytes of hidden fields and padding\n", m_Size - computedSize );
 	}
+
+	ComputeFieldRuns();
 }
 
 void MetaStruct::Unregister() const
 {
 	MetaType::Unregister();
+
+	// the fields may change before it registers again
+	m_HasFieldRuns = false;
 }
 
-bool MetaStruct::IsType(const MetaStruct* type) const
+void MetaStruct::SetBase( const MetaStruct* base )
 {
-	for ( const MetaStruct* base = this; base; base = base->m_Base )
-	{
-		if ( base == type )
-		{
-			return true;
-		}
-	}
+	HELIUM_ASSERT( !m_Base && base );
 
-	return false;
+	m_Base = base;
+	m_Depth = base->m_Depth + 1;
+
+	// the base's ancestors never change once it exists, so copy them and add ourself at the end
+	delete[] m_Ancestors;
+	m_Ancestors = new const MetaStruct*[ m_Depth + 1 ];
+	MemoryCopy( m_Ancestors, base->m_Ancestors, m_Depth * sizeof( const MetaStruct* ) );
+	m_Ancestors[ m_Depth ] = this;
+
+	// populate base classes' derived class list
+	base->AddDerived( this );
 }
 
 void MetaStruct::AddDerived( const MetaStruct* derived ) const
@@ -153,6 +177,59 @@ void MetaStruct::RemoveDerived( const MetaStruct* derived ) const
 	derived->m_NextSibling = NULL;
 }
 
+static bool EqualsField( const Field* field, void* compositeA, Object* objectA, void* compositeB, Object* objectB )
+{
+	for ( uint32_t i=0; i<field->m_Count; ++i )
+	{
+		Pointer a ( field, compositeA, objectA, i );
+		Pointer b ( field, compositeB, objectB, i );
+		bool equality = field->m_Translator->Equals( a, b );
+		if ( !equality )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template< class T >
+static bool EqualsValues( const void* a, const void* b, uint32_t size )
+{
+	// compare by value, not by bits, and without an early out so this vectorizes
+	const T* valuesA = static_cast< const T* >( a );
+	const T* valuesB = static_cast< const T* >( b );
+	bool equality = true;
+	for ( uint32_t i=0, count=size/sizeof(T); i<count; ++i )
+	{
+		equality &= valuesA[ i ] == valuesB[ i ];
+	}
+
+	return equality;
+}
+
+static bool EqualsRun( const FieldRun& run, void* compositeA, void* compositeB )
+{
+	const void* a = static_cast< uint8_t* >( compositeA ) + run.m_Offset;
+	const void* b = static_cast< uint8_t* >( compositeB ) + run.m_Offset;
+
+	switch ( run.m_Kind )
+	{
+	case BitwiseKinds::Bytes:
+		return MemoryCompare( a, b, run.m_Size ) == 0;
+
+	case BitwiseKinds::Float32:
+		return EqualsValues< float32_t >( a, b, run.m_Size );
+
+	case BitwiseKinds::Float64:
+		return EqualsValues< float64_t >( a, b, run.m_Size );
+
+	default:
+		HELIUM_ASSERT( false );
+		return false;
+	}
+}
+
 bool MetaStruct::Equals(void* compositeA, Object* objectA, void* compositeB, Object* objectB) const
 {
 	if (compositeA == compositeB)
@@ -165,23 +242,42 @@ bool MetaStruct::Equals(void* compositeA, Object* objectA, void* compositeB, Obj
 		return false;
 	}
 
+	if ( m_HasFieldRuns )
+	{
+		// bitwise runs first, they are cheap and most likely to differ
+		DynamicArray< FieldRun >::ConstIterator runItr = m_EqualsRuns.Begin();
+		DynamicArray< FieldRun >::ConstIterator runEnd = m_EqualsRuns.End();
+		for ( ; runItr != runEnd; ++runItr )
+		{
+			if ( !EqualsRun( *runItr, compositeA, compositeB ) )
+			{
+				return false;
+			}
+		}
+
+		DynamicArray< const Field* >::ConstIterator fieldItr = m_TranslatedFields.Begin();
+		DynamicArray< const Field* >::ConstIterator fieldEnd = m_TranslatedFields.End();
+		for ( ; fieldItr != fieldEnd; ++fieldItr )
+		{
+			if ( !EqualsField( *fieldItr, compositeA, objectA, compositeB, objectB ) )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// not registered yet, so go field by field
 	for ( const MetaStruct* current = this; current != NULL; current = current->m_Base )
 	{
 		DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin();
 		DynamicArray< Field >::ConstIterator end = current->m_Fields.End();
 		for ( ; itr != end; ++itr )
 		{
-			const Field* field = &*itr;
-
-			for ( uint32_t i=0; i<field->m_Count; ++i )
+			if ( !EqualsField( &*itr, compositeA, objectA, compositeB, objectB ) )
 			{
-				Pointer a ( field, compositeA, objectA, i );
-				Pointer b ( field, compositeB, objectB, i );
-				bool equality = field->m_Translator->Equals( a, b );
-				if ( !equality )
-				{
-					return false;
-				}
+				return false;
 			}
 		}
 	}
@@ -189,33 +285,119 @@ bool MetaStruct::Equals(void* compositeA, Object* objectA, void* compositeB, Obj
 	return true;
 }
 
+static void CopyField( const Field* field, void* compositeSource, Object* objectSource, void* compositeDestination, Object* objectDestination, bool shallowCopy )
+{
+	for ( uint32_t i=0; i<field->m_Count; ++i )
+	{
+		Pointer pointerSource ( field, compositeSource, objectSource, i );
+		Pointer pointerDestination ( field, compositeDestination, objectDestination, i );
+
+		// for normal data types, run overloaded assignement operator via data's vtable
+		// for reference container types, this deep copies containers (which is bad for 
+		//  non-cloneable (FieldFlags::Share) reference containers)
+		field->m_Translator->Copy(pointerSource, pointerDestination, shallowCopy || (field->m_Flags & FieldFlags::Share) ? CopyFlags::Shallow : 0);
+	}
+}
+
 void MetaStruct::Copy( void* compositeSource, Object* objectSource, void* compositeDestination, Object* objectDestination, bool shallowCopy ) const
 {
 	if ( compositeSource != compositeDestination )
 	{
+		if ( m_HasFieldRuns )
+		{
+			DynamicArray< FieldRun >::ConstIterator runItr = m_CopyRuns.Begin();
+			DynamicArray< FieldRun >::ConstIterator runEnd = m_CopyRuns.End();
+			for ( ; runItr != runEnd; ++runItr )
+			{
+				MemoryCopy( static_cast< uint8_t* >( compositeDestination ) + runItr->m_Offset, static_cast< uint8_t* >( compositeSource ) + runItr->m_Offset, runItr->m_Size );
+			}
+
+			DynamicArray< const Field* >::ConstIterator fieldItr = m_TranslatedFields.Begin();
+			DynamicArray< const Field* >::ConstIterator fieldEnd = m_TranslatedFields.End();
+			for ( ; fieldItr != fieldEnd; ++fieldItr )
+			{
+				CopyField( *fieldItr, compositeSource, objectSource, compositeDestination, objectDestination, shallowCopy );
+			}
+
+			return;
+		}
+
+		// not registered yet, so go field by field
 		for ( const MetaStruct* current = this; current != NULL; current = current->m_Base )
 		{
 			DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin();
 			DynamicArray< Field >::ConstIterator end = current->m_Fields.End();
 			for ( ; itr != end; ++itr )
 			{
-				const Field* field = &*itr;
-
-				for ( uint32_t i=0; i<field->m_Count; ++i )
-				{
-					Pointer pointerSource ( field, compositeSource, objectSource, i );
-					Pointer pointerDestination ( field, compositeDestination, objectDestination, i );
-
-					// for normal data types, run overloaded assignement operator via data's vtable
-					// for reference container types, this deep copies containers (which is bad for 
-					//  non-cloneable (FieldFlags::Share) reference containers)
-					field->m_Translator->Copy(pointerSource, pointerDestination, shallowCopy || (field->m_Flags & FieldFlags::Share) ? CopyFlags::Shallow : 0);
-				}
+				CopyField( &*itr, compositeSource, objectSource, compositeDestination, objectDestination, shallowCopy );
 			}
 		}
 	}
 }
 
+static bool CompareFieldOffsets( const Field* lhs, const Field* rhs )
+{
+	return lhs->m_Offset < rhs->m_Offset;
+}
+
+static void AppendFieldRun( DynamicArray< FieldRun >& runs, const Field* field, BitwiseKind kind )
+{
+	// merge with the previous run if we directly follow it (no padding in between) and are of the same kind
+	if ( runs.GetSize() )
+	{
+		FieldRun& last = runs.GetLast();
+		if ( last.m_Offset + last.m_Size == field->m_Offset && last.m_Kind == kind )
+		{
+			last.m_Size += field->m_Size;
+			return;
+		}
+	}
+
+	FieldRun run;
+	run.m_Offset = field->m_Offset;
+	run.m_Size = field->m_Size;
+	run.m_Kind = kind;
+	runs.Add( run );
+}
+
+void MetaStruct::ComputeFieldRuns() const
+{
+	std::vector< const Field* > fields;
+	for ( const MetaStruct* current = this; current != NULL; current = current->m_Base )
+	{
+		DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin();
+		DynamicArray< Field >::ConstIterator end = current->m_Fields.End();
+		for ( ; itr != end; ++itr )
+		{
+			fields.push_back( &*itr );
+		}
+	}
+
+	// runs can only span fields that are adjacent in memory, so walk them in layout order
+	std::stable_sort( fields.begin(), fields.end(), &CompareFieldOffsets );
+
+	m_CopyRuns.Clear();
+	m_EqualsRuns.Clear();
+	m_TranslatedFields.Clear();
+
+	for ( std::vector< const Field* >::const_iterator itr = fields.begin(), end = fields.end(); itr != end; ++itr )
+	{
+		const Field* field = *itr;
+		if ( field->m_Bitwise == BitwiseKinds::None )
+		{
+			m_TranslatedFields.Add( field );
+		}
+		else
+		{
+			// everything bitwise copies the same way, so copy runs ignore the kind
+			AppendFieldRun( m_CopyRuns, field, BitwiseKinds::Bytes );
+			AppendFieldRun( m_EqualsRuns, field, field->m_Bitwise );
+		}
+	}
+
+	m_HasFieldRuns = true;
+}
+
 const Field* MetaStruct::FindFieldByName(uint32_t crc) const
 {
 	for ( const MetaStruct* current = this; current != NULL; current = current->m_Base )
@@ -238,7 +420,7 @@ const Field* MetaStruct::FindFieldByIndex(uint32_t index) const
 {
 	for ( const MetaStruct* current = this; current != NULL; current = current->m_Base )
 	{
-		if ( current->m_Fields.GetSize() && index >= current->m_Fields.GetFirst().m_Index && index <= current->m_Fields.GetFirst().m_Index )
+		if ( current->m_Fields.GetSize() && index >= current->m_Fields.GetFirst().m_Index && index <= current->m_Fields.GetLast().m_Index )
 		{
 			return &current->m_Fields[ index - current->m_Fields.GetFirst().m_Index ];
 		}
@@ -252,16 +434,14 @@ const Field* MetaStruct::FindFieldByOffset(uint32_t offset) const
 	// TODO: Implement binary search
 	for ( const MetaStruct* current = this; current != NULL; current = current->m_Base )
 	{
-		if ( current->m_Fields.GetSize() && offset >= current->m_Fields.GetFirst().m_Offset && offset <= current->m_Fields.GetFirst().m_Offset )
+		// fields are kept in the order they were added, which need not be the order of their offsets
+		DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin();
+		DynamicArray< Field >::ConstIterator end = current->m_Fields.End();
+		for ( ; itr != end; ++itr )
 		{
-			DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin();
-			DynamicArray< Field >::ConstIterator end = current->m_Fields.End();
-			for ( ; itr != end; ++itr )
+			if ( itr->m_Offset == offset )
 			{
-				if ( itr->m_Offset == offset )
-				{
-					return &*itr;
-				}
+				return &*itr;
 			}
 		}
 	}
@@ -275,9 +455,9 @@ uint32_t MetaStruct::GetBaseFieldCount() const
 
 	for ( const MetaStruct* base = m_Base; base; base = base->m_Base )
 	{
-		if ( m_Base->m_Fields.GetSize() )
+		if ( base->m_Fields.GetSize() )
 		{
-			count = m_Base->m_Fields.GetLast().m_Index + 1;
+			count = base->m_Fields.GetLast().m_Index + 1;
 			break;
 		}
 	}
@@ -285,6 +465,16 @@ uint32_t MetaStruct::GetBaseFieldCount() const
 	return count;
 }
 
+uint32_t MetaStruct::GetFlattenedFieldCount() const
+{
+	if ( m_Fields.GetSize() )
+	{
+		return m_Fields.GetLast().m_Index + 1;
+	}
+
+	return GetBaseFieldCount();
+}
+
 Reflect::Field* MetaStruct::AllocateField()
 {
 	Field field;
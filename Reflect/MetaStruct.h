@@ -31,6 +31,30 @@ namespace Helium
 			};
 		}
 
+		//
+		// How a field can be copied and compared without going through its translator
+		//
+
+		namespace BitwiseKinds
+		{
+			enum BitwiseKind
+			{
+				None,       // needs its translator
+				Bytes,      // integers and enums, copied with memcpy and compared with memcmp
+				Float32,    // copied with memcpy, but compared by value (so 0 == -0 and NaN != NaN)
+				Float64,
+			};
+		}
+		typedef BitwiseKinds::BitwiseKind BitwiseKind;
+
+		// a contiguous range of bitwise fields of the same kind, so they are copied or compared at once
+		struct FieldRun
+		{
+			uint32_t    m_Offset;
+			uint32_t    m_Size;
+			BitwiseKind m_Kind;
+		};
+
 		//
 		// Field (member data of a composite)
 		//
@@ -57,6 +81,7 @@ namespace Helium
 			const MetaType*        m_KeyType;    // the key type, if any, of the internal data
 			const MetaType*        m_ValueType;  // the value type, if any, of the internal data
 			SmartPtr< Translator > m_Translator; // interface to the data
+			BitwiseKind            m_Bitwise;    // how to copy and compare the data without the translator
 		};
 
 		//
@@ -116,8 +141,9 @@ namespace Helium
 			virtual void Register() const override;
 			virtual void Unregister() const override;
 
-			// inheritance hierarchy
-			bool IsType(const MetaStruct* type) const;
+			// inheritance hierarchy, IsType is constant time (it checks our ancestor at the depth of the given type)
+			inline bool IsType(const MetaStruct* type) const;
+			void SetBase( const MetaStruct* base );
 			void AddDerived( const MetaStruct* derived ) const;
 			void RemoveDerived( const MetaStruct* derived ) const;
 
@@ -127,6 +153,9 @@ namespace Helium
 			// copies data from one instance to another by finding a common base class and cloning all of the fields from the source object into the destination object.
 			void Copy( void* compositeSource, Object* objectSource, void* compositeDestination, Object* objectDestination, bool shallowCopy = false ) const;
 
+			// gather our fields and our bases' into runs of bitwise data plus the fields that need translators, done at registration
+			void ComputeFieldRuns() const;
+
 			// find a field in this composite
 			const Field* FindFieldByName(uint32_t crc) const;
 			const Field* FindFieldByIndex(uint32_t index) const;
@@ -139,6 +168,9 @@ namespace Helium
 			// computes the number of fields in all our base classes (the base index for our fields)
 			uint32_t GetBaseFieldCount() const;
 
+			// computes the number of fields in this type and all its bases (one past the highest field index)
+			uint32_t GetFlattenedFieldCount() const;
+
 			// concrete field population functions, called from template functions below with deducted data
 			Reflect::Field* AllocateField();
 			Reflect::Method* AllocateMethod();
@@ -171,6 +203,10 @@ namespace Helium
 			template < class T >
 			static inline const MetaType* DeduceValueType( std::true_type  /*is_array*/  );
 
+			// deduce how the data can be copied and compared without its translator
+			template < class T >
+			static inline BitwiseKind DeduceBitwiseKind();
+
 			// create translator object
 			template < class T >
 			static inline Translator* AllocateTranslator( std::false_type /*is_array*/ );
@@ -187,6 +223,8 @@ namespace Helium
 
 		public:
 			const MetaStruct*         m_Base;         // the base type name
+			uint32_t                  m_Depth;        // the number of base types above us
+			const MetaStruct**        m_Ancestors;    // our base types indexed by depth, from the root down to us at m_Depth
 			mutable const MetaStruct* m_FirstDerived; // head of the derived linked list, mutable since its populated by other objects
 			mutable const MetaStruct* m_NextSibling;  // next in the derived linked list, mutable since its populated by other objects
 			DynamicArray< Field >     m_Fields;       // fields in this composite
@@ -194,6 +232,11 @@ namespace Helium
 			PopulateMetaTypeFunc      m_Populate;     // function to populate this structure
 			void*                     m_Default;      // default instance
 			DefaultDeleteFunc         m_DefaultDelete;// function to use to delete the default instance
+
+			mutable bool                           m_HasFieldRuns;     // set once ComputeFieldRuns has run
+			mutable DynamicArray< FieldRun >       m_CopyRuns;         // bitwise fields to memcpy, merged regardless of kind
+			mutable DynamicArray< FieldRun >       m_EqualsRuns;       // bitwise fields to compare, merged by kind
+			mutable DynamicArray< const Field* >   m_TranslatedFields; // fields that go through their translator
 		};
 
 		template< class ClassT, class BaseT >
@@ -36,13 +36,16 @@ void Helium::Reflect::MetaStruct::Create( const char* name, const char* baseName
 	// lookup base class
 	if ( baseName )
 	{
-		info->m_Base = Reflect::Registry::GetInstance()->GetMetaStruct( baseName );
+		const MetaStruct* base = Reflect::Registry::GetInstance()->GetMetaStruct( baseName );
 
 		// if you hit this break your base class is not registered yet!
-		HELIUM_ASSERT( info->m_Base );
+		HELIUM_ASSERT( base );
 
-		// populate base classes' derived class list (unregister will remove it)
-		info->m_Base->AddDerived( info );
+		// compute our place in the hierarchy
+		if ( base )
+		{
+			info->SetBase( base );
+		}
 	}
 
 	// c++ can give us the address of base class static functions,
@@ -79,6 +82,11 @@ void Helium::Reflect::MetaStruct::Create( const char* name, const char* baseName
 	}
 }
 
+bool Helium::Reflect::MetaStruct::IsType(const MetaStruct* type) const
+{
+	return type && type->m_Depth <= m_Depth && m_Ancestors[ type->m_Depth ] == type;
+}
+
 template< class StructureT, typename FieldT >
 const Helium::Reflect::Field* Helium::Reflect::MetaStruct::FindField( FieldT StructureT::* pointerToMember ) const
 {
@@ -134,6 +142,18 @@ const Helium::Reflect::MetaType* Helium::Reflect::MetaStruct::DeduceValueType( s
 	return Reflect::DeduceValueType< typename std::remove_extent< T >::type >();
 }
 
+template < class T >
+Helium::Reflect::BitwiseKind Helium::Reflect::MetaStruct::DeduceBitwiseKind()
+{
+	typedef typename std::remove_all_extents< T >::type ElementT;
+
+	// structures recurse into their own runs (only their reflected fields are copied), everything else needs its translator
+	return std::is_same< ElementT, float32_t >::value ? BitwiseKinds::Float32
+		: std::is_same< ElementT, float64_t >::value ? BitwiseKinds::Float64
+		: ( std::is_integral< ElementT >::value || std::is_enum< ElementT >::value ) ? BitwiseKinds::Bytes
+		: BitwiseKinds::None;
+}
+
 template < class T >
 Helium::Reflect::Translator* Helium::Reflect::MetaStruct::AllocateTranslator( std::false_type /* is_array */ )
 {
@@ -160,6 +180,7 @@ Helium::Reflect::Field* Helium::Reflect::MetaStruct::AddField( FieldT StructureT
 	f->m_ValueType = DeduceValueType<FieldT>( std::is_array< FieldT >() );
 	f->m_Translator = translator ? translator : AllocateTranslator<FieldT>( std::is_array< FieldT >() );
 	f->m_Flags = f->m_Translator->GetDefaultFlags() | flags;
+	f->m_Bitwise = translator ? BitwiseKinds::None : DeduceBitwiseKind<FieldT>();
 	return f;
 }
 
@@ -0,0 +1,195 @@
+#include "Precompile.h"
+#include "Reflect/MetaStruct.h"
+#include "Reflect/Registry.h"
+#include "Reflect/TranslatorDeduction.h"
+
+#include "Platform/Console.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+using namespace Helium;
+using namespace Helium::Reflect;
+
+// the linear walk IsType used to do, for reference
+static bool WalkIsType( const MetaStruct* derived, const MetaStruct* type )
+{
+	for ( const MetaStruct* base = derived; base; base = base->m_Base )
+	{
+		if ( base == type )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// a chain of depth types, with a sibling branching off at each level
+struct TestHierarchy
+{
+	static const uint32_t Depth = 16;
+
+	SmartPtr< MetaStruct > m_Chain[ Depth ];
+	SmartPtr< MetaStruct > m_Siblings[ Depth ];
+
+	TestHierarchy()
+	{
+		for ( uint32_t i = 0; i < Depth; ++i )
+		{
+			m_Chain[ i ] = MetaStruct::Create();
+			m_Siblings[ i ] = MetaStruct::Create();
+			if ( i > 0 )
+			{
+				m_Chain[ i ]->SetBase( m_Chain[ i - 1 ] );
+				m_Siblings[ i ]->SetBase( m_Chain[ i - 1 ] );
+			}
+		}
+	}
+};
+
+// fields added out of the order of their offsets, under a base with none of its own
+struct FieldLookupBase : Struct
+{
+	uint32_t  m_A;
+	float32_t m_B;
+	uint16_t  m_C;
+
+	HELIUM_DECLARE_BASE_STRUCT( FieldLookupBase );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+struct FieldLookupMiddle : FieldLookupBase
+{
+	uint32_t m_Unreflected;
+
+	HELIUM_DECLARE_DERIVED_STRUCT( FieldLookupMiddle, FieldLookupBase );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+struct FieldLookupDerived : FieldLookupMiddle
+{
+	float64_t m_D;
+	uint8_t   m_E;
+
+	HELIUM_DECLARE_DERIVED_STRUCT( FieldLookupDerived, FieldLookupMiddle );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+HELIUM_DEFINE_BASE_STRUCT( FieldLookupBase );
+HELIUM_DEFINE_DERIVED_STRUCT( FieldLookupMiddle );
+HELIUM_DEFINE_DERIVED_STRUCT( FieldLookupDerived );
+
+void FieldLookupBase::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &FieldLookupBase::m_C, "C" );
+	comp.AddField( &FieldLookupBase::m_A, "A" );
+	comp.AddField( &FieldLookupBase::m_B, "B" );
+}
+
+void FieldLookupMiddle::PopulateMetaType( MetaStruct& /*comp*/ )
+{
+}
+
+void FieldLookupDerived::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &FieldLookupDerived::m_E, "E" );
+	comp.AddField( &FieldLookupDerived::m_D, "D" );
+}
+
+TEST(ReflectMetaStruct, FindFieldByIndexAndOffset)
+{
+	Reflect::Startup();
+
+	const MetaStruct* base = GetMetaStruct< FieldLookupBase >();
+	const MetaStruct* middle = GetMetaStruct< FieldLookupMiddle >();
+	const MetaStruct* derived = GetMetaStruct< FieldLookupDerived >();
+
+	// the derived fields are numbered after the base's, past the base without any
+	EXPECT_EQ( 0u, base->GetBaseFieldCount() );
+	EXPECT_EQ( 3u, middle->GetBaseFieldCount() );
+	EXPECT_EQ( 3u, derived->GetBaseFieldCount() );
+	EXPECT_EQ( 3u, middle->GetFlattenedFieldCount() );
+	EXPECT_EQ( 5u, derived->GetFlattenedFieldCount() );
+
+	const char* names[] = { "C", "A", "B", "E", "D" };
+	for ( uint32_t i = 0; i < HELIUM_ARRAY_COUNT( names ); ++i )
+	{
+		const Field* field = derived->FindFieldByIndex( i );
+		ASSERT_TRUE( field != NULL );
+		EXPECT_EQ( i, field->m_Index );
+		EXPECT_STREQ( names[ i ], field->m_Name );
+
+		// every field, not only the first of each type
+		EXPECT_EQ( field, derived->FindFieldByOffset( field->m_Offset ) );
+		EXPECT_EQ( field, derived->FindFieldByName( Crc32( field->m_Name ) ) );
+	}
+	EXPECT_TRUE( derived->FindFieldByIndex( 5 ) == NULL );
+	EXPECT_TRUE( middle->FindFieldByIndex( 3 ) == NULL );
+	EXPECT_TRUE( derived->FindFieldByOffset( MetaStruct::GetOffset( &FieldLookupMiddle::m_Unreflected ) ) == NULL );
+
+	Reflect::Shutdown();
+}
+
+TEST(ReflectMetaStruct, IsTypeMatchesBaseChain)
+{
+	TestHierarchy hierarchy;
+
+	std::vector< const MetaStruct* > types;
+	for ( uint32_t i = 0; i < TestHierarchy::Depth; ++i )
+	{
+		types.push_back( hierarchy.m_Chain[ i ] );
+		types.push_back( hierarchy.m_Siblings[ i ] );
+	}
+
+	for ( size_t i = 0; i < types.size(); ++i )
+	{
+		for ( size_t j = 0; j < types.size(); ++j )
+		{
+			EXPECT_EQ( WalkIsType( types[ i ], types[ j ] ), types[ i ]->IsType( types[ j ] ) );
+		}
+
+		EXPECT_FALSE( types[ i ]->IsType( NULL ) );
+	}
+
+	// types created later (eg. after something else unregistered) slot in without disturbing the others
+	{
+		SmartPtr< MetaStruct > late = MetaStruct::Create();
+		late->SetBase( hierarchy.m_Siblings[ 3 ] );
+		EXPECT_TRUE( late->IsType( hierarchy.m_Chain[ 2 ] ) );
+		EXPECT_TRUE( late->IsType( hierarchy.m_Siblings[ 3 ] ) );
+		EXPECT_FALSE( late->IsType( hierarchy.m_Chain[ 3 ] ) );
+		EXPECT_FALSE( hierarchy.m_Siblings[ 3 ]->IsType( late ) );
+	}
+
+	EXPECT_TRUE( hierarchy.m_Chain[ TestHierarchy::Depth - 1 ]->IsType( hierarchy.m_Chain[ 0 ] ) );
+}
+
+TEST(ReflectMetaStruct, IsTypeBenchmark)
+{
+	const uint32_t queryCount = 10000000;
+	TestHierarchy hierarchy;
+
+	const MetaStruct* deepest = hierarchy.m_Chain[ TestHierarchy::Depth - 1 ];
+	const MetaStruct* queries[ 4 ] = { hierarchy.m_Chain[ 0 ], hierarchy.m_Chain[ TestHierarchy::Depth / 2 ], hierarchy.m_Siblings[ 1 ], deepest };
+
+	uint32_t hits = 0;
+	SimpleTimer timer;
+	for ( uint32_t i = 0; i < queryCount; ++i )
+	{
+		hits += WalkIsType( deepest, queries[ i & 3 ] ) ? 1 : 0;
+	}
+	float64_t walkMillis = timer.Elapsed();
+
+	timer.Reset();
+	for ( uint32_t i = 0; i < queryCount; ++i )
+	{
+		hits += deepest->IsType( queries[ i & 3 ] ) ? 1 : 0;
+	}
+	float64_t displayMillis = timer.Elapsed();
+
+	EXPECT_EQ( queryCount / 2 * 3, hits );
+
+	Helium::Print( "MetaStruct::IsType (depth %u): base chain walk %.2f ns/query, ancestor display %.2f ns/query\n",
+		TestHierarchy::Depth, walkMillis * 1000000.0 / queryCount, displayMillis * 1000000.0 / queryCount );
+}
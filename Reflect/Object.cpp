@@ -1,6 +1,8 @@
 #include "Precompile.h"
 #include "Reflect/Object.h"
 
+#include "Platform/Thread.h"
+
 #include "Foundation/Log.h"
 #include "Foundation/ObjectPool.h"
 
@@ -12,6 +14,55 @@
 using namespace Helium;
 using namespace Helium::Reflect;
 
+/// Pool entry wrapping a reference count proxy.  The proxy must be the first member so the pointers handed out by
+/// Allocate() can be cast back to their entry.
+struct ObjectRefCountSupport::ProxyEntry
+{
+	/// Proxy handed out to the object.
+	RefCountProxy< Object > proxy;
+#if HELIUM_REFLECT_TRACK_PROXIES
+	/// Cache of the thread that allocated this proxy, whose active list holds it.
+	ProxyCache* pOwner;
+	/// Previous entry in the owner's active list.
+	ProxyEntry* pPrevious;
+	/// Next entry in the owner's active list.
+	ProxyEntry* pNext;
+#endif
+};
+
+/// Per-thread proxy cache.  Proxies are moved between the shared pool and these caches in batches so the pool locks
+/// are taken once per batch instead of once per object, and active proxies are tracked in a list owned by the
+/// allocating thread so that only enumeration has to visit every thread.  When a thread exits its free proxies go
+/// back to the pool, and the cache waits for a new thread to adopt it.
+struct ObjectRefCountSupport::ProxyCache
+{
+	/// Number of free proxies held by each thread.
+	static const size_t CAPACITY = 256;
+	/// Number of proxies moved to or from the shared pool at a time.
+	static const size_t BATCH_SIZE = CAPACITY / 2;
+
+	/// Next cache in StaticTranslator::pCaches, caches are kept until Shutdown().
+	ProxyCache* pNext;
+	/// Non-zero while a thread is using this cache.
+	volatile int32_t owned;
+
+	/// Free proxies, only touched by the owning thread.
+	ProxyEntry* pFree[ CAPACITY ];
+	/// Number of free proxies.
+	size_t freeCount;
+
+#if HELIUM_REFLECT_TRACK_PROXIES
+	/// Guards the active list, only contended by releases on other threads and by enumeration.
+	SpinLock activeLock;
+	/// Head of the list of active proxies allocated by this thread.
+	ProxyEntry* pActive;
+	/// Number of proxies in the active list.
+	volatile size_t activeCount;
+	/// Active proxies merged from every cache by GetFirstActiveProxy() on the owning thread.
+	ConcurrentHashSet< RefCountProxy< Object >* >* pSnapshot;
+#endif
+};
+
 /// Static reference count proxy management data.
 struct ObjectRefCountSupport::StaticTranslator
 {
@@ -19,15 +70,23 @@ struct ObjectRefCountSupport::StaticTranslator
 	static const size_t POOL_BLOCK_SIZE = 1024 * 2048;
 
 	/// Proxy object pool.
-	ObjectPool< RefCountProxy< Object > > proxyPool;
-#if HELIUM_ENABLE_MEMORY_TRACKING
-	/// Active reference count proxies.
-	ConcurrentHashSet< RefCountProxy< Object >* > activeProxySet;
-#endif
+	ObjectPool< ProxyEntry > proxyPool;
+
+	/// Cache for the calling thread.
+	ThreadLocal< ProxyCache > cache;
+	/// All thread caches.
+	ProxyCache* volatile pCaches;
 
 	/// @name Construction/Destruction
 	//@{
 	StaticTranslator();
+	~StaticTranslator();
+	//@}
+
+	/// @name Thread Caches
+	//@{
+	ProxyCache* GetCache();
+	static void HELIUM_THREAD_LOCAL_DESTRUCTOR ReleaseCache( void* pCache );
 	//@}
 };
 
@@ -55,15 +114,33 @@ RefCountProxy< Object >* ObjectRefCountSupport::Allocate()
 		sm_pStaticTranslator = pStaticTranslator;
 	}
 
-	RefCountProxy< Object >* pProxy = pStaticTranslator->proxyPool.Allocate();
-	HELIUM_ASSERT( pProxy );
+	ProxyCache* pCache = pStaticTranslator->GetCache();
+	if( pCache->freeCount == 0 )
+	{
+		pCache->freeCount = pStaticTranslator->proxyPool.Allocate( pCache->pFree, ProxyCache::BATCH_SIZE );
+	}
+
+	HELIUM_ASSERT( pCache->freeCount != 0 );
+	ProxyEntry* pEntry = pCache->pFree[ --pCache->freeCount ];
+	HELIUM_ASSERT( pEntry );
 
-#if HELIUM_ENABLE_MEMORY_TRACKING
-	ConcurrentHashSet< RefCountProxy< Object >* >::Accessor activeProxySetAccessor;
-	HELIUM_VERIFY( pStaticTranslator->activeProxySet.Insert( activeProxySetAccessor, pProxy ) );
+#if HELIUM_REFLECT_TRACK_PROXIES
+	pEntry->pOwner = pCache;
+	pEntry->pPrevious = NULL;
+
+	{
+		ScopeLock< SpinLock > scopeLock( pCache->activeLock );
+		pEntry->pNext = pCache->pActive;
+		if( pCache->pActive )
+		{
+			pCache->pActive->pPrevious = pEntry;
+		}
+		pCache->pActive = pEntry;
+		++pCache->activeCount;
+	}
 #endif
 
-	return pProxy;
+	return &pEntry->proxy;
 }
 
 /// Release a reference count proxy back to the global pool.
@@ -78,11 +155,40 @@ void ObjectRefCountSupport::Release( RefCountProxy< Object >* pProxy )
 	StaticTranslator* pStaticTranslator = sm_pStaticTranslator;
 	HELIUM_ASSERT( pStaticTranslator );
 
-#if HELIUM_ENABLE_MEMORY_TRACKING
-	HELIUM_VERIFY( pStaticTranslator->activeProxySet.Remove( pProxy ) );
+	ProxyEntry* pEntry = reinterpret_cast< ProxyEntry* >( pProxy );
+
+#if HELIUM_REFLECT_TRACK_PROXIES
+	{
+		// the proxy may have been allocated on another thread, so unlink it from the list that owns it
+		ProxyCache* pOwner = pEntry->pOwner;
+		HELIUM_ASSERT( pOwner );
+
+		ScopeLock< SpinLock > scopeLock( pOwner->activeLock );
+		if( pEntry->pPrevious )
+		{
+			pEntry->pPrevious->pNext = pEntry->pNext;
+		}
+		else
+		{
+			HELIUM_ASSERT( pOwner->pActive == pEntry );
+			pOwner->pActive = pEntry->pNext;
+		}
+		if( pEntry->pNext )
+		{
+			pEntry->pNext->pPrevious = pEntry->pPrevious;
+		}
+		--pOwner->activeCount;
+	}
 #endif
 
-	pStaticTranslator->proxyPool.Release( pProxy );
+	ProxyCache* pCache = pStaticTranslator->GetCache();
+	if( pCache->freeCount == ProxyCache::CAPACITY )
+	{
+		pCache->freeCount -= ProxyCache::BATCH_SIZE;
+		pStaticTranslator->proxyPool.Release( pCache->pFree + pCache->freeCount, ProxyCache::BATCH_SIZE );
+	}
+
+	pCache->pFree[ pCache->freeCount++ ] = pEntry;
 }
 
 /// Release the name table and free all allocated memory.
@@ -90,15 +196,15 @@ void ObjectRefCountSupport::Release( RefCountProxy< Object >* pProxy )
 /// This should only be called immediately prior to application exit.
 void ObjectRefCountSupport::Shutdown()
 {
-#if HELIUM_ENABLE_MEMORY_TRACKING
-	ConcurrentHashSet< RefCountProxy< Reflect::Object >* >::ConstAccessor refCountProxyAccessor;
-	if( Reflect::ObjectRefCountSupport::GetFirstActiveProxy( refCountProxyAccessor ) )
+#if HELIUM_REFLECT_TRACK_PROXIES
+	if( sm_pStaticTranslator && GetActiveProxyCount() )
 	{
 		HELIUM_TRACE(
 			TraceLevels::Warning,
 			"%" PRIuSZ " reference counted object(s) still active during shutdown!\n",
 			Reflect::ObjectRefCountSupport::GetActiveProxyCount() );
-  
+
+		ConcurrentHashSet< RefCountProxy< Reflect::Object >* >::ConstAccessor refCountProxyAccessor;
 		Reflect::ObjectRefCountSupport::GetFirstActiveProxy( refCountProxyAccessor );
 		while( refCountProxyAccessor.IsValid() )
 		{
@@ -116,13 +222,15 @@ void ObjectRefCountSupport::Shutdown()
 		}
 		refCountProxyAccessor.Release();
 	}
-#endif  // HELIUM_ENABLE_MEMORY_TRACKING
+#endif  // HELIUM_REFLECT_TRACK_PROXIES
 
-	delete sm_pStaticTranslator;
+	// clear it first, the caches may be released while their thread local storage is torn down
+	StaticTranslator* pStaticTranslator = sm_pStaticTranslator;
 	sm_pStaticTranslator = NULL;
+	delete pStaticTranslator;
 }
 
-#if HELIUM_ENABLE_MEMORY_TRACKING
+#if HELIUM_REFLECT_TRACK_PROXIES
 /// Get the number of active reference count proxies.
 ///
 /// Be careful when using this function, as the number may change if other threads are actively setting and clearing
@@ -137,11 +245,21 @@ size_t ObjectRefCountSupport::GetActiveProxyCount()
 {
 	HELIUM_ASSERT( sm_pStaticTranslator );
 
-	return sm_pStaticTranslator->activeProxySet.GetSize();
+	size_t count = 0;
+	for( ProxyCache* pCache = sm_pStaticTranslator->pCaches; pCache; pCache = pCache->pNext )
+	{
+		count += pCache->activeCount;
+	}
+
+	return count;
 }
 
 /// Initialize a constant accessor to the first active reference count proxy.
 ///
+/// Active proxies are tracked per thread, so this first merges every thread's list into a single set.  The set is a
+/// snapshot belonging to the calling thread, so any number of threads can enumerate at once, but the accessor is
+/// only good until the same thread calls this again.
+///
 /// @param[in] rAccessor  Accessor to initialize.
 ///
 /// @return  True if there are active reference count proxies and the accessor was successfully set to reference the
@@ -153,24 +271,330 @@ bool ObjectRefCountSupport::GetFirstActiveProxy(
 {
 	HELIUM_ASSERT( sm_pStaticTranslator );
 
-	return sm_pStaticTranslator->activeProxySet.First( rAccessor );
+	rAccessor.Release();
+
+	ProxyCache* pOwnCache = sm_pStaticTranslator->GetCache();
+	if( !pOwnCache->pSnapshot )
+	{
+		pOwnCache->pSnapshot = new ConcurrentHashSet< RefCountProxy< Object >* >;
+	}
+
+	ConcurrentHashSet< RefCountProxy< Object >* >& activeProxySet = *pOwnCache->pSnapshot;
+	activeProxySet.Clear();
+
+	for( ProxyCache* pCache = sm_pStaticTranslator->pCaches; pCache; pCache = pCache->pNext )
+	{
+		ScopeLock< SpinLock > scopeLock( pCache->activeLock );
+		for( ProxyEntry* pEntry = pCache->pActive; pEntry; pEntry = pEntry->pNext )
+		{
+			ConcurrentHashSet< RefCountProxy< Object >* >::Accessor activeProxySetAccessor;
+			HELIUM_VERIFY( activeProxySet.Insert( activeProxySetAccessor, &pEntry->proxy ) );
+		}
+	}
+
+	return activeProxySet.First( rAccessor );
 }
 #endif
 
 /// Constructor.
 ObjectRefCountSupport::StaticTranslator::StaticTranslator()
 : proxyPool( POOL_BLOCK_SIZE )
+, cache( &ReleaseCache )
+, pCaches( NULL )
+{
+}
+
+/// Destructor.
+ObjectRefCountSupport::StaticTranslator::~StaticTranslator()
+{
+	ProxyCache* pCache = pCaches;
+	while( pCache )
+	{
+		ProxyCache* pNext = pCache->pNext;
+#if HELIUM_REFLECT_TRACK_PROXIES
+		delete pCache->pSnapshot;
+#endif
+		delete pCache;
+		pCache = pNext;
+	}
+}
+
+/// Get the proxy cache for the calling thread, adopting one left by an exited thread or creating one on first use.
+///
+/// @return  Proxy cache for the calling thread.
+ObjectRefCountSupport::ProxyCache* ObjectRefCountSupport::StaticTranslator::GetCache()
+{
+	ProxyCache* pCache = cache.GetPointer();
+	if( !pCache )
+	{
+		// caches are never unlinked, so the list can be walked without a lock
+		for( pCache = pCaches; pCache; pCache = pCache->pNext )
+		{
+			if( !pCache->owned && AtomicCompareExchange( pCache->owned, 1, 0 ) == 0 )
+			{
+				break;
+			}
+		}
+
+		if( !pCache )
+		{
+			pCache = new ProxyCache;
+			pCache->owned = 1;
+			pCache->freeCount = 0;
+#if HELIUM_REFLECT_TRACK_PROXIES
+			pCache->pActive = NULL;
+			pCache->activeCount = 0;
+			pCache->pSnapshot = NULL;
+#endif
+
+			// publish to enumeration
+			ProxyCache* pHead;
+			do
+			{
+				pHead = pCaches;
+				pCache->pNext = pHead;
+			}
+			while( AtomicCompareExchange( pCaches, pCache, pHead ) != pHead );
+		}
+
+		cache.SetPointer( pCache );
+	}
+
+	return pCache;
+}
+
+/// Return the free proxies of an exiting thread's cache to the pool, and leave the cache for another thread.  Its
+/// active list stays, since the proxies in it are released through the cache that allocated them.
+///
+/// @param[in] pCache  Cache of the exiting thread.
+void HELIUM_THREAD_LOCAL_DESTRUCTOR ObjectRefCountSupport::StaticTranslator::ReleaseCache( void* pCache )
+{
+	StaticTranslator* pStaticTranslator = sm_pStaticTranslator;
+	if( !pStaticTranslator )
+	{
+		return; // shut down, the caches are gone
+	}
+
+	ProxyCache* pThreadCache = static_cast< ProxyCache* >( pCache );
+	if( pThreadCache->freeCount )
+	{
+		pStaticTranslator->proxyPool.Release( pThreadCache->pFree, pThreadCache->freeCount );
+		pThreadCache->freeCount = 0;
+	}
+
+	AtomicExchange( pThreadCache->owned, 0 );
+}
+
+//
+// Changes recorded by the open ChangeBatch on a thread, in the order they were first raised.  Each object keeps the
+//  index of its latest change, and its changes are chained back from there through m_Previous, so recording never
+//  has to search for the object.  Dropped changes (absorbed by a null field, delivered, or of a deleted object) keep
+//  their place with a null object.  Objects also keep the serial of the batch holding their changes until the
+//  last of them is delivered, so deleting or batching them on another thread meanwhile can be caught.
+//
+
+class Helium::Reflect::ChangeBatchState
+{
+public:
+	static const uint32_t Invalid = ~static_cast< uint32_t >( 0 );
+
+	uint32_t m_Depth;
+	uint32_t m_Serial;
+	bool     m_Delivering;
+
+	ChangeBatchState()
+		: m_Depth( 0 )
+		, m_Serial( 0 )
+		, m_Delivering( false )
+	{
+		while ( !m_Serial )
+		{
+			m_Serial = static_cast< uint32_t >( AtomicIncrement( sm_NextSerial ) );
+		}
+	}
+
+	void Record( const Object* object, const Field* field )
+	{
+		HELIUM_ASSERT_MSG( !object->m_BatchSerial || object->m_BatchSerial == m_Serial, "Object has changes pending in a batch on another thread" );
+
+		uint32_t last = FindLast( object );
+		for ( uint32_t i = last; i != Invalid; i = m_Changes[ i ].m_Previous )
+		{
+			PendingChange& change = m_Changes[ i ];
+			if ( change.m_Object )
+			{
+				if ( change.m_Field == field || !change.m_Field )
+				{
+					return;
+				}
+
+				if ( !field )
+				{
+					change.m_Object = NULL;
+				}
+			}
+		}
+
+		HELIUM_ASSERT( m_Changes.GetSize() < Invalid );
+		PendingChange change = { object, object, field, last };
+		object->m_BatchedChange = static_cast< uint32_t >( m_Changes.GetSize() );
+		object->m_BatchSerial = m_Serial;
+		m_Changes.Add( change );
+	}
+
+	void Forget( const Object* object )
+	{
+		for ( uint32_t i = FindLast( object ); i != Invalid; i = m_Changes[ i ].m_Previous )
+		{
+			m_Changes[ i ].m_Object = NULL;
+		}
+	}
+
+	// listeners may change objects again, which is raised right away, or open a batch of their own, whose
+	//  changes are appended and delivered by a following round
+	void Deliver()
+	{
+		m_Delivering = true;
+
+		DynamicArray< ObjectChangeArgs > round;
+		for ( size_t start = 0; start < m_Changes.GetSize(); )
+		{
+			size_t end = m_Changes.GetSize();
+
+			if ( ChangeBatch::e_Delivered.Valid() )
+			{
+				round.Clear();
+				for ( size_t i = start; i < end; ++i )
+				{
+					if ( m_Changes[ i ].m_Object )
+					{
+						round.Add( ObjectChangeArgs( m_Changes[ i ].m_Object, m_Changes[ i ].m_Field ) );
+					}
+				}
+
+				if ( !round.IsEmpty() )
+				{
+					ChangeBatch::e_Delivered.Raise( ObjectChangeBatchArgs( round.GetData(), round.GetSize() ) );
+				}
+			}
+
+			for ( size_t i = start; i < end; ++i )
+			{
+				// objects deleted by a listener are dropped as we go
+				const Object* object = m_Changes[ i ].m_Object;
+				if ( object )
+				{
+					m_Changes[ i ].m_Object = NULL;
+					if ( object->m_BatchedChange == i )
+					{
+						object->m_BatchSerial = 0;
+					}
+					object->e_Changed.Raise( ObjectChangeArgs( object, m_Changes[ i ].m_Field ) );
+				}
+			}
+
+			start = end;
+		}
+
+		m_Delivering = false;
+	}
+
+private:
+	struct PendingChange
+	{
+		const Object* m_Object;  // null once dropped
+		const Object* m_Owner;
+		const Field*  m_Field;
+		uint32_t      m_Previous;
+	};
+
+	// the object's index is left over from an earlier batch unless the change there is its own
+	uint32_t FindLast( const Object* object ) const
+	{
+		uint32_t last = object->m_BatchedChange;
+		return object->m_BatchSerial == m_Serial && last < m_Changes.GetSize() && m_Changes[ last ].m_Owner == object ? last : Invalid;
+	}
+
+	DynamicArray< PendingChange > m_Changes;
+
+	// serial of the last batch state made, by any thread
+	static volatile int32_t sm_NextSerial;
+};
+
+volatile int32_t ChangeBatchState::sm_NextSerial = 0;
+
+// batch state of the calling thread, if it has a batch open
+static ThreadLocal< ChangeBatchState > g_ChangeBatch;
+
+// number of threads with a batch open, so raising and deleting objects skip the thread local lookup when there are none
+static volatile int32_t g_ChangeBatchThreads = 0;
+
+static ChangeBatchState* GetOpenChangeBatch()
+{
+	return g_ChangeBatchThreads ? g_ChangeBatch.GetPointer() : NULL;
+}
+
+ObjectChangeBatchSignature::Event ChangeBatch::e_Delivered;
+
+ChangeBatch::ChangeBatch()
+{
+	ChangeBatchState* state = g_ChangeBatch.GetPointer();
+	if ( !state )
+	{
+		state = new ChangeBatchState;
+		g_ChangeBatch.SetPointer( state );
+		AtomicIncrementRelease( g_ChangeBatchThreads );
+	}
+
+	++state->m_Depth;
+}
+
+ChangeBatch::~ChangeBatch()
+{
+	ChangeBatchState* state = g_ChangeBatch.GetPointer();
+	HELIUM_ASSERT( state && state->m_Depth );
+
+	// a batch opened by a listener during delivery is delivered along with the outermost one
+	if ( --state->m_Depth || state->m_Delivering )
+	{
+		return;
+	}
+
+	state->Deliver();
+
+	g_ChangeBatch.SetPointer( NULL );
+	AtomicDecrementRelease( g_ChangeBatchThreads );
+	delete state;
+}
+
+bool ChangeBatch::IsOpen()
 {
+	ChangeBatchState* state = GetOpenChangeBatch();
+	return state && state->m_Depth;
 }
 
 Object::Object()
+	: m_DirtyFields( NULL )
+	, m_BatchedChange( ChangeBatchState::Invalid )
+	, m_BatchSerial( 0 )
 {
 
 }
 
 Object::~Object()
 {
+	if ( m_BatchSerial )
+	{
+		// the batch of another thread can't be reached from here, its delivery would raise on a deleted object
+		ChangeBatchState* batch = GetOpenChangeBatch();
+		HELIUM_ASSERT_MSG( batch && batch->m_Serial == m_BatchSerial, "Object with changes pending in a batch on another thread was deleted" );
+		if ( batch )
+		{
+			batch->Forget( this );
+		}
+	}
 
+	delete m_DirtyFields;
 }
 
 void* Object::operator new( size_t bytes )
@@ -331,5 +755,93 @@ ObjectPtr Object::Clone()
 
 void Object::RaiseChanged( const Field* field ) const
 {
+	if ( m_DirtyFields )
+	{
+		// fields of nested structures don't have a bit of their own, so they dirty the whole object
+		if ( field && field->m_Index < m_DirtyFields->GetSize() && GetMetaClass()->IsType( field->m_Structure ) )
+		{
+			m_DirtyFields->SetElement( field->m_Index );
+		}
+		else
+		{
+			m_DirtyFields->SetAll();
+		}
+	}
+
+	ChangeBatchState* batch = GetOpenChangeBatch();
+	if ( batch && batch->m_Depth )
+	{
+		batch->Record( this, field );
+		return;
+	}
+
 	e_Changed.Raise( ObjectChangeArgs( this, field ) );
 }
+
+void Object::SetDirtyTracking( bool enable )
+{
+	if ( enable && !m_DirtyFields )
+	{
+		m_DirtyFields = new BitArray<>;
+		m_DirtyFields->Resize( GetMetaClass()->GetFlattenedFieldCount() );
+		m_DirtyFields->SetAll();
+	}
+	else if ( !enable )
+	{
+		delete m_DirtyFields;
+		m_DirtyFields = NULL;
+	}
+}
+
+bool Object::IsDirtyTracking() const
+{
+	return m_DirtyFields != NULL;
+}
+
+bool Object::IsDirty() const
+{
+	if ( !m_DirtyFields )
+	{
+		return true;
+	}
+
+	for ( size_t i = 0; i < m_DirtyFields->GetSize(); ++i )
+	{
+		if ( m_DirtyFields->GetElement( i ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Object::IsFieldDirty( const Field* field ) const
+{
+	HELIUM_ASSERT( field );
+
+	if ( m_DirtyFields && field->m_Index < m_DirtyFields->GetSize() && GetMetaClass()->IsType( field->m_Structure ) )
+	{
+		return m_DirtyFields->GetElement( field->m_Index );
+	}
+
+	return IsDirty();
+}
+
+void Object::ClearDirtyFields()
+{
+	if ( m_DirtyFields )
+	{
+		m_DirtyFields->UnsetAll();
+	}
+}
+
+bool ObjectIdentifier::Identify( const ObjectPtr& object, uint32_t& index )
+{
+	return false;
+}
+
+bool ObjectResolver::Resolve( uint32_t index, ObjectPtr& pointer, const MetaClass* pointerClass )
+{
+	return false;
+}
@@ -5,6 +5,7 @@
 #include "Platform/Utility.h"
 
 #include "Foundation/Attribute.h"
+#include "Foundation/BitArray.h"
 #include "Foundation/ConcurrentHashSet.h"
 #include "Foundation/Event.h"
 #include "Foundation/FilePath.h"
@@ -49,7 +50,7 @@ namespace Helium
 			static void Shutdown();
 			//@}
 
-#if HELIUM_ENABLE_MEMORY_TRACKING
+#if HELIUM_REFLECT_TRACK_PROXIES
 			/// @name Active Proxy Iteration
 			//@{
 			static size_t GetActiveProxyCount();
@@ -58,6 +59,8 @@ namespace Helium
 #endif
 
 		private:
+			struct ProxyEntry;
+			struct ProxyCache;
 			struct StaticTranslator;
 
 			/// Static proxy management data.
@@ -81,6 +84,44 @@ namespace Helium
 		};
 		typedef Helium::Signature< const ObjectChangeArgs&, Helium::AtomicRefCountBase > ObjectChangeSignature;
 
+		struct ObjectChangeBatchArgs
+		{
+			const ObjectChangeArgs* m_Changes;
+			size_t m_Count;
+
+			ObjectChangeBatchArgs( const ObjectChangeArgs* changes, size_t count )
+				: m_Changes( changes )
+				, m_Count( count )
+			{
+			}
+		};
+		typedef Helium::Signature< const ObjectChangeBatchArgs&, Helium::AtomicRefCountBase > ObjectChangeBatchSignature;
+
+		// Changes recorded by the open batches of a thread (see Object.cpp)
+		class ChangeBatchState;
+
+		//
+		// Defers change notification on the calling thread while in scope, for bulk edits.  Each object and field
+		//  is recorded once (a null field absorbs the rest of that object's changes), and when the outermost batch
+		//  closes the changes are raised all at once to e_Delivered, then once each to their object's e_Changed.
+		//  Changes to objects deleted on the batching thread before then are dropped.  An object with changes
+		//  pending in a batch must not be deleted on another thread or have changes batched by another thread
+		//  until that batch is delivered (both are asserted).
+		//
+
+		class HELIUM_REFLECT_API ChangeBatch : NonCopyable
+		{
+		public:
+			ChangeBatch();
+			~ChangeBatch();
+
+			// true if changes raised on the calling thread are being deferred
+			static bool IsOpen();
+
+			// Event raised with every change of a batch when it is delivered
+			static ObjectChangeBatchSignature::Event e_Delivered;
+		};
+
 		//
 		// Object is the abstract base class of a serializable class
 		//
@@ -149,7 +190,7 @@ namespace Helium
 			// Do comparison logic against other object, checks type and field data
 			virtual bool Equals( Object* object );
 
-			// Copy this object's data into another object isntance
+			// Copy this object's data into another object isntance (sharing the objects it references, even from structures)
 			virtual void CopyTo( Object* object );
 
 			// Copy this object's data into a new instance
@@ -172,6 +213,29 @@ namespace Helium
 			// Modify and notify a field change
 			template< class ObjectT, class FieldT >
 			void ChangeField( FieldT ObjectT::* field, const FieldT& newValue );
+
+			//
+			// Dirty tracking
+			//
+
+			// Record which fields RaiseChanged reports, off by default, enabling it marks every field dirty
+			void SetDirtyTracking( bool enable );
+			bool IsDirtyTracking() const;
+
+			// Query the fields changed since tracking was enabled or last cleared, untracked objects are always dirty
+			bool IsDirty() const;
+			bool IsFieldDirty( const Field* field ) const;
+			void ClearDirtyFields();
+
+		private:
+			friend class ChangeBatchState;
+
+			// one bit per flattened field index (Field::m_Index), NULL unless tracking
+			mutable BitArray<>* m_DirtyFields;
+
+			// latest change recorded by a ChangeBatch, and the serial of the batch holding it (0 once delivered)
+			mutable uint32_t m_BatchedChange;
+			mutable uint32_t m_BatchSerial;
 		};
 
 		//
@@ -213,6 +277,9 @@ namespace Helium
 		{
 		public:
 			virtual bool Identify( const ObjectPtr& object, Name* identity ) = 0;
+
+			// numeric identity, for identifiers that can skip formatting a name (returns false if they can't)
+			virtual bool Identify( const ObjectPtr& object, uint32_t& index );
 		};
 
 		//
@@ -224,8 +291,12 @@ namespace Helium
 		public:
 			virtual bool Resolve( const Name& identity, ObjectPtr& pointer, const MetaClass* pointerClass ) = 0;
 
-			// helper to extract the class of the pointer
+			// numeric identity, as given by ObjectIdentifier (returns false if it isn't supported)
+			virtual bool Resolve( uint32_t index, ObjectPtr& pointer, const MetaClass* pointerClass );
+
+			// helpers to extract the class of the pointer
 			template< class T > bool Resolve( const Name& identity, StrongPtr< T >& object );
+			template< class T > bool Resolve( uint32_t index, StrongPtr< T >& object );
 		};
 	}
 }
@@ -19,7 +19,7 @@ template< class ObjectT, class FieldT >
 void Helium::Reflect::Object::ChangeField( FieldT ObjectT::* pointerToMember, const FieldT& newValue )
 {
     // set the field via pointer-to-member on the deduced templated type (!)
-    this->*pointerToMember = newValue;
+    static_cast< ObjectT* >( this )->*pointerToMember = newValue;
 
     // find the field in our reflection information
     const Reflect::Field* field = GetMetaClass()->FindField( pointerToMember );
@@ -144,3 +144,10 @@ bool Helium::Reflect::ObjectResolver::Resolve( const Name& identity, StrongPtr<
 	const MetaClass* pointerClass = Reflect::GetMetaClass< T >();
 	return this->Resolve( identity, reinterpret_cast< ObjectPtr& >( object ), pointerClass );
 }
+
+template< class T >
+bool Helium::Reflect::ObjectResolver::Resolve( uint32_t index, StrongPtr< T >& object )
+{
+	const MetaClass* pointerClass = Reflect::GetMetaClass< T >();
+	return this->Resolve( index, reinterpret_cast< ObjectPtr& >( object ), pointerClass );
+}
@@ -0,0 +1,334 @@
+#include "Precompile.h"
+#include "Reflect/ObjectGraph.h"
+
+#include "Platform/Atomic.h"
+#include "Platform/Runtime.h"
+#include "Platform/Thread.h"
+
+#include "Foundation/Math.h"
+
+#include "Reflect/MetaClass.h"
+#include "Reflect/Translator.h"
+
+using namespace Helium;
+using namespace Helium::Reflect;
+
+// objects are handed out to the copy threads in batches of this many
+static const int32_t CloneBatchSize = 64;
+
+// graphs smaller than this aren't worth starting threads for
+static const uint32_t CloneParallelThreshold = 1024;
+
+ObjectIndex::ObjectIndex()
+	: m_Slots( NULL )
+	, m_Mask( 0 )
+	, m_Count( 0 )
+{
+	Allocate( 1024 );
+}
+
+ObjectIndex::~ObjectIndex()
+{
+	delete[] m_Slots;
+}
+
+void ObjectIndex::Allocate( size_t slotCount )
+{
+	m_Slots = new Slot[ slotCount ];
+	MemoryZero( m_Slots, sizeof( Slot ) * slotCount );
+	m_Mask = slotCount - 1;
+}
+
+void ObjectIndex::Grow()
+{
+	Slot* slots = m_Slots;
+	size_t slotCount = m_Mask + 1;
+
+	Allocate( slotCount * 2 );
+	for ( size_t i = 0; i < slotCount; ++i )
+	{
+		if ( slots[ i ].m_Object )
+		{
+			*Probe( slots[ i ].m_Object ) = slots[ i ];
+		}
+	}
+
+	delete[] slots;
+}
+
+//
+// Reference traversal, functors are handed each object reference (as an ObjectPtr, since every
+//  StrongPtr< T > shares its layout) and return true if they changed it
+//
+
+static bool HoldsReferences( Translator* translator )
+{
+	if ( translator->IsA( MetaIds::PointerTranslator ) || translator->IsA( MetaIds::StructureTranslator ) )
+	{
+		return true;
+	}
+
+	if ( translator->IsA( MetaIds::SequenceTranslator ) )
+	{
+		return HoldsReferences( static_cast< SequenceTranslator* >( translator )->GetItemTranslator() );
+	}
+
+	if ( translator->IsA( MetaIds::SetTranslator ) )
+	{
+		return HoldsReferences( static_cast< SetTranslator* >( translator )->GetItemTranslator() );
+	}
+
+	if ( translator->IsA( MetaIds::AssociationTranslator ) )
+	{
+		return HoldsReferences( static_cast< AssociationTranslator* >( translator )->GetValueTranslator() );
+	}
+
+	return false;
+}
+
+template< class FunctorT >
+static void VisitReferences( const MetaStruct* type, void* composite, Object* object, FunctorT& functor );
+
+template< class FunctorT >
+static void VisitReferences( Translator* translator, Pointer pointer, FunctorT& functor )
+{
+	if ( translator->IsA( MetaIds::PointerTranslator ) )
+	{
+		functor( pointer.As< ObjectPtr >() );
+	}
+	else if ( translator->IsA( MetaIds::StructureTranslator ) )
+	{
+		VisitReferences( static_cast< StructureTranslator* >( translator )->GetMetaStruct(), pointer.m_Address, pointer.m_Object, functor );
+	}
+	else if ( translator->IsA( MetaIds::SequenceTranslator ) )
+	{
+		SequenceTranslator* sequence = static_cast< SequenceTranslator* >( translator );
+		Translator* itemTranslator = sequence->GetItemTranslator();
+		if ( HoldsReferences( itemTranslator ) )
+		{
+			DynamicArray< Pointer > items;
+			sequence->GetItems( pointer, items );
+			for ( size_t i = 0; i < items.GetSize(); ++i )
+			{
+				VisitReferences( itemTranslator, items[ i ], functor );
+			}
+		}
+	}
+	else if ( translator->IsA( MetaIds::AssociationTranslator ) )
+	{
+		AssociationTranslator* association = static_cast< AssociationTranslator* >( translator );
+		Translator* valueTranslator = association->GetValueTranslator();
+		if ( HoldsReferences( valueTranslator ) )
+		{
+			DynamicArray< Pointer > keys, values;
+			association->GetItems( pointer, keys, values );
+			for ( size_t i = 0; i < values.GetSize(); ++i )
+			{
+				VisitReferences( valueTranslator, values[ i ], functor );
+			}
+		}
+	}
+	else if ( translator->IsA( MetaIds::SetTranslator ) )
+	{
+		SetTranslator* set = static_cast< SetTranslator* >( translator );
+		if ( set->GetItemTranslator()->IsA( MetaIds::PointerTranslator ) )
+		{
+			DynamicArray< Pointer > items;
+			set->GetItems( pointer, items );
+
+			bool changed = false;
+			DynamicArray< ObjectPtr > references;
+			references.Reserve( items.GetSize() );
+			for ( size_t i = 0; i < items.GetSize(); ++i )
+			{
+				ObjectPtr reference = items[ i ].As< ObjectPtr >();
+				changed |= functor( reference );
+				references.Add( reference );
+			}
+
+			// sets are ordered by address, so changed references are reinserted rather than written in place
+			if ( changed )
+			{
+				set->Clear( pointer );
+				for ( size_t i = 0; i < references.GetSize(); ++i )
+				{
+					set->InsertItem( pointer, Pointer( &references[ i ], pointer.m_Field, pointer.m_Object ) );
+				}
+			}
+		}
+	}
+}
+
+template< class FunctorT >
+static void VisitReferences( const MetaStruct* type, void* composite, Object* object, FunctorT& functor )
+{
+	for ( const MetaStruct* current = type; current != NULL; current = current->m_Base )
+	{
+		DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin();
+		DynamicArray< Field >::ConstIterator end = current->m_Fields.End();
+		for ( ; itr != end; ++itr )
+		{
+			const Field* field = &*itr;
+
+			// shared references are not part of the graph, they keep pointing at the originals
+			if ( field->m_Bitwise != BitwiseKinds::None || ( field->m_Flags & FieldFlags::Share ) || !HoldsReferences( field->m_Translator ) )
+			{
+				continue;
+			}
+
+			for ( uint32_t i=0; i<field->m_Count; ++i )
+			{
+				VisitReferences( field->m_Translator, Pointer( field, composite, object, i ), functor );
+			}
+		}
+	}
+}
+
+// add each object we haven't seen yet to the index, and to the list still to be visited
+struct DiscoverReferences
+{
+	ObjectIndex&             m_Index;
+	DynamicArray< Object* >& m_Originals;
+
+	bool operator()( ObjectPtr& reference )
+	{
+		if ( reference.ReferencesObject() && m_Index.Insert( reference.Ptr(), static_cast< uint32_t >( m_Originals.GetSize() ) ) )
+		{
+			m_Originals.Add( reference.Ptr() );
+		}
+
+		return false;
+	}
+};
+
+// point a reference to an original at its clone instead, the index is only read so threads can share it
+struct RemapReferences
+{
+	const ObjectIndex&             m_Index;
+	const DynamicArray< Object* >& m_Clones;
+
+	bool operator()( ObjectPtr& reference )
+	{
+		if ( reference.ReferencesObject() )
+		{
+			uint32_t index = m_Index.Find( reference.Ptr() );
+			if ( index != ObjectIndex::Invalid )
+			{
+				reference = m_Clones[ index ];
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+//
+// Copies field data for batches of objects, run by every copy thread
+//
+
+class CloneGraphJob
+{
+public:
+	CloneGraphJob( const DynamicArray< Object* >& originals, const DynamicArray< Object* >& clones, const ObjectIndex& index )
+		: m_Originals( originals )
+		, m_Clones( clones )
+		, m_Index( index )
+		, m_Next( 0 )
+	{
+	}
+
+	void Run()
+	{
+		RemapReferences remap = { m_Index, m_Clones };
+		int32_t count = static_cast< int32_t >( m_Originals.GetSize() );
+
+		for ( int32_t begin = AtomicAdd( m_Next, CloneBatchSize ); begin < count; begin = AtomicAdd( m_Next, CloneBatchSize ) )
+		{
+			for ( int32_t i = begin, end = Min( begin + CloneBatchSize, count ); i < end; ++i )
+			{
+				Object* original = m_Originals[ i ];
+				Object* clone = m_Clones[ i ];
+				const MetaClass* type = original->GetMetaClass();
+
+				// copy references as they are, then point the ones into the graph at their clones
+				type->Copy( original, original, clone, clone, true );
+				VisitReferences( type, clone, clone, remap );
+			}
+		}
+	}
+
+private:
+	const DynamicArray< Object* >& m_Originals;
+	const DynamicArray< Object* >& m_Clones;
+	const ObjectIndex&             m_Index;
+	int32_t volatile               m_Next;
+};
+
+void Reflect::CloneGraph( const DynamicArray< ObjectPtr >& roots, ObjectGraphMap& clones, uint32_t threadCount )
+{
+	// discover the graph breadth first, each object is only visited once so cycles terminate
+	ObjectIndex index;
+	DynamicArray< Object* > originals;
+	DiscoverReferences discover = { index, originals };
+	for ( size_t i = 0; i < roots.GetSize(); ++i )
+	{
+		ObjectPtr root = roots[ i ];
+		discover( root );
+	}
+	for ( size_t i = 0; i < originals.GetSize(); ++i )
+	{
+		VisitReferences( originals[ i ]->GetMetaClass(), originals[ i ], originals[ i ], discover );
+	}
+
+	// allocate every clone up front, so the copy threads only read the index (the map holds the references)
+	clones = ObjectGraphMap( originals.GetSize() | 1 );
+	DynamicArray< Object* > cloneObjects;
+	cloneObjects.Reserve( originals.GetSize() );
+	for ( size_t i = 0; i < originals.GetSize(); ++i )
+	{
+		Object* original = originals[ i ];
+		const MetaClass* type = original->GetMetaClass();
+		HELIUM_ASSERT( type->m_Creator );
+
+		ObjectPtr clone = type->m_Creator();
+		clones.Insert( ObjectGraphMap::ValueType( original, clone ) );
+		cloneObjects.Add( clone );
+
+		original->PreSerialize( NULL );
+		clone->PreDeserialize( NULL );
+	}
+
+	if ( threadCount == 0 )
+	{
+		threadCount = Platform::GetProcessorCount();
+	}
+
+	if ( originals.GetSize() < CloneParallelThreshold )
+	{
+		threadCount = 1;
+	}
+
+	// copy field data, this thread works alongside the others
+	CloneGraphJob job ( originals, cloneObjects, index );
+	CallbackThread* threads = threadCount > 1 ? new CallbackThread[ threadCount - 1 ] : NULL;
+	for ( uint32_t i = 0; i + 1 < threadCount; ++i )
+	{
+		threads[ i ].Create( &CallbackThread::EntryHelper< CloneGraphJob, &CloneGraphJob::Run >, &job, "Reflect Clone Graph" );
+	}
+
+	job.Run();
+
+	for ( uint32_t i = 0; i + 1 < threadCount; ++i )
+	{
+		threads[ i ].Join();
+	}
+	delete[] threads;
+
+	// callbacks can touch other objects, so they run here once all the data is in place
+	for ( size_t i = 0; i < originals.GetSize(); ++i )
+	{
+		cloneObjects[ i ]->PostDeserialize( NULL );
+		originals[ i ]->PostSerialize( NULL );
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Foundation/DynamicArray.h"
+#include "Foundation/HashMap.h"
+
+#include "Reflect/API.h"
+#include "Reflect/Object.h"
+
+namespace Helium
+{
+	namespace Reflect
+	{
+		//
+		// Open addressed table of objects, to their position in some list of them.  Unlike HashMap it grows
+		//  with the number of objects, and lookups are safe from any number of threads while it isn't changing.
+		//
+
+		class HELIUM_REFLECT_API ObjectIndex : NonCopyable
+		{
+		public:
+			static const uint32_t Invalid = 0xffffffff;
+
+			ObjectIndex();
+			~ObjectIndex();
+
+			// false if the object was already present
+			inline bool Insert( const Object* object, uint32_t index );
+			inline uint32_t Find( const Object* object ) const;
+			inline size_t GetSize() const;
+
+		private:
+			struct Slot
+			{
+				const Object* m_Object;
+				uint32_t      m_Index;
+			};
+
+			inline static size_t HashObject( const Object* object );
+			inline Slot* Probe( const Object* object ) const;
+
+			void Allocate( size_t slotCount );
+			void Grow();
+
+			Slot*  m_Slots;
+			size_t m_Mask;
+			size_t m_Count;
+		};
+
+		// maps each object in a graph to its counterpart (its clone, for CloneGraph)
+		typedef HashMap< Object*, ObjectPtr > ObjectGraphMap;
+
+		//
+		// Deep clone the graph of objects reachable from the roots through their object pointer fields
+		//  (including pointers held in structures and containers).  Each object is cloned exactly once, so
+		//  references shared between objects and cycles carry over to the clones, while fields flagged
+		//  FieldFlags::Share keep referring to the original objects, just like Object::Clone.
+		//
+		// The graph is discovered and the clones allocated on the calling thread, then field data is copied
+		//  across threadCount threads (zero picks one per processor).  Clones are returned in the map, keyed
+		//  by their originals.
+		//
+
+		HELIUM_REFLECT_API void CloneGraph( const DynamicArray< ObjectPtr >& roots, ObjectGraphMap& clones, uint32_t threadCount = 0 );
+	}
+}
+
+#include "Reflect/ObjectGraph.inl"
@@ -0,0 +1,46 @@
+bool Helium::Reflect::ObjectIndex::Insert( const Object* object, uint32_t index )
+{
+	if ( ( m_Count + 1 ) * 2 > m_Mask + 1 )
+	{
+		Grow();
+	}
+
+	Slot* slot = Probe( object );
+	if ( slot->m_Object )
+	{
+		return false;
+	}
+
+	slot->m_Object = object;
+	slot->m_Index = index;
+	++m_Count;
+	return true;
+}
+
+uint32_t Helium::Reflect::ObjectIndex::Find( const Object* object ) const
+{
+	const Slot* slot = Probe( object );
+	return slot->m_Object ? slot->m_Index : Invalid;
+}
+
+size_t Helium::Reflect::ObjectIndex::GetSize() const
+{
+	return m_Count;
+}
+
+size_t Helium::Reflect::ObjectIndex::HashObject( const Object* object )
+{
+	// objects are aligned, so mix the address to spread the low bits
+	return static_cast< size_t >( ( static_cast< uint64_t >( reinterpret_cast< uintptr_t >( object ) ) * 0x9e3779b97f4a7c15ULL ) >> 32 );
+}
+
+Helium::Reflect::ObjectIndex::Slot* Helium::Reflect::ObjectIndex::Probe( const Object* object ) const
+{
+	for ( size_t i = HashObject( object ) & m_Mask; ; i = ( i + 1 ) & m_Mask )
+	{
+		if ( m_Slots[ i ].m_Object == object || !m_Slots[ i ].m_Object )
+		{
+			return &m_Slots[ i ];
+		}
+	}
+}
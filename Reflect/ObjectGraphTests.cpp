@@ -0,0 +1,199 @@
+#include "Precompile.h"
+#include "Reflect/ObjectGraph.h"
+#include "Reflect/Registry.h"
+#include "Reflect/TranslatorDeduction.h"
+
+#include "Platform/Console.h"
+#include "Platform/Runtime.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+using namespace Helium;
+using namespace Helium::Reflect;
+
+class GraphTestNode;
+typedef StrongPtr< GraphTestNode > GraphTestNodePtr;
+
+struct GraphTestLink : Struct
+{
+	GraphTestNodePtr m_Target;
+	float32_t        m_Weight;
+
+	GraphTestLink()
+		: m_Weight( 0.f )
+	{
+	}
+
+	HELIUM_DECLARE_BASE_STRUCT( GraphTestLink );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+class GraphTestNode : public Object
+{
+public:
+	uint32_t                        m_Value;
+	GraphTestNodePtr                m_Next;
+	std::vector< GraphTestNodePtr > m_Children;
+	GraphTestLink                   m_Link;
+	GraphTestNodePtr                m_Owner; // shared, not cloned
+
+	GraphTestNode()
+		: m_Value( 0 )
+	{
+	}
+
+	HELIUM_DECLARE_CLASS( GraphTestNode, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+HELIUM_DEFINE_BASE_STRUCT( GraphTestLink );
+HELIUM_DEFINE_CLASS( GraphTestNode );
+
+void GraphTestLink::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &GraphTestLink::m_Target, "Target" );
+	comp.AddField( &GraphTestLink::m_Weight, "Weight" );
+}
+
+void GraphTestNode::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &GraphTestNode::m_Value, "Value" );
+	comp.AddField( &GraphTestNode::m_Next, "Next" );
+	comp.AddField( &GraphTestNode::m_Children, "Children" );
+	comp.AddField( &GraphTestNode::m_Link, "Link" );
+	comp.AddField( &GraphTestNode::m_Owner, "Owner", FieldFlags::Share );
+}
+
+static GraphTestNode* CloneOf( const ObjectGraphMap& clones, const GraphTestNodePtr& original )
+{
+	ObjectGraphMap::ConstIterator found = clones.Find( original.Ptr() );
+	return found != clones.End() ? static_cast< GraphTestNode* >( found->Second().Ptr() ) : NULL;
+}
+
+// a chain of nodes linked in a ring, each with a couple of children from further along and a link back
+static void BuildGraph( uint32_t nodeCount, DynamicArray< GraphTestNodePtr >& nodes, const GraphTestNodePtr& owner )
+{
+	nodes.Clear();
+	nodes.Reserve( nodeCount );
+	for ( uint32_t i = 0; i < nodeCount; ++i )
+	{
+		GraphTestNodePtr node = new GraphTestNode;
+		node->m_Value = i;
+		node->m_Owner = owner;
+		nodes.Add( node );
+	}
+
+	for ( uint32_t i = 0; i < nodeCount; ++i )
+	{
+		nodes[ i ]->m_Next = nodes[ ( i + 1 ) % nodeCount ];
+		nodes[ i ]->m_Children.push_back( nodes[ ( i * 7 + 3 ) % nodeCount ] );
+		nodes[ i ]->m_Children.push_back( nodes[ ( i * 13 + 5 ) % nodeCount ] );
+		nodes[ i ]->m_Link.m_Target = nodes[ i / 2 ];
+		nodes[ i ]->m_Link.m_Weight = i * 0.5f;
+	}
+}
+
+// rings hold on to themselves, so break them before letting go
+static void BreakGraph( DynamicArray< GraphTestNodePtr >& nodes )
+{
+	for ( size_t i = 0; i < nodes.GetSize(); ++i )
+	{
+		nodes[ i ]->m_Next = NULL;
+		nodes[ i ]->m_Children.clear();
+		nodes[ i ]->m_Link.m_Target = NULL;
+	}
+
+	nodes.Clear();
+}
+
+static void BreakClones( ObjectGraphMap& clones )
+{
+	DynamicArray< GraphTestNodePtr > nodes;
+	for ( ObjectGraphMap::Iterator itr = clones.Begin(), end = clones.End(); itr != end; ++itr )
+	{
+		nodes.Add( static_cast< GraphTestNode* >( itr->Second().Ptr() ) );
+	}
+
+	BreakGraph( nodes );
+	clones.Clear();
+}
+
+TEST(ReflectObjectGraph, ClonePreservesSharingAndCycles)
+{
+	Reflect::Startup();
+
+	const uint32_t nodeCount = 2000; // enough to copy on several threads
+	GraphTestNodePtr owner = new GraphTestNode;
+	DynamicArray< GraphTestNodePtr > nodes;
+	BuildGraph( nodeCount, nodes, owner );
+
+	DynamicArray< ObjectPtr > roots;
+	roots.Add( nodes[ 0 ] );
+	roots.Add( nodes[ 0 ] );
+
+	ObjectGraphMap clones;
+	CloneGraph( roots, clones, 4 );
+	ASSERT_EQ( nodeCount, clones.GetSize() );
+	EXPECT_TRUE( clones.Find( owner.Ptr() ) == clones.End() );
+
+	for ( uint32_t i = 0; i < nodeCount; ++i )
+	{
+		const GraphTestNodePtr& original = nodes[ i ];
+		GraphTestNode* clone = CloneOf( clones, original );
+		ASSERT_TRUE( clone != NULL );
+		EXPECT_NE( original.Ptr(), clone );
+		EXPECT_EQ( i, clone->m_Value );
+
+		// references into the graph lead to the one clone of their target, through pointers, containers and structures
+		EXPECT_EQ( CloneOf( clones, original->m_Next ), clone->m_Next.Ptr() );
+		ASSERT_EQ( 2u, clone->m_Children.size() );
+		EXPECT_EQ( CloneOf( clones, original->m_Children[ 0 ] ), clone->m_Children[ 0 ].Ptr() );
+		EXPECT_EQ( CloneOf( clones, original->m_Children[ 1 ] ), clone->m_Children[ 1 ].Ptr() );
+		EXPECT_EQ( CloneOf( clones, original->m_Link.m_Target ), clone->m_Link.m_Target.Ptr() );
+		EXPECT_EQ( original->m_Link.m_Weight, clone->m_Link.m_Weight );
+
+		// shared references are left alone
+		EXPECT_EQ( owner.Ptr(), clone->m_Owner.Ptr() );
+	}
+
+	BreakClones( clones );
+	BreakGraph( nodes );
+	owner = NULL;
+	roots.Clear();
+
+	Reflect::Shutdown();
+}
+
+TEST(ReflectObjectGraph, CloneScalingBenchmark)
+{
+	Reflect::Startup();
+
+	const uint32_t nodeCount = 200000;
+	DynamicArray< GraphTestNodePtr > nodes;
+	BuildGraph( nodeCount, nodes, NULL );
+
+	DynamicArray< ObjectPtr > roots;
+	roots.Add( nodes[ 0 ] );
+
+	uint32_t processorCount = Platform::GetProcessorCount();
+	for ( uint32_t threadCount = 1; threadCount <= Max< uint32_t >( processorCount, 2 ); threadCount *= 2 )
+	{
+		ObjectGraphMap clones;
+
+		SimpleTimer timer;
+		CloneGraph( roots, clones, threadCount );
+		float64_t millis = timer.Elapsed();
+
+		EXPECT_EQ( nodeCount, clones.GetSize() );
+		Helium::Print( "CloneGraph: %u objects on %u thread(s) (%u processors), %.1f ms, %.0f ns/object\n",
+			nodeCount, threadCount, processorCount, millis, millis * 1000000.0 / nodeCount );
+
+		BreakClones( clones );
+	}
+
+	BreakGraph( nodes );
+	roots.Clear();
+
+	Reflect::Shutdown();
+}
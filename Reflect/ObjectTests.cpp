@@ -0,0 +1,764 @@
+#include "Precompile.h"
+#include "Reflect/Object.h"
+#include "Reflect/Registry.h"
+#include "Reflect/TranslatorDeduction.h"
+
+#include "Platform/Console.h"
+#include "Platform/Runtime.h"
+#include "Platform/Thread.h"
+#include "Platform/Timer.h"
+
+#include "gtest/gtest.h"
+
+#include <limits>
+
+using namespace Helium;
+using namespace Helium::Reflect;
+
+// an object much like a scene node: mostly plain data, with a few fields that need their translators
+struct CopyTestVector : Struct
+{
+	float32_t m_X;
+	float32_t m_Y;
+	float32_t m_Z;
+
+	CopyTestVector()
+		: m_X( 0.f )
+		, m_Y( 0.f )
+		, m_Z( 0.f )
+	{
+	}
+
+	HELIUM_DECLARE_BASE_STRUCT( CopyTestVector );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+class CopyTestObject : public Object
+{
+public:
+	uint32_t       m_Id;
+	int32_t        m_Flags;
+	uint64_t       m_Mask;
+	float32_t      m_Weights[ 16 ];
+	float64_t      m_Time;
+	CopyTestVector m_Position;
+	CopyTestVector m_Scale;
+	std::string    m_Name;
+
+	CopyTestObject()
+		: m_Id( 0 )
+		, m_Flags( 0 )
+		, m_Mask( 0 )
+		, m_Time( 0.0 )
+	{
+		MemoryZero( m_Weights, sizeof( m_Weights ) );
+	}
+
+	HELIUM_DECLARE_CLASS( CopyTestObject, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+HELIUM_DEFINE_BASE_STRUCT( CopyTestVector );
+HELIUM_DEFINE_CLASS( CopyTestObject );
+
+void CopyTestVector::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &CopyTestVector::m_X, "X" );
+	comp.AddField( &CopyTestVector::m_Y, "Y" );
+	comp.AddField( &CopyTestVector::m_Z, "Z" );
+}
+
+void CopyTestObject::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &CopyTestObject::m_Id, "Id" );
+	comp.AddField( &CopyTestObject::m_Flags, "Flags" );
+	comp.AddField( &CopyTestObject::m_Mask, "Mask" );
+	comp.AddField( &CopyTestObject::m_Weights, "Weights" );
+	comp.AddField( &CopyTestObject::m_Time, "Time" );
+	comp.AddField( &CopyTestObject::m_Position, "Position" );
+	comp.AddField( &CopyTestObject::m_Scale, "Scale" );
+	comp.AddField( &CopyTestObject::m_Name, "Name" );
+}
+
+static StrongPtr< CopyTestObject > CreateCopyTestObject()
+{
+	StrongPtr< CopyTestObject > object = new CopyTestObject;
+	object->m_Id = 42;
+	object->m_Flags = -7;
+	object->m_Mask = 0x0123456789abcdefULL;
+	for ( uint32_t i = 0; i < 16; ++i )
+	{
+		object->m_Weights[ i ] = i * 0.25f;
+	}
+	object->m_Time = 1.5;
+	object->m_Position.m_X = 1.f;
+	object->m_Position.m_Y = 2.f;
+	object->m_Position.m_Z = 3.f;
+	object->m_Scale.m_X = object->m_Scale.m_Y = object->m_Scale.m_Z = 1.f;
+	object->m_Name = "Copy Test Object";
+	return object;
+}
+
+TEST(ReflectObject, CloneAndEqualsUseFieldRuns)
+{
+	Reflect::Startup();
+
+	const MetaClass* type = GetMetaClass< CopyTestObject >();
+	ASSERT_TRUE( type->m_HasFieldRuns );
+
+	// the integers, 32-bit floats and 64-bit float compare as three runs but copy as one, the structures and string go through translators
+	EXPECT_EQ( 3u, type->m_EqualsRuns.GetSize() );
+	EXPECT_EQ( 1u, type->m_CopyRuns.GetSize() );
+	EXPECT_EQ( 3u, type->m_TranslatedFields.GetSize() );
+
+	StrongPtr< CopyTestObject > object = CreateCopyTestObject();
+	StrongPtr< CopyTestObject > clone = Reflect::AssertCast< CopyTestObject >( object->Clone() );
+	EXPECT_EQ( 42u, clone->m_Id );
+	EXPECT_EQ( 0x0123456789abcdefULL, clone->m_Mask );
+	EXPECT_EQ( 3.75f, clone->m_Weights[ 15 ] );
+	EXPECT_EQ( 3.f, clone->m_Position.m_Z );
+	EXPECT_EQ( "Copy Test Object", clone->m_Name );
+	EXPECT_TRUE( object->Equals( clone ) );
+
+	clone->m_Mask ^= 1;
+	EXPECT_FALSE( object->Equals( clone ) );
+	clone->m_Mask ^= 1;
+
+	// floats compare by value, like their translators do
+	object->m_Weights[ 0 ] = 0.f;
+	clone->m_Weights[ 0 ] = -0.f;
+	EXPECT_TRUE( object->Equals( clone ) );
+	object->m_Weights[ 0 ] = clone->m_Weights[ 0 ] = std::numeric_limits< float32_t >::quiet_NaN();
+	EXPECT_FALSE( object->Equals( clone ) );
+	object->m_Weights[ 0 ] = clone->m_Weights[ 0 ] = 0.f;
+
+	clone->m_Name = "Changed";
+	EXPECT_FALSE( object->Equals( clone ) );
+
+	object = NULL;
+	clone = NULL;
+	Reflect::Shutdown();
+}
+
+// a reference held in a structure, next to one held directly
+struct CopyTestHandle : Struct
+{
+	StrongPtr< CopyTestObject > m_Target;
+
+	HELIUM_DECLARE_BASE_STRUCT( CopyTestHandle );
+	static void PopulateMetaType( MetaStruct& comp );
+};
+
+class CopyTestOwner : public Object
+{
+public:
+	StrongPtr< CopyTestObject > m_Target;
+	CopyTestHandle              m_Handle;
+
+	HELIUM_DECLARE_CLASS( CopyTestOwner, Object );
+	static void PopulateMetaType( MetaClass& comp );
+};
+
+HELIUM_DEFINE_BASE_STRUCT( CopyTestHandle );
+HELIUM_DEFINE_CLASS( CopyTestOwner );
+
+void CopyTestHandle::PopulateMetaType( MetaStruct& comp )
+{
+	comp.AddField( &CopyTestHandle::m_Target, "Target" );
+}
+
+void CopyTestOwner::PopulateMetaType( MetaClass& comp )
+{
+	comp.AddField( &CopyTestOwner::m_Target, "Target" );
+	comp.AddField( &CopyTestOwner::m_Handle, "Handle" );
+}
+
+TEST(ReflectObject, ShallowCopiesReachIntoStructures)
+{
+	Reflect::Startup();
+
+	StrongPtr< CopyTestOwner > owner = new CopyTestOwner;
+	owner->m_Target = CreateCopyTestObject();
+	owner->m_Handle.m_Target = CreateCopyTestObject();
+
+	// CopyTo is shallow, so references in structures are shared just like the ones held directly
+	StrongPtr< CopyTestOwner > copy = new CopyTestOwner;
+	owner->CopyTo( copy );
+	EXPECT_EQ( owner->m_Target.Ptr(), copy->m_Target.Ptr() );
+	EXPECT_EQ( owner->m_Handle.m_Target.Ptr(), copy->m_Handle.m_Target.Ptr() );
+
+	// Clone is deep, all the way down
+	StrongPtr< CopyTestOwner > clone = Reflect::AssertCast< CopyTestOwner >( owner->Clone() );
+	ASSERT_TRUE( clone->m_Target.ReferencesObject() );
+	ASSERT_TRUE( clone->m_Handle.m_Target.ReferencesObject() );
+	EXPECT_NE( owner->m_Target.Ptr(), clone->m_Target.Ptr() );
+	EXPECT_NE( owner->m_Handle.m_Target.Ptr(), clone->m_Handle.m_Target.Ptr() );
+	EXPECT_TRUE( owner->m_Handle.m_Target->Equals( clone->m_Handle.m_Target ) );
+
+	owner = NULL;
+	copy = NULL;
+	clone = NULL;
+	Reflect::Shutdown();
+}
+
+TEST(ReflectObject, CloneAndEqualsBenchmark)
+{
+	const uint32_t iterationCount = 200000;
+
+	Reflect::Startup();
+
+	const MetaClass* type = GetMetaClass< CopyTestObject >();
+	StrongPtr< CopyTestObject > object = CreateCopyTestObject();
+	StrongPtr< CopyTestObject > other = CreateCopyTestObject();
+
+	float64_t millis[ 2 ][ 2 ];
+	for ( uint32_t pass = 0; pass < 2; ++pass )
+	{
+		// the first pass goes field by field through the translators, like unregistered types do
+		type->m_HasFieldRuns = pass > 0;
+
+		SimpleTimer timer;
+		for ( uint32_t i = 0; i < iterationCount; ++i )
+		{
+			object->Clone();
+		}
+		millis[ pass ][ 0 ] = timer.Elapsed();
+
+		uint32_t equalCount = 0;
+		timer.Reset();
+		for ( uint32_t i = 0; i < iterationCount; ++i )
+		{
+			equalCount += object->Equals( other ) ? 1 : 0;
+		}
+		millis[ pass ][ 1 ] = timer.Elapsed();
+
+		EXPECT_EQ( iterationCount, equalCount );
+	}
+
+	type->m_HasFieldRuns = true;
+
+	Helium::Print( "Object: Clone %.1f ns by field, %.1f ns with runs; Equals %.1f ns by field, %.1f ns with runs\n",
+		millis[ 0 ][ 0 ] * 1000000.0 / iterationCount, millis[ 1 ][ 0 ] * 1000000.0 / iterationCount,
+		millis[ 0 ][ 1 ] * 1000000.0 / iterationCount, millis[ 1 ][ 1 ] * 1000000.0 / iterationCount );
+
+	object = NULL;
+	other = NULL;
+	Reflect::Shutdown();
+}
+
+TEST(ReflectObject, StringFieldsPrintAndParse)
+{
+	Reflect::Startup();
+
+	StrongPtr< CopyTestObject > object = CreateCopyTestObject();
+	const Field* nameField = GetMetaClass< CopyTestObject >()->FindField( &CopyTestObject::m_Name );
+	ASSERT_TRUE( nameField && nameField->m_Translator->GetMetaId() == MetaIds::ScalarTranslator );
+	ScalarTranslator* translator = static_cast< ScalarTranslator* >( nameField->m_Translator.Get() );
+	Pointer name ( nameField, object );
+
+	String printed;
+	translator->Print( name, printed );
+	EXPECT_STREQ( "Copy Test Object", printed.GetData() );
+
+	// an empty string has no characters at all to parse
+	String empty;
+	translator->Parse( empty, name );
+	EXPECT_TRUE( object->m_Name.empty() );
+
+	translator->Parse( printed, name );
+	EXPECT_EQ( std::string( "Copy Test Object" ), object->m_Name );
+
+	object = NULL;
+	Reflect::Shutdown();
+}
+
+TEST(ReflectObject, DirtyTrackingFollowsChanges)
+{
+	Reflect::Startup();
+
+	const MetaClass* type = GetMetaClass< CopyTestObject >();
+	const Field* idField = type->FindField( &CopyTestObject::m_Id );
+	const Field* timeField = type->FindField( &CopyTestObject::m_Time );
+	const Field* nameField = type->FindField( &CopyTestObject::m_Name );
+	const Field* xField = GetMetaStruct< CopyTestVector >()->FindField( &CopyTestVector::m_X );
+	ASSERT_TRUE( idField && timeField && nameField && xField );
+
+	// without tracking nothing is known, so everything counts as dirty
+	StrongPtr< CopyTestObject > object = CreateCopyTestObject();
+	EXPECT_FALSE( object->IsDirtyTracking() );
+	EXPECT_TRUE( object->IsDirty() );
+	EXPECT_TRUE( object->IsFieldDirty( idField ) );
+
+	object->SetDirtyTracking( true );
+	EXPECT_TRUE( object->IsFieldDirty( nameField ) );
+	object->ClearDirtyFields();
+	EXPECT_FALSE( object->IsDirty() );
+
+	object->ChangeField( &CopyTestObject::m_Id, 7u );
+	EXPECT_EQ( 7u, object->m_Id );
+	object->m_Time = 2.0;
+	object->FieldChanged( &object->m_Time );
+	EXPECT_TRUE( object->IsDirty() );
+	EXPECT_TRUE( object->IsFieldDirty( idField ) );
+	EXPECT_TRUE( object->IsFieldDirty( timeField ) );
+	EXPECT_FALSE( object->IsFieldDirty( nameField ) );
+
+	// a field of a nested structure has no bit of its own
+	object->ClearDirtyFields();
+	object->m_Position.m_X = 4.f;
+	object->RaiseChanged( xField );
+	EXPECT_TRUE( object->IsFieldDirty( nameField ) );
+
+	object->ClearDirtyFields();
+	object->RaiseChanged();
+	EXPECT_TRUE( object->IsFieldDirty( idField ) );
+	EXPECT_TRUE( object->IsFieldDirty( nameField ) );
+
+	object->SetDirtyTracking( false );
+	EXPECT_TRUE( object->IsDirty() );
+
+	object = NULL;
+	Reflect::Shutdown();
+}
+
+// counts what it hears, and can make changes of its own from inside a delivery, or copy the changed object
+//  to a mirror of it like an editor refreshing its view would
+struct ChangeTestListener
+{
+	uint32_t                    m_Changes;
+	uint32_t                    m_AmbiguousChanges;
+	uint32_t                    m_Batches;
+	uint32_t                    m_BatchedChanges;
+	StrongPtr< CopyTestObject > m_Change;
+	StrongPtr< CopyTestObject > m_Mirror;
+
+	ChangeTestListener()
+		: m_Changes( 0 )
+		, m_AmbiguousChanges( 0 )
+		, m_Batches( 0 )
+		, m_BatchedChanges( 0 )
+	{
+	}
+
+	void Changed( const ObjectChangeArgs& args )
+	{
+		++m_Changes;
+		m_AmbiguousChanges += args.m_Field ? 0 : 1;
+
+		if ( m_Mirror )
+		{
+			const_cast< Object* >( args.m_Object )->CopyTo( m_Mirror );
+		}
+
+		if ( m_Change )
+		{
+			StrongPtr< CopyTestObject > object = m_Change;
+			m_Change = NULL;
+
+			ChangeBatch batch;
+			object->ChangeField( &CopyTestObject::m_Flags, 1 );
+		}
+	}
+
+	void Delivered( const ObjectChangeBatchArgs& args )
+	{
+		++m_Batches;
+		m_BatchedChanges += static_cast< uint32_t >( args.m_Count );
+	}
+};
+
+TEST(ReflectObject, ChangeBatchCoalescesNotifications)
+{
+	Reflect::Startup();
+
+	StrongPtr< CopyTestObject > first = CreateCopyTestObject();
+	StrongPtr< CopyTestObject > second = CreateCopyTestObject();
+	StrongPtr< CopyTestObject > deleted = CreateCopyTestObject();
+
+	ChangeTestListener firstListener, secondListener, deletedListener, batchListener;
+	first->e_Changed.AddMethod( &firstListener, &ChangeTestListener::Changed );
+	second->e_Changed.AddMethod( &secondListener, &ChangeTestListener::Changed );
+	deleted->e_Changed.AddMethod( &deletedListener, &ChangeTestListener::Changed );
+	ChangeBatch::e_Delivered.AddMethod( &batchListener, &ChangeTestListener::Delivered );
+
+	EXPECT_FALSE( ChangeBatch::IsOpen() );
+	{
+		ChangeBatch batch;
+		EXPECT_TRUE( ChangeBatch::IsOpen() );
+
+		// each field is heard once, however often and however deeply it changes
+		first->ChangeField( &CopyTestObject::m_Id, 1u );
+		first->ChangeField( &CopyTestObject::m_Id, 2u );
+		{
+			ChangeBatch nested;
+			first->ChangeField( &CopyTestObject::m_Time, 3.0 );
+			first->ChangeField( &CopyTestObject::m_Id, 4u );
+		}
+		EXPECT_EQ( 0u, firstListener.m_Changes );
+
+		// an ambiguous change covers every field of its object
+		second->ChangeField( &CopyTestObject::m_Id, 1u );
+		second->RaiseChanged();
+		second->ChangeField( &CopyTestObject::m_Time, 2.0 );
+
+		// changes to objects deleted before delivery are dropped
+		deleted->RaiseChanged();
+		deleted = NULL;
+	}
+	EXPECT_FALSE( ChangeBatch::IsOpen() );
+
+	EXPECT_EQ( 2u, firstListener.m_Changes );
+	EXPECT_EQ( 0u, firstListener.m_AmbiguousChanges );
+	EXPECT_EQ( 1u, secondListener.m_Changes );
+	EXPECT_EQ( 1u, secondListener.m_AmbiguousChanges );
+	EXPECT_EQ( 0u, deletedListener.m_Changes );
+	EXPECT_EQ( 1u, batchListener.m_Batches );
+	EXPECT_EQ( 3u, batchListener.m_BatchedChanges );
+
+	// without a batch changes are heard as they happen
+	first->ChangeField( &CopyTestObject::m_Id, 5u );
+	first->ChangeField( &CopyTestObject::m_Id, 6u );
+	EXPECT_EQ( 4u, firstListener.m_Changes );
+	EXPECT_EQ( 1u, batchListener.m_Batches );
+
+	// a batch opened by a listener during delivery is delivered in a following round of the same batch
+	firstListener.m_Change = second;
+	{
+		ChangeBatch batch;
+		first->ChangeField( &CopyTestObject::m_Id, 7u );
+	}
+	EXPECT_EQ( 5u, firstListener.m_Changes );
+	EXPECT_EQ( 2u, secondListener.m_Changes );
+	EXPECT_EQ( 3u, batchListener.m_Batches );
+	EXPECT_EQ( 5u, batchListener.m_BatchedChanges );
+
+	ChangeBatch::e_Delivered.RemoveMethod( &batchListener, &ChangeTestListener::Delivered );
+	first->e_Changed.RemoveMethod( &firstListener, &ChangeTestListener::Changed );
+	second->e_Changed.RemoveMethod( &secondListener, &ChangeTestListener::Changed );
+	first = NULL;
+	second = NULL;
+	Reflect::Shutdown();
+}
+
+// changes an object in a batch of its own thread
+struct ChangeBatchJob
+{
+	StrongPtr< CopyTestObject > m_Object;
+	uint32_t                    m_Id;
+
+	void Run()
+	{
+		ChangeBatch batch;
+		m_Object->ChangeField( &CopyTestObject::m_Id, m_Id );
+		m_Object->ChangeField( &CopyTestObject::m_Time, 1.0 );
+	}
+};
+
+TEST(ReflectObject, ChangeBatchHandsObjectsBetweenThreads)
+{
+	Reflect::Startup();
+
+	StrongPtr< CopyTestObject > object = CreateCopyTestObject();
+	ChangeTestListener listener;
+	object->e_Changed.AddMethod( &listener, &ChangeTestListener::Changed );
+
+	// once delivered on one thread, an object can be batched and deleted on another
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		ChangeBatchJob job;
+		job.m_Object = object;
+		job.m_Id = i;
+
+		CallbackThread thread;
+		thread.Create( &CallbackThread::EntryHelper< ChangeBatchJob, &ChangeBatchJob::Run >, &job, "Change Batch" );
+		thread.Join();
+		EXPECT_EQ( 3 * i + 2, listener.m_Changes );
+
+		ChangeBatch batch;
+		object->ChangeField( &CopyTestObject::m_Id, i + 10 );
+	}
+	EXPECT_EQ( 9u, listener.m_Changes );
+
+	{
+		ChangeBatch batch;
+		object->RaiseChanged();
+		object->e_Changed.RemoveMethod( &listener, &ChangeTestListener::Changed );
+		object = NULL;
+	}
+	EXPECT_EQ( 9u, listener.m_Changes );
+
+	Reflect::Shutdown();
+}
+
+TEST(ReflectObject, ChangeBatchBenchmark)
+{
+	Reflect::Startup();
+
+	// a bulk edit of a large scene: a few fields of every object, each changed a few times, with a listener on each
+	const uint32_t objectCount = 100000;
+	const uint32_t passCount = 4;
+
+	DynamicArray< StrongPtr< CopyTestObject > > objects;
+	objects.Reserve( objectCount );
+	ChangeTestListener listener;
+	for ( uint32_t i = 0; i < objectCount; ++i )
+	{
+		objects.Add( new CopyTestObject );
+		objects[ i ]->e_Changed.AddMethod( &listener, &ChangeTestListener::Changed );
+	}
+
+	for ( uint32_t refresh = 0; refresh < 2; ++refresh )
+	{
+		listener.m_Mirror = refresh ? new CopyTestObject : NULL;
+
+		float64_t millis[ 2 ];
+		float64_t deliverMillis = 0.0;
+		for ( uint32_t batched = 0; batched < 2; ++batched )
+		{
+			listener.m_Changes = 0;
+
+			SimpleTimer timer;
+			ChangeBatch* batch = batched ? new ChangeBatch : NULL;
+			for ( uint32_t pass = 0; pass < passCount; ++pass )
+			{
+				for ( uint32_t i = 0; i < objectCount; ++i )
+				{
+					CopyTestObject* object = objects[ i ];
+					object->ChangeField( &CopyTestObject::m_Id, pass );
+					object->ChangeField( &CopyTestObject::m_Flags, static_cast< int32_t >( pass ) );
+					object->ChangeField( &CopyTestObject::m_Time, pass * 0.5 );
+				}
+			}
+			millis[ batched ] = timer.Elapsed();
+
+			if ( batch )
+			{
+				timer.Reset();
+				delete batch;
+				deliverMillis = timer.Elapsed();
+				millis[ batched ] += deliverMillis;
+			}
+
+			EXPECT_EQ( ( batched ? 3 : 3 * passCount ) * objectCount, listener.m_Changes );
+		}
+
+		Helium::Print( "Object: %u objects x %u fields x %u passes, %s listener, %.1f ms raised as they change, %.1f ms batched (%.1f ms delivering, %.2fx)\n",
+			objectCount, 3, passCount, refresh ? "refreshing" : "counting", millis[ 0 ], millis[ 1 ], deliverMillis, millis[ 0 ] / millis[ 1 ] );
+	}
+
+	for ( uint32_t i = 0; i < objectCount; ++i )
+	{
+		objects[ i ]->e_Changed.RemoveMethod( &listener, &ChangeTestListener::Changed );
+	}
+	objects.Clear();
+	listener.m_Mirror = NULL;
+	Reflect::Shutdown();
+}
+
+// the smallest object there is, so the churn is all proxy traffic
+class ChurnTestObject : public Object
+{
+};
+
+// allocates and drops objects in waves, keeping the first wave alive for another thread to release
+struct ProxyChurnJob
+{
+	uint32_t                m_Waves;
+	uint32_t                m_Keep;
+	DynamicArray< ObjectPtr > m_Kept;
+
+	ProxyChurnJob()
+		: m_Waves( 0 )
+		, m_Keep( 0 )
+	{
+	}
+
+	void Run()
+	{
+		const uint32_t waveSize = 64;
+		ObjectPtr objects[ waveSize ];
+		for ( uint32_t wave = 0; wave < m_Waves; ++wave )
+		{
+			for ( uint32_t i = 0; i < waveSize; ++i )
+			{
+				objects[ i ] = new ChurnTestObject;
+				if ( m_Kept.GetSize() < m_Keep )
+				{
+					m_Kept.Add( objects[ i ] );
+				}
+			}
+
+			for ( uint32_t i = 0; i < waveSize; ++i )
+			{
+				objects[ i ] = NULL;
+			}
+		}
+	}
+};
+
+static void RunProxyChurn( ProxyChurnJob* jobs, uint32_t threadCount )
+{
+	CallbackThread* threads = new CallbackThread[ threadCount ];
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		threads[ i ].Create( &CallbackThread::EntryHelper< ProxyChurnJob, &ProxyChurnJob::Run >, &jobs[ i ], "Proxy Churn" );
+	}
+
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		threads[ i ].Join();
+	}
+	delete[] threads;
+}
+
+#if HELIUM_REFLECT_TRACK_PROXIES
+TEST(ReflectObject, ProxyTrackingAcrossThreads)
+{
+	Reflect::Startup();
+
+	ObjectPtr first = new ChurnTestObject; // make sure the proxy system is up
+	size_t baseline = ObjectRefCountSupport::GetActiveProxyCount();
+
+	const uint32_t threadCount = 4;
+	ProxyChurnJob jobs[ threadCount ];
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		jobs[ i ].m_Waves = 100;
+		jobs[ i ].m_Keep = 100;
+	}
+
+	RunProxyChurn( jobs, threadCount );
+	EXPECT_EQ( baseline + threadCount * 100, ObjectRefCountSupport::GetActiveProxyCount() );
+
+	// enumeration merges every thread's list
+	size_t enumerated = 0;
+	bool foundKept = false;
+	ConcurrentHashSet< RefCountProxy< Object >* >::ConstAccessor accessor;
+	ObjectRefCountSupport::GetFirstActiveProxy( accessor );
+	while ( accessor.IsValid() )
+	{
+		foundKept |= ( *accessor )->GetObject() == jobs[ 2 ].m_Kept[ 50 ].Ptr();
+		++enumerated;
+		++accessor;
+	}
+	accessor.Release();
+	EXPECT_EQ( baseline + threadCount * 100, enumerated );
+	EXPECT_TRUE( foundKept );
+
+	// releasing here unlinks the proxies from the lists of the threads that allocated them
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		jobs[ i ].m_Kept.Clear();
+	}
+	EXPECT_EQ( baseline, ObjectRefCountSupport::GetActiveProxyCount() );
+
+	first = NULL;
+	Reflect::Shutdown();
+}
+
+// enumerates the active proxies over and over, while other threads do the same
+struct ProxyEnumerationJob
+{
+	uint32_t m_Passes;
+	size_t   m_Expected;
+	bool     m_Matched;
+
+	ProxyEnumerationJob()
+		: m_Passes( 0 )
+		, m_Expected( 0 )
+		, m_Matched( false )
+	{
+	}
+
+	void Run()
+	{
+		m_Matched = true;
+		for ( uint32_t pass = 0; pass < m_Passes; ++pass )
+		{
+			size_t enumerated = 0;
+			ConcurrentHashSet< RefCountProxy< Object >* >::ConstAccessor accessor;
+			ObjectRefCountSupport::GetFirstActiveProxy( accessor );
+			while ( accessor.IsValid() )
+			{
+				++enumerated;
+				++accessor;
+			}
+			accessor.Release();
+			m_Matched &= enumerated == m_Expected;
+		}
+	}
+};
+
+TEST(ReflectObject, ProxyEnumerationFromManyThreads)
+{
+	Reflect::Startup();
+
+	DynamicArray< ObjectPtr > objects;
+	for ( uint32_t i = 0; i < 1000; ++i )
+	{
+		objects.Add( new ChurnTestObject );
+	}
+
+	// each thread merges into its own snapshot, so they don't clear each other's
+	const uint32_t threadCount = 4;
+	ProxyEnumerationJob jobs[ threadCount ];
+	CallbackThread threads[ threadCount ];
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		jobs[ i ].m_Passes = 50;
+		jobs[ i ].m_Expected = ObjectRefCountSupport::GetActiveProxyCount();
+		threads[ i ].Create( &CallbackThread::EntryHelper< ProxyEnumerationJob, &ProxyEnumerationJob::Run >, &jobs[ i ], "Proxy Enumeration" );
+	}
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		threads[ i ].Join();
+		EXPECT_TRUE( jobs[ i ].m_Matched );
+	}
+
+	// the caches of threads that exited are adopted by new ones, which track and release as before
+	size_t baseline = ObjectRefCountSupport::GetActiveProxyCount();
+	for ( uint32_t round = 0; round < 3; ++round )
+	{
+		ProxyChurnJob churn[ threadCount ];
+		for ( uint32_t i = 0; i < threadCount; ++i )
+		{
+			churn[ i ].m_Waves = 20;
+			churn[ i ].m_Keep = 10;
+		}
+
+		RunProxyChurn( churn, threadCount );
+		EXPECT_EQ( baseline + threadCount * 10, ObjectRefCountSupport::GetActiveProxyCount() );
+	}
+	EXPECT_EQ( baseline, ObjectRefCountSupport::GetActiveProxyCount() );
+
+	objects.Clear();
+	Reflect::Shutdown();
+}
+#endif
+
+TEST(ReflectObject, ProxyChurnBenchmark)
+{
+	Reflect::Startup();
+
+	const uint32_t objectsPerThread = 1 << 20;
+	uint32_t processorCount = Platform::GetProcessorCount();
+	for ( uint32_t threadCount = 1; threadCount <= Max< uint32_t >( processorCount, 2 ); threadCount *= 2 )
+	{
+		ProxyChurnJob* jobs = new ProxyChurnJob[ threadCount ];
+		for ( uint32_t i = 0; i < threadCount; ++i )
+		{
+			jobs[ i ].m_Waves = objectsPerThread / 64;
+		}
+
+		SimpleTimer timer;
+		RunProxyChurn( jobs, threadCount );
+		float64_t millis = timer.Elapsed();
+
+		Helium::Print( "Object: proxy churn on %u thread(s) (%u processors), %.1f ms, %.1f ns/object\n",
+			threadCount, processorCount, millis, millis * 1000000.0 / ( objectsPerThread * threadCount ) );
+
+		delete[] jobs;
+	}
+
+	Reflect::Shutdown();
+}
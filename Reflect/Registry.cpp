@@ -4,11 +4,16 @@
 #include "Platform/Atomic.h"
 #include "Platform/Thread.h"
 
+#include "Foundation/FileStream.h"
 #include "Foundation/Log.h"
+#include "Foundation/Math.h"
 
 #include "Reflect/Object.h"
 #include "Reflect/TranslatorDeduction.h"
 
+#include <algorithm>
+#include <vector>
+
 // Prints the callstack for every init and cleanup call
 // #define HELIUM_DEBUG_INIT_AND_CLEANUP
 
@@ -67,7 +72,507 @@ namespace Helium
     {
         int32_t g_InitCount = 0;
         Registry* g_Registry = NULL;
+
+        //
+        // Flat, open addressed table of the registered types by crc.  Lookups never lock or write, the
+        //  main thread either updates a table in place (publishing each slot with a release barrier) or
+        //  builds a replacement and swaps it in.
+        //
+        //  - probed tables find a crc by linear probing from its home slot, and take inserts in place
+        //  - perfect tables map each crc straight to its slot with a displacement stored per bucket of
+        //    crcs (hash and displace), they are built once after startup and are copied back to a probed
+        //    table if a new crc registers late
+        //
+        // Unregistered entries keep their slot with a NULL type, so probe chains are never broken.
+        //
+
+        class TypeIndex
+        {
+        public:
+            struct Slot
+            {
+                uint32_t volatile        m_Crc;
+                int32_t volatile         m_Used;
+                const MetaType* volatile m_Type;
+            };
+
+            TypeIndex( uint32_t slotCount, uint32_t bucketCount );
+            ~TypeIndex();
+
+            static TypeIndex* BuildProbed( const M_HashToType& types, uint32_t reserve = 0 );
+            static TypeIndex* BuildPerfect( const M_HashToType& types );
+            static TypeIndex* BuildPerfect( const M_HashToType& types, uint32_t slotCount, const uint16_t* displacements, uint32_t bucketCount );
+
+            inline const MetaType* Find( uint32_t crc ) const;
+            bool Insert( uint32_t crc, const MetaType* type );
+            void Remove( uint32_t crc );
+
+            Slot*      m_Slots;
+            uint32_t   m_SlotMask;
+            uint16_t*  m_Displacements; // per bucket, NULL for probed tables
+            uint32_t   m_BucketMask;
+            uint32_t   m_UsedCount;
+            TypeIndex* m_NextRetired;
+
+        private:
+            Slot* Probe( uint32_t crc );
+            bool Place( const std::vector< uint32_t >& crcs, uint16_t displacement, std::vector< uint32_t >& slots );
+        };
+
+        //
+        // Precomputed registry layout, read whole from a file written by Registry::SaveSchema.  It's a cache for one
+        //  build on one machine, not an interchange format, so everything is native uint32_t words:
+        //
+        //  - the header
+        //  - the perfect table's displacements, one uint16_t per bucket (padded to a whole word)
+        //  - a record per structure, sorted by crc
+        //  - the field runs of all the structures
+        //  - the flattened indices of the fields that need their translators
+        //
+
+        struct SchemaHeader
+        {
+            uint32_t m_Magic;
+            uint32_t m_Version;
+            uint32_t m_BuildHashLow;
+            uint32_t m_BuildHashHigh;
+            uint32_t m_TypeCount;       // registered crcs, including aliases
+            uint32_t m_SlotCount;       // zero if there was no perfect table to save
+            uint32_t m_BucketCount;
+            uint32_t m_StructureCount;
+            uint32_t m_RunCount;
+            uint32_t m_TranslatedCount;
+        };
+
+        struct SchemaStructure
+        {
+            uint32_t m_Crc;
+            uint32_t m_Size;
+            uint32_t m_FieldCount;      // flattened, to catch a base that changed
+            uint32_t m_LayoutDigest;    // of every field's offset, size and kind, see LayoutDigest
+            uint32_t m_FirstCopyRun;
+            uint32_t m_CopyRunCount;
+            uint32_t m_FirstEqualsRun;
+            uint32_t m_EqualsRunCount;
+            uint32_t m_FirstTranslated;
+            uint32_t m_TranslatedCount;
+        };
+
+        struct SchemaRun
+        {
+            uint32_t m_Offset;
+            uint32_t m_Size;
+            uint32_t m_Kind;
+        };
+
+        class SchemaCache
+        {
+        public:
+            SchemaCache();
+
+            bool Read( const FilePath& path, uint64_t buildHash );
+            const SchemaStructure* FindStructure( uint32_t crc ) const;
+
+            DynamicArray< uint32_t > m_Words;
+            const SchemaHeader*      m_Header;
+            const uint16_t*          m_Displacements;
+            const SchemaStructure*   m_Structures;
+            const SchemaRun*         m_Runs;
+            const uint32_t*          m_Translated;
+        };
+    }
+}
+
+static const uint32_t MinimumTypeIndexSlots = 64;
+static const uint32_t MaximumTypeIndexDisplacement = 0xffff;
+static const uint32_t MaximumTypeIndexAttempts = 3;
+
+static const uint32_t SchemaMagic = 0x48525343; // 'HRSC'
+static const uint32_t SchemaVersion = 2;
+
+static FilePath g_SchemaPath;
+static uint64_t g_SchemaBuildHash = 0;
+
+// crc32 is already well distributed, but probing by its low bits clusters badly, so scramble it per seed
+static inline uint32_t HashCrc( uint32_t crc, uint32_t seed )
+{
+    uint32_t hash = crc ^ ( seed * 0x9e3779b9 );
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static inline uint32_t RoundUpToPowerOfTwo( uint32_t value )
+{
+    uint32_t result = 1;
+    while ( result < value )
+    {
+        result <<= 1;
     }
+
+    return result;
+}
+
+TypeIndex::TypeIndex( uint32_t slotCount, uint32_t bucketCount )
+: m_Slots( new Slot[ slotCount ] )
+, m_SlotMask( slotCount - 1 )
+, m_Displacements( bucketCount ? new uint16_t[ bucketCount ] : NULL )
+, m_BucketMask( bucketCount ? bucketCount - 1 : 0 )
+, m_UsedCount( 0 )
+, m_NextRetired( NULL )
+{
+    HELIUM_ASSERT( ( slotCount & m_SlotMask ) == 0 );
+    HELIUM_ASSERT( ( bucketCount & m_BucketMask ) == 0 );
+
+    MemoryZero( m_Slots, sizeof( Slot ) * slotCount );
+    if ( m_Displacements )
+    {
+        MemoryZero( m_Displacements, sizeof( uint16_t ) * bucketCount );
+    }
+}
+
+TypeIndex::~TypeIndex()
+{
+    delete[] m_Slots;
+    delete[] m_Displacements;
+}
+
+TypeIndex* TypeIndex::BuildProbed( const M_HashToType& types, uint32_t reserve )
+{
+    // keep the load at or under half, so there is room for inserts before the next rebuild
+    uint32_t typeCount = Max< uint32_t >( static_cast< uint32_t >( types.GetSize() ), reserve );
+    uint32_t slotCount = Max< uint32_t >( RoundUpToPowerOfTwo( typeCount * 2 ), MinimumTypeIndexSlots );
+
+    TypeIndex* index = new TypeIndex( slotCount, 0 );
+    for ( M_HashToType::ConstIterator itr = types.Begin(), end = types.End(); itr != end; ++itr )
+    {
+        HELIUM_VERIFY( index->Insert( itr->First(), itr->Second() ) );
+    }
+
+    return index;
+}
+
+TypeIndex* TypeIndex::BuildPerfect( const M_HashToType& types )
+{
+    uint32_t typeCount = static_cast< uint32_t >( types.GetSize() );
+    if ( typeCount == 0 )
+    {
+        return NULL;
+    }
+
+    // around four crcs per bucket
+    uint32_t bucketCount = RoundUpToPowerOfTwo( ( typeCount + 3 ) / 4 );
+    std::vector< std::vector< uint32_t > > buckets ( bucketCount );
+    for ( M_HashToType::ConstIterator itr = types.Begin(), end = types.End(); itr != end; ++itr )
+    {
+        buckets[ HashCrc( itr->First(), 0 ) & ( bucketCount - 1 ) ].push_back( itr->First() );
+    }
+
+    // place the largest buckets first, while the table is emptiest
+    std::vector< std::pair< size_t, uint32_t > > order;
+    order.reserve( bucketCount );
+    for ( uint32_t i = 0; i < bucketCount; ++i )
+    {
+        order.push_back( std::make_pair( buckets[ i ].size(), i ) );
+    }
+    std::sort( order.rbegin(), order.rend() );
+
+    // start at a load of 50-100%, and give up on perfection once the table would be mostly empty anyway
+    uint32_t slotCount = Max< uint32_t >( RoundUpToPowerOfTwo( typeCount ), MinimumTypeIndexSlots );
+    for ( uint32_t attempt = 0; attempt < MaximumTypeIndexAttempts; ++attempt, slotCount <<= 1 )
+    {
+        TypeIndex* index = new TypeIndex( slotCount, bucketCount );
+
+        bool placed = true;
+        std::vector< uint32_t > slots;
+        for ( size_t i = 0; placed && i < order.size() && order[ i ].first; ++i )
+        {
+            const std::vector< uint32_t >& crcs = buckets[ order[ i ].second ];
+
+            placed = false;
+            for ( uint32_t displacement = 0; !placed && displacement <= MaximumTypeIndexDisplacement; ++displacement )
+            {
+                placed = index->Place( crcs, static_cast< uint16_t >( displacement ), slots );
+                if ( placed )
+                {
+                    index->m_Displacements[ order[ i ].second ] = static_cast< uint16_t >( displacement );
+                }
+            }
+        }
+
+        if ( placed )
+        {
+            for ( M_HashToType::ConstIterator itr = types.Begin(), end = types.End(); itr != end; ++itr )
+            {
+                Slot* slot = index->Probe( itr->First() );
+                HELIUM_ASSERT( slot && slot->m_Crc == itr->First() );
+                slot->m_Type = itr->Second();
+            }
+
+            return index;
+        }
+
+        delete index;
+    }
+
+    return NULL;
+}
+
+TypeIndex* TypeIndex::BuildPerfect( const M_HashToType& types, uint32_t slotCount, const uint16_t* displacements, uint32_t bucketCount )
+{
+    // reuse displacements found by an earlier build of the table, a collision means the types differ and we search again
+    if ( slotCount < MinimumTypeIndexSlots || ( slotCount & ( slotCount - 1 ) ) || !bucketCount || ( bucketCount & ( bucketCount - 1 ) ) )
+    {
+        return NULL;
+    }
+
+    TypeIndex* index = new TypeIndex( slotCount, bucketCount );
+    MemoryCopy( index->m_Displacements, displacements, sizeof( uint16_t ) * bucketCount );
+
+    for ( M_HashToType::ConstIterator itr = types.Begin(), end = types.End(); itr != end; ++itr )
+    {
+        uint32_t displacement = index->m_Displacements[ HashCrc( itr->First(), 0 ) & index->m_BucketMask ];
+        Slot& slot = index->m_Slots[ HashCrc( itr->First(), displacement + 1 ) & index->m_SlotMask ];
+        if ( slot.m_Used )
+        {
+            delete index;
+            return NULL;
+        }
+
+        slot.m_Crc = itr->First();
+        slot.m_Type = itr->Second();
+        slot.m_Used = 1;
+        ++index->m_UsedCount;
+    }
+
+    return index;
+}
+
+const MetaType* TypeIndex::Find( uint32_t crc ) const
+{
+    if ( m_Displacements )
+    {
+        uint32_t displacement = m_Displacements[ HashCrc( crc, 0 ) & m_BucketMask ];
+        const Slot& slot = m_Slots[ HashCrc( crc, displacement + 1 ) & m_SlotMask ];
+        return ( slot.m_Used && slot.m_Crc == crc ) ? slot.m_Type : NULL;
+    }
+
+    for ( uint32_t i = HashCrc( crc, 0 ) & m_SlotMask; ; i = ( i + 1 ) & m_SlotMask )
+    {
+        const Slot& slot = m_Slots[ i ];
+        if ( !slot.m_Used )
+        {
+            return NULL;
+        }
+
+        if ( slot.m_Crc == crc )
+        {
+            return slot.m_Type;
+        }
+    }
+}
+
+bool TypeIndex::Insert( uint32_t crc, const MetaType* type )
+{
+    Slot* slot = Probe( crc );
+    if ( slot && slot->m_Used )
+    {
+        // re-registration of a crc that was unregistered, or an alias
+        AtomicExchangeRelease( slot->m_Type, type );
+        return true;
+    }
+
+    // a new crc can't go in a perfect table, and probed tables stay at most three quarters full
+    if ( !slot || m_Displacements || ( m_UsedCount + 1 ) * 4 > ( m_SlotMask + 1 ) * 3 )
+    {
+        return false;
+    }
+
+    slot->m_Crc = crc;
+    slot->m_Type = type;
+    AtomicExchangeRelease( slot->m_Used, 1 );
+    ++m_UsedCount;
+
+    return true;
+}
+
+void TypeIndex::Remove( uint32_t crc )
+{
+    Slot* slot = Probe( crc );
+    if ( slot && slot->m_Used )
+    {
+        AtomicExchangeRelease( slot->m_Type, static_cast< const MetaType* >( NULL ) );
+    }
+}
+
+TypeIndex::Slot* TypeIndex::Probe( uint32_t crc )
+{
+    // returns the slot holding crc, else where it would go (or NULL for a perfect table that hasn't room)
+    if ( m_Displacements )
+    {
+        uint32_t displacement = m_Displacements[ HashCrc( crc, 0 ) & m_BucketMask ];
+        Slot* slot = &m_Slots[ HashCrc( crc, displacement + 1 ) & m_SlotMask ];
+        return ( slot->m_Used && slot->m_Crc == crc ) ? slot : NULL;
+    }
+
+    for ( uint32_t i = HashCrc( crc, 0 ) & m_SlotMask; ; i = ( i + 1 ) & m_SlotMask )
+    {
+        Slot* slot = &m_Slots[ i ];
+        if ( !slot->m_Used || slot->m_Crc == crc )
+        {
+            return slot;
+        }
+    }
+}
+
+bool TypeIndex::Place( const std::vector< uint32_t >& crcs, uint16_t displacement, std::vector< uint32_t >& slots )
+{
+    slots.clear();
+    for ( size_t i = 0; i < crcs.size(); ++i )
+    {
+        uint32_t slot = HashCrc( crcs[ i ], displacement + 1 ) & m_SlotMask;
+        if ( m_Slots[ slot ].m_Used || std::find( slots.begin(), slots.end(), slot ) != slots.end() )
+        {
+            return false;
+        }
+
+        slots.push_back( slot );
+    }
+
+    for ( size_t i = 0; i < crcs.size(); ++i )
+    {
+        m_Slots[ slots[ i ] ].m_Crc = crcs[ i ];
+        m_Slots[ slots[ i ] ].m_Used = 1;
+        ++m_UsedCount;
+    }
+
+    return true;
+}
+
+SchemaCache::SchemaCache()
+: m_Header( NULL )
+, m_Displacements( NULL )
+, m_Structures( NULL )
+, m_Runs( NULL )
+, m_Translated( NULL )
+{
+
+}
+
+bool SchemaCache::Read( const FilePath& path, uint64_t buildHash )
+{
+    FileStream stream;
+    if ( !stream.Open( path.Data(), FileStream::MODE_READ ) )
+    {
+        return false;
+    }
+
+    int64_t size = stream.GetSize();
+    if ( size < static_cast< int64_t >( sizeof( SchemaHeader ) ) || size % sizeof( uint32_t ) || size > 0x7fffffff )
+    {
+        return false;
+    }
+
+    m_Words.Resize( static_cast< size_t >( size / sizeof( uint32_t ) ) );
+    if ( stream.Read( m_Words.GetData(), sizeof( uint32_t ), m_Words.GetSize() ) != m_Words.GetSize() )
+    {
+        return false;
+    }
+
+    m_Header = reinterpret_cast< const SchemaHeader* >( m_Words.GetData() );
+    if ( m_Header->m_Magic != SchemaMagic
+        || m_Header->m_Version != SchemaVersion
+        || m_Header->m_BuildHashLow != static_cast< uint32_t >( buildHash )
+        || m_Header->m_BuildHashHigh != static_cast< uint32_t >( buildHash >> 32 ) )
+    {
+        return false;
+    }
+
+    // the counts have to account for every word in the file
+    uint64_t displacementWords = ( static_cast< uint64_t >( m_Header->m_BucketCount ) + 1 ) / 2;
+    uint64_t expected = sizeof( SchemaHeader ) / sizeof( uint32_t )
+        + displacementWords
+        + static_cast< uint64_t >( m_Header->m_StructureCount ) * ( sizeof( SchemaStructure ) / sizeof( uint32_t ) )
+        + static_cast< uint64_t >( m_Header->m_RunCount ) * ( sizeof( SchemaRun ) / sizeof( uint32_t ) )
+        + m_Header->m_TranslatedCount;
+    if ( expected != m_Words.GetSize() )
+    {
+        return false;
+    }
+
+    const uint32_t* words = m_Words.GetData() + sizeof( SchemaHeader ) / sizeof( uint32_t );
+    m_Displacements = reinterpret_cast< const uint16_t* >( words );
+    words += displacementWords;
+    m_Structures = reinterpret_cast< const SchemaStructure* >( words );
+    words += m_Header->m_StructureCount * ( sizeof( SchemaStructure ) / sizeof( uint32_t ) );
+    m_Runs = reinterpret_cast< const SchemaRun* >( words );
+    words += m_Header->m_RunCount * ( sizeof( SchemaRun ) / sizeof( uint32_t ) );
+    m_Translated = words;
+
+    for ( uint32_t i = 0; i < m_Header->m_StructureCount; ++i )
+    {
+        const SchemaStructure& structure = m_Structures[ i ];
+        if ( ( i && m_Structures[ i - 1 ].m_Crc >= structure.m_Crc )
+            || static_cast< uint64_t >( structure.m_FirstCopyRun ) + structure.m_CopyRunCount > m_Header->m_RunCount
+            || static_cast< uint64_t >( structure.m_FirstEqualsRun ) + structure.m_EqualsRunCount > m_Header->m_RunCount
+            || static_cast< uint64_t >( structure.m_FirstTranslated ) + structure.m_TranslatedCount > m_Header->m_TranslatedCount )
+        {
+            return false;
+        }
+
+        // and the runs have to lie within the structure they're for
+        uint32_t firsts[] = { structure.m_FirstCopyRun, structure.m_FirstEqualsRun };
+        uint32_t counts[] = { structure.m_CopyRunCount, structure.m_EqualsRunCount };
+        for ( uint32_t j = 0; j < 2; ++j )
+        {
+            for ( const SchemaRun* run = m_Runs + firsts[ j ], *end = run + counts[ j ]; run != end; ++run )
+            {
+                if ( run->m_Offset > structure.m_Size || run->m_Size > structure.m_Size - run->m_Offset )
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    for ( uint32_t i = 0; i < m_Header->m_RunCount; ++i )
+    {
+        if ( m_Runs[ i ].m_Kind > BitwiseKinds::Float64 )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const SchemaStructure* SchemaCache::FindStructure( uint32_t crc ) const
+{
+    uint32_t low = 0;
+    uint32_t high = m_Header->m_StructureCount;
+    while ( low < high )
+    {
+        uint32_t middle = low + ( high - low ) / 2;
+        if ( m_Structures[ middle ].m_Crc < crc )
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return ( low < m_Header->m_StructureCount && m_Structures[ low ].m_Crc == crc ) ? &m_Structures[ low ] : NULL;
+}
+
+void Reflect::SetSchemaCache( const FilePath& path, uint64_t buildHash )
+{
+    g_SchemaPath = path;
+    g_SchemaBuildHash = buildHash;
 }
 
 void Reflect::Startup()
@@ -76,9 +581,21 @@ void Reflect::Startup()
     {
         g_Registry = new Registry();
 
+        if ( !g_SchemaPath.Empty() )
+        {
+            g_Registry->LoadSchema( g_SchemaPath, g_SchemaBuildHash );
+        }
+
         MetaTypeRegistrar::RegisterTypes( RegistrarTypes::MetaEnum );
         MetaTypeRegistrar::RegisterTypes( RegistrarTypes::MetaStruct );
         MetaTypeRegistrar::RegisterTypes( RegistrarTypes::MetaClass );
+
+        g_Registry->OptimizeIndex();
+
+        if ( !g_SchemaPath.Empty() && !g_Registry->IsSchemaCurrent() )
+        {
+            g_Registry->SaveSchema( g_SchemaPath, g_SchemaBuildHash );
+        }
     }
 
 #ifdef HELIUM_DEBUG_INIT_AND_CLEANUP
@@ -119,6 +636,10 @@ void Reflect::Shutdown()
 
 // private constructor
 Registry::Registry()
+: m_Index( TypeIndex::BuildProbed( M_HashToType() ) )
+, m_RetiredIndices( NULL )
+, m_Schema( NULL )
+, m_SchemaMissed( false )
 {
 
 }
@@ -126,6 +647,15 @@ Registry::Registry()
 Registry::~Registry()
 {
     m_TypesByHash.Clear();
+
+    delete m_Schema;
+    delete m_Index;
+    while ( m_RetiredIndices )
+    {
+        TypeIndex* next = m_RetiredIndices->m_NextRetired;
+        delete m_RetiredIndices;
+        m_RetiredIndices = next;
+    }
 }
 
 Registry* Registry::GetInstance()
@@ -150,6 +680,15 @@ bool Registry::RegisterType(const MetaType* type)
         return false;
     }
 
+    IndexType( crc, type );
+
+    // a structure whose layout is in the schema takes it from there, and needn't compute (or log) it
+    const MetaStruct* structure = ReflectionCast< const MetaStruct >( type );
+    if ( structure )
+    {
+        ApplySchema( structure, crc );
+    }
+
     type->Register();
 
     return true;
@@ -163,6 +702,7 @@ void Registry::UnregisterType(const MetaType* type)
 
     uint32_t crc = Crc32( type->m_Name );
     m_TypesByHash.Remove( crc );
+    m_Index->Remove( crc );
 }
 
 void Registry::AliasType( const MetaType* type, const char* alias )
@@ -170,7 +710,11 @@ void Registry::AliasType( const MetaType* type, const char* alias )
     HELIUM_ASSERT( Thread::IsMain() );
 
     uint32_t crc = Crc32( alias );
-    m_TypesByHash.Insert( M_HashToType::ValueType( crc, type ) );
+    Pair< M_HashToType::Iterator, bool > result = m_TypesByHash.Insert( M_HashToType::ValueType( crc, type ) );
+    if ( result.Second() )
+    {
+        IndexType( crc, type );
+    }
 }
 
 void Registry::UnaliasType( const MetaType* type, const char* alias )
@@ -182,19 +726,261 @@ void Registry::UnaliasType( const MetaType* type, const char* alias )
     if ( found != m_TypesByHash.End() && found->Second() == type )
     {
         m_TypesByHash.Remove( crc );
+        m_Index->Remove( crc );
     }
 }
 
-const MetaType* Registry::GetType( uint32_t crc ) const
+void Registry::OptimizeIndex()
 {
-    M_HashToType::ConstIterator found = m_TypesByHash.Find( crc );
+    HELIUM_ASSERT( Thread::IsMain() );
 
-    if ( found != m_TypesByHash.End() )
+    TypeIndex* index = NULL;
+    if ( m_Schema && m_Schema->m_Header->m_SlotCount )
     {
-        return found->Second();
+        index = TypeIndex::BuildPerfect( m_TypesByHash, m_Schema->m_Header->m_SlotCount, m_Schema->m_Displacements, m_Schema->m_Header->m_BucketCount );
     }
 
-    return NULL;
+    if ( !index )
+    {
+        m_SchemaMissed = true;
+        index = TypeIndex::BuildPerfect( m_TypesByHash );
+    }
+
+    if ( index )
+    {
+        PublishIndex( index );
+    }
+}
+
+// fold a word into a running digest (a murmur3 round, far cheaper per field than crc32's table)
+static inline uint32_t MixLayout( uint32_t digest, uint32_t value )
+{
+    value *= 0xcc9e2d51;
+    value = ( value << 15 ) | ( value >> 17 );
+    value *= 0x1b873593;
+    digest ^= value;
+    digest = ( digest << 13 ) | ( digest >> 19 );
+    return digest * 5 + 0xe6546b64;
+}
+
+// everything the runs are built from, each field's offset, size and kind in the order PopulateMetaType added
+//  them (bases first, so it's also index order), optionally gathering the fields by index along the way
+static uint32_t LayoutDigest( const MetaStruct* type, DynamicArray< const Field* >* fields )
+{
+    uint32_t digest = type->m_Size;
+    for ( uint32_t depth = 0; depth <= type->m_Depth; ++depth )
+    {
+        const MetaStruct* current = type->m_Ancestors[ depth ];
+        for ( DynamicArray< Field >::ConstIterator itr = current->m_Fields.Begin(), end = current->m_Fields.End(); itr != end; ++itr )
+        {
+            digest = MixLayout( digest, itr->m_Offset );
+            digest = MixLayout( digest, itr->m_Size );
+            digest = MixLayout( digest, static_cast< uint32_t >( itr->m_Bitwise ) );
+            if ( fields )
+            {
+                fields->Add( &*itr );
+            }
+        }
+    }
+
+    return HashCrc( digest, 0 );
+}
+
+bool Registry::SaveSchema( const FilePath& path, uint64_t buildHash ) const
+{
+    HELIUM_ASSERT( Thread::IsMain() );
+
+    SchemaHeader header;
+    MemoryZero( &header, sizeof( header ) );
+    header.m_Magic = SchemaMagic;
+    header.m_Version = SchemaVersion;
+    header.m_BuildHashLow = static_cast< uint32_t >( buildHash );
+    header.m_BuildHashHigh = static_cast< uint32_t >( buildHash >> 32 );
+    header.m_TypeCount = static_cast< uint32_t >( m_TypesByHash.GetSize() );
+
+    DynamicArray< uint16_t > displacements;
+    if ( m_Index->m_Displacements )
+    {
+        header.m_SlotCount = m_Index->m_SlotMask + 1;
+        header.m_BucketCount = m_Index->m_BucketMask + 1;
+        displacements.AddArray( m_Index->m_Displacements, header.m_BucketCount );
+    }
+    if ( displacements.GetSize() % 2 )
+    {
+        displacements.Add( 0 );
+    }
+
+    // the map iterates in crc order, so the records come out sorted
+    DynamicArray< SchemaStructure > structures;
+    DynamicArray< SchemaRun > runs;
+    DynamicArray< uint32_t > translated;
+    for ( M_HashToType::ConstIterator itr = m_TypesByHash.Begin(), end = m_TypesByHash.End(); itr != end; ++itr )
+    {
+        const MetaStruct* type = ReflectionCast< const MetaStruct >( itr->Second() );
+        if ( !type || !type->m_HasFieldRuns || Crc32( type->m_Name ) != itr->First() )
+        {
+            continue; // not a structure, or an alias
+        }
+
+        SchemaStructure structure;
+        structure.m_Crc = itr->First();
+        structure.m_Size = type->m_Size;
+        structure.m_FieldCount = type->GetFlattenedFieldCount();
+        structure.m_LayoutDigest = LayoutDigest( type, NULL );
+
+        const DynamicArray< FieldRun >* typeRuns[] = { &type->m_CopyRuns, &type->m_EqualsRuns };
+        uint32_t* firsts[] = { &structure.m_FirstCopyRun, &structure.m_FirstEqualsRun };
+        uint32_t* counts[] = { &structure.m_CopyRunCount, &structure.m_EqualsRunCount };
+        for ( uint32_t i = 0; i < 2; ++i )
+        {
+            *firsts[ i ] = static_cast< uint32_t >( runs.GetSize() );
+            *counts[ i ] = static_cast< uint32_t >( typeRuns[ i ]->GetSize() );
+            for ( size_t j = 0; j < typeRuns[ i ]->GetSize(); ++j )
+            {
+                const FieldRun& typeRun = ( *typeRuns[ i ] )[ j ];
+                SchemaRun run;
+                run.m_Offset = typeRun.m_Offset;
+                run.m_Size = typeRun.m_Size;
+                run.m_Kind = typeRun.m_Kind;
+                runs.Add( run );
+            }
+        }
+
+        structure.m_FirstTranslated = static_cast< uint32_t >( translated.GetSize() );
+        structure.m_TranslatedCount = static_cast< uint32_t >( type->m_TranslatedFields.GetSize() );
+        for ( size_t i = 0; i < type->m_TranslatedFields.GetSize(); ++i )
+        {
+            translated.Add( type->m_TranslatedFields[ i ]->m_Index );
+        }
+
+        structures.Add( structure );
+    }
+
+    header.m_StructureCount = static_cast< uint32_t >( structures.GetSize() );
+    header.m_RunCount = static_cast< uint32_t >( runs.GetSize() );
+    header.m_TranslatedCount = static_cast< uint32_t >( translated.GetSize() );
+
+    FileStream stream;
+    if ( !stream.Open( path.Data(), FileStream::MODE_WRITE ) )
+    {
+        Log::Warning( "Unable to write schema cache '%s'\n", path.Data() );
+        return false;
+    }
+
+    bool written =
+        stream.Write( &header, sizeof( header ), 1 ) == 1 &&
+        stream.Write( displacements.GetData(), sizeof( uint16_t ), displacements.GetSize() ) == displacements.GetSize() &&
+        stream.Write( structures.GetData(), sizeof( SchemaStructure ), structures.GetSize() ) == structures.GetSize() &&
+        stream.Write( runs.GetData(), sizeof( SchemaRun ), runs.GetSize() ) == runs.GetSize() &&
+        stream.Write( translated.GetData(), sizeof( uint32_t ), translated.GetSize() ) == translated.GetSize();
+
+    stream.Close();
+    return written;
+}
+
+bool Registry::LoadSchema( const FilePath& path, uint64_t buildHash )
+{
+    HELIUM_ASSERT( Thread::IsMain() );
+
+    delete m_Schema;
+    m_Schema = new SchemaCache;
+    m_SchemaMissed = false;
+
+    if ( !m_Schema->Read( path, buildHash ) )
+    {
+        delete m_Schema;
+        m_Schema = NULL;
+        m_SchemaMissed = true;
+        return false;
+    }
+
+    // make room for everything that's about to register, rather than growing the table as it does
+    if ( !m_Index->m_Displacements && ( m_Index->m_SlotMask + 1 ) < m_Schema->m_Header->m_TypeCount * 2 )
+    {
+        PublishIndex( TypeIndex::BuildProbed( m_TypesByHash, m_Schema->m_Header->m_TypeCount ) );
+    }
+
+    return true;
+}
+
+bool Registry::IsSchemaCurrent() const
+{
+    return m_Schema && !m_SchemaMissed;
+}
+
+bool Registry::ApplySchema( const MetaStruct* type, uint32_t crc ) const
+{
+    if ( !m_Schema )
+    {
+        return false;
+    }
+
+    // the runs were built from exactly this layout, so they still hold if its digest does
+    m_SchemaFields.RemoveAll();
+    const SchemaStructure* structure = m_Schema->FindStructure( crc );
+    if ( !structure
+        || structure->m_Size != type->m_Size
+        || structure->m_FieldCount != type->GetFlattenedFieldCount()
+        || structure->m_LayoutDigest != LayoutDigest( type, &m_SchemaFields )
+        || m_SchemaFields.GetSize() != structure->m_FieldCount )
+    {
+        m_SchemaMissed = true;
+        return false;
+    }
+
+    type->m_TranslatedFields.Resize( structure->m_TranslatedCount );
+    for ( uint32_t i = 0; i < structure->m_TranslatedCount; ++i )
+    {
+        uint32_t index = m_Schema->m_Translated[ structure->m_FirstTranslated + i ];
+        if ( index >= m_SchemaFields.GetSize() )
+        {
+            type->m_TranslatedFields.Clear();
+            m_SchemaMissed = true;
+            return false;
+        }
+
+        type->m_TranslatedFields[ i ] = m_SchemaFields[ index ];
+    }
+
+    DynamicArray< FieldRun >* typeRuns[] = { &type->m_CopyRuns, &type->m_EqualsRuns };
+    uint32_t firsts[] = { structure->m_FirstCopyRun, structure->m_FirstEqualsRun };
+    uint32_t counts[] = { structure->m_CopyRunCount, structure->m_EqualsRunCount };
+    for ( uint32_t i = 0; i < 2; ++i )
+    {
+        typeRuns[ i ]->Resize( counts[ i ] );
+        for ( uint32_t j = 0; j < counts[ i ]; ++j )
+        {
+            const SchemaRun& run = m_Schema->m_Runs[ firsts[ i ] + j ];
+            FieldRun& typeRun = ( *typeRuns[ i ] )[ j ];
+            typeRun.m_Offset = run.m_Offset;
+            typeRun.m_Size = run.m_Size;
+            typeRun.m_Kind = static_cast< BitwiseKind >( run.m_Kind );
+        }
+    }
+
+    type->m_HasFieldRuns = true;
+    return true;
+}
+
+void Registry::IndexType( uint32_t crc, const MetaType* type )
+{
+    if ( !m_Index->Insert( crc, type ) )
+    {
+        // full, or perfect, so rebuild from the authoritative map (which already has this type)
+        PublishIndex( TypeIndex::BuildProbed( m_TypesByHash ) );
+    }
+}
+
+void Registry::PublishIndex( TypeIndex* index )
+{
+    TypeIndex* previous = AtomicExchangeRelease( m_Index, index );
+    previous->m_NextRetired = m_RetiredIndices;
+    m_RetiredIndices = previous;
+}
+
+const MetaType* Registry::GetType( uint32_t crc ) const
+{
+    return m_Index->Find( crc );
 }
 
 const MetaStruct* Registry::GetMetaStruct( uint32_t crc ) const
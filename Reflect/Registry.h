@@ -3,6 +3,7 @@
 #include "Platform/Types.h"
 
 #include "Foundation/Crc32.h"
+#include "Foundation/DynamicArray.h"
 #include "Foundation/SortedMap.h"
 #include "Foundation/FilePath.h"
 #include "Foundation/SmartPtr.h"
@@ -20,6 +21,13 @@ namespace Helium
         // Registry containers
         typedef SortedMap< uint32_t, Helium::SmartPtr< MetaType > > M_HashToType;
 
+        // Flat lookup table of types by crc (see Registry.cpp)
+        class TypeIndex;
+
+        // Precomputed registry layout loaded from disk (see Registry.cpp)
+        class SchemaCache;
+        class Field;
+
         // Profile interface
 #if HELIUM_PROFILE_ENABLE
         extern Profile::Sink g_CloneSink;
@@ -36,6 +44,10 @@ namespace Helium
         HELIUM_REFLECT_API void Startup();
         HELIUM_REFLECT_API void Shutdown();
 
+        // name a schema cache for Startup to load, and to rewrite if it was missing, stale, or from another build
+        //  (buildHash should change whenever any reflected type could have, a revision or link time stamp works)
+        HELIUM_REFLECT_API void SetSchemaCache( const FilePath& path, uint64_t buildHash );
+
         class HELIUM_REFLECT_API Registry
         {
         private:
@@ -60,6 +72,23 @@ namespace Helium
             void AliasType( const MetaType* type, const char* alias );
             void UnaliasType( const MetaType* type, const char* alias );
 
+            // rebuild the lookup table with a perfect hash of the registered types (Startup does this
+            //  once the static types are in, types registered afterward fall back to a probed table)
+            void OptimizeIndex();
+
+            // snapshot the finished layout (each structure's field runs and the perfect lookup table) to a binary
+            //  file, so the next startup of the same build can load it instead of computing it again
+            bool SaveSchema( const FilePath& path, uint64_t buildHash ) const;
+            bool LoadSchema( const FilePath& path, uint64_t buildHash );
+
+            // true if a schema is loaded and everything registered since was found in it
+            bool IsSchemaCurrent() const;
+
+            // take a structure's field runs from the loaded schema (it's registered under crc), false if they need computing
+            bool ApplySchema( const MetaStruct* type, uint32_t crc ) const;
+
+            // type lookups are lock free, and safe from any thread while the main thread registers types
+
             // type lookup
             const MetaType* GetType( uint32_t crc ) const;
             inline const MetaType* GetType( const char* name ) const;
@@ -77,7 +106,15 @@ namespace Helium
             inline const MetaEnum* GetMetaEnum( const char* name ) const;
 
         private:
-            M_HashToType        m_TypesByHash;
+            void IndexType( uint32_t crc, const MetaType* type );
+            void PublishIndex( TypeIndex* index );
+
+            M_HashToType        m_TypesByHash;      // authoritative, main thread only
+            TypeIndex* volatile m_Index;            // read by lookups on any thread
+            TypeIndex*          m_RetiredIndices;   // replaced tables, freed with the registry since readers may still hold them
+            SchemaCache*        m_Schema;           // loaded schema, NULL if none
+            mutable bool        m_SchemaMissed;     // something registered wasn't in the schema (or it didn't load)
+            mutable DynamicArray< const Field* > m_SchemaFields; // scratch for ApplySchema, the fields by index
         };
 
         //
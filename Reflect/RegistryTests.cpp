@@ -0,0 +1,359 @@
+#include "Precompile.h"
+#include "Reflect/Registry.h"
+#include "Reflect/MetaStruct.h"
+
+#include "Platform/Console.h"
+#include "Platform/Timer.h"
+
+#include "Foundation/FilePath.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+using namespace Helium;
+using namespace Helium::Reflect;
+
+// a few thousand uniquely named types, on top of the ones Startup registers
+struct TestTypes
+{
+	static const uint32_t Count = 4096;
+
+	std::vector< std::string >            m_Names;
+	std::vector< uint32_t >               m_Crcs;
+	std::vector< SmartPtr< MetaStruct > > m_Types;
+
+	TestTypes( const char* prefix, uint32_t fieldCount = 0 )
+	{
+		for ( uint32_t i = 0; i < Count; ++i )
+		{
+			char name[ 64 ];
+			StringPrint( name, sizeof( name ), "%sType%u", prefix, i );
+			m_Names.push_back( name );
+			m_Crcs.push_back( Crc32( name ) );
+		}
+
+		for ( uint32_t i = 0; i < Count; ++i )
+		{
+			MetaStruct* type = MetaStruct::Create();
+			type->m_Name = m_Names[ i ].c_str();
+			AddFields( type, i, fieldCount );
+			m_Types.push_back( type );
+		}
+	}
+
+	// packed four byte fields of a mix of kinds, so each type has a few runs and a few translated fields
+	static void AddFields( MetaStruct* type, uint32_t seed, uint32_t fieldCount )
+	{
+		static const char* names[] = { "A", "B", "C", "D", "E", "F", "G", "H" };
+		static const BitwiseKind kinds[] = { BitwiseKinds::Bytes, BitwiseKinds::Bytes, BitwiseKinds::Float32, BitwiseKinds::None };
+		for ( uint32_t i = 0; i < fieldCount; ++i )
+		{
+			Field* field = type->AllocateField();
+			field->m_Name = names[ i % HELIUM_ARRAY_COUNT( names ) ];
+			field->m_NameCrc = Crc32( field->m_Name );
+			field->m_Size = 4;
+			field->m_Offset = i * 4;
+			field->m_Bitwise = kinds[ ( seed + i ) % HELIUM_ARRAY_COUNT( kinds ) ];
+		}
+		type->m_Size = fieldCount * 4;
+	}
+
+	void Register( uint32_t begin = 0, uint32_t end = Count )
+	{
+		for ( uint32_t i = begin; i < end; ++i )
+		{
+			EXPECT_TRUE( Registry::GetInstance()->RegisterType( m_Types[ i ] ) );
+		}
+	}
+
+	void Unregister( uint32_t begin = 0, uint32_t end = Count )
+	{
+		for ( uint32_t i = begin; i < end; ++i )
+		{
+			Registry::GetInstance()->UnregisterType( m_Types[ i ] );
+		}
+	}
+
+	void ExpectRegistered( uint32_t begin, uint32_t end, bool registered )
+	{
+		for ( uint32_t i = begin; i < end; ++i )
+		{
+			EXPECT_EQ( registered ? static_cast< const MetaType* >( m_Types[ i ] ) : NULL, Registry::GetInstance()->GetType( m_Crcs[ i ] ) );
+		}
+	}
+};
+
+TEST(ReflectRegistry, LookupFollowsRegistration)
+{
+	Reflect::Startup();
+	Registry* registry = Registry::GetInstance();
+
+	TestTypes types ( "Lookup" );
+	types.Register();
+	types.ExpectRegistered( 0, TestTypes::Count, true );
+	EXPECT_EQ( NULL, registry->GetType( "LookupTypeMissing" ) );
+
+	registry->OptimizeIndex();
+	types.ExpectRegistered( 0, TestTypes::Count, true );
+	EXPECT_EQ( NULL, registry->GetType( "LookupTypeMissing" ) );
+	EXPECT_EQ( types.m_Types[ 7 ].Ptr(), registry->GetMetaStruct( "LookupType7" ) );
+	EXPECT_EQ( NULL, registry->GetMetaClass( "LookupType7" ) );
+
+	// unregistering and re-registering at run time, with the perfect table in place
+	types.Unregister( 0, TestTypes::Count / 2 );
+	types.ExpectRegistered( 0, TestTypes::Count / 2, false );
+	types.ExpectRegistered( TestTypes::Count / 2, TestTypes::Count, true );
+	types.Register( 0, TestTypes::Count / 4 );
+	types.ExpectRegistered( 0, TestTypes::Count / 4, true );
+
+	// late registration of new crcs falls back to a probed table
+	TestTypes late ( "Late" );
+	late.Register();
+	late.ExpectRegistered( 0, TestTypes::Count, true );
+	types.ExpectRegistered( 0, TestTypes::Count / 4, true );
+	types.ExpectRegistered( TestTypes::Count / 4, TestTypes::Count / 2, false );
+	types.ExpectRegistered( TestTypes::Count / 2, TestTypes::Count, true );
+
+	registry->AliasType( types.m_Types[ 3000 ], "LookupAlias" );
+	EXPECT_EQ( types.m_Types[ 3000 ].Ptr(), registry->GetType( "LookupAlias" ) );
+	registry->UnaliasType( types.m_Types[ 3001 ], "LookupAlias" );
+	EXPECT_EQ( types.m_Types[ 3000 ].Ptr(), registry->GetType( "LookupAlias" ) );
+	registry->UnaliasType( types.m_Types[ 3000 ], "LookupAlias" );
+	EXPECT_EQ( NULL, registry->GetType( "LookupAlias" ) );
+
+	late.Unregister();
+	types.Unregister( 0, TestTypes::Count / 4 );
+	types.Unregister( TestTypes::Count / 2, TestTypes::Count );
+
+	Reflect::Shutdown();
+}
+
+TEST(ReflectRegistry, LookupBenchmark)
+{
+	const uint32_t lookupCount = 10000000;
+
+	Reflect::Startup();
+	Registry* registry = Registry::GetInstance();
+
+	TestTypes types ( "Benchmark" );
+	types.Register();
+
+	// the sorted map the registry used to search
+	M_HashToType reference;
+	for ( uint32_t i = 0; i < TestTypes::Count; ++i )
+	{
+		reference.Insert( M_HashToType::ValueType( types.m_Crcs[ i ], types.m_Types[ i ].Ptr() ) );
+	}
+
+	uint32_t found = 0;
+	SimpleTimer timer;
+	for ( uint32_t i = 0; i < lookupCount; ++i )
+	{
+		found += reference.Find( types.m_Crcs[ ( i * 7919 ) % TestTypes::Count ] ) != reference.End() ? 1 : 0;
+	}
+	float64_t sortedMillis = timer.Elapsed();
+
+	timer.Reset();
+	for ( uint32_t i = 0; i < lookupCount; ++i )
+	{
+		found += registry->GetType( types.m_Crcs[ ( i * 7919 ) % TestTypes::Count ] ) ? 1 : 0;
+	}
+	float64_t probedMillis = timer.Elapsed();
+
+	registry->OptimizeIndex();
+
+	timer.Reset();
+	for ( uint32_t i = 0; i < lookupCount; ++i )
+	{
+		found += registry->GetType( types.m_Crcs[ ( i * 7919 ) % TestTypes::Count ] ) ? 1 : 0;
+	}
+	float64_t perfectMillis = timer.Elapsed();
+
+	EXPECT_EQ( lookupCount * 3, found );
+
+	Helium::Print( "Registry: %u types, sorted map %.2f ns/lookup, probed table %.2f ns/lookup, perfect table %.2f ns/lookup\n",
+		TestTypes::Count, sortedMillis * 1000000.0 / lookupCount, probedMillis * 1000000.0 / lookupCount, perfectMillis * 1000000.0 / lookupCount );
+
+	types.Unregister();
+	Reflect::Shutdown();
+}
+
+struct TestLayout
+{
+	DynamicArray< FieldRun >     m_CopyRuns;
+	DynamicArray< FieldRun >     m_EqualsRuns;
+	DynamicArray< const Field* > m_TranslatedFields;
+};
+
+static void ExpectSameRuns( const DynamicArray< FieldRun >& expected, const DynamicArray< FieldRun >& actual )
+{
+	ASSERT_EQ( expected.GetSize(), actual.GetSize() );
+	for ( size_t i = 0; i < expected.GetSize(); ++i )
+	{
+		EXPECT_EQ( expected[ i ].m_Offset, actual[ i ].m_Offset );
+		EXPECT_EQ( expected[ i ].m_Size, actual[ i ].m_Size );
+		EXPECT_EQ( expected[ i ].m_Kind, actual[ i ].m_Kind );
+	}
+}
+
+TEST(ReflectRegistry, SchemaCacheRestoresLayout)
+{
+	const uint64_t buildHash = 0x0123456789abcdefULL;
+	FilePath path ( "ReflectRegistrySchemaTest.bin" );
+
+	Reflect::Startup();
+	Registry* registry = Registry::GetInstance();
+	EXPECT_FALSE( registry->IsSchemaCurrent() );
+
+	TestTypes types ( "Schema", 8 );
+	types.Register();
+	registry->OptimizeIndex();
+	ASSERT_TRUE( registry->SaveSchema( path, buildHash ) );
+
+	// keep what was computed, then take it all away
+	std::vector< TestLayout > computed;
+	for ( uint32_t i = 0; i < TestTypes::Count; ++i )
+	{
+		MetaStruct* type = types.m_Types[ i ];
+		computed.push_back( TestLayout() );
+		computed.back().m_CopyRuns = type->m_CopyRuns;
+		computed.back().m_EqualsRuns = type->m_EqualsRuns;
+		computed.back().m_TranslatedFields = type->m_TranslatedFields;
+		type->m_CopyRuns.Clear();
+		type->m_EqualsRuns.Clear();
+		type->m_TranslatedFields.Clear();
+		type->m_HasFieldRuns = false;
+	}
+	types.Unregister();
+
+	EXPECT_FALSE( registry->LoadSchema( path, buildHash + 1 ) );
+	EXPECT_FALSE( registry->LoadSchema( FilePath( "ReflectRegistrySchemaMissing.bin" ), buildHash ) );
+	EXPECT_TRUE( registry->LoadSchema( path, buildHash ) );
+
+	types.Register();
+	registry->OptimizeIndex();
+	EXPECT_TRUE( registry->IsSchemaCurrent() );
+	types.ExpectRegistered( 0, TestTypes::Count, true );
+	EXPECT_EQ( NULL, registry->GetType( "SchemaTypeMissing" ) );
+
+	for ( uint32_t i = 0; i < TestTypes::Count; ++i )
+	{
+		MetaStruct* type = types.m_Types[ i ];
+		EXPECT_TRUE( type->m_HasFieldRuns );
+		ExpectSameRuns( computed[ i ].m_CopyRuns, type->m_CopyRuns );
+		ExpectSameRuns( computed[ i ].m_EqualsRuns, type->m_EqualsRuns );
+		ASSERT_EQ( computed[ i ].m_TranslatedFields.GetSize(), type->m_TranslatedFields.GetSize() );
+		for ( size_t j = 0; j < type->m_TranslatedFields.GetSize(); ++j )
+		{
+			EXPECT_EQ( computed[ i ].m_TranslatedFields[ j ], type->m_TranslatedFields[ j ] );
+		}
+	}
+
+	// a type that gained a field doesn't match its record, so it's computed and the schema is stale
+	types.Unregister( 0, 1 );
+	types.m_Types[ 0 ]->m_Fields.Clear();
+	TestTypes::AddFields( types.m_Types[ 0 ], 0, 9 );
+	types.Register( 0, 1 );
+	EXPECT_FALSE( registry->IsSchemaCurrent() );
+	EXPECT_EQ( 36u, types.m_Types[ 0 ]->m_CopyRuns.GetLast().m_Offset + types.m_Types[ 0 ]->m_CopyRuns.GetLast().m_Size );
+
+	// so is one with the same size and field count whose bitwise field now needs its translator (became a pointer)
+	EXPECT_TRUE( registry->LoadSchema( path, buildHash ) );
+	types.Unregister( 1, 2 );
+	Field& changed = types.m_Types[ 1 ]->m_Fields[ 0 ];
+	ASSERT_EQ( BitwiseKinds::Bytes, changed.m_Bitwise );
+	changed.m_Bitwise = BitwiseKinds::None;
+	types.Register( 1, 2 );
+	EXPECT_FALSE( registry->IsSchemaCurrent() );
+	EXPECT_EQ( 4u, types.m_Types[ 1 ]->m_CopyRuns.GetFirst().m_Offset );
+	EXPECT_EQ( &changed, types.m_Types[ 1 ]->m_TranslatedFields.GetFirst() );
+
+	// and one whose float field became an integer, which copies the same but compares differently
+	EXPECT_TRUE( registry->LoadSchema( path, buildHash ) );
+	types.Unregister( 2, 3 );
+	Field& retyped = types.m_Types[ 2 ]->m_Fields[ 0 ];
+	ASSERT_EQ( BitwiseKinds::Float32, retyped.m_Bitwise );
+	retyped.m_Bitwise = BitwiseKinds::Bytes;
+	types.Register( 2, 3 );
+	EXPECT_FALSE( registry->IsSchemaCurrent() );
+	EXPECT_EQ( BitwiseKinds::Bytes, types.m_Types[ 2 ]->m_EqualsRuns.GetFirst().m_Kind );
+	EXPECT_EQ( 0u, types.m_Types[ 2 ]->m_EqualsRuns.GetFirst().m_Offset );
+
+	// and one whose fields traded places, which leaves the size, the count and the kinds as they were
+	EXPECT_TRUE( registry->LoadSchema( path, buildHash ) );
+	types.Unregister( 3, 4 );
+	Field& moved = types.m_Types[ 3 ]->m_Fields[ 0 ];
+	ASSERT_EQ( BitwiseKinds::None, moved.m_Bitwise );
+	moved.m_Offset = 4;
+	types.m_Types[ 3 ]->m_Fields[ 1 ].m_Offset = 0;
+	types.Register( 3, 4 );
+	EXPECT_FALSE( registry->IsSchemaCurrent() );
+	EXPECT_EQ( 0u, types.m_Types[ 3 ]->m_CopyRuns.GetFirst().m_Offset );
+	EXPECT_EQ( 4u, types.m_Types[ 3 ]->m_CopyRuns.GetFirst().m_Size );
+	EXPECT_EQ( &moved, types.m_Types[ 3 ]->m_TranslatedFields.GetFirst() );
+
+	types.Unregister();
+	Reflect::Shutdown();
+	path.Delete();
+}
+
+TEST(ReflectRegistry, SchemaCacheStartupBenchmark)
+{
+	const uint64_t buildHash = 0xfedcba9876543210ULL;
+	FilePath path ( "ReflectRegistrySchemaBenchmark.bin" );
+
+	Reflect::Startup();
+	Registry* registry = Registry::GetInstance();
+
+	TestTypes types ( "Startup", 8 );
+
+	SimpleTimer timer;
+	types.Register();
+	registry->OptimizeIndex();
+	float64_t computedMillis = timer.Elapsed();
+
+	ASSERT_TRUE( registry->SaveSchema( path, buildHash ) );
+	types.Unregister();
+
+	timer.Reset();
+	EXPECT_TRUE( registry->LoadSchema( path, buildHash ) );
+	types.Register();
+	registry->OptimizeIndex();
+	float64_t cachedMillis = timer.Elapsed();
+
+	EXPECT_TRUE( registry->IsSchemaCurrent() );
+	types.ExpectRegistered( 0, TestTypes::Count, true );
+
+	// and the layout alone, which is all the schema saves over registering from scratch
+	const uint32_t passes = 20;
+	timer.Reset();
+	for ( uint32_t pass = 0; pass < passes; ++pass )
+	{
+		for ( uint32_t i = 0; i < TestTypes::Count; ++i )
+		{
+			types.m_Types[ i ]->ComputeFieldRuns();
+		}
+	}
+	float64_t computeMillis = timer.Elapsed();
+
+	timer.Reset();
+	for ( uint32_t pass = 0; pass < passes; ++pass )
+	{
+		for ( uint32_t i = 0; i < TestTypes::Count; ++i )
+		{
+			EXPECT_TRUE( registry->ApplySchema( types.m_Types[ i ], types.m_Crcs[ i ] ) );
+		}
+	}
+	float64_t applyMillis = timer.Elapsed();
+
+	Helium::Print( "Registry: %u types, startup computing layout %.2f ms, loading schema cache %.2f ms\n",
+		TestTypes::Count, computedMillis, cachedMillis );
+	Helium::Print( "Registry: layout computed %.1f ns/type, taken from schema %.1f ns/type\n",
+		computeMillis * 1000000.0 / ( passes * TestTypes::Count ), applyMillis * 1000000.0 / ( passes * TestTypes::Count ) );
+
+	types.Unregister();
+	Reflect::Shutdown();
+	path.Delete();
+}
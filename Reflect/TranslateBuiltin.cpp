@@ -16,6 +16,16 @@ void Reflect::Resolve( ObjectResolver* resolver, Name name, Pointer pointer )
 	resolver->Resolve( name, pointer.As< ObjectPtr >() );
 }
 
+bool Reflect::Identify( ObjectIdentifier* identifier, Pointer pointer, uint32_t& index )
+{
+	return identifier->Identify( pointer.As< ObjectPtr >(), index );
+}
+
+bool Reflect::Resolve( ObjectResolver* resolver, uint32_t index, Pointer pointer )
+{
+	return resolver->Resolve( index, pointer.As< ObjectPtr >() );
+}
+
 TypeTranslator::TypeTranslator()
 	: ScalarTranslator( sizeof( const MetaType* ), ScalarTypes::String )
 {
@@ -153,6 +153,8 @@ namespace Helium
 
 		HELIUM_REFLECT_API bool Identify( ObjectIdentifier* identifier, Pointer pointer, Name* name );
 		HELIUM_REFLECT_API void Resolve( ObjectResolver* resolver, Name name, Pointer pointer );
+		HELIUM_REFLECT_API bool Identify( ObjectIdentifier* identifier, Pointer pointer, uint32_t& index );
+		HELIUM_REFLECT_API bool Resolve( ObjectResolver* resolver, uint32_t index, Pointer pointer );
 
 		//////////////////////////////////////////////////////////////////////////
 
@@ -109,7 +109,7 @@ template< class T >
 void Helium::Reflect::SimpleStructureTranslator<T>::Copy( Pointer src, Pointer dest, uint32_t flags )
 {
 	const MetaStruct* structure = Reflect::GetMetaStruct< T >();
-	structure->Copy( src.m_Address, src.m_Object, dest.m_Address, dest.m_Object );
+	structure->Copy( src.m_Address, src.m_Object, dest.m_Address, dest.m_Object, ( flags & CopyFlags::Shallow ) != 0 );
 	dest.RaiseChanged( flags & CopyFlags::Notify ); 
 }
 
@@ -193,9 +193,12 @@ void Helium::Reflect::PointerTranslator<T>::Print( Pointer pointer, String& stri
 {
 	if ( identifier )
 	{
+		// null and unidentified pointers print as empty
 		Name name;
-		Identify( identifier, pointer, &name );
-		string = name.Get();
+		if ( Identify( identifier, pointer, &name ) && !name.IsEmpty() )
+		{
+			string = name.Get();
+		}
 	}
 }
 
@@ -112,6 +112,13 @@ void Helium::Reflect::SimpleDynamicArrayTranslator<T>::GetItems( Pointer sequenc
 	}
 }
 
+template <class T>
+void* Helium::Reflect::SimpleDynamicArrayTranslator<T>::GetItemData( Pointer sequence ) const
+{
+	DynamicArray<T> &v = sequence.As< DynamicArray<T> >();
+	return v.GetData();
+}
+
 template <class T>
 void Helium::Reflect::SimpleDynamicArrayTranslator<T>::SetLength( Pointer sequence, size_t length )
 {
@@ -38,5 +38,6 @@ void StlStringTranslator::Print( Pointer pointer, String& string, ObjectIdentifi
 
 void StlStringTranslator::Parse( const String& string, Pointer pointer, ObjectResolver* resolver, bool raiseChanged )
 {
-	pointer.As< std::string >() = string.GetData();
+	// empty strings have no data, and std::string can't be assigned NULL
+	pointer.As< std::string >() = string.IsEmpty() ? "" : string.GetData();
 }
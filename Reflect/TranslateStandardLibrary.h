@@ -51,6 +51,7 @@ namespace Helium
 			// SequenceTranslator
 			virtual Translator* GetItemTranslator() const override;
 			virtual void        GetItems( Pointer sequence, DynamicArray< Pointer >& items ) const override;
+			virtual void*       GetItemData( Pointer sequence ) const override;
 			virtual void        SetLength( Pointer sequence, size_t length ) override;
 			virtual Pointer GetItem( Pointer sequence, size_t at ) override;
 			virtual void        SetItem( Pointer sequence, size_t at, Pointer value ) override;
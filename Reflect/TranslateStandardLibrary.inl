@@ -113,6 +113,13 @@ void Helium::Reflect::SimpleStlVectorTranslator<T>::GetItems( Pointer sequence,
 	}
 }
 
+template <class T>
+void* Helium::Reflect::SimpleStlVectorTranslator<T>::GetItemData( Pointer sequence ) const
+{
+	std::vector<T> &v = sequence.As< std::vector<T> >();
+	return v.empty() ? NULL : &v[0];
+}
+
 template <class T>
 void Helium::Reflect::SimpleStlVectorTranslator<T>::SetLength( Pointer sequence, size_t length )
 {
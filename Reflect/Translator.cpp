@@ -59,3 +59,8 @@ uint32_t Translator::GetDefaultFlags()
 {
 	return 0x0;
 }
+
+void* SequenceTranslator::GetItemData( Pointer /*sequence*/ ) const
+{
+	return NULL;
+}
@@ -80,7 +80,7 @@ namespace Helium
 			enum MetaType
 			{
 				Notify    = 1 << 0, // emit changed events when copying data
-				Shallow   = 1 << 1, // copy references only
+				Shallow   = 1 << 1, // copy references only, structures pass this on to their fields
 			};
 		}
 
@@ -223,6 +223,9 @@ namespace Helium
 
 			virtual void        GetItems( Pointer sequence, DynamicArray< Pointer >& items ) const = 0;
 
+			// the items as one contiguous block of memory, NULL if they aren't stored that way (or there are none)
+			virtual void*       GetItemData( Pointer sequence ) const;
+
 			virtual void        SetLength( Pointer sequence, size_t length ) = 0;
 			virtual Pointer     GetItem( Pointer sequence, size_t at ) = 0;
 			virtual void        SetItem( Pointer sequence, size_t at, Pointer value ) = 0;